@@ -29,13 +29,18 @@
 #include <signal.h>
 #include <time.h>
 
+#include <deque>
+#include <vector>
+
 #include <cutils/properties.h>
 
 #include <androidfw/AssetManager.h>
 #include <binder/IPCThreadState.h>
 #include <utils/Atomic.h>
+#include <utils/Condition.h>
 #include <utils/Errors.h>
 #include <utils/Log.h>
+#include <utils/Mutex.h>
 #include <utils/SystemClock.h>
 
 #include <android-base/properties.h>
@@ -203,21 +208,35 @@ status_t BootAnimation::initTexture(Texture* texture, AssetManager& assets,
     return NO_ERROR;
 }
 
-status_t BootAnimation::initTexture(FileMap* map, int* width, int* height)
+static bool decodeFrame(FileMap* map, SkBitmap* bitmap)
 {
-    SkBitmap bitmap;
     sk_sp<SkData> data = SkData::MakeWithoutCopy(map->getDataPtr(),
             map->getDataLength());
     sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
-    image->asLegacyBitmap(&bitmap, SkImage::kRO_LegacyBitmapMode);
+    bool decoded = image && image->asLegacyBitmap(bitmap, SkImage::kRO_LegacyBitmapMode);
 
     // FileMap memory is never released until application exit.
-    // Release it now as the texture is already loaded and the memory used for
+    // Release it now as the image is already decoded and the memory used for
     // the packed resource can be released.
     delete map;
+    return decoded;
+}
+
+status_t BootAnimation::initTexture(FileMap* map, int* width, int* height)
+{
+    SkBitmap bitmap;
+    decodeFrame(map, &bitmap);
+    return initTexture(bitmap, width, height);
+}
+
+status_t BootAnimation::initTexture(const SkBitmap& bitmap, int* width, int* height)
+{
+    if (bitmap.isNull()) {
+        return NO_INIT;
+    }
 
     // ensure we can call getPixels(). No need to call unlock, since the
-    // bitmap will go out of scope when we return from this method.
+    // bitmap will go out of scope when the caller is done with it.
     bitmap.lockPixels();
 
     const int w = bitmap.width();
@@ -890,6 +909,75 @@ bool BootAnimation::movie()
     return false;
 }
 
+// Decodes the frames of one pass of a part ahead of the render loop, which only has to
+// upload them. At most MAX_DECODED_FRAMES decoded frames are held at once.
+class FrameDecodeThread : public Thread {
+public:
+    static constexpr size_t MAX_DECODED_FRAMES = 3;
+
+    explicit FrameDecodeThread(std::vector<FileMap*>&& maps)
+        : Thread(false), mMaps(std::move(maps)) {}
+
+    // Blocks until the next frame is decoded. Frames are returned in order. Returns false if
+    // it couldn't be decoded, bitmap is left empty then.
+    bool takeFrame(SkBitmap* bitmap) {
+        Mutex::Autolock _l(mLock);
+        while (mDecoded.empty() && mNextFrame < mMaps.size()) {
+            mCondition.wait(mLock);
+        }
+        if (mDecoded.empty()) {
+            return false;
+        }
+        bool decoded = !mDecoded.front().isNull();
+        bitmap->swap(mDecoded.front());
+        mDecoded.pop_front();
+        mCondition.broadcast();
+        return decoded;
+    }
+
+    // Stops decoding, frames that weren't decoded yet keep their maps
+    void stop() {
+        {
+            Mutex::Autolock _l(mLock);
+            requestExit();
+            mCondition.broadcast();
+        }
+        requestExitAndWait();
+    }
+
+private:
+    virtual bool threadLoop() {
+        FileMap* map;
+        {
+            Mutex::Autolock _l(mLock);
+            while (mDecoded.size() >= MAX_DECODED_FRAMES && !exitPending()) {
+                mCondition.wait(mLock);
+            }
+            if (exitPending()) {
+                return false;
+            }
+            map = mMaps[mNextFrame];
+        }
+
+        SkBitmap bitmap;
+        if (!decodeFrame(map, &bitmap)) {
+            ALOGE("Failed to decode animation frame");
+        }
+
+        Mutex::Autolock _l(mLock);
+        mDecoded.push_back(bitmap);
+        mNextFrame++;
+        mCondition.broadcast();
+        return mNextFrame < mMaps.size();
+    }
+
+    const std::vector<FileMap*> mMaps;
+    Mutex mLock;
+    Condition mCondition;
+    std::deque<SkBitmap> mDecoded;
+    size_t mNextFrame = 0;
+};
+
 bool BootAnimation::playAnimation(const Animation& animation)
 {
     const size_t pcount = animation.parts.size();
@@ -933,6 +1021,21 @@ bool BootAnimation::playAnimation(const Animation& animation)
                     part.backgroundColor[2],
                     1.0f);
 
+            // The first pass decodes every frame, later ones reuse the textures
+            sp<FrameDecodeThread> decoder;
+            if (r == 0 && fcount > 0) {
+                std::vector<FileMap*> maps;
+                maps.reserve(fcount);
+                for (size_t j = 0; j < fcount; j++) {
+                    maps.push_back(part.frames[j].map);
+                }
+                decoder = new FrameDecodeThread(std::move(maps));
+                if (decoder->run("BootAnimation::FrameDecodeThread", PRIORITY_NORMAL)
+                        != NO_ERROR) {
+                    decoder = nullptr;
+                }
+            }
+
             for (size_t j=0 ; j<fcount && (!exitPending() || part.playUntilComplete) ; j++) {
                 const Animation::Frame& frame(part.frames[j]);
                 nsecs_t lastFrame = systemTime();
@@ -947,7 +1050,13 @@ bool BootAnimation::playAnimation(const Animation& animation)
                         glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
                     }
                     int w, h;
-                    initTexture(frame.map, &w, &h);
+                    if (decoder != nullptr) {
+                        SkBitmap bitmap;
+                        decoder->takeFrame(&bitmap);
+                        initTexture(bitmap, &w, &h);
+                    } else {
+                        initTexture(frame.map, &w, &h);
+                    }
                 }
 
                 const int xc = animationX + frame.trimX;
@@ -993,6 +1102,10 @@ bool BootAnimation::playAnimation(const Animation& animation)
                 checkExit();
             }
 
+            if (decoder != nullptr) {
+                decoder->stop();
+            }
+
             usleep(part.pause * ns2us(frameDuration));
 
             // For infinite parts, we've now played them at least once, so perhaps exit
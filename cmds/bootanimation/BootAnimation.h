@@ -133,6 +133,7 @@ private:
 
     status_t initTexture(Texture* texture, AssetManager& asset, const char* name);
     status_t initTexture(FileMap* map, int* width, int* height);
+    status_t initTexture(const SkBitmap& bitmap, int* width, int* height);
     status_t initFont(Font* font, const char* fallback);
     bool android();
     bool movie();
@@ -15,6 +15,8 @@ SYNOPSIS \n\
       idmap --path target overlay idmap \n\
       idmap --scan target-package-name-to-look-for path-to-target-apk dir-to-hold-idmaps \\\
                    dir-to-scan [additional-dir-to-scan [additional-dir-to-scan [...]]]\n\
+      idmap --scan-parallel jobs target-package-name-to-look-for path-to-target-apk \\\
+                   dir-to-hold-idmaps dir-to-scan [additional-dir-to-scan [...]]\n\
       idmap --inspect idmap \n\
       idmap --verify target overlay fd \n\
 \n\
@@ -54,6 +56,9 @@ OPTIONS \n\
               with target package 'target-package-name-to-look-for' (package name) present at\n\
               'path-to-target-apk' (path to apk). For each overlay package found, create an\n\
               idmap file in 'dir-to-hold-idmaps' (path). \n\
+\n\
+      --scan-parallel: same as --scan, but process up to 'jobs' (integer) overlay packages\n\
+              concurrently. Overlays whose idmap is up to date are skipped, as with --scan.\n\
 \n\
       --inspect: decode the binary format of 'idmap' (path) and display the contents in a \n\
                  debug-friendly format. \n\
@@ -195,7 +200,8 @@ NOTES \n\
     }
 
     int maybe_scan(const char *target_package_name, const char *target_apk_path,
-            const char *idmap_dir, const android::Vector<const char *> *overlay_dirs)
+            const char *idmap_dir, const android::Vector<const char *> *overlay_dirs,
+            size_t jobs)
     {
         if (!verify_root_or_system()) {
             fprintf(stderr, "error: permission denied: not user root or user system\n");
@@ -221,7 +227,7 @@ NOTES \n\
             }
         }
 
-        return idmap_scan(target_package_name, target_apk_path, idmap_dir, overlay_dirs);
+        return idmap_scan(target_package_name, target_apk_path, idmap_dir, overlay_dirs, jobs);
     }
 
     int maybe_inspect(const char *idmap_path)
@@ -271,7 +277,21 @@ int main(int argc, char **argv)
         for (int i = 5; i < argc; i++) {
             v.push(argv[i]);
         }
-        return maybe_scan(argv[2], argv[3], argv[4], &v);
+        return maybe_scan(argv[2], argv[3], argv[4], &v, 1);
+    }
+
+    if (argc >= 7 && !strcmp(argv[1], "--scan-parallel")) {
+        char *endptr;
+        long jobs = strtol(argv[2], &endptr, 10);
+        if (*endptr != '\0' || jobs < 1) {
+            fprintf(stderr, "error: failed to parse jobs argument %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        android::Vector<const char *> v;
+        for (int i = 6; i < argc; i++) {
+            v.push(argv[i]);
+        }
+        return maybe_scan(argv[3], argv[4], argv[5], &v, static_cast<size_t>(jobs));
     }
 
     if (argc == 3 && !strcmp(argv[1], "--inspect")) {
@@ -30,8 +30,9 @@ int idmap_verify_fd(const char *target_apk_path, const char *overlay_apk_path, i
 // Regarding target_package_name: the idmap_scan implementation should
 // be able to extract this from the manifest in target_apk_path,
 // simplifying the external API.
+// Up to 'jobs' overlays are processed concurrently.
 int idmap_scan(const char *target_package_name, const char *target_apk_path,
-        const char *idmap_dir, const android::Vector<const char *> *overlay_dirs);
+        const char *idmap_dir, const android::Vector<const char *> *overlay_dirs, size_t jobs);
 
 int idmap_inspect(const char *idmap_path);
 
@@ -5,7 +5,11 @@
 
 #include "idmap.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 #include <androidfw/ResourceTypes.h>
 #include <androidfw/StreamingZipInflater.h>
 #include <androidfw/ZipFileRO.h>
@@ -228,15 +232,41 @@ namespace {
         delete dataMap;
         return priority;
     }
+
+    // Creates the idmap for the overlay at overlay_apk_path if it is a static overlay targeting
+    // target_package_name. Safe to call concurrently for different overlays.
+    bool scan_overlay(const char *target_package_name, const char *target_apk_path,
+            const char *idmap_dir, const char *overlay_apk_path, Overlay *out_overlay)
+    {
+        int priority = parse_apk(overlay_apk_path, target_package_name);
+        if (priority < 0) {
+            return false;
+        }
+
+        String8 idmap_path(idmap_dir);
+        idmap_path.appendPath(flatten_path(overlay_apk_path + 1));
+        idmap_path.append("@idmap");
+
+        if (idmap_create_path(target_apk_path, overlay_apk_path, idmap_path.string()) != 0) {
+            ALOGE("error: failed to create idmap for target=%s overlay=%s idmap=%s\n",
+                    target_apk_path, overlay_apk_path, idmap_path.string());
+            return false;
+        }
+
+        *out_overlay = Overlay(String8(overlay_apk_path), idmap_path, priority);
+        return true;
+    }
 }
 
 int idmap_scan(const char *target_package_name, const char *target_apk_path,
-        const char *idmap_dir, const android::Vector<const char *> *overlay_dirs)
+        const char *idmap_dir, const android::Vector<const char *> *overlay_dirs, size_t jobs)
 {
     String8 filename = String8(idmap_dir);
     filename.appendPath("overlays.list");
 
-    SortedVector<Overlay> overlayVector;
+    // Collect the candidates first so that they can be processed in any order, but still be
+    // added to the list in directory order.
+    std::vector<String8> candidates;
     const size_t N = overlay_dirs->size();
     for (size_t i = 0; i < N; ++i) {
         const char *overlay_dir = overlay_dirs->itemAt(i);
@@ -256,27 +286,44 @@ int idmap_scan(const char *target_package_name, const char *target_apk_path,
             if (!S_ISREG(st.st_mode)) {
                 continue;
             }
+            candidates.push_back(String8(overlay_apk_path));
+        }
 
-            int priority = parse_apk(overlay_apk_path, target_package_name);
-            if (priority < 0) {
-                continue;
-            }
+        closedir(dir);
+    }
 
-            String8 idmap_path(idmap_dir);
-            idmap_path.appendPath(flatten_path(overlay_apk_path + 1));
-            idmap_path.append("@idmap");
+    std::vector<Overlay> overlays(candidates.size());
+    std::unique_ptr<bool[]> found(new bool[candidates.size()]());
 
-            if (idmap_create_path(target_apk_path, overlay_apk_path, idmap_path.string()) != 0) {
-                ALOGE("error: failed to create idmap for target=%s overlay=%s idmap=%s\n",
-                        target_apk_path, overlay_apk_path, idmap_path.string());
-                continue;
-            }
+    // Each overlay is independent of the others, and idmap_create_path() skips overlays whose
+    // idmap already records the current CRCs of both resources.arsc files.
+    std::atomic<size_t> next_candidate(0);
+    auto worker = [&]() {
+        for (size_t i = next_candidate++; i < candidates.size(); i = next_candidate++) {
+            found[i] = scan_overlay(target_package_name, target_apk_path, idmap_dir,
+                    candidates[i].string(), &overlays[i]);
+        }
+    };
 
-            Overlay overlay(String8(overlay_apk_path), idmap_path, priority);
-            overlayVector.add(overlay);
+    const size_t thread_count = std::min(jobs, candidates.size());
+    if (thread_count <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back(worker);
         }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
 
-        closedir(dir);
+    SortedVector<Overlay> overlayVector;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (found[i]) {
+            overlayVector.add(overlays[i]);
+        }
     }
 
     if (!writePackagesList(filename.string(), overlayVector)) {
@@ -285,4 +332,3 @@ int idmap_scan(const char *target_package_name, const char *target_apk_path,
 
     return EXIT_SUCCESS;
 }
-
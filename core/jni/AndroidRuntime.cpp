@@ -1251,28 +1251,32 @@ static void quickTest(void* arg)
 }
 #endif
 
-#ifdef NDEBUG
-    #define REG_JNI(name)      { name }
-    struct RegJNIRec {
-        int (*mProc)(JNIEnv*);
-    };
-#else
-    #define REG_JNI(name)      { name, #name }
-    struct RegJNIRec {
-        int (*mProc)(JNIEnv*);
-        const char* mName;
-    };
-#endif
+/*
+ * The names are kept in release builds too, so that a boot trace shows how
+ * long each table takes to register. That is the profile to look at before
+ * moving anything off the zygote startup path.
+ */
+#define REG_JNI(name)      { name, #name }
+struct RegJNIRec {
+    int (*mProc)(JNIEnv*);
+    const char* mName;
+};
 
 typedef void (*RegJAMProc)();
 
 static int register_jni_procs(const RegJNIRec array[], size_t count, JNIEnv* env)
 {
+    const bool traced = ATRACE_ENABLED();
     for (size_t i = 0; i < count; i++) {
-        if (array[i].mProc(env) < 0) {
-#ifndef NDEBUG
-            ALOGD("----------!!! %s failed to load\n", array[i].mName);
-#endif
+        if (traced) {
+            ATRACE_BEGIN(array[i].mName);
+        }
+        int result = array[i].mProc(env);
+        if (traced) {
+            ATRACE_END();
+        }
+        if (result < 0) {
+            ALOGE("----------!!! %s failed to load\n", array[i].mName);
             return -1;
         }
     }
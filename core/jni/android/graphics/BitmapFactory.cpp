@@ -385,6 +385,7 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
     RecyclingPixelAllocator recyclingAllocator(reuseBitmap, existingBufferSize);
     ScaleCheckingAllocator scaleCheckingAllocator(scale, existingBufferSize);
     SkBitmap::HeapAllocator heapAllocator;
+    HardwarePixelAllocator hardwareAllocator;
     SkBitmap::Allocator* decodeAllocator;
     if (javaBitmap != nullptr && willScale) {
         // This will allocate pixels using a HeapAllocator, since there will be an extra
@@ -393,6 +394,9 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
         decodeAllocator = &scaleCheckingAllocator;
     } else if (javaBitmap != nullptr) {
         decodeAllocator = &recyclingAllocator;
+    } else if (isHardware && !willScale && decodeColorType == kN32_SkColorType) {
+        // Decode straight into the hardware bitmap, there is nothing to upload afterwards
+        decodeAllocator = &hardwareAllocator;
     } else if (willScale || isHardware) {
         // This will allocate pixels using a HeapAllocator,
         // for scale case: there will be an extra scaling step.
@@ -441,11 +445,19 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
                 bitmapInfo.makeColorType(kAlpha_8_SkColorType).makeAlphaType(kPremul_SkAlphaType);
     }
     SkBitmap decodingBitmap;
-    if (!decodingBitmap.setInfo(bitmapInfo) ||
-            !decodingBitmap.tryAllocPixels(decodeAllocator, colorTable.get())) {
+    if (!decodingBitmap.setInfo(bitmapInfo)) {
         // SkAndroidCodec should recommend a valid SkImageInfo, so setInfo()
         // should only only fail if the calculated value for rowBytes is too
         // large.
+        return nullptr;
+    }
+    if (decodeAllocator == &hardwareAllocator
+            && !decodingBitmap.tryAllocPixels(decodeAllocator, colorTable.get())) {
+        // Gralloc may not support CPU writes for this buffer, upload it instead
+        decodeAllocator = &heapAllocator;
+    }
+    if (!decodingBitmap.getPixels()
+            && !decodingBitmap.tryAllocPixels(decodeAllocator, colorTable.get())) {
         // tryAllocPixels() can fail due to OOM on the Java heap, OOM on the
         // native heap, or the recycled javaBitmap being too small to reuse.
         return nullptr;
@@ -516,20 +528,26 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
         const float sy = scaledHeight / float(decodingBitmap.height());
 
         // Set the allocator for the outputBitmap.
-        SkBitmap::Allocator* outputAllocator;
-        if (javaBitmap != nullptr) {
-            outputAllocator = &recyclingAllocator;
-        } else {
-            outputAllocator = &defaultAllocator;
-        }
-
         SkColorType scaledColorType = colorTypeForScaledOutput(decodingBitmap.colorType());
         // FIXME: If the alphaType is kUnpremul and the image has alpha, the
         // colors may not be correct, since Skia does not yet support drawing
         // to/from unpremultiplied bitmaps.
         outputBitmap.setInfo(
                 bitmapInfo.makeWH(scaledWidth, scaledHeight).makeColorType(scaledColorType));
-        if (!outputBitmap.tryAllocPixels(outputAllocator, NULL)) {
+
+        // Set the allocator for the outputBitmap.
+        SkBitmap::Allocator* outputAllocator;
+        if (javaBitmap != nullptr) {
+            outputAllocator = &recyclingAllocator;
+        } else {
+            outputAllocator = &defaultAllocator;
+        }
+        if (isHardware && javaBitmap == nullptr && scaledColorType == kN32_SkColorType
+                && outputBitmap.tryAllocPixels(&hardwareAllocator, NULL)) {
+            // Scale straight into the hardware bitmap, there is nothing to upload afterwards
+            outputAllocator = &hardwareAllocator;
+        }
+        if (!outputBitmap.getPixels() && !outputBitmap.tryAllocPixels(outputAllocator, NULL)) {
             // This should only fail on OOM.  The recyclingAllocator should have
             // enough memory since we check this before decoding using the
             // scaleCheckingAllocator.
@@ -583,7 +601,10 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
     if (isPremultiplied) bitmapCreateFlags |= android::bitmap::kBitmapCreateFlag_Premultiplied;
 
     if (isHardware) {
-        sk_sp<Bitmap> hardwareBitmap = Bitmap::allocateHardwareBitmap(outputBitmap);
+        sk_sp<Bitmap> hardwareBitmap(hardwareAllocator.getStorageObjAndReset());
+        if (!hardwareBitmap) {
+            hardwareBitmap = Bitmap::allocateHardwareBitmap(outputBitmap);
+        }
         return bitmap::createBitmap(env, hardwareBitmap.release(), bitmapCreateFlags,
                 ninePatchChunk, ninePatchInsets, -1);
     }
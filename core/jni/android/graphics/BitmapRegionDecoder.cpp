@@ -24,6 +24,7 @@
 #include "SkBitmap.h"
 #include "SkBitmapRegionDecoder.h"
 #include "SkCodec.h"
+#include "SkColorSpace.h"
 #include "SkData.h"
 #include "SkUtils.h"
 #include "SkPixelRef.h"
@@ -39,10 +40,99 @@
 #include <jni.h>
 #include <sys/stat.h>
 
+#include <list>
 #include <memory>
+#include <mutex>
 
 using namespace android;
 
+// Viewers keep re-requesting the same tiles while panning and zooming back and forth, so
+// each decoder keeps the most recently decoded ones around to skip the codec on those.
+static const size_t kTileCacheBudget = 8 * 1024 * 1024;
+// Larger regions are rarely requested twice and would evict every tile.
+static const size_t kMaxCachedTileSize = kTileCacheBudget / 4;
+
+/**
+ * Owns the SkBitmapRegionDecoder behind a Java BitmapRegionDecoder, along with a small LRU
+ * cache of decoded regions keyed by the parameters of the decode. Cached pixels are always
+ * copied into the bitmap handed back to Java, so callers are free to modify it.
+ */
+class CachingRegionDecoder {
+public:
+    explicit CachingRegionDecoder(std::unique_ptr<SkBitmapRegionDecoder> brd)
+            : mDecoder(std::move(brd)) {}
+
+    SkBitmapRegionDecoder* decoder() { return mDecoder.get(); }
+
+    bool decodeRegion(SkBitmap* bitmap, SkBRDAllocator* allocator, const SkIRect& subset,
+            int sampleSize, SkColorType colorType, bool requireUnpremul,
+            sk_sp<SkColorSpace> colorSpace) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mTiles.begin(); it != mTiles.end(); it++) {
+            if (it->matches(subset, sampleSize, colorType, requireUnpremul, colorSpace.get())) {
+                mTiles.splice(mTiles.begin(), mTiles, it);
+                return copyTile(mTiles.front().pixels, bitmap, allocator);
+            }
+        }
+
+        // The codec keeps per-decode state, decodes of the same image can't run concurrently
+        if (!mDecoder->decodeRegion(bitmap, allocator, subset, sampleSize,
+                colorType, requireUnpremul, colorSpace)) {
+            return false;
+        }
+
+        size_t size = bitmap->getSize();
+        if (size > kMaxCachedTileSize || bitmap->colorType() == kIndex_8_SkColorType) {
+            return true;
+        }
+        Tile tile { subset, sampleSize, colorType, requireUnpremul, std::move(colorSpace) };
+        if (!tile.pixels.tryAllocPixels(bitmap->info())
+                || !bitmap->readPixels(tile.pixels.info(), tile.pixels.getPixels(),
+                        tile.pixels.rowBytes(), 0, 0)) {
+            return true;
+        }
+        while (mCachedBytes + size > kTileCacheBudget) {
+            mCachedBytes -= mTiles.back().pixels.getSize();
+            mTiles.pop_back();
+        }
+        mCachedBytes += size;
+        mTiles.push_front(std::move(tile));
+        return true;
+    }
+
+private:
+    struct Tile {
+        SkIRect subset;
+        int sampleSize;
+        SkColorType colorType;
+        bool requireUnpremul;
+        sk_sp<SkColorSpace> colorSpace;
+        SkBitmap pixels;
+
+        bool matches(const SkIRect& otherSubset, int otherSampleSize, SkColorType otherColorType,
+                bool otherRequireUnpremul, SkColorSpace* otherColorSpace) const {
+            return subset == otherSubset
+                    && sampleSize == otherSampleSize
+                    && colorType == otherColorType
+                    && requireUnpremul == otherRequireUnpremul
+                    && SkColorSpace::Equals(colorSpace.get(), otherColorSpace);
+        }
+    };
+
+    static bool copyTile(const SkBitmap& pixels, SkBitmap* bitmap, SkBRDAllocator* allocator) {
+        if (!bitmap->setInfo(pixels.info()) || !bitmap->tryAllocPixels(allocator, nullptr)) {
+            return false;
+        }
+        return pixels.readPixels(bitmap->info(), bitmap->getPixels(), bitmap->rowBytes(), 0, 0);
+    }
+
+    std::mutex mLock;
+    std::unique_ptr<SkBitmapRegionDecoder> mDecoder;
+    // Most recently used first
+    std::list<Tile> mTiles;
+    size_t mCachedBytes = 0;
+};
+
 static jobject createBitmapRegionDecoder(JNIEnv* env, std::unique_ptr<SkStreamRewindable> stream) {
   std::unique_ptr<SkBitmapRegionDecoder> brd(
             SkBitmapRegionDecoder::Create(stream.release(),
@@ -52,7 +142,7 @@ static jobject createBitmapRegionDecoder(JNIEnv* env, std::unique_ptr<SkStreamRe
         return nullObjectReturn("CreateBitmapRegionDecoder returned null");
     }
 
-    return GraphicsJNI::createBitmapRegionDecoder(env, brd.release());
+    return GraphicsJNI::createBitmapRegionDecoder(env, new CachingRegionDecoder(std::move(brd)));
 }
 
 static jobject nativeNewInstanceFromByteArray(JNIEnv* env, jobject, jbyteArray byteArray,
@@ -155,7 +245,8 @@ static jobject nativeDecodeRegion(JNIEnv* env, jobject, jlong brdHandle, jint in
         env->SetObjectField(options, gOptions_outColorSpaceFieldID, 0);
     }
 
-    SkBitmapRegionDecoder* brd = reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+    CachingRegionDecoder* cachingDecoder = reinterpret_cast<CachingRegionDecoder*>(brdHandle);
+    SkBitmapRegionDecoder* brd = cachingDecoder->decoder();
 
     SkColorType decodeColorType = brd->computeOutputColorType(colorType);
     sk_sp<SkColorSpace> decodeColorSpace = brd->computeOutputColorSpace(
@@ -187,7 +278,7 @@ static jobject nativeDecodeRegion(JNIEnv* env, jobject, jlong brdHandle, jint in
     // Decode the region.
     SkIRect subset = SkIRect::MakeXYWH(inputX, inputY, inputWidth, inputHeight);
     SkBitmap bitmap;
-    if (!brd->decodeRegion(&bitmap, allocator, subset, sampleSize,
+    if (!cachingDecoder->decodeRegion(&bitmap, allocator, subset, sampleSize,
             decodeColorType, requireUnpremul, decodeColorSpace)) {
         return nullObjectReturn("Failed to decode region.");
     }
@@ -235,19 +326,18 @@ static jobject nativeDecodeRegion(JNIEnv* env, jobject, jlong brdHandle, jint in
 
 static jint nativeGetHeight(JNIEnv* env, jobject, jlong brdHandle) {
     SkBitmapRegionDecoder* brd =
-            reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+            reinterpret_cast<CachingRegionDecoder*>(brdHandle)->decoder();
     return static_cast<jint>(brd->height());
 }
 
 static jint nativeGetWidth(JNIEnv* env, jobject, jlong brdHandle) {
     SkBitmapRegionDecoder* brd =
-            reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+            reinterpret_cast<CachingRegionDecoder*>(brdHandle)->decoder();
     return static_cast<jint>(brd->width());
 }
 
 static void nativeClean(JNIEnv* env, jobject, jlong brdHandle) {
-    SkBitmapRegionDecoder* brd =
-            reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+    CachingRegionDecoder* brd = reinterpret_cast<CachingRegionDecoder*>(brdHandle);
     delete brd;
 }
 
@@ -37,7 +37,16 @@
 #include <utils/FatVector.h>
 #include <minikin/FontFamily.h>
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace android {
 
@@ -95,8 +104,78 @@ static void FontFamily_unref(jlong familyPtr) {
     delete family;
 }
 
-static bool addSkTypeface(NativeFamilyBuilder* builder, sk_sp<SkData>&& data, int ttcIndex,
-        jint givenWeight, jint givenItalic) {
+/**
+ * Identifies the bytes of a font and how they are instantiated. Fonts created from the same
+ * bytes with the same parameters share their MinikinFontSkia, and with it the SkTypeface and
+ * the HarfBuzz face that minikin builds out of its tables.
+ */
+struct FontKey {
+    enum class Source : uint8_t {
+        // id is the address of a buffer, which is stable while a font holds on to it
+        Buffer,
+        // id and inode identify a file, the font starts at offset
+        File,
+    };
+
+    Source source;
+    uint64_t id;
+    uint64_t inode;
+    uint64_t offset;
+    uint64_t size;
+    int ttcIndex;
+    std::vector<minikin::FontVariation> axes;
+
+    bool operator==(const FontKey& other) const {
+        if (source != other.source || id != other.id || inode != other.inode
+                || offset != other.offset || size != other.size || ttcIndex != other.ttcIndex
+                || axes.size() != other.axes.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < axes.size(); i++) {
+            if (axes[i].axisTag != other.axes[i].axisTag || axes[i].value != other.axes[i].value) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+class FontRegistry {
+public:
+    std::shared_ptr<minikin::MinikinFont> find(const FontKey& key) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto& entry : mEntries) {
+            if (entry.first == key) {
+                return entry.second.lock();
+            }
+        }
+        return nullptr;
+    }
+
+    void add(FontKey&& key, const std::shared_ptr<minikin::MinikinFont>& font) {
+        std::lock_guard<std::mutex> lock(mLock);
+        // Forget the fonts that all typefaces let go of
+        mEntries.erase(std::remove_if(mEntries.begin(), mEntries.end(),
+                [&key](const std::pair<FontKey, std::weak_ptr<minikin::MinikinFont>>& entry) {
+                    return entry.second.expired() || entry.first == key;
+                }), mEntries.end());
+        mEntries.emplace_back(std::move(key), font);
+    }
+
+private:
+    std::mutex mLock;
+    std::vector<std::pair<FontKey, std::weak_ptr<minikin::MinikinFont>>> mEntries;
+};
+
+static FontRegistry gFontRegistry;
+
+static FontKey makeFontKey(NativeFamilyBuilder* builder, FontKey::Source source, uint64_t id,
+        uint64_t inode, uint64_t offset, uint64_t size, int ttcIndex) {
+    return FontKey{source, id, inode, offset, size, ttcIndex, builder->axes};
+}
+
+static std::shared_ptr<minikin::MinikinFont> createMinikinFont(NativeFamilyBuilder* builder,
+        sk_sp<SkData>&& data, int ttcIndex) {
     uirenderer::FatVector<SkFontMgr::FontParameters::Axis, 2> skiaAxes;
     for (const auto& axis : builder->axes) {
         skiaAxes.emplace_back(SkFontMgr::FontParameters::Axis{axis.axisTag, axis.value});
@@ -114,12 +193,18 @@ static bool addSkTypeface(NativeFamilyBuilder* builder, sk_sp<SkData>&& data, in
     sk_sp<SkTypeface> face(fm->createFromStream(fontData.release(), params));
     if (face == NULL) {
         ALOGE("addFont failed to create font, invalid request");
-        builder->axes.clear();
+        return nullptr;
+    }
+    return std::make_shared<MinikinFontSkia>(std::move(face), fontPtr, fontSize, ttcIndex,
+            builder->axes);
+}
+
+static bool addMinikinFont(NativeFamilyBuilder* builder,
+        std::shared_ptr<minikin::MinikinFont>&& minikinFont, jint givenWeight, jint givenItalic) {
+    builder->axes.clear();
+    if (!minikinFont) {
         return false;
     }
-    std::shared_ptr<minikin::MinikinFont> minikinFont =
-            std::make_shared<MinikinFontSkia>(std::move(face), fontPtr, fontSize, ttcIndex,
-                    builder->axes);
 
     int weight = givenWeight / 100;
     bool italic = givenItalic == 1;
@@ -139,11 +224,17 @@ static bool addSkTypeface(NativeFamilyBuilder* builder, sk_sp<SkData>&& data, in
         }
     }
 
-    builder->fonts.push_back(minikin::Font(minikinFont, minikin::FontStyle(weight, italic)));
-    builder->axes.clear();
+    builder->fonts.push_back(minikin::Font(std::move(minikinFont),
+            minikin::FontStyle(weight, italic)));
     return true;
 }
 
+static bool addSkTypeface(NativeFamilyBuilder* builder, sk_sp<SkData>&& data, int ttcIndex,
+        jint givenWeight, jint givenItalic) {
+    return addMinikinFont(builder, createMinikinFont(builder, std::move(data), ttcIndex),
+            givenWeight, givenItalic);
+}
+
 static void release_global_ref(const void* /*data*/, void* context) {
     JNIEnv* env = AndroidRuntime::getJNIEnv();
     bool needToAttach = (env == NULL);
@@ -167,10 +258,8 @@ static void release_global_ref(const void* /*data*/, void* context) {
     }
 }
 
-static jboolean FontFamily_addFont(JNIEnv* env, jobject clazz, jlong builderPtr, jobject bytebuf,
+static jboolean addFontFromBuffer(JNIEnv* env, NativeFamilyBuilder* builder, jobject bytebuf,
         jint ttcIndex, jint weight, jint isItalic) {
-    NPE_CHECK_RETURN_ZERO(env, bytebuf);
-    NativeFamilyBuilder* builder = reinterpret_cast<NativeFamilyBuilder*>(builderPtr);
     const void* fontPtr = env->GetDirectBufferAddress(bytebuf);
     if (fontPtr == NULL) {
         ALOGE("addFont failed to create font, buffer invalid");
@@ -183,36 +272,106 @@ static jboolean FontFamily_addFont(JNIEnv* env, jobject clazz, jlong builderPtr,
         builder->axes.clear();
         return false;
     }
-    jobject fontRef = MakeGlobalRefOrDie(env, bytebuf);
-    sk_sp<SkData> data(SkData::MakeWithProc(fontPtr, fontSize,
-            release_global_ref, reinterpret_cast<void*>(fontRef)));
-    return addSkTypeface(builder, std::move(data), ttcIndex, weight, isItalic);
+
+    FontKey key = makeFontKey(builder, FontKey::Source::Buffer,
+            reinterpret_cast<uintptr_t>(fontPtr), 0, 0, fontSize, ttcIndex);
+    std::shared_ptr<minikin::MinikinFont> minikinFont = gFontRegistry.find(key);
+    if (!minikinFont) {
+        jobject fontRef = MakeGlobalRefOrDie(env, bytebuf);
+        sk_sp<SkData> data(SkData::MakeWithProc(fontPtr, fontSize,
+                release_global_ref, reinterpret_cast<void*>(fontRef)));
+        minikinFont = createMinikinFont(builder, std::move(data), ttcIndex);
+        if (minikinFont) {
+            gFontRegistry.add(std::move(key), minikinFont);
+        }
+    }
+    return addMinikinFont(builder, std::move(minikinFont), weight, isItalic);
+}
+
+static jboolean FontFamily_addFont(JNIEnv* env, jobject clazz, jlong builderPtr, jobject bytebuf,
+        jint ttcIndex, jint weight, jint isItalic) {
+    NPE_CHECK_RETURN_ZERO(env, bytebuf);
+    NativeFamilyBuilder* builder = reinterpret_cast<NativeFamilyBuilder*>(builderPtr);
+    return addFontFromBuffer(env, builder, bytebuf, ttcIndex, weight, isItalic);
 }
 
 static jboolean FontFamily_addFontWeightStyle(JNIEnv* env, jobject clazz, jlong builderPtr,
         jobject font, jint ttcIndex, jint weight, jint isItalic) {
     NPE_CHECK_RETURN_ZERO(env, font);
     NativeFamilyBuilder* builder = reinterpret_cast<NativeFamilyBuilder*>(builderPtr);
-    const void* fontPtr = env->GetDirectBufferAddress(font);
-    if (fontPtr == NULL) {
-        ALOGE("addFont failed to create font, buffer invalid");
-        builder->axes.clear();
+    return addFontFromBuffer(env, builder, font, ttcIndex, weight, isItalic);
+}
+
+static void releaseAsset(const void* ptr, void* context) {
+    delete static_cast<Asset*>(context);
+}
+
+struct FontMapping {
+    void* address;
+    size_t length;
+};
+
+static void releaseMapping(const void* ptr, void* context) {
+    FontMapping* mapping = static_cast<FontMapping*>(context);
+    munmap(mapping->address, mapping->length);
+    delete mapping;
+}
+
+/**
+ * Maps an asset stored uncompressed read-only, so that its pages are shared with every other
+ * process using the same font, rather than going through the buffer of the Asset. Takes
+ * ownership of fd.
+ */
+static sk_sp<SkData> mapFontFile(int fd, off64_t start, off64_t length) {
+    static const off64_t pageSize = sysconf(_SC_PAGE_SIZE);
+    off64_t alignedStart = start & ~(pageSize - 1);
+    size_t mappedLength = length + (start - alignedStart);
+    void* address = mmap(nullptr, mappedLength, PROT_READ, MAP_SHARED, fd, alignedStart);
+    close(fd);
+    if (address == MAP_FAILED) {
+        ALOGW("Failed to map font: %s", strerror(errno));
+        return nullptr;
+    }
+    FontMapping* mapping = new FontMapping{address, mappedLength};
+    return SkData::MakeWithProc(static_cast<uint8_t*>(address) + (start - alignedStart), length,
+            releaseMapping, mapping);
+}
+
+/**
+ * Shares the font with the other typefaces created from the same file, as long as the asset
+ * is stored uncompressed. Returns false if it isn't, the caller then loads it from the Asset.
+ */
+static bool addFontFromAssetFile(NativeFamilyBuilder* builder, Asset* asset, jint ttcIndex,
+        jint weight, jint isItalic, jboolean* outResult) {
+    off64_t start;
+    off64_t length;
+    int fd = asset->openFileDescriptor(&start, &length);
+    if (fd < 0) {
         return false;
     }
-    jlong fontSize = env->GetDirectBufferCapacity(font);
-    if (fontSize < 0) {
-        ALOGE("addFont failed to create font, buffer size invalid");
-        builder->axes.clear();
+    struct stat fdStat;
+    if (fstat(fd, &fdStat) == -1) {
+        close(fd);
         return false;
     }
-    jobject fontRef = MakeGlobalRefOrDie(env, font);
-    sk_sp<SkData> data(SkData::MakeWithProc(fontPtr, fontSize,
-            release_global_ref, reinterpret_cast<void*>(fontRef)));
-    return addSkTypeface(builder, std::move(data), ttcIndex, weight, isItalic);
-}
 
-static void releaseAsset(const void* ptr, void* context) {
-    delete static_cast<Asset*>(context);
+    FontKey key = makeFontKey(builder, FontKey::Source::File, fdStat.st_dev, fdStat.st_ino,
+            start, length, ttcIndex);
+    std::shared_ptr<minikin::MinikinFont> minikinFont = gFontRegistry.find(key);
+    if (minikinFont) {
+        close(fd);
+    } else {
+        sk_sp<SkData> data = mapFontFile(fd, start, length);
+        if (!data) {
+            return false;
+        }
+        minikinFont = createMinikinFont(builder, std::move(data), ttcIndex);
+        if (minikinFont) {
+            gFontRegistry.add(std::move(key), minikinFont);
+        }
+    }
+    *outResult = addMinikinFont(builder, std::move(minikinFont), weight, isItalic);
+    return true;
 }
 
 static jboolean FontFamily_addFontFromAssetManager(JNIEnv* env, jobject, jlong builderPtr,
@@ -247,6 +406,12 @@ static jboolean FontFamily_addFontFromAssetManager(JNIEnv* env, jobject, jlong b
         return false;
     }
 
+    jboolean result;
+    if (addFontFromAssetFile(builder, asset, ttcIndex, weight, isItalic, &result)) {
+        delete asset;
+        return result;
+    }
+
     const void* buf = asset->getBuffer(false);
     if (NULL == buf) {
         delete asset;
@@ -15,6 +15,9 @@
 
 #include "gif_lib.h"
 
+#include <algorithm>
+#include <vector>
+
 #if GIFLIB_MAJOR < 5 || (GIFLIB_MAJOR == 5 && GIFLIB_MINOR == 0)
 #define DGifCloseFile(a, b) DGifCloseFile(a)
 #endif
@@ -30,11 +33,18 @@ protected:
     virtual bool onGetBitmap(SkBitmap*);
 
 private:
+    void computeFrameInfo();
+
     GifFileType* fGIF;
     int fCurrIndex;
     int fLastDrawIndex;
     SkBitmap fBackup;
     SkColor fPaintingColor;
+    // time at which each frame ends, from the start of the movie
+    std::vector<SkMSec> fFrameEndTimes;
+    // for each frame, the last frame at or before it that repaints the whole
+    // image, so that compositing can start there instead of at the first one
+    std::vector<int> fKeyFrames;
 };
 
 static int Decode(GifFileType* fileType, GifByteType* out, int size) {
@@ -60,6 +70,9 @@ GIFMovie::GIFMovie(SkStream* stream)
     fCurrIndex = -1;
     fLastDrawIndex = -1;
     fPaintingColor = SkPackARGB32(0, 0, 0, 0);
+    if (fGIF) {
+        computeFrameInfo();
+    }
 }
 
 GIFMovie::~GIFMovie()
@@ -87,11 +100,7 @@ bool GIFMovie::onGetInfo(Info* info)
     if (nullptr == fGIF)
         return false;
 
-    SkMSec dur = 0;
-    for (int i = 0; i < fGIF->ImageCount; i++)
-        dur += savedimage_duration(&fGIF->SavedImages[i]);
-
-    info->fDuration = dur;
+    info->fDuration = fFrameEndTimes.empty() ? 0 : fFrameEndTimes.back();
     info->fWidth = fGIF->SWidth;
     info->fHeight = fGIF->SHeight;
     info->fIsOpaque = false;    // how to compute?
@@ -103,15 +112,12 @@ bool GIFMovie::onSetTime(SkMSec time)
     if (nullptr == fGIF)
         return false;
 
-    SkMSec dur = 0;
-    for (int i = 0; i < fGIF->ImageCount; i++)
+    // first frame that ends at or after the requested time
+    auto frame = std::lower_bound(fFrameEndTimes.begin(), fFrameEndTimes.end(), time);
+    if (frame != fFrameEndTimes.end())
     {
-        dur += savedimage_duration(&fGIF->SavedImages[i]);
-        if (dur >= time)
-        {
-            fCurrIndex = i;
-            return fLastDrawIndex != fCurrIndex;
-        }
+        fCurrIndex = frame - fFrameEndTimes.begin();
+        return fLastDrawIndex != fCurrIndex;
     }
     fCurrIndex = fGIF->ImageCount - 1;
     return true;
@@ -303,6 +309,33 @@ static bool checkIfCover(const SavedImage* target, const SavedImage* covered)
     return false;
 }
 
+static void copyRect(const SkBitmap* src, SkBitmap* dst, const GifImageDesc& desc)
+{
+    const int width = src->width();
+    const int height = src->height();
+    if (desc.Left >= width || desc.Top >= height) {
+        return;
+    }
+    const int copyWidth = std::min<int>(desc.Width, width - desc.Left);
+    const int copyHeight = std::min<int>(desc.Height, height - desc.Top);
+    for (int row = 0; row < copyHeight; row++) {
+        memcpy(dst->getAddr32(desc.Left, desc.Top + row), src->getAddr32(desc.Left, desc.Top + row),
+               copyWidth * sizeof(uint32_t));
+    }
+}
+
+// return true if the frame repaints every pixel of the image, regardless of what
+// the previous frames left, and leaves something the next frames can build on
+static bool checkIfKeyFrame(const SavedImage* frame, int width, int height)
+{
+    bool trans;
+    int disposal;
+    getTransparencyAndDisposalMethod(frame, &trans, &disposal);
+    return !trans && disposal != 3
+            && frame->ImageDesc.Left == 0 && frame->ImageDesc.Top == 0
+            && frame->ImageDesc.Width >= width && frame->ImageDesc.Height >= height;
+}
+
 static void disposeFrameIfNeeded(SkBitmap* bm, const SavedImage* cur, const SavedImage* next,
                                  SkBitmap* backup, SkColor color)
 {
@@ -327,17 +360,43 @@ static void disposeFrameIfNeeded(SkBitmap* bm, const SavedImage* cur, const Save
 
         // restore to previous
         case 3:
-            bm->swap(*backup);
+            copyRect(backup, bm, cur->ImageDesc);
             break;
         }
     }
 
-    // Save current image if next frame's disposal method == 3
+    // Save the area the next frame draws to if its disposal method == 3,
+    // that's the only part of the image it can change
     if (nextDisposal == 3) {
-        const uint32_t* src = bm->getAddr32(0, 0);
-        uint32_t* dst = backup->getAddr32(0, 0);
-        int cnt = bm->width() * bm->height();
-        memcpy(dst, src, cnt*sizeof(uint32_t));
+        copyRect(bm, backup, next->ImageDesc);
+    }
+}
+
+void GIFMovie::computeFrameInfo()
+{
+    SkMSec dur = 0;
+    int keyFrame = 0;
+    for (int i = 0; i < fGIF->ImageCount; i++)
+    {
+        const SavedImage* frame = &fGIF->SavedImages[i];
+        dur += savedimage_duration(frame);
+        fFrameEndTimes.push_back(dur);
+
+        if (i > 0 && checkIfKeyFrame(frame, fGIF->SWidth, fGIF->SHeight)) {
+            keyFrame = i;
+        }
+        fKeyFrames.push_back(keyFrame);
+    }
+
+    // The color disposed frames are cleared to, which depends on the first one
+    if (fGIF->ImageCount > 0) {
+        bool trans;
+        int disposal;
+        getTransparencyAndDisposalMethod(&fGIF->SavedImages[0], &trans, &disposal);
+        if (!trans && fGIF->SColorMap != nullptr) {
+            const GifColorType& col = fGIF->SColorMap->Colors[fGIF->SBackGroundColor];
+            fPaintingColor = SkColorSetARGB(0xFF, col.Red, col.Green, col.Blue);
+        }
     }
 }
 
@@ -390,25 +449,19 @@ bool GIFMovie::onGetBitmap(SkBitmap* bm)
         lastIndex = fGIF->ImageCount - 1;
     }
 
-    SkColor bgColor = SkPackARGB32(0, 0, 0, 0);
-    if (gif->SColorMap != nullptr) {
-        const GifColorType& col = gif->SColorMap->Colors[fGIF->SBackGroundColor];
-        bgColor = SkColorSetARGB(0xFF, col.Red, col.Green, col.Blue);
+    // Frames before the last key frame are entirely painted over, skip them
+    const int keyFrame = fKeyFrames[lastIndex];
+    const bool skipToKeyFrame = keyFrame > startIndex;
+    if (skipToKeyFrame) {
+        startIndex = keyFrame;
     }
 
     // draw each frames - not intelligent way
     for (int i = startIndex; i <= lastIndex; i++) {
         const SavedImage* cur = &fGIF->SavedImages[i];
-        if (i == 0) {
-            bool trans;
-            int disposal;
-            getTransparencyAndDisposalMethod(cur, &trans, &disposal);
-            if (!trans && gif->SColorMap != nullptr) {
-                fPaintingColor = bgColor;
-            } else {
-                fPaintingColor = SkColorSetARGB(0, 0, 0, 0);
-            }
-
+        if (i == keyFrame && skipToKeyFrame) {
+            // Nothing of the previous frames shows through, no need to dispose them
+        } else if (i == 0) {
             bm->eraseColor(fPaintingColor);
             fBackup.eraseColor(fPaintingColor);
         } else {
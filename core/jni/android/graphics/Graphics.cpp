@@ -80,7 +80,7 @@ AutoJavaFloatArray::~AutoJavaFloatArray() {
 }
 
 AutoJavaIntArray::AutoJavaIntArray(JNIEnv* env, jintArray array,
-                                       int minLength)
+                                       int minLength, JNIAccess access)
 : fEnv(env), fArray(array), fPtr(NULL), fLen(0) {
     SkASSERT(env);
     if (array) {
@@ -90,11 +90,12 @@ AutoJavaIntArray::AutoJavaIntArray(JNIEnv* env, jintArray array,
         }
         fPtr = env->GetIntArrayElements(array, NULL);
     }
+    fReleaseMode = (access == kRO_JNIAccess) ? JNI_ABORT : 0;
 }
 
 AutoJavaIntArray::~AutoJavaIntArray() {
     if (fPtr) {
-        fEnv->ReleaseIntArrayElements(fArray, fPtr, 0);
+        fEnv->ReleaseIntArrayElements(fArray, fPtr, fReleaseMode);
     }
 }
 
@@ -412,13 +413,13 @@ SkRegion* GraphicsJNI::getNativeRegion(JNIEnv* env, jobject region)
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 
-jobject GraphicsJNI::createBitmapRegionDecoder(JNIEnv* env, SkBitmapRegionDecoder* bitmap)
+jobject GraphicsJNI::createBitmapRegionDecoder(JNIEnv* env, CachingRegionDecoder* decoder)
 {
-    SkASSERT(bitmap != NULL);
+    SkASSERT(decoder != NULL);
 
     jobject obj = env->NewObject(gBitmapRegionDecoder_class,
             gBitmapRegionDecoder_constructorMethodID,
-            reinterpret_cast<jlong>(bitmap));
+            reinterpret_cast<jlong>(decoder));
     hasException(env); // For the side effect of logging.
     return obj;
 }
@@ -620,6 +621,43 @@ bool HeapAllocator::allocPixelRef(SkBitmap* bitmap, SkColorTable* ctable) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+HardwarePixelAllocator::~HardwarePixelAllocator() {
+    unlockPixels();
+}
+
+bool HardwarePixelAllocator::allocPixelRef(SkBitmap* bitmap, SkColorTable* ctable) {
+    if (ctable) {
+        return false;
+    }
+    sk_sp<android::Bitmap> storage =
+            android::Bitmap::allocateCpuWritableHardwareBitmap(bitmap->info());
+    if (!storage) {
+        return false;
+    }
+    void* pixels = nullptr;
+    if (storage->graphicBuffer()->lock(GraphicBuffer::USAGE_SW_WRITE_RARELY, &pixels) != OK) {
+        ALOGW("Failed to lock hardware bitmap for writing");
+        return false;
+    }
+    unlockPixels();
+    mStorage = std::move(storage);
+    // The buffer stride may be wider than the bitmap
+    return bitmap->installPixels(bitmap->info(), pixels, mStorage->rowBytes());
+}
+
+android::Bitmap* HardwarePixelAllocator::getStorageObjAndReset() {
+    unlockPixels();
+    return mStorage.release();
+}
+
+void HardwarePixelAllocator::unlockPixels() {
+    if (mStorage) {
+        mStorage->graphicBuffer()->unlock();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 RecyclingClippingPixelAllocator::RecyclingClippingPixelAllocator(
         android::Bitmap* recycledBitmap, size_t recycledBytes)
     : mRecycledBitmap(recycledBitmap)
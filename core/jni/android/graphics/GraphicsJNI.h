@@ -15,7 +15,7 @@
 #include <hwui/Canvas.h>
 #include <hwui/Bitmap.h>
 
-class SkBitmapRegionDecoder;
+class CachingRegionDecoder;
 class SkCanvas;
 
 namespace android {
@@ -88,7 +88,7 @@ public:
 
     static jobject createRegion(JNIEnv* env, SkRegion* region);
 
-    static jobject createBitmapRegionDecoder(JNIEnv* env, SkBitmapRegionDecoder* bitmap);
+    static jobject createBitmapRegionDecoder(JNIEnv* env, CachingRegionDecoder* decoder);
 
     static android::Bitmap* mapAshmemBitmap(JNIEnv* env, SkBitmap* bitmap,
             SkColorTable* ctable, int fd, void* addr, size_t size, bool readOnly);
@@ -141,6 +141,31 @@ private:
     sk_sp<android::Bitmap> mStorage;
 };
 
+/**
+ *  Allocator writing the pixels straight into a hardware bitmap, which saves
+ *  decoding into a separate buffer just to upload it. Fails when the pixels
+ *  can't be written by the CPU, see Bitmap::allocateCpuWritableHardwareBitmap.
+ *
+ *  The pixels are only accessible until getStorageObjAndReset() is called.
+ */
+class HardwarePixelAllocator : public SkBitmap::Allocator {
+public:
+    HardwarePixelAllocator() { };
+    ~HardwarePixelAllocator();
+
+    virtual bool allocPixelRef(SkBitmap* bitmap, SkColorTable* ctable) override;
+
+    /**
+     * Unlocks the pixels and fetches the hardware bitmap, if one was allocated.
+     */
+    android::Bitmap* getStorageObjAndReset();
+
+private:
+    void unlockPixels();
+
+    sk_sp<android::Bitmap> mStorage;
+};
+
 /**
  *  Allocator to handle reusing bitmaps for BitmapRegionDecoder.
  *
@@ -241,7 +266,8 @@ private:
 
 class AutoJavaIntArray {
 public:
-    AutoJavaIntArray(JNIEnv* env, jintArray array, int minLength = 0);
+    AutoJavaIntArray(JNIEnv* env, jintArray array,
+                     int minLength = 0, JNIAccess = kRW_JNIAccess);
     ~AutoJavaIntArray();
 
     jint* ptr() const { return fPtr; }
@@ -252,6 +278,7 @@ private:
     jintArray fArray;
     jint*      fPtr;
     int         fLen;
+    int         fReleaseMode;
 };
 
 class AutoJavaShortArray {
@@ -15,6 +15,7 @@
  */
 
 #include "Picture.h"
+#include "SkBBHFactory.h"
 #include "SkStream.h"
 
 #include <memory>
@@ -43,7 +44,11 @@ Canvas* Picture::beginRecording(int width, int height) {
     mRecorder.reset(new SkPictureRecorder);
     mWidth = width;
     mHeight = height;
-    SkCanvas* canvas = mRecorder->beginRecording(SkIntToScalar(width), SkIntToScalar(height));
+    // Pictures are typically recorded once and drawn many times, often partially
+    // clipped. An R-tree lets playback skip the ops outside of the clip.
+    SkRTreeFactory rtreeFactory;
+    SkCanvas* canvas = mRecorder->beginRecording(SkIntToScalar(width), SkIntToScalar(height),
+            &rtreeFactory);
     return Canvas::create_canvas(canvas, Canvas::XformToSRGB::kDefer);
 }
 
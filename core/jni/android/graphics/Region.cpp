@@ -25,6 +25,8 @@
 #include <jni.h>
 #include <core_jni_helpers.h>
 
+#include <vector>
+
 namespace android {
 
 static jfieldID gRegion_nativeInstanceFieldID;
@@ -161,6 +163,27 @@ static void Region_translate(JNIEnv* env, jobject region, jint x, jint y, jobjec
         rgn->translate(x, y);
 }
 
+// Set dst to the union of the given regions, which are left in an unspecified state.
+// Each union costs time linear in the size of both operands, so unioning the regions
+// pairwise is O(n log n), where unioning them into dst one at a time is O(n^2).
+static void union_rgns(SkRegion* dst, std::vector<SkRegion>* rgns) {
+    size_t count = rgns->size();
+    while (count > 1) {
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            (*rgns)[i / 2].op((*rgns)[i], (*rgns)[i + 1], SkRegion::kUnion_Op);
+        }
+        if (count & 1) {
+            (*rgns)[count / 2].swap((*rgns)[count - 1]);
+        }
+        count = (count + 1) / 2;
+    }
+    if (count == 1) {
+        dst->swap((*rgns)[0]);
+    } else {
+        dst->setEmpty();
+    }
+}
+
 // Scale the rectangle by given scale and set the reuslt to the dst.
 static void scale_rect(SkIRect* dst, const SkIRect& src, float scale) {
    dst->fLeft = (int)::roundf(src.fLeft * scale);
@@ -172,15 +195,15 @@ static void scale_rect(SkIRect* dst, const SkIRect& src, float scale) {
 // Scale the region by given scale and set the reuslt to the dst.
 // dest and src can be the same region instance.
 static void scale_rgn(SkRegion* dst, const SkRegion& src, float scale) {
-   SkRegion tmp;
+   std::vector<SkRegion> rgns;
    SkRegion::Iterator iter(src);
 
    for (; !iter.done(); iter.next()) {
        SkIRect r;
        scale_rect(&r, iter.rect(), scale);
-       tmp.op(r, SkRegion::kUnion_Op);
+       rgns.emplace_back(r);
    }
-   dst->swap(tmp);
+   union_rgns(dst, &rgns);
 }
 
 static void Region_scale(JNIEnv* env, jobject region, jfloat scale, jobject dst) {
@@ -212,18 +235,29 @@ static jlong Region_createFromParcel(JNIEnv* env, jobject clazz, jobject parcel)
 
     android::Parcel* p = android::parcelForJavaObject(env, parcel);
 
-    std::vector<int32_t> rects;
-    p->readInt32Vector(&rects);
+    // Same layout as readInt32Vector(), but read in place instead of copied out. Like
+    // readInt32Vector(), a malformed count reads as an empty list.
+    int32_t count = p->readInt32();
+    const int32_t* rects = nullptr;
+    if (count > 0 && size_t(count) <= p->dataAvail() / sizeof(int32_t)) {
+        rects = reinterpret_cast<const int32_t*>(p->readInplace(count * sizeof(int32_t)));
+    }
+    if (rects == nullptr) {
+        count = 0;
+    }
 
-    if ((rects.size() % 4) != 0) {
+    if ((count % 4) != 0) {
         return 0;
     }
 
-    SkRegion* region = new SkRegion;
-    for (size_t x = 0; x + 4 <= rects.size(); x += 4) {
-        region->op(rects[x], rects[x+1], rects[x+2], rects[x+3], SkRegion::kUnion_Op);
+    std::vector<SkRegion> rgns;
+    rgns.reserve(count / 4);
+    for (int32_t x = 0; x + 4 <= count; x += 4) {
+        rgns.emplace_back(SkIRect::MakeLTRB(rects[x], rects[x+1], rects[x+2], rects[x+3]));
     }
 
+    SkRegion* region = new SkRegion;
+    union_rgns(region, &rgns);
     return reinterpret_cast<jlong>(region);
 }
 
@@ -236,18 +270,29 @@ static jboolean Region_writeToParcel(JNIEnv* env, jobject clazz, jlong regionHan
 
     android::Parcel* p = android::parcelForJavaObject(env, parcel);
 
-    std::vector<int32_t> rects;
-    SkRegion::Iterator it(*region);
-    while (!it.done()) {
-        const SkIRect& r = it.rect();
-        rects.push_back(r.fLeft);
-        rects.push_back(r.fTop);
-        rects.push_back(r.fRight);
-        rects.push_back(r.fBottom);
-        it.next();
+    size_t count = 0;
+    for (SkRegion::Iterator it(*region); !it.done(); it.next()) {
+        count++;
     }
 
-    p->writeInt32Vector(rects);
+    // Same layout as writeInt32Vector(), but written in place
+    if (p->writeInt32(count * 4) != NO_ERROR) {
+        return JNI_FALSE;
+    }
+    if (count == 0) {
+        return JNI_TRUE;
+    }
+    int32_t* rects = reinterpret_cast<int32_t*>(p->writeInplace(count * 4 * sizeof(int32_t)));
+    if (rects == nullptr) {
+        return JNI_FALSE;
+    }
+    for (SkRegion::Iterator it(*region); !it.done(); it.next()) {
+        const SkIRect& r = it.rect();
+        *rects++ = r.fLeft;
+        *rects++ = r.fTop;
+        *rects++ = r.fRight;
+        *rects++ = r.fBottom;
+    }
     return JNI_TRUE;
 }
 
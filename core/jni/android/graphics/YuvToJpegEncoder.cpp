@@ -8,6 +8,78 @@
 
 #include <jni.h>
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define YUV_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define YUV_USE_SSE2
+#endif
+
+// Splits count interleaved VU pairs into a row of U and a row of V
+static void deinterleaveVuRow(const uint8_t* vu, uint8_t* u, uint8_t* v, int count) {
+    int i = 0;
+#if defined(YUV_USE_NEON)
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x2_t pairs = vld2q_u8(vu + i * 2);
+        vst1q_u8(v + i, pairs.val[0]);
+        vst1q_u8(u + i, pairs.val[1]);
+    }
+#elif defined(YUV_USE_SSE2)
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    for (; i + 16 <= count; i += 16) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vu + i * 2));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vu + i * 2 + 16));
+        __m128i vs = _mm_packus_epi16(_mm_and_si128(first, lowBytes),
+                _mm_and_si128(second, lowBytes));
+        __m128i us = _mm_packus_epi16(_mm_srli_epi16(first, 8), _mm_srli_epi16(second, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + i), vs);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + i), us);
+    }
+#endif
+    for (; i < count; i++) {
+        u[i] = vu[i * 2 + 1];
+        v[i] = vu[i * 2];
+    }
+}
+
+// Splits count YUYV groups, each holding two pixels, into rows of Y, U and V
+static void deinterleaveYuyvRow(const uint8_t* yuyv, uint8_t* y, uint8_t* u, uint8_t* v,
+        int count) {
+    int i = 0;
+#if defined(YUV_USE_NEON)
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t groups = vld4_u8(yuyv + i * 4);
+        uint8x8x2_t luma = {{ groups.val[0], groups.val[2] }};
+        vst2_u8(y + i * 2, luma);
+        vst1_u8(u + i, groups.val[1]);
+        vst1_u8(v + i, groups.val[3]);
+    }
+#elif defined(YUV_USE_SSE2)
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(yuyv + i * 4));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(yuyv + i * 4 + 16));
+        __m128i luma = _mm_packus_epi16(_mm_and_si128(first, lowBytes),
+                _mm_and_si128(second, lowBytes));
+        // UVUV... as bytes, or one UV pair per 16 bit lane
+        __m128i chroma = _mm_packus_epi16(_mm_srli_epi16(first, 8), _mm_srli_epi16(second, 8));
+        __m128i us = _mm_packus_epi16(_mm_and_si128(chroma, lowBytes), zero);
+        __m128i vs = _mm_packus_epi16(_mm_srli_epi16(chroma, 8), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i * 2), luma);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(u + i), us);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(v + i), vs);
+    }
+#endif
+    for (; i < count; i++) {
+        y[i * 2] = yuyv[i * 4];
+        y[i * 2 + 1] = yuyv[i * 4 + 2];
+        u[i] = yuyv[i * 4 + 1];
+        v[i] = yuyv[i * 4 + 3];
+    }
+}
+
 YuvToJpegEncoder* YuvToJpegEncoder::create(int format, int* strides) {
     // Only ImageFormat.NV21 and ImageFormat.YUY2 are supported
     // for now.
@@ -72,7 +144,6 @@ Yuv420SpToJpegEncoder::Yuv420SpToJpegEncoder(int* strides) :
 
 void Yuv420SpToJpegEncoder::compress(jpeg_compress_struct* cinfo,
         uint8_t* yuv, int* offsets) {
-    SkDebugf("onFlyCompress");
     JSAMPROW y[16];
     JSAMPROW cb[8];
     JSAMPROW cr[8];
@@ -120,13 +191,8 @@ void Yuv420SpToJpegEncoder::deinterleave(uint8_t* vuPlanar, uint8_t* uRows,
     if (numRows > 8) numRows = 8;
     for (int row = 0; row < numRows; ++row) {
         int offset = ((rowIndex >> 1) + row) * fStrides[1];
-        uint8_t* vu = vuPlanar + offset;
-        for (int i = 0; i < (width >> 1); ++i) {
-            int index = row * (width >> 1) + i;
-            uRows[index] = vu[1];
-            vRows[index] = vu[0];
-            vu += 2;
-        }
+        int index = row * (width >> 1);
+        deinterleaveVuRow(vuPlanar + offset, uRows + index, vRows + index, width >> 1);
     }
 }
 
@@ -148,7 +214,6 @@ Yuv422IToJpegEncoder::Yuv422IToJpegEncoder(int* strides) :
 
 void Yuv422IToJpegEncoder::compress(jpeg_compress_struct* cinfo,
         uint8_t* yuv, int* offsets) {
-    SkDebugf("onFlyCompress_422");
     JSAMPROW y[16];
     JSAMPROW cb[16];
     JSAMPROW cr[16];
@@ -195,15 +260,9 @@ void Yuv422IToJpegEncoder::deinterleave(uint8_t* yuv, uint8_t* yRows, uint8_t* u
     if (numRows > 16) numRows = 16;
     for (int row = 0; row < numRows; ++row) {
         uint8_t* yuvSeg = yuv + (rowIndex + row) * fStrides[0];
-        for (int i = 0; i < (width >> 1); ++i) {
-            int indexY = row * width + (i << 1);
-            int indexU = row * (width >> 1) + i;
-            yRows[indexY] = yuvSeg[0];
-            yRows[indexY + 1] = yuvSeg[2];
-            uRows[indexU] = yuvSeg[1];
-            vRows[indexU] = yuvSeg[3];
-            yuvSeg += 4;
-        }
+        int indexU = row * (width >> 1);
+        deinterleaveYuyvRow(yuvSeg, yRows + row * width, uRows + indexU, vRows + indexU,
+                width >> 1);
     }
 }
 
@@ -52,16 +52,9 @@ static jlong nativeOpenPageAndGetSize(JNIEnv* env, jclass thiz, jlong documentPt
     }
     HANDLE_PDFIUM_ERROR_STATE_WITH_RET_CODE(env, -1)
 
-    double width = 0;
-    double height = 0;
-
-    int result = FPDF_GetPageSizeByIndex(document, pageIndex, &width, &height);
-    if (!result) {
-        jniThrowException(env, "java/lang/IllegalStateException",
-                    "cannot get page size");
-        return -1;
-    }
-    HANDLE_PDFIUM_ERROR_STATE_WITH_RET_CODE(env, -1)
+    // Ask the page that was just loaded, getting the size by index would load it again
+    double width = FPDF_GetPageWidth(page);
+    double height = FPDF_GetPageHeight(page);
 
     env->SetIntField(outSize, gPointClassInfo.x, width);
     env->SetIntField(outSize, gPointClassInfo.y, height);
@@ -83,15 +76,8 @@ static void nativeRenderPage(JNIEnv* env, jclass thiz, jlong documentPtr, jlong
     SkBitmap skBitmap;
     GraphicsJNI::getSkBitmap(env, jbitmap, &skBitmap);
 
-    SkAutoLockPixels alp(skBitmap);
-
-    const int stride = skBitmap.width() * 4;
-
-    FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(skBitmap.width(), skBitmap.height(),
-            FPDFBitmap_BGRA, skBitmap.getPixels(), stride);
-    bool isExceptionPending = forwardPdfiumError(env);
-    if (isExceptionPending || bitmap == NULL) {
-        ALOGE("Error creating bitmap");
+    SkIRect bounds = SkIRect::MakeLTRB(clipLeft, clipTop, clipRight, clipBottom);
+    if (!bounds.intersect(SkIRect::MakeWH(skBitmap.width(), skBitmap.height()))) {
         return;
     }
 
@@ -116,6 +102,10 @@ static void nativeRenderPage(JNIEnv* env, jclass thiz, jlong documentPtr, jlong
         matrix = SkMatrix::Concat(*reinterpret_cast<SkMatrix*>(transformPtr), coordinateChange);
     }
 
+    // Only the clipped part of the bitmap is handed to PDFium, so the buffers it allocates
+    // while rendering are sized to it, which makes rendering a page in tiles cheap
+    matrix.postTranslate(-bounds.fLeft, -bounds.fTop);
+
     SkScalar transformValues[6];
     if (!matrix.asAffine(transformValues)) {
         jniThrowException(env, "java/lang/IllegalArgumentException",
@@ -128,9 +118,23 @@ static void nativeRenderPage(JNIEnv* env, jclass thiz, jlong documentPtr, jlong
                            transformValues[SkMatrix::kATransX],
                            transformValues[SkMatrix::kATransY]};
 
-    FS_RECTF clip = {(float) clipLeft, (float) clipTop, (float) clipRight, (float) clipBottom};
+    FS_RECTF clip = {0, 0, (float) bounds.width(), (float) bounds.height()};
+
+    SkAutoLockPixels alp(skBitmap);
+
+    const size_t stride = skBitmap.rowBytes();
+    uint8_t* pixels = reinterpret_cast<uint8_t*>(skBitmap.getAddr(bounds.fLeft, bounds.fTop));
+
+    FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(bounds.width(), bounds.height(),
+            FPDFBitmap_BGRA, pixels, stride);
+    bool isExceptionPending = forwardPdfiumError(env);
+    if (isExceptionPending || bitmap == NULL) {
+        ALOGE("Error creating bitmap");
+        return;
+    }
 
     FPDF_RenderPageBitmapWithMatrix(bitmap, page, &transform, &clip, renderFlags);
+    FPDFBitmap_Destroy(bitmap);
     HANDLE_PDFIUM_ERROR_STATE(env);
 
     skBitmap.notifyPixelsChanged();
@@ -53,6 +53,10 @@ static struct {
 
 static jstring gEmptyString;
 
+// Windows may grow past their requested size while they are filled, until they are sent
+// to another process. This saves re-running queries that just overflow the window.
+static const size_t kMaxWindowGrowth = 4;
+
 static void throwExceptionWithRowCol(JNIEnv* env, jint row, jint column) {
     String8 msg;
     msg.appendFormat("Couldn't read row %d, col %d from CursorWindow.  "
@@ -96,6 +100,7 @@ static jlong nativeCreate(JNIEnv* env, jclass clazz, jstring nameObj, jint curso
                 name.string(), cursorWindowSize, status);
         return 0;
     }
+    window->setMaxSize(size_t(cursorWindowSize) * kMaxWindowGrowth);
 
     LOG_WINDOW("nativeInitializeEmpty: window = %p", window);
     return reinterpret_cast<jlong>(window);
@@ -21,6 +21,7 @@
 #include <JNIHelp.h>
 
 #include <sqlite3.h>
+#include <utils/Timers.h>
 
 // Special log tags defined in SQLiteDebug.java.
 #define SQLITE_LOG_TAG "SQLiteLog"
@@ -46,6 +47,15 @@ void throw_sqlite3_exception_errcode(JNIEnv* env, int errcode, const char* messa
 void throw_sqlite3_exception(JNIEnv* env, int errcode,
         const char* sqlite3Message, const char* message);
 
+/* record one execution of statement on a connection to the database with the given label,
+   windowRefill is true when it continued filling a cursor window past the first rows
+ */
+void record_sqlite3_statement_stats(const char* label, sqlite3_stmt* statement,
+        nsecs_t duration, bool windowRefill);
+
+/* make the statement statistics of the process available as the android_query_stats table */
+int register_sqlite3_query_stats(sqlite3* db);
+
 }
 
 #endif // _ANDROID_DATABASE_SQLITE_COMMON_H
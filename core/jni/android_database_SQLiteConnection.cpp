@@ -30,6 +30,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <vector>
+
 #include <androidfw/CursorWindow.h>
 
 #include <sqlite3.h>
@@ -58,6 +60,13 @@ namespace android {
  */
 static const int BUSY_TIMEOUT_MS = 2500;
 
+/* Number of finalized statements kept prepared per connection.
+ * SQLiteConnection.java finalizes statements that are evicted from its own cache, or that
+ * could not be cached, and prepares them again the next time they are used. Keeping the
+ * most recently finalized ones around saves compiling them again when that happens.
+ */
+static const size_t FINALIZED_STATEMENT_CACHE_SIZE = 16;
+
 static struct {
     jfieldID name;
     jfieldID numArgs;
@@ -86,6 +95,11 @@ struct SQLiteConnection {
 
     volatile bool canceled;
 
+    // Statements that were finalized, but reset and kept prepared, least recently finalized
+    // first. Only statements with plain ASCII sql are kept, so that their sql can be compared
+    // to the UTF-16 sql of new statements without converting either.
+    std::vector<sqlite3_stmt*> finalizedStatements;
+
     SQLiteConnection(sqlite3* db, int openFlags, const String8& path, const String8& label) :
         db(db), openFlags(openFlags), path(path), label(label), canceled(false) { }
 };
@@ -160,6 +174,14 @@ static jlong nativeOpen(JNIEnv* env, jclass clazz, jstring pathStr, jint openFla
         return 0;
     }
 
+    // Expose the statistics of the statements run in this process.
+    err = register_sqlite3_query_stats(db);
+    if (err != SQLITE_OK) {
+        throw_sqlite3_exception(env, db, "Could not register the query stats table.");
+        sqlite3_close(db);
+        return 0;
+    }
+
     // Create wrapper object.
     SQLiteConnection* connection = new SQLiteConnection(db, openFlags, path, label);
 
@@ -180,6 +202,10 @@ static void nativeClose(JNIEnv* env, jclass clazz, jlong connectionPtr) {
 
     if (connection) {
         ALOGV("Closing connection %p", connection->db);
+        for (sqlite3_stmt* statement : connection->finalizedStatements) {
+            sqlite3_finalize(statement);
+        }
+        connection->finalizedStatements.clear();
         int err = sqlite3_close(connection->db);
         if (err != SQLITE_OK) {
             // This can happen if sub-objects aren't closed first.  Make sure the caller knows.
@@ -282,15 +308,69 @@ static void nativeRegisterLocalizedCollators(JNIEnv* env, jclass clazz, jlong co
     }
 }
 
+static bool isAsciiSql(const char* sql) {
+    for (; *sql; sql++) {
+        if (*sql & 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sqlEquals(const char* asciiSql, const jchar* sql, jsize sqlLength) {
+    for (jsize i = 0; i < sqlLength; i++) {
+        if (!asciiSql[i] || jchar(asciiSql[i]) != sql[i]) {
+            return false;
+        }
+    }
+    return !asciiSql[sqlLength];
+}
+
+// Returns a statement that was finalized and kept prepared for the given sql, if any.
+static sqlite3_stmt* takeFinalizedStatement(SQLiteConnection* connection,
+        const jchar* sql, jsize sqlLength) {
+    auto& statements = connection->finalizedStatements;
+    for (auto it = statements.rbegin(); it != statements.rend(); it++) {
+        if (sqlEquals(sqlite3_sql(*it), sql, sqlLength)) {
+            sqlite3_stmt* statement = *it;
+            statements.erase(std::next(it).base());
+            return statement;
+        }
+    }
+    return NULL;
+}
+
+// Resets the statement and keeps it prepared instead of finalizing it, if possible.
+static bool keepFinalizedStatement(SQLiteConnection* connection, sqlite3_stmt* statement) {
+    const char* sql = sqlite3_sql(statement);
+    if (!sql || !isAsciiSql(sql)) {
+        return false;
+    }
+
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
+
+    auto& statements = connection->finalizedStatements;
+    if (statements.size() >= FINALIZED_STATEMENT_CACHE_SIZE) {
+        sqlite3_finalize(statements.front());
+        statements.erase(statements.begin());
+    }
+    statements.push_back(statement);
+    return true;
+}
+
 static jlong nativePrepareStatement(JNIEnv* env, jclass clazz, jlong connectionPtr,
         jstring sqlString) {
     SQLiteConnection* connection = reinterpret_cast<SQLiteConnection*>(connectionPtr);
 
     jsize sqlLength = env->GetStringLength(sqlString);
     const jchar* sql = env->GetStringCritical(sqlString, NULL);
-    sqlite3_stmt* statement;
-    int err = sqlite3_prepare16_v2(connection->db,
-            sql, sqlLength * sizeof(jchar), &statement, NULL);
+    int err = SQLITE_OK;
+    sqlite3_stmt* statement = takeFinalizedStatement(connection, sql, sqlLength);
+    if (!statement) {
+        err = sqlite3_prepare16_v2(connection->db,
+                sql, sqlLength * sizeof(jchar), &statement, NULL);
+    }
     env->ReleaseStringCritical(sqlString, sql);
 
     if (err != SQLITE_OK) {
@@ -322,7 +402,9 @@ static void nativeFinalizeStatement(JNIEnv* env, jclass clazz, jlong connectionP
     // whether any errors occurred while executing the statement.  The statement itself
     // is always finalized regardless.
     ALOGV("Finalized statement %p on connection %p", statement, connection->db);
-    sqlite3_finalize(statement);
+    if (!keepFinalizedStatement(connection, statement)) {
+        sqlite3_finalize(statement);
+    }
 }
 
 static jint nativeGetParameterCount(JNIEnv* env, jclass clazz, jlong connectionPtr,
@@ -438,7 +520,10 @@ static void nativeResetStatementAndClearBindings(JNIEnv* env, jclass clazz, jlon
 }
 
 static int executeNonQuery(JNIEnv* env, SQLiteConnection* connection, sqlite3_stmt* statement) {
+    nsecs_t startTime = systemTime(SYSTEM_TIME_MONOTONIC);
     int err = sqlite3_step(statement);
+    record_sqlite3_statement_stats(connection->label.string(), statement,
+            systemTime(SYSTEM_TIME_MONOTONIC) - startTime, false /*windowRefill*/);
     if (err == SQLITE_ROW) {
         throw_sqlite3_exception(env,
                 "Queries can be performed using SQLiteDatabase query or rawQuery methods only.");
@@ -476,7 +561,10 @@ static jlong nativeExecuteForLastInsertedRowId(JNIEnv* env, jclass clazz,
 }
 
 static int executeOneRowQuery(JNIEnv* env, SQLiteConnection* connection, sqlite3_stmt* statement) {
+    nsecs_t startTime = systemTime(SYSTEM_TIME_MONOTONIC);
     int err = sqlite3_step(statement);
+    record_sqlite3_statement_stats(connection->label.string(), statement,
+            systemTime(SYSTEM_TIME_MONOTONIC) - startTime, false /*windowRefill*/);
     if (err != SQLITE_ROW) {
         throw_sqlite3_exception(env, connection->db);
     }
@@ -677,6 +765,7 @@ static jlong nativeExecuteForCursorWindow(JNIEnv* env, jclass clazz,
         return 0;
     }
 
+    nsecs_t startTime = systemTime(SYSTEM_TIME_MONOTONIC);
     int numColumns = sqlite3_column_count(statement);
     status = window->setNumColumns(numColumns);
     if (status) {
@@ -748,6 +837,8 @@ static jlong nativeExecuteForCursorWindow(JNIEnv* env, jclass clazz,
     LOG_WINDOW("Resetting statement %p after fetching %d rows and adding %d rows"
             "to the window in %d bytes",
             statement, totalRows, addedRows, window->size() - window->freeSpace());
+    record_sqlite3_statement_stats(connection->label.string(), statement,
+            systemTime(SYSTEM_TIME_MONOTONIC) - startTime, startPos > 0 /*windowRefill*/);
     sqlite3_reset(statement);
 
     // Report the total number of rows on request.
@@ -28,6 +28,14 @@
 
 #include <sqlite3.h>
 
+#include <algorithm>
+#include <ctype.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "android_database_SQLiteCommon.h"
 #include "core_jni_helpers.h"
 
 namespace android {
@@ -54,6 +62,271 @@ static void nativeGetPagerStats(JNIEnv *env, jobject clazz, jobject statsObj)
     env->SetIntField(statsObj, gSQLiteDebugPagerStatsClassInfo.largestMemAlloc, largestMemAlloc);
 }
 
+/*
+ * Statement statistics.
+ *
+ * Executions are aggregated per database and normalized sql, where literals are replaced by
+ * '?' and whitespace is collapsed, so that statements that only differ by their arguments
+ * share an entry. Queries can read them from the android_query_stats table.
+ */
+
+// Upper bounds of the execution time histogram buckets, the last bucket is unbounded
+static const nsecs_t STATS_HISTOGRAM_BOUNDS[] = {
+    ms2ns(1), ms2ns(4), ms2ns(16), ms2ns(64), ms2ns(256),
+};
+static const size_t STATS_HISTOGRAM_SIZE = NELEM(STATS_HISTOGRAM_BOUNDS) + 1;
+
+// Statements past this many distinct ones are all accounted to OTHER_STATEMENTS_SQL
+static const size_t MAX_STATEMENT_STATS = 512;
+static const char OTHER_STATEMENTS_SQL[] = "(other)";
+
+struct StatementStats {
+    std::string label;
+    std::string sql;
+    int64_t executions = 0;
+    nsecs_t totalTime = 0;
+    nsecs_t maxTime = 0;
+    int64_t rowsScanned = 0;
+    int64_t windowRefills = 0;
+    int64_t histogram[STATS_HISTOGRAM_SIZE] = {};
+};
+
+static std::mutex gStatementStatsLock;
+static std::unordered_map<std::string, StatementStats> gStatementStats;
+
+static bool isIdentifierChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+static std::string normalizeSql(const char* sql) {
+    std::string result;
+    bool pendingSpace = false;
+    const char* p = sql;
+    while (*p) {
+        char c = *p;
+        if (isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !result.empty();
+            p++;
+            continue;
+        }
+        if (pendingSpace) {
+            result += ' ';
+            pendingSpace = false;
+        }
+        if (c == '\'') {
+            // String literal, with '' as an escaped quote
+            for (p++; *p; p++) {
+                if (*p == '\'') {
+                    if (p[1] != '\'') {
+                        p++;
+                        break;
+                    }
+                    p++;
+                }
+            }
+            result += '?';
+        } else if (isdigit(static_cast<unsigned char>(c))
+                && (result.empty() || !isIdentifierChar(result.back()))) {
+            // Numeric literal, including hex and decimal ones
+            while (isIdentifierChar(*p) || *p == '.') {
+                p++;
+            }
+            result += '?';
+        } else {
+            result += c;
+            p++;
+        }
+    }
+    return result;
+}
+
+void record_sqlite3_statement_stats(const char* label, sqlite3_stmt* statement,
+        nsecs_t duration, bool windowRefill) {
+    const char* sql = sqlite3_sql(statement);
+    if (!sql) {
+        return;
+    }
+    std::string normalizedSql = normalizeSql(sql);
+    int rowsScanned = sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_FULLSCAN_STEP,
+            1 /*reset*/);
+
+    size_t bucket = 0;
+    while (bucket < NELEM(STATS_HISTOGRAM_BOUNDS) && duration >= STATS_HISTOGRAM_BOUNDS[bucket]) {
+        bucket++;
+    }
+
+    std::string key(label);
+    key += '\n';
+    key += normalizedSql;
+
+    std::lock_guard<std::mutex> lock(gStatementStatsLock);
+    auto it = gStatementStats.find(key);
+    if (it == gStatementStats.end()) {
+        if (gStatementStats.size() >= MAX_STATEMENT_STATS) {
+            normalizedSql = OTHER_STATEMENTS_SQL;
+            key = std::string(label) + '\n' + normalizedSql;
+        }
+        it = gStatementStats.emplace(key, StatementStats()).first;
+        if (it->second.sql.empty()) {
+            it->second.label = label;
+            it->second.sql = normalizedSql;
+        }
+    }
+    StatementStats& stats = it->second;
+    stats.executions++;
+    stats.totalTime += duration;
+    stats.maxTime = std::max(stats.maxTime, duration);
+    stats.rowsScanned += rowsScanned;
+    stats.windowRefills += windowRefill ? 1 : 0;
+    stats.histogram[bucket]++;
+}
+
+/*
+ * android_query_stats eponymous virtual table, which snapshots the statistics when a query
+ * on it starts.
+ */
+
+enum {
+    STATS_COLUMN_DATABASE,
+    STATS_COLUMN_SQL,
+    STATS_COLUMN_EXECUTIONS,
+    STATS_COLUMN_TOTAL_TIME_MS,
+    STATS_COLUMN_MAX_TIME_MS,
+    STATS_COLUMN_ROWS_SCANNED,
+    STATS_COLUMN_WINDOW_REFILLS,
+    STATS_COLUMN_HISTOGRAM,
+};
+
+static const char STATS_TABLE_SCHEMA[] = "CREATE TABLE x(database TEXT, sql TEXT, "
+        "executions INTEGER, total_time_ms REAL, max_time_ms REAL, rows_scanned INTEGER, "
+        "window_refills INTEGER, histogram_1ms INTEGER, histogram_4ms INTEGER, "
+        "histogram_16ms INTEGER, histogram_64ms INTEGER, histogram_256ms INTEGER, "
+        "histogram_slow INTEGER)";
+
+struct StatsCursor {
+    sqlite3_vtab_cursor base;
+    std::vector<StatementStats> rows;
+    size_t position;
+};
+
+static int statsConnect(sqlite3* db, void* aux, int argc, const char* const* argv,
+        sqlite3_vtab** outTable, char** outError) {
+    int err = sqlite3_declare_vtab(db, STATS_TABLE_SCHEMA);
+    if (err != SQLITE_OK) {
+        return err;
+    }
+    sqlite3_vtab* table = static_cast<sqlite3_vtab*>(sqlite3_malloc(sizeof(sqlite3_vtab)));
+    if (!table) {
+        return SQLITE_NOMEM;
+    }
+    memset(table, 0, sizeof(sqlite3_vtab));
+    *outTable = table;
+    return SQLITE_OK;
+}
+
+static int statsDisconnect(sqlite3_vtab* table) {
+    sqlite3_free(table);
+    return SQLITE_OK;
+}
+
+static int statsBestIndex(sqlite3_vtab* table, sqlite3_index_info* indexInfo) {
+    indexInfo->estimatedCost = MAX_STATEMENT_STATS;
+    return SQLITE_OK;
+}
+
+static int statsOpen(sqlite3_vtab* table, sqlite3_vtab_cursor** outCursor) {
+    StatsCursor* cursor = new StatsCursor();
+    cursor->position = 0;
+    *outCursor = &cursor->base;
+    return SQLITE_OK;
+}
+
+static int statsClose(sqlite3_vtab_cursor* base) {
+    delete reinterpret_cast<StatsCursor*>(base);
+    return SQLITE_OK;
+}
+
+static int statsFilter(sqlite3_vtab_cursor* base, int indexNum, const char* indexStr,
+        int argc, sqlite3_value** argv) {
+    StatsCursor* cursor = reinterpret_cast<StatsCursor*>(base);
+    cursor->rows.clear();
+    cursor->position = 0;
+
+    std::lock_guard<std::mutex> lock(gStatementStatsLock);
+    cursor->rows.reserve(gStatementStats.size());
+    for (const auto& entry : gStatementStats) {
+        cursor->rows.push_back(entry.second);
+    }
+    return SQLITE_OK;
+}
+
+static int statsNext(sqlite3_vtab_cursor* base) {
+    reinterpret_cast<StatsCursor*>(base)->position++;
+    return SQLITE_OK;
+}
+
+static int statsEof(sqlite3_vtab_cursor* base) {
+    StatsCursor* cursor = reinterpret_cast<StatsCursor*>(base);
+    return cursor->position >= cursor->rows.size();
+}
+
+static int statsColumn(sqlite3_vtab_cursor* base, sqlite3_context* context, int column) {
+    StatsCursor* cursor = reinterpret_cast<StatsCursor*>(base);
+    const StatementStats& stats = cursor->rows[cursor->position];
+    switch (column) {
+    case STATS_COLUMN_DATABASE:
+        sqlite3_result_text(context, stats.label.c_str(), stats.label.size(), SQLITE_TRANSIENT);
+        break;
+    case STATS_COLUMN_SQL:
+        sqlite3_result_text(context, stats.sql.c_str(), stats.sql.size(), SQLITE_TRANSIENT);
+        break;
+    case STATS_COLUMN_EXECUTIONS:
+        sqlite3_result_int64(context, stats.executions);
+        break;
+    case STATS_COLUMN_TOTAL_TIME_MS:
+        sqlite3_result_double(context, stats.totalTime / 1000000.0);
+        break;
+    case STATS_COLUMN_MAX_TIME_MS:
+        sqlite3_result_double(context, stats.maxTime / 1000000.0);
+        break;
+    case STATS_COLUMN_ROWS_SCANNED:
+        sqlite3_result_int64(context, stats.rowsScanned);
+        break;
+    case STATS_COLUMN_WINDOW_REFILLS:
+        sqlite3_result_int64(context, stats.windowRefills);
+        break;
+    default:
+        sqlite3_result_int64(context, stats.histogram[column - STATS_COLUMN_HISTOGRAM]);
+        break;
+    }
+    return SQLITE_OK;
+}
+
+static int statsRowid(sqlite3_vtab_cursor* base, sqlite3_int64* outRowid) {
+    *outRowid = reinterpret_cast<StatsCursor*>(base)->position;
+    return SQLITE_OK;
+}
+
+static sqlite3_module gStatsModule = {
+    0,                  // iVersion
+    NULL,               // xCreate, NULL for an eponymous only table
+    statsConnect,       // xConnect
+    statsBestIndex,     // xBestIndex
+    statsDisconnect,    // xDisconnect
+    NULL,               // xDestroy
+    statsOpen,          // xOpen
+    statsClose,         // xClose
+    statsFilter,        // xFilter
+    statsNext,          // xNext
+    statsEof,           // xEof
+    statsColumn,        // xColumn
+    statsRowid,         // xRowid
+};
+
+int register_sqlite3_query_stats(sqlite3* db) {
+    return sqlite3_create_module(db, "android_query_stats", &gStatsModule, NULL);
+}
+
 /*
  * JNI registration.
  */
@@ -229,7 +229,7 @@ static void drawPoint(JNIEnv*, jobject, jlong canvasHandle, jfloat x, jfloat y,
 static void drawPoints(JNIEnv* env, jobject, jlong canvasHandle, jfloatArray jptsArray,
                        jint offset, jint count, jlong paintHandle) {
     NPE_CHECK_RETURN_VOID(env, jptsArray);
-    AutoJavaFloatArray autoPts(env, jptsArray);
+    AutoJavaFloatArray autoPts(env, jptsArray, 0, kRO_JNIAccess);
     float* floats = autoPts.ptr();
     const int length = autoPts.length();
 
@@ -251,7 +251,7 @@ static void drawLine(JNIEnv* env, jobject, jlong canvasHandle, jfloat startX, jf
 static void drawLines(JNIEnv* env, jobject, jlong canvasHandle, jfloatArray jptsArray,
                       jint offset, jint count, jlong paintHandle) {
     NPE_CHECK_RETURN_VOID(env, jptsArray);
-    AutoJavaFloatArray autoPts(env, jptsArray);
+    AutoJavaFloatArray autoPts(env, jptsArray, 0, kRO_JNIAccess);
     float* floats = autoPts.ptr();
     const int length = autoPts.length();
 
@@ -317,10 +317,10 @@ static void drawVertices(JNIEnv* env, jobject, jlong canvasHandle,
                          jintArray jcolors, jint colorIndex,
                          jshortArray jindices, jint indexIndex,
                          jint indexCount, jlong paintHandle) {
-    AutoJavaFloatArray  vertA(env, jverts, vertIndex + vertexCount);
-    AutoJavaFloatArray  texA(env, jtexs, texIndex + vertexCount);
-    AutoJavaIntArray    colorA(env, jcolors, colorIndex + vertexCount);
-    AutoJavaShortArray  indexA(env, jindices, indexIndex + indexCount);
+    AutoJavaFloatArray  vertA(env, jverts, vertIndex + vertexCount, kRO_JNIAccess);
+    AutoJavaFloatArray  texA(env, jtexs, texIndex + vertexCount, kRO_JNIAccess);
+    AutoJavaIntArray    colorA(env, jcolors, colorIndex + vertexCount, kRO_JNIAccess);
+    AutoJavaShortArray  indexA(env, jindices, indexIndex + indexCount, kRO_JNIAccess);
 
     const float* verts = vertA.ptr() + vertIndex;
     const float* texs = texA.ptr() + vertIndex;
@@ -463,8 +463,8 @@ static void drawBitmapMesh(JNIEnv* env, jobject, jlong canvasHandle, jobject jbi
                            jint meshWidth, jint meshHeight, jfloatArray jverts,
                            jint vertIndex, jintArray jcolors, jint colorIndex, jlong paintHandle) {
     const int ptCount = (meshWidth + 1) * (meshHeight + 1);
-    AutoJavaFloatArray vertA(env, jverts, vertIndex + (ptCount << 1));
-    AutoJavaIntArray colorA(env, jcolors, colorIndex + ptCount);
+    AutoJavaFloatArray vertA(env, jverts, vertIndex + (ptCount << 1), kRO_JNIAccess);
+    AutoJavaIntArray colorA(env, jcolors, colorIndex + ptCount, kRO_JNIAccess);
 
     const Paint* paint = reinterpret_cast<Paint*>(paintHandle);
     Bitmap& bitmap = android::bitmap::toBitmap(env, jbitmap);
@@ -337,8 +337,16 @@ private:
         ssize_t n;
         ASensorEvent buffer[16];
         while ((n = q->read(buffer, 16)) > 0) {
+            if (receiverObj.get() == NULL) {
+                // The Java queue is gone, so there is no one to dispatch to. Drain the events
+                // without marshalling each of them into the scratch arrays.
+                mSensorQueue->sendAck(buffer, n);
+                continue;
+            }
             for (int i=0 ; i<n ; i++) {
-                if (buffer[i].type == SENSOR_TYPE_STEP_COUNTER) {
+                if (buffer[i].type == SENSOR_TYPE_META_DATA) {
+                    // Flush complete events carry no values.
+                } else if (buffer[i].type == SENSOR_TYPE_STEP_COUNTER) {
                     // step-counter returns a uint64, but the java API only deals with floats
                     float value = float(buffer[i].u64.step_counter);
                     env->SetFloatArrayRegion(mFloatScratch, 0, 1, &value);
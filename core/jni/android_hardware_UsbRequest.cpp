@@ -25,14 +25,41 @@
 #include <usbhost/usbhost.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 
 using namespace android;
 
 static jfieldID field_context;
 
+// Native state of a UsbRequest. The buffer used to queue byte arrays is kept
+// between transfers, so that streaming data through the same request doesn't
+// allocate and free a buffer for every packet.
+struct usb_request_context {
+    struct usb_request* request;
+    void* array_buffer;
+    size_t array_buffer_capacity;
+};
+
+static struct usb_request_context* get_context_from_object(JNIEnv* env, jobject java_request)
+{
+    return (struct usb_request_context*)env->GetLongField(java_request, field_context);
+}
+
 struct usb_request* get_request_from_object(JNIEnv* env, jobject java_request)
 {
-    return (struct usb_request*)env->GetLongField(java_request, field_context);
+    struct usb_request_context* context = get_context_from_object(env, java_request);
+    return context ? context->request : NULL;
+}
+
+// Returns a buffer of at least length bytes to queue a byte array with
+static void* get_array_buffer(struct usb_request_context* context, size_t length)
+{
+    if (context->array_buffer_capacity < length) {
+        free(context->array_buffer);
+        context->array_buffer = malloc(length);
+        context->array_buffer_capacity = context->array_buffer ? length : 0;
+    }
+    return context->array_buffer;
 }
 
 // in android_hardware_UsbDeviceConnection.cpp
@@ -60,18 +87,29 @@ android_hardware_UsbRequest_init(JNIEnv *env, jobject thiz, jobject java_device,
     desc.bInterval = ep_interval;
 
     struct usb_request* request = usb_request_new(device, &desc);
-    if (request)
-        env->SetLongField(thiz, field_context, (jlong)request);
-    return (request != NULL);
+    if (!request)
+        return JNI_FALSE;
+
+    struct usb_request_context* context =
+            (struct usb_request_context*)calloc(1, sizeof(struct usb_request_context));
+    if (!context) {
+        usb_request_free(request);
+        return JNI_FALSE;
+    }
+    context->request = request;
+    env->SetLongField(thiz, field_context, (jlong)context);
+    return JNI_TRUE;
 }
 
 static void
 android_hardware_UsbRequest_close(JNIEnv *env, jobject thiz)
 {
     ALOGD("close\n");
-    struct usb_request* request = get_request_from_object(env, thiz);
-    if (request) {
-        usb_request_free(request);
+    struct usb_request_context* context = get_context_from_object(env, thiz);
+    if (context) {
+        usb_request_free(context->request);
+        free(context->array_buffer);
+        free(context);
         env->SetLongField(thiz, field_context, 0);
     }
 }
@@ -80,20 +118,23 @@ static jboolean
 android_hardware_UsbRequest_queue_array(JNIEnv *env, jobject thiz,
         jbyteArray buffer, jint length, jboolean out)
 {
-    struct usb_request* request = get_request_from_object(env, thiz);
-    if (!request) {
+    struct usb_request_context* context = get_context_from_object(env, thiz);
+    if (!context) {
         ALOGE("request is closed in native_queue");
         return JNI_FALSE;
     }
+    struct usb_request* request = context->request;
 
     if (buffer && length) {
-        request->buffer = malloc(length);
+        request->buffer = get_array_buffer(context, length);
         if (!request->buffer)
             return JNI_FALSE;
-        memset(request->buffer, 0, length);
         if (out) {
             // copy data from Java buffer to native buffer
             env->GetByteArrayRegion(buffer, 0, length, (jbyte *)request->buffer);
+        } else {
+            // don't hand data of a previous transfer back to Java
+            memset(request->buffer, 0, length);
         }
     } else {
         request->buffer = NULL;
@@ -104,11 +145,8 @@ android_hardware_UsbRequest_queue_array(JNIEnv *env, jobject thiz,
     request->client_data = (void *)env->NewGlobalRef(thiz);
 
     if (usb_request_queue(request)) {
-        if (request->buffer) {
-            // free our buffer if usb_request_queue fails
-            free(request->buffer);
-            request->buffer = NULL;
-        }
+        // the buffer is kept for the next transfer
+        request->buffer = NULL;
         env->DeleteGlobalRef((jobject)request->client_data);
         return JNI_FALSE;
     }
@@ -129,7 +167,8 @@ android_hardware_UsbRequest_dequeue_array(JNIEnv *env, jobject thiz,
         // copy data from native buffer to Java buffer
         env->SetByteArrayRegion(buffer, 0, length, (jbyte *)request->buffer);
     }
-    free(request->buffer);
+    // the buffer belongs to the request context, it is reused by the next transfer
+    request->buffer = NULL;
     env->DeleteGlobalRef((jobject)request->client_data);
     return (jint) request->actual_length;
 }
@@ -316,8 +316,8 @@ static jbyteArray CameraMetadata_readValues(JNIEnv *env, jobject thiz, jint tag)
     if (env->ExceptionCheck()) return NULL;
 
     // Copy into java array from native array
-    ScopedByteArrayRW arrayWriter(env, byteArray);
-    memcpy(arrayWriter.get(), entry.data.u8, byteCount);
+    env->SetByteArrayRegion(byteArray, 0, byteCount,
+            reinterpret_cast<const jbyte*>(entry.data.u8));
 
     return byteArray;
 }
@@ -305,6 +305,9 @@ bool NativeContext::hasCaptureTime() const {
 /**
  * Wrapper class for a Java OutputStream.
  *
+ * Writes are buffered so that the many small writes of the TIFF header don't each call into
+ * Java, close() must be called to write out the remaining data.
+ *
  * This class is not intended to be used across JNI calls.
  */
 class JniOutputStream : public Output, public LightRefBase<JniOutputStream> {
@@ -320,15 +323,19 @@ public:
     status_t close();
 private:
     enum {
-        BYTE_ARRAY_LENGTH = 4096
+        BYTE_ARRAY_LENGTH = 64 * 1024
     };
+
+    status_t flush();
+
     jobject mOutputStream;
     JNIEnv* mEnv;
     jbyteArray mByteArray;
+    size_t mBufferedBytes;
 };
 
 JniOutputStream::JniOutputStream(JNIEnv* env, jobject outStream) : mOutputStream(outStream),
-        mEnv(env) {
+        mEnv(env), mBufferedBytes(0) {
     mByteArray = env->NewByteArray(BYTE_ARRAY_LENGTH);
     if (mByteArray == nullptr) {
         jniThrowException(env, "java/lang/OutOfMemoryError", "Could not allocate byte array.");
@@ -346,30 +353,44 @@ status_t JniOutputStream::open() {
 
 status_t JniOutputStream::write(const uint8_t* buf, size_t offset, size_t count) {
     while(count > 0) {
-        size_t len = BYTE_ARRAY_LENGTH;
+        size_t len = BYTE_ARRAY_LENGTH - mBufferedBytes;
         len = (count > len) ? len : count;
-        mEnv->SetByteArrayRegion(mByteArray, 0, len, reinterpret_cast<const jbyte*>(buf + offset));
+        mEnv->SetByteArrayRegion(mByteArray, mBufferedBytes, len,
+                reinterpret_cast<const jbyte*>(buf + offset));
 
         if (mEnv->ExceptionCheck()) {
             return BAD_VALUE;
         }
 
-        mEnv->CallVoidMethod(mOutputStream, gOutputStreamClassInfo.mWriteMethod, mByteArray,
-                0, len);
+        mBufferedBytes += len;
+        count -= len;
+        offset += len;
 
-        if (mEnv->ExceptionCheck()) {
+        if (mBufferedBytes == BYTE_ARRAY_LENGTH && flush() != OK) {
             return BAD_VALUE;
         }
+    }
+    return OK;
+}
 
-        count -= len;
-        offset += len;
+status_t JniOutputStream::flush() {
+    if (mBufferedBytes == 0) {
+        return OK;
+    }
+
+    mEnv->CallVoidMethod(mOutputStream, gOutputStreamClassInfo.mWriteMethod, mByteArray,
+            0, mBufferedBytes);
+    mBufferedBytes = 0;
+
+    if (mEnv->ExceptionCheck()) {
+        return BAD_VALUE;
     }
     return OK;
 }
 
 status_t JniOutputStream::close() {
-    // Do nothing
-    return OK;
+    // Only writes out what is buffered, the Java stream is closed by the caller
+    return flush();
 }
 
 // End of JniOutputStream
@@ -2215,7 +2236,8 @@ static void DngCreator_nativeWriteImage(JNIEnv* env, jobject thiz, jobject outSt
         sources.add(&stripSource);
 
         status_t ret = OK;
-        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK) {
+        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK ||
+                (ret = out->close()) != OK) {
             ALOGE("%s: write failed with error %d.", __FUNCTION__, ret);
             if (!env->ExceptionCheck()) {
                 jniThrowExceptionFmt(env, "java/io/IOException",
@@ -2232,7 +2254,8 @@ static void DngCreator_nativeWriteImage(JNIEnv* env, jobject thiz, jobject outSt
         sources.add(&stripSource);
 
         status_t ret = OK;
-        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK) {
+        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK ||
+                (ret = out->close()) != OK) {
             ALOGE("%s: write failed with error %d.", __FUNCTION__, ret);
             if (!env->ExceptionCheck()) {
                 jniThrowExceptionFmt(env, "java/io/IOException",
@@ -2306,7 +2329,8 @@ static void DngCreator_nativeWriteInputStream(JNIEnv* env, jobject thiz, jobject
     sources.add(&stripSource);
 
     status_t ret = OK;
-    if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK) {
+    if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK ||
+            (ret = out->close()) != OK) {
         ALOGE("%s: write failed with error %d.", __FUNCTION__, ret);
         if (!env->ExceptionCheck()) {
             jniThrowExceptionFmt(env, "java/io/IOException",
@@ -42,6 +42,12 @@ namespace android {
 template <typename T>
 void UNUSED(T t) {}
 
+// Reads and writes up to this size go through a stack buffer and only copy the
+// requested range of the Java array. Get/ReleaseByteArrayElements copy the whole
+// array when it is movable, which is the case for the small arrays typically used
+// for messages, while larger arrays are usually accessed in place.
+static const jint kStackBufferSize = 4096;
+
 static jfieldID field_inboundFileDescriptors;
 static jfieldID field_outboundFileDescriptors;
 static jclass class_Credentials;
@@ -254,7 +260,7 @@ static int socket_write_all(JNIEnv *env, jobject object, int fd,
     struct cmsghdr *cmsg;
     int countFds = outboundFds == NULL ? 0 : env->GetArrayLength(outboundFds);
     int fds[countFds];
-    char msgbuf[CMSG_SPACE(countFds)];
+    char msgbuf[CMSG_SPACE(sizeof(int) * countFds)];
 
     // Add any pending outbound file descriptors to the message
     if (outboundFds != NULL) {
@@ -376,6 +382,18 @@ static jint socket_readba (JNIEnv *env, jobject object,
         return (jint)-1;
     }
 
+    if (len <= kStackBufferSize) {
+        jbyte stackBuffer[kStackBufferSize];
+        ret = socket_read_all(env, object, fd, stackBuffer, len);
+
+        // A return of -1 above means an exception is pending
+        if (ret > 0) {
+            env->SetByteArrayRegion(buffer, off, ret, stackBuffer);
+        }
+
+        return (jint) ((ret == 0) ? -1 : ret);
+    }
+
     byteBuffer = env->GetByteArrayElements(buffer, NULL);
 
     if (NULL == byteBuffer) {
@@ -438,6 +456,16 @@ static void socket_writeba (JNIEnv *env, jobject object,
         return;
     }
 
+    if (len <= kStackBufferSize) {
+        jbyte stackBuffer[kStackBufferSize];
+        env->GetByteArrayRegion(buffer, off, len, stackBuffer);
+
+        err = socket_write_all(env, object, fd, stackBuffer, len);
+        UNUSED(err);
+        // A return of -1 above means an exception is pending
+        return;
+    }
+
     byteBuffer = env->GetByteArrayElements(buffer,NULL);
 
     if (NULL == byteBuffer) {
@@ -110,8 +110,11 @@ getPointer(JNIEnv *_env, jobject buffer, jarray *array, jint *remaining, jint *o
     limit = _env->GetIntField(buffer, limitID);
     elementSizeShift = _env->GetIntField(buffer, elementSizeShiftID);
     *remaining = (limit - position) << elementSizeShift;
-    pointer = _env->CallStaticLongMethod(nioAccessClass,
-            getBasePointerID, buffer);
+    // Same as NIOAccess.getBasePointer(), without calling up into Java
+    pointer = reinterpret_cast<jlong>(_env->GetDirectBufferAddress(buffer));
+    if (pointer != 0L) {
+        pointer += position << elementSizeShift;
+    }
     if (pointer != 0L) {
         *array = NULL;
         return reinterpret_cast<void*>(pointer);
@@ -29,6 +29,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iomanip>
 #include <string>
 
@@ -527,8 +528,15 @@ static jlong android_os_Debug_getPssPid(JNIEnv *env, jobject clazz, jint pid,
     }
 
     {
-        std::string smaps_path = base::StringPrintf("/proc/%d/smaps", pid);
+        // smaps_rollup has the same fields as smaps, already summed over all mappings, so
+        // the loop below reads a single block instead of one for every mapping. Kernels
+        // that predate it only have smaps.
+        std::string smaps_path = base::StringPrintf("/proc/%d/smaps_rollup", pid);
         UniqueFile fp = MakeUniqueFile(smaps_path.c_str(), "re");
+        if (fp == nullptr) {
+            smaps_path = base::StringPrintf("/proc/%d/smaps", pid);
+            fp = MakeUniqueFile(smaps_path.c_str(), "re");
+        }
 
         if (fp != nullptr) {
             while (true) {
@@ -566,25 +574,14 @@ static jlong android_os_Debug_getPssPid(JNIEnv *env, jobject clazz, jint pid,
     }
 
     if (outUssSwapPss != NULL) {
-        if (env->GetArrayLength(outUssSwapPss) >= 1) {
-            jlong* outUssSwapPssArray = env->GetLongArrayElements(outUssSwapPss, 0);
-            if (outUssSwapPssArray != NULL) {
-                outUssSwapPssArray[0] = uss;
-                if (env->GetArrayLength(outUssSwapPss) >= 2) {
-                    outUssSwapPssArray[1] = swapPss;
-                }
-            }
-            env->ReleaseLongArrayElements(outUssSwapPss, outUssSwapPssArray, 0);
-        }
+        const jlong ussSwapPss[] = { uss, swapPss };
+        jsize length = std::min<jsize>(env->GetArrayLength(outUssSwapPss), 2);
+        env->SetLongArrayRegion(outUssSwapPss, 0, length, ussSwapPss);
     }
 
     if (outMemtrack != NULL) {
         if (env->GetArrayLength(outMemtrack) >= 1) {
-            jlong* outMemtrackArray = env->GetLongArrayElements(outMemtrack, 0);
-            if (outMemtrackArray != NULL) {
-                outMemtrackArray[0] = memtrack;
-            }
-            env->ReleaseLongArrayElements(outMemtrack, outMemtrackArray, 0);
+            env->SetLongArrayRegion(outMemtrack, 0, 1, &memtrack);
         }
     }
 
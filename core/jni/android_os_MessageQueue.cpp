@@ -23,6 +23,8 @@
 #include <utils/Log.h>
 #include "android_os_MessageQueue.h"
 
+#include <atomic>
+
 #include "core_jni_helpers.h"
 
 namespace android {
@@ -55,6 +57,10 @@ private:
     JNIEnv* mPollEnv;
     jobject mPollObj;
     jthrowable mExceptionObj;
+
+    // Set by wake() until the looper returns from the next poll. Wakes while the looper
+    // already has one pending skip writing to its event fd again.
+    std::atomic<bool> mWakePending;
 };
 
 
@@ -76,7 +82,7 @@ bool MessageQueue::raiseAndClearException(JNIEnv* env, const char* msg) {
 }
 
 NativeMessageQueue::NativeMessageQueue() :
-        mPollEnv(NULL), mPollObj(NULL), mExceptionObj(NULL) {
+        mPollEnv(NULL), mPollObj(NULL), mExceptionObj(NULL), mWakePending(false) {
     mLooper = Looper::getForThread();
     if (mLooper == NULL) {
         mLooper = new Looper(false);
@@ -108,6 +114,10 @@ void NativeMessageQueue::pollOnce(JNIEnv* env, jobject pollObj, int timeoutMilli
     mPollEnv = env;
     mPollObj = pollObj;
     mLooper->pollOnce(timeoutMillis);
+    // Only cleared once the poll returned, so that a skipped wake is always followed by the
+    // caller looking at its queue again. Clearing it before polling could skip the wake of a
+    // message enqueued after the queue was last looked at.
+    mWakePending = false;
     mPollObj = NULL;
     mPollEnv = NULL;
 
@@ -119,7 +129,9 @@ void NativeMessageQueue::pollOnce(JNIEnv* env, jobject pollObj, int timeoutMilli
 }
 
 void NativeMessageQueue::wake() {
-    mLooper->wake();
+    if (!mWakePending.exchange(true)) {
+        mLooper->wake();
+    }
 }
 
 void NativeMessageQueue::setFileDescriptorEvents(int fd, int events) {
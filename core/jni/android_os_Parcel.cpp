@@ -333,11 +333,10 @@ static jbyteArray android_os_Parcel_createByteArray(JNIEnv* env, jclass clazz, j
             ret = env->NewByteArray(len);
 
             if (ret != NULL) {
-                jbyte* a2 = (jbyte*)env->GetPrimitiveArrayCritical(ret, 0);
-                if (a2) {
-                    const void* data = parcel->readInplace(len);
-                    memcpy(a2, data, len);
-                    env->ReleasePrimitiveArrayCritical(ret, a2, 0);
+                // A single copy, without entering a critical region that may block the GC
+                const void* data = parcel->readInplace(len);
+                if (data) {
+                    env->SetByteArrayRegion(ret, 0, len, static_cast<const jbyte*>(data));
                 }
             }
         }
@@ -363,11 +362,7 @@ static jbyteArray android_os_Parcel_readBlob(JNIEnv* env, jclass clazz, jlong na
 
             ret = env->NewByteArray(len);
             if (ret != NULL) {
-                jbyte* a2 = (jbyte*)env->GetPrimitiveArrayCritical(ret, 0);
-                if (a2) {
-                    memcpy(a2, blob.data(), len);
-                    env->ReleasePrimitiveArrayCritical(ret, a2, 0);
-                }
+                env->SetByteArrayRegion(ret, 0, len, static_cast<const jbyte*>(blob.data()));
             }
             blob.release();
         }
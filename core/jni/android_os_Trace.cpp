@@ -19,34 +19,85 @@
 
 #include <inttypes.h>
 
+#include <memory>
+
 #include <cutils/trace.h>
-#include <utils/String8.h>
+#include <utils/Unicode.h>
 #include <log/log.h>
+#include <android-base/macros.h>
 
 #include <JNIHelp.h>
 #include <ScopedUtfChars.h>
-#include <ScopedStringChars.h>
 
 namespace android {
 
-static void sanitizeString(String8& utf8Chars) {
-    size_t size = utf8Chars.size();
-    char* str = utf8Chars.lockBuffer(size);
+// Names up to this length are converted without allocating
+static const size_t kStackNameLength = 128;
+
+static void sanitizeString(char* str, size_t size) {
     for (size_t i = 0; i < size; i++) {
         char c = str[i];
         if (c == '\0' || c == '\n' || c == '|') {
             str[i] = ' ';
         }
     }
-    utf8Chars.unlockBuffer();
 }
 
+/*
+ * Sanitized UTF-8 copy of a section name. The characters are read straight out of the Java
+ * string, and typical names are converted on the stack without allocating.
+ */
+class ScopedTraceName {
+public:
+    ScopedTraceName(JNIEnv* env, jstring nameStr) {
+        mStackUtf8[0] = '\0';
+        if (nameStr == NULL) {
+            jniThrowNullPointerException(env, NULL);
+            mUtf8 = NULL;
+            return;
+        }
+        size_t length = env->GetStringLength(nameStr);
+        char16_t stackChars[kStackNameLength];
+        std::unique_ptr<char16_t[]> heapChars;
+        char16_t* chars = stackChars;
+        if (length > kStackNameLength) {
+            heapChars.reset(new char16_t[length]);
+            chars = heapChars.get();
+        }
+        env->GetStringRegion(nameStr, 0, length, reinterpret_cast<jchar*>(chars));
+
+        ssize_t utf8Length = length > 0 ? utf16_to_utf8_length(chars, length) : 0;
+        if (utf8Length <= 0) {
+            return;
+        }
+        if (size_t(utf8Length) >= sizeof(mStackUtf8)) {
+            mHeapUtf8.reset(new char[utf8Length + 1]);
+            mUtf8 = mHeapUtf8.get();
+        }
+        utf16_to_utf8(chars, length, mUtf8, utf8Length + 1);
+        sanitizeString(mUtf8, utf8Length);
+    }
+
+    // NULL if the name was null, in which case an exception is pending
+    const char* c_str() const { return mUtf8; }
+
+private:
+    char mStackUtf8[kStackNameLength * 3 + 1];
+    std::unique_ptr<char[]> mHeapUtf8;
+    char* mUtf8 = mStackUtf8;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedTraceName);
+};
+
 static jlong android_os_Trace_nativeGetEnabledTags(JNIEnv* env, jclass clazz) {
     return atrace_get_enabled_tags();
 }
 
 static void android_os_Trace_nativeTraceCounter(JNIEnv* env, jclass clazz,
         jlong tag, jstring nameStr, jint value) {
+    if (!atrace_is_tag_enabled(tag)) {
+        return;
+    }
     ScopedUtfChars name(env, nameStr);
 
     ALOGV("%s: %" PRId64 " %s %d", __FUNCTION__, tag, name.c_str(), value);
@@ -55,12 +106,17 @@ static void android_os_Trace_nativeTraceCounter(JNIEnv* env, jclass clazz,
 
 static void android_os_Trace_nativeTraceBegin(JNIEnv* env, jclass clazz,
         jlong tag, jstring nameStr) {
-    ScopedStringChars jchars(env, nameStr);
-    String8 utf8Chars(reinterpret_cast<const char16_t*>(jchars.get()), jchars.size());
-    sanitizeString(utf8Chars);
+    // Tracing may have stopped since the caller checked the tag
+    if (!atrace_is_tag_enabled(tag)) {
+        return;
+    }
+    ScopedTraceName name(env, nameStr);
+    if (name.c_str() == NULL) {
+        return;
+    }
 
-    ALOGV("%s: %" PRId64 " %s", __FUNCTION__, tag, utf8Chars.string());
-    atrace_begin(tag, utf8Chars.string());
+    ALOGV("%s: %" PRId64 " %s", __FUNCTION__, tag, name.c_str());
+    atrace_begin(tag, name.c_str());
 }
 
 static void android_os_Trace_nativeTraceEnd(JNIEnv* env, jclass clazz,
@@ -72,22 +128,30 @@ static void android_os_Trace_nativeTraceEnd(JNIEnv* env, jclass clazz,
 
 static void android_os_Trace_nativeAsyncTraceBegin(JNIEnv* env, jclass clazz,
         jlong tag, jstring nameStr, jint cookie) {
-    ScopedStringChars jchars(env, nameStr);
-    String8 utf8Chars(reinterpret_cast<const char16_t*>(jchars.get()), jchars.size());
-    sanitizeString(utf8Chars);
+    if (!atrace_is_tag_enabled(tag)) {
+        return;
+    }
+    ScopedTraceName name(env, nameStr);
+    if (name.c_str() == NULL) {
+        return;
+    }
 
-    ALOGV("%s: %" PRId64 " %s %d", __FUNCTION__, tag, utf8Chars.string(), cookie);
-    atrace_async_begin(tag, utf8Chars.string(), cookie);
+    ALOGV("%s: %" PRId64 " %s %d", __FUNCTION__, tag, name.c_str(), cookie);
+    atrace_async_begin(tag, name.c_str(), cookie);
 }
 
 static void android_os_Trace_nativeAsyncTraceEnd(JNIEnv* env, jclass clazz,
         jlong tag, jstring nameStr, jint cookie) {
-    ScopedStringChars jchars(env, nameStr);
-    String8 utf8Chars(reinterpret_cast<const char16_t*>(jchars.get()), jchars.size());
-    sanitizeString(utf8Chars);
+    if (!atrace_is_tag_enabled(tag)) {
+        return;
+    }
+    ScopedTraceName name(env, nameStr);
+    if (name.c_str() == NULL) {
+        return;
+    }
 
-    ALOGV("%s: %" PRId64 " %s %d", __FUNCTION__, tag, utf8Chars.string(), cookie);
-    atrace_async_end(tag, utf8Chars.string(), cookie);
+    ALOGV("%s: %" PRId64 " %s %d", __FUNCTION__, tag, name.c_str(), cookie);
+    atrace_async_end(tag, name.c_str(), cookie);
 }
 
 static void android_os_Trace_nativeSetAppTracingAllowed(JNIEnv* env,
@@ -29,6 +29,10 @@
 #include <vector>
 #include <list>
 #include <algorithm>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
 
 #include "SkPaint.h"
 #include "SkTypeface.h"
@@ -50,22 +54,138 @@ struct JLineBreaksID {
 static jclass gLineBreaks_class;
 static JLineBreaksID gLineBreaks_fieldID;
 
+// Longer paragraphs are unlikely to be laid out again with the exact same parameters
+static const size_t kMaxCachedParagraphLength = 1024;
+static const size_t kMaxCachedParagraphs = 64;
+
+/**
+ * A LineBreaker, along with everything that was passed to it for the current paragraph. The
+ * same text is often laid out again at the same width, RecyclerView rebinds for instance, in
+ * which case the line breaks computed the previous time are reused.
+ *
+ * The style runs are still measured, since their widths are handed back to Java, but that
+ * mostly hits the minikin layout cache. Computing the breaks is what the cache saves.
+ */
+struct StaticLayoutBuilder {
+    // Tells apart the calls that make up the key
+    enum class KeyTag : uint8_t {
+        Paragraph,
+        StyleRun,
+        MeasuredRun,
+        ReplacementRun,
+    };
+
+    minikin::LineBreaker breaker;
+    // Every parameter of the paragraph, in the order they were passed
+    std::string key;
+    bool cacheable = true;
+    // The locale and indents outlive the paragraph, Java only sets them when they change
+    std::string localeKey;
+    bool hasIndents = false;
+
+    bool canCache() const {
+        return cacheable && !hasIndents;
+    }
+
+    std::string fullKey() const {
+        return localeKey + key;
+    }
+
+    template <typename T>
+    void appendKey(const T& value) {
+        appendKey(&value, sizeof(T));
+    }
+
+    void appendKey(const void* data, size_t size) {
+        if (cacheable) {
+            key.append(reinterpret_cast<const char*>(data), size);
+        }
+    }
+
+    void finish() {
+        breaker.finish();
+        key.clear();
+        cacheable = true;
+    }
+};
+
+struct LineBreaks {
+    std::vector<jint> breaks;
+    std::vector<jfloat> widths;
+    std::vector<jint> flags;
+};
+
+class LineBreakCache {
+public:
+    bool get(const std::string& key, LineBreaks* outBreaks) {
+        size_t hash = std::hash<std::string>()(key);
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+            if (it->hash == hash && it->key == key) {
+                *outBreaks = it->breaks;
+                mEntries.splice(mEntries.begin(), mEntries, it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void put(std::string&& key, LineBreaks&& breaks) {
+        size_t hash = std::hash<std::string>()(key);
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mEntries.size() >= kMaxCachedParagraphs) {
+            mEntries.pop_back();
+        }
+        mEntries.push_front({hash, std::move(key), std::move(breaks)});
+    }
+
+private:
+    struct Entry {
+        size_t hash;
+        std::string key;
+        LineBreaks breaks;
+    };
+
+    std::mutex mLock;
+    // Most recently used first
+    std::list<Entry> mEntries;
+};
+
+static LineBreakCache gLineBreakCache;
+
 // set text and set a number of parameters for creating a layout (width, tabstops, strategy,
 // hyphenFrequency)
 static void nSetupParagraph(JNIEnv* env, jclass, jlong nativePtr, jcharArray text, jint length,
         jfloat firstWidth, jint firstWidthLineLimit, jfloat restWidth,
         jintArray variableTabStops, jint defaultTabStop, jint strategy, jint hyphenFrequency,
         jboolean isJustified) {
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    minikin::LineBreaker* b = &builder->breaker;
     b->resize(length);
     env->GetCharArrayRegion(text, 0, length, b->buffer());
     b->setText();
     b->setLineWidths(firstWidth, firstWidthLineLimit, restWidth);
+
+    builder->cacheable = builder->cacheable && (size_t) length <= kMaxCachedParagraphLength;
+    builder->appendKey(StaticLayoutBuilder::KeyTag::Paragraph);
+    builder->appendKey(length);
+    builder->appendKey(b->buffer(), length * sizeof(uint16_t));
+    builder->appendKey(firstWidth);
+    builder->appendKey(firstWidthLineLimit);
+    builder->appendKey(restWidth);
+    builder->appendKey(defaultTabStop);
+    builder->appendKey(strategy);
+    builder->appendKey(hyphenFrequency);
+    builder->appendKey(isJustified);
+
     if (variableTabStops == nullptr) {
         b->setTabStops(nullptr, 0, defaultTabStop);
+        builder->appendKey((size_t) 0);
     } else {
         ScopedIntArrayRO stops(env, variableTabStops);
         b->setTabStops(stops.get(), stops.size(), defaultTabStop);
+        builder->appendKey(stops.size());
+        builder->appendKey(stops.get(), stops.size() * sizeof(jint));
     }
     b->setStrategy(static_cast<minikin::BreakStrategy>(strategy));
     b->setHyphenationFrequency(static_cast<minikin::HyphenationFrequency>(hyphenFrequency));
@@ -96,29 +216,49 @@ static jint nComputeLineBreaks(JNIEnv* env, jclass, jlong nativePtr,
                                jobject recycle, jintArray recycleBreaks,
                                jfloatArray recycleWidths, jintArray recycleFlags,
                                jint recycleLength) {
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    minikin::LineBreaker* b = &builder->breaker;
+
+    bool canCache = builder->canCache();
+    std::string key = canCache ? builder->fullKey() : std::string();
+    LineBreaks cached;
+    if (canCache && gLineBreakCache.get(key, &cached)) {
+        size_t nBreaks = cached.breaks.size();
+        recycleCopy(env, recycle, recycleBreaks, recycleWidths, recycleFlags, recycleLength,
+                nBreaks, cached.breaks.data(), cached.widths.data(), cached.flags.data());
+        builder->finish();
+        return static_cast<jint>(nBreaks);
+    }
 
     size_t nBreaks = b->computeBreaks();
 
     recycleCopy(env, recycle, recycleBreaks, recycleWidths, recycleFlags, recycleLength,
             nBreaks, b->getBreaks(), b->getWidths(), b->getFlags());
 
-    b->finish();
+    if (canCache) {
+        LineBreaks result;
+        result.breaks.assign(b->getBreaks(), b->getBreaks() + nBreaks);
+        result.widths.assign(b->getWidths(), b->getWidths() + nBreaks);
+        result.flags.assign(b->getFlags(), b->getFlags() + nBreaks);
+        gLineBreakCache.put(std::move(key), std::move(result));
+    }
+
+    builder->finish();
 
     return static_cast<jint>(nBreaks);
 }
 
 static jlong nNewBuilder(JNIEnv*, jclass) {
-    return reinterpret_cast<jlong>(new minikin::LineBreaker);
+    return reinterpret_cast<jlong>(new StaticLayoutBuilder);
 }
 
 static void nFreeBuilder(JNIEnv*, jclass, jlong nativePtr) {
-    delete reinterpret_cast<minikin::LineBreaker*>(nativePtr);
+    delete reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
 }
 
 static void nFinishBuilder(JNIEnv*, jclass, jlong nativePtr) {
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
-    b->finish();
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    builder->finish();
 }
 
 static jlong nLoadHyphenator(JNIEnv* env, jclass, jobject buffer, jint offset,
@@ -140,31 +280,59 @@ static jlong nLoadHyphenator(JNIEnv* env, jclass, jobject buffer, jint offset,
 static void nSetLocale(JNIEnv* env, jclass, jlong nativePtr, jstring javaLocaleName,
         jlong nativeHyphenator) {
     ScopedIcuLocale icuLocale(env, javaLocaleName);
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
     minikin::Hyphenator* hyphenator = reinterpret_cast<minikin::Hyphenator*>(nativeHyphenator);
 
     if (icuLocale.valid()) {
-        b->setLocale(icuLocale.locale(), hyphenator);
+        builder->breaker.setLocale(icuLocale.locale(), hyphenator);
+        const char* name = icuLocale.locale().getName();
+        builder->localeKey.assign(name, strlen(name) + 1);
+        builder->localeKey.append(reinterpret_cast<const char*>(&hyphenator),
+                sizeof(hyphenator));
     }
 }
 
 static void nSetIndents(JNIEnv* env, jclass, jlong nativePtr, jintArray indents) {
     ScopedIntArrayRO indentArr(env, indents);
     std::vector<float> indentVec(indentArr.get(), indentArr.get() + indentArr.size());
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
-    b->setIndents(indentVec);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    builder->breaker.setIndents(indentVec);
+    // Rare enough to not be worth keying on
+    builder->hasIndents = std::any_of(indentVec.begin(), indentVec.end(),
+            [](float indent) { return indent != 0; });
 }
 
 // Basically similar to Paint.getTextRunAdvances but with C++ interface
 static jfloat nAddStyleRun(JNIEnv* env, jclass, jlong nativePtr,
         jlong nativePaint, jlong nativeTypeface, jint start, jint end, jboolean isRtl) {
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    minikin::LineBreaker* b = &builder->breaker;
     Paint* paint = reinterpret_cast<Paint*>(nativePaint);
     Typeface* typeface = reinterpret_cast<Typeface*>(nativeTypeface);
     minikin::MinikinPaint minikinPaint;
     Typeface* resolvedTypeface = Typeface::resolveDefault(typeface);
     minikin::FontStyle style = MinikinUtils::prepareMinikinPaint(&minikinPaint, paint,
             typeface);
+
+    // Everything prepareMinikinPaint() reads from the paint and typeface
+    builder->appendKey(StaticLayoutBuilder::KeyTag::StyleRun);
+    builder->appendKey(start);
+    builder->appendKey(end);
+    builder->appendKey(isRtl);
+    builder->appendKey(resolvedTypeface);
+    builder->appendKey(minikinPaint.size);
+    builder->appendKey(minikinPaint.scaleX);
+    builder->appendKey(minikinPaint.skewX);
+    builder->appendKey(minikinPaint.letterSpacing);
+    builder->appendKey(minikinPaint.wordSpacing);
+    builder->appendKey(minikinPaint.paintFlags);
+    builder->appendKey(paint->getHyphenEdit());
+    builder->appendKey(paint->getMinikinLangListId());
+    builder->appendKey(paint->getFontVariant());
+    builder->appendKey(minikinPaint.fontFeatureSettings.size());
+    builder->appendKey(minikinPaint.fontFeatureSettings.data(),
+            minikinPaint.fontFeatureSettings.size());
+
     return b->addStyleRun(&minikinPaint, resolvedTypeface->fFontCollection, style, start, end,
             isRtl);
 }
@@ -172,19 +340,29 @@ static jfloat nAddStyleRun(JNIEnv* env, jclass, jlong nativePtr,
 // Accept width measurements for the run, passed in from Java
 static void nAddMeasuredRun(JNIEnv* env, jclass, jlong nativePtr,
         jint start, jint end, jfloatArray widths) {
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    minikin::LineBreaker* b = &builder->breaker;
     env->GetFloatArrayRegion(widths, start, end - start, b->charWidths() + start);
     b->addStyleRun(nullptr, nullptr, minikin::FontStyle{}, start, end, false);
+    builder->appendKey(StaticLayoutBuilder::KeyTag::MeasuredRun);
+    builder->appendKey(start);
+    builder->appendKey(end);
+    builder->appendKey(b->charWidths() + start, (end - start) * sizeof(float));
 }
 
 static void nAddReplacementRun(JNIEnv* env, jclass, jlong nativePtr,
         jint start, jint end, jfloat width) {
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
-    b->addReplacement(start, end, width);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    builder->breaker.addReplacement(start, end, width);
+    builder->appendKey(StaticLayoutBuilder::KeyTag::ReplacementRun);
+    builder->appendKey(start);
+    builder->appendKey(end);
+    builder->appendKey(width);
 }
 
 static void nGetWidths(JNIEnv* env, jclass, jlong nativePtr, jfloatArray widths) {
-    minikin::LineBreaker* b = reinterpret_cast<minikin::LineBreaker*>(nativePtr);
+    StaticLayoutBuilder* builder = reinterpret_cast<StaticLayoutBuilder*>(nativePtr);
+    minikin::LineBreaker* b = &builder->breaker;
     env->SetFloatArrayRegion(widths, 0, b->size(), b->charWidths());
 }
 
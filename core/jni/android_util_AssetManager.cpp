@@ -35,6 +35,7 @@
 #include "androidfw/ResourceTypes.h"
 #include "android_runtime/AndroidRuntime.h"
 #include "android_util_Binder.h"
+#include "android_util_StringBlock.h"
 #include "core_jni_helpers.h"
 #include "jni.h"
 #include "JNIHelp.h"
@@ -1491,7 +1492,7 @@ static jobjectArray android_content_AssetManager_getArrayStringResource(JNIEnv*
             const ResStringPool* pool = res.getTableStringBlock(block);
             const char* str8 = pool->string8At(value.data, &strLen);
             if (str8 != NULL) {
-                str = env->NewStringUTF(str8);
+                str = newStringFromPoolUtf8(env, str8, strLen);
             } else {
                 const char16_t* str16 = pool->stringAt(value.data, &strLen);
                 str = env->NewString(reinterpret_cast<const jchar*>(str16),
@@ -29,12 +29,19 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <tuple>
+
 #include <android-base/stringprintf.h>
 #include <binder/IInterface.h>
 #include <binder/IServiceManager.h>
 #include <binder/IPCThreadState.h>
 #include <binder/Parcel.h>
 #include <binder/ProcessState.h>
+#include <cutils/properties.h>
 #include <log/log.h>
 #include <utils/Atomic.h>
 #include <utils/KeyedVector.h>
@@ -42,6 +49,7 @@
 #include <utils/Log.h>
 #include <utils/String8.h>
 #include <utils/SystemClock.h>
+#include <utils/Timers.h>
 #include <utils/threads.h>
 
 #include <ScopedUtfChars.h>
@@ -231,6 +239,144 @@ bail:
     env->DeleteLocalRef(msgstr);
 }
 
+// ****************************************************************************
+// ****************************************************************************
+// ****************************************************************************
+
+// Transaction statistics, collected when the debug.binder.stats property is set when the
+// process starts. Every transaction is timed, but only one in kBinderStatsSampleInterval
+// of them, plus the slow ones, are recorded, to keep contention on the table low.
+
+static bool gBinderStatsEnabled = false;
+
+static const uint32_t kBinderStatsSampleInterval = 16;
+static const nsecs_t kBinderStatsSlowTransaction = ms2ns(16);
+// Transactions past this many distinct (descriptor, code) pairs are not recorded
+static const size_t kBinderStatsMaxEntries = 1024;
+static const size_t kMaxDescriptorLength = 128;
+
+// Upper bounds of the time histogram buckets, the last bucket is unbounded
+static const nsecs_t kBinderStatsHistogramBounds[] = {
+    us2ns(100), ms2ns(1), ms2ns(4), ms2ns(16), ms2ns(64), ms2ns(256),
+};
+#define BINDER_STATS_HISTOGRAM_SIZE (NELEM(kBinderStatsHistogramBounds) + 1)
+
+struct BinderTransactionStats {
+    int64_t samples = 0;
+    nsecs_t totalTime = 0;
+    nsecs_t maxTime = 0;
+    int64_t totalDataSize = 0;
+    size_t maxDataSize = 0;
+    int64_t totalReplySize = 0;
+    // Sum of the binder threads busy with incoming transactions, this one included
+    int64_t totalBusyThreads = 0;
+    int64_t histogram[BINDER_STATS_HISTOGRAM_SIZE] = {};
+};
+
+// Keyed by direction, true for incoming transactions, then descriptor and code
+typedef std::tuple<bool, std::string, uint32_t> BinderTransactionKey;
+
+static Mutex gBinderStatsLock;
+static std::map<BinderTransactionKey, BinderTransactionStats> gBinderStats;
+static std::atomic<int32_t> gBusyBinderThreads(0);
+static std::atomic<int32_t> gMaxBusyBinderThreads(0);
+
+static bool shouldSampleTransaction(nsecs_t duration) {
+    static thread_local uint32_t sTransactionCount = 0;
+    return ++sTransactionCount % kBinderStatsSampleInterval == 0
+            || duration >= kBinderStatsSlowTransaction;
+}
+
+// Transactions written by AIDL interfaces start with an interface token: the strict mode
+// policy of the caller followed by the interface descriptor.
+static std::string descriptorFromParcel(const Parcel& data) {
+    size_t position = data.dataPosition();
+    data.setDataPosition(0);
+    data.readInt32();
+    size_t length = 0;
+    const char16_t* descriptor = data.readString16Inplace(&length);
+    data.setDataPosition(position);
+    if (!descriptor || length == 0 || length > kMaxDescriptorLength) {
+        return "(unknown)";
+    }
+
+    std::string result;
+    for (size_t i = 0; i < length; i++) {
+        if (descriptor[i] < 0x20 || descriptor[i] >= 0x7f) {
+            return "(unknown)";
+        }
+        result += static_cast<char>(descriptor[i]);
+    }
+    return result;
+}
+
+static void recordBinderTransaction(bool incoming, uint32_t code, const Parcel& data,
+        const Parcel* reply, nsecs_t duration, int32_t busyThreads) {
+    BinderTransactionKey key(incoming, descriptorFromParcel(data), code);
+
+    size_t bucket = 0;
+    while (bucket < NELEM(kBinderStatsHistogramBounds)
+            && duration >= kBinderStatsHistogramBounds[bucket]) {
+        bucket++;
+    }
+
+    Mutex::Autolock _l(gBinderStatsLock);
+    auto it = gBinderStats.find(key);
+    if (it == gBinderStats.end()) {
+        if (gBinderStats.size() >= kBinderStatsMaxEntries) {
+            return;
+        }
+        it = gBinderStats.emplace(key, BinderTransactionStats()).first;
+    }
+    BinderTransactionStats& stats = it->second;
+    stats.samples++;
+    stats.totalTime += duration;
+    stats.maxTime = std::max(stats.maxTime, duration);
+    stats.totalDataSize += data.dataSize();
+    stats.maxDataSize = std::max(stats.maxDataSize, data.dataSize());
+    stats.totalReplySize += reply ? reply->dataSize() : 0;
+    stats.totalBusyThreads += busyThreads;
+    stats.histogram[bucket]++;
+}
+
+namespace android {
+
+void dumpBinderStats(int fd)
+{
+    if (!gBinderStatsEnabled) {
+        dprintf(fd, "Binder transaction stats are disabled, set debug.binder.stats to 1\n");
+        return;
+    }
+
+    Mutex::Autolock _l(gBinderStatsLock);
+    dprintf(fd, "Binder transaction stats, 1 in %" PRIu32 " sampled plus calls over %" PRId64
+            "ms:\n", kBinderStatsSampleInterval, ns2ms(kBinderStatsSlowTransaction));
+    dprintf(fd, "  busy binder threads: %" PRId32 " now, %" PRId32 " max\n",
+            gBusyBinderThreads.load(), gMaxBusyBinderThreads.load());
+    dprintf(fd, "  histogram buckets: <0.1ms <1ms <4ms <16ms <64ms <256ms >=256ms\n");
+    for (const auto& entry : gBinderStats) {
+        const BinderTransactionKey& key = entry.first;
+        const BinderTransactionStats& stats = entry.second;
+        dprintf(fd, "  %s %s code=%" PRIu32 ": samples=%" PRId64 " avg=%.3fms max=%.3fms"
+                " data avg=%" PRId64 "B max=%zuB reply avg=%" PRId64 "B",
+                std::get<0>(key) ? "in " : "out", std::get<1>(key).c_str(), std::get<2>(key),
+                stats.samples, stats.totalTime / 1000000.0 / stats.samples,
+                stats.maxTime / 1000000.0, stats.totalDataSize / stats.samples,
+                stats.maxDataSize, stats.totalReplySize / stats.samples);
+        if (std::get<0>(key)) {
+            dprintf(fd, " busy threads avg=%.1f",
+                    double(stats.totalBusyThreads) / stats.samples);
+        }
+        dprintf(fd, " histogram=[");
+        for (size_t i = 0; i < BINDER_STATS_HISTOGRAM_SIZE; i++) {
+            dprintf(fd, "%s%" PRId64, i ? " " : "", stats.histogram[i]);
+        }
+        dprintf(fd, "]\n");
+    }
+}
+
+}
+
 class JavaBBinderHolder;
 
 class JavaBBinder : public BBinder
@@ -276,9 +422,30 @@ protected:
         //printf("Transact from %p to Java code sending: ", this);
         //data.print();
         //printf("\n");
+        nsecs_t start_time = 0;
+        int32_t busy_threads = 0;
+        if (gBinderStatsEnabled) {
+            start_time = systemTime(SYSTEM_TIME_MONOTONIC);
+            busy_threads = ++gBusyBinderThreads;
+            int32_t max_busy_threads = gMaxBusyBinderThreads.load(std::memory_order_relaxed);
+            while (busy_threads > max_busy_threads
+                    && !gMaxBusyBinderThreads.compare_exchange_weak(max_busy_threads,
+                            busy_threads, std::memory_order_relaxed)) {
+            }
+        }
+
         jboolean res = env->CallBooleanMethod(mObject, gBinderOffsets.mExecTransact,
             code, reinterpret_cast<jlong>(&data), reinterpret_cast<jlong>(reply), flags);
 
+        if (gBinderStatsEnabled) {
+            gBusyBinderThreads--;
+            nsecs_t duration = systemTime(SYSTEM_TIME_MONOTONIC) - start_time;
+            if (shouldSampleTransaction(duration)) {
+                recordBinderTransaction(true /*incoming*/, code, data, reply, duration,
+                        busy_threads);
+            }
+        }
+
         if (env->ExceptionCheck()) {
             jthrowable excep = env->ExceptionOccurred();
             report_exception(env, excep,
@@ -886,6 +1053,8 @@ static int int_register_android_os_Binder(JNIEnv* env)
     gBinderOffsets.mExecTransact = GetMethodIDOrDie(env, clazz, "execTransact", "(IJJI)Z");
     gBinderOffsets.mObject = GetFieldIDOrDie(env, clazz, "mObject", "J");
 
+    gBinderStatsEnabled = property_get_bool("debug.binder.stats", false);
+
     return RegisterMethodsOrDie(
         env, kBinderPathName,
         gBinderMethods, NELEM(gBinderMethods));
@@ -1149,10 +1318,19 @@ static jboolean android_os_BinderProxy_transact(JNIEnv* env, jobject obj,
         }
     }
 
+    nsecs_t start_time = gBinderStatsEnabled ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
+
     //printf("Transact from Java code to %p sending: ", target); data->print();
     status_t err = target->transact(code, *data, reply, flags);
     //if (reply) printf("Transact from Java code to %p received: ", target); reply->print();
 
+    if (gBinderStatsEnabled) {
+        nsecs_t duration = systemTime(SYSTEM_TIME_MONOTONIC) - start_time;
+        if (shouldSampleTransaction(duration)) {
+            recordBinderTransaction(false /*incoming*/, code, *data, reply, duration, 0);
+        }
+    }
+
     if (kEnableBinderSample) {
         if (time_binder_calls) {
             conditionally_log_binder_call(start_millis, target, code);
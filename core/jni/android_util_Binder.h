@@ -35,6 +35,9 @@ extern void set_dalvik_blockguard_policy(JNIEnv* env, jint strict_policy);
 extern void signalExceptionForError(JNIEnv* env, jobject obj, status_t err,
         bool canThrowRemoteException = false, int parcelSize = 0);
 
+// Writes the binder transaction statistics of this process, see debug.binder.stats.
+extern void dumpBinderStats(int fd);
+
 }
 
 #endif
@@ -45,6 +45,24 @@ static jfieldID gFloatValueID;
 
 static jclass gStringClass;
 
+/*
+ * Appends value to ctx. Strings that fit in an event are converted on the stack, longer
+ * ones would be truncated by ctx anyway.
+ */
+static void appendString(JNIEnv* env, android_log_event_list& ctx, jstring value) {
+    char buffer[LOGGER_ENTRY_MAX_PAYLOAD];
+    jsize utfLength = env->GetStringUTFLength(value);
+    if (size_t(utfLength) < sizeof(buffer)) {
+        env->GetStringUTFRegion(value, 0, env->GetStringLength(value), buffer);
+        buffer[utfLength] = '\0';
+        ctx << buffer;
+    } else {
+        const char *str = env->GetStringUTFChars(value, NULL);
+        ctx << str;
+        env->ReleaseStringUTFChars(value, str);
+    }
+}
+
 /*
  * In class android.util.EventLog:
  *  static native int writeEvent(int tag, int value)
@@ -95,9 +113,7 @@ static jint android_util_EventLog_writeEvent_String(JNIEnv* env,
     // Don't throw NPE -- I feel like it's sort of mean for a logging function
     // to be all crashy if you pass in NULL -- but make the NULL value explicit.
     if (value != NULL) {
-        const char *str = env->GetStringUTFChars(value, NULL);
-        ctx << str;
-        env->ReleaseStringUTFChars(value, str);
+        appendString(env, ctx, value);
     } else {
         ctx << "NULL";
     }
@@ -124,9 +140,7 @@ static jint android_util_EventLog_writeEvent_Array(JNIEnv* env, jobject clazz,
         if (item == NULL) {
             ctx << "NULL";
         } else if (env->IsInstanceOf(item, gStringClass)) {
-            const char *str = env->GetStringUTFChars((jstring) item, NULL);
-            ctx << str;
-            env->ReleaseStringUTFChars((jstring) item, str);
+            appendString(env, ctx, (jstring) item);
         } else if (env->IsInstanceOf(item, gIntegerClass)) {
             ctx << (int32_t)env->GetIntField(item, gIntegerValueID);
         } else if (env->IsInstanceOf(item, gLongClass)) {
@@ -50,7 +50,9 @@ static void android_os_fileobserver_observe(JNIEnv* env, jobject object, jint fd
 {
 #if defined(__linux__)
 
-    char event_buf[512];
+    // Large enough to pick up a burst of events, such as a directory being
+    // populated, with a single read rather than a few events at a time.
+    char event_buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
     struct inotify_event* event;
 
     while (1)
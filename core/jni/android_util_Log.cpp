@@ -22,9 +22,20 @@
 #include <assert.h>
 #include <cutils/properties.h>
 #include <log/log.h>               // For LOGGER_ENTRY_MAX_PAYLOAD.
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
 #include <utils/Log.h>
 #include <utils/String8.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "jni.h"
 #include "JNIHelp.h"
 #include "utils/misc.h"
@@ -68,6 +79,247 @@ bool android_util_Log_isVerboseLogEnabled(const char* tag) {
     return isLoggable(tag, levels.verbose);
 }
 
+/*
+ * Asynchronous logging, enabled with the debug.log.async property.
+ *
+ * Each thread appends its messages to its own lock-free ring, which a background thread
+ * writes to logd. Messages are dropped, and counted, when the ring of their thread is full.
+ * Entries then carry the tid of the background thread, and the time at which it wrote them.
+ * Assertions are still written before println_native returns.
+ *
+ * Only processes forked from the one that registered the natives, typically the zygote,
+ * log asynchronously, since the zygote must not start threads. The mode is decided at the
+ * first message such a process logs.
+ */
+
+class LogRing {
+public:
+    // Record header, followed by the tag and the message including their terminators
+    struct Record {
+        uint8_t bufID;
+        uint8_t priority;
+        uint16_t tagSize;
+        uint16_t msgSize;
+    };
+
+    static const size_t kSize = 64 * 1024;
+    // Largest tag and message written to logd, matching what liblog truncates them to
+    static const size_t kMaxPayload = LOGGER_ENTRY_MAX_PAYLOAD;
+
+    // Called by the thread owning the ring only
+    bool push(int bufID, int priority, const char* tag, const char* msg) {
+        size_t tagSize = std::min(strlen(tag), size_t(UINT8_MAX)) + 1;
+        size_t msgSize = std::min(strlen(msg), kMaxPayload - tagSize - 1) + 1;
+        Record record = { uint8_t(bufID), uint8_t(priority),
+                uint16_t(tagSize), uint16_t(msgSize) };
+
+        size_t head = mHead.load(std::memory_order_relaxed);
+        size_t tail = mTail.load(std::memory_order_acquire);
+        if (kSize - (head - tail) < sizeof(Record) + tagSize + msgSize) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        head = copyIn(head, &record, sizeof(Record));
+        head = copyIn(head, tag, tagSize - 1);
+        head = copyIn(head, "", 1);
+        head = copyIn(head, msg, msgSize - 1);
+        head = copyIn(head, "", 1);
+        mHead.store(head, std::memory_order_release);
+        return true;
+    }
+
+    // Called by the writer thread only. Returns whether anything was written.
+    bool drain() {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t head = mHead.load(std::memory_order_acquire);
+        bool wrote = tail != head;
+        while (tail != head) {
+            Record record;
+            tail = copyOut(tail, &record, sizeof(Record));
+            tail = copyOut(tail, mScratch, record.tagSize + record.msgSize);
+            // Let the producer reuse the space before the slow write to logd
+            mTail.store(tail, std::memory_order_release);
+            __android_log_buf_write(record.bufID, (android_LogPriority)record.priority,
+                    mScratch, mScratch + record.tagSize);
+        }
+
+        uint32_t dropped = mDropped.exchange(0, std::memory_order_relaxed);
+        if (dropped) {
+            ALOGW("Dropped %u log messages of thread %d, its log ring was full", dropped, mTid);
+            wrote = true;
+        }
+        return wrote;
+    }
+
+    bool isEmpty() const {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+    // Whether the messages and the drop count were all written
+    bool isDrained() const {
+        return isEmpty() && mDropped.load(std::memory_order_relaxed) == 0;
+    }
+
+    const pid_t mTid = gettid();
+    // Set when the owning thread exits, the ring is freed once drained
+    std::atomic<bool> mOrphaned { false };
+
+private:
+    size_t copyIn(size_t position, const void* data, size_t size) {
+        size_t offset = position % kSize;
+        size_t first = std::min(size, kSize - offset);
+        memcpy(mData + offset, data, first);
+        memcpy(mData, static_cast<const uint8_t*>(data) + first, size - first);
+        return position + size;
+    }
+
+    size_t copyOut(size_t position, void* data, size_t size) {
+        size_t offset = position % kSize;
+        size_t first = std::min(size, kSize - offset);
+        memcpy(data, mData + offset, first);
+        memcpy(static_cast<uint8_t*>(data) + first, mData, size - first);
+        return position + size;
+    }
+
+    uint8_t mData[kSize];
+    // Positions only ever grow, they are taken modulo kSize to index mData
+    std::atomic<size_t> mHead { 0 };
+    std::atomic<size_t> mTail { 0 };
+    std::atomic<uint32_t> mDropped { 0 };
+    // Only accessed by the writer thread
+    char mScratch[kMaxPayload];
+};
+
+enum class AsyncLogState {
+    Undecided,
+    Disabled,
+    Enabled,
+};
+
+static pid_t gRegisteringPid;
+static std::atomic<AsyncLogState> gAsyncLogState(AsyncLogState::Undecided);
+
+// Never destroyed, the writer thread may still use them while the process exits
+static std::mutex& gLogRingsLock = *new std::mutex();
+static std::condition_variable& gLogWriterCondition = *new std::condition_variable();
+static std::vector<LogRing*>& gLogRings = *new std::vector<LogRing*>();
+// True while the writer thread waits for messages
+static std::atomic<bool> gLogWriterIdle(false);
+
+static void logWriterLoop() {
+    std::vector<LogRing*> rings;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(gLogRingsLock);
+            // Rings of exited threads are only freed when they were drained previously
+            gLogRings.erase(std::remove_if(gLogRings.begin(), gLogRings.end(),
+                    [](LogRing* ring) {
+                        if (ring->mOrphaned.load() && ring->isDrained()) {
+                            delete ring;
+                            return true;
+                        }
+                        return false;
+                    }), gLogRings.end());
+            rings = gLogRings;
+        }
+
+        bool wrote = false;
+        for (LogRing* ring : rings) {
+            wrote |= ring->drain();
+        }
+        if (wrote) {
+            continue;
+        }
+
+        gLogWriterIdle = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // Messages pushed before the flag was set didn't wake the writer
+        std::unique_lock<std::mutex> lock(gLogRingsLock);
+        bool drained = std::all_of(gLogRings.begin(), gLogRings.end(),
+                [](LogRing* ring) { return ring->isDrained(); });
+        if (drained) {
+            gLogWriterCondition.wait(lock, [] { return !gLogWriterIdle.load(); });
+        }
+        gLogWriterIdle = false;
+    }
+}
+
+static void wakeLogWriter() {
+    // Orders the push before reading the flag, pairing with the fence of the writer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (gLogWriterIdle.load(std::memory_order_relaxed) && gLogWriterIdle.exchange(false)) {
+        std::lock_guard<std::mutex> lock(gLogRingsLock);
+        gLogWriterCondition.notify_one();
+    }
+}
+
+static void disableAsyncLogInChild() {
+    // The writer thread doesn't survive fork(), and gLogRingsLock may have been held by it
+    gAsyncLogState = AsyncLogState::Disabled;
+    gLogWriterIdle = false;
+}
+
+static bool isAsyncLogEnabled() {
+    AsyncLogState state = gAsyncLogState.load(std::memory_order_relaxed);
+    if (CC_LIKELY(state != AsyncLogState::Undecided)) {
+        return state == AsyncLogState::Enabled;
+    }
+    if (getpid() == gRegisteringPid) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(gLogRingsLock);
+    state = gAsyncLogState.load();
+    if (state == AsyncLogState::Undecided) {
+        state = AsyncLogState::Disabled;
+        if (property_get_bool("debug.log.async", false)) {
+            pthread_atfork(NULL, NULL, disableAsyncLogInChild);
+            std::thread(logWriterLoop).detach();
+            state = AsyncLogState::Enabled;
+        }
+        gAsyncLogState = state;
+    }
+    return state == AsyncLogState::Enabled;
+}
+
+struct ThreadLogRing {
+    LogRing* ring = nullptr;
+
+    ~ThreadLogRing() {
+        if (ring && gAsyncLogState.load() == AsyncLogState::Enabled) {
+            ring->mOrphaned = true;
+            wakeLogWriter();
+        }
+    }
+
+    LogRing* get() {
+        if (!ring) {
+            ring = new LogRing();
+            std::lock_guard<std::mutex> lock(gLogRingsLock);
+            gLogRings.push_back(ring);
+        }
+        return ring;
+    }
+};
+
+static int writeLogAsync(int bufID, int priority, const char* tag, const char* msg) {
+    static thread_local ThreadLogRing sThreadRing;
+    LogRing* ring = sThreadRing.get();
+    if (priority >= ANDROID_LOG_FATAL) {
+        // The caller may abort right after, wait for the earlier messages to be written
+        wakeLogWriter();
+        for (int i = 0; i < 100 && !ring->isEmpty(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return __android_log_buf_write(bufID, (android_LogPriority)priority, tag, msg);
+    }
+    if (!ring->push(bufID, priority, tag, msg)) {
+        return -EAGAIN;
+    }
+    wakeLogWriter();
+    return 1 + strlen(tag) + 1 + strlen(msg) + 1;
+}
+
 /*
  * In class android.util.Log:
  *  public static native int println_native(int buffer, int priority, String tag, String msg)
@@ -92,7 +344,12 @@ static jint android_util_Log_println_native(JNIEnv* env, jobject clazz,
         tag = env->GetStringUTFChars(tagObj, NULL);
     msg = env->GetStringUTFChars(msgObj, NULL);
 
-    int res = __android_log_buf_write(bufID, (android_LogPriority)priority, tag, msg);
+    int res;
+    if (isAsyncLogEnabled()) {
+        res = writeLogAsync(bufID, priority, tag ? tag : "", msg);
+    } else {
+        res = __android_log_buf_write(bufID, (android_LogPriority)priority, tag, msg);
+    }
 
     if (tag != NULL)
         env->ReleaseStringUTFChars(tagObj, tag);
@@ -125,6 +382,8 @@ int register_android_util_Log(JNIEnv* env)
 {
     jclass clazz = FindClassOrDie(env, "android/util/Log");
 
+    gRegisteringPid = getpid();
+
     levels.verbose = env->GetStaticIntField(clazz, GetStaticFieldIDOrDie(env, clazz, "VERBOSE", "I"));
     levels.debug = env->GetStaticIntField(clazz, GetStaticFieldIDOrDie(env, clazz, "DEBUG", "I"));
     levels.info = env->GetStaticIntField(clazz, GetStaticFieldIDOrDie(env, clazz, "INFO", "I"));
@@ -313,11 +313,13 @@ jint android_os_Process_getProcessGroup(JNIEnv* env, jobject clazz, jint pid)
  */
 static void parse_cpuset_cpus(char *cpus, cpu_set_t *cpu_set) {
     unsigned int start, end, matched, i;
-    char *cpu_range = strtok(cpus, ",");
+    // Any thread of the process may get here, so strtok's hidden state won't do
+    char *saveptr;
+    char *cpu_range = strtok_r(cpus, ",", &saveptr);
     while (cpu_range != NULL) {
         start = end = 0;
         matched = sscanf(cpu_range, "%u-%u", &start, &end);
-        cpu_range = strtok(NULL, ",");
+        cpu_range = strtok_r(NULL, ",", &saveptr);
         if (start >= CPU_SETSIZE) {
             ALOGE("parse_cpuset_cpus: ignoring CPU number larger than %d.", CPU_SETSIZE);
             continue;
@@ -339,31 +341,34 @@ static void parse_cpuset_cpus(char *cpus, cpu_set_t *cpu_set) {
 }
 
 /**
- * Stores the CPUs assigned to the cpuset corresponding to the
- * SchedPolicy in the passed in cpu_set.
+ * Returns the cpus file of the cpuset corresponding to the SchedPolicy,
+ * or NULL if it has none. Policies sharing a cpuset return the same pointer.
  */
-static void get_cpuset_cores_for_policy(SchedPolicy policy, cpu_set_t *cpu_set)
+static const char* get_cpuset_cpus_path(SchedPolicy policy)
 {
-    FILE *file;
-    const char *filename;
-
-    CPU_ZERO(cpu_set);
-
     switch (policy) {
         case SP_BACKGROUND:
-            filename = "/dev/cpuset/background/cpus";
-            break;
+            return "/dev/cpuset/background/cpus";
         case SP_FOREGROUND:
         case SP_AUDIO_APP:
         case SP_AUDIO_SYS:
-            filename = "/dev/cpuset/foreground/cpus";
-            break;
+            return "/dev/cpuset/foreground/cpus";
         case SP_TOP_APP:
-            filename = "/dev/cpuset/top-app/cpus";
-            break;
+            return "/dev/cpuset/top-app/cpus";
         default:
-            filename = NULL;
+            return NULL;
     }
+}
+
+/**
+ * Stores the CPUs assigned to the cpuset whose cpus file is
+ * filename in the passed in cpu_set.
+ */
+static void get_cpuset_cores(const char *filename, cpu_set_t *cpu_set)
+{
+    FILE *file;
+
+    CPU_ZERO(cpu_set);
 
     if (!filename) return;
 
@@ -394,10 +399,30 @@ void get_exclusive_cpuset_cores(SchedPolicy policy, cpu_set_t *cpu_set) {
     if (cpusets_enabled()) {
         int i;
         cpu_set_t tmp_set;
-        get_cpuset_cores_for_policy(policy, cpu_set);
+        // Several policies share a cpuset, read each cpus file only once
+        const char *paths[SP_CNT];
+        cpu_set_t cores[SP_CNT];
+        for (i = 0; i < SP_CNT; i++) {
+            paths[i] = get_cpuset_cpus_path((SchedPolicy) i);
+            int j = 0;
+            while (j < i && paths[j] != paths[i]) {
+                j++;
+            }
+            if (j < i) {
+                cores[i] = cores[j];
+            } else {
+                get_cpuset_cores(paths[i], &cores[i]);
+            }
+        }
+
+        if (policy >= 0 && policy < SP_CNT) {
+            *cpu_set = cores[policy];
+        } else {
+            CPU_ZERO(cpu_set);
+        }
         for (i = 0; i < SP_CNT; i++) {
             if ((SchedPolicy) i == policy) continue;
-            get_cpuset_cores_for_policy((SchedPolicy)i, &tmp_set);
+            tmp_set = cores[i];
             // First get cores exclusive to one set or the other
             CPU_XOR(&tmp_set, cpu_set, &tmp_set);
             // Then get the ones only in cpu_set
@@ -426,7 +451,7 @@ jintArray android_os_Process_getExclusiveCores(JNIEnv* env, jobject clazz) {
         return NULL;
     }
 
-    jint* cpu_elements = env->GetIntArrayElements(cpus, 0);
+    jint cpu_elements[CPU_SETSIZE];
     int count = 0;
     for (int i = 0; i < CPU_SETSIZE && count < num_cpus; i++) {
         if (CPU_ISSET(i, &cpu_set)) {
@@ -434,7 +459,7 @@ jintArray android_os_Process_getExclusiveCores(JNIEnv* env, jobject clazz) {
         }
     }
 
-    env->ReleaseIntArrayElements(cpus, cpu_elements, 0);
+    env->SetIntArrayRegion(cpus, 0, count, cpu_elements);
     return cpus;
 }
 
@@ -886,7 +911,7 @@ jboolean android_os_Process_parseProcLineArray(JNIEnv* env, jobject clazz,
     if (formatData == NULL || (NL > 0 && longsData == NULL)
             || (NR > 0 && floatsData == NULL)) {
         if (formatData != NULL) {
-            env->ReleaseIntArrayElements(format, formatData, 0);
+            env->ReleaseIntArrayElements(format, formatData, JNI_ABORT);
         }
         if (longsData != NULL) {
             env->ReleaseLongArrayElements(outLongs, longsData, 0);
@@ -981,7 +1006,8 @@ jboolean android_os_Process_parseProcLineArray(JNIEnv* env, jobject clazz,
         }
     }
 
-    env->ReleaseIntArrayElements(format, formatData, 0);
+    // The format is only read, don't copy it back
+    env->ReleaseIntArrayElements(format, formatData, JNI_ABORT);
     if (longsData != NULL) {
         env->ReleaseLongArrayElements(outLongs, longsData, 0);
     }
@@ -1002,7 +1028,8 @@ jboolean android_os_Process_parseProcLine(JNIEnv* env, jobject clazz,
                 (char*) bufferArray, startIndex, endIndex, format, outStrings,
                 outLongs, outFloats);
 
-        env->ReleaseByteArrayElements(buffer, bufferArray, 0);
+        // Parsing terminates fields in place but restores the buffer, so it's unchanged
+        env->ReleaseByteArrayElements(buffer, bufferArray, JNI_ABORT);
 
         return result;
 }
@@ -1093,9 +1120,13 @@ static jlong android_os_Process_getPss(JNIEnv* env, jobject clazz, jint pid)
 {
     char filename[64];
 
-    snprintf(filename, sizeof(filename), "/proc/%" PRId32 "/smaps", pid);
-
-    FILE * file = fopen(filename, "r");
+    // smaps_rollup has the Pss of all maps already summed up, older kernels only have smaps
+    snprintf(filename, sizeof(filename), "/proc/%" PRId32 "/smaps_rollup", pid);
+    FILE * file = fopen(filename, "re");
+    if (!file) {
+        snprintf(filename, sizeof(filename), "/proc/%" PRId32 "/smaps", pid);
+        file = fopen(filename, "re");
+    }
     if (!file) {
         return (jlong) -1;
     }
@@ -1104,9 +1135,8 @@ static jlong android_os_Process_getPss(JNIEnv* env, jobject clazz, jint pid)
     char line[256];
     jlong pss = 0;
     while (fgets(line, sizeof(line), file)) {
-        jlong v;
-        if (sscanf(line, "Pss: %" SCNd64 " kB", &v) == 1) {
-            pss += v;
+        if (strncmp(line, "Pss:", 4) == 0) {
+            pss += strtoll(line + 4, NULL, 10);
         }
     }
 
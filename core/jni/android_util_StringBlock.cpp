@@ -17,14 +17,18 @@
 
 #define LOG_TAG "StringBlock"
 
+#include "android_util_StringBlock.h"
+
 #include "jni.h"
 #include "JNIHelp.h"
 #include <utils/misc.h>
 #include <core_jni_helpers.h>
 #include <utils/Log.h>
+#include <utils/Unicode.h>
 
 #include <androidfw/ResourceTypes.h>
 
+#include <memory>
 #include <stdio.h>
 
 namespace android {
@@ -71,6 +75,41 @@ static jint android_content_StringBlock_nativeGetSize(JNIEnv* env, jobject clazz
     return osb->size();
 }
 
+// Creates a Java string from a string of a UTF-8 pool. NewStringUTF() takes modified UTF-8, which
+// encodes supplementary characters as surrogate pairs, so strings holding 4-byte sequences are
+// converted to UTF-16 here instead. That conversion doesn't go through the decode cache of the
+// pool, which is meant to stay unused on device.
+jstring newStringFromPoolUtf8(JNIEnv* env, const char* str8, size_t len)
+{
+    const uint8_t* u8str = reinterpret_cast<const uint8_t*>(str8);
+    bool hasSupplementary = false;
+    for (size_t i = 0; i < len; i++) {
+        if (u8str[i] >= 0xF0) {
+            hasSupplementary = true;
+            break;
+        }
+    }
+    if (!hasSupplementary) {
+        return env->NewStringUTF(str8);
+    }
+
+    const ssize_t u16len = utf8_to_utf16_length(u8str, len);
+    if (u16len < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+        return NULL;
+    }
+
+    char16_t stackBuffer[256];
+    std::unique_ptr<char16_t[]> heapBuffer;
+    char16_t* u16str = stackBuffer;
+    if (static_cast<size_t>(u16len) + 1 > sizeof(stackBuffer) / sizeof(stackBuffer[0])) {
+        heapBuffer.reset(new char16_t[u16len + 1]);
+        u16str = heapBuffer.get();
+    }
+    utf8_to_utf16(u8str, len, u16str, u16len + 1);
+    return env->NewString(reinterpret_cast<const jchar*>(u16str), u16len);
+}
+
 static jstring android_content_StringBlock_nativeGetString(JNIEnv* env, jobject clazz,
                                                         jlong token, jint idx)
 {
@@ -83,7 +122,7 @@ static jstring android_content_StringBlock_nativeGetString(JNIEnv* env, jobject
     size_t len;
     const char* str8 = osb->string8At(idx, &len);
     if (str8 != NULL) {
-        return env->NewStringUTF(str8);
+        return newStringFromPoolUtf8(env, str8, len);
     }
 
     const char16_t* str = osb->stringAt(idx, &len);
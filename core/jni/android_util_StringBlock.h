@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _ANDROID_UTIL_STRINGBLOCK_H
+#define _ANDROID_UTIL_STRINGBLOCK_H
+
+#include <jni.h>
+#include <stddef.h>
+
+namespace android {
+
+// Creates a Java string from the UTF-8 string of a ResStringPool, of len bytes.
+jstring newStringFromPoolUtf8(JNIEnv* env, const char* str8, size_t len);
+
+}
+
+#endif // _ANDROID_UTIL_STRINGBLOCK_H
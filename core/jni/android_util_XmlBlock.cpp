@@ -25,6 +25,7 @@
 #include <utils/Log.h>
 #include <utils/misc.h>
 
+#include <memory>
 #include <stdio.h>
 
 namespace android {
@@ -254,6 +255,40 @@ static jint android_content_XmlBlock_nativeGetAttributeStringValue(JNIEnv* env,
     return static_cast<jint>(st->getAttributeValueStringID(idx));
 }
 
+// Copies the characters of a Java string for the duration of a lookup. Attribute names and
+// namespaces are short, so they are read with GetStringRegion() into a stack buffer instead of
+// GetStringChars(), which has to allocate a copy of compressed strings on every call. A null
+// string gives null chars, as indexOfAttribute() expects for an absent namespace.
+class JavaStringCopy {
+public:
+    JavaStringCopy(JNIEnv* env, jstring str)
+        : mChars(NULL), mLength(0) {
+        if (str == NULL) {
+            return;
+        }
+        mLength = env->GetStringLength(str);
+        jchar* buffer = mStackBuffer;
+        if (static_cast<size_t>(mLength) > NELEM(mStackBuffer)) {
+            mHeapBuffer.reset(new jchar[mLength]);
+            buffer = mHeapBuffer.get();
+        }
+        env->GetStringRegion(str, 0, mLength, buffer);
+        mChars = reinterpret_cast<const char16_t*>(buffer);
+    }
+
+    const char16_t* chars() const { return mChars; }
+    size_t length() const { return mLength; }
+
+private:
+    JavaStringCopy(const JavaStringCopy&) = delete;
+    JavaStringCopy& operator=(const JavaStringCopy&) = delete;
+
+    const char16_t* mChars;
+    jsize mLength;
+    jchar mStackBuffer[128];
+    std::unique_ptr<jchar[]> mHeapBuffer;
+};
+
 static jint android_content_XmlBlock_nativeGetAttributeIndex(JNIEnv* env, jobject clazz,
                                                              jlong token,
                                                              jstring ns, jstring name)
@@ -264,25 +299,11 @@ static jint android_content_XmlBlock_nativeGetAttributeIndex(JNIEnv* env, jobjec
         return 0;
     }
 
-    const char16_t* ns16 = NULL;
-    jsize nsLen = 0;
-    if (ns) {
-        ns16 = reinterpret_cast<const char16_t*>(env->GetStringChars(ns, NULL));
-        nsLen = env->GetStringLength(ns);
-    }
-
-    const char16_t* name16 = reinterpret_cast<const char16_t*>(
-        env->GetStringChars(name, NULL));
-    jsize nameLen = env->GetStringLength(name);
-
-    jint idx = static_cast<jint>(st->indexOfAttribute(ns16, nsLen, name16, nameLen));
-
-    if (ns) {
-        env->ReleaseStringChars(ns, reinterpret_cast<const jchar*>(ns16));
-    }
-    env->ReleaseStringChars(name, reinterpret_cast<const jchar*>(name16));
+    const JavaStringCopy ns16(env, ns);
+    const JavaStringCopy name16(env, name);
 
-    return idx;
+    return static_cast<jint>(st->indexOfAttribute(ns16.chars(), ns16.length(),
+                                                  name16.chars(), name16.length()));
 }
 
 static jint android_content_XmlBlock_nativeGetIdAttribute(JNIEnv* env, jobject clazz,
@@ -17,7 +17,14 @@
 
 #define LOG_TAG "StrictJarFile"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include <log/log.h>
@@ -52,6 +59,54 @@ static jobject newZipEntry(JNIEnv* env, const ZipEntry& entry, jstring entryName
                         static_cast<jlong>(entry.offset));
 }
 
+// Archives closed by Java that are kept open, since package scanning and verification
+// open each APK several times in a row
+static const size_t kMaxIdleArchives = 4;
+
+/*
+ * An archive shared by the StrictJarFiles of the same file. It reads from its own
+ * duplicate of the descriptor, so it can outlive the StrictJarFile that opened it.
+ */
+struct JarArchive {
+  ZipArchiveHandle handle;
+  // Identifies the file contents, ctime changes whenever the file is written
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  struct timespec mtime;
+  struct timespec ctime;
+  // Number of open StrictJarFiles using the archive, guarded by gArchivesLock
+  int refs;
+
+  bool Matches(const struct stat& st) const {
+    return dev == st.st_dev && ino == st.st_ino && size == st.st_size
+        && mtime.tv_sec == st.st_mtim.tv_sec && mtime.tv_nsec == st.st_mtim.tv_nsec
+        && ctime.tv_sec == st.st_ctim.tv_sec && ctime.tv_nsec == st.st_ctim.tv_nsec;
+  }
+};
+
+static std::mutex gArchivesLock;
+// Most recently used first
+static std::list<JarArchive*> gArchives;
+
+static ZipArchiveHandle toArchiveHandle(jlong nativeHandle) {
+  return reinterpret_cast<JarArchive*>(nativeHandle)->handle;
+}
+
+static void closeIdleArchives(size_t maxIdle) {
+  size_t idle = 0;
+  for (auto it = gArchives.begin(); it != gArchives.end();) {
+    JarArchive* archive = *it;
+    if (archive->refs == 0 && ++idle > maxIdle) {
+      CloseArchive(archive->handle);
+      delete archive;
+      it = gArchives.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 static jlong StrictJarFile_nativeOpenJarFile(JNIEnv* env, jobject, jstring name, jint fd) {
   // Name argument is used for logging, and can be any string.
   ScopedUtfChars nameChars(env, name);
@@ -59,16 +114,49 @@ static jlong StrictJarFile_nativeOpenJarFile(JNIEnv* env, jobject, jstring name,
     return static_cast<jlong>(-1);
   }
 
+  // The zygote runs as root, and must not keep descriptors open across forks
+  struct stat st;
+  const bool cacheable = getuid() != 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+  if (cacheable) {
+    std::lock_guard<std::mutex> lock(gArchivesLock);
+    for (auto it = gArchives.begin(); it != gArchives.end(); ++it) {
+      JarArchive* archive = *it;
+      if (archive->Matches(st)) {
+        archive->refs++;
+        gArchives.splice(gArchives.begin(), gArchives, it);
+        return reinterpret_cast<jlong>(archive);
+      }
+    }
+  }
+
+  int archiveFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (archiveFd == -1) {
+    jniThrowIOException(env, errno);
+    return static_cast<jlong>(-1);
+  }
+
   ZipArchiveHandle handle;
-  int32_t error = OpenArchiveFd(fd, nameChars.c_str(), &handle,
-      false /* owned by Java side */);
+  int32_t error = OpenArchiveFd(archiveFd, nameChars.c_str(), &handle,
+      true /* assume ownership of the duplicate */);
   if (error) {
     CloseArchive(handle);
     throwIoException(env, error);
     return static_cast<jlong>(-1);
   }
 
-  return reinterpret_cast<jlong>(handle);
+  JarArchive* archive = new JarArchive();
+  archive->handle = handle;
+  archive->refs = 1;
+  if (cacheable) {
+    archive->dev = st.st_dev;
+    archive->ino = st.st_ino;
+    archive->size = st.st_size;
+    archive->mtime = st.st_mtim;
+    archive->ctime = st.st_ctim;
+    std::lock_guard<std::mutex> lock(gArchivesLock);
+    gArchives.push_front(archive);
+  }
+  return reinterpret_cast<jlong>(archive);
 }
 
 class IterationHandle {
@@ -100,11 +188,11 @@ static jlong StrictJarFile_nativeStartIteration(JNIEnv* env, jobject, jlong nati
   IterationHandle* handle = new IterationHandle();
   int32_t error = 0;
   if (prefixChars.size() == 0) {
-    error = StartIteration(reinterpret_cast<ZipArchiveHandle>(nativeHandle),
+    error = StartIteration(toArchiveHandle(nativeHandle),
                            handle->CookieAddress(), NULL, NULL);
   } else {
     ZipString entry_name(prefixChars.c_str());
-    error = StartIteration(reinterpret_cast<ZipArchiveHandle>(nativeHandle),
+    error = StartIteration(toArchiveHandle(nativeHandle),
                            handle->CookieAddress(), &entry_name, NULL);
   }
 
@@ -143,7 +231,7 @@ static jobject StrictJarFile_nativeFindEntry(JNIEnv* env, jobject, jlong nativeH
   }
 
   ZipEntry data;
-  const int32_t error = FindEntry(reinterpret_cast<ZipArchiveHandle>(nativeHandle),
+  const int32_t error = FindEntry(toArchiveHandle(nativeHandle),
                                   ZipString(entryNameChars.c_str()), &data);
   if (error) {
     return NULL;
@@ -153,7 +241,20 @@ static jobject StrictJarFile_nativeFindEntry(JNIEnv* env, jobject, jlong nativeH
 }
 
 static void StrictJarFile_nativeClose(JNIEnv*, jobject, jlong nativeHandle) {
-  CloseArchive(reinterpret_cast<ZipArchiveHandle>(nativeHandle));
+  JarArchive* archive = reinterpret_cast<JarArchive*>(nativeHandle);
+  std::lock_guard<std::mutex> lock(gArchivesLock);
+  if (--archive->refs > 0) {
+    return;
+  }
+  auto it = std::find(gArchives.begin(), gArchives.end(), archive);
+  if (it == gArchives.end()) {
+    // Not cacheable
+    CloseArchive(archive->handle);
+    delete archive;
+    return;
+  }
+  gArchives.splice(gArchives.begin(), gArchives, it);
+  closeIdleArchives(kMaxIdleArchives);
 }
 
 static JNINativeMethod gMethods[] = {
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <memory>
 
 #include "jni.h"
 #include <nativehelper/JNIHelp.h>
@@ -504,51 +505,44 @@ public:
         return mObserverWeak;
     }
 
+    // Copies the next frame to sink, called from the observer's looper thread
     bool getNextBuffer(JNIEnv* env, jlongArray sink, int* dropCount) {
-        FrameMetricsNotification& elem = mRingBuffer[mNextInQueue];
-
-        if (elem.hasData.load()) {
-            env->SetLongArrayRegion(sink, 0, kBufferSize, elem.buffer);
-            *dropCount = elem.dropCount;
-            mNextInQueue = (mNextInQueue + 1) % kRingSize;
-            elem.hasData = false;
-            return true;
+        if (mReader == nullptr || !mReader->next(*mRing, &mBuffer, dropCount)) {
+            return false;
         }
-
-        return false;
+        env->SetLongArrayRegion(sink, 0, kBufferSize, mBuffer.data());
+        return true;
     }
 
-    virtual void notify(const int64_t* stats) {
-        FrameMetricsNotification& elem = mRingBuffer[mNextFree];
-
-        if (!elem.hasData.load()) {
-            memcpy(elem.buffer, stats, kBufferSize * sizeof(stats[0]));
-
-            elem.dropCount = mDroppedReports;
-            mDroppedReports = 0;
-
-            incStrong(nullptr);
-            mNextFree = (mNextFree + 1) % kRingSize;
-            elem.hasData = true;
+    // Picks up the ring that was current when the message was sent, and allows the next
+    // notify() to send another message. Called from the observer's looper thread before
+    // reading the frames.
+    void startReading() {
+        if (mRing != mPendingRing) {
+            mRing = mPendingRing;
+            mReader.reset(new FrameMetricsRing::Reader(*mRing, mPendingPosition));
+        }
+        mPendingRing.clear();
+        mMessagePending.store(false, std::memory_order_release);
+    }
 
-            mMessageQueue->getLooper()->sendMessage(mMessageHandler, mMessage);
-        } else {
-            mDroppedReports++;
+    // Called on the RenderThread, the frame is only read later on the observer's thread,
+    // batched with any other frame that is published until then
+    virtual void notify(const sp<FrameMetricsRing>& ring, uint64_t position) override {
+        if (mMessagePending.load(std::memory_order_acquire)) {
+            return;
         }
+        // Not touched by the looper thread again until the message is handled
+        mPendingRing = ring;
+        mPendingPosition = position;
+        mMessagePending.store(true, std::memory_order_release);
+
+        incStrong(nullptr);
+        mMessageQueue->getLooper()->sendMessage(mMessageHandler, mMessage);
     }
 
 private:
     static const int kBufferSize = static_cast<int>(FrameInfoIndex::NumIndexes);
-    static constexpr int kRingSize = 3;
-
-    class FrameMetricsNotification {
-    public:
-        FrameMetricsNotification() : hasData(false) {}
-
-        std::atomic_bool hasData;
-        int64_t buffer[kBufferSize];
-        int dropCount = 0;
-    };
 
     JavaVM* const mVm;
     jweak mObserverWeak;
@@ -557,11 +551,14 @@ private:
     sp<NotifyHandler> mMessageHandler;
     Message mMessage;
 
-    int mNextFree = 0;
-    int mNextInQueue = 0;
-    FrameMetricsNotification mRingBuffer[kRingSize];
+    std::atomic_bool mMessagePending { false };
+    sp<FrameMetricsRing> mPendingRing;
+    uint64_t mPendingPosition = 0;
 
-    int mDroppedReports = 0;
+    // Only used from the looper thread
+    sp<FrameMetricsRing> mRing;
+    std::unique_ptr<FrameMetricsRing::Reader> mReader;
+    FrameMetricsData mBuffer;
 };
 
 void NotifyHandler::handleMessage(const Message& message) {
@@ -569,11 +566,13 @@ void NotifyHandler::handleMessage(const Message& message) {
 
     jobject target = env->NewLocalRef(mObserver->getObserverReference());
 
+    mObserver->startReading();
     if (target != nullptr) {
         jlongArray javaBuffer = get_metrics_buffer(env, target);
         int dropCount = 0;
         while (mObserver->getNextBuffer(env, javaBuffer, &dropCount)) {
             env->CallVoidMethod(target, gFrameMetricsObserverClassInfo.callback, dropCount);
+            dropCount = 0;
         }
         env->DeleteLocalRef(target);
     }
@@ -973,7 +972,14 @@ static void android_view_ThreadedRenderer_setupShadersDiskCache(JNIEnv* env, job
         jstring diskCachePath) {
     const char* cacheArray = env->GetStringUTFChars(diskCachePath, NULL);
     android::egl_set_cache_filename(cacheArray);
+    // Linked programs are kept next to the driver's cache of compiled shaders
+    std::string programCachePath(cacheArray);
+    programCachePath.append(".programs");
+    RenderProxy::setupProgramDiskCache(programCachePath.c_str());
     env->ReleaseStringUTFChars(diskCachePath, cacheArray);
+    // This is called while the application is being bound, get the GPU context ready in
+    // parallel now that the program cache can be loaded with it
+    RenderProxy::preload();
 }
 
 // ----------------------------------------------------------------------------
@@ -62,23 +62,40 @@ private:
     int32_t mActivePointerId;
     BitSet32 mCalculatedIdBits;
     Velocity mCalculatedVelocity[MAX_POINTERS];
+
+    // Set while mCalculatedVelocity matches the movements and the arguments below. Nested
+    // scrolling views often all compute the velocity of the same gesture.
+    bool mCalculatedVelocityValid;
+    int32_t mCalculatedUnits;
+    float mCalculatedMaxVelocity;
 };
 
 VelocityTrackerState::VelocityTrackerState(const char* strategy) :
-        mVelocityTracker(strategy), mActivePointerId(-1) {
+        mVelocityTracker(strategy), mActivePointerId(-1), mCalculatedVelocityValid(false),
+        mCalculatedUnits(0), mCalculatedMaxVelocity(0) {
 }
 
 void VelocityTrackerState::clear() {
     mVelocityTracker.clear();
     mActivePointerId = -1;
     mCalculatedIdBits.clear();
+    mCalculatedVelocityValid = false;
 }
 
 void VelocityTrackerState::addMovement(const MotionEvent* event) {
     mVelocityTracker.addMovement(event);
+    mCalculatedVelocityValid = false;
 }
 
 void VelocityTrackerState::computeCurrentVelocity(int32_t units, float maxVelocity) {
+    if (mCalculatedVelocityValid && mCalculatedUnits == units
+            && mCalculatedMaxVelocity == maxVelocity) {
+        return;
+    }
+    mCalculatedVelocityValid = true;
+    mCalculatedUnits = units;
+    mCalculatedMaxVelocity = maxVelocity;
+
     BitSet32 idBits(mVelocityTracker.getCurrentPointerIdBits());
     mCalculatedIdBits = idBits;
 
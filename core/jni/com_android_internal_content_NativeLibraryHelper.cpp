@@ -36,7 +36,12 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #define APK_LIB "lib/"
 #define APK_LIB_LEN (sizeof(APK_LIB) - 1)
@@ -52,6 +57,9 @@
 #define TMP_FILE_PATTERN "/tmp.XXXXXX"
 #define TMP_FILE_PATTERN_LEN (sizeof(TMP_FILE_PATTERN) - 1)
 
+// Extraction is mostly inflate and CRC work, spread it over a few cores only
+#define MAX_EXTRACT_THREADS 4
+
 namespace android {
 
 // These match PackageManager.java install codes
@@ -165,33 +173,49 @@ sumFiles(JNIEnv*, void* arg, ZipFileRO* zipFile, ZipEntryRO zipEntry, const char
 }
 
 /*
- * Copy the native library if needed.
- *
- * This function assumes the library and path names passed in are considered safe.
+ * A library of the requested ABI that has to be copied out of the APK, unless an identical
+ * copy already exists.
  */
-static install_status_t
-copyFileIfChanged(JNIEnv *env, void* arg, ZipFileRO* zipFile, ZipEntryRO zipEntry, const char* fileName)
-{
-    void** args = reinterpret_cast<void**>(arg);
-    jstring* javaNativeLibPath = (jstring*) args[0];
-    jboolean extractNativeLibs = *(jboolean*) args[1];
-    jboolean hasNativeBridge = *(jboolean*) args[2];
+struct LibraryToCopy {
+    ZipEntryRO entry;
+    std::string fileName;
+    install_status_t status;
+};
 
-    ScopedUtfChars nativeLibPath(env, *javaNativeLibPath);
+struct CopyNativeBinariesArgs {
+    ZipFileRO* zipFile;
+    const char* nativeLibPath;
+    const char* cpuAbi;
+    bool extractNativeLibs;
+    bool hasNativeBridge;
+    std::vector<LibraryToCopy> libraries;
+
+    ~CopyNativeBinariesArgs() {
+        for (const LibraryToCopy& library : libraries) {
+            zipFile->releaseEntry(library.entry);
+        }
+    }
+};
 
-    uint32_t uncompLen;
-    uint32_t when;
-    uint32_t crc;
+/*
+ * Checks whether the native library can be used in place, and queues it for copying if it
+ * can't or if a copy is needed anyway.
+ */
+static install_status_t
+collectLibraryToCopy(JNIEnv*, void* arg, ZipFileRO* zipFile, ZipEntryRO zipEntry,
+        const char* fileName)
+{
+    CopyNativeBinariesArgs* args = reinterpret_cast<CopyNativeBinariesArgs*>(arg);
 
     uint16_t method;
     off64_t offset;
 
-    if (!zipFile->getEntryInfo(zipEntry, &method, &uncompLen, NULL, &offset, &when, &crc)) {
+    if (!zipFile->getEntryInfo(zipEntry, &method, NULL, NULL, &offset, NULL, NULL)) {
         ALOGD("Couldn't read zip entry info\n");
         return INSTALL_FAILED_INVALID_APK;
     }
 
-    if (!extractNativeLibs) {
+    if (!args->extractNativeLibs) {
         // check if library is uncompressed and page-aligned
         if (method != ZipFileRO::kCompressStored) {
             ALOGD("Library '%s' is compressed - will not be able to open it directly from apk.\n",
@@ -205,24 +229,55 @@ copyFileIfChanged(JNIEnv *env, void* arg, ZipFileRO* zipFile, ZipEntryRO zipEntr
             return INSTALL_FAILED_INVALID_APK;
         }
 
-        if (!hasNativeBridge) {
+        if (!args->hasNativeBridge) {
           return INSTALL_SUCCEEDED;
         }
     }
 
+    // The iteration reuses zipEntry, look up one that outlives it
+    std::string entryName = std::string(APK_LIB) + args->cpuAbi + "/" + fileName;
+    ZipEntryRO entry = zipFile->findEntryByName(entryName.c_str());
+    if (entry == NULL) {
+        return INSTALL_FAILED_INVALID_APK;
+    }
+    args->libraries.push_back({ entry, fileName, INSTALL_SUCCEEDED });
+    return INSTALL_SUCCEEDED;
+}
+
+/*
+ * Copy the native library if needed.
+ *
+ * This function assumes the library and path names passed in are considered safe. It may be
+ * called for several libraries of the same APK concurrently.
+ */
+static install_status_t
+copyFileIfChanged(ZipFileRO* zipFile, ZipEntryRO zipEntry, const char* fileName,
+        const char* nativeLibPath)
+{
+    const size_t nativeLibPathLen = strlen(nativeLibPath);
+
+    uint32_t uncompLen;
+    uint32_t when;
+    uint32_t crc;
+
+    if (!zipFile->getEntryInfo(zipEntry, NULL, &uncompLen, NULL, NULL, &when, &crc)) {
+        ALOGD("Couldn't read zip entry info\n");
+        return INSTALL_FAILED_INVALID_APK;
+    }
+
     // Build local file path
     const size_t fileNameLen = strlen(fileName);
-    char localFileName[nativeLibPath.size() + fileNameLen + 2];
+    char localFileName[nativeLibPathLen + fileNameLen + 2];
 
-    if (strlcpy(localFileName, nativeLibPath.c_str(), sizeof(localFileName)) != nativeLibPath.size()) {
+    if (strlcpy(localFileName, nativeLibPath, sizeof(localFileName)) != nativeLibPathLen) {
         ALOGD("Couldn't allocate local file name for library");
         return INSTALL_FAILED_INTERNAL_ERROR;
     }
 
-    *(localFileName + nativeLibPath.size()) = '/';
+    *(localFileName + nativeLibPathLen) = '/';
 
-    if (strlcpy(localFileName + nativeLibPath.size() + 1, fileName, sizeof(localFileName)
-                    - nativeLibPath.size() - 1) != fileNameLen) {
+    if (strlcpy(localFileName + nativeLibPathLen + 1, fileName, sizeof(localFileName)
+                    - nativeLibPathLen - 1) != fileNameLen) {
         ALOGD("Couldn't allocate local file name for library");
         return INSTALL_FAILED_INTERNAL_ERROR;
     }
@@ -236,17 +291,17 @@ copyFileIfChanged(JNIEnv *env, void* arg, ZipFileRO* zipFile, ZipEntryRO zipEntr
         return INSTALL_SUCCEEDED;
     }
 
-    char localTmpFileName[nativeLibPath.size() + TMP_FILE_PATTERN_LEN + 2];
-    if (strlcpy(localTmpFileName, nativeLibPath.c_str(), sizeof(localTmpFileName))
-            != nativeLibPath.size()) {
+    char localTmpFileName[nativeLibPathLen + TMP_FILE_PATTERN_LEN + 2];
+    if (strlcpy(localTmpFileName, nativeLibPath, sizeof(localTmpFileName))
+            != nativeLibPathLen) {
         ALOGD("Couldn't allocate local file name for library");
         return INSTALL_FAILED_INTERNAL_ERROR;
     }
 
-    *(localTmpFileName + nativeLibPath.size()) = '/';
+    *(localTmpFileName + nativeLibPathLen) = '/';
 
-    if (strlcpy(localTmpFileName + nativeLibPath.size(), TMP_FILE_PATTERN,
-                    TMP_FILE_PATTERN_LEN - nativeLibPath.size()) != TMP_FILE_PATTERN_LEN) {
+    if (strlcpy(localTmpFileName + nativeLibPathLen, TMP_FILE_PATTERN,
+                    TMP_FILE_PATTERN_LEN - nativeLibPathLen) != TMP_FILE_PATTERN_LEN) {
         ALOGI("Couldn't allocate temporary file name for library");
         return INSTALL_FAILED_INTERNAL_ERROR;
     }
@@ -297,6 +352,48 @@ copyFileIfChanged(JNIEnv *env, void* arg, ZipFileRO* zipFile, ZipEntryRO zipEntr
     return INSTALL_SUCCEEDED;
 }
 
+/*
+ * Copies the libraries on a few threads. Returns the status of the first library in APK
+ * order that failed to copy, libraries after a failure may not be attempted.
+ */
+static install_status_t
+copyLibraries(ZipFileRO* zipFile, std::vector<LibraryToCopy>& libraries, const char* nativeLibPath)
+{
+    std::atomic<size_t> nextLibrary(0);
+    std::atomic<bool> failed(false);
+    auto copyFiles = [&]() {
+        size_t i;
+        while (!failed && (i = nextLibrary++) < libraries.size()) {
+            LibraryToCopy& library = libraries[i];
+            library.status = copyFileIfChanged(zipFile, library.entry, library.fileName.c_str(),
+                    nativeLibPath);
+            if (library.status != INSTALL_SUCCEEDED) {
+                failed = true;
+            }
+        }
+    };
+
+    unsigned maxThreads = std::min<unsigned>(std::thread::hardware_concurrency(),
+            MAX_EXTRACT_THREADS);
+    size_t numThreads = std::min<size_t>(libraries.size(), std::max(maxThreads, 1u));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++) {
+        threads.emplace_back(copyFiles);
+    }
+    copyFiles();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (const LibraryToCopy& library : libraries) {
+        if (library.status != INSTALL_SUCCEEDED) {
+            ALOGV("Failure for entry %s", library.fileName.c_str());
+            return library.status;
+        }
+    }
+    return INSTALL_SUCCEEDED;
+}
+
 /*
  * An iterator over all shared libraries in a zip file. An entry is
  * considered to be a shared library if all of the conditions below are
@@ -492,9 +589,28 @@ com_android_internal_content_NativeLibraryHelper_copyNativeBinaries(JNIEnv *env,
         jlong apkHandle, jstring javaNativeLibPath, jstring javaCpuAbi,
         jboolean extractNativeLibs, jboolean hasNativeBridge, jboolean debuggable)
 {
-    void* args[] = { &javaNativeLibPath, &extractNativeLibs, &hasNativeBridge };
-    return (jint) iterateOverNativeFiles(env, apkHandle, javaCpuAbi, debuggable,
-            copyFileIfChanged, reinterpret_cast<void*>(args));
+    ZipFileRO* zipFile = reinterpret_cast<ZipFileRO*>(apkHandle);
+    if (zipFile == NULL) {
+        return INSTALL_FAILED_INVALID_APK;
+    }
+    ScopedUtfChars nativeLibPath(env, javaNativeLibPath);
+    ScopedUtfChars cpuAbi(env, javaCpuAbi);
+    if (nativeLibPath.c_str() == NULL || cpuAbi.c_str() == NULL) {
+        return INSTALL_FAILED_INTERNAL_ERROR;
+    }
+
+    CopyNativeBinariesArgs args;
+    args.zipFile = zipFile;
+    args.nativeLibPath = nativeLibPath.c_str();
+    args.cpuAbi = cpuAbi.c_str();
+    args.extractNativeLibs = extractNativeLibs;
+    args.hasNativeBridge = hasNativeBridge;
+    install_status_t ret = iterateOverNativeFiles(env, apkHandle, javaCpuAbi, debuggable,
+            collectLibraryToCopy, &args);
+    if (ret != INSTALL_SUCCEEDED) {
+        return (jint) ret;
+    }
+    return (jint) copyLibraries(zipFile, args.libraries, args.nativeLibPath);
 }
 
 static jlong
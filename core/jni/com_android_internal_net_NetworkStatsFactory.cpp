@@ -21,12 +21,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <memory>
+
 #include <core_jni_helpers.h>
 #include <jni.h>
 
 #include <ScopedUtfChars.h>
 #include <ScopedLocalRef.h>
-#include <ScopedPrimitiveArray.h>
 
 #include <utils/Log.h>
 #include <utils/misc.h>
@@ -36,6 +37,9 @@ namespace android {
 
 static jclass gStringClass;
 
+// Distinct ifaces whose String is shared by all their rows, the others get one per row
+static const size_t MAX_CACHED_IFACES = 32;
+
 static struct {
     jfieldID size;
     jfieldID capacity;
@@ -96,6 +100,30 @@ static jlongArray get_long_array(JNIEnv* env, jobject obj, jfieldID field, int s
     return env->NewLongArray(size);
 }
 
+/*
+ * Parses the unsigned decimal number at *pos, which sscanf used to do for most of the
+ * runtime of a poll. Leading spaces are skipped, and *pos is left right after the number.
+ */
+template<typename T>
+static bool parseUnsigned(char** pos, T* out)
+{
+    char* p = *pos;
+    while (*p == ' ') {
+        p++;
+    }
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+    uint64_t value = 0;
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    *out = static_cast<T>(value);
+    *pos = p;
+    return true;
+}
+
 static int readNetworkStatsDetail(JNIEnv* env, jclass clazz, jobject stats,
         jstring path, jint limitUid, jobjectArray limitIfacesObj, jint limitTag) {
     ScopedUtfChars path8(env, path);
@@ -190,7 +218,9 @@ static int readNetworkStatsDetail(JNIEnv* env, jclass clazz, jobject stats,
         if (endPos - pos == 3) {
             rawTag = 0;
         } else {
-            if (sscanf(pos, "%" PRIx64, &rawTag) != 1) {
+            char* tagEnd;
+            rawTag = strtoull(pos, &tagEnd, 16);
+            if (tagEnd == pos) {
                 ALOGE("bad tag: %s", pos);
                 fclose(fp);
                 return -1;
@@ -207,9 +237,9 @@ static int readNetworkStatsDetail(JNIEnv* env, jclass clazz, jobject stats,
         while (*pos == ' ') pos++;
 
         // Parse remaining fields.
-        if (sscanf(pos, "%u %u %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64,
-                &s.uid, &s.set, &s.rxBytes, &s.rxPackets,
-                &s.txBytes, &s.txPackets) == 6) {
+        if (parseUnsigned(&pos, &s.uid) && parseUnsigned(&pos, &s.set)
+                && parseUnsigned(&pos, &s.rxBytes) && parseUnsigned(&pos, &s.rxPackets)
+                && parseUnsigned(&pos, &s.txBytes) && parseUnsigned(&pos, &s.txPackets)) {
             if (limitUid != -1 && limitUid != s.uid) {
                 //ALOGI("skipping due to uid: %s", buffer);
                 continue;
@@ -226,70 +256,110 @@ static int readNetworkStatsDetail(JNIEnv* env, jclass clazz, jobject stats,
     }
 
     int size = lines.size();
-    bool grow = size > env->GetIntField(stats, gNetworkStatsClassInfo.capacity);
+    int capacity = env->GetIntField(stats, gNetworkStatsClassInfo.capacity);
+    bool grow = size > capacity;
+    if (grow) {
+        // Leave room for the rows that appear between polls
+        capacity = size + size / 4;
+    }
 
     ScopedLocalRef<jobjectArray> iface(env, get_string_array(env, stats,
-            gNetworkStatsClassInfo.iface, size, grow));
+            gNetworkStatsClassInfo.iface, capacity, grow));
     if (iface.get() == NULL) return -1;
-    ScopedIntArrayRW uid(env, get_int_array(env, stats,
-            gNetworkStatsClassInfo.uid, size, grow));
+    ScopedLocalRef<jintArray> uid(env, get_int_array(env, stats,
+            gNetworkStatsClassInfo.uid, capacity, grow));
     if (uid.get() == NULL) return -1;
-    ScopedIntArrayRW set(env, get_int_array(env, stats,
-            gNetworkStatsClassInfo.set, size, grow));
+    ScopedLocalRef<jintArray> set(env, get_int_array(env, stats,
+            gNetworkStatsClassInfo.set, capacity, grow));
     if (set.get() == NULL) return -1;
-    ScopedIntArrayRW tag(env, get_int_array(env, stats,
-            gNetworkStatsClassInfo.tag, size, grow));
+    ScopedLocalRef<jintArray> tag(env, get_int_array(env, stats,
+            gNetworkStatsClassInfo.tag, capacity, grow));
     if (tag.get() == NULL) return -1;
-    ScopedIntArrayRW metered(env, get_int_array(env, stats,
-            gNetworkStatsClassInfo.metered, size, grow));
+    ScopedLocalRef<jintArray> metered(env, get_int_array(env, stats,
+            gNetworkStatsClassInfo.metered, capacity, grow));
     if (metered.get() == NULL) return -1;
-    ScopedIntArrayRW roaming(env, get_int_array(env, stats,
-            gNetworkStatsClassInfo.roaming, size, grow));
+    ScopedLocalRef<jintArray> roaming(env, get_int_array(env, stats,
+            gNetworkStatsClassInfo.roaming, capacity, grow));
     if (roaming.get() == NULL) return -1;
-    ScopedLongArrayRW rxBytes(env, get_long_array(env, stats,
-            gNetworkStatsClassInfo.rxBytes, size, grow));
+    ScopedLocalRef<jlongArray> rxBytes(env, get_long_array(env, stats,
+            gNetworkStatsClassInfo.rxBytes, capacity, grow));
     if (rxBytes.get() == NULL) return -1;
-    ScopedLongArrayRW rxPackets(env, get_long_array(env, stats,
-            gNetworkStatsClassInfo.rxPackets, size, grow));
+    ScopedLocalRef<jlongArray> rxPackets(env, get_long_array(env, stats,
+            gNetworkStatsClassInfo.rxPackets, capacity, grow));
     if (rxPackets.get() == NULL) return -1;
-    ScopedLongArrayRW txBytes(env, get_long_array(env, stats,
-            gNetworkStatsClassInfo.txBytes, size, grow));
+    ScopedLocalRef<jlongArray> txBytes(env, get_long_array(env, stats,
+            gNetworkStatsClassInfo.txBytes, capacity, grow));
     if (txBytes.get() == NULL) return -1;
-    ScopedLongArrayRW txPackets(env, get_long_array(env, stats,
-            gNetworkStatsClassInfo.txPackets, size, grow));
+    ScopedLocalRef<jlongArray> txPackets(env, get_long_array(env, stats,
+            gNetworkStatsClassInfo.txPackets, capacity, grow));
     if (txPackets.get() == NULL) return -1;
-    ScopedLongArrayRW operations(env, get_long_array(env, stats,
-            gNetworkStatsClassInfo.operations, size, grow));
+    ScopedLocalRef<jlongArray> operations(env, get_long_array(env, stats,
+            gNetworkStatsClassInfo.operations, capacity, grow));
     if (operations.get() == NULL) return -1;
 
+    // Rows share a handful of ifaces, create one String for each of them
+    Vector<const char*> ifaceNames;
+    Vector<jstring> ifaceStrings;
+    std::unique_ptr<jint[]> ints(new jint[size]);
+    std::unique_ptr<jlong[]> longs(new jlong[size]);
     for (int i = 0; i < size; i++) {
-        ScopedLocalRef<jstring> ifaceString(env, env->NewStringUTF(lines[i].iface));
-        env->SetObjectArrayElement(iface.get(), i, ifaceString.get());
-
-        uid[i] = lines[i].uid;
-        set[i] = lines[i].set;
-        tag[i] = lines[i].tag;
-        // Metered and Roaming are populated in Java-land by inspecting the iface properties.
-        rxBytes[i] = lines[i].rxBytes;
-        rxPackets[i] = lines[i].rxPackets;
-        txBytes[i] = lines[i].txBytes;
-        txPackets[i] = lines[i].txPackets;
+        jstring ifaceString = NULL;
+        for (size_t j = 0; j < ifaceNames.size(); j++) {
+            if (!strcmp(ifaceNames[j], lines[i].iface)) {
+                ifaceString = ifaceStrings[j];
+                break;
+            }
+        }
+        bool cached = ifaceString != NULL;
+        if (!cached) {
+            ifaceString = env->NewStringUTF(lines[i].iface);
+            if (ifaceString == NULL) return -1;
+            cached = ifaceNames.size() < MAX_CACHED_IFACES;
+            if (cached) {
+                ifaceNames.add(lines[i].iface);
+                ifaceStrings.add(ifaceString);
+            }
+        }
+        env->SetObjectArrayElement(iface.get(), i, ifaceString);
+        if (!cached) {
+            env->DeleteLocalRef(ifaceString);
+        }
     }
+    for (size_t j = 0; j < ifaceStrings.size(); j++) {
+        env->DeleteLocalRef(ifaceStrings[j]);
+    }
+
+    // Only the rows read are written, each column straight from a native copy.
+    // Metered and Roaming are populated in Java-land by inspecting the iface properties.
+    for (int i = 0; i < size; i++) ints[i] = lines[i].uid;
+    env->SetIntArrayRegion(uid.get(), 0, size, ints.get());
+    for (int i = 0; i < size; i++) ints[i] = lines[i].set;
+    env->SetIntArrayRegion(set.get(), 0, size, ints.get());
+    for (int i = 0; i < size; i++) ints[i] = lines[i].tag;
+    env->SetIntArrayRegion(tag.get(), 0, size, ints.get());
+    for (int i = 0; i < size; i++) longs[i] = lines[i].rxBytes;
+    env->SetLongArrayRegion(rxBytes.get(), 0, size, longs.get());
+    for (int i = 0; i < size; i++) longs[i] = lines[i].rxPackets;
+    env->SetLongArrayRegion(rxPackets.get(), 0, size, longs.get());
+    for (int i = 0; i < size; i++) longs[i] = lines[i].txBytes;
+    env->SetLongArrayRegion(txBytes.get(), 0, size, longs.get());
+    for (int i = 0; i < size; i++) longs[i] = lines[i].txPackets;
+    env->SetLongArrayRegion(txPackets.get(), 0, size, longs.get());
 
     env->SetIntField(stats, gNetworkStatsClassInfo.size, size);
     if (grow) {
-        env->SetIntField(stats, gNetworkStatsClassInfo.capacity, size);
+        env->SetIntField(stats, gNetworkStatsClassInfo.capacity, capacity);
         env->SetObjectField(stats, gNetworkStatsClassInfo.iface, iface.get());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.uid, uid.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.set, set.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.tag, tag.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.metered, metered.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.roaming, roaming.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.rxBytes, rxBytes.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.rxPackets, rxPackets.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.txBytes, txBytes.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.txPackets, txPackets.getJavaArray());
-        env->SetObjectField(stats, gNetworkStatsClassInfo.operations, operations.getJavaArray());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.uid, uid.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.set, set.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.tag, tag.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.metered, metered.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.roaming, roaming.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.rxBytes, rxBytes.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.rxPackets, rxPackets.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.txBytes, txBytes.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.txPackets, txPackets.get());
+        env->SetObjectField(stats, gNetworkStatsClassInfo.operations, operations.get());
     }
 
     return 0;
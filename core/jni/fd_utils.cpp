@@ -143,7 +143,8 @@ FileDescriptorInfo* FileDescriptorInfo::CreateFromFd(int fd) {
       return NULL;
     }
 
-    return new FileDescriptorInfo(fd);
+    // Keep the stat so that Restat() recognizes the socket on later forks
+    return new FileDescriptorInfo(f_stat, fd);
   }
 
   // We only handle whitelisted regular files and character devices. Whitelisted
@@ -229,34 +230,34 @@ bool FileDescriptorInfo::ReopenOrDetach() const {
   // NOTE: This might happen if the file was unlinked after being opened.
   // It's a common pattern in the case of temporary files and the like but
   // we should not allow such usage from the zygote.
-  const int new_fd = TEMP_FAILURE_RETRY(open(file_path.c_str(), open_flags));
+  //
+  // This runs in every child before it starts, so skip the calls that would
+  // leave the description as open() created it. The descriptor flags only
+  // consist of FD_CLOEXEC, which dup3 sets on |fd| itself: dup2 would clear it.
+  const int new_fd = TEMP_FAILURE_RETRY(open(file_path.c_str(), open_flags | O_CLOEXEC));
 
   if (new_fd == -1) {
     PLOG(ERROR) << "Failed open(" << file_path << ", " << open_flags << ")";
     return false;
   }
 
-  if (TEMP_FAILURE_RETRY(fcntl(new_fd, F_SETFD, fd_flags)) == -1) {
-    close(new_fd);
-    PLOG(ERROR) << "Failed fcntl(" << new_fd << ", F_SETFD, " << fd_flags << ")";
-    return false;
-  }
-
-  if (TEMP_FAILURE_RETRY(fcntl(new_fd, F_SETFL, fs_flags)) == -1) {
+  if ((fs_flags & ~O_LARGEFILE) != 0
+      && TEMP_FAILURE_RETRY(fcntl(new_fd, F_SETFL, fs_flags)) == -1) {
     close(new_fd);
     PLOG(ERROR) << "Failed fcntl(" << new_fd << ", F_SETFL, " << fs_flags << ")";
     return false;
   }
 
-  if (offset != -1 && TEMP_FAILURE_RETRY(lseek64(new_fd, offset, SEEK_SET)) == -1) {
+  if (offset > 0 && TEMP_FAILURE_RETRY(lseek64(new_fd, offset, SEEK_SET)) == -1) {
     close(new_fd);
     PLOG(ERROR) << "Failed lseek64(" << new_fd << ", SEEK_SET)";
     return false;
   }
 
-  if (TEMP_FAILURE_RETRY(dup2(new_fd, fd)) == -1) {
+  const int dup_flags = (fd_flags & FD_CLOEXEC) ? O_CLOEXEC : 0;
+  if (TEMP_FAILURE_RETRY(dup3(new_fd, fd, dup_flags)) == -1) {
     close(new_fd);
-    PLOG(ERROR) << "Failed dup2(" << fd << ", " << new_fd << ")";
+    PLOG(ERROR) << "Failed dup3(" << fd << ", " << new_fd << ")";
     return false;
   }
 
@@ -265,9 +266,9 @@ bool FileDescriptorInfo::ReopenOrDetach() const {
   return true;
 }
 
-FileDescriptorInfo::FileDescriptorInfo(int fd) :
+FileDescriptorInfo::FileDescriptorInfo(struct stat stat, int fd) :
   fd(fd),
-  stat(),
+  stat(stat),
   open_flags(0),
   fd_flags(0),
   fs_flags(0),
@@ -21,34 +21,83 @@
 
 #include "EphemeralStorage.h"
 
+#include <cstddef>
+#include <new>
+
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
 
 namespace android {
 
-EphemeralStorage::EphemeralStorage() {
+EphemeralStorage::EphemeralStorage()
+    : mSlabsUsed(0),
+      mSlabOffset(0) {
 }
 
 EphemeralStorage::~EphemeralStorage() {
     CHECK(mItems.empty())
         << "All item storage should have been released by now.";
+
+    for (void *slab : mSlabs) {
+        free(slab);
+    }
+}
+
+void *EphemeralStorage::allocFromSlab(size_t size) {
+    const size_t kAlignment = alignof(std::max_align_t);
+    size = (size + kAlignment - 1) & ~(kAlignment - 1);
+
+    // Leave larger allocations to malloc rather than wasting most of a slab
+    if (size > kSlabSize / 4) {
+        return NULL;
+    }
+
+    if (mSlabsUsed == 0 || mSlabOffset + size > kSlabSize) {
+        if (mSlabsUsed == mSlabs.size()) {
+            void *slab = malloc(kSlabSize);
+            if (slab == NULL) {
+                return NULL;
+            }
+            mSlabs.push_back(slab);
+        }
+        mSlabsUsed++;
+        mSlabOffset = 0;
+    }
+
+    void *ptr = static_cast<uint8_t *>(mSlabs[mSlabsUsed - 1]) + mSlabOffset;
+    mSlabOffset += size;
+
+    return ptr;
 }
 
 hidl_string *EphemeralStorage::allocStringArray(size_t size) {
+    hidl_string *strings = static_cast<hidl_string *>(
+            allocTemporaryStorage(size * sizeof(hidl_string)));
+    for (size_t i = 0; i < size; ++i) {
+        new (&strings[i]) hidl_string;
+    }
+
     Item item;
     item.mType = TYPE_STRING_ARRAY;
     item.mObj = NULL;
-    item.mPtr = new hidl_string[size];
+    item.mPtr = strings;
+    item.mSize = size;
     mItems.push_back(item);
 
     return static_cast<hidl_string *>(item.mPtr);
 }
 
 void *EphemeralStorage::allocTemporaryStorage(size_t size) {
+    void *ptr = allocFromSlab(size);
+    if (ptr != NULL) {
+        return ptr;
+    }
+
     Item item;
     item.mType = TYPE_STORAGE;
     item.mObj = NULL;
     item.mPtr = malloc(size);
+    item.mSize = size;
     mItems.push_back(item);
 
     return item.mPtr;
@@ -63,6 +112,7 @@ const hidl_string *EphemeralStorage::allocTemporaryString(
     item.mType = TYPE_STRING;
     item.mObj = obj;
     item.mPtr = (void *)val;
+    item.mSize = 0;
     mItems.push_back(item);
 
     hidl_string *s = allocStringArray(1 /* size */);
@@ -82,6 +132,7 @@ const hidl_vec<Type> *EphemeralStorage::allocTemporary ## Suffix ## Vector(    \
     item.mType = TYPE_ ## Suffix ## _ARRAY;                                    \
     item.mObj = obj;                                                           \
     item.mPtr = (void *)val;                                                   \
+    item.mSize = len;                                                          \
     mItems.push_back(item);                                                    \
                                                                                \
     void *vecPtr = allocTemporaryStorage(sizeof(hidl_vec<Type>));              \
@@ -105,7 +156,7 @@ DEFINE_ALLOC_VECTOR_METHODS(Double,jdouble,Double)
                 env->Release ## NewType ## ArrayElements(                      \
                         (Type ## Array)item.mObj,                              \
                         (Type *)item.mPtr,                                     \
-                        0 /* mode */);                                         \
+                        JNI_ABORT /* mode */);                                 \
                                                                                \
                 env->DeleteGlobalRef(item.mObj);                               \
                 break;                                                         \
@@ -118,7 +169,12 @@ void EphemeralStorage::release(JNIEnv *env) {
         switch (item.mType) {
             case TYPE_STRING_ARRAY:
             {
-                delete[] static_cast<hidl_string *>(item.mPtr);
+                // The storage itself is released with the slabs or with
+                // its own TYPE_STORAGE item, which precedes this one
+                hidl_string *strings = static_cast<hidl_string *>(item.mPtr);
+                for (size_t j = 0; j < item.mSize; ++j) {
+                    strings[j].~hidl_string();
+                }
                 break;
             }
 
@@ -150,6 +206,9 @@ void EphemeralStorage::release(JNIEnv *env) {
     }
 
     mItems.clear();
+
+    mSlabsUsed = 0;
+    mSlabOffset = 0;
 }
 
 }  // namespace android
@@ -21,7 +21,8 @@
 #include <android-base/macros.h>
 #include <hidl/HidlSupport.h>
 #include <jni.h>
-#include <utils/Vector.h>
+
+#include <vector>
 
 namespace android {
 
@@ -51,6 +52,12 @@ struct EphemeralStorage {
     DECLARE_ALLOC_METHODS(Double,jdouble)
 
 private:
+    // Small allocations are carved out of slabs that are kept across
+    // release(), so a parcel reused for many transactions stops allocating
+    static const size_t kSlabSize = 1024;
+
+    void *allocFromSlab(size_t size);
+
     enum Type {
         TYPE_STRING_ARRAY,
         TYPE_STORAGE,
@@ -67,9 +74,14 @@ private:
         Type mType;
         jobject mObj;
         void *mPtr;
+        size_t mSize;
     };
 
-    Vector<Item> mItems;
+    std::vector<Item> mItems;
+
+    std::vector<void *> mSlabs;
+    size_t mSlabsUsed;
+    size_t mSlabOffset;
 
     DISALLOW_COPY_AND_ASSIGN(EphemeralStorage);
 };
@@ -18,9 +18,14 @@
 
 #include "androidfw/ApkAssets.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+
 #include <algorithm>
 
+#include "android-base/file.h"
 #include "android-base/logging.h"
+#include "android-base/unique_fd.h"
 #include "utils/FileMap.h"
 #include "utils/Trace.h"
 #include "ziparchive/zip_archive.h"
@@ -28,19 +33,77 @@
 #include "androidfw/Asset.h"
 #include "androidfw/Util.h"
 
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
 namespace android {
 
+// The maximum number of uncompressed entry mappings kept by each ApkAssets.
+constexpr static size_t kMaxCachedMaps = 32u;
+
 std::unique_ptr<const ApkAssets> ApkAssets::Load(const std::string& path, bool system) {
-  return ApkAssets::LoadImpl(path, system, false /*load_as_shared_library*/);
+  return ApkAssets::LoadImpl(path, {} /*index_path*/, {} /*idmap_map*/, {} /*loaded_idmap*/,
+                             system, false /*load_as_shared_library*/);
 }
 
 std::unique_ptr<const ApkAssets> ApkAssets::LoadAsSharedLibrary(const std::string& path,
                                                                 bool system) {
-  return ApkAssets::LoadImpl(path, system, true /*load_as_shared_library*/);
+  return ApkAssets::LoadImpl(path, {} /*index_path*/, {} /*idmap_map*/, {} /*loaded_idmap*/,
+                             system, true /*load_as_shared_library*/);
+}
+
+std::unique_ptr<const ApkAssets> ApkAssets::LoadWithArscIndex(const std::string& path,
+                                                              const std::string& index_path,
+                                                              bool system) {
+  return ApkAssets::LoadImpl(path, index_path, {} /*idmap_map*/, {} /*loaded_idmap*/, system,
+                             false /*load_as_shared_library*/);
+}
+
+// Maps the entire file at `path` read-only. Returns nullptr if the file can't be mapped.
+static std::unique_ptr<FileMap> MapFile(const std::string& path) {
+  base::unique_fd fd(::open(path.c_str(), O_RDONLY | O_BINARY));
+  if (fd == -1) {
+    return {};
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    return {};
+  }
+
+  std::unique_ptr<FileMap> map = util::make_unique<FileMap>();
+  if (!map->create(path.c_str(), fd, 0, static_cast<size_t>(st.st_size), true /*readOnly*/)) {
+    return {};
+  }
+  return map;
+}
+
+std::unique_ptr<const ApkAssets> ApkAssets::LoadOverlay(const std::string& idmap_path,
+                                                        bool system) {
+  ATRACE_CALL();
+  std::unique_ptr<FileMap> idmap_map = MapFile(idmap_path);
+  if (idmap_map == nullptr) {
+    LOG(ERROR) << "Failed to map IDMAP '" << idmap_path << "'.";
+    return {};
+  }
+
+  std::unique_ptr<const LoadedIdmap> loaded_idmap = LoadedIdmap::Load(
+      StringPiece(reinterpret_cast<const char*>(idmap_map->getDataPtr()),
+                  idmap_map->getDataLength()));
+  if (loaded_idmap == nullptr) {
+    LOG(ERROR) << "Failed to load IDMAP '" << idmap_path << "'.";
+    return {};
+  }
+
+  const std::string overlay_path = loaded_idmap->OverlayApkPath();
+  return LoadImpl(overlay_path, {} /*index_path*/, std::move(idmap_map), std::move(loaded_idmap),
+                  system, false /*load_as_shared_library*/);
 }
 
-std::unique_ptr<const ApkAssets> ApkAssets::LoadImpl(const std::string& path, bool system,
-                                                     bool load_as_shared_library) {
+std::unique_ptr<const ApkAssets> ApkAssets::LoadImpl(
+    const std::string& path, const std::string& index_path, std::unique_ptr<FileMap> idmap_map,
+    std::unique_ptr<const LoadedIdmap> loaded_idmap, bool system, bool load_as_shared_library) {
   ATRACE_CALL();
   ::ZipArchiveHandle unmanaged_handle;
   int32_t result = ::OpenArchive(path.c_str(), &unmanaged_handle);
@@ -66,15 +129,37 @@ std::unique_ptr<const ApkAssets> ApkAssets::LoadImpl(const std::string& path, bo
   }
 
   loaded_apk->path_ = path;
+  loaded_apk->resources_crc32_ = entry.crc32;
+  loaded_apk->idmap_map_ = std::move(idmap_map);
+  loaded_apk->loaded_idmap_ = std::move(loaded_idmap);
   loaded_apk->resources_asset_ =
       loaded_apk->Open("resources.arsc", Asset::AccessMode::ACCESS_BUFFER);
   if (loaded_apk->resources_asset_ == nullptr) {
     return {};
   }
 
-  loaded_apk->loaded_arsc_ =
-      LoadedArsc::Load(loaded_apk->resources_asset_->getBuffer(true /*wordAligned*/),
-                       loaded_apk->resources_asset_->getLength(), system, load_as_shared_library);
+  const void* data = loaded_apk->resources_asset_->getBuffer(true /*wordAligned*/);
+  const size_t length = loaded_apk->resources_asset_->getLength();
+  if (!index_path.empty()) {
+    // The index is only needed while building the LoadedArsc, so unmap it right after.
+    std::unique_ptr<FileMap> index_map = MapFile(index_path);
+    if (index_map != nullptr) {
+      loaded_apk->loaded_arsc_ = LoadedArsc::LoadWithIndex(
+          data, length, index_map->getDataPtr(), index_map->getDataLength(), entry.crc32, system,
+          load_as_shared_library);
+    }
+
+    if (loaded_apk->loaded_arsc_ == nullptr) {
+      LOG(WARNING) << "Unusable resource table index '" << index_path << "' for APK '" << path
+                   << "'.";
+    }
+  }
+
+  if (loaded_apk->loaded_arsc_ == nullptr) {
+    loaded_apk->loaded_arsc_ = LoadedArsc::Load(data, length, loaded_apk->loaded_idmap_.get(),
+                                                system, load_as_shared_library);
+  }
+
   if (loaded_apk->loaded_arsc_ == nullptr) {
     return {};
   }
@@ -87,6 +172,14 @@ std::unique_ptr<Asset> ApkAssets::Open(const std::string& path, Asset::AccessMod
   ATRACE_CALL();
   CHECK(zip_handle_ != nullptr);
 
+  {
+    AutoMutex _l(map_cache_lock_);
+    auto cached_iter = map_cache_.find(path);
+    if (cached_iter != map_cache_.end()) {
+      return Asset::createFromSharedUncompressedMap(cached_iter->second, mode);
+    }
+  }
+
   ::ZipString name(path.c_str());
   ::ZipEntry entry;
   int32_t result = ::FindEntry(zip_handle_.get(), name, &entry);
@@ -111,14 +204,29 @@ std::unique_ptr<Asset> ApkAssets::Open(const std::string& path, Asset::AccessMod
     }
     return asset;
   } else {
-    std::unique_ptr<FileMap> map = util::make_unique<FileMap>();
+    std::shared_ptr<FileMap> map = std::make_shared<FileMap>();
     if (!map->create(path_.c_str(), ::GetFileDescriptor(zip_handle_.get()), entry.offset,
                      entry.uncompressed_length, true /*readOnly*/)) {
       LOG(ERROR) << "Failed to mmap file '" << path << "' in APK '" << path_ << "'";
       return {};
     }
 
-    std::unique_ptr<Asset> asset = Asset::createFromUncompressedMap(std::move(map), mode);
+    {
+      AutoMutex _l(map_cache_lock_);
+      auto result = map_cache_.emplace(path, map);
+      if (result.second) {
+        map_cache_order_.push_back(path);
+        if (map_cache_order_.size() > kMaxCachedMaps) {
+          map_cache_.erase(map_cache_order_.front());
+          map_cache_order_.pop_front();
+        }
+      } else {
+        // Another thread mapped the same entry first. Share its mapping.
+        map = result.first->second;
+      }
+    }
+
+    std::unique_ptr<Asset> asset = Asset::createFromSharedUncompressedMap(map, mode);
     if (asset == nullptr) {
       LOG(ERROR) << "Failed to mmap file '" << path << "' in APK '" << path_ << "'";
       return {};
@@ -127,6 +235,21 @@ std::unique_ptr<Asset> ApkAssets::Open(const std::string& path, Asset::AccessMod
   }
 }
 
+bool ApkAssets::WriteArscIndex(const std::string& index_path) const {
+  ATRACE_CALL();
+  std::string index;
+  if (!loaded_arsc_->WriteIndex(resources_crc32_, &index)) {
+    LOG(ERROR) << "Failed to build resource table index for APK '" << path_ << "'.";
+    return false;
+  }
+
+  if (!base::WriteStringToFile(index, index_path)) {
+    PLOG(ERROR) << "Failed to write resource table index '" << index_path << "'";
+    return false;
+  }
+  return true;
+}
+
 bool ApkAssets::ForEachFile(const std::string& root_path,
                             const std::function<void(const StringPiece&, FileType)>& f) const {
   CHECK(zip_handle_ != nullptr);
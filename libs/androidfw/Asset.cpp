@@ -315,6 +315,23 @@ Asset::Asset(void)
     return std::move(pAsset);
 }
 
+/*
+ * Create a new Asset from a memory mapping shared with other assets.
+ */
+/*static*/ std::unique_ptr<Asset> Asset::createFromSharedUncompressedMap(
+    const std::shared_ptr<FileMap>& dataMap, AccessMode mode)
+{
+    std::unique_ptr<_FileAsset> pAsset = util::make_unique<_FileAsset>();
+
+    status_t result = pAsset->openChunk(dataMap);
+    if (result != NO_ERROR) {
+        return NULL;
+    }
+
+    pAsset->mAccessMode = mode;
+    return std::move(pAsset);
+}
+
 /*
  * Create a new Asset from compressed data in a memory mapping.
  */
@@ -481,6 +498,18 @@ status_t _FileAsset::openChunk(FileMap* dataMap)
     return NO_ERROR;
 }
 
+/*
+ * Create the chunk from a map shared with other assets.
+ */
+status_t _FileAsset::openChunk(const std::shared_ptr<FileMap>& dataMap)
+{
+    status_t result = openChunk(dataMap.get());
+    if (result == NO_ERROR) {
+        mSharedMap = dataMap;
+    }
+    return result;
+}
+
 /*
  * Read a chunk of data.
  */
@@ -577,9 +606,12 @@ off64_t _FileAsset::seek(off64_t offset, int whence)
 void _FileAsset::close(void)
 {
     if (mMap != NULL) {
-        delete mMap;
+        if (mSharedMap == nullptr) {
+            delete mMap;
+        }
         mMap = NULL;
     }
+    mSharedMap.reset();
     if (mBuf != NULL) {
         delete[] mBuf;
         mBuf = NULL;
@@ -818,6 +850,11 @@ ssize_t _CompressedAsset::read(void* buf, size_t count)
 
     /* If we're relying on a streaming inflater, go through that */
     if (mZipInflater) {
+        // streaming readers consume the asset front to back, so let the inflater
+        // decode the next window while the caller works through this one
+        if (getAccessMode() == ACCESS_STREAMING) {
+            mZipInflater->setReadAhead(true);
+        }
         actual = mZipInflater->read(buf, count);
     } else {
         if (mBuf == NULL) {
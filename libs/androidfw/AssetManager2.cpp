@@ -18,6 +18,7 @@
 
 #include "androidfw/AssetManager2.h"
 
+#include <algorithm>
 #include <set>
 
 #include "android-base/logging.h"
@@ -41,6 +42,12 @@ bool AssetManager2::SetApkAssets(const std::vector<const ApkAssets*>& apk_assets
                                  bool invalidate_caches) {
   apk_assets_ = apk_assets;
   BuildDynamicRefTable();
+
+  // Cached entries point to the DynamicRefTables that were just rebuilt.
+  for (CacheShard<CachedEntry>& shard : cached_entries_) {
+    AutoMutex _l(shard.lock);
+    shard.map.clear();
+  }
   if (invalidate_caches) {
     InvalidateCaches(static_cast<uint32_t>(-1));
   }
@@ -91,7 +98,13 @@ void AssetManager2::BuildDynamicRefTable() {
   // Now assign the runtime IDs so that we have a build-time to runtime ID map.
   const auto package_groups_end = package_groups_.end();
   for (auto iter = package_groups_.begin(); iter != package_groups_end; ++iter) {
-    const std::string& package_name = iter->packages_[0]->GetPackageName();
+    // Overlays take on the ID of their target, but the group is known by the target's name.
+    auto package_iter = std::find_if(
+        iter->packages_.begin(), iter->packages_.end(),
+        [](const LoadedPackage* package) -> bool { return !package->IsOverlay(); });
+    const LoadedPackage* named_package =
+        package_iter != iter->packages_.end() ? *package_iter : iter->packages_[0];
+    const std::string& package_name = named_package->GetPackageName();
     for (auto iter2 = package_groups_.begin(); iter2 != package_groups_end; ++iter2) {
       iter2->dynamic_ref_table.addMapping(String16(package_name.c_str(), package_name.size()),
                                           iter->dynamic_ref_table.mAssignedPackageId);
@@ -277,6 +290,22 @@ ApkAssetsCookie AssetManager2::FindEntry(uint32_t resid, uint16_t density_overri
     desired_config = &density_override_config;
   }
 
+  // Results for the current configuration are cached. A full search always yields a valid answer
+  // for stop_at_first_match callers, so they share the cache.
+  const bool use_cache = desired_config == &configuration_;
+  if (use_cache) {
+    CacheShard<CachedEntry>& shard = cached_entries_[GetCacheShard(resid)];
+    AutoMutex _l(shard.lock);
+    auto cached_iter = shard.map.find(resid);
+    if (cached_iter != shard.map.end()) {
+      const CachedEntry& cached_entry = cached_iter->second;
+      *out_entry = cached_entry.entry;
+      *out_selected_config = cached_entry.config;
+      *out_flags = cached_entry.flags;
+      return cached_entry.cookie;
+    }
+  }
+
   if (!is_valid_resid(resid)) {
     LOG(ERROR) << base::StringPrintf("Invalid ID 0x%08x.", resid);
     return kInvalidCookie;
@@ -312,7 +341,10 @@ ApkAssetsCookie AssetManager2::FindEntry(uint32_t resid, uint16_t density_overri
 
     cumulated_flags |= current_flags;
 
-    if (best_cookie == kInvalidCookie || current_config.isBetterThan(best_config, desired_config)) {
+    // An overlay replaces the value of an equally specific configuration in the packages loaded
+    // before it.
+    if (best_cookie == kInvalidCookie || current_config.isBetterThan(best_config, desired_config) ||
+        (loaded_package->IsOverlay() && current_config.compare(best_config) == 0)) {
       best_entry = current_entry;
       best_config = current_config;
       best_cookie = package_group.cookies_[i];
@@ -330,6 +362,13 @@ ApkAssetsCookie AssetManager2::FindEntry(uint32_t resid, uint16_t density_overri
   out_entry->dynamic_ref_table = &package_group.dynamic_ref_table;
   *out_selected_config = best_config;
   *out_flags = cumulated_flags;
+
+  // When stopping at the first match, the flags and selection may be incomplete, so don't cache.
+  if (use_cache && !stop_at_first_match) {
+    CacheShard<CachedEntry>& shard = cached_entries_[GetCacheShard(resid)];
+    AutoMutex _l(shard.lock);
+    shard.map[resid] = CachedEntry{*out_entry, best_config, cumulated_flags, best_cookie};
+  }
   return best_cookie;
 }
 
@@ -456,9 +495,13 @@ ApkAssetsCookie AssetManager2::ResolveReference(ApkAssetsCookie cookie, Res_valu
 const ResolvedBag* AssetManager2::GetBag(uint32_t resid) {
   ATRACE_CALL();
 
-  auto cached_iter = cached_bags_.find(resid);
-  if (cached_iter != cached_bags_.end()) {
-    return cached_iter->second.get();
+  {
+    CacheShard<util::unique_cptr<ResolvedBag>>& shard = cached_bags_[GetCacheShard(resid)];
+    AutoMutex _l(shard.lock);
+    auto cached_iter = shard.map.find(resid);
+    if (cached_iter != shard.map.end()) {
+      return cached_iter->second.get();
+    }
   }
 
   LoadedArscEntry entry;
@@ -511,9 +554,7 @@ const ResolvedBag* AssetManager2::GetBag(uint32_t resid) {
     }
     new_bag->type_spec_flags = flags;
     new_bag->entry_count = static_cast<uint32_t>(entry_count);
-    ResolvedBag* result = new_bag.get();
-    cached_bags_[resid] = std::move(new_bag);
-    return result;
+    return PublishBag(resid, std::move(new_bag));
   }
 
   // In case the parent is a dynamic reference, resolve it.
@@ -608,9 +649,17 @@ const ResolvedBag* AssetManager2::GetBag(uint32_t resid) {
   util::unique_cptr<ResolvedBag> final_bag{new_bag};
   final_bag->type_spec_flags = flags;
   final_bag->entry_count = static_cast<uint32_t>(actual_count);
-  ResolvedBag* result = final_bag.get();
-  cached_bags_[resid] = std::move(final_bag);
-  return result;
+  return PublishBag(resid, std::move(final_bag));
+}
+
+const ResolvedBag* AssetManager2::PublishBag(uint32_t resid, util::unique_cptr<ResolvedBag> bag) {
+  CacheShard<util::unique_cptr<ResolvedBag>>& shard = cached_bags_[GetCacheShard(resid)];
+  AutoMutex _l(shard.lock);
+
+  // Another thread may have resolved the same bag in the meantime. Keep the published one,
+  // since callers may already be holding on to it.
+  auto result = shard.map.emplace(resid, std::move(bag));
+  return result.first->second.get();
 }
 
 static bool Utf8ToUtf16(const StringPiece& str, std::u16string* out) {
@@ -682,33 +731,136 @@ uint32_t AssetManager2::GetResourceId(const std::string& resource_name,
 }
 
 void AssetManager2::InvalidateCaches(uint32_t diff) {
+  {
+    // Cached themes are built from bags that may be about to change.
+    AutoMutex _l(theme_cache_lock_);
+    theme_cache_.clear();
+    theme_cache_generation_++;
+  }
+
   if (diff == 0xffffffffu) {
     // Everything must go.
-    cached_bags_.clear();
+    for (CacheShard<util::unique_cptr<ResolvedBag>>& shard : cached_bags_) {
+      AutoMutex _l(shard.lock);
+      shard.map.clear();
+    }
+
+    for (CacheShard<CachedEntry>& shard : cached_entries_) {
+      AutoMutex _l(shard.lock);
+      shard.map.clear();
+    }
     return;
   }
 
   // Be more conservative with what gets purged. Only if the bag has other possible
   // variations with respect to what changed (diff) should we remove it.
-  for (auto iter = cached_bags_.cbegin(); iter != cached_bags_.cend();) {
-    if (diff & iter->second->type_spec_flags) {
-      iter = cached_bags_.erase(iter);
-    } else {
-      ++iter;
+  for (CacheShard<util::unique_cptr<ResolvedBag>>& shard : cached_bags_) {
+    AutoMutex _l(shard.lock);
+    for (auto iter = shard.map.cbegin(); iter != shard.map.cend();) {
+      if (diff & iter->second->type_spec_flags) {
+        iter = shard.map.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  // Entries that don't vary with any of the changed axis are still the best match.
+  for (CacheShard<CachedEntry>& shard : cached_entries_) {
+    AutoMutex _l(shard.lock);
+    for (auto iter = shard.map.cbegin(); iter != shard.map.cend();) {
+      if (diff & iter->second.flags) {
+        iter = shard.map.erase(iter);
+      } else {
+        ++iter;
+      }
     }
   }
 }
 
 std::unique_ptr<Theme> AssetManager2::NewTheme() { return std::unique_ptr<Theme>(new Theme(this)); }
 
+bool AssetManager2::FindCachedTheme(const ThemeStyleKey& key, Theme* out_theme) {
+  AutoMutex _l(theme_cache_lock_);
+  if (out_theme->cache_generation_ != theme_cache_generation_) {
+    return false;
+  }
+
+  auto cached_iter = theme_cache_.find(key);
+  if (cached_iter == theme_cache_.end()) {
+    return false;
+  }
+  out_theme->CopyFrom(*cached_iter->second);
+  return true;
+}
+
+void AssetManager2::CacheTheme(const Theme& theme) {
+  // Bound the number of distinct style sequences that are remembered.
+  constexpr const size_t kMaxCachedThemes = 64u;
+
+  AutoMutex _l(theme_cache_lock_);
+  if (theme.cache_generation_ != theme_cache_generation_ ||
+      theme_cache_.size() >= kMaxCachedThemes) {
+    return;
+  }
+
+  auto result = theme_cache_.emplace(theme.applied_styles_, nullptr);
+  if (result.second) {
+    result.first->second.reset(new Theme(this));
+    result.first->second->CopyFrom(theme);
+  }
+}
+
+std::shared_ptr<Theme::Type> Theme::NewType(uint32_t capacity, const Type* src) {
+  Type* type = reinterpret_cast<Type*>(calloc(sizeof(Type) + (capacity * sizeof(Entry)), 1));
+  if (src != nullptr) {
+    const uint32_t copy_count = std::min(src->entry_count, capacity);
+    type->entry_count = copy_count;
+    memcpy(type->entries, src->entries, copy_count * sizeof(Entry));
+  }
+  type->entry_capacity = capacity;
+  return std::shared_ptr<Type>(type, free);
+}
+
+Theme::Package* Theme::EditPackage(uint32_t package_idx) {
+  std::shared_ptr<Package>& package = packages_[package_idx];
+  if (package == nullptr) {
+    package = std::make_shared<Package>();
+  } else if (package.use_count() > 1) {
+    // Copying a Package only copies the pointers to its Types.
+    package = std::make_shared<Package>(*package);
+  }
+  return package.get();
+}
+
 bool Theme::ApplyStyle(uint32_t resid, bool force) {
   ATRACE_CALL();
 
+  // Themes built from the same sequence of styles are identical, so try to reuse one.
+  const bool cacheable = cache_generation_ == asset_manager_->theme_cache_generation_;
+  if (cacheable) {
+    applied_styles_.emplace_back(resid, force);
+    if (asset_manager_->FindCachedTheme(applied_styles_, this)) {
+      return true;
+    }
+  }
+
   const ResolvedBag* bag = asset_manager_->GetBag(resid);
-  if (bag == nullptr) {
+  if (bag == nullptr || !ApplyBag(bag, force)) {
+    // Nothing was applied, so the key is unchanged.
+    if (cacheable) {
+      applied_styles_.pop_back();
+    }
     return false;
   }
 
+  if (cacheable) {
+    asset_manager_->CacheTheme(*this);
+  }
+  return true;
+}
+
+bool Theme::ApplyBag(const ResolvedBag* bag, bool force) {
   // Merge the flags from this style.
   type_spec_flags_ |= bag->type_spec_flags;
 
@@ -730,19 +882,16 @@ bool Theme::ApplyStyle(uint32_t resid, bool force) {
     const uint32_t type_idx = get_type_id(attr_resid) - 1;
     const uint32_t entry_idx = get_entry_id(attr_resid);
 
-    std::unique_ptr<Package>& package = packages_[package_idx];
-    if (package == nullptr) {
-      package.reset(new Package());
-    }
-
-    util::unique_cptr<Type>& type = package->types[type_idx];
+    Package* package = EditPackage(package_idx);
+    std::shared_ptr<Type>& type = package->types[type_idx];
     if (type == nullptr) {
       // Set the initial capacity to take up a total amount of 1024 bytes.
       constexpr uint32_t kInitialCapacity = (1024u - sizeof(Type)) / sizeof(Entry);
       const uint32_t initial_capacity = std::max(entry_idx, kInitialCapacity);
-      type.reset(
-          reinterpret_cast<Type*>(calloc(sizeof(Type) + (initial_capacity * sizeof(Entry)), 1)));
-      type->entry_capacity = initial_capacity;
+      type = NewType(initial_capacity);
+    } else if (type.use_count() > 1) {
+      // This Type is shared with another Theme, so take a private copy before modifying it.
+      type = NewType(type->entry_capacity, type.get());
     }
 
     // Set the entry_count to include this entry. We will populate
@@ -753,7 +902,7 @@ bool Theme::ApplyStyle(uint32_t resid, bool force) {
     }
   }
 
-  // On the second pass, we will realloc to fit the entry counts
+  // On the second pass, we will resize to fit the entry counts
   // and populate the structures.
   for (auto bag_iter = begin(bag); bag_iter != bag_iter_end; ++bag_iter) {
     const uint32_t attr_resid = bag_iter->key;
@@ -761,19 +910,14 @@ bool Theme::ApplyStyle(uint32_t resid, bool force) {
     const uint32_t type_idx = get_type_id(attr_resid) - 1;
     const uint32_t entry_idx = get_entry_id(attr_resid);
     Package* package = packages_[package_idx].get();
-    util::unique_cptr<Type>& type = package->types[type_idx];
+    std::shared_ptr<Type>& type = package->types[type_idx];
     if (type->entry_count != type->entry_capacity) {
-      // Resize to fit the actual entries that will be included.
-      Type* type_ptr = type.release();
-      type.reset(reinterpret_cast<Type*>(
-          realloc(type_ptr, sizeof(Type) + (type_ptr->entry_count * sizeof(Entry)))));
-      if (type->entry_capacity < type->entry_count) {
-        // Clear the newly allocated memory (which does not get zero initialized).
-        // We need to do this because we |= type_spec_flags.
-        memset(type->entries + type->entry_capacity, 0,
-               sizeof(Entry) * (type->entry_count - type->entry_capacity));
-      }
-      type->entry_capacity = type->entry_count;
+      // Resize to fit the actual entries that will be included. The new memory is zero
+      // initialized, which we need because we |= type_spec_flags.
+      const uint32_t entry_count = type->entry_count;
+      std::shared_ptr<Type> resized_type = NewType(entry_count, type.get());
+      resized_type->entry_count = entry_count;
+      type = std::move(resized_type);
     }
     Entry& entry = type->entries[entry_idx];
     if (force || entry.value.dataType == Res_value::TYPE_NULL) {
@@ -893,9 +1037,18 @@ ApkAssetsCookie Theme::ResolveAttributeReference(ApkAssetsCookie cookie, Res_val
 
 void Theme::Clear() {
   type_spec_flags_ = 0u;
-  for (std::unique_ptr<Package>& package : packages_) {
+  for (std::shared_ptr<Package>& package : packages_) {
     package.reset();
   }
+  applied_styles_.clear();
+  cache_generation_ = asset_manager_->theme_cache_generation_;
+}
+
+void Theme::CopyFrom(const Theme& o) {
+  type_spec_flags_ = o.type_spec_flags_;
+  packages_ = o.packages_;
+  applied_styles_ = o.applied_styles_;
+  cache_generation_ = o.cache_generation_;
 }
 
 bool Theme::SetTo(const Theme& o) {
@@ -907,28 +1060,8 @@ bool Theme::SetTo(const Theme& o) {
     return false;
   }
 
-  type_spec_flags_ = o.type_spec_flags_;
-
-  for (size_t p = 0; p < packages_.size(); p++) {
-    const Package* package = o.packages_[p].get();
-    if (package == nullptr) {
-      packages_[p].reset();
-      continue;
-    }
-
-    for (size_t t = 0; t < package->types.size(); t++) {
-      const Type* type = package->types[t].get();
-      if (type == nullptr) {
-        packages_[p]->types[t].reset();
-        continue;
-      }
-
-      const size_t type_alloc_size = sizeof(Type) + (type->entry_capacity * sizeof(Entry));
-      void* copied_data = malloc(type_alloc_size);
-      memcpy(copied_data, type, type_alloc_size);
-      packages_[p]->types[t].reset(reinterpret_cast<Type*>(copied_data));
-    }
-  }
+  // The Packages and Types are shared, and copied by whichever Theme modifies them first.
+  CopyFrom(o);
   return true;
 }
 
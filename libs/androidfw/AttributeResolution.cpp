@@ -17,6 +17,9 @@
 #include "androidfw/AttributeResolution.h"
 
 #include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <log/log.h>
 
@@ -203,76 +206,76 @@ bool ResolveAttrs(ResTable::Theme* theme, uint32_t def_style_attr,
   return true;
 }
 
-void ApplyStyle(ResTable::Theme* theme, ResXMLParser* xml_parser, uint32_t def_style_attr,
-                uint32_t def_style_res, const uint32_t* attrs, size_t attrs_length,
-                uint32_t* out_values, uint32_t* out_indices) {
-  if (kDebugStyles) {
-    ALOGI("APPLY STYLE: theme=0x%p defStyleAttr=0x%x defStyleRes=0x%x xml=0x%p",
-          theme, def_style_attr, def_style_res, xml_parser);
-  }
-
-  const ResTable& res = theme->getResTable();
-  ResTable_config config;
-  Res_value value;
+// A style bag retrieved from a ResTable while it is locked. The entries remain valid until the
+// table is unlocked.
+struct LockedStyleBag {
+  const ResTable::bag_entry* start = nullptr;
+  const ResTable::bag_entry* end = nullptr;
+  uint32_t type_set_flags = 0;
+};
 
-  int indices_idx = 0;
+static LockedStyleBag GetStyleBagLocked(const ResTable& res, uint32_t resid) {
+  LockedStyleBag bag;
+  ssize_t bag_off = resid != 0 ? res.getBagLocked(resid, &bag.start, &bag.type_set_flags) : -1;
+  bag.end = bag.start + (bag_off >= 0 ? bag_off : 0);
+  return bag;
+}
 
-  // Load default style from attribute, if specified...
-  uint32_t def_style_bag_type_set_flags = 0;
+// Returns the default style resource to use, resolving `def_style_attr` against the theme.
+static uint32_t ResolveDefStyle(ResTable::Theme* theme, uint32_t def_style_attr,
+                                uint32_t def_style_res, uint32_t* out_type_set_flags) {
+  *out_type_set_flags = 0;
   if (def_style_attr != 0) {
     Res_value value;
-    if (theme->getAttribute(def_style_attr, &value,
-                            &def_style_bag_type_set_flags) >= 0) {
+    if (theme->getAttribute(def_style_attr, &value, out_type_set_flags) >= 0) {
       if (value.dataType == Res_value::TYPE_REFERENCE) {
         def_style_res = value.data;
       }
     }
   }
+  return def_style_res;
+}
 
-  // Retrieve the style class associated with the current XML tag.
-  int style = 0;
-  uint32_t style_bag_type_set_flags = 0;
-  if (xml_parser != nullptr) {
-    ssize_t idx = xml_parser->indexOfStyle();
-    if (idx >= 0 && xml_parser->getAttributeValue(idx, &value) >= 0) {
-      if (value.dataType == value.TYPE_ATTRIBUTE) {
-        if (theme->getAttribute(value.data, &value, &style_bag_type_set_flags) < 0) {
-          value.dataType = Res_value::TYPE_NULL;
-        }
-      }
-      if (value.dataType == value.TYPE_REFERENCE) {
-        style = value.data;
+// Returns the style resource referenced by the style="" attribute of the current XML tag, or 0.
+static uint32_t ResolveXmlStyle(ResTable::Theme* theme, ResXMLParser* xml_parser,
+                                uint32_t* out_type_set_flags) {
+  *out_type_set_flags = 0;
+  if (xml_parser == nullptr) {
+    return 0u;
+  }
+
+  Res_value value;
+  ssize_t idx = xml_parser->indexOfStyle();
+  if (idx >= 0 && xml_parser->getAttributeValue(idx, &value) >= 0) {
+    if (value.dataType == value.TYPE_ATTRIBUTE) {
+      if (theme->getAttribute(value.data, &value, out_type_set_flags) < 0) {
+        value.dataType = Res_value::TYPE_NULL;
       }
     }
+    if (value.dataType == value.TYPE_REFERENCE) {
+      return value.data;
+    }
   }
+  return 0u;
+}
 
-  // Now lock down the resource object and start pulling stuff from it.
-  res.lock();
+// Resolves `attrs` for a single XML element. The ResTable backing `theme` must be locked.
+static void ApplyStyleLocked(ResTable::Theme* theme, ResXMLParser* xml_parser,
+                             const LockedStyleBag& def_style_bag, const LockedStyleBag& style_bag,
+                             const uint32_t* attrs, size_t attrs_length, uint32_t* out_values,
+                             uint32_t* out_indices) {
+  const ResTable& res = theme->getResTable();
+  ResTable_config config;
+  Res_value value;
 
-  // Retrieve the default style bag, if requested.
-  const ResTable::bag_entry* def_style_attr_start = nullptr;
-  uint32_t def_style_type_set_flags = 0;
-  ssize_t bag_off = def_style_res != 0
-                        ? res.getBagLocked(def_style_res, &def_style_attr_start,
-                                           &def_style_type_set_flags)
-                        : -1;
-  def_style_type_set_flags |= def_style_bag_type_set_flags;
-  const ResTable::bag_entry* const def_style_attr_end =
-      def_style_attr_start + (bag_off >= 0 ? bag_off : 0);
-  BagAttributeFinder def_style_attr_finder(def_style_attr_start,
-                                           def_style_attr_end);
-
-  // Retrieve the style class bag, if requested.
-  const ResTable::bag_entry* style_attr_start = nullptr;
-  uint32_t style_type_set_flags = 0;
-  bag_off =
-      style != 0
-          ? res.getBagLocked(style, &style_attr_start, &style_type_set_flags)
-          : -1;
-  style_type_set_flags |= style_bag_type_set_flags;
-  const ResTable::bag_entry* const style_attr_end =
-      style_attr_start + (bag_off >= 0 ? bag_off : 0);
-  BagAttributeFinder style_attr_finder(style_attr_start, style_attr_end);
+  int indices_idx = 0;
+
+  const ResTable::bag_entry* const def_style_attr_end = def_style_bag.end;
+  BagAttributeFinder def_style_attr_finder(def_style_bag.start, def_style_bag.end);
+
+  const ResTable::bag_entry* const style_attr_end = style_bag.end;
+  const uint32_t style_type_set_flags = style_bag.type_set_flags;
+  BagAttributeFinder style_attr_finder(style_bag.start, style_bag.end);
 
   // Retrieve the XML attributes, if requested.
   static const ssize_t kXmlBlock = 0x10000000;
@@ -402,12 +405,73 @@ void ApplyStyle(ResTable::Theme* theme, ResXMLParser* xml_parser, uint32_t def_s
     out_values += STYLE_NUM_ENTRIES;
   }
 
-  res.unlock();
-
   // out_indices must NOT be nullptr.
   out_indices[0] = indices_idx;
 }
 
+void ApplyStyle(ResTable::Theme* theme, ResXMLParser* xml_parser, uint32_t def_style_attr,
+                uint32_t def_style_res, const uint32_t* attrs, size_t attrs_length,
+                uint32_t* out_values, uint32_t* out_indices) {
+  ApplyStyles(theme, &xml_parser, 1u, def_style_attr, def_style_res, attrs, attrs_length,
+              out_values, out_indices);
+}
+
+void ApplyStyles(ResTable::Theme* theme, ResXMLParser* const* xml_parsers,
+                 size_t xml_parsers_length, uint32_t def_style_attr, uint32_t def_style_res,
+                 const uint32_t* attrs, size_t attrs_length, uint32_t* out_values,
+                 uint32_t* out_indices) {
+  if (kDebugStyles) {
+    ALOGI("APPLY STYLES: theme=0x%p defStyleAttr=0x%x defStyleRes=0x%x count=%zu", theme,
+          def_style_attr, def_style_res, xml_parsers_length);
+  }
+
+  const ResTable& res = theme->getResTable();
+
+  // Load default style from attribute, if specified. This is shared by all elements.
+  uint32_t def_style_bag_type_set_flags = 0;
+  def_style_res =
+      ResolveDefStyle(theme, def_style_attr, def_style_res, &def_style_bag_type_set_flags);
+
+  // Retrieve the style class associated with each XML tag.
+  std::vector<std::pair<uint32_t, uint32_t>> styles;
+  styles.reserve(xml_parsers_length);
+  for (size_t i = 0; i < xml_parsers_length; i++) {
+    uint32_t style_bag_type_set_flags = 0;
+    uint32_t style = ResolveXmlStyle(theme, xml_parsers[i], &style_bag_type_set_flags);
+    styles.push_back(std::make_pair(style, style_bag_type_set_flags));
+  }
+
+  // Now lock down the resource object and start pulling stuff from it.
+  res.lock();
+
+  // Retrieve the default style bag, if requested.
+  LockedStyleBag def_style_bag = GetStyleBagLocked(res, def_style_res);
+  def_style_bag.type_set_flags |= def_style_bag_type_set_flags;
+
+  // Elements inflated together very often share the same style="" attribute, so look up each
+  // distinct style bag only once.
+  std::unordered_map<uint32_t, LockedStyleBag> style_bags;
+
+  for (size_t i = 0; i < xml_parsers_length; i++) {
+    LockedStyleBag style_bag;
+    const uint32_t style = styles[i].first;
+    if (style != 0) {
+      auto iter = style_bags.find(style);
+      if (iter == style_bags.end()) {
+        iter = style_bags.emplace(style, GetStyleBagLocked(res, style)).first;
+      }
+      style_bag = iter->second;
+    }
+    style_bag.type_set_flags |= styles[i].second;
+
+    ApplyStyleLocked(theme, xml_parsers[i], def_style_bag, style_bag, attrs, attrs_length,
+                     out_values + (i * attrs_length * STYLE_NUM_ENTRIES),
+                     out_indices + (i * (attrs_length + 1)));
+  }
+
+  res.unlock();
+}
+
 bool RetrieveAttributes(const ResTable* res, ResXMLParser* xml_parser,
                         uint32_t* attrs, size_t attrs_length,
                         uint32_t* out_values, uint32_t* out_indices) {
@@ -310,7 +310,7 @@ compute_crc32(const char* file, FileRec* out) {
         return -1;
     }
 
-    const int bufsize = 4*1024;
+    const int bufsize = 32*1024;
     int amt;
 
     char* buf = (char*)malloc(bufsize);
@@ -318,7 +318,7 @@ compute_crc32(const char* file, FileRec* out) {
 
     lseek(fd, 0, SEEK_SET);
 
-    while ((amt = read(fd, buf, bufsize)) != 0) {
+    while ((amt = read(fd, buf, bufsize)) > 0) {
         crc = crc32(crc, (Bytef*)buf, amt);
     }
 
@@ -329,6 +329,18 @@ compute_crc32(const char* file, FileRec* out) {
     return NO_ERROR;
 }
 
+// Whether the file described by cur is known to be unchanged since old was recorded, without
+// reading it. Snapshots written before nanosecond mtimes were recorded have a zero
+// modTime_nsec, and so do files on filesystems that only keep seconds; those always get
+// checksummed again, a second is too coarse to catch a rewrite of the same size.
+static bool
+is_unchanged_by_metadata(const FileState& old, const FileState& cur)
+{
+    return old.modTime_nsec != 0
+            && old.modTime_sec == cur.modTime_sec && old.modTime_nsec == cur.modTime_nsec
+            && old.mode == cur.mode && old.size == cur.size;
+}
+
 int
 back_up_files(int oldSnapshotFD, BackupDataWriter* dataStream, int newSnapshotFD,
         char const* const* files, char const* const* keys, int fileCount)
@@ -359,8 +371,7 @@ back_up_files(int oldSnapshotFD, BackupDataWriter* dataStream, int newSnapshotFD
         } else {
             r.deleted = false;
             r.s.modTime_sec = st.st_mtime;
-            r.s.modTime_nsec = 0; // workaround sim breakage
-            //r.s.modTime_nsec = st.st_mtime_nsec;
+            r.s.modTime_nsec = st.st_mtim.tv_nsec;
             r.s.mode = st.st_mode;
             r.s.size = st.st_size;
 
@@ -369,8 +380,11 @@ back_up_files(int oldSnapshotFD, BackupDataWriter* dataStream, int newSnapshotFD
                 return -1;
             }
 
-            // compute the CRC
-            if (compute_crc32(file, &r) != NO_ERROR) {
+            // Reuse the old CRC when the metadata says the file wasn't touched
+            ssize_t oldIndex = oldSnapshot.indexOfKey(key);
+            if (oldIndex >= 0 && is_unchanged_by_metadata(oldSnapshot.valueAt(oldIndex), r.s)) {
+                r.s.crc32 = oldSnapshot.valueAt(oldIndex).crc32;
+            } else if (compute_crc32(file, &r) != NO_ERROR) {
                 ALOGW("Unable to open file %s", file);
                 continue;
             }
@@ -407,7 +421,9 @@ back_up_files(int oldSnapshotFD, BackupDataWriter* dataStream, int newSnapshotFD
                     f.modTime_sec, f.modTime_nsec, f.mode, f.size, f.crc32);
             LOGP("  new: modTime=%d,%d mode=%04o size=%-3d crc32=0x%08x",
                     g.s.modTime_sec, g.s.modTime_nsec, g.s.mode, g.s.size, g.s.crc32);
-            if (f.modTime_sec != g.s.modTime_sec || f.modTime_nsec != g.s.modTime_nsec
+            // Old snapshots have no nanoseconds, don't send every file again because of that
+            bool nsecChanged = f.modTime_nsec != 0 && f.modTime_nsec != g.s.modTime_nsec;
+            if (f.modTime_sec != g.s.modTime_sec || nsecChanged
                     || f.mode != g.s.mode || f.size != g.s.size || f.crc32 != g.s.crc32) {
                 int fd = open(g.file.string(), O_RDONLY);
                 if (fd < 0) {
@@ -478,6 +494,16 @@ void send_tarfile_chunk(BackupDataWriter* writer, const char* buffer, size_t siz
     if (size != 0) writer->WriteEntityData(buffer, size);
 }
 
+// Same as send_tarfile_chunk(), but stores the chunk size in the TARFILE_CHUNK_PREFIX bytes
+// reserved in front of buffer so the whole chunk goes out in a single write
+static const size_t TARFILE_CHUNK_PREFIX = 4;
+
+static void send_prefixed_tarfile_chunk(BackupDataWriter* writer, char* buffer, size_t size) {
+    uint32_t chunk_size_no = htonl(size);
+    memcpy(buffer - TARFILE_CHUNK_PREFIX, &chunk_size_no, TARFILE_CHUNK_PREFIX);
+    writer->WriteEntityData(buffer - TARFILE_CHUNK_PREFIX, size + TARFILE_CHUNK_PREFIX);
+}
+
 int write_tarfile(const String8& packageName, const String8& domain,
         const String8& rootpath, const String8& filepath, off_t* outSize,
         BackupDataWriter* writer)
@@ -547,10 +573,13 @@ int write_tarfile(const String8& packageName, const String8& domain,
         ALOGE("Error %d (%s) from open(%s)", err, strerror(err), filepath.string());
         return err;
     }
+    // Let the kernel read ahead of us, we stream the whole file exactly once
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-    // read/write up to this much at a time.
-    const size_t BUFSIZE = 32 * 1024;
-    char* buf = (char *)calloc(1,BUFSIZE);
+    // read/write up to this much at a time; matches the default pipe capacity
+    const size_t BUFSIZE = 64 * 1024;
+    char* const chunk = (char *)calloc(1, TARFILE_CHUNK_PREFIX + BUFSIZE);
+    char* const buf = chunk ? chunk + TARFILE_CHUNK_PREFIX : NULL;
     const size_t PAXHEADER_OFFSET = 512;
     const size_t PAXHEADER_SIZE = 512;
     const size_t PAXDATA_SIZE = BUFSIZE - (PAXHEADER_SIZE + PAXHEADER_OFFSET);
@@ -677,7 +706,7 @@ int write_tarfile(const String8& packageName, const String8& domain,
 
     // Checksum and write the 512-byte ustar file header block to the output
     calc_tar_checksum(buf, BUFSIZE);
-    send_tarfile_chunk(writer, buf, 512);
+    send_prefixed_tarfile_chunk(writer, buf, 512);
 
     // Now write the file data itself, for real files.  We honor tar's convention that
     // only full 512-byte blocks are sent to write().
@@ -710,13 +739,13 @@ int write_tarfile(const String8& packageName, const String8& domain,
                 memset(buf + nRead, 0, remainder);
                 nRead += remainder;
             }
-            send_tarfile_chunk(writer, buf, nRead);
+            send_prefixed_tarfile_chunk(writer, buf, nRead);
             toWrite -= nRead;
         }
     }
 
 cleanup:
-    free(buf);
+    free(chunk);
 done:
     close(fd);
     return err;
@@ -807,8 +836,7 @@ RestoreHelperBase::WriteFile(const String8& filename, BackupDataReader* in)
     r.file = filename;
     r.deleted = false;
     r.s.modTime_sec = st.st_mtime;
-    r.s.modTime_nsec = 0; // workaround sim breakage
-    //r.s.modTime_nsec = st.st_mtime_nsec;
+    r.s.modTime_nsec = st.st_mtim.tv_nsec;
     r.s.mode = st.st_mode;
     r.s.size = st.st_size;
     r.s.crc32 = crc;
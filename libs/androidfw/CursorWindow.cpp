@@ -24,15 +24,19 @@
 #include <cutils/ashmem.h>
 #include <sys/mman.h>
 
+#include <algorithm>
+
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 namespace android {
 
 CursorWindow::CursorWindow(const String8& name, int ashmemFd,
         void* data, size_t size, bool readOnly) :
-        mName(name), mAshmemFd(ashmemFd), mData(data), mSize(size), mReadOnly(readOnly) {
+        mName(name), mAshmemFd(ashmemFd), mData(data), mSize(size), mMaxSize(size),
+        mReadOnly(readOnly), mLastChunk(0) {
     mHeader = static_cast<Header*>(mData);
 }
 
@@ -41,7 +45,8 @@ CursorWindow::~CursorWindow() {
     ::close(mAshmemFd);
 }
 
-status_t CursorWindow::create(const String8& name, size_t size, CursorWindow** outCursorWindow) {
+static status_t createAshmemRegion(const String8& name, size_t size,
+        int* outAshmemFd, void** outData) {
     String8 ashmemName("CursorWindow: ");
     ashmemName.append(name);
 
@@ -58,26 +63,38 @@ status_t CursorWindow::create(const String8& name, size_t size, CursorWindow** o
             } else {
                 result = ashmem_set_prot_region(ashmemFd, PROT_READ);
                 if (result >= 0) {
-                    CursorWindow* window = new CursorWindow(name, ashmemFd,
-                            data, size, false /*readOnly*/);
-                    result = window->clear();
-                    if (!result) {
-                        LOG_WINDOW("Created new CursorWindow: freeOffset=%d, "
-                                "numRows=%d, numColumns=%d, mSize=%d, mData=%p",
-                                window->mHeader->freeOffset,
-                                window->mHeader->numRows,
-                                window->mHeader->numColumns,
-                                window->mSize, window->mData);
-                        *outCursorWindow = window;
-                        return OK;
-                    }
-                    delete window;
+                    *outAshmemFd = ashmemFd;
+                    *outData = data;
+                    return OK;
                 }
+                ::munmap(data, size);
             }
-            ::munmap(data, size);
         }
         ::close(ashmemFd);
     }
+    return result;
+}
+
+status_t CursorWindow::create(const String8& name, size_t size, CursorWindow** outCursorWindow) {
+    int ashmemFd;
+    void* data;
+    status_t result = createAshmemRegion(name, size, &ashmemFd, &data);
+    if (!result) {
+        CursorWindow* window = new CursorWindow(name, ashmemFd,
+                data, size, false /*readOnly*/);
+        result = window->clear();
+        if (!result) {
+            LOG_WINDOW("Created new CursorWindow: freeOffset=%d, "
+                    "numRows=%d, numColumns=%d, mSize=%d, mData=%p",
+                    window->mHeader->freeOffset,
+                    window->mHeader->numRows,
+                    window->mHeader->numColumns,
+                    window->mSize, window->mData);
+            *outCursorWindow = window;
+            return OK;
+        }
+        delete window;
+    }
     *outCursorWindow = NULL;
     return result;
 }
@@ -127,6 +144,9 @@ status_t CursorWindow::createFromParcel(Parcel* parcel, CursorWindow** outCursor
 }
 
 status_t CursorWindow::writeToParcel(Parcel* parcel) {
+    // The receiver maps the current region, which must not be replaced behind its back
+    mMaxSize = mSize;
+
     status_t status = parcel->writeString8(mName);
     if (!status) {
         status = parcel->writeDupFileDescriptor(mAshmemFd);
@@ -134,6 +154,42 @@ status_t CursorWindow::writeToParcel(Parcel* parcel) {
     return status;
 }
 
+status_t CursorWindow::setMaxSize(size_t maxSize) {
+    if (mReadOnly) {
+        return INVALID_OPERATION;
+    }
+
+    mMaxSize = std::max(maxSize, mSize);
+    return OK;
+}
+
+status_t CursorWindow::grow(size_t minSize) {
+    size_t pageSize = getpagesize();
+    size_t size = std::max(mSize * 2, minSize);
+    size = std::min((size + pageSize - 1) & ~(pageSize - 1), mMaxSize);
+    if (size < minSize) {
+        return NO_MEMORY;
+    }
+
+    int ashmemFd;
+    void* data;
+    status_t result = createAshmemRegion(mName, size, &ashmemFd, &data);
+    if (result) {
+        return result;
+    }
+    // Everything in the window is addressed by offset, so it can be moved as is
+    memcpy(data, mData, mHeader->freeOffset);
+    ::munmap(mData, mSize);
+    ::close(mAshmemFd);
+
+    LOG_WINDOW("Grew CursorWindow from %zu to %zu bytes", mSize, size);
+    mAshmemFd = ashmemFd;
+    mData = data;
+    mSize = size;
+    mHeader = static_cast<Header*>(mData);
+    return OK;
+}
+
 status_t CursorWindow::clear() {
     if (mReadOnly) {
         return INVALID_OPERATION;
@@ -146,6 +202,7 @@ status_t CursorWindow::clear() {
 
     RowSlotChunk* firstChunk = static_cast<RowSlotChunk*>(offsetToPtr(mHeader->firstChunkOffset));
     firstChunk->nextChunkOffset = 0;
+    mLastChunk.store(0, std::memory_order_relaxed);
     return OK;
 }
 
@@ -174,7 +231,8 @@ status_t CursorWindow::allocRow() {
         return NO_MEMORY;
     }
 
-    // Allocate the slots for the field directory
+    // Allocate the slots for the field directory, which may move the window
+    uint32_t rowSlotOffset = offsetFromPtr(rowSlot);
     size_t fieldDirSize = mHeader->numColumns * sizeof(FieldSlot);
     uint32_t fieldDirOffset = alloc(fieldDirSize, true /*aligned*/);
     if (!fieldDirOffset) {
@@ -187,7 +245,8 @@ status_t CursorWindow::allocRow() {
     memset(fieldDir, 0, fieldDirSize);
 
     LOG_WINDOW("Allocated row %u, rowSlot is at offset %u, fieldDir is %d bytes at offset %u\n",
-            mHeader->numRows - 1, offsetFromPtr(rowSlot), fieldDirSize, fieldDirOffset);
+            mHeader->numRows - 1, rowSlotOffset, fieldDirSize, fieldDirOffset);
+    rowSlot = static_cast<RowSlot*>(offsetToPtr(rowSlotOffset));
     rowSlot->offset = fieldDirOffset;
     return OK;
 }
@@ -214,6 +273,9 @@ uint32_t CursorWindow::alloc(size_t size, bool aligned) {
 
     uint32_t offset = mHeader->freeOffset + padding;
     uint32_t nextFreeOffset = offset + size;
+    if (nextFreeOffset > mSize && nextFreeOffset <= mMaxSize) {
+        grow(nextFreeOffset);
+    }
     if (nextFreeOffset > mSize) {
         ALOGW("Window is full: requested allocation %zu bytes, "
                 "free space %zu bytes, window size %zu bytes",
@@ -225,35 +287,52 @@ uint32_t CursorWindow::alloc(size_t size, bool aligned) {
     return offset;
 }
 
-CursorWindow::RowSlot* CursorWindow::getRowSlot(uint32_t row) {
-    uint32_t chunkPos = row;
-    RowSlotChunk* chunk = static_cast<RowSlotChunk*>(
-            offsetToPtr(mHeader->firstChunkOffset));
-    while (chunkPos >= ROW_SLOT_CHUNK_NUM_ROWS) {
-        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunk->nextChunkOffset));
-        chunkPos -= ROW_SLOT_CHUNK_NUM_ROWS;
+CursorWindow::RowSlotChunk* CursorWindow::getRowSlotChunk(uint32_t chunkIndex) {
+    uint32_t index = 0;
+    uint32_t chunkOffset = mHeader->firstChunkOffset;
+    uint64_t lastChunk = mLastChunk.load(std::memory_order_relaxed);
+    if (lastChunk && uint32_t(lastChunk >> 32) <= chunkIndex) {
+        index = uint32_t(lastChunk >> 32);
+        chunkOffset = uint32_t(lastChunk);
     }
-    return &chunk->slots[chunkPos];
+    RowSlotChunk* chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunkOffset));
+    while (index < chunkIndex) {
+        chunkOffset = chunk->nextChunkOffset;
+        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunkOffset));
+        index++;
+    }
+    mLastChunk.store((uint64_t(chunkIndex) << 32) | chunkOffset, std::memory_order_relaxed);
+    return chunk;
+}
+
+CursorWindow::RowSlot* CursorWindow::getRowSlot(uint32_t row) {
+    RowSlotChunk* chunk = getRowSlotChunk(row / ROW_SLOT_CHUNK_NUM_ROWS);
+    return &chunk->slots[row % ROW_SLOT_CHUNK_NUM_ROWS];
 }
 
 CursorWindow::RowSlot* CursorWindow::allocRowSlot() {
-    uint32_t chunkPos = mHeader->numRows;
-    RowSlotChunk* chunk = static_cast<RowSlotChunk*>(
-            offsetToPtr(mHeader->firstChunkOffset));
-    while (chunkPos > ROW_SLOT_CHUNK_NUM_ROWS) {
-        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunk->nextChunkOffset));
-        chunkPos -= ROW_SLOT_CHUNK_NUM_ROWS;
-    }
-    if (chunkPos == ROW_SLOT_CHUNK_NUM_ROWS) {
-        if (!chunk->nextChunkOffset) {
-            chunk->nextChunkOffset = alloc(sizeof(RowSlotChunk), true /*aligned*/);
-            if (!chunk->nextChunkOffset) {
+    uint32_t row = mHeader->numRows;
+    uint32_t chunkIndex = row / ROW_SLOT_CHUNK_NUM_ROWS;
+    uint32_t chunkPos = row % ROW_SLOT_CHUNK_NUM_ROWS;
+    RowSlotChunk* chunk;
+    if (row > 0 && chunkPos == 0) {
+        // The previous chunk is full, reuse the next one if freeLastRow() left it behind
+        RowSlotChunk* previousChunk = getRowSlotChunk(chunkIndex - 1);
+        uint32_t chunkOffset = previousChunk->nextChunkOffset;
+        if (!chunkOffset) {
+            uint32_t previousChunkOffset = offsetFromPtr(previousChunk);
+            chunkOffset = alloc(sizeof(RowSlotChunk), true /*aligned*/);
+            if (!chunkOffset) {
                 return NULL;
             }
+            previousChunk = static_cast<RowSlotChunk*>(offsetToPtr(previousChunkOffset));
+            previousChunk->nextChunkOffset = chunkOffset;
         }
-        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunk->nextChunkOffset));
+        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunkOffset));
         chunk->nextChunkOffset = 0;
-        chunkPos = 0;
+        mLastChunk.store((uint64_t(chunkIndex) << 32) | chunkOffset, std::memory_order_relaxed);
+    } else {
+        chunk = getRowSlotChunk(chunkIndex);
     }
     mHeader->numRows += 1;
     return &chunk->slots[chunkPos];
@@ -275,6 +354,78 @@ CursorWindow::FieldSlot* CursorWindow::getFieldSlot(uint32_t row, uint32_t colum
     return &fieldDir[column];
 }
 
+status_t CursorWindow::getColumnLongs(uint32_t column, uint32_t startRow, uint32_t numRows,
+        int64_t* outValues) {
+    if (column >= mHeader->numColumns || startRow > mHeader->numRows
+            || numRows > mHeader->numRows - startRow) {
+        ALOGE("Failed to read rows %d to %d, column %d from a CursorWindow which "
+                "has %d rows, %d columns.",
+                startRow, startRow + numRows, column, mHeader->numRows, mHeader->numColumns);
+        return BAD_VALUE;
+    }
+    for (uint32_t i = 0; i < numRows; i++) {
+        RowSlot* rowSlot = getRowSlot(startRow + i);
+        FieldSlot* fieldDir = static_cast<FieldSlot*>(offsetToPtr(rowSlot->offset));
+        FieldSlot* fieldSlot = &fieldDir[column];
+        switch (fieldSlot->type) {
+        case FIELD_TYPE_INTEGER:
+            outValues[i] = fieldSlot->data.l;
+            break;
+        case FIELD_TYPE_FLOAT:
+            outValues[i] = int64_t(fieldSlot->data.d);
+            break;
+        case FIELD_TYPE_STRING: {
+            size_t sizeIncludingNull;
+            const char* value = getFieldSlotValueString(fieldSlot, &sizeIncludingNull);
+            outValues[i] = sizeIncludingNull > 1 ? strtoll(value, NULL, 0) : 0L;
+            break;
+        }
+        case FIELD_TYPE_NULL:
+            outValues[i] = 0;
+            break;
+        default:
+            return BAD_TYPE;
+        }
+    }
+    return OK;
+}
+
+status_t CursorWindow::getColumnDoubles(uint32_t column, uint32_t startRow, uint32_t numRows,
+        double* outValues) {
+    if (column >= mHeader->numColumns || startRow > mHeader->numRows
+            || numRows > mHeader->numRows - startRow) {
+        ALOGE("Failed to read rows %d to %d, column %d from a CursorWindow which "
+                "has %d rows, %d columns.",
+                startRow, startRow + numRows, column, mHeader->numRows, mHeader->numColumns);
+        return BAD_VALUE;
+    }
+    for (uint32_t i = 0; i < numRows; i++) {
+        RowSlot* rowSlot = getRowSlot(startRow + i);
+        FieldSlot* fieldDir = static_cast<FieldSlot*>(offsetToPtr(rowSlot->offset));
+        FieldSlot* fieldSlot = &fieldDir[column];
+        switch (fieldSlot->type) {
+        case FIELD_TYPE_FLOAT:
+            outValues[i] = fieldSlot->data.d;
+            break;
+        case FIELD_TYPE_INTEGER:
+            outValues[i] = double(fieldSlot->data.l);
+            break;
+        case FIELD_TYPE_STRING: {
+            size_t sizeIncludingNull;
+            const char* value = getFieldSlotValueString(fieldSlot, &sizeIncludingNull);
+            outValues[i] = sizeIncludingNull > 1 ? strtod(value, NULL) : 0.0;
+            break;
+        }
+        case FIELD_TYPE_NULL:
+            outValues[i] = 0.0;
+            break;
+        default:
+            return BAD_TYPE;
+        }
+    }
+    return OK;
+}
+
 status_t CursorWindow::putBlob(uint32_t row, uint32_t column, const void* value, size_t size) {
     return putBlobOrString(row, column, value, size, FIELD_TYPE_BLOB);
 }
@@ -294,6 +445,7 @@ status_t CursorWindow::putBlobOrString(uint32_t row, uint32_t column,
     if (!fieldSlot) {
         return BAD_VALUE;
     }
+    uint32_t fieldSlotOffset = offsetFromPtr(fieldSlot);
 
     uint32_t offset = alloc(size);
     if (!offset) {
@@ -302,6 +454,9 @@ status_t CursorWindow::putBlobOrString(uint32_t row, uint32_t column,
 
     memcpy(offsetToPtr(offset), value, size);
 
+    // The allocation may have moved the window
+    fieldSlot = static_cast<FieldSlot*>(offsetToPtr(fieldSlotOffset));
+
     fieldSlot->type = type;
     fieldSlot->data.buffer.offset = offset;
     fieldSlot->data.buffer.size = size;
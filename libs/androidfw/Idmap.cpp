@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_RESOURCES
+
+#include "androidfw/Idmap.h"
+
+#include <cstring>
+#include <limits>
+
+#include "android-base/logging.h"
+#include "android-base/stringprintf.h"
+#include "utils/ByteOrder.h"
+#include "utils/Trace.h"
+
+#ifdef _WIN32
+#ifdef ERROR
+#undef ERROR
+#endif
+#endif
+
+using android::base::StringPrintf;
+
+namespace android {
+
+constexpr static uint32_t kIdmapMagic = 0x504D4449u;
+constexpr static uint32_t kIdmapCurrentVersion = 0x00000001u;
+
+static bool is_word_aligned(const void* data) {
+  return (reinterpret_cast<uintptr_t>(data) & 0x03) == 0;
+}
+
+static bool IsValidIdmapHeader(const StringPiece& data) {
+  if (!is_word_aligned(data.data())) {
+    LOG(ERROR) << "Idmap header is not word aligned.";
+    return false;
+  }
+
+  if (data.size() < sizeof(Idmap_header)) {
+    LOG(ERROR) << "Idmap header is too small.";
+    return false;
+  }
+
+  const Idmap_header* header = reinterpret_cast<const Idmap_header*>(data.data());
+  if (dtohl(header->magic) != kIdmapMagic) {
+    LOG(ERROR) << StringPrintf("Invalid Idmap file: bad magic value (was 0x%08x, expected 0x%08x)",
+                               dtohl(header->magic), kIdmapMagic);
+    return false;
+  }
+
+  if (dtohl(header->version) != kIdmapCurrentVersion) {
+    // We are strict about versions because files with this format are auto-generated and don't
+    // need backwards compatibility.
+    LOG(ERROR) << StringPrintf("Version mismatch in Idmap (was 0x%08x, expected 0x%08x)",
+                               dtohl(header->version), kIdmapCurrentVersion);
+    return false;
+  }
+
+  if (dtohs(header->target_package_id) == 0 ||
+      dtohs(header->target_package_id) > std::numeric_limits<uint8_t>::max()) {
+    LOG(ERROR) << StringPrintf("Target package ID in Idmap is invalid: 0x%02x",
+                               dtohs(header->target_package_id));
+    return false;
+  }
+
+  if (dtohs(header->type_count) > std::numeric_limits<uint8_t>::max()) {
+    LOG(ERROR) << "Idmap has too many type mappings (was " << dtohs(header->type_count)
+               << ", max " << static_cast<int>(std::numeric_limits<uint8_t>::max()) << ")";
+    return false;
+  }
+  return true;
+}
+
+static bool IsValidIdmapEntryHeader(const IdmapEntry_header* header, size_t size) {
+  if (size < sizeof(IdmapEntry_header)) {
+    LOG(ERROR) << "Idmap type map is too small.";
+    return false;
+  }
+
+  const uint16_t target_type_id = dtohs(header->target_type_id);
+  const uint16_t overlay_type_id = dtohs(header->overlay_type_id);
+  if (target_type_id == 0 || overlay_type_id == 0 ||
+      target_type_id > std::numeric_limits<uint8_t>::max() ||
+      overlay_type_id > std::numeric_limits<uint8_t>::max()) {
+    LOG(ERROR) << StringPrintf("Invalid type map (0x%02x -> 0x%02x)", target_type_id,
+                               overlay_type_id);
+    return false;
+  }
+
+  const size_t entry_count = dtohs(header->entry_count);
+  if ((size - sizeof(IdmapEntry_header)) / sizeof(uint32_t) < entry_count) {
+    LOG(ERROR) << "Idmap too small for the number of entries (" << entry_count << ").";
+    return false;
+  }
+  return true;
+}
+
+LoadedIdmap::LoadedIdmap(const Idmap_header* header) : header_(header) {
+  const char* path = reinterpret_cast<const char*>(header_->overlay_path);
+  overlay_apk_path_.assign(path, strnlen(path, arraysize(header_->overlay_path)));
+}
+
+std::unique_ptr<const LoadedIdmap> LoadedIdmap::Load(const StringPiece& idmap_data) {
+  ATRACE_CALL();
+  if (!IsValidIdmapHeader(idmap_data)) {
+    return {};
+  }
+
+  const Idmap_header* header = reinterpret_cast<const Idmap_header*>(idmap_data.data());
+
+  // Can't use make_unique because LoadedIdmap constructor is private.
+  std::unique_ptr<LoadedIdmap> loaded_idmap(new LoadedIdmap(header));
+
+  const uint8_t* data_ptr = reinterpret_cast<const uint8_t*>(idmap_data.data()) + sizeof(*header);
+  size_t data_size = idmap_data.size() - sizeof(*header);
+
+  const size_t type_map_count = dtohs(header->type_count);
+  for (size_t i = 0; i < type_map_count; i++) {
+    const IdmapEntry_header* entry_header = reinterpret_cast<const IdmapEntry_header*>(data_ptr);
+    if (!IsValidIdmapEntryHeader(entry_header, data_size)) {
+      return {};
+    }
+
+    const uint8_t overlay_type_id = static_cast<uint8_t>(dtohs(entry_header->overlay_type_id));
+    if (loaded_idmap->type_map_[overlay_type_id] != nullptr) {
+      LOG(ERROR) << StringPrintf("Idmap maps overlay type 0x%02x more than once.",
+                                 overlay_type_id);
+      return {};
+    }
+    loaded_idmap->type_map_.editItemAt(overlay_type_id) = entry_header;
+
+    const size_t entry_size_bytes =
+        sizeof(IdmapEntry_header) + (dtohs(entry_header->entry_count) * sizeof(uint32_t));
+    data_ptr += entry_size_bytes;
+    data_size -= entry_size_bytes;
+  }
+
+  // Need to force a move for mingw32.
+  return std::move(loaded_idmap);
+}
+
+bool LoadedIdmap::Lookup(const IdmapEntry_header* header, uint16_t input_entry_id,
+                         uint16_t* output_entry_id) {
+  const uint16_t entry_id_offset = dtohs(header->entry_id_offset);
+  if (input_entry_id < entry_id_offset) {
+    // After applying the offset, the input entry can't be represented in this map.
+    return false;
+  }
+  input_entry_id -= entry_id_offset;
+
+  if (input_entry_id >= dtohs(header->entry_count)) {
+    // The input entry is not present in this map.
+    return false;
+  }
+
+  const uint32_t result = dtohl(header->entries[input_entry_id]);
+  if (result == 0xffffffffu) {
+    return false;
+  }
+  *output_entry_id = static_cast<uint16_t>(result);
+  return true;
+}
+
+uint8_t LoadedIdmap::TargetPackageId() const {
+  return static_cast<uint8_t>(dtohs(header_->target_package_id));
+}
+
+}  // namespace android
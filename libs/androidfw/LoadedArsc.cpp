@@ -18,6 +18,7 @@
 
 #include "androidfw/LoadedArsc.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <limits>
 
@@ -51,6 +52,11 @@ struct Type {
 
   // Pointer to the mmapped data where entry definitions are kept.
   const ResTable_type* type;
+
+  // The qualifiers of `configuration` that must match exactly, and the mask of those that are set.
+  // See ResTable_config::packExactQualifiers().
+  uint64_t exact_qualifiers;
+  uint64_t exact_qualifiers_mask;
 };
 
 // TypeSpec is going to be immediately proceeded by
@@ -61,6 +67,10 @@ struct TypeSpec {
   // and under which configurations it varies.
   const ResTable_typeSpec* type_spec;
 
+  // The IDMAP entries for this type if this type is an overlay, otherwise nullptr.
+  // Target entry IDs are translated through this map before being looked up.
+  const IdmapEntry_header* idmap_entries;
+
   // The number of types that follow this struct.
   // There is a type for each configuration
   // that entries are defined for.
@@ -77,6 +87,56 @@ struct TypeSpec {
 // itself.
 using TypeSpecPtr = util::unique_cptr<TypeSpec>;
 
+// The side index written by LoadedArsc::WriteIndex() and consumed by LoadedArsc::LoadWithIndex().
+// It is laid out flat so that it can be used directly from an mmapped file:
+//
+//   ArscIndexHeader
+//   ArscIndexPackage[package_count]
+//   ArscIndexTypeSpec[type_spec_count]
+//   uint32_t type_offsets[type_count]
+//
+// All values are in host byte order, since an index is only meant to be consumed on the device
+// that produced it. Offsets are relative to the start of the resource table data.
+constexpr const static uint32_t kArscIndexMagic = 0x58444941u;  // 'AIDX'
+constexpr const static uint32_t kArscIndexVersion = 1u;
+
+struct ArscIndexHeader {
+  uint32_t magic;
+  uint32_t version;
+
+  // The size and identity of the resource table this index was built from.
+  uint32_t arsc_size;
+  uint32_t source_crc;
+
+  uint32_t table_offset;
+
+  // 0 if the table has no global string pool.
+  uint32_t string_pool_offset;
+
+  uint32_t package_count;
+  uint32_t type_spec_count;
+  uint32_t type_count;
+};
+
+struct ArscIndexPackage {
+  uint32_t package_offset;
+
+  // 0 if the package has no RES_TABLE_LIBRARY_TYPE chunk.
+  uint32_t library_offset;
+
+  // Range into the ArscIndexTypeSpec array.
+  uint32_t first_type_spec;
+  uint32_t type_spec_count;
+};
+
+struct ArscIndexTypeSpec {
+  uint32_t type_spec_offset;
+
+  // Range into the type_offsets array.
+  uint32_t first_type;
+  uint32_t type_count;
+};
+
 namespace {
 
 // Builder that helps accumulate Type structs and then create a single
@@ -84,12 +144,15 @@ namespace {
 // the Type structs.
 class TypeSpecPtrBuilder {
  public:
-  TypeSpecPtrBuilder(const ResTable_typeSpec* header) : header_(header) {}
+  TypeSpecPtrBuilder(const ResTable_typeSpec* header, const IdmapEntry_header* idmap_header)
+      : header_(header), idmap_header_(idmap_header) {}
 
   void AddType(const ResTable_type* type) {
     ResTable_config config;
     config.copyFromDtoH(type->config);
-    types_.push_back(Type{config, type});
+    uint64_t exact_qualifiers_mask;
+    const uint64_t exact_qualifiers = config.packExactQualifiers(&exact_qualifiers_mask);
+    types_.push_back(Type{config, type, exact_qualifiers, exact_qualifiers_mask});
   }
 
   TypeSpecPtr Build() {
@@ -99,6 +162,7 @@ class TypeSpecPtrBuilder {
     }
     TypeSpec* type_spec = (TypeSpec*)::malloc(sizeof(TypeSpec) + (types_.size() * sizeof(Type)));
     type_spec->type_spec = header_;
+    type_spec->idmap_entries = idmap_header_;
     type_spec->type_count = types_.size();
     memcpy(type_spec + 1, types_.data(), types_.size() * sizeof(Type));
     return TypeSpecPtr(type_spec);
@@ -108,11 +172,74 @@ class TypeSpecPtrBuilder {
   DISALLOW_COPY_AND_ASSIGN(TypeSpecPtrBuilder);
 
   const ResTable_typeSpec* header_;
+  const IdmapEntry_header* idmap_header_;
   std::vector<Type> types_;
 };
 
+inline const ArscIndexPackage* GetIndexPackages(const ArscIndexHeader* index) {
+  return reinterpret_cast<const ArscIndexPackage*>(index + 1);
+}
+
+inline const ArscIndexTypeSpec* GetIndexTypeSpecs(const ArscIndexHeader* index) {
+  return reinterpret_cast<const ArscIndexTypeSpec*>(GetIndexPackages(index) +
+                                                     index->package_count);
+}
+
+inline const uint32_t* GetIndexTypeOffsets(const ArscIndexHeader* index) {
+  return reinterpret_cast<const uint32_t*>(GetIndexTypeSpecs(index) + index->type_spec_count);
+}
+
+// Returns the chunk at `offset` within `data` if it is well formed, of type `type` and fits
+// inside the `len` bytes of `data`. Otherwise returns nullptr.
+const ResChunk_header* GetIndexedChunk(const void* data, size_t len, uint32_t offset,
+                                       uint16_t type) {
+  if ((offset & 0x03) != 0 || offset > len || len - offset < sizeof(ResChunk_header)) {
+    return nullptr;
+  }
+
+  const ResChunk_header* header = reinterpret_cast<const ResChunk_header*>(
+      reinterpret_cast<const uint8_t*>(data) + offset);
+  const size_t header_size = dtohs(header->headerSize);
+  const size_t size = dtohl(header->size);
+  if (dtohs(header->type) != type || header_size < sizeof(ResChunk_header) || header_size > size ||
+      size > len - offset) {
+    return nullptr;
+  }
+  return header;
+}
+
 }  // namespace
 
+static bool SparseEntryLess(const ResTable_sparseTypeEntry& entry, uint16_t entry_idx) {
+  return dtohs(entry.idx) < entry_idx;
+}
+
+// Returns the offset of the entry from the type's entriesStart, or ResTable_type::NO_ENTRY if the
+// type has no value for it. Types with FLAG_SPARSE set only list the entries they define, sorted
+// by entry index.
+static uint32_t GetEntryOffset(const ResTable_type* type, uint16_t entry_idx) {
+  const size_t entry_count = dtohl(type->entryCount);
+  const uint8_t* indices =
+      reinterpret_cast<const uint8_t*>(type) + dtohs(type->header.headerSize);
+  if (type->flags & ResTable_type::FLAG_SPARSE) {
+    const ResTable_sparseTypeEntry* sparse_indices =
+        reinterpret_cast<const ResTable_sparseTypeEntry*>(indices);
+    const ResTable_sparseTypeEntry* sparse_indices_end = sparse_indices + entry_count;
+    const ResTable_sparseTypeEntry* result =
+        std::lower_bound(sparse_indices, sparse_indices_end, entry_idx, SparseEntryLess);
+    if (result == sparse_indices_end || dtohs(result->idx) != entry_idx) {
+      return ResTable_type::NO_ENTRY;
+    }
+    // Offsets are 4-byte aligned, so they are stored divided by 4.
+    return static_cast<uint32_t>(dtohs(result->offset)) * 4u;
+  }
+
+  if (entry_idx >= entry_count) {
+    return ResTable_type::NO_ENTRY;
+  }
+  return dtohl(reinterpret_cast<const uint32_t*>(indices)[entry_idx]);
+}
+
 bool LoadedPackage::FindEntry(uint8_t type_idx, uint16_t entry_idx, const ResTable_config& config,
                               LoadedArscEntry* out_entry, ResTable_config* out_selected_config,
                               uint32_t* out_flags) const {
@@ -125,6 +252,14 @@ bool LoadedPackage::FindEntry(uint8_t type_idx, uint16_t entry_idx, const ResTab
     return false;
   }
 
+  // If there is an IDMAP supplied with this package, translate the entry ID.
+  if (ptr->idmap_entries != nullptr) {
+    if (!LoadedIdmap::Lookup(ptr->idmap_entries, entry_idx, &entry_idx)) {
+      // There is no mapping, so the resource is not meant to be in this overlay package.
+      return false;
+    }
+  }
+
   // Don't bother checking if the entry ID is larger than
   // the number of entries.
   if (entry_idx >= dtohl(ptr->type_spec->entryCount)) {
@@ -135,24 +270,27 @@ bool LoadedPackage::FindEntry(uint8_t type_idx, uint16_t entry_idx, const ResTab
   const ResTable_type* best_type = nullptr;
   uint32_t best_offset = 0;
 
+  const uint64_t desired_exact_qualifiers = config.packExactQualifiers(nullptr);
+
   for (uint32_t i = 0; i < ptr->type_count; i++) {
     const Type* type = &ptr->types[i];
 
+    // Cheaply reject configurations that differ in a qualifier requiring an exact match, before
+    // going through the full ResTable_config::match().
+    if (((type->exact_qualifiers ^ desired_exact_qualifiers) & type->exact_qualifiers_mask) != 0) {
+      continue;
+    }
+
     if (type->configuration.match(config) &&
         (best_config == nullptr || type->configuration.isBetterThan(*best_config, &config))) {
       // The configuration matches and is better than the previous selection.
       // Find the entry value if it exists for this configuration.
-      size_t entry_count = dtohl(type->type->entryCount);
-      if (entry_idx < entry_count) {
-        const uint32_t* entry_offsets = reinterpret_cast<const uint32_t*>(
-            reinterpret_cast<const uint8_t*>(type->type) + dtohs(type->type->header.headerSize));
-        const uint32_t offset = dtohl(entry_offsets[entry_idx]);
-        if (offset != ResTable_type::NO_ENTRY) {
-          // There is an entry for this resource, record it.
-          best_config = &type->configuration;
-          best_type = type->type;
-          best_offset = offset + dtohl(type->type->entriesStart);
-        }
+      const uint32_t offset = GetEntryOffset(type->type, entry_idx);
+      if (offset != ResTable_type::NO_ENTRY) {
+        // There is an entry for this resource, record it.
+        best_config = &type->configuration;
+        best_type = type->type;
+        best_offset = offset + dtohl(type->type->entriesStart);
       }
     }
   }
@@ -240,11 +378,23 @@ static bool VerifyType(const Chunk& chunk) {
     return false;
   }
 
-  // Check each entry offset.
-  const uint32_t* offsets =
-      reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(header) + offsets_offset);
+  // Check each entry offset. Sparse types are looked up by binary search, so their entry indices
+  // must be strictly increasing.
+  const bool sparse = (header->flags & ResTable_type::FLAG_SPARSE) != 0;
+  const uint8_t* indices = reinterpret_cast<const uint8_t*>(header) + offsets_offset;
   for (size_t i = 0; i < entry_count; i++) {
-    uint32_t offset = dtohl(offsets[i]);
+    uint32_t offset;
+    if (sparse) {
+      const ResTable_sparseTypeEntry* sparse_indices =
+          reinterpret_cast<const ResTable_sparseTypeEntry*>(indices);
+      if (i > 0 && dtohs(sparse_indices[i].idx) <= dtohs(sparse_indices[i - 1].idx)) {
+        LOG(ERROR) << "Sparse entry at index " << i << " is out of order.";
+        return false;
+      }
+      offset = static_cast<uint32_t>(dtohs(sparse_indices[i].offset)) * 4u;
+    } else {
+      offset = dtohl(reinterpret_cast<const uint32_t*>(indices)[i]);
+    }
     if (offset != ResTable_type::NO_ENTRY) {
       // Check that the offset is aligned.
       if (offset & 0x03) {
@@ -322,6 +472,41 @@ static bool VerifyType(const Chunk& chunk) {
   return true;
 }
 
+static bool LoadDynamicPackageMap(const Chunk& chunk,
+                                  std::vector<DynamicPackageEntry>* out_package_map) {
+  const ResTable_lib_header* lib = chunk.header<ResTable_lib_header>();
+  if (lib == nullptr) {
+    LOG(ERROR) << "Chunk RES_TABLE_LIBRARY_TYPE is too small.";
+    return false;
+  }
+
+  if (chunk.data_size() / sizeof(ResTable_lib_entry) < dtohl(lib->count)) {
+    LOG(ERROR) << "Chunk too small to hold entries in RES_TABLE_LIBRARY_TYPE.";
+    return false;
+  }
+
+  out_package_map->reserve(dtohl(lib->count));
+
+  const ResTable_lib_entry* const entry_begin =
+      reinterpret_cast<const ResTable_lib_entry*>(chunk.data_ptr());
+  const ResTable_lib_entry* const entry_end = entry_begin + dtohl(lib->count);
+  for (auto entry_iter = entry_begin; entry_iter != entry_end; ++entry_iter) {
+    std::string package_name;
+    util::ReadUtf16StringFromDevice(entry_iter->packageName, arraysize(entry_iter->packageName),
+                                    &package_name);
+
+    if (dtohl(entry_iter->packageId) >= std::numeric_limits<uint8_t>::max()) {
+      LOG(ERROR) << base::StringPrintf(
+          "Package ID %02x in RES_TABLE_LIBRARY_TYPE too large for package '%s'.",
+          dtohl(entry_iter->packageId), package_name.c_str());
+      return false;
+    }
+
+    out_package_map->emplace_back(std::move(package_name), dtohl(entry_iter->packageId));
+  }
+  return true;
+}
+
 void LoadedPackage::CollectConfigurations(bool exclude_mipmap,
                                           std::set<ResTable_config>* out_configs) const {
   const static std::u16string kMipMap = u"mipmap";
@@ -375,6 +560,12 @@ void LoadedPackage::CollectLocales(bool canonicalize, std::set<std::string>* out
 
 uint32_t LoadedPackage::FindEntryByName(const std::u16string& type_name,
                                         const std::u16string& entry_name) const {
+  if (overlay_) {
+    // An overlay's types are stored under the target's type IDs, so its own names can't be
+    // resolved to IDs. Names are resolved by the target package instead.
+    return 0u;
+  }
+
   ssize_t type_idx = type_string_pool_.indexOfString(type_name.data(), type_name.size());
   if (type_idx < 0) {
     return 0u;
@@ -390,57 +581,113 @@ uint32_t LoadedPackage::FindEntryByName(const std::u16string& type_name,
     return 0u;
   }
 
-  for (size_t ti = 0; ti < type_spec->type_count; ti++) {
-    const Type* type = &type_spec->types[ti];
-    size_t entry_count = dtohl(type->type->entryCount);
-    for (size_t entry_idx = 0; entry_idx < entry_count; entry_idx++) {
-      const uint32_t* entry_offsets = reinterpret_cast<const uint32_t*>(
-          reinterpret_cast<const uint8_t*>(type->type) + dtohs(type->type->header.headerSize));
-      const uint32_t offset = dtohl(entry_offsets[entry_idx]);
-      if (offset != ResTable_type::NO_ENTRY) {
-        const ResTable_entry* entry =
-            reinterpret_cast<const ResTable_entry*>(reinterpret_cast<const uint8_t*>(type->type) +
-                                                    dtohl(type->type->entriesStart) + offset);
-        if (dtohl(entry->key.index) == static_cast<uint32_t>(key_idx)) {
-          // The package ID will be overridden by the caller (due to runtime assignment of package
-          // IDs for shared libraries).
-          return make_resid(0x00, type_idx + type_id_offset_ + 1, entry_idx);
+  std::lock_guard<std::mutex> lock(entry_name_index_lock_);
+  auto index_iter = entry_name_index_.find(static_cast<uint8_t>(type_idx));
+  if (index_iter == entry_name_index_.end()) {
+    std::vector<std::pair<uint32_t, uint16_t>> index;
+    for (size_t ti = 0; ti < type_spec->type_count; ti++) {
+      const Type* type = &type_spec->types[ti];
+      const bool sparse = (type->type->flags & ResTable_type::FLAG_SPARSE) != 0;
+      const uint8_t* indices =
+          reinterpret_cast<const uint8_t*>(type->type) + dtohs(type->type->header.headerSize);
+      size_t entry_count = dtohl(type->type->entryCount);
+      for (size_t i = 0; i < entry_count; i++) {
+        uint16_t entry_idx;
+        uint32_t offset;
+        if (sparse) {
+          const ResTable_sparseTypeEntry& sparse_index =
+              reinterpret_cast<const ResTable_sparseTypeEntry*>(indices)[i];
+          entry_idx = dtohs(sparse_index.idx);
+          offset = static_cast<uint32_t>(dtohs(sparse_index.offset)) * 4u;
+        } else {
+          entry_idx = static_cast<uint16_t>(i);
+          offset = dtohl(reinterpret_cast<const uint32_t*>(indices)[i]);
+        }
+        if (offset != ResTable_type::NO_ENTRY) {
+          const ResTable_entry* entry = reinterpret_cast<const ResTable_entry*>(
+              reinterpret_cast<const uint8_t*>(type->type) + dtohl(type->type->entriesStart) +
+              offset);
+          index.push_back(std::make_pair(dtohl(entry->key.index), entry_idx));
         }
       }
     }
+
+    // The first configuration to define a key wins, so keep equal keys in configuration order.
+    std::stable_sort(index.begin(), index.end(),
+                     [](const std::pair<uint32_t, uint16_t>& a,
+                        const std::pair<uint32_t, uint16_t>& b) { return a.first < b.first; });
+    index.erase(std::unique(index.begin(), index.end(),
+                            [](const std::pair<uint32_t, uint16_t>& a,
+                               const std::pair<uint32_t, uint16_t>& b) {
+                              return a.first == b.first;
+                            }),
+                index.end());
+    index.shrink_to_fit();
+    index_iter = entry_name_index_.emplace(static_cast<uint8_t>(type_idx), std::move(index)).first;
   }
-  return 0u;
-}
 
-std::unique_ptr<LoadedPackage> LoadedPackage::Load(const Chunk& chunk) {
-  ATRACE_CALL();
-  std::unique_ptr<LoadedPackage> loaded_package{new LoadedPackage()};
+  const std::vector<std::pair<uint32_t, uint16_t>>& index = index_iter->second;
+  auto result = std::lower_bound(
+      index.begin(), index.end(), static_cast<uint32_t>(key_idx),
+      [](const std::pair<uint32_t, uint16_t>& entry, uint32_t key) { return entry.first < key; });
+  if (result == index.end() || result->first != static_cast<uint32_t>(key_idx)) {
+    return 0u;
+  }
 
+  // The package ID will be overridden by the caller (due to runtime assignment of package IDs for
+  // shared libraries).
+  return make_resid(0x00, type_idx + type_id_offset_ + 1, result->second);
+}
+
+bool LoadedPackage::LoadHeader(const Chunk& chunk) {
   constexpr size_t kMinPackageSize =
       sizeof(ResTable_package) - sizeof(ResTable_package::typeIdOffset);
   const ResTable_package* header = chunk.header<ResTable_package, kMinPackageSize>();
   if (header == nullptr) {
     LOG(ERROR) << "Chunk RES_TABLE_PACKAGE_TYPE is too small.";
-    return {};
+    return false;
   }
 
-  loaded_package->package_id_ = dtohl(header->id);
-  if (loaded_package->package_id_ == 0) {
+  header_ = header;
+  package_id_ = dtohl(header->id);
+  if (package_id_ == 0) {
     // Package ID of 0 means this is a shared library.
-    loaded_package->dynamic_ = true;
+    dynamic_ = true;
   }
 
   if (header->header.headerSize >= sizeof(ResTable_package)) {
     uint32_t type_id_offset = dtohl(header->typeIdOffset);
     if (type_id_offset > std::numeric_limits<uint8_t>::max()) {
       LOG(ERROR) << "Type ID offset in RES_TABLE_PACKAGE_TYPE is too large.";
-      return {};
+      return false;
     }
-    loaded_package->type_id_offset_ = static_cast<int>(type_id_offset);
+    type_id_offset_ = static_cast<int>(type_id_offset);
   }
 
-  util::ReadUtf16StringFromDevice(header->name, arraysize(header->name),
-                                  &loaded_package->package_name_);
+  util::ReadUtf16StringFromDevice(header->name, arraysize(header->name), &package_name_);
+  return true;
+}
+
+std::unique_ptr<LoadedPackage> LoadedPackage::Load(const Chunk& chunk,
+                                                  const LoadedIdmap* loaded_idmap) {
+  ATRACE_CALL();
+  std::unique_ptr<LoadedPackage> loaded_package{new LoadedPackage()};
+  if (!loaded_package->LoadHeader(chunk)) {
+    return {};
+  }
+  const ResTable_package* header = loaded_package->header_;
+
+  // Stores a finished TypeSpec. An overlay's types are stored under the ID of the target type
+  // they overlay, so that lookups of target resource IDs land on them directly. Overlay types
+  // that the IDMAP doesn't map onto the target are dropped.
+  auto store_type_spec = [&](uint8_t type_idx, TypeSpecPtr type_spec_ptr) {
+    if (loaded_idmap == nullptr) {
+      loaded_package->type_specs_.editItemAt(type_idx) = std::move(type_spec_ptr);
+    } else if (type_spec_ptr->idmap_entries != nullptr) {
+      const uint16_t target_type_id = dtohs(type_spec_ptr->idmap_entries->target_type_id);
+      loaded_package->type_specs_.editItemAt(target_type_id - 1) = std::move(type_spec_ptr);
+    }
+  };
 
   // A TypeSpec builder. We use this to accumulate the set of Types
   // available for a TypeSpec, and later build a single, contiguous block
@@ -490,7 +737,7 @@ std::unique_ptr<LoadedPackage> LoadedPackage::Load(const Chunk& chunk) {
             LOG(ERROR) << "Too many type configurations, overflow detected.";
             return {};
           }
-          loaded_package->type_specs_.editItemAt(last_type_idx) = std::move(type_spec_ptr);
+          store_type_spec(last_type_idx, std::move(type_spec_ptr));
 
           types_builder = {};
           last_type_idx = 0;
@@ -530,8 +777,13 @@ std::unique_ptr<LoadedPackage> LoadedPackage::Load(const Chunk& chunk) {
           return {};
         }
 
+        const IdmapEntry_header* idmap_entry_header = nullptr;
+        if (loaded_idmap != nullptr) {
+          idmap_entry_header = loaded_idmap->GetEntryMapForType(type_spec->id);
+        }
+
         last_type_idx = type_spec->id - 1;
-        types_builder = util::make_unique<TypeSpecPtrBuilder>(type_spec);
+        types_builder = util::make_unique<TypeSpecPtrBuilder>(type_spec, idmap_entry_header);
       } break;
 
       case RES_TABLE_TYPE_TYPE: {
@@ -561,38 +813,10 @@ std::unique_ptr<LoadedPackage> LoadedPackage::Load(const Chunk& chunk) {
       } break;
 
       case RES_TABLE_LIBRARY_TYPE: {
-        const ResTable_lib_header* lib = child_chunk.header<ResTable_lib_header>();
-        if (lib == nullptr) {
-          LOG(ERROR) << "Chunk RES_TABLE_LIBRARY_TYPE is too small.";
-          return {};
-        }
-
-        if (child_chunk.data_size() / sizeof(ResTable_lib_entry) < dtohl(lib->count)) {
-          LOG(ERROR) << "Chunk too small to hold entries in RES_TABLE_LIBRARY_TYPE.";
+        if (!LoadDynamicPackageMap(child_chunk, &loaded_package->dynamic_package_map_)) {
           return {};
         }
-
-        loaded_package->dynamic_package_map_.reserve(dtohl(lib->count));
-
-        const ResTable_lib_entry* const entry_begin =
-            reinterpret_cast<const ResTable_lib_entry*>(child_chunk.data_ptr());
-        const ResTable_lib_entry* const entry_end = entry_begin + dtohl(lib->count);
-        for (auto entry_iter = entry_begin; entry_iter != entry_end; ++entry_iter) {
-          std::string package_name;
-          util::ReadUtf16StringFromDevice(entry_iter->packageName,
-                                          arraysize(entry_iter->packageName), &package_name);
-
-          if (dtohl(entry_iter->packageId) >= std::numeric_limits<uint8_t>::max()) {
-            LOG(ERROR) << base::StringPrintf(
-                "Package ID %02x in RES_TABLE_LIBRARY_TYPE too large for package '%s'.",
-                dtohl(entry_iter->packageId), package_name.c_str());
-            return {};
-          }
-
-          loaded_package->dynamic_package_map_.emplace_back(std::move(package_name),
-                                                            dtohl(entry_iter->packageId));
-        }
-
+        loaded_package->library_header_ = child_chunk.header<ResTable_lib_header>();
       } break;
 
       default:
@@ -608,23 +832,128 @@ std::unique_ptr<LoadedPackage> LoadedPackage::Load(const Chunk& chunk) {
       LOG(ERROR) << "Too many type configurations, overflow detected.";
       return {};
     }
-    loaded_package->type_specs_.editItemAt(last_type_idx) = std::move(type_spec_ptr);
+    store_type_spec(last_type_idx, std::move(type_spec_ptr));
   }
 
   if (iter.HadError()) {
     LOG(ERROR) << iter.GetLastError();
     return {};
   }
+
+  if (loaded_idmap != nullptr) {
+    // This is an overlay, so it needs to pretend to be the target package. Its types were stored
+    // under the target's (already offset) type IDs.
+    loaded_package->package_id_ = loaded_idmap->TargetPackageId();
+    loaded_package->type_id_offset_ = 0;
+    loaded_package->dynamic_ = false;
+    loaded_package->overlay_ = true;
+  }
   return loaded_package;
 }
 
-bool LoadedArsc::LoadTable(const Chunk& chunk, bool load_as_shared_library) {
+std::unique_ptr<LoadedPackage> LoadedPackage::LoadFromIndex(const void* data, size_t len,
+                                                           const ArscIndexHeader* index,
+                                                           const ArscIndexPackage& index_package) {
+  ATRACE_CALL();
+  const ResChunk_header* package_chunk =
+      GetIndexedChunk(data, len, index_package.package_offset, RES_TABLE_PACKAGE_TYPE);
+  if (package_chunk == nullptr) {
+    LOG(ERROR) << "Indexed RES_TABLE_PACKAGE_TYPE chunk is invalid.";
+    return {};
+  }
+
+  const Chunk chunk(package_chunk);
+  std::unique_ptr<LoadedPackage> loaded_package{new LoadedPackage()};
+  if (!loaded_package->LoadHeader(chunk)) {
+    return {};
+  }
+  const ResTable_package* header = loaded_package->header_;
+
+  // The string pool offsets are relative to the package header.
+  const ResChunk_header* type_strings =
+      GetIndexedChunk(header, chunk.size(), dtohl(header->typeStrings), RES_STRING_POOL_TYPE);
+  if (type_strings == nullptr ||
+      loaded_package->type_string_pool_.setTo(type_strings, dtohl(type_strings->size)) !=
+          NO_ERROR) {
+    LOG(ERROR) << "Corrupt package type string pool.";
+    return {};
+  }
+
+  const ResChunk_header* key_strings =
+      GetIndexedChunk(header, chunk.size(), dtohl(header->keyStrings), RES_STRING_POOL_TYPE);
+  if (key_strings == nullptr ||
+      loaded_package->key_string_pool_.setTo(key_strings, dtohl(key_strings->size)) != NO_ERROR) {
+    LOG(ERROR) << "Corrupt package key string pool.";
+    return {};
+  }
+
+  if (index_package.library_offset != 0u) {
+    const ResChunk_header* library_chunk =
+        GetIndexedChunk(data, len, index_package.library_offset, RES_TABLE_LIBRARY_TYPE);
+    if (library_chunk == nullptr) {
+      LOG(ERROR) << "Indexed RES_TABLE_LIBRARY_TYPE chunk is invalid.";
+      return {};
+    }
+
+    const Chunk child_chunk(library_chunk);
+    if (!LoadDynamicPackageMap(child_chunk, &loaded_package->dynamic_package_map_)) {
+      return {};
+    }
+    loaded_package->library_header_ = child_chunk.header<ResTable_lib_header>();
+  }
+
+  const ArscIndexTypeSpec* index_type_specs = GetIndexTypeSpecs(index);
+  const uint32_t* type_offsets = GetIndexTypeOffsets(index);
+  const uint32_t type_specs_end = index_package.first_type_spec + index_package.type_spec_count;
+  for (uint32_t i = index_package.first_type_spec; i < type_specs_end; i++) {
+    const ArscIndexTypeSpec& index_type_spec = index_type_specs[i];
+    const ResChunk_header* type_spec_chunk =
+        GetIndexedChunk(data, len, index_type_spec.type_spec_offset, RES_TABLE_TYPE_SPEC_TYPE);
+    const ResTable_typeSpec* type_spec =
+        type_spec_chunk != nullptr ? Chunk(type_spec_chunk).header<ResTable_typeSpec>() : nullptr;
+    if (type_spec == nullptr || type_spec->id == 0 ||
+        loaded_package->type_id_offset_ + static_cast<int>(type_spec->id) >
+            std::numeric_limits<uint8_t>::max()) {
+      LOG(ERROR) << "Indexed RES_TABLE_TYPE_SPEC_TYPE chunk is invalid.";
+      return {};
+    }
+
+    // The entries of every type were checked by VerifyType() when the index was written. The size
+    // and source CRC of the table were verified against the index, so they are still valid.
+    TypeSpecPtrBuilder types_builder(type_spec, nullptr /*idmap_header*/);
+    const uint32_t types_end = index_type_spec.first_type + index_type_spec.type_count;
+    for (uint32_t j = index_type_spec.first_type; j < types_end; j++) {
+      const ResChunk_header* type_chunk =
+          GetIndexedChunk(data, len, type_offsets[j], RES_TABLE_TYPE_TYPE);
+      const ResTable_type* type =
+          type_chunk != nullptr ? Chunk(type_chunk).header<ResTable_type, kResTableTypeMinSize>()
+                                : nullptr;
+      if (type == nullptr || type->id != type_spec->id) {
+        LOG(ERROR) << "Indexed RES_TABLE_TYPE_TYPE chunk is invalid.";
+        return {};
+      }
+      types_builder.AddType(type);
+    }
+
+    TypeSpecPtr type_spec_ptr = types_builder.Build();
+    if (type_spec_ptr == nullptr) {
+      LOG(ERROR) << "Too many type configurations, overflow detected.";
+      return {};
+    }
+    loaded_package->type_specs_.editItemAt(type_spec->id - 1) = std::move(type_spec_ptr);
+  }
+  return loaded_package;
+}
+
+bool LoadedArsc::LoadTable(const Chunk& chunk, const LoadedIdmap* loaded_idmap,
+                           bool load_as_shared_library) {
   ATRACE_CALL();
   const ResTable_header* header = chunk.header<ResTable_header>();
   if (header == nullptr) {
     LOG(ERROR) << "Chunk RES_TABLE_TYPE is too small.";
     return false;
   }
+  table_header_ = header;
 
   const size_t package_count = dtohl(header->packageCount);
   size_t packages_seen = 0;
@@ -644,6 +973,7 @@ bool LoadedArsc::LoadTable(const Chunk& chunk, bool load_as_shared_library) {
             LOG(ERROR) << "Corrupt string pool.";
             return false;
           }
+          string_pool_header_ = child_chunk.header<ResStringPool_header>();
         } else {
           LOG(WARNING) << "Multiple string pool chunks found in resource table.";
         }
@@ -658,7 +988,8 @@ bool LoadedArsc::LoadTable(const Chunk& chunk, bool load_as_shared_library) {
         }
         packages_seen++;
 
-        std::unique_ptr<LoadedPackage> loaded_package = LoadedPackage::Load(child_chunk);
+        std::unique_ptr<LoadedPackage> loaded_package =
+            LoadedPackage::Load(child_chunk, loaded_idmap);
         if (!loaded_package) {
           return false;
         }
@@ -686,18 +1017,26 @@ bool LoadedArsc::LoadTable(const Chunk& chunk, bool load_as_shared_library) {
 
 std::unique_ptr<const LoadedArsc> LoadedArsc::Load(const void* data, size_t len, bool system,
                                                    bool load_as_shared_library) {
+  return Load(data, len, nullptr /*loaded_idmap*/, system, load_as_shared_library);
+}
+
+std::unique_ptr<const LoadedArsc> LoadedArsc::Load(const void* data, size_t len,
+                                                   const LoadedIdmap* loaded_idmap, bool system,
+                                                   bool load_as_shared_library) {
   ATRACE_CALL();
 
   // Not using make_unique because the constructor is private.
   std::unique_ptr<LoadedArsc> loaded_arsc(new LoadedArsc());
   loaded_arsc->system_ = system;
+  loaded_arsc->data_ = data;
+  loaded_arsc->data_len_ = len;
 
   ChunkIterator iter(data, len);
   while (iter.HasNext()) {
     const Chunk chunk = iter.Next();
     switch (chunk.type()) {
       case RES_TABLE_TYPE:
-        if (!loaded_arsc->LoadTable(chunk, load_as_shared_library)) {
+        if (!loaded_arsc->LoadTable(chunk, loaded_idmap, load_as_shared_library)) {
           return {};
         }
         break;
@@ -717,4 +1056,179 @@ std::unique_ptr<const LoadedArsc> LoadedArsc::Load(const void* data, size_t len,
   return std::move(loaded_arsc);
 }
 
+std::unique_ptr<const LoadedArsc> LoadedArsc::LoadWithIndex(const void* data, size_t len,
+                                                            const void* index_data,
+                                                            size_t index_len, uint32_t source_crc,
+                                                            bool system,
+                                                            bool load_as_shared_library) {
+  ATRACE_CALL();
+  if (index_len < sizeof(ArscIndexHeader)) {
+    LOG(WARNING) << "Resource table index is too small.";
+    return {};
+  }
+
+  const ArscIndexHeader* index = reinterpret_cast<const ArscIndexHeader*>(index_data);
+  if (index->magic != kArscIndexMagic || index->version != kArscIndexVersion) {
+    LOG(WARNING) << "Resource table index has an unknown format.";
+    return {};
+  }
+
+  if (index->arsc_size != len || index->source_crc != source_crc) {
+    LOG(WARNING) << "Resource table index is stale.";
+    return {};
+  }
+
+  // Make sure all the arrays fit. Use 64-bit math so that the counts can't overflow.
+  const uint64_t expected_len = sizeof(ArscIndexHeader) +
+                                (uint64_t)index->package_count * sizeof(ArscIndexPackage) +
+                                (uint64_t)index->type_spec_count * sizeof(ArscIndexTypeSpec) +
+                                (uint64_t)index->type_count * sizeof(uint32_t);
+  if (expected_len > index_len) {
+    LOG(ERROR) << "Resource table index is truncated.";
+    return {};
+  }
+
+  // The ranges each package and type spec refer to must be inside the index.
+  const ArscIndexPackage* index_packages = GetIndexPackages(index);
+  for (uint32_t i = 0; i < index->package_count; i++) {
+    if (index_packages[i].type_spec_count > index->type_spec_count ||
+        index_packages[i].first_type_spec >
+            index->type_spec_count - index_packages[i].type_spec_count) {
+      LOG(ERROR) << "Resource table index has out of range package.";
+      return {};
+    }
+  }
+
+  const ArscIndexTypeSpec* index_type_specs = GetIndexTypeSpecs(index);
+  for (uint32_t i = 0; i < index->type_spec_count; i++) {
+    if (index_type_specs[i].type_count > index->type_count ||
+        index_type_specs[i].first_type > index->type_count - index_type_specs[i].type_count) {
+      LOG(ERROR) << "Resource table index has out of range type spec.";
+      return {};
+    }
+  }
+
+  // Not using make_unique because the constructor is private.
+  std::unique_ptr<LoadedArsc> loaded_arsc(new LoadedArsc());
+  loaded_arsc->system_ = system;
+  loaded_arsc->data_ = data;
+  loaded_arsc->data_len_ = len;
+
+  const ResChunk_header* table_chunk =
+      GetIndexedChunk(data, len, index->table_offset, RES_TABLE_TYPE);
+  if (table_chunk == nullptr ||
+      (loaded_arsc->table_header_ = Chunk(table_chunk).header<ResTable_header>()) == nullptr) {
+    LOG(ERROR) << "Indexed RES_TABLE_TYPE chunk is invalid.";
+    return {};
+  }
+
+  if (index->string_pool_offset != 0u) {
+    const ResChunk_header* pool_chunk =
+        GetIndexedChunk(data, len, index->string_pool_offset, RES_STRING_POOL_TYPE);
+    if (pool_chunk == nullptr ||
+        loaded_arsc->global_string_pool_.setTo(pool_chunk, dtohl(pool_chunk->size)) != NO_ERROR) {
+      LOG(ERROR) << "Corrupt string pool.";
+      return {};
+    }
+    loaded_arsc->string_pool_header_ = reinterpret_cast<const ResStringPool_header*>(pool_chunk);
+  }
+
+  loaded_arsc->packages_.reserve(index->package_count);
+  for (uint32_t i = 0; i < index->package_count; i++) {
+    std::unique_ptr<LoadedPackage> loaded_package =
+        LoadedPackage::LoadFromIndex(data, len, index, index_packages[i]);
+    if (!loaded_package) {
+      return {};
+    }
+
+    // Mark the package as dynamic if we are forcefully loading the Apk as a shared library.
+    if (loaded_package->package_id_ == kAppPackageId) {
+      loaded_package->dynamic_ = load_as_shared_library;
+    }
+    loaded_package->system_ = system;
+    loaded_arsc->packages_.push_back(std::move(loaded_package));
+  }
+
+  // Need to force a move for mingw32.
+  return std::move(loaded_arsc);
+}
+
+uint32_t LoadedArsc::OffsetOf(const void* ptr) const {
+  return static_cast<uint32_t>(reinterpret_cast<const uint8_t*>(ptr) -
+                               reinterpret_cast<const uint8_t*>(data_));
+}
+
+bool LoadedArsc::WriteIndex(uint32_t source_crc, std::string* out_index) const {
+  ATRACE_CALL();
+  if (table_header_ == nullptr || data_len_ > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+
+  // Overlay types are stored under their target's type IDs, which the index can't describe.
+  for (const auto& loaded_package : packages_) {
+    if (loaded_package->IsOverlay()) {
+      return false;
+    }
+  }
+
+  std::vector<ArscIndexPackage> index_packages;
+  std::vector<ArscIndexTypeSpec> index_type_specs;
+  std::vector<uint32_t> type_offsets;
+
+  index_packages.reserve(packages_.size());
+  for (const auto& loaded_package : packages_) {
+    ArscIndexPackage index_package;
+    index_package.package_offset = OffsetOf(loaded_package->header_);
+    index_package.library_offset = loaded_package->library_header_ != nullptr
+                                       ? OffsetOf(loaded_package->library_header_)
+                                       : 0u;
+    index_package.first_type_spec = static_cast<uint32_t>(index_type_specs.size());
+
+    const size_t type_spec_count = loaded_package->type_specs_.size();
+    for (size_t i = 0; i < type_spec_count; i++) {
+      const TypeSpecPtr& type_spec = loaded_package->type_specs_[i];
+      if (type_spec == nullptr) {
+        continue;
+      }
+
+      ArscIndexTypeSpec index_type_spec;
+      index_type_spec.type_spec_offset = OffsetOf(type_spec->type_spec);
+      index_type_spec.first_type = static_cast<uint32_t>(type_offsets.size());
+      index_type_spec.type_count = static_cast<uint32_t>(type_spec->type_count);
+      for (size_t j = 0; j < type_spec->type_count; j++) {
+        type_offsets.push_back(OffsetOf(type_spec->types[j].type));
+      }
+      index_type_specs.push_back(index_type_spec);
+    }
+
+    index_package.type_spec_count =
+        static_cast<uint32_t>(index_type_specs.size()) - index_package.first_type_spec;
+    index_packages.push_back(index_package);
+  }
+
+  ArscIndexHeader index;
+  index.magic = kArscIndexMagic;
+  index.version = kArscIndexVersion;
+  index.arsc_size = static_cast<uint32_t>(data_len_);
+  index.source_crc = source_crc;
+  index.table_offset = OffsetOf(table_header_);
+  index.string_pool_offset = string_pool_header_ != nullptr ? OffsetOf(string_pool_header_) : 0u;
+  index.package_count = static_cast<uint32_t>(index_packages.size());
+  index.type_spec_count = static_cast<uint32_t>(index_type_specs.size());
+  index.type_count = static_cast<uint32_t>(type_offsets.size());
+
+  out_index->clear();
+  out_index->reserve(sizeof(index) + index_packages.size() * sizeof(ArscIndexPackage) +
+                     index_type_specs.size() * sizeof(ArscIndexTypeSpec) +
+                     type_offsets.size() * sizeof(uint32_t));
+  out_index->append(reinterpret_cast<const char*>(&index), sizeof(index));
+  out_index->append(reinterpret_cast<const char*>(index_packages.data()),
+                    index_packages.size() * sizeof(ArscIndexPackage));
+  out_index->append(reinterpret_cast<const char*>(index_type_specs.data()),
+                    index_type_specs.size() * sizeof(ArscIndexTypeSpec));
+  out_index->append(reinterpret_cast<const char*>(type_offsets.data()),
+                    type_offsets.size() * sizeof(uint32_t));
+  return true;
+}
+
 }  // namespace android
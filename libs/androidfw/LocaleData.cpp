@@ -14,7 +14,6 @@
  * limitations under the License.
  */
 
-#include <array>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -132,6 +131,30 @@ inline bool isSpecialSpanish(uint32_t language_and_region) {
     return (language_and_region == US_SPANISH || language_and_region == MEXICAN_SPANISH);
 }
 
+// The full ancestor list of the last requested locale seen by localeDataCompareRegions() on this
+// thread. The requested locale is the configured one, so the comparisons made while resolving a
+// resource almost always share it, and its parent walk only needs to be done once.
+struct RequestAncestors {
+    bool valid = false;
+    uint32_t request = 0;
+    char script[SCRIPT_LENGTH] = {};
+    size_t count = 0;
+    uint32_t ancestors[MAX_PARENT_DEPTH+1];
+};
+
+static const RequestAncestors& getRequestAncestors(uint32_t request, const char* script) {
+    static thread_local RequestAncestors sLast;
+    if (!sLast.valid || sLast.request != request
+            || memcmp(sLast.script, script, SCRIPT_LENGTH) != 0) {
+        ssize_t unused_index;
+        sLast.count = findAncestors(sLast.ancestors, &unused_index, request, script, nullptr, 0);
+        sLast.request = request;
+        memcpy(sLast.script, script, SCRIPT_LENGTH);
+        sLast.valid = true;
+    }
+    return sLast;
+}
+
 int localeDataCompareRegions(
         const char* left_region, const char* right_region,
         const char* requested_language, const char* requested_script,
@@ -156,29 +179,26 @@ int localeDataCompareRegions(
         right = LATIN_AMERICAN_SPANISH;
     }
 
-    uint32_t request_ancestors[MAX_PARENT_DEPTH+1];
-    ssize_t left_right_index;
-    // Find the parents of the request, but stop as soon as we saw left or right
-    const std::array<uint32_t, 2> left_and_right = {{left, right}};
-    const size_t ancestor_count = findAncestors(
-            request_ancestors, &left_right_index,
-            request, requested_script,
-            left_and_right.data(), left_and_right.size());
-    if (left_right_index == 0) { // We saw left earlier
-        return 1;
-    }
-    if (left_right_index == 1) { // We saw right earlier
-        return -1;
+    // Look through the parents of the request for whichever of left or right comes first
+    const RequestAncestors& request_ancestors = getRequestAncestors(request, requested_script);
+    for (size_t i = 0; i < request_ancestors.count; i++) {
+        if (request_ancestors.ancestors[i] == left) { // We saw left earlier
+            return 1;
+        }
+        if (request_ancestors.ancestors[i] == right) { // We saw right earlier
+            return -1;
+        }
     }
+    const size_t ancestor_count = request_ancestors.count;
 
     // If we are here, neither left nor right are an ancestor of the
     // request. This means that all the ancestors have been computed and
     // the last ancestor is just the language by itself. We will use the
     // distance in the parent tree for determining the better match.
     const size_t left_distance = findDistance(
-            left, requested_script, request_ancestors, ancestor_count);
+            left, requested_script, request_ancestors.ancestors, ancestor_count);
     const size_t right_distance = findDistance(
-            right, requested_script, request_ancestors, ancestor_count);
+            right, requested_script, request_ancestors.ancestors, ancestor_count);
     if (left_distance != right_distance) {
         return (int) right_distance - (int) left_distance; // smaller distance is better
     }
@@ -43,6 +43,8 @@
 
 #define kMaxBufSize    32768 /* Maximum file read buffer */
 
+#define kFooterReadSize 1024 /* Bytes read from the end of the file to find the footer */
+
 #define kSignature     0x01059983U /* ObbFile signature */
 
 #define kSigVersion    1 /* We only know about signature version 1 */
@@ -127,61 +129,60 @@ bool ObbFile::parseObbFile(int fd)
         return false;
     }
 
-    ssize_t actual;
-    size_t footerSize;
-
-    {
-        lseek64(fd, fileLength - kFooterTagSize, SEEK_SET);
-
-        char footer[kFooterTagSize];
-        actual = TEMP_FAILURE_RETRY(read(fd, footer, kFooterTagSize));
-        if (actual != kFooterTagSize) {
-            ALOGW("couldn't read footer signature: %s\n", strerror(errno));
-            return false;
-        }
-
-        unsigned int fileSig = get4LE((unsigned char*)footer + sizeof(int32_t));
-        if (fileSig != kSignature) {
-            ALOGW("footer didn't match magic string (expected 0x%08x; got 0x%08x)\n",
-                    kSignature, fileSig);
-            return false;
-        }
+    // The footer is normally much smaller than this, so a single read of the end of the
+    // file usually gets all of it
+    char tail[kFooterReadSize];
+    const size_t tailSize = fileLength < kFooterReadSize ? (size_t)fileLength : kFooterReadSize;
+    ssize_t actual = TEMP_FAILURE_RETRY(pread64(fd, tail, tailSize, fileLength - tailSize));
+    if (actual != (ssize_t)tailSize) {
+        ALOGW("couldn't read footer signature: %s\n", strerror(errno));
+        return false;
+    }
 
-        footerSize = get4LE((unsigned char*)footer);
-        if (footerSize > (size_t)fileLength - kFooterTagSize
-                || footerSize > kMaxBufSize) {
-            ALOGW("claimed footer size is too large (0x%08zx; file size is 0x%08lld)\n",
-                    footerSize, (long long int)fileLength);
-            return false;
-        }
+    const unsigned char* footer = (unsigned char*)tail + tailSize - kFooterTagSize;
+    unsigned int fileSig = get4LE(footer + sizeof(int32_t));
+    if (fileSig != kSignature) {
+        ALOGW("footer didn't match magic string (expected 0x%08x; got 0x%08x)\n",
+                kSignature, fileSig);
+        return false;
+    }
 
-        if (footerSize < (kFooterMinSize - kFooterTagSize)) {
-            ALOGW("claimed footer size is too small (0x%zx; minimum size is 0x%x)\n",
-                    footerSize, kFooterMinSize - kFooterTagSize);
-            return false;
-        }
+    size_t footerSize = get4LE(footer);
+    if (footerSize > (size_t)fileLength - kFooterTagSize
+            || footerSize > kMaxBufSize) {
+        ALOGW("claimed footer size is too large (0x%08zx; file size is 0x%08lld)\n",
+                footerSize, (long long int)fileLength);
+        return false;
     }
 
-    off64_t fileOffset = fileLength - footerSize - kFooterTagSize;
-    if (lseek64(fd, fileOffset, SEEK_SET) != fileOffset) {
-        ALOGW("seek %lld failed: %s\n", (long long int)fileOffset, strerror(errno));
+    if (footerSize < (kFooterMinSize - kFooterTagSize)) {
+        ALOGW("claimed footer size is too small (0x%zx; minimum size is 0x%x)\n",
+                footerSize, kFooterMinSize - kFooterTagSize);
         return false;
     }
 
+    off64_t fileOffset = fileLength - footerSize - kFooterTagSize;
     mFooterStart = fileOffset;
 
-    char* scanBuf = (char*)malloc(footerSize);
-    if (scanBuf == NULL) {
-        ALOGW("couldn't allocate scanBuf: %s\n", strerror(errno));
-        return false;
-    }
+    char* allocatedBuf = NULL;
+    char* scanBuf;
+    if (footerSize + kFooterTagSize <= tailSize) {
+        scanBuf = tail + tailSize - kFooterTagSize - footerSize;
+    } else {
+        allocatedBuf = (char*)malloc(footerSize);
+        if (allocatedBuf == NULL) {
+            ALOGW("couldn't allocate scanBuf: %s\n", strerror(errno));
+            return false;
+        }
 
-    actual = TEMP_FAILURE_RETRY(read(fd, scanBuf, footerSize));
-    // readAmount is guaranteed to be less than kMaxBufSize
-    if (actual != (ssize_t)footerSize) {
-        ALOGI("couldn't read ObbFile footer: %s\n", strerror(errno));
-        free(scanBuf);
-        return false;
+        actual = TEMP_FAILURE_RETRY(pread64(fd, allocatedBuf, footerSize, fileOffset));
+        // readAmount is guaranteed to be less than kMaxBufSize
+        if (actual != (ssize_t)footerSize) {
+            ALOGI("couldn't read ObbFile footer: %s\n", strerror(errno));
+            free(allocatedBuf);
+            return false;
+        }
+        scanBuf = allocatedBuf;
     }
 
 #ifdef DEBUG
@@ -193,7 +194,7 @@ bool ObbFile::parseObbFile(int fd)
     uint32_t sigVersion = get4LE((unsigned char*)scanBuf);
     if (sigVersion != kSigVersion) {
         ALOGW("Unsupported ObbFile version %d\n", sigVersion);
-        free(scanBuf);
+        free(allocatedBuf);
         return false;
     }
 
@@ -207,14 +208,14 @@ bool ObbFile::parseObbFile(int fd)
             || packageNameLen > (footerSize - kPackageNameOffset)) {
         ALOGW("bad ObbFile package name length (0x%04zx; 0x%04zx possible)\n",
                 packageNameLen, footerSize - kPackageNameOffset);
-        free(scanBuf);
+        free(allocatedBuf);
         return false;
     }
 
     char* packageName = reinterpret_cast<char*>(scanBuf + kPackageNameOffset);
     mPackageName = String8(const_cast<char*>(packageName), packageNameLen);
 
-    free(scanBuf);
+    free(allocatedBuf);
 
 #ifdef DEBUG
     ALOGI("Obb scan succeeded: packageName=%s, version=%d\n", mPackageName.string(), mVersion);
@@ -255,53 +256,28 @@ bool ObbFile::writeTo(int fd)
         return false;
     }
 
-    unsigned char intBuf[sizeof(uint32_t)+1];
-    memset(&intBuf, 0, sizeof(intBuf));
-
-    put4LE(intBuf, kSigVersion);
-    if (write(fd, &intBuf, sizeof(uint32_t)) != (ssize_t)sizeof(uint32_t)) {
-        ALOGW("couldn't write signature version: %s\n", strerror(errno));
-        return false;
-    }
-
-    put4LE(intBuf, mVersion);
-    if (write(fd, &intBuf, sizeof(uint32_t)) != (ssize_t)sizeof(uint32_t)) {
-        ALOGW("couldn't write package version\n");
-        return false;
-    }
-
-    put4LE(intBuf, mFlags);
-    if (write(fd, &intBuf, sizeof(uint32_t)) != (ssize_t)sizeof(uint32_t)) {
-        ALOGW("couldn't write package version\n");
-        return false;
-    }
-
-    if (write(fd, mSalt, sizeof(mSalt)) != (ssize_t)sizeof(mSalt)) {
-        ALOGW("couldn't write salt: %s\n", strerror(errno));
-        return false;
-    }
-
+    // Build the whole footer first so it goes out in a single write
     size_t packageNameLen = mPackageName.size();
-    put4LE(intBuf, packageNameLen);
-    if (write(fd, &intBuf, sizeof(uint32_t)) != (ssize_t)sizeof(uint32_t)) {
-        ALOGW("couldn't write package name length: %s\n", strerror(errno));
+    size_t footerSize = kPackageNameOffset + packageNameLen + kFooterTagSize;
+    unsigned char* footer = (unsigned char*)malloc(footerSize);
+    if (footer == NULL) {
+        ALOGW("couldn't allocate footer: %s\n", strerror(errno));
         return false;
     }
 
-    if (write(fd, mPackageName.string(), packageNameLen) != (ssize_t)packageNameLen) {
-        ALOGW("couldn't write package name: %s\n", strerror(errno));
-        return false;
-    }
-
-    put4LE(intBuf, kPackageNameOffset + packageNameLen);
-    if (write(fd, &intBuf, sizeof(uint32_t)) != (ssize_t)sizeof(uint32_t)) {
-        ALOGW("couldn't write footer size: %s\n", strerror(errno));
-        return false;
-    }
-
-    put4LE(intBuf, kSignature);
-    if (write(fd, &intBuf, sizeof(uint32_t)) != (ssize_t)sizeof(uint32_t)) {
-        ALOGW("couldn't write footer magic signature: %s\n", strerror(errno));
+    put4LE(footer, kSigVersion);
+    put4LE(footer + kPackageVersionOffset, mVersion);
+    put4LE(footer + kFlagsOffset, mFlags);
+    memcpy(footer + kSaltOffset, mSalt, sizeof(mSalt));
+    put4LE(footer + kPackageNameLenOffset, packageNameLen);
+    memcpy(footer + kPackageNameOffset, mPackageName.string(), packageNameLen);
+    put4LE(footer + kPackageNameOffset + packageNameLen, kPackageNameOffset + packageNameLen);
+    put4LE(footer + kPackageNameOffset + packageNameLen + sizeof(uint32_t), kSignature);
+
+    ssize_t actual = TEMP_FAILURE_RETRY(write(fd, footer, footerSize));
+    free(footer);
+    if (actual != (ssize_t)footerSize) {
+        ALOGW("couldn't write footer: %s\n", strerror(errno));
         return false;
     }
 
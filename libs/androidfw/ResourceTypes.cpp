@@ -28,6 +28,8 @@
 #include <limits>
 #include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <androidfw/ByteBucketArray.h>
 #include <androidfw/ResourceTypes.h>
@@ -2755,6 +2757,48 @@ bool ResTable_config::match(const ResTable_config& settings) const {
     return true;
 }
 
+uint64_t ResTable_config::packExactQualifiers(uint64_t* outMask) const {
+    uint64_t packed = 0;
+    uint64_t mask = 0;
+    int shift = 0;
+
+    // Each qualifier is packed under its own mask, so that the bits of a qualifier only
+    // contribute to `mask` when that qualifier is set.
+    auto pack = [&](uint32_t value, uint32_t qualifierMask) {
+        const uint64_t bits = static_cast<uint64_t>(value & qualifierMask) << shift;
+        packed |= bits;
+        if (bits != 0) {
+            mask |= static_cast<uint64_t>(qualifierMask) << shift;
+        }
+    };
+
+    pack(orientation, 0xff);
+    shift += 8;
+    pack(touchscreen, 0xff);
+    shift += 8;
+    pack(keyboard, 0xff);
+    shift += 8;
+    pack(navigation, 0xff);
+    shift += 8;
+    pack(screenLayout, MASK_LAYOUTDIR);
+    pack(screenLayout, MASK_SCREENLONG);
+    shift += 8;
+    pack(uiMode, MASK_UI_MODE_TYPE);
+    pack(uiMode, MASK_UI_MODE_NIGHT);
+    shift += 8;
+    pack(inputFlags, MASK_NAVHIDDEN);
+    shift += 8;
+    pack(colorMode, MASK_WIDE_COLOR_GAMUT);
+    pack(colorMode, MASK_HDR);
+    shift += 4;
+    pack(screenLayout2, MASK_SCREENROUND);
+
+    if (outMask != NULL) {
+        *outMask = mask;
+    }
+    return packed;
+}
+
 void ResTable_config::appendDirLocale(String8& out) const {
     if (!language[0]) {
         return;
@@ -3270,6 +3314,17 @@ struct ResTable::Type
     const uint32_t*                 typeSpecFlags;
     IdmapEntries                    idmapEntries;
     Vector<const ResTable_type*>    configs;
+
+    // Returns the index of the entry named by the key string at keyIndex, or -1. The name
+    // index is built on the first call.
+    ssize_t findEntryIndexForKey(uint32_t keyIndex) const;
+
+    // The (key string index, entry index) of every entry defined by configs, sorted by key
+    // string index. Rebuilt if configs grew since it was built. Types are shared between the
+    // ResTables of a process through add(ResTable*), so this is guarded by the process-wide
+    // gEntryNameIndexLock rather than a lock of the table.
+    mutable std::vector<std::pair<uint32_t, uint32_t>> entryNameIndex;
+    mutable size_t                  entryNameIndexConfigCount = 0;
 };
 
 struct ResTable::Package
@@ -3833,17 +3888,18 @@ status_t ResTable::add(ResTable* src, bool isSystemAsset)
         PackageGroup* srcPg = src->mPackageGroups[i];
         PackageGroup* pg = new PackageGroup(this, srcPg->name, srcPg->id,
                 false /* appAsLib */, isSystemAsset || srcPg->isSystemAsset);
-        for (size_t j=0; j<srcPg->packages.size(); j++) {
-            pg->packages.add(srcPg->packages[j]);
-        }
+
+        // The group is new, so its lists can share the storage of the source's. Vector is
+        // copy-on-write, and the source is usually the process-wide table of a system package,
+        // so every AssetManager of the process would otherwise hold its own copy of each list.
+        pg->packages = srcPg->packages;
 
         for (size_t j = 0; j < srcPg->types.size(); j++) {
             if (srcPg->types[j].isEmpty()) {
                 continue;
             }
 
-            TypeList& typeList = pg->types.editItemAt(j);
-            typeList.appendVector(srcPg->types[j]);
+            pg->types.editItemAt(j) = srcPg->types[j];
         }
         pg->dynamicRefTable.addMappings(srcPg->dynamicRefTable);
         pg->largestTypeId = max(pg->largestTypeId, srcPg->largestTypeId);
@@ -4773,6 +4829,53 @@ nope:
     return 0;
 }
 
+static bool entryNameIndexLess(const std::pair<uint32_t, uint32_t>& entry, uint32_t keyIndex) {
+    return entry.first < keyIndex;
+}
+
+static Mutex gEntryNameIndexLock;
+
+ssize_t ResTable::Type::findEntryIndexForKey(uint32_t keyIndex) const {
+    AutoMutex _l(gEntryNameIndexLock);
+    const size_t configCount = configs.size();
+    if (entryNameIndexConfigCount != configCount) {
+        entryNameIndex.clear();
+        for (size_t j = 0; j < configCount; j++) {
+            const TypeVariant tv(configs[j]);
+            for (TypeVariant::iterator iter = tv.beginEntries();
+                 iter != tv.endEntries();
+                 iter++) {
+                const ResTable_entry* entry = *iter;
+                if (entry != NULL) {
+                    entryNameIndex.push_back(std::make_pair(dtohl(entry->key.index),
+                            (uint32_t) iter.index()));
+                }
+            }
+        }
+
+        // Keep the first config that defines a key, like a scan of the configs would. The sort
+        // is stable, so equal keys stay in config order.
+        std::stable_sort(entryNameIndex.begin(), entryNameIndex.end(),
+                [](const std::pair<uint32_t, uint32_t>& a,
+                   const std::pair<uint32_t, uint32_t>& b) {
+                    return a.first < b.first;
+                });
+        entryNameIndex.erase(std::unique(entryNameIndex.begin(), entryNameIndex.end(),
+                [](const std::pair<uint32_t, uint32_t>& a,
+                   const std::pair<uint32_t, uint32_t>& b) {
+                    return a.first == b.first;
+                }), entryNameIndex.end());
+        entryNameIndexConfigCount = configCount;
+    }
+
+    auto result = std::lower_bound(entryNameIndex.begin(), entryNameIndex.end(), keyIndex,
+            entryNameIndexLess);
+    if (result == entryNameIndex.end() || result->first != keyIndex) {
+        return -1;
+    }
+    return result->second;
+}
+
 uint32_t ResTable::findEntry(const PackageGroup* group, ssize_t typeIndex, const char16_t* name,
         size_t nameLen, uint32_t* outTypeSpecFlags) const {
     const TypeList& typeList = group->types[typeIndex];
@@ -4784,31 +4887,21 @@ uint32_t ResTable::findEntry(const PackageGroup* group, ssize_t typeIndex, const
             continue;
         }
 
-        const size_t configCount = t->configs.size();
-        for (size_t j = 0; j < configCount; j++) {
-            const TypeVariant tv(t->configs[j]);
-            for (TypeVariant::iterator iter = tv.beginEntries();
-                 iter != tv.endEntries();
-                 iter++) {
-                const ResTable_entry* entry = *iter;
-                if (entry == NULL) {
-                    continue;
-                }
+        const ssize_t entryIndex = t->findEntryIndexForKey((uint32_t) ei);
+        if (entryIndex < 0) {
+            continue;
+        }
 
-                if (dtohl(entry->key.index) == (size_t) ei) {
-                    uint32_t resId = Res_MAKEID(group->id - 1, typeIndex, iter.index());
-                    if (outTypeSpecFlags) {
-                        Entry result;
-                        if (getEntry(group, typeIndex, iter.index(), NULL, &result) != NO_ERROR) {
-                            ALOGW("Failed to find spec flags for 0x%08x", resId);
-                            return 0;
-                        }
-                        *outTypeSpecFlags = result.specFlags;
-                    }
-                    return resId;
-                }
+        uint32_t resId = Res_MAKEID(group->id - 1, typeIndex, entryIndex);
+        if (outTypeSpecFlags) {
+            Entry result;
+            if (getEntry(group, typeIndex, entryIndex, NULL, &result) != NO_ERROR) {
+                ALOGW("Failed to find spec flags for 0x%08x", resId);
+                return 0;
             }
+            *outTypeSpecFlags = result.specFlags;
         }
+        return resId;
     }
     return 0;
 }
@@ -5903,6 +5996,25 @@ uint32_t ResTable::getLastTypeIdForPackage(size_t idx) const
     return group->largestTypeId;
 }
 
+size_t ResTable::getEntryCountForType(size_t idx, uint32_t typeId) const
+{
+    if (mError != NO_ERROR || typeId == 0 || typeId > 0xff) {
+        return 0;
+    }
+    LOG_FATAL_IF(idx >= mPackageGroups.size(),
+            "Requested package index %d past package count %d",
+            (int)idx, (int)mPackageGroups.size());
+    const TypeList& typeList = mPackageGroups[idx]->types[typeId - 1];
+    size_t count = 0;
+    const size_t typeCount = typeList.size();
+    for (size_t i = 0; i < typeCount; i++) {
+        if (typeList[i]->entryCount > count) {
+            count = typeList[i]->entryCount;
+        }
+    }
+    return count;
+}
+
 size_t ResTable::getTableCount() const
 {
     return mHeaders.size();
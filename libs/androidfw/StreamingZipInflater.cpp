@@ -64,6 +64,7 @@ StreamingZipInflater::StreamingZipInflater(int fd, off64_t compDataStart,
     mOutBufSize = StreamingZipInflater::OUTPUT_CHUNK_SIZE;
     mOutBuf = new uint8_t[mOutBufSize];
 
+    initReadAheadState();
     initInflateState();
 }
 
@@ -82,10 +83,17 @@ StreamingZipInflater::StreamingZipInflater(FileMap* dataMap, size_t uncompSize)
     mOutBufSize = StreamingZipInflater::OUTPUT_CHUNK_SIZE;
     mOutBuf = new uint8_t[mOutBufSize];
 
+    initReadAheadState();
     initInflateState();
 }
 
 StreamingZipInflater::~StreamingZipInflater() {
+#if !defined(_WIN32)
+    // the worker may still be using the z_stream and the buffers
+    stopReadAhead();
+    delete [] mAheadBuf;
+#endif
+
     // tear down the in-flight zip state just in case
     ::inflateEnd(&mInflateState);
 
@@ -95,6 +103,16 @@ StreamingZipInflater::~StreamingZipInflater() {
     delete [] mOutBuf;
 }
 
+void StreamingZipInflater::initReadAheadState() {
+    mReadAhead = false;
+#if !defined(_WIN32)
+    mAheadBuf = NULL;
+    mAheadDecoded = 0;
+    mAheadResult = 0;
+    mAheadReady = mAheadDone = mAheadStop = false;
+#endif
+}
+
 void StreamingZipInflater::initInflateState() {
     ALOGV("Initializing inflate state");
 
@@ -119,6 +137,13 @@ void StreamingZipInflater::initInflateState() {
     }
 }
 
+void StreamingZipInflater::resetInflateState() {
+    if (!mStreamNeedsInit) {
+        ::inflateEnd(&mInflateState);
+    }
+    initInflateState();
+}
+
 /*
  * Basic approach:
  *
@@ -151,59 +176,184 @@ ssize_t StreamingZipInflater::read(void* outBuf, size_t count) {
 
         // need more data?  time to decode some.
         if (toRead > 0) {
-            // if we don't have any data to decode, read some in.  If we're working
-            // from mmapped data this won't happen, because the clipping to total size
-            // will prevent reading off the end of the mapped input chunk.
-            if ((mInflateState.avail_in == 0) && (mDataMap == NULL)) {
-                int err = readNextChunk();
-                if (err < 0) {
-                    ALOGE("Unable to access asset data: %d", err);
-                    if (!mStreamNeedsInit) {
-                        ::inflateEnd(&mInflateState);
-                        initInflateState();
-                    }
-                    return -1;
-                }
-            }
-            // we know we've drained whatever is in the out buffer now, so just
-            // start from scratch there, reading all the input we have at present.
-            mInflateState.next_out = (Bytef*) mOutBuf;
-            mInflateState.avail_out = mOutBufSize;
-
-            /*
-            ALOGV("Inflating to outbuf: avail_in=%u avail_out=%u next_in=%p next_out=%p",
-                    mInflateState.avail_in, mInflateState.avail_out,
-                    mInflateState.next_in, mInflateState.next_out);
-            */
-            int result = Z_OK;
-            if (mStreamNeedsInit) {
-                ALOGV("Initializing zlib to inflate");
-                result = inflateInit2(&mInflateState, -MAX_WBITS);
-                mStreamNeedsInit = false;
-            }
-            if (result == Z_OK) result = ::inflate(&mInflateState, Z_SYNC_FLUSH);
-            if (result < 0) {
-                // Whoops, inflation failed
-                ALOGE("Error inflating asset: %d", result);
-                ::inflateEnd(&mInflateState);
-                initInflateState();
+            if (fillOutBuf() < 0) {
                 return -1;
-            } else {
-                if (result == Z_STREAM_END) {
-                    // we know we have to have reached the target size here and will
-                    // not try to read any further, so just wind things up.
-                    ::inflateEnd(&mInflateState);
-                }
-
-                // Note how much data we got, and off we go
-                mOutDeliverable = 0;
-                mOutLastDecoded = mOutBufSize - mInflateState.avail_out;
             }
         }
     }
     return bytesRead;
 }
 
+/*
+ * Decode the next window of output into 'buf'.  The caller owns the z_stream
+ * for the duration of the call: either the reading thread, or the read-ahead
+ * worker while it is running.
+ */
+int StreamingZipInflater::inflateNextWindow(uint8_t* buf, size_t* outDecoded) {
+    // if we don't have any data to decode, read some in.  If we're working
+    // from mmapped data this won't happen, because the clipping to total size
+    // will prevent reading off the end of the mapped input chunk.
+    if ((mInflateState.avail_in == 0) && (mDataMap == NULL)) {
+        int err = readNextChunk();
+        if (err < 0) {
+            ALOGE("Unable to access asset data: %d", err);
+            return -1;
+        }
+    }
+    // the window being filled holds no undelivered data, so just start from
+    // scratch there, reading all the input we have at present.
+    mInflateState.next_out = (Bytef*) buf;
+    mInflateState.avail_out = mOutBufSize;
+
+    /*
+    ALOGV("Inflating to outbuf: avail_in=%u avail_out=%u next_in=%p next_out=%p",
+            mInflateState.avail_in, mInflateState.avail_out,
+            mInflateState.next_in, mInflateState.next_out);
+    */
+    int result = Z_OK;
+    if (mStreamNeedsInit) {
+        ALOGV("Initializing zlib to inflate");
+        result = inflateInit2(&mInflateState, -MAX_WBITS);
+        mStreamNeedsInit = false;
+    }
+    if (result == Z_OK) result = ::inflate(&mInflateState, Z_SYNC_FLUSH);
+    if (result < 0) {
+        // Whoops, inflation failed
+        ALOGE("Error inflating asset: %d", result);
+        return -1;
+    }
+    if (result == Z_STREAM_END) {
+        // we know we have to have reached the target size here and will
+        // not try to read any further, so just wind things up.
+        ::inflateEnd(&mInflateState);
+    }
+
+    // Note how much data we got, and off we go
+    *outDecoded = mOutBufSize - mInflateState.avail_out;
+    return 0;
+}
+
+/*
+ * Replace the drained contents of mOutBuf with the next window of output.
+ * With read-ahead enabled that window has usually been decoded already, and
+ * handing it over just swaps it with the back buffer.  On error the inflate
+ * state is rewound to the start of the data.
+ */
+int StreamingZipInflater::fillOutBuf() {
+#if !defined(_WIN32)
+    if (mReadAhead) {
+        if (!mAheadThread.joinable()) {
+            if (mAheadBuf == NULL) {
+                mAheadBuf = new uint8_t[mOutBufSize];
+            }
+            // everything decoded so far has been delivered, so the stream is
+            // positioned at mOutCurPosition
+            mAheadThread = std::thread(&StreamingZipInflater::readAheadLoop, this,
+                    mOutCurPosition);
+        }
+
+        std::unique_lock<std::mutex> lock(mAheadLock);
+        mAheadCond.wait(lock, [this] { return mAheadReady || mAheadDone; });
+        // the worker only stops on its own once it has produced all of the data
+        // or failed, so running out of windows here means the data is truncated
+        int result = mAheadReady ? mAheadResult : -1;
+        if (result == 0) {
+            uint8_t* drained = mOutBuf;
+            mOutBuf = mAheadBuf;
+            mAheadBuf = drained;
+            mOutDeliverable = 0;
+            mOutLastDecoded = mAheadDecoded;
+        }
+        mAheadReady = false;
+        lock.unlock();
+        mAheadCond.notify_all();
+
+        if (result < 0) {
+            stopReadAhead();
+            resetInflateState();
+        }
+        return result;
+    }
+#endif
+
+    size_t decoded = 0;
+    if (inflateNextWindow(mOutBuf, &decoded) < 0) {
+        resetInflateState();
+        return -1;
+    }
+    mOutDeliverable = 0;
+    mOutLastDecoded = decoded;
+    return 0;
+}
+
+void StreamingZipInflater::setReadAhead(bool enabled) {
+#if !defined(_WIN32)
+    if (enabled == mReadAhead) {
+        return;
+    }
+    mReadAhead = enabled;
+    if (!enabled && mAheadThread.joinable()) {
+        // the worker has decoded past the window being delivered, so the
+        // synchronous path has to replay the stream up to the current position
+        off64_t position = mOutCurPosition;
+        stopReadAhead();
+        resetInflateState();
+        read(NULL, position);
+    }
+#else
+    (void) enabled;
+#endif
+}
+
+#if !defined(_WIN32)
+/*
+ * Body of the read-ahead worker.  Decodes one window ahead of the reader into
+ * mAheadBuf, then waits for the reader to take it before decoding the next.
+ * 'decodedTotal' is the amount of output the stream has produced on entry.
+ */
+void StreamingZipInflater::readAheadLoop(off64_t decodedTotal) {
+    std::unique_lock<std::mutex> lock(mAheadLock);
+    while (!mAheadStop) {
+        uint8_t* buf = mAheadBuf;
+        lock.unlock();
+        size_t decoded = 0;
+        int result = inflateNextWindow(buf, &decoded);
+        lock.lock();
+
+        mAheadDecoded = decoded;
+        mAheadResult = result;
+        mAheadReady = true;
+        mAheadCond.notify_all();
+
+        decodedTotal += decoded;
+        if (result < 0 || decodedTotal >= (off64_t) mOutTotalSize) {
+            break;
+        }
+        mAheadCond.wait(lock, [this] { return !mAheadReady || mAheadStop; });
+    }
+    mAheadDone = true;
+    mAheadCond.notify_all();
+}
+
+/*
+ * Stop the read-ahead worker, waiting for any window it is decoding.  Any
+ * window it prepared is discarded, so callers must rewind the inflate state
+ * afterwards.
+ */
+void StreamingZipInflater::stopReadAhead() {
+    if (!mAheadThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mAheadLock);
+        mAheadStop = true;
+    }
+    mAheadCond.notify_all();
+    mAheadThread.join();
+    mAheadReady = mAheadDone = mAheadStop = false;
+}
+#endif
+
 int StreamingZipInflater::readNextChunk() {
     assert(mDataMap == NULL);
 
@@ -233,10 +383,10 @@ int StreamingZipInflater::readNextChunk() {
 off64_t StreamingZipInflater::seekAbsolute(off64_t absoluteInputPosition) {
     if (absoluteInputPosition < mOutCurPosition) {
         // rewind and reprocess the data from the beginning
-        if (!mStreamNeedsInit) {
-            ::inflateEnd(&mInflateState);
-        }
-        initInflateState();
+#if !defined(_WIN32)
+        stopReadAhead();
+#endif
+        resetInflateState();
         read(NULL, absoluteInputPosition);
     } else if (absoluteInputPosition > mOutCurPosition) {
         read(NULL, absoluteInputPosition - mOutCurPosition);
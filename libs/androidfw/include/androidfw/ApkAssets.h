@@ -17,13 +17,18 @@
 #ifndef APKASSETS_H_
 #define APKASSETS_H_
 
+#include <deque>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "android-base/macros.h"
+#include "utils/FileMap.h"
+#include "utils/Mutex.h"
 #include "ziparchive/zip_archive.h"
 
 #include "androidfw/Asset.h"
+#include "androidfw/Idmap.h"
 #include "androidfw/LoadedArsc.h"
 #include "androidfw/misc.h"
 
@@ -36,6 +41,27 @@ class ApkAssets {
   static std::unique_ptr<const ApkAssets> LoadAsSharedLibrary(const std::string& path,
                                                               bool system = false);
 
+  // Creates an ApkAssets from the IDMAP at `idmap_path`. The overlay APK path is read from the
+  // IDMAP, and the IDMAP stays mapped for the lifetime of the ApkAssets so that target resource IDs
+  // are redirected to the overlay without copying or rebuilding any tables.
+  static std::unique_ptr<const ApkAssets> LoadOverlay(const std::string& idmap_path,
+                                                      bool system = false);
+
+  // Loads the APK at `path`, using the resource table index at `index_path` (as written by
+  // WriteArscIndex()) to avoid parsing resources.arsc. If the index is missing or stale, the
+  // resource table is parsed as it would be with Load().
+  static std::unique_ptr<const ApkAssets> LoadWithArscIndex(const std::string& path,
+                                                            const std::string& index_path,
+                                                            bool system = false);
+
+  // Writes an index of this APK's resource table to `index_path`, for use with
+  // LoadWithArscIndex().
+  bool WriteArscIndex(const std::string& index_path) const;
+
+  // Opens the file at `path` in this APK. Uncompressed entries are served from a small cache of
+  // recently opened mappings, so repeated opens of the same entry share a single FileMap instead
+  // of searching the zip central directory and mapping the region again.
+  // This method is thread-safe.
   std::unique_ptr<Asset> Open(const std::string& path,
                               Asset::AccessMode mode = Asset::AccessMode::ACCESS_RANDOM) const;
 
@@ -46,11 +72,17 @@ class ApkAssets {
 
   inline const LoadedArsc* GetLoadedArsc() const { return loaded_arsc_.get(); }
 
+  // Returns true if this ApkAssets is a Runtime Resource Overlay loaded with LoadOverlay().
+  inline bool IsOverlay() const { return loaded_idmap_ != nullptr; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(ApkAssets);
 
-  static std::unique_ptr<const ApkAssets> LoadImpl(const std::string& path, bool system,
-                                                   bool load_as_shared_library);
+  static std::unique_ptr<const ApkAssets> LoadImpl(const std::string& path,
+                                                   const std::string& index_path,
+                                                   std::unique_ptr<FileMap> idmap_map,
+                                                   std::unique_ptr<const LoadedIdmap> loaded_idmap,
+                                                   bool system, bool load_as_shared_library);
 
   ApkAssets() = default;
 
@@ -63,8 +95,19 @@ class ApkAssets {
 
   ZipArchivePtr zip_handle_;
   std::string path_;
+  uint32_t resources_crc32_ = 0u;
   std::unique_ptr<Asset> resources_asset_;
+
+  // The IDMAP data must outlive the LoadedArsc that points into it.
+  std::unique_ptr<FileMap> idmap_map_;
+  std::unique_ptr<const LoadedIdmap> loaded_idmap_;
   std::unique_ptr<const LoadedArsc> loaded_arsc_;
+
+  // Mappings of recently opened uncompressed entries, shared by every Asset opened from them.
+  // The oldest mapping is evicted first; Assets already handed out keep theirs alive.
+  mutable Mutex map_cache_lock_;
+  mutable std::unordered_map<std::string, std::shared_ptr<FileMap>> map_cache_;
+  mutable std::deque<std::string> map_cache_order_;
 };
 
 }  // namespace android
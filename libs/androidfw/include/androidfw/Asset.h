@@ -200,6 +200,16 @@ private:
     static std::unique_ptr<Asset> createFromUncompressedMap(std::unique_ptr<FileMap> dataMap,
         AccessMode mode);
 
+    /*
+     * Create the asset from a memory-mapped file segment that may be shared
+     * with other assets.
+     *
+     * The asset holds a reference to the FileMap. The region stays mapped
+     * until the last reference to it is released.
+     */
+    static std::unique_ptr<Asset> createFromSharedUncompressedMap(
+        const std::shared_ptr<FileMap>& dataMap, AccessMode mode);
+
     /*
      * Create the asset from a memory-mapped file segment with compressed
      * data.
@@ -255,6 +265,13 @@ public:
      */
     status_t openChunk(FileMap* dataMap);
 
+    /*
+     * Use a memory-mapped region shared with other assets.
+     *
+     * On success, the object holds a reference to "dataMap".
+     */
+    status_t openChunk(const std::shared_ptr<FileMap>& dataMap);
+
     /*
      * Standard Asset interfaces.
      */
@@ -284,6 +301,9 @@ private:
     FileMap*    mMap;           // for memory map
     unsigned char* mBuf;        // for read
 
+    // Set if mMap is shared with other assets, in which case mMap is not owned.
+    std::shared_ptr<FileMap> mSharedMap;
+
     const void* ensureAlignment(FileMap* map);
 };
 
@@ -21,8 +21,13 @@
 
 #include <array>
 #include <limits>
+#include <map>
 #include <set>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/Mutex.h"
 
 #include "androidfw/ApkAssets.h"
 #include "androidfw/Asset.h"
@@ -73,6 +78,8 @@ struct ResolvedBag {
 // AssetManager2 provides caching of resources retrieved via the underlying
 // ApkAssets.
 class AssetManager2 : public ::AAssetManager {
+  friend class Theme;
+
  public:
   struct ResourceName {
     const char* package = nullptr;
@@ -223,6 +230,9 @@ class AssetManager2 : public ::AAssetManager {
   //      ...
   //    }
   //  }
+  //
+  // This may be called from multiple threads concurrently, as long as the configuration and
+  // ApkAssets are not changed at the same time.
   const ResolvedBag* GetBag(uint32_t resid);
 
   // Creates a new Theme from this AssetManager.
@@ -249,6 +259,10 @@ class AssetManager2 : public ::AAssetManager {
                             LoadedArscEntry* out_entry, ResTable_config* out_selected_config,
                             uint32_t* out_flags);
 
+  // Inserts `bag` into the bag cache, unless a bag for `resid` was published concurrently.
+  // Returns the cached bag.
+  const ResolvedBag* PublishBag(uint32_t resid, util::unique_cptr<ResolvedBag> bag);
+
   // Assigns package IDs to all shared library ApkAssets.
   // Should be called whenever the ApkAssets are changed.
   void BuildDynamicRefTable();
@@ -281,9 +295,61 @@ class AssetManager2 : public ::AAssetManager {
   // may need to be purged.
   ResTable_config configuration_;
 
+  // The result of a FindEntry() call for the current configuration.
+  struct CachedEntry {
+    LoadedArscEntry entry;
+    ResTable_config config;
+
+    // The configuration axis the entry varies with. The entry is purged when any of these
+    // change in the configuration.
+    uint32_t flags;
+    ApkAssetsCookie cookie;
+  };
+
+  // The caches below are split into independently locked shards, so that GetBag(), GetResource()
+  // and the Theme methods built on them can be called from several threads at once. Changing the
+  // configuration or the ApkAssets must still not race with lookups.
+  static constexpr const size_t kCacheShardCount = 16u;
+
+  template <typename T>
+  struct CacheShard {
+    Mutex lock;
+    std::unordered_map<uint32_t, T> map;
+  };
+
+  template <typename T>
+  using ShardedCache = std::array<CacheShard<T>, kCacheShardCount>;
+
+  // Consecutive resource IDs land in different shards.
+  static inline size_t GetCacheShard(uint32_t resid) { return resid & (kCacheShardCount - 1u); }
+
   // Cached set of bags. These are cached because they can inherit keys from parent bags,
-  // which involves some calculation.
-  std::unordered_map<uint32_t, util::unique_cptr<ResolvedBag>> cached_bags_;
+  // which involves some calculation. A bag is never mutated once published, and stays alive
+  // until it is purged by InvalidateCaches().
+  ShardedCache<util::unique_cptr<ResolvedBag>> cached_bags_;
+
+  // Cached FindEntry() results for the current configuration, keyed by resource ID.
+  // Only lookups without a density override are cached.
+  ShardedCache<CachedEntry> cached_entries_;
+
+  // The sequence of (style, force) pairs applied to a Theme since it was last cleared.
+  using ThemeStyleKey = std::vector<std::pair<uint32_t, bool>>;
+
+  // Copies the cached Theme that was built by applying `key` into `out_theme`.
+  // Returns false if no such Theme is cached.
+  bool FindCachedTheme(const ThemeStyleKey& key, Theme* out_theme);
+
+  // Caches a snapshot of `theme`, keyed by the styles that were applied to it.
+  void CacheTheme(const Theme& theme);
+
+  // Snapshots of Themes, keyed by the sequence of styles that built them. Snapshots share their
+  // data with live Themes, so caching one costs little more than a pointer copy.
+  Mutex theme_cache_lock_;
+  std::map<ThemeStyleKey, std::unique_ptr<Theme>> theme_cache_;
+
+  // Incremented whenever the caches are invalidated. Themes built under an older generation
+  // don't participate in the theme cache until they are cleared.
+  uint32_t theme_cache_generation_ = 0u;
 };
 
 class Theme {
@@ -299,6 +365,7 @@ class Theme {
   bool ApplyStyle(uint32_t resid, bool force = false);
 
   // Sets this Theme to be a copy of `o` if `o` has the same AssetManager as this Theme.
+  // The data of `o` is shared, and only copied when either Theme is modified.
   // Returns false if the AssetManagers of the Themes were not compatible.
   bool SetTo(const Theme& o);
 
@@ -337,7 +404,9 @@ class Theme {
   DISALLOW_COPY_AND_ASSIGN(Theme);
 
   // Called by AssetManager2.
-  explicit inline Theme(AssetManager2* asset_manager) : asset_manager_(asset_manager) {}
+  explicit inline Theme(AssetManager2* asset_manager)
+      : asset_manager_(asset_manager),
+        cache_generation_(asset_manager->theme_cache_generation_) {}
 
   struct Entry {
     ApkAssetsCookie cookie;
@@ -358,12 +427,33 @@ class Theme {
   struct Package {
     // Each element of Type will be a dynamically sized object
     // allocated to have the entries stored contiguously with the Type.
-    std::array<util::unique_cptr<Type>, kTypeCount> types;
+    // Types are shared between Themes and copied before they are modified.
+    std::array<std::shared_ptr<Type>, kTypeCount> types;
   };
 
+  // Creates a zeroed Type with room for `capacity` entries, copying the entries of `src` if
+  // it is not nullptr.
+  static std::shared_ptr<Type> NewType(uint32_t capacity, const Type* src = nullptr);
+
+  // Returns the Package at `package_idx`, creating it or copying it first if it is shared with
+  // another Theme.
+  Package* EditPackage(uint32_t package_idx);
+
+  // Merges the entries of `bag` into this Theme.
+  bool ApplyBag(const ResolvedBag* bag, bool force);
+
+  // Copies the state of `o` into this Theme, sharing its data.
+  void CopyFrom(const Theme& o);
+
   AssetManager2* asset_manager_;
   uint32_t type_spec_flags_ = 0u;
-  std::array<std::unique_ptr<Package>, kPackageCount> packages_;
+  std::array<std::shared_ptr<Package>, kPackageCount> packages_;
+
+  // The styles applied since this Theme was last cleared, used as the theme cache key.
+  AssetManager2::ThemeStyleKey applied_styles_;
+
+  // The AssetManager2 theme cache generation this Theme was built under.
+  uint32_t cache_generation_;
 };
 
 inline const ResolvedBag::Entry* begin(const ResolvedBag* bag) { return bag->entries; }
@@ -52,6 +52,20 @@ void ApplyStyle(ResTable::Theme* theme, ResXMLParser* xml_parser, uint32_t def_s
                 uint32_t def_style_res, const uint32_t* attrs, size_t attrs_length,
                 uint32_t* out_values, uint32_t* out_indices);
 
+// Performs ApplyStyle() for each of the `xml_parsers_length` elements in `xml_parsers`, with the
+// same default style and requested `attrs`. The default style, and each distinct style="" bag, is
+// looked up once for the whole batch, and the ResTable is locked only once.
+// Each entry in `xml_parsers` must be positioned at a START_TAG, or be nullptr.
+// `out_values` must NOT be nullptr, and must hold
+//     xml_parsers_length * attrs_length * STYLE_NUM_ENTRIES elements.
+// `out_indices` is NOT optional and must NOT be nullptr. It must hold
+//     xml_parsers_length * (attrs_length + 1) elements, laid out as one ApplyStyle() indices array
+//     per element.
+void ApplyStyles(ResTable::Theme* theme, ResXMLParser* const* xml_parsers,
+                 size_t xml_parsers_length, uint32_t def_style_attr, uint32_t def_style_res,
+                 const uint32_t* attrs, size_t attrs_length, uint32_t* out_values,
+                 uint32_t* out_indices);
+
 // `out_values` must NOT be nullptr.
 // `out_indices` may be nullptr.
 bool RetrieveAttributes(const ResTable* res, ResXMLParser* xml_parser, uint32_t* attrs,
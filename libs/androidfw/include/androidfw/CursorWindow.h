@@ -17,6 +17,7 @@
 #ifndef _ANDROID__DATABASE_WINDOW_H
 #define _ANDROID__DATABASE_WINDOW_H
 
+#include <atomic>
 #include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -95,6 +96,13 @@ public:
     status_t clear();
     status_t setNumColumns(uint32_t numColumns);
 
+    /**
+     * Lets the window grow up to maxSize bytes instead of failing allocations once it is
+     * full. Growing moves the contents to a new, larger ashmem region, so it stops being
+     * allowed once the window was written to a parcel.
+     */
+    status_t setMaxSize(size_t maxSize);
+
     /**
      * Allocate a row slot and its directory.
      * The row is initialized will null entries for each field.
@@ -138,6 +146,22 @@ public:
         return offsetToPtr(fieldSlot->data.buffer.offset, fieldSlot->data.buffer.size);
     }
 
+    /**
+     * Reads numRows fields of a column starting at startRow, converting them the same way
+     * reading a single field as a long does: strings are parsed, floats are truncated and
+     * nulls read as 0. This avoids looking up each row separately for large reads.
+     * Returns BAD_VALUE if the range is not in the window, or BAD_TYPE if one of the fields
+     * is a blob, in which case the contents of outValues are undefined.
+     */
+    status_t getColumnLongs(uint32_t column, uint32_t startRow, uint32_t numRows,
+            int64_t* outValues);
+
+    /**
+     * Same as getColumnLongs(), but converts the fields to doubles.
+     */
+    status_t getColumnDoubles(uint32_t column, uint32_t startRow, uint32_t numRows,
+            double* outValues);
+
 private:
     static const size_t ROW_SLOT_CHUNK_NUM_ROWS = 100;
 
@@ -165,9 +189,15 @@ private:
     int mAshmemFd;
     void* mData;
     size_t mSize;
+    size_t mMaxSize;
     bool mReadOnly;
     Header* mHeader;
 
+    // Index of the last row slot chunk that was looked up in the high bits, and its offset
+    // in the low bits. Rows are mostly accessed in order, so walking the chunk list from
+    // there instead of from the first chunk keeps lookups constant time. 0 if unset.
+    std::atomic<uint64_t> mLastChunk;
+
     inline void* offsetToPtr(uint32_t offset, uint32_t bufferSize = 0) {
         if (offset >= mSize) {
             ALOGE("Offset %" PRIu32 " out of bounds, max value %zu", offset, mSize);
@@ -189,9 +219,17 @@ private:
      * Allocate a portion of the window. Returns the offset
      * of the allocation, or 0 if there isn't enough space.
      * If aligned is true, the allocation gets 4 byte alignment.
+     * The window grows if it is full and allowed to, see grow().
      */
     uint32_t alloc(size_t size, bool aligned = false);
 
+    /**
+     * Moves the window to a region of at least minSize bytes. This invalidates all the
+     * pointers into the window, but not the offsets.
+     */
+    status_t grow(size_t minSize);
+
+    RowSlotChunk* getRowSlotChunk(uint32_t chunkIndex);
     RowSlot* getRowSlot(uint32_t row);
     RowSlot* allocRowSlot();
 
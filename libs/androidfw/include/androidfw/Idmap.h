@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IDMAP_H_
+#define IDMAP_H_
+
+#include <memory>
+#include <string>
+
+#include "android-base/macros.h"
+
+#include "androidfw/ByteBucketArray.h"
+#include "androidfw/StringPiece.h"
+
+namespace android {
+
+// The on-disk header of an idmap, as produced by ResTable::createIdmap().
+// All values are in device byte order.
+struct Idmap_header {
+  // Always 0x504D4449 ('IDMP').
+  uint32_t magic;
+
+  uint32_t version;
+
+  uint32_t target_crc32;
+  uint32_t overlay_crc32;
+
+  uint8_t target_path[256];
+  uint8_t overlay_path[256];
+
+  uint16_t target_package_id;
+  uint16_t type_count;
+} __attribute__((packed));
+
+// The mapping of the entries of one target type to the entries of one overlay type.
+struct IdmapEntry_header {
+  uint16_t target_type_id;
+  uint16_t overlay_type_id;
+  uint16_t entry_count;
+  uint16_t entry_id_offset;
+
+  // `entry_count` overlay entry IDs, indexed by (target entry ID - entry_id_offset).
+  // 0xffffffff means the target entry is not overlaid.
+  uint32_t entries[0];
+};
+
+// Represents a loaded/parsed IDMAP for a Runtime Resource Overlay (RRO).
+// An RRO and its target APK have different resource IDs assigned to their resources. Overlaying
+// a resource is done by resource name. An IDMAP is a generated mapping between the resource IDs
+// of the RRO and the target APK for each resource with the same name.
+// A LoadedIdmap does not copy the idmap data. The data must outlive the LoadedIdmap.
+class LoadedIdmap {
+ public:
+  // Loads an IDMAP from a chunk of memory. Returns nullptr if the IDMAP data was malformed.
+  static std::unique_ptr<const LoadedIdmap> Load(const StringPiece& idmap_data);
+
+  // Performs a lookup of the expected entry ID for the given IDMAP entry header.
+  // Returns true if the mapping exists and fills `output_entry_id` with the result.
+  static bool Lookup(const IdmapEntry_header* header, uint16_t input_entry_id,
+                     uint16_t* output_entry_id);
+
+  // Returns the package ID for which this overlay should apply.
+  uint8_t TargetPackageId() const;
+
+  // Returns the path to the RRO (Runtime Resource Overlay) APK for which this IDMAP was generated.
+  inline const std::string& OverlayApkPath() const { return overlay_apk_path_; }
+
+  // Returns the mapping of target entry ID to overlay entry ID for the given overlay type.
+  // Returns nullptr if no entries of `overlay_type_id` overlay the target package.
+  inline const IdmapEntry_header* GetEntryMapForType(uint8_t overlay_type_id) const {
+    return type_map_[overlay_type_id];
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LoadedIdmap);
+
+  explicit LoadedIdmap(const Idmap_header* header);
+
+  const Idmap_header* header_ = nullptr;
+  std::string overlay_apk_path_;
+  ByteBucketArray<const IdmapEntry_header*> type_map_;
+};
+
+}  // namespace android
+
+#endif  // IDMAP_H_
@@ -17,14 +17,19 @@
 #ifndef LOADEDARSC_H_
 #define LOADEDARSC_H_
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "android-base/macros.h"
 
 #include "androidfw/ByteBucketArray.h"
 #include "androidfw/Chunk.h"
+#include "androidfw/Idmap.h"
 #include "androidfw/ResourceTypes.h"
 #include "androidfw/Util.h"
 
@@ -59,6 +64,8 @@ struct LoadedArscEntry {
 };
 
 struct TypeSpec;
+struct ArscIndexHeader;
+struct ArscIndexPackage;
 class LoadedArsc;
 
 class LoadedPackage {
@@ -85,6 +92,10 @@ class LoadedPackage {
   // Returns true if this package originates from a system provided resource.
   inline bool IsSystem() const { return system_; }
 
+  // Returns true if this package is a Runtime Resource Overlay. An overlay takes on the package ID
+  // of its target, and answers lookups of target resource IDs through its IDMAP.
+  inline bool IsOverlay() const { return overlay_; }
+
   // Returns the map of package name to package ID used in this LoadedPackage. At runtime, a
   // package could have been assigned a different package ID than what this LoadedPackage was
   // compiled with. AssetManager rewrites the package IDs so that they are compatible at runtime.
@@ -111,10 +122,19 @@ class LoadedPackage {
  private:
   DISALLOW_COPY_AND_ASSIGN(LoadedPackage);
 
-  static std::unique_ptr<LoadedPackage> Load(const Chunk& chunk);
+  static std::unique_ptr<LoadedPackage> Load(const Chunk& chunk, const LoadedIdmap* loaded_idmap);
+
+  // Builds the package described by `index_package` without walking its child chunks.
+  // See LoadedArsc::LoadWithIndex().
+  static std::unique_ptr<LoadedPackage> LoadFromIndex(const void* data, size_t len,
+                                                      const ArscIndexHeader* index,
+                                                      const ArscIndexPackage& index_package);
 
   LoadedPackage() = default;
 
+  // Reads the package ID, type ID offset and name from the package header.
+  bool LoadHeader(const Chunk& chunk);
+
   ResStringPool type_string_pool_;
   ResStringPool key_string_pool_;
   std::string package_name_;
@@ -122,9 +142,19 @@ class LoadedPackage {
   int type_id_offset_ = 0;
   bool dynamic_ = false;
   bool system_ = false;
+  bool overlay_ = false;
+
+  // Pointers into the resource table data, used when writing an index.
+  const ResTable_package* header_ = nullptr;
+  const ResTable_lib_header* library_header_ = nullptr;
 
   ByteBucketArray<util::unique_cptr<TypeSpec>> type_specs_;
   std::vector<DynamicPackageEntry> dynamic_package_map_;
+
+  // Built by FindEntryByName() for each type it is asked about. Holds the (key string index,
+  // entry index) of every entry of the type, sorted by key string index.
+  mutable std::mutex entry_name_index_lock_;
+  mutable std::map<uint8_t, std::vector<std::pair<uint32_t, uint16_t>>> entry_name_index_;
 };
 
 // Read-only view into a resource table. This class validates all data
@@ -140,8 +170,34 @@ class LoadedArsc {
   static std::unique_ptr<const LoadedArsc> Load(const void* data, size_t len, bool system = false,
                                                 bool load_as_shared_library = false);
 
+  // Load a Runtime Resource Overlay's resource table from memory pointed to by `data` of size
+  // `len`. Every type mapped by `loaded_idmap` is redirected onto its target type, so that the
+  // overlay's packages answer lookups of the target's resource IDs. Types the idmap doesn't map
+  // are dropped. The lifetime of `data` and `loaded_idmap` must out-live the returned LoadedArsc.
+  static std::unique_ptr<const LoadedArsc> Load(const void* data, size_t len,
+                                                const LoadedIdmap* loaded_idmap,
+                                                bool system = false,
+                                                bool load_as_shared_library = false);
+
+  // Load a resource table from memory pointed to by `data` of size `len`, using the precomputed
+  // index at `index_data` (as produced by WriteIndex()) to locate every package, type spec and
+  // type chunk directly. This skips the chunk walk and the per-entry validation done by Load(),
+  // so it is O(1) in the number of entries.
+  // `source_crc` identifies the contents of `data` (typically the CRC-32 recorded in the zip
+  // entry). If it, or the size of `data`, doesn't match what the index was written with, the index
+  // is considered stale and nullptr is returned. Callers should then fall back to Load().
+  static std::unique_ptr<const LoadedArsc> LoadWithIndex(const void* data, size_t len,
+                                                         const void* index_data, size_t index_len,
+                                                         uint32_t source_crc, bool system = false,
+                                                         bool load_as_shared_library = false);
+
   ~LoadedArsc();
 
+  // Serializes the location of every package, type spec and type chunk of this table into
+  // `out_index`, so that a later LoadWithIndex() can skip parsing. The index is in host byte order
+  // and is only valid for the exact data this LoadedArsc was loaded from.
+  bool WriteIndex(uint32_t source_crc, std::string* out_index) const;
+
   // Returns the string pool where all string resource values
   // (Res_value::dataType == Res_value::TYPE_STRING) are indexed.
   inline const ResStringPool* GetStringPool() const { return &global_string_pool_; }
@@ -168,7 +224,16 @@ class LoadedArsc {
   DISALLOW_COPY_AND_ASSIGN(LoadedArsc);
 
   LoadedArsc() = default;
-  bool LoadTable(const Chunk& chunk, bool load_as_shared_library);
+  bool LoadTable(const Chunk& chunk, const LoadedIdmap* loaded_idmap,
+                 bool load_as_shared_library);
+
+  // Returns the offset of `ptr` from the start of the data this table was loaded from.
+  uint32_t OffsetOf(const void* ptr) const;
+
+  const void* data_ = nullptr;
+  size_t data_len_ = 0u;
+  const ResTable_header* table_header_ = nullptr;
+  const ResStringPool_header* string_pool_header_ = nullptr;
 
   ResStringPool global_string_pool_;
   std::vector<std::unique_ptr<const LoadedPackage>> packages_;
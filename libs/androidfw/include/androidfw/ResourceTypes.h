@@ -1240,6 +1240,16 @@ struct ResTable_config
     // settings is the requested settings
     bool match(const ResTable_config& settings) const;
 
+    // Packs the qualifiers that match() requires to be identical whenever they are set
+    // (orientation, touchscreen, keyboard, navigation, layout direction, screen long, UI mode,
+    // navigation hidden, screen round, HDR and wide color gamut) into a single word. If `outMask`
+    // is not NULL, it receives the bits of every such qualifier that is set in 'this'.
+    //
+    // If ((packExactQualifiers(&mask) ^ settings.packExactQualifiers(NULL)) & mask) != 0, then
+    // match(settings) is guaranteed to be false. This lets callers reject most candidate
+    // configurations with a single compare before falling back to match().
+    uint64_t packExactQualifiers(uint64_t* outMask) const;
+
     // Get the string representation of the locale component of this
     // Config. The maximum size of this representation will be
     // |RESTABLE_MAX_LOCALE_LEN| (including a terminating '\0').
@@ -1902,6 +1912,9 @@ public:
     const String16 getBasePackageName(size_t idx) const;
     uint32_t getBasePackageId(size_t idx) const;
     uint32_t getLastTypeIdForPackage(size_t idx) const;
+    // Return the number of entry IDs of the given type (1-based) in the package group at the
+    // given index, or 0 if there is no such type. Not every ID below the count needs a value.
+    size_t getEntryCountForType(size_t idx, uint32_t typeId) const;
 
     // Return the number of resource tables that the object contains.
     size_t getTableCount() const;
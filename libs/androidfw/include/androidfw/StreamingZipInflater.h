@@ -23,6 +23,12 @@
 
 #include <utils/Compat.h>
 
+#if !defined(_WIN32)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 namespace android {
 
 class StreamingZipInflater {
@@ -47,9 +53,26 @@ public:
     // position to the destination.
     off64_t seekAbsolute(off64_t absoluteInputPosition);
 
+    // When enabled, the next OUTPUT_CHUNK_SIZE window of uncompressed data is decoded
+    // on a background thread while the caller consumes the current one.  This pays off
+    // for sequential readers of large assets; random access still works, but a backwards
+    // seek discards the window being prepared.  Ignored on hosts without thread support.
+    void setReadAhead(bool enabled);
+
 private:
     void initInflateState();
+    void initReadAheadState();
+    void resetInflateState();
     int readNextChunk();
+    // decode the next window of output into 'buf', storing the number of bytes produced
+    // in 'outDecoded'.  Returns 0 on success, -1 on a read or inflate error.
+    int inflateNextWindow(uint8_t* buf, size_t* outDecoded);
+    // make the next decoded window current in mOutBuf.  Returns 0 on success, -1 on error.
+    int fillOutBuf();
+#if !defined(_WIN32)
+    void readAheadLoop(off64_t decodedTotal);
+    void stopReadAhead();
+#endif
 
     // where to find the uncompressed data
     int mFd;
@@ -77,6 +100,21 @@ private:
     // input state bookkeeping
     size_t mInNextChunkOffset;  // offset from start of blob at which the next input chunk lies
     // the z_stream contains state about input block consumption
+
+    bool mReadAhead;            // decode ahead of the caller on a worker thread
+#if !defined(_WIN32)
+    // read-ahead state.  While mAheadThread is running it owns mInflateState, the input
+    // buffer and mAheadBuf; everything below except the thread itself is guarded by mAheadLock.
+    std::thread mAheadThread;
+    std::mutex mAheadLock;
+    std::condition_variable mAheadCond;
+    uint8_t* mAheadBuf;         // back buffer the worker decodes into
+    size_t mAheadDecoded;       // bytes decoded into mAheadBuf
+    int mAheadResult;           // result of decoding mAheadBuf
+    bool mAheadReady;           // mAheadBuf holds a window that hasn't been consumed yet
+    bool mAheadDone;            // the worker has exited on its own (end of data or error)
+    bool mAheadStop;            // the worker has been asked to exit
+#endif
 };
 
 }
@@ -48,7 +48,8 @@ benchmarkFiles := \
     BenchmarkHelpers.cpp \
     SparseEntry_bench.cpp \
     TestHelpers.cpp \
-    Theme_bench.cpp
+    Theme_bench.cpp \
+    Workload_bench.cpp
 
 androidfw_test_cflags := \
     -Wall \
@@ -90,11 +91,13 @@ LOCAL_MODULE := libandroidfw_tests
 LOCAL_CFLAGS := $(androidfw_test_cflags)
 LOCAL_SRC_FILES := $(testFiles) \
     BackupData_test.cpp \
+    CursorWindow_test.cpp \
     ObbFile_test.cpp \
 
 LOCAL_SHARED_LIBRARIES := \
     libandroidfw \
     libbase \
+    libbinder \
     libcutils \
     libutils \
     libui \
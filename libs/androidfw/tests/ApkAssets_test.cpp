@@ -91,4 +91,26 @@ TEST(ApkAssetsTest, OpenUncompressedAssetFd) {
   EXPECT_EQ("This should be uncompressed.\n\n", buffer);
 }
 
+TEST(ApkAssetsTest, ReopenedUncompressedAssetSharesMapping) {
+  std::unique_ptr<const ApkAssets> loaded_apk =
+      ApkAssets::Load(GetTestDataPath() + "/basic/basic.apk");
+  ASSERT_NE(nullptr, loaded_apk);
+
+  std::unique_ptr<Asset> first = loaded_apk->Open("assets/uncompressed.txt", Asset::ACCESS_BUFFER);
+  ASSERT_NE(nullptr, first);
+  std::unique_ptr<Asset> second =
+      loaded_apk->Open("assets/uncompressed.txt", Asset::ACCESS_BUFFER);
+  ASSERT_NE(nullptr, second);
+
+  const void* first_buffer = first->getBuffer(false /*wordAligned*/);
+  ASSERT_NE(nullptr, first_buffer);
+  EXPECT_EQ(first_buffer, second->getBuffer(false /*wordAligned*/));
+
+  // The shared mapping outlives any one of the Assets using it.
+  first.reset();
+  std::string contents(reinterpret_cast<const char*>(second->getBuffer(false /*wordAligned*/)),
+                       second->getLength());
+  EXPECT_EQ("This should be uncompressed.\n\n", contents);
+}
+
 }  // namespace android
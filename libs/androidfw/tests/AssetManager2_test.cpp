@@ -17,6 +17,10 @@
 #include "androidfw/AssetManager2.h"
 #include "androidfw/AssetManager.h"
 
+#include <array>
+#include <thread>
+#include <vector>
+
 #include "android-base/logging.h"
 
 #include "TestHelpers.h"
@@ -137,6 +141,38 @@ TEST_F(AssetManager2Test, FindsResourceFromMultipleApkAssets) {
   EXPECT_EQ(Res_value::TYPE_STRING, value.dataType);
 }
 
+TEST_F(AssetManager2Test, FindsNewResourceAfterConfigurationChange) {
+  ResTable_config desired_config;
+  memset(&desired_config, 0, sizeof(desired_config));
+
+  AssetManager2 assetmanager;
+  assetmanager.SetConfiguration(desired_config);
+  assetmanager.SetApkAssets({basic_assets_.get(), basic_de_fr_assets_.get()});
+
+  Res_value value;
+  ResTable_config selected_config;
+  uint32_t flags;
+
+  ApkAssetsCookie cookie =
+      assetmanager.GetResource(basic::R::string::test1, false /*may_be_bag*/,
+                               0 /*density_override*/, &value, &selected_config, &flags);
+  ASSERT_NE(kInvalidCookie, cookie);
+  EXPECT_EQ(0, cookie);
+  EXPECT_EQ(0, selected_config.language[0]);
+
+  // Changing the locale must not return the previously cached default value.
+  desired_config.language[0] = 'd';
+  desired_config.language[1] = 'e';
+  assetmanager.SetConfiguration(desired_config);
+
+  cookie = assetmanager.GetResource(basic::R::string::test1, false /*may_be_bag*/,
+                                    0 /*density_override*/, &value, &selected_config, &flags);
+  ASSERT_NE(kInvalidCookie, cookie);
+  EXPECT_EQ(1, cookie);
+  EXPECT_EQ('d', selected_config.language[0]);
+  EXPECT_EQ('e', selected_config.language[1]);
+}
+
 TEST_F(AssetManager2Test, FindsResourceFromSharedLibrary) {
   AssetManager2 assetmanager;
 
@@ -302,6 +338,30 @@ TEST_F(AssetManager2Test, MergesStylesWithParentFromSingleApkAssets) {
   EXPECT_EQ(0, bag_two->entries[5].cookie);
 }
 
+TEST_F(AssetManager2Test, GetsSameBagFromMultipleThreads) {
+  AssetManager2 assetmanager;
+  assetmanager.SetApkAssets({style_assets_.get()});
+
+  constexpr size_t kThreadCount = 4u;
+  std::array<const ResolvedBag*, kThreadCount> bags;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; i++) {
+    threads.emplace_back([&, i]() { bags[i] = assetmanager.GetBag(app::R::style::StyleTwo); });
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Every thread must observe the single published bag.
+  ASSERT_NE(nullptr, bags[0]);
+  EXPECT_EQ(6u, bags[0]->entry_count);
+  for (const ResolvedBag* bag : bags) {
+    EXPECT_EQ(bags[0], bag);
+  }
+  EXPECT_EQ(bags[0], assetmanager.GetBag(app::R::style::StyleTwo));
+}
+
 TEST_F(AssetManager2Test, ResolveReferenceToResource) {
   AssetManager2 assetmanager;
   assetmanager.SetApkAssets({basic_assets_.get()});
@@ -16,6 +16,7 @@
 
 #include "androidfw/AttributeResolution.h"
 
+#include <algorithm>
 #include <array>
 
 #include "android-base/file.h"
@@ -237,5 +238,37 @@ TEST_F(AttributeResolutionXmlTest, ThemeAndXmlParser) {
   EXPECT_EQ(expected_indices, indices);
 }
 
+TEST_F(AttributeResolutionXmlTest, ApplyStylesMatchesApplyStyle) {
+  ResTable::Theme theme(table_);
+  ASSERT_EQ(NO_ERROR, theme.applyStyle(R::style::StyleTwo));
+
+  std::array<uint32_t, 6> attrs{{R::attr::attr_one, R::attr::attr_two, R::attr::attr_three,
+                                 R::attr::attr_four, R::attr::attr_five, R::attr::attr_empty}};
+  std::array<uint32_t, attrs.size() * STYLE_NUM_ENTRIES> xml_values;
+  std::array<uint32_t, attrs.size() + 1> xml_indices;
+  ApplyStyle(&theme, &xml_parser_, 0 /*def_style_attr*/, 0 /*def_style_res*/, attrs.data(),
+             attrs.size(), xml_values.data(), xml_indices.data());
+
+  std::array<uint32_t, attrs.size() * STYLE_NUM_ENTRIES> null_values;
+  std::array<uint32_t, attrs.size() + 1> null_indices;
+  ApplyStyle(&theme, nullptr /*xml_parser*/, 0 /*def_style_attr*/, 0 /*def_style_res*/,
+             attrs.data(), attrs.size(), null_values.data(), null_indices.data());
+
+  std::array<ResXMLParser*, 3> parsers{{&xml_parser_, nullptr, &xml_parser_}};
+  std::array<uint32_t, parsers.size() * attrs.size() * STYLE_NUM_ENTRIES> values;
+  std::array<uint32_t, parsers.size() * (attrs.size() + 1)> indices;
+  ApplyStyles(&theme, parsers.data(), parsers.size(), 0 /*def_style_attr*/, 0 /*def_style_res*/,
+              attrs.data(), attrs.size(), values.data(), indices.data());
+
+  for (size_t i = 0; i < parsers.size(); i++) {
+    const auto& expected_values = parsers[i] != nullptr ? xml_values : null_values;
+    const auto& expected_indices = parsers[i] != nullptr ? xml_indices : null_indices;
+    EXPECT_TRUE(std::equal(expected_values.begin(), expected_values.end(),
+                           values.begin() + (i * expected_values.size())));
+    EXPECT_TRUE(std::equal(expected_indices.begin(), expected_indices.end(),
+                           indices.begin() + (i * expected_indices.size())));
+  }
+}
+
 } // namespace android
 
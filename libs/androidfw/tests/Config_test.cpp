@@ -202,4 +202,45 @@ TEST(ConfigTest, ScreenIsHdr) {
   EXPECT_EQ(defaultConfig.diff(hdrConfig), ResTable_config::CONFIG_COLOR_MODE);
 }
 
+TEST(ConfigTest, PackedExactQualifiersAgreeWithMatch) {
+  ResTable_config deviceConfig;
+  memset(&deviceConfig, 0, sizeof(deviceConfig));
+  deviceConfig.orientation = ResTable_config::ORIENTATION_PORT;
+  deviceConfig.uiMode = ResTable_config::UI_MODE_TYPE_NORMAL | ResTable_config::UI_MODE_NIGHT_YES;
+  deviceConfig.screenLayout = ResTable_config::LAYOUTDIR_LTR;
+  deviceConfig.screenLayout2 = ResTable_config::SCREENROUND_NO;
+  deviceConfig.colorMode = ResTable_config::HDR_NO;
+
+  ResTable_config defaultConfig;
+  memset(&defaultConfig, 0, sizeof(defaultConfig));
+
+  ResTable_config nightConfig = defaultConfig;
+  nightConfig.uiMode = ResTable_config::UI_MODE_NIGHT_YES;
+
+  ResTable_config landConfig = defaultConfig;
+  landConfig.orientation = ResTable_config::ORIENTATION_LAND;
+
+  ResTable_config rtlConfig = defaultConfig;
+  rtlConfig.screenLayout = ResTable_config::LAYOUTDIR_RTL;
+
+  ResTable_config roundConfig = defaultConfig;
+  roundConfig.screenLayout2 = ResTable_config::SCREENROUND_YES;
+
+  ResTable_config hdrConfig = defaultConfig;
+  hdrConfig.colorMode = ResTable_config::HDR_YES;
+
+  const uint64_t devicePacked = deviceConfig.packExactQualifiers(NULL);
+  for (const ResTable_config& config :
+       {defaultConfig, nightConfig, landConfig, rtlConfig, roundConfig, hdrConfig}) {
+    uint64_t mask;
+    const uint64_t packed = config.packExactQualifiers(&mask);
+    const bool rejected = ((packed ^ devicePacked) & mask) != 0;
+    EXPECT_EQ(!config.match(deviceConfig), rejected);
+  }
+
+  uint64_t mask;
+  defaultConfig.packExactQualifiers(&mask);
+  EXPECT_EQ(0u, mask);
+}
+
 }  // namespace android.
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/CursorWindow.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace android {
+
+// Spans a few row slot chunks
+static const uint32_t kNumRows = 250;
+
+class CursorWindowTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    CursorWindow* window;
+    ASSERT_EQ(OK, CursorWindow::create(String8("test"), 1024 * 1024, &window));
+    window_.reset(window);
+    ASSERT_EQ(OK, window_->setNumColumns(2));
+  }
+
+  void AddRows(uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t row = window_->getNumRows();
+      ASSERT_EQ(OK, window_->allocRow());
+      ASSERT_EQ(OK, window_->putLong(row, 0, row));
+      ASSERT_EQ(OK, window_->putDouble(row, 1, row + 0.5));
+    }
+  }
+
+ protected:
+  std::unique_ptr<CursorWindow> window_;
+};
+
+TEST_F(CursorWindowTest, RandomAccessAcrossChunks) {
+  AddRows(kNumRows);
+  ASSERT_EQ(kNumRows, window_->getNumRows());
+
+  for (uint32_t row : {249u, 0u, 150u, 99u, 100u, 201u, 1u}) {
+    CursorWindow::FieldSlot* slot = window_->getFieldSlot(row, 0);
+    ASSERT_NE(nullptr, slot);
+    EXPECT_EQ(int64_t(row), window_->getFieldSlotValueLong(slot));
+  }
+  EXPECT_EQ(nullptr, window_->getFieldSlot(kNumRows, 0));
+}
+
+TEST_F(CursorWindowTest, FreeLastRowAcrossChunks) {
+  AddRows(kNumRows);
+  // Drop back into the first chunk, then grow past the chunks that were left behind
+  for (uint32_t i = 0; i < 160; i++) {
+    ASSERT_EQ(OK, window_->freeLastRow());
+  }
+  AddRows(kNumRows - 90);
+
+  std::vector<int64_t> values(kNumRows);
+  ASSERT_EQ(OK, window_->getColumnLongs(0, 0, kNumRows, values.data()));
+  for (uint32_t row = 0; row < kNumRows; row++) {
+    EXPECT_EQ(int64_t(row), values[row]);
+  }
+}
+
+TEST_F(CursorWindowTest, GetColumnLongs) {
+  AddRows(kNumRows);
+  ASSERT_EQ(OK, window_->putString(120, 0, "42", 3));
+  ASSERT_EQ(OK, window_->putNull(121, 0));
+
+  std::vector<int64_t> values(110);
+  ASSERT_EQ(OK, window_->getColumnLongs(0, 95, values.size(), values.data()));
+  EXPECT_EQ(95, values[0]);
+  EXPECT_EQ(42, values[25]);
+  EXPECT_EQ(0, values[26]);
+  EXPECT_EQ(204, values[109]);
+
+  // Floats are truncated
+  ASSERT_EQ(OK, window_->getColumnLongs(1, 10, 1, values.data()));
+  EXPECT_EQ(10, values[0]);
+}
+
+TEST_F(CursorWindowTest, GetColumnDoubles) {
+  AddRows(kNumRows);
+
+  std::vector<double> values(kNumRows);
+  ASSERT_EQ(OK, window_->getColumnDoubles(1, 0, kNumRows, values.data()));
+  for (uint32_t row = 0; row < kNumRows; row++) {
+    EXPECT_EQ(row + 0.5, values[row]);
+  }
+  ASSERT_EQ(OK, window_->getColumnDoubles(0, 7, 1, values.data()));
+  EXPECT_EQ(7.0, values[0]);
+}
+
+TEST_F(CursorWindowTest, GetColumnRejectsBadRanges) {
+  AddRows(10);
+  ASSERT_EQ(OK, window_->putBlob(5, 0, "\x01\x02", 2));
+
+  int64_t values[10];
+  EXPECT_EQ(BAD_VALUE, window_->getColumnLongs(2, 0, 1, values));
+  EXPECT_EQ(BAD_VALUE, window_->getColumnLongs(0, 5, 6, values));
+  EXPECT_EQ(BAD_VALUE, window_->getColumnLongs(0, 11, 0, values));
+  EXPECT_EQ(OK, window_->getColumnLongs(0, 10, 0, values));
+  EXPECT_EQ(BAD_TYPE, window_->getColumnLongs(0, 0, 10, values));
+  EXPECT_EQ(OK, window_->getColumnLongs(0, 6, 4, values));
+}
+
+TEST(CursorWindowGrowthTest, GrowsUpToMaxSize) {
+  CursorWindow* raw_window;
+  ASSERT_EQ(OK, CursorWindow::create(String8("test"), 4096, &raw_window));
+  std::unique_ptr<CursorWindow> window(raw_window);
+  ASSERT_EQ(OK, window->setNumColumns(1));
+  ASSERT_EQ(OK, window->setMaxSize(64 * 1024));
+
+  const std::string value(100, 'a');
+  uint32_t rows = 0;
+  while (window->allocRow() == OK) {
+    if (window->putString(rows, 0, value.c_str(), value.size() + 1) != OK) {
+      window->freeLastRow();
+      break;
+    }
+    rows++;
+  }
+  EXPECT_EQ(64u * 1024u, window->size());
+  EXPECT_GT(rows, 500u);
+  ASSERT_EQ(rows, window->getNumRows());
+
+  for (uint32_t row = 0; row < rows; row++) {
+    CursorWindow::FieldSlot* slot = window->getFieldSlot(row, 0);
+    ASSERT_NE(nullptr, slot);
+    size_t size;
+    ASSERT_EQ(value, window->getFieldSlotValueString(slot, &size));
+  }
+}
+
+}  // namespace android
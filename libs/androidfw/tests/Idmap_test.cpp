@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include "androidfw/Idmap.h"
+#include "androidfw/LoadedArsc.h"
 #include "androidfw/ResourceTypes.h"
 
 #include "utils/String16.h"
@@ -124,4 +126,40 @@ TEST_F(IdmapTest, OverlayDoesNotIncludeNonOverlaidResources) {
   ASSERT_LT(block, 0);
 }
 
+TEST_F(IdmapTest, LoadedArscRedirectsTargetIdsToOverlay) {
+  std::unique_ptr<const LoadedIdmap> loaded_idmap =
+      LoadedIdmap::Load(StringPiece(reinterpret_cast<const char*>(data_), data_size_));
+  ASSERT_NE(nullptr, loaded_idmap);
+  EXPECT_EQ(0x7f, loaded_idmap->TargetPackageId());
+
+  std::unique_ptr<const LoadedArsc> overlay_arsc =
+      LoadedArsc::Load(overlay_data_.data(), overlay_data_.size(), loaded_idmap.get());
+  ASSERT_NE(nullptr, overlay_arsc);
+  ASSERT_EQ(1u, overlay_arsc->GetPackages().size());
+  EXPECT_TRUE(overlay_arsc->GetPackages()[0]->IsOverlay());
+  EXPECT_EQ(0x7f, overlay_arsc->GetPackages()[0]->GetPackageId());
+
+  ResTable_config config;
+  memset(&config, 0, sizeof(config));
+
+  LoadedArscEntry entry;
+  ResTable_config selected_config;
+  uint32_t flags;
+  ASSERT_TRUE(overlay_arsc->FindEntry(R::string::test2, config, &entry, &selected_config, &flags));
+  ASSERT_NE(nullptr, entry.entry);
+
+  const Res_value* value = reinterpret_cast<const Res_value*>(
+      reinterpret_cast<const uint8_t*>(entry.entry) + dtohs(entry.entry->size));
+  ASSERT_EQ(Res_value::TYPE_STRING, value->dataType);
+
+  size_t str_len;
+  const char16_t* str16 = overlay_arsc->GetStringPool()->stringAt(dtohl(value->data), &str_len);
+  ASSERT_TRUE(str16 != NULL);
+  EXPECT_EQ(String16("test2-overlay"), String16(str16, str_len));
+
+  // Resources of the overlay that don't overlay anything are not visible.
+  EXPECT_FALSE(
+      overlay_arsc->FindEntry(kNonOverlaidResourceId, config, &entry, &selected_config, &flags));
+}
+
 }  // namespace
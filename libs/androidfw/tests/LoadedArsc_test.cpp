@@ -16,6 +16,8 @@
 
 #include "androidfw/LoadedArsc.h"
 
+#include "androidfw/Util.h"
+
 #include "TestHelpers.h"
 #include "data/basic/R.h"
 #include "data/libclient/R.h"
@@ -77,6 +79,72 @@ TEST(LoadedArscTest, FindDefaultEntry) {
   ASSERT_NE(nullptr, entry.entry);
 }
 
+TEST(LoadedArscTest, FindEntryByName) {
+  std::string contents;
+  ASSERT_TRUE(
+      ReadFileFromZipToString(GetTestDataPath() + "/basic/basic.apk", "resources.arsc", &contents));
+
+  std::unique_ptr<const LoadedArsc> loaded_arsc =
+      LoadedArsc::Load(contents.data(), contents.size());
+  ASSERT_NE(nullptr, loaded_arsc);
+
+  const std::vector<std::unique_ptr<const LoadedPackage>>& packages = loaded_arsc->GetPackages();
+  ASSERT_EQ(1u, packages.size());
+  const LoadedPackage* package = packages[0].get();
+
+  // The second lookup in a type goes through the index built by the first one.
+  EXPECT_EQ(basic::R::string::test2 & 0x00ffffffu, package->FindEntryByName(u"string", u"test2"));
+  EXPECT_EQ(basic::R::string::test1 & 0x00ffffffu, package->FindEntryByName(u"string", u"test1"));
+  EXPECT_EQ(basic::R::integer::ref2 & 0x00ffffffu, package->FindEntryByName(u"integer", u"ref2"));
+  EXPECT_EQ(0u, package->FindEntryByName(u"string", u"ref2"));
+  EXPECT_EQ(0u, package->FindEntryByName(u"string", u"does_not_exist"));
+  EXPECT_EQ(0u, package->FindEntryByName(u"does_not_exist", u"test1"));
+}
+
+TEST(LoadedArscTest, FindSparseEntry) {
+  std::string contents;
+  ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/sparse/sparse.apk", "resources.arsc",
+                                      &contents));
+
+  std::unique_ptr<const LoadedArsc> loaded_arsc =
+      LoadedArsc::Load(contents.data(), contents.size());
+  ASSERT_NE(nullptr, loaded_arsc);
+
+  const std::vector<std::unique_ptr<const LoadedPackage>>& packages = loaded_arsc->GetPackages();
+  ASSERT_EQ(1u, packages.size());
+
+  ResTable_config config;
+  memset(&config, 0, sizeof(config));
+  config.sdkVersion = 26;
+
+  LoadedArscEntry entry;
+  ResTable_config selected_config;
+  uint32_t flags;
+
+  // The v26 type is sparse and only holds foo_4, foo_5 and foo_9. The other entries fall back to
+  // the default configuration.
+  for (uint32_t value : {0u, 4u, 5u, 8u, 9u}) {
+    std::u16string name = u"foo_" + util::Utf8ToUtf16(std::to_string(value));
+    uint32_t resid = packages[0]->FindEntryByName(u"integer", name);
+    ASSERT_NE(0u, resid);
+    resid |= 0x7f000000u;
+
+    ASSERT_TRUE(loaded_arsc->FindEntry(resid, config, &entry, &selected_config, &flags));
+    ASSERT_NE(nullptr, entry.entry);
+
+    const Res_value* res_value = reinterpret_cast<const Res_value*>(
+        reinterpret_cast<const uint8_t*>(entry.entry) + dtohs(entry.entry->size));
+    EXPECT_EQ(Res_value::TYPE_INT_DEC, res_value->dataType);
+    if (value == 4u || value == 5u || value == 9u) {
+      EXPECT_EQ(26, dtohs(selected_config.sdkVersion));
+      EXPECT_EQ(value * 100u, dtohl(res_value->data));
+    } else {
+      EXPECT_EQ(0, dtohs(selected_config.sdkVersion));
+      EXPECT_EQ(value, dtohl(res_value->data));
+    }
+  }
+}
+
 TEST(LoadedArscTest, LoadSharedLibrary) {
   std::string contents;
   ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/lib_one/lib_one.apk", "resources.arsc",
@@ -174,6 +242,54 @@ TEST(LoadedArscTest, LoadFeatureSplit) {
   EXPECT_EQ(std::string("string"), type_name);
 }
 
+TEST(LoadedArscTest, LoadWithIndex) {
+  std::string contents;
+  ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/libclient/libclient.apk",
+                                      "resources.arsc", &contents));
+
+  std::unique_ptr<const LoadedArsc> loaded_arsc =
+      LoadedArsc::Load(contents.data(), contents.size());
+  ASSERT_NE(nullptr, loaded_arsc);
+
+  std::string index;
+  ASSERT_TRUE(loaded_arsc->WriteIndex(0x1234u, &index));
+
+  std::unique_ptr<const LoadedArsc> indexed_arsc = LoadedArsc::LoadWithIndex(
+      contents.data(), contents.size(), index.data(), index.size(), 0x1234u);
+  ASSERT_NE(nullptr, indexed_arsc);
+
+  const auto& packages = indexed_arsc->GetPackages();
+  ASSERT_EQ(1u, packages.size());
+  EXPECT_EQ(std::string("com.android.libclient"), packages[0]->GetPackageName());
+  EXPECT_EQ(0x7f, packages[0]->GetPackageId());
+  ASSERT_EQ(2u, packages[0]->GetDynamicPackageMap().size());
+
+  ResTable_config config;
+  memset(&config, 0, sizeof(config));
+
+  LoadedArscEntry expected_entry;
+  ResTable_config expected_config;
+  uint32_t expected_flags;
+  ASSERT_TRUE(loaded_arsc->FindEntry(libclient::R::string::foo_one, config, &expected_entry,
+                                     &expected_config, &expected_flags));
+
+  LoadedArscEntry entry;
+  ResTable_config selected_config;
+  uint32_t flags;
+  ASSERT_TRUE(indexed_arsc->FindEntry(libclient::R::string::foo_one, config, &entry,
+                                      &selected_config, &flags));
+  EXPECT_EQ(expected_entry.entry, entry.entry);
+  EXPECT_EQ(expected_flags, flags);
+
+  // The index must be rejected if it was written for different data.
+  EXPECT_EQ(nullptr, LoadedArsc::LoadWithIndex(contents.data(), contents.size(), index.data(),
+                                               index.size(), 0x4321u));
+  EXPECT_EQ(nullptr, LoadedArsc::LoadWithIndex(contents.data(), contents.size() - 4u,
+                                               index.data(), index.size(), 0x1234u));
+  EXPECT_EQ(nullptr, LoadedArsc::LoadWithIndex(contents.data(), contents.size(), index.data(),
+                                               index.size() - 1u, 0x1234u));
+}
+
 // structs with size fields (like Res_value, ResTable_entry) should be
 // backwards and forwards compatible (aka checking the size field against
 // sizeof(Res_value) might not be backwards compatible.
@@ -27,6 +27,8 @@
 #include <fcntl.h>
 #include <string.h>
 
+#include <string>
+
 namespace android {
 
 #define TEST_FILENAME "/test.obb"
@@ -97,4 +99,21 @@ TEST_F(ObbFileTest, WriteThenRead) {
             << "salts should be the same";
 }
 
+TEST_F(ObbFileTest, WriteThenReadLongPackageName) {
+    // Longer than the tail read when looking for the footer
+    const String8 packageName(std::string(2000, 'a').c_str());
+
+    mObbFile->setPackageName(packageName);
+    mObbFile->setVersion(3);
+    EXPECT_TRUE(mObbFile->writeTo(mFileName.string()))
+            << "couldn't write to fake .obb file";
+
+    mObbFile = new ObbFile();
+
+    EXPECT_TRUE(mObbFile->readFrom(mFileName.string()))
+            << "couldn't read from fake .obb file";
+    EXPECT_EQ(3, mObbFile->getVersion());
+    EXPECT_STREQ(packageName.string(), mObbFile->getPackageName().string());
+}
+
 }
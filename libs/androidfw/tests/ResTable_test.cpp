@@ -41,6 +41,21 @@ TEST(ResTableTest, ShouldLoadSuccessfully) {
   ASSERT_EQ(NO_ERROR, table.add(contents.data(), contents.size()));
 }
 
+TEST(ResTableTest, GetEntryCountForType) {
+  std::string contents;
+  ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/basic/basic.apk",
+                                      "resources.arsc", &contents));
+
+  ResTable table;
+  ASSERT_EQ(NO_ERROR, table.add(contents.data(), contents.size()));
+  ASSERT_EQ(size_t(1), table.getBasePackageCount());
+
+  const uint32_t integer_type_id = Res_GETTYPE(basic::R::integer::number1) + 1;
+  EXPECT_EQ(size_t(4), table.getEntryCountForType(0, integer_type_id));
+  EXPECT_EQ(size_t(0), table.getEntryCountForType(0, 0));
+  EXPECT_EQ(size_t(0), table.getEntryCountForType(0, table.getLastTypeIdForPackage(0) + 1));
+}
+
 TEST(ResTableTest, ShouldLoadSparseEntriesSuccessfully) {
   std::string contents;
   ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/sparse/sparse.apk", "resources.arsc",
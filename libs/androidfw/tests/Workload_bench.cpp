@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks that replay short traces of resource accesses, modelled on what the framework does
+// while inflating a layout and while handling a configuration change. Each trace is replayed
+// through AssetManager2 and through the legacy AssetManager/ResTable path, so the two can be
+// compared on the same sequence of calls rather than on a single lookup.
+//
+// Every benchmark labels its result with the number of heap allocations made per iteration.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "benchmark/benchmark.h"
+
+#include "android-base/macros.h"
+#include "android-base/stringprintf.h"
+#include "androidfw/ApkAssets.h"
+#include "androidfw/AssetManager.h"
+#include "androidfw/AssetManager2.h"
+#include "androidfw/ResourceTypes.h"
+
+#include "TestHelpers.h"
+#include "data/basic/R.h"
+#include "data/styles/R.h"
+
+namespace app = com::android::app;
+namespace basic = com::android::basic;
+
+static std::atomic<size_t> gAllocationCount{0};
+
+// Replaces the global allocator of the benchmark binary so that allocations can be counted.
+void* operator new(std::size_t size) {
+  gAllocationCount.fetch_add(1u, std::memory_order_relaxed);
+  void* ptr = malloc(size != 0u ? size : 1u);
+  if (ptr == nullptr) {
+    abort();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+namespace android {
+
+enum class TraceOp {
+  // Applies the style `resid` to the current theme.
+  kApplyStyle,
+
+  // Looks up the attribute `resid` in the current theme and resolves the result.
+  kThemeAttribute,
+
+  // Looks up the bag `resid` and reads each of its entries.
+  kGetBag,
+
+  // Looks up the resource `resid` and resolves any reference it holds.
+  kGetResource,
+};
+
+struct TraceEvent {
+  TraceOp op;
+  uint32_t resid;
+};
+
+// Inflation of a small layout: the activity theme is created, then every view resolves its style
+// and reads its attributes through the theme.
+static const TraceEvent kInflationTrace[] = {
+    {TraceOp::kApplyStyle, app::R::style::StyleOne},
+    {TraceOp::kApplyStyle, app::R::style::StyleTwo},
+
+    // Root view.
+    {TraceOp::kGetBag, app::R::style::StyleTwo},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_one},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_two},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_indirect},
+
+    // First child.
+    {TraceOp::kGetBag, app::R::style::StyleThree},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_one},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_three},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_five},
+    {TraceOp::kGetResource, app::R::string::string_one},
+
+    // Second child, sharing the style of the root view.
+    {TraceOp::kGetBag, app::R::style::StyleTwo},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_two},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_four},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_six},
+    {TraceOp::kThemeAttribute, app::R::attr::attr_empty},
+};
+
+// Reload after a configuration change: the theme is rebuilt and the resources the activity shows
+// are looked up again.
+static const TraceEvent kConfigChangeTrace[] = {
+    {TraceOp::kApplyStyle, basic::R::style::Theme1},
+    {TraceOp::kThemeAttribute, basic::R::attr::attr1},
+    {TraceOp::kThemeAttribute, basic::R::attr::attr2},
+    {TraceOp::kGetResource, basic::R::string::density},
+    {TraceOp::kGetResource, basic::R::string::test1},
+    {TraceOp::kGetResource, basic::R::string::test2},
+    {TraceOp::kGetResource, basic::R::integer::number1},
+    {TraceOp::kGetResource, basic::R::integer::ref1},
+    {TraceOp::kGetBag, basic::R::array::integerArray1},
+};
+
+// The configurations cycled through by the configuration change benchmarks. Each one picks a
+// different density split, and the locales pick values from the de/fr split.
+static std::vector<ResTable_config> MakeConfigChanges() {
+  static const struct {
+    const char* language;
+    uint16_t density;
+  } kChanges[] = {
+      {"en", ResTable_config::DENSITY_HIGH},
+      {"de", ResTable_config::DENSITY_XHIGH},
+      {"fr", ResTable_config::DENSITY_XXHIGH},
+      {"de", ResTable_config::DENSITY_HIGH},
+  };
+
+  std::vector<ResTable_config> configs;
+  for (const auto& change : kChanges) {
+    ResTable_config config;
+    memset(&config, 0, sizeof(config));
+    memcpy(config.language, change.language, 2);
+    config.density = change.density;
+    config.sdkVersion = 21;
+    configs.push_back(config);
+  }
+  return configs;
+}
+
+static std::vector<std::string> GetConfigChangePaths() {
+  const std::string base = GetTestDataPath() + "/basic/";
+  return {base + "basic.apk", base + "basic_de_fr.apk", base + "basic_hdpi-v4.apk",
+          base + "basic_xhdpi-v4.apk", base + "basic_xxhdpi-v4.apk"};
+}
+
+// Labels the benchmark with the allocations made per iteration since `start_count`.
+static void ReportAllocations(size_t start_count, benchmark::State& state) {
+  if (state.iterations() == 0) {
+    return;
+  }
+  const size_t allocations = gAllocationCount.load(std::memory_order_relaxed) - start_count;
+  state.SetLabel(base::StringPrintf("%.1f allocs/iter",
+                                    static_cast<double>(allocations) / state.iterations()));
+}
+
+static void ReplayTrace(const TraceEvent* trace, size_t trace_length, AssetManager2* assets) {
+  std::unique_ptr<Theme> theme = assets->NewTheme();
+  for (size_t i = 0; i < trace_length; i++) {
+    const TraceEvent& event = trace[i];
+    switch (event.op) {
+      case TraceOp::kApplyStyle:
+        theme->ApplyStyle(event.resid, false /* force */);
+        break;
+
+      case TraceOp::kThemeAttribute: {
+        Res_value value;
+        uint32_t flags = 0u;
+        ApkAssetsCookie cookie = theme->GetAttribute(event.resid, &value, &flags);
+        if (cookie != kInvalidCookie) {
+          ResTable_config selected_config;
+          uint32_t last_ref = 0u;
+          theme->ResolveAttributeReference(cookie, &value, &selected_config, &flags, &last_ref);
+        }
+        benchmark::DoNotOptimize(value);
+        break;
+      }
+
+      case TraceOp::kGetBag: {
+        const ResolvedBag* bag = assets->GetBag(event.resid);
+        if (bag == nullptr) {
+          break;
+        }
+        const auto bag_end = end(bag);
+        for (auto iter = begin(bag); iter != bag_end; ++iter) {
+          Res_value value = iter->value;
+          benchmark::DoNotOptimize(value);
+        }
+        break;
+      }
+
+      case TraceOp::kGetResource: {
+        Res_value value;
+        ResTable_config selected_config;
+        uint32_t flags = 0u;
+        ApkAssetsCookie cookie =
+            assets->GetResource(event.resid, false /* may_be_bag */, 0u /* density_override */,
+                                &value, &selected_config, &flags);
+        if (cookie != kInvalidCookie) {
+          uint32_t last_ref = 0u;
+          assets->ResolveReference(cookie, &value, &selected_config, &flags, &last_ref);
+        }
+        benchmark::DoNotOptimize(value);
+        break;
+      }
+    }
+  }
+}
+
+static void ReplayTraceOld(const TraceEvent* trace, size_t trace_length, const ResTable& table) {
+  ResTable::Theme theme(table);
+  for (size_t i = 0; i < trace_length; i++) {
+    const TraceEvent& event = trace[i];
+    switch (event.op) {
+      case TraceOp::kApplyStyle:
+        theme.applyStyle(event.resid, false /* force */);
+        break;
+
+      case TraceOp::kThemeAttribute: {
+        Res_value value;
+        uint32_t flags = 0u;
+        ssize_t block = theme.getAttribute(event.resid, &value, &flags);
+        if (block >= 0) {
+          ResTable_config selected_config;
+          uint32_t last_ref = 0u;
+          theme.resolveAttributeReference(&value, block, &last_ref, &flags, &selected_config);
+        }
+        benchmark::DoNotOptimize(value);
+        break;
+      }
+
+      case TraceOp::kGetBag: {
+        const ResTable::bag_entry* bag_begin;
+        const ssize_t n = table.lockBag(event.resid, &bag_begin);
+        if (n >= 0) {
+          const ResTable::bag_entry* const bag_end = bag_begin + n;
+          for (auto iter = bag_begin; iter != bag_end; ++iter) {
+            Res_value value = iter->map.value;
+            benchmark::DoNotOptimize(value);
+          }
+          table.unlockBag(bag_begin);
+        }
+        break;
+      }
+
+      case TraceOp::kGetResource: {
+        Res_value value;
+        ResTable_config selected_config;
+        uint32_t flags = 0u;
+        ssize_t block = table.getResource(event.resid, &value, false /* may_be_bag */,
+                                          0u /* density */, &flags, &selected_config);
+        if (block >= 0) {
+          uint32_t last_ref = 0u;
+          table.resolveReference(&value, block, &last_ref, &flags, &selected_config);
+        }
+        benchmark::DoNotOptimize(value);
+        break;
+      }
+    }
+  }
+}
+
+static bool LoadApkAssets(const std::vector<std::string>& paths,
+                          std::vector<std::unique_ptr<const ApkAssets>>* out_apk_assets,
+                          benchmark::State& state) {
+  for (const std::string& path : paths) {
+    std::unique_ptr<const ApkAssets> apk = ApkAssets::Load(path);
+    if (apk == nullptr) {
+      state.SkipWithError(base::StringPrintf("Failed to load assets %s", path.c_str()).c_str());
+      return false;
+    }
+    out_apk_assets->push_back(std::move(apk));
+  }
+  return true;
+}
+
+static bool AddAssetPaths(const std::vector<std::string>& paths, AssetManager* assets,
+                          benchmark::State& state) {
+  for (const std::string& path : paths) {
+    if (!assets->addAssetPath(String8(path.c_str()), nullptr /* cookie */, false /* appAsLib */,
+                              false /* isSystemAsset */)) {
+      state.SkipWithError(base::StringPrintf("Failed to load assets %s", path.c_str()).c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::vector<const ApkAssets*> GetPointers(
+    const std::vector<std::unique_ptr<const ApkAssets>>& apk_assets) {
+  std::vector<const ApkAssets*> ptrs;
+  for (const auto& apk : apk_assets) {
+    ptrs.push_back(apk.get());
+  }
+  return ptrs;
+}
+
+static void BM_WorkloadInflation(benchmark::State& state) {
+  std::vector<std::unique_ptr<const ApkAssets>> apk_assets;
+  if (!LoadApkAssets({GetTestDataPath() + "/styles/styles.apk"}, &apk_assets, state)) {
+    return;
+  }
+
+  AssetManager2 assets;
+  assets.SetApkAssets(GetPointers(apk_assets));
+
+  const size_t start_count = gAllocationCount.load(std::memory_order_relaxed);
+  while (state.KeepRunning()) {
+    ReplayTrace(kInflationTrace, arraysize(kInflationTrace), &assets);
+  }
+  ReportAllocations(start_count, state);
+}
+BENCHMARK(BM_WorkloadInflation);
+
+static void BM_WorkloadInflationOld(benchmark::State& state) {
+  AssetManager assets;
+  if (!AddAssetPaths({GetTestDataPath() + "/styles/styles.apk"}, &assets, state)) {
+    return;
+  }
+
+  const ResTable& table = assets.getResources(true);
+
+  const size_t start_count = gAllocationCount.load(std::memory_order_relaxed);
+  while (state.KeepRunning()) {
+    ReplayTraceOld(kInflationTrace, arraysize(kInflationTrace), table);
+  }
+  ReportAllocations(start_count, state);
+}
+BENCHMARK(BM_WorkloadInflationOld);
+
+static void BM_WorkloadConfigChange(benchmark::State& state) {
+  std::vector<std::unique_ptr<const ApkAssets>> apk_assets;
+  if (!LoadApkAssets(GetConfigChangePaths(), &apk_assets, state)) {
+    return;
+  }
+
+  AssetManager2 assets;
+  assets.SetApkAssets(GetPointers(apk_assets));
+
+  const std::vector<ResTable_config> configs = MakeConfigChanges();
+  size_t next_config = 0u;
+
+  const size_t start_count = gAllocationCount.load(std::memory_order_relaxed);
+  while (state.KeepRunning()) {
+    assets.SetConfiguration(configs[next_config]);
+    next_config = (next_config + 1u) % configs.size();
+    ReplayTrace(kConfigChangeTrace, arraysize(kConfigChangeTrace), &assets);
+  }
+  ReportAllocations(start_count, state);
+}
+BENCHMARK(BM_WorkloadConfigChange);
+
+static void BM_WorkloadConfigChangeOld(benchmark::State& state) {
+  AssetManager assets;
+  if (!AddAssetPaths(GetConfigChangePaths(), &assets, state)) {
+    return;
+  }
+
+  const std::vector<ResTable_config> configs = MakeConfigChanges();
+  size_t next_config = 0u;
+
+  const size_t start_count = gAllocationCount.load(std::memory_order_relaxed);
+  while (state.KeepRunning()) {
+    assets.setConfiguration(configs[next_config]);
+    next_config = (next_config + 1u) % configs.size();
+    ReplayTraceOld(kConfigChangeTrace, arraysize(kConfigChangeTrace), assets.getResources(true));
+  }
+  ReportAllocations(start_count, state);
+}
+BENCHMARK(BM_WorkloadConfigChangeOld);
+
+// Loading the APKs is part of a cold start, so it is measured together with the first replay.
+static void BM_WorkloadColdConfigChange(benchmark::State& state) {
+  const std::vector<std::string> paths = GetConfigChangePaths();
+  const std::vector<ResTable_config> configs = MakeConfigChanges();
+
+  const size_t start_count = gAllocationCount.load(std::memory_order_relaxed);
+  while (state.KeepRunning()) {
+    std::vector<std::unique_ptr<const ApkAssets>> apk_assets;
+    if (!LoadApkAssets(paths, &apk_assets, state)) {
+      return;
+    }
+
+    AssetManager2 assets;
+    assets.SetApkAssets(GetPointers(apk_assets));
+    assets.SetConfiguration(configs[0]);
+    ReplayTrace(kConfigChangeTrace, arraysize(kConfigChangeTrace), &assets);
+  }
+  ReportAllocations(start_count, state);
+}
+BENCHMARK(BM_WorkloadColdConfigChange);
+
+static void BM_WorkloadColdConfigChangeOld(benchmark::State& state) {
+  const std::vector<std::string> paths = GetConfigChangePaths();
+  const std::vector<ResTable_config> configs = MakeConfigChanges();
+
+  const size_t start_count = gAllocationCount.load(std::memory_order_relaxed);
+  while (state.KeepRunning()) {
+    AssetManager assets;
+    if (!AddAssetPaths(paths, &assets, state)) {
+      return;
+    }
+
+    assets.setConfiguration(configs[0]);
+    ReplayTraceOld(kConfigChangeTrace, arraysize(kConfigChangeTrace), assets.getResources(true));
+  }
+  ReportAllocations(start_count, state);
+}
+BENCHMARK(BM_WorkloadColdConfigChangeOld);
+
+}  // namespace android
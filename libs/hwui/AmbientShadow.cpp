@@ -59,20 +59,20 @@
 #include <algorithm>
 #include <utils/Log.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define SHADOW_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SHADOW_USE_SSE2
+#endif
+
 namespace android {
 namespace uirenderer {
 
 /**
  *  Local utility functions.
  */
-inline Vector2 getNormalFromVertices(const Vector3* vertices, int current, int next) {
-    // Convert from Vector3 to Vector2 first.
-    Vector2 currentVertex = { vertices[current].x, vertices[current].y };
-    Vector2 nextVertex = { vertices[next].x, vertices[next].y };
-
-    return ShadowTessellator::calculateNormal(currentVertex, nextVertex);
-}
-
 // The input z value will be converted to be non-negative inside.
 // The output must be ranged from 0 to 1.
 inline float getAlphaFromFactoredZ(float factoredZ) {
@@ -119,6 +119,35 @@ inline bool needsExtraForEdge(float firstAlpha, float secondAlpha) {
     return fabsf(firstAlpha - secondAlpha) > ALPHA_THRESHOLD;
 }
 
+// Fills alphas with getAlphaFromFactoredZ() of each vertex, four vertices at a time where SIMD
+// is available.
+inline void computeVertexAlphas(const Vector3* vertices, int vertexCount, float heightFactor,
+        float* alphas) {
+    int i = 0;
+#if defined(SHADOW_USE_NEON)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (; i + 4 <= vertexCount; i += 4) {
+        float32x4x3_t v = vld3q_f32(&vertices[i].x);
+        float32x4_t factoredZ = vmaxq_f32(vmulq_f32(v.val[2], vdupq_n_f32(heightFactor)),
+                vdupq_n_f32(0.0f));
+        vst1q_f32(alphas + i, vdivq_f32(one, vaddq_f32(one, factoredZ)));
+    }
+#elif defined(SHADOW_USE_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= vertexCount; i += 4) {
+        __m128 z = _mm_setr_ps(vertices[i].z, vertices[i + 1].z,
+                vertices[i + 2].z, vertices[i + 3].z);
+        // operand order matches std::max() for NaN
+        __m128 factoredZ = _mm_max_ps(_mm_setzero_ps(),
+                _mm_mul_ps(z, _mm_set1_ps(heightFactor)));
+        _mm_storeu_ps(alphas + i, _mm_div_ps(one, _mm_add_ps(one, factoredZ)));
+    }
+#endif
+    for (; i < vertexCount; i++) {
+        alphas[i] = getAlphaFromFactoredZ(vertices[i].z * heightFactor);
+    }
+}
+
 /**
  * Calculate the shadows as a triangle strips while alpha value as the
  * shadow values.
@@ -168,15 +197,25 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
         float heightFactor, float geomFactor, VertexBuffer& shadowVertexBuffer) {
     shadowVertexBuffer.setMeshFeatureFlags(VertexBuffer::kAlpha | VertexBuffer::kIndices);
 
+    // The edge normals and vertex alphas only depend on the caster, so compute them for the
+    // whole polygon up front, rather than for each vertex of the (branchy) loop below.
+    Vector2 casterVertices2d[casterVertexCount];
+    for (int i = 0; i < casterVertexCount; i++) {
+        casterVertices2d[i] = (Vector2){casterVertices[i].x, casterVertices[i].y};
+    }
+    Vector2 normals[casterVertexCount];
+    ShadowTessellator::calculateNormals(casterVertices2d, casterVertexCount, normals);
+    float alphas[casterVertexCount];
+    computeVertexAlphas(casterVertices, casterVertexCount, heightFactor, alphas);
+
     // In order to computer the outer vertices in one loop, we need pre-compute
     // the normal by the vertex (n - 1) to vertex 0, and the spike and alpha value
     // for vertex 0.
-    Vector2 previousNormal = getNormalFromVertices(casterVertices,
-            casterVertexCount - 1 , 0);
+    Vector2 previousNormal = normals[casterVertexCount - 1];
     Vector2 currentSpike = {casterVertices[0].x - centroid3d.x,
         casterVertices[0].y - centroid3d.y};
     currentSpike.normalize();
-    float currentAlpha = getAlphaFromFactoredZ(casterVertices[0].z * heightFactor);
+    float currentAlpha = alphas[0];
 
     // Preparing all the output data.
     int totalVertexCount, totalIndexCount, totalUmbraCount;
@@ -193,8 +232,7 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
     for (int i = 0; i < casterVertexCount; i++)  {
         // Corner: first figure out the extra vertices we need for the corner.
         const Vector3& innerVertex = casterVertices[i];
-        Vector2 currentNormal = getNormalFromVertices(casterVertices, i,
-                (i + 1) % casterVertexCount);
+        const Vector2& currentNormal = normals[i];
 
         int extraVerticesNumber = ShadowTessellator::getExtraVertexNumber(currentNormal,
                 previousNormal, CORNER_RADIANS_DIVISOR);
@@ -248,7 +286,7 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
 
         // Edge: first figure out the extra vertices needed for the edge.
         const Vector3& innerNext = casterVertices[(i + 1) % casterVertexCount];
-        float nextAlpha = getAlphaFromFactoredZ(innerNext.z * heightFactor);
+        float nextAlpha = alphas[(i + 1) % casterVertexCount];
         if (needsExtraForEdge(currentAlpha, nextAlpha)) {
             // TODO: See if we can / should cache this outer vertex across the loop.
             Vector2 outerNext;
@@ -17,6 +17,7 @@ hwui_src_files := \
     hwui/MinikinSkia.cpp \
     hwui/MinikinUtils.cpp \
     hwui/PaintImpl.cpp \
+    hwui/PixelBufferPool.cpp \
     hwui/Typeface.cpp \
     pipeline/skia/GLFunctorDrawable.cpp \
     pipeline/skia/LayerDrawable.cpp \
@@ -47,6 +48,7 @@ hwui_src_files := \
     renderthread/RenderThread.cpp \
     renderthread/TimeLord.cpp \
     renderthread/Frame.cpp \
+    renderthread/GpuCompletionTracker.cpp \
     service/GraphicsStatsService.cpp \
     thread/TaskManager.cpp \
     utils/Blur.cpp \
@@ -70,6 +72,7 @@ hwui_src_files := \
     DeferredLayerUpdater.cpp \
     DeviceInfo.cpp \
     DisplayList.cpp \
+    DisplayListDiff.cpp \
     Extensions.cpp \
     FboCache.cpp \
     FontRenderer.cpp \
@@ -117,6 +120,7 @@ hwui_src_files := \
     TextDropShadowCache.cpp \
     Texture.cpp \
     TextureCache.cpp \
+    TextureUploader.cpp \
     VectorDrawable.cpp \
     VkLayer.cpp \
     protos/hwui.proto
@@ -286,12 +290,14 @@ LOCAL_SRC_FILES += \
     tests/unit/BakedOpRendererTests.cpp \
     tests/unit/BakedOpStateTests.cpp \
     tests/unit/BitmapTests.cpp \
+    tests/unit/BlurTests.cpp \
     tests/unit/CanvasContextTests.cpp \
     tests/unit/CanvasStateTests.cpp \
     tests/unit/ClipAreaTests.cpp \
     tests/unit/DamageAccumulatorTests.cpp \
     tests/unit/DeferredLayerUpdaterTests.cpp \
     tests/unit/DeviceInfoTests.cpp \
+    tests/unit/DisplayListDiffTests.cpp \
     tests/unit/FatVectorTests.cpp \
     tests/unit/FontRendererTests.cpp \
     tests/unit/FrameBuilderTests.cpp \
@@ -299,6 +305,7 @@ LOCAL_SRC_FILES += \
     tests/unit/GpuMemoryTrackerTests.cpp \
     tests/unit/GradientCacheTests.cpp \
     tests/unit/GraphicsStatsServiceTests.cpp \
+    tests/unit/JankTrackerTests.cpp \
     tests/unit/LayerUpdateQueueTests.cpp \
     tests/unit/LeakCheckTests.cpp \
     tests/unit/LinearAllocatorTests.cpp \
@@ -306,7 +313,10 @@ LOCAL_SRC_FILES += \
     tests/unit/MeshStateTests.cpp \
     tests/unit/OffscreenBufferPoolTests.cpp \
     tests/unit/OpDumperTests.cpp \
+    tests/unit/PatchCacheTests.cpp \
     tests/unit/PathInterpolatorTests.cpp \
+    tests/unit/PixelBufferPoolTests.cpp \
+    tests/unit/ProgramCacheTests.cpp \
     tests/unit/RenderNodeDrawableTests.cpp \
     tests/unit/RecordingCanvasTests.cpp \
     tests/unit/RenderNodeTests.cpp \
@@ -317,7 +327,10 @@ LOCAL_SRC_FILES += \
     tests/unit/SkiaRenderPropertiesTests.cpp \
     tests/unit/SkiaCanvasTests.cpp \
     tests/unit/SnapshotTests.cpp \
+    tests/unit/SpmcRingBufferTests.cpp \
     tests/unit/StringUtilsTests.cpp \
+    tests/unit/TaskQueueTests.cpp \
+    tests/unit/TessellationCacheTests.cpp \
     tests/unit/TestUtilsTests.cpp \
     tests/unit/TextDropShadowCacheTests.cpp \
     tests/unit/TextureCacheTests.cpp \
@@ -346,6 +359,7 @@ LOCAL_SHARED_LIBRARIES := libmemunreachable
 
 LOCAL_SRC_FILES += \
     $(hwui_test_common_src_files) \
+    tests/macrobench/FrameStatsWriter.cpp \
     tests/macrobench/TestSceneRunner.cpp \
     tests/macrobench/main.cpp
 
@@ -372,6 +386,7 @@ LOCAL_SHARED_LIBRARIES := libmemunreachable
 LOCAL_SRC_FILES += \
     $(hwui_test_common_src_files) \
     tests/microbench/main.cpp \
+    tests/microbench/BlurBench.cpp \
     tests/microbench/DisplayListCanvasBench.cpp \
     tests/microbench/FontBench.cpp \
     tests/microbench/FrameBuilderBench.cpp \
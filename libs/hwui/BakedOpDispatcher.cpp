@@ -685,6 +685,7 @@ void BakedOpDispatcher::onRoundRectOp(BakedOpRenderer& renderer, const RoundRect
 }
 
 static void renderShadow(BakedOpRenderer& renderer, const BakedOpState& state, float casterAlpha,
+        const Vector2& translation,
         const VertexBuffer* ambientShadowVertexBuffer, const VertexBuffer* spotShadowVertexBuffer) {
     SkPaint paint;
     paint.setAntiAlias(true); // want to use AlphaVertex
@@ -696,7 +697,8 @@ static void renderShadow(BakedOpRenderer& renderer, const BakedOpState& state, f
     }
     if (ambientShadowVertexBuffer && ambientShadowAlpha > 0) {
         paint.setAlpha((uint8_t)(casterAlpha * ambientShadowAlpha));
-        renderVertexBuffer(renderer, state, *ambientShadowVertexBuffer, 0, 0,
+        renderVertexBuffer(renderer, state, *ambientShadowVertexBuffer,
+                translation.x, translation.y,
                 paint, VertexBufferRenderFlags::ShadowInterp);
     }
 
@@ -706,14 +708,16 @@ static void renderShadow(BakedOpRenderer& renderer, const BakedOpState& state, f
     }
     if (spotShadowVertexBuffer && spotShadowAlpha > 0) {
         paint.setAlpha((uint8_t)(casterAlpha * spotShadowAlpha));
-        renderVertexBuffer(renderer, state, *spotShadowVertexBuffer, 0, 0,
+        renderVertexBuffer(renderer, state, *spotShadowVertexBuffer,
+                translation.x, translation.y,
                 paint, VertexBufferRenderFlags::ShadowInterp);
     }
 }
 
 void BakedOpDispatcher::onShadowOp(BakedOpRenderer& renderer, const ShadowOp& op, const BakedOpState& state) {
     TessellationCache::vertexBuffer_pair_t buffers = op.shadowTask->getResult();
-    renderShadow(renderer, state, op.casterAlpha, buffers.first, buffers.second);
+    renderShadow(renderer, state, op.casterAlpha, op.translation,
+            buffers.first, buffers.second);
 }
 
 void BakedOpDispatcher::onSimpleRectsOp(BakedOpRenderer& renderer, const SimpleRectsOp& op, const BakedOpState& state) {
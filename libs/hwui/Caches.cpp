@@ -76,6 +76,8 @@ bool Caches::init() {
     mTextureState = new TextureState();
     mTextureState->constructTexture(*this);
 
+    programCache.loadDiskCache();
+
     return true;
 }
 
@@ -113,6 +115,8 @@ void Caches::terminate() {
 
     patchCache.clear();
 
+    textureCache.destroyTextureUploader();
+
     clearGarbage();
 
     delete mPixelBufferState;
@@ -154,6 +158,19 @@ uint32_t Caches::getOverdrawColor(uint32_t amount) const {
     return sOverdrawColors[overdrawColorIndex][amount - 1];
 }
 
+uint32_t Caches::getCacheMemoryUsage() {
+    uint32_t total = 0;
+    total += textureCache.getSize();
+    total += renderBufferCache.getSize();
+    total += gradientCache.getSize();
+    total += pathCache.getSize();
+    total += tessellationCache.getSize();
+    total += dropShadowCache.getSize();
+    total += patchCache.getSize();
+    total += fontRenderer.getSize();
+    return total;
+}
+
 void Caches::dumpMemoryUsage() {
     String8 stringLog;
     dumpMemoryUsage(stringLog);
@@ -201,14 +218,7 @@ void Caches::dumpMemoryUsage(String8 &log) {
     log.appendFormat("  FboCache             %8d / %8d\n",
             fboCache.getSize(), fboCache.getMaxSize());
 
-    total += textureCache.getSize();
-    total += renderBufferCache.getSize();
-    total += gradientCache.getSize();
-    total += pathCache.getSize();
-    total += tessellationCache.getSize();
-    total += dropShadowCache.getSize();
-    total += patchCache.getSize();
-    total += fontRenderer.getSize();
+    total += getCacheMemoryUsage();
 
     log.appendFormat("Total memory usage:\n");
     log.appendFormat("  %d bytes, %.2f MB\n", total, total / 1024.0f / 1024.0f);
@@ -240,6 +250,7 @@ void Caches::flush(FlushMode mode) {
             fboCache.clear();
             // fall through
         case FlushMode::Moderate:
+            programCache.saveDiskCache();
             fontRenderer.flush();
             textureCache.flush();
             pathCache.clear();
@@ -139,6 +139,11 @@ public:
     /**
      * Displays the memory usage of each cache and the total sum.
      */
+    /**
+     * Returns the number of bytes held by the caches that flush() can release.
+     */
+    uint32_t getCacheMemoryUsage();
+
     void dumpMemoryUsage();
     void dumpMemoryUsage(String8& log);
 
@@ -24,20 +24,10 @@
 namespace android {
 namespace uirenderer {
 
-static void handlePoint(Rect& transformedBounds, const Matrix4& transform, float x, float y) {
-    Vertex v = {x, y};
-    transform.mapPoint(v.x, v.y);
-    transformedBounds.expandToCover(v.x, v.y);
-}
-
 Rect transformAndCalculateBounds(const Rect& r, const Matrix4& transform) {
-    const float kMinFloat = std::numeric_limits<float>::lowest();
-    const float kMaxFloat = std::numeric_limits<float>::max();
-    Rect transformedBounds = { kMaxFloat, kMaxFloat, kMinFloat, kMinFloat };
-    handlePoint(transformedBounds, transform, r.left, r.top);
-    handlePoint(transformedBounds, transform, r.right, r.top);
-    handlePoint(transformedBounds, transform, r.left, r.bottom);
-    handlePoint(transformedBounds, transform, r.right, r.bottom);
+    // mapRect() bounds the four mapped corners, with a fast path for scale/translate transforms.
+    Rect transformedBounds(r);
+    transform.mapRect(transformedBounds);
     return transformedBounds;
 }
 
@@ -112,6 +102,20 @@ void RectangleList::set(const Rect& bounds, const Matrix4& transform) {
 
 bool RectangleList::intersectWith(const Rect& bounds,
         const Matrix4& transform) {
+    if (transform.rectToRect() && !transform.isIdentity()) {
+        // Rectangles that stay axis aligned can be folded into an identity rectangle in
+        // device space, rather than using up an entry of the list.
+        Rect mappedBounds(bounds);
+        transform.mapRect(mappedBounds);
+        for (int index = 0; index < mTransformedRectanglesCount; index++) {
+            TransformedRectangle& tr(mTransformedRectangles[index]);
+            if (tr.getTransform().isIdentity()) {
+                tr.intersectWith(TransformedRectangle(mappedBounds, Matrix4::identity()));
+                return true;
+            }
+        }
+    }
+
     TransformedRectangle newRectangle(bounds, transform);
 
     // Try to find a rectangle with a compatible transformation
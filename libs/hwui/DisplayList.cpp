@@ -122,6 +122,7 @@ bool DisplayList::prepareListAndChildren(TreeObserver& observer, TreeInfo& info,
         // If any vector drawable in the display list needs update, damage the node.
         if (vectorDrawable->isDirty()) {
             isDirty = true;
+            info.canvasContext.scheduleVectorDrawableUpdate(vectorDrawable);
         }
         vectorDrawable->setPropertyChangeWillBeConsumed(true);
     }
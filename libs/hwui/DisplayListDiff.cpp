@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DisplayListDiff.h"
+
+#include "ClipArea.h"
+#include "DisplayList.h"
+#include "RecordedOp.h"
+#include "Rect.h"
+
+#include <SkPaint.h>
+#include <SkPath.h>
+
+#include <cstring>
+
+namespace android {
+namespace uirenderer {
+
+enum class OpComparison {
+    // The ops draw the same content
+    Same,
+    // The ops may draw different content, but only inside their recorded bounds
+    Changed,
+    // The ops can't be compared, or may draw outside of their recorded bounds
+    Incomparable,
+};
+
+template <typename T>
+static bool buffersEqual(const T* a, const T* b, size_t count) {
+    return a == b || !memcmp(a, b, count * sizeof(T));
+}
+
+static bool clipsEqual(const ClipBase* a, const ClipBase* b) {
+    if (a == b) return true;
+    if (!a || !b) return false;
+    // Only plain rect clips are compared by value, since those are the common case
+    return a->mode == ClipMode::Rectangle && b->mode == ClipMode::Rectangle
+            && a->intersectWithRoot == b->intersectWithRoot
+            && a->rect == b->rect;
+}
+
+static bool paintsEqual(const SkPaint* a, const SkPaint* b) {
+    if (a == b) return true;
+    return a && b && *a == *b;
+}
+
+// Effects that can draw outside of the recorded bounds of an op
+static bool hasUnboundedEffects(const SkPaint* paint) {
+    return paint && (paint->getLooper() || paint->getMaskFilter() || paint->getImageFilter());
+}
+
+static bool bitmapsEqual(const Bitmap* a, const Bitmap* b) {
+    // The contents of a mutable bitmap may have changed since the previous recording
+    return a == b && a->isImmutable();
+}
+
+static OpComparison compareBoundedOps(const RecordedOp& a, const RecordedOp& b) {
+    bool same = false;
+    switch (a.opId) {
+    case RecordedOpId::OvalOp:
+    case RecordedOpId::RectOp:
+        same = true;
+        break;
+    case RecordedOpId::ArcOp: {
+        auto& arcA = static_cast<const ArcOp&>(a);
+        auto& arcB = static_cast<const ArcOp&>(b);
+        same = arcA.startAngle == arcB.startAngle
+                && arcA.sweepAngle == arcB.sweepAngle
+                && arcA.useCenter == arcB.useCenter;
+        break;
+    }
+    case RecordedOpId::RoundRectOp: {
+        auto& rrA = static_cast<const RoundRectOp&>(a);
+        auto& rrB = static_cast<const RoundRectOp&>(b);
+        same = rrA.rx == rrB.rx && rrA.ry == rrB.ry;
+        break;
+    }
+    case RecordedOpId::BitmapOp:
+        same = bitmapsEqual(static_cast<const BitmapOp&>(a).bitmap,
+                static_cast<const BitmapOp&>(b).bitmap);
+        break;
+    case RecordedOpId::BitmapRectOp: {
+        auto& bitmapA = static_cast<const BitmapRectOp&>(a);
+        auto& bitmapB = static_cast<const BitmapRectOp&>(b);
+        same = bitmapsEqual(bitmapA.bitmap, bitmapB.bitmap) && bitmapA.src == bitmapB.src;
+        break;
+    }
+    case RecordedOpId::PatchOp: {
+        auto& patchA = static_cast<const PatchOp&>(a);
+        auto& patchB = static_cast<const PatchOp&>(b);
+        same = bitmapsEqual(patchA.bitmap, patchB.bitmap) && patchA.patch == patchB.patch;
+        break;
+    }
+    case RecordedOpId::PathOp:
+        same = *(static_cast<const PathOp&>(a).path) == *(static_cast<const PathOp&>(b).path);
+        break;
+    case RecordedOpId::LinesOp:
+    case RecordedOpId::PointsOp: {
+        // LinesOp and PointsOp share the same layout
+        auto& pointsA = static_cast<const PointsOp&>(a);
+        auto& pointsB = static_cast<const PointsOp&>(b);
+        same = pointsA.floatCount == pointsB.floatCount
+                && buffersEqual(pointsA.points, pointsB.points, pointsA.floatCount);
+        break;
+    }
+    case RecordedOpId::SimpleRectsOp: {
+        auto& rectsA = static_cast<const SimpleRectsOp&>(a);
+        auto& rectsB = static_cast<const SimpleRectsOp&>(b);
+        same = rectsA.vertexCount == rectsB.vertexCount
+                && buffersEqual(rectsA.vertices, rectsB.vertices, rectsA.vertexCount);
+        break;
+    }
+    case RecordedOpId::TextOp: {
+        auto& textA = static_cast<const TextOp&>(a);
+        auto& textB = static_cast<const TextOp&>(b);
+        same = textA.glyphCount == textB.glyphCount
+                && textA.x == textB.x && textA.y == textB.y
+                && buffersEqual(textA.glyphs, textB.glyphs, textA.glyphCount)
+                && buffersEqual(textA.positions, textB.positions, textA.glyphCount * 2);
+        break;
+    }
+    default:
+        LOG_ALWAYS_FATAL("unexpected op %d", a.opId);
+    }
+    return same ? OpComparison::Same : OpComparison::Changed;
+}
+
+static OpComparison compareOps(const RecordedOp& a, const RecordedOp& b) {
+    if (a.opId != b.opId) return OpComparison::Incomparable;
+
+    bool baseEqual = a.unmappedBounds == b.unmappedBounds
+            && a.localMatrix == b.localMatrix
+            && clipsEqual(a.localClip, b.localClip)
+            && paintsEqual(a.paint, b.paint);
+
+    switch (a.opId) {
+    case RecordedOpId::ArcOp:
+    case RecordedOpId::BitmapOp:
+    case RecordedOpId::BitmapRectOp:
+    case RecordedOpId::LinesOp:
+    case RecordedOpId::OvalOp:
+    case RecordedOpId::PatchOp:
+    case RecordedOpId::PathOp:
+    case RecordedOpId::PointsOp:
+    case RecordedOpId::RectOp:
+    case RecordedOpId::RoundRectOp:
+    case RecordedOpId::SimpleRectsOp:
+    case RecordedOpId::TextOp: {
+        // A change drawn through a blur, shadow or filter may reach outside of the bounds
+        bool unbounded = hasUnboundedEffects(a.paint) || hasUnboundedEffects(b.paint);
+        OpComparison result = baseEqual ? compareBoundedOps(a, b) : OpComparison::Changed;
+        return (unbounded && result == OpComparison::Changed)
+                ? OpComparison::Incomparable : result;
+    }
+    case RecordedOpId::RenderNodeOp:
+        // The child damages itself when its own content or properties change, but moving it
+        // within this list may affect more than its recorded bounds (shadows, projection...)
+        return baseEqual && static_cast<const RenderNodeOp&>(a).renderNode
+                        == static_cast<const RenderNodeOp&>(b).renderNode
+                ? OpComparison::Same : OpComparison::Incomparable;
+    case RecordedOpId::VectorDrawableOp:
+        // Changes to the tree itself are reported by DisplayList::prepareListAndChildren()
+        return baseEqual && static_cast<const VectorDrawableOp&>(a).vectorDrawable
+                        == static_cast<const VectorDrawableOp&>(b).vectorDrawable
+                ? OpComparison::Same : OpComparison::Incomparable;
+    case RecordedOpId::ColorOp: {
+        auto& colorA = static_cast<const ColorOp&>(a);
+        auto& colorB = static_cast<const ColorOp&>(b);
+        return baseEqual && colorA.color == colorB.color && colorA.mode == colorB.mode
+                ? OpComparison::Same : OpComparison::Incomparable;
+    }
+    case RecordedOpId::BeginLayerOp:
+    case RecordedOpId::EndLayerOp:
+    case RecordedOpId::BeginUnclippedLayerOp:
+    case RecordedOpId::EndUnclippedLayerOp:
+        return baseEqual ? OpComparison::Same : OpComparison::Incomparable;
+    default:
+        // Functors, texture layers and ops that read animated properties or transform their
+        // content in ways that aren't captured by the recorded bounds.
+        return OpComparison::Incomparable;
+    }
+}
+
+static void unionRecordedBounds(const RecordedOp& op, Rect* damage) {
+    Rect bounds = op.unmappedBounds;
+    if (op.paint && (op.paint->getStyle() != SkPaint::kFill_Style
+            || op.opId == RecordedOpId::LinesOp || op.opId == RecordedOpId::PointsOp)) {
+        bounds.outset(op.paint->getStrokeWidth() * 0.5f);
+    }
+    op.localMatrix.mapRect(bounds);
+    // Account for hairlines and antialiasing
+    bounds.outset(1);
+    if (op.localClip) {
+        bounds.doIntersect(op.localClip->rect);
+    }
+    damage->unionWith(bounds);
+}
+
+static bool chunksEqual(const DisplayList::Chunk& a, const DisplayList::Chunk& b) {
+    return a.beginOpIndex == b.beginOpIndex
+            && a.endOpIndex == b.endOpIndex
+            && a.beginChildIndex == b.beginChildIndex
+            && a.endChildIndex == b.endChildIndex
+            && a.reorderChildren == b.reorderChildren
+            && clipsEqual(a.reorderClip, b.reorderClip);
+}
+
+bool DisplayListDiff::computeDamage(const DisplayList& previous, const DisplayList& next,
+        Rect* outDamage) {
+    outDamage->setEmpty();
+    if (previous.isSkiaDL() || next.isSkiaDL()
+            || previous.hasFunctor() || next.hasFunctor()
+            || previous.projectionReceiveIndex != next.projectionReceiveIndex) {
+        return false;
+    }
+
+    const auto& previousChunks = previous.getChunks();
+    const auto& nextChunks = next.getChunks();
+    if (previousChunks.size() != nextChunks.size()) return false;
+    for (size_t i = 0; i < nextChunks.size(); i++) {
+        if (!chunksEqual(previousChunks[i], nextChunks[i])) return false;
+    }
+
+    const auto& previousOps = previous.getOps();
+    const auto& nextOps = next.getOps();
+    if (previousOps.size() != nextOps.size()) return false;
+    for (size_t i = 0; i < nextOps.size(); i++) {
+        switch (compareOps(*previousOps[i], *nextOps[i])) {
+        case OpComparison::Same:
+            break;
+        case OpComparison::Changed:
+            unionRecordedBounds(*previousOps[i], outDamage);
+            unionRecordedBounds(*nextOps[i], outDamage);
+            break;
+        case OpComparison::Incomparable:
+            return false;
+        }
+    }
+    return true;
+}
+
+}; // namespace uirenderer
+}; // namespace android
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+namespace android {
+namespace uirenderer {
+
+class DisplayList;
+class Rect;
+
+/**
+ * Structural comparison of a RenderNode's re-recorded DisplayList against the one it replaces,
+ * so that a small change to a large view (e.g. a single paint color) only damages the ops that
+ * actually changed, instead of the whole node.
+ *
+ * Only OpenGL pipeline DisplayLists are compared. Ops are matched one to one, in order; any
+ * insertion, removal or op whose output can't be bounded from the recorded data (children,
+ * layers, functors, animated props, ...) makes the lists incomparable.
+ */
+class DisplayListDiff {
+public:
+    /**
+     * Returns true if the two lists could be compared, in which case outDamage is set to the
+     * union of the recording space bounds of every op that differs between them (empty if the
+     * lists draw the same content). Returns false if the whole node must be damaged.
+     */
+    static bool computeDamage(const DisplayList& previous, const DisplayList& next,
+            Rect* outDamage);
+};
+
+}; // namespace uirenderer
+}; // namespace android
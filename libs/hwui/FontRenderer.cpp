@@ -93,6 +93,8 @@ FontRenderer::FontRenderer(const uint8_t* gammaTable)
         , mBounds(nullptr)
         , mDrawn(false)
         , mInitialized(false)
+        , mNextEvictedACacheTexture(0)
+        , mNextEvictedRGBACacheTexture(0)
         , mLinearFiltering(false) {
 
     if (sLogFontRendererCreate) {
@@ -148,6 +150,10 @@ FontRenderer::~FontRenderer() {
 void FontRenderer::flushAllAndInvalidate() {
     issueDrawCommand();
 
+#ifdef BUGREPORT_FONT_CACHE_USAGE
+    mHistoryTracker.cacheFlushed();
+#endif
+
     LruCache<Font::FontDescription, Font*>::Iterator it(mActiveFonts);
     while (it.next()) {
         it.value()->invalidateTextureCache();
@@ -205,6 +211,40 @@ CacheTexture* FontRenderer::cacheBitmapInTexture(std::vector<CacheTexture*>& cac
     return nullptr;
 }
 
+CacheTexture* FontRenderer::evictAndCacheBitmap(std::vector<CacheTexture*>& cacheTextures,
+        const SkGlyph& glyph, uint32_t* startX, uint32_t* startY) {
+    uint32_t& nextEvicted = (&cacheTextures == &mACacheTextures) ?
+            mNextEvictedACacheTexture : mNextEvictedRGBACacheTexture;
+
+    // Textures are evicted in turn, so the one we clear is the one filled the longest ago.
+    // Glyphs in the other textures stay valid, which avoids re-rasterizing everything.
+    for (uint32_t i = 0; i < cacheTextures.size(); i++) {
+        CacheTexture* cacheTexture = cacheTextures[nextEvicted];
+        nextEvicted = (nextEvicted + 1) % cacheTextures.size();
+        if (glyph.fHeight + TEXTURE_BORDER_SIZE * 2 > cacheTexture->getHeight()
+                || glyph.fWidth + TEXTURE_BORDER_SIZE * 2 > cacheTexture->getWidth()) {
+            continue;
+        }
+
+        // Queued quads may still point into this texture
+        issueDrawCommand();
+
+        LruCache<Font::FontDescription, Font*>::Iterator it(mActiveFonts);
+        while (it.next()) {
+            it.value()->invalidateTextureCache(cacheTexture);
+        }
+        cacheTexture->init();
+#ifdef BUGREPORT_FONT_CACHE_USAGE
+        mHistoryTracker.textureEvicted(cacheTexture);
+#endif
+
+        if (cacheTexture->fitBitmap(glyph, startX, startY)) {
+            return cacheTexture;
+        }
+    }
+    return nullptr;
+}
+
 void FontRenderer::cacheBitmap(const SkGlyph& glyph, CachedGlyphInfo* cachedGlyph,
         uint32_t* retOriginX, uint32_t* retOriginY, bool precaching) {
     checkInit();
@@ -254,9 +294,12 @@ void FontRenderer::cacheBitmap(const SkGlyph& glyph, CachedGlyphInfo* cachedGlyp
     if (!cacheTexture) {
         if (!precaching) {
             // If the new glyph didn't fit and we are not just trying to precache it,
-            // clear out the cache and try again
-            flushAllAndInvalidate();
-            cacheTexture = cacheBitmapInTexture(*cacheTextures, glyph, &startX, &startY);
+            // make room in one texture, or clear out the whole cache as a last resort
+            cacheTexture = evictAndCacheBitmap(*cacheTextures, glyph, &startX, &startY);
+            if (!cacheTexture) {
+                flushAllAndInvalidate();
+                cacheTexture = cacheBitmapInTexture(*cacheTextures, glyph, &startX, &startY);
+            }
         }
 
         if (!cacheTexture) {
@@ -721,10 +764,14 @@ void FontRenderer::blurImage(uint8_t** image, int32_t width, int32_t height, flo
         }
     }
 
+    std::unique_ptr<uint8_t[]> scratch(new uint8_t[width * height]);
+    if (intRadius > Blur::kBoxApproximationRadius) {
+        Blur::approximateGaussian(radius, *image, scratch.get(), width, height);
+        return;
+    }
+
     std::unique_ptr<float[]> gaussian(new float[2 * intRadius + 1]);
     Blur::generateGaussianWeights(gaussian.get(), radius);
-
-    std::unique_ptr<uint8_t[]> scratch(new uint8_t[width * height]);
     Blur::horizontal(gaussian.get(), intRadius, *image, scratch.get(), width, height);
     Blur::vertical(gaussian.get(), intRadius, scratch.get(), *image, width, height);
 }
@@ -774,7 +821,8 @@ static void dumpTextures(String8& log, const char* tag,
         if (cacheTexture && cacheTexture->getPixelBuffer()) {
             uint32_t free = cacheTexture->calculateFreeMemory();
             uint32_t total = cacheTexture->getPixelBuffer()->getSize();
-            log.appendFormat("    %-4s texture %d     %8d / %8d\n", tag, i, total - free, total);
+            log.appendFormat("    %-4s texture %d     %8d / %8d, %d glyphs\n", tag, i,
+                    total - free, total, cacheTexture->getGlyphCount());
         }
     }
 }
@@ -139,6 +139,8 @@ private:
             uint32_t *retOriginX, uint32_t *retOriginY, bool precaching);
     CacheTexture* cacheBitmapInTexture(std::vector<CacheTexture*>& cacheTextures, const SkGlyph& glyph,
             uint32_t* startX, uint32_t* startY);
+    CacheTexture* evictAndCacheBitmap(std::vector<CacheTexture*>& cacheTextures,
+            const SkGlyph& glyph, uint32_t* startX, uint32_t* startY);
 
     void flushAllAndInvalidate();
 
@@ -193,6 +195,10 @@ private:
 
     bool mInitialized;
 
+    // Index of the cache texture to clear next when a glyph doesn't fit, per format
+    uint32_t mNextEvictedACacheTexture;
+    uint32_t mNextEvictedRGBACacheTexture;
+
     bool mLinearFiltering;
 
 #ifdef BUGREPORT_FONT_CACHE_USAGE
@@ -449,15 +449,15 @@ void FrameBuilder::deferShadow(const ClipBase* reorderClip, const RenderNodeOp&
         node.applyViewPropertyTransforms(shadowMatrixXY, false);
         node.applyViewPropertyTransforms(shadowMatrixZ, true);
 
+        Vector2 translation;
         sp<TessellationCache::ShadowTask> task = mCaches.tessellationCache.getShadowTask(
                 mCanvasState.currentTransform(),
-                mCanvasState.getLocalClipBounds(),
                 casterAlpha >= 1.0f,
                 casterPath,
                 &shadowMatrixXY, &shadowMatrixZ,
                 mCanvasState.currentSnapshot()->getRelativeLightCenter(),
-                mLightRadius);
-        ShadowOp* shadowOp = mAllocator.create<ShadowOp>(task, casterAlpha);
+                mLightRadius, &translation);
+        ShadowOp* shadowOp = mAllocator.create<ShadowOp>(task, casterAlpha, translation);
         BakedOpState* bakedOpState = BakedOpState::tryShadowOpConstruct(
                 mAllocator, *mCanvasState.writableSnapshot(), shadowOp);
         if (CC_LIKELY(bakedOpState)) {
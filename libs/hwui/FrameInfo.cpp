@@ -48,6 +48,7 @@ static_assert(static_cast<int>(FrameInfoIndex::NumIndexes) == 16,
 
 void FrameInfo::importUiThreadInfo(int64_t* info) {
     memcpy(mFrameInfo, info, UI_THREAD_FRAME_INFO_SIZE * sizeof(int64_t));
+    mGpuCompleted = 0;
 }
 
 } /* namespace uirenderer */
@@ -122,6 +122,16 @@ public:
         set(FrameInfoIndex::Flags) |= static_cast<uint64_t>(frameInfoFlag);
     }
 
+    // GPU completion is only known after the frame was reported, so it is kept out of
+    // the data shared with FrameMetrics.java. 0 until the GPU has finished the frame.
+    void markGpuCompleted(nsecs_t gpuCompleted) {
+        mGpuCompleted = gpuCompleted;
+    }
+
+    nsecs_t gpuCompleted() const {
+        return mGpuCompleted;
+    }
+
     const int64_t* data() const {
         return mFrameInfo;
     }
@@ -168,6 +178,7 @@ public:
 
 private:
     int64_t mFrameInfo[static_cast<int>(FrameInfoIndex::NumIndexes)];
+    nsecs_t mGpuCompleted = 0;
 };
 
 } /* namespace uirenderer */
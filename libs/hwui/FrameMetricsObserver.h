@@ -16,14 +16,35 @@
 
 #pragma once
 
+#include "FrameInfo.h"
+#include "utils/SpmcRingBuffer.h"
+
 #include <utils/RefBase.h>
+#include <utils/Timers.h>
+
+#include <array>
 
 namespace android {
 namespace uirenderer {
 
+typedef std::array<int64_t, static_cast<size_t>(FrameInfoIndex::NumIndexes)> FrameMetricsData;
+
+// Frames are only copied once into this ring, which all the observers of a
+// FrameMetricsReporter share. Sized to absorb a few frames of latency of their threads.
+class FrameMetricsRing : public LightRefBase<FrameMetricsRing>,
+        public SpmcRingBuffer<FrameMetricsData, 16> {
+};
+
 class FrameMetricsObserver : public VirtualLightRefBase {
 public:
-    virtual void notify(const int64_t* buffer);
+    // Called on the RenderThread after a frame was pushed into ring at the given position.
+    // This must be cheap, frames are meant to be read from the observer's own thread, in
+    // batches, with a FrameMetricsRing::Reader.
+    virtual void notify(const sp<FrameMetricsRing>& ring, uint64_t position) = 0;
+
+    // Called once the GPU has finished rendering a frame previously passed to notify(),
+    // with its data. Not all pipelines can report GPU completion.
+    virtual void notifyGpuCompleted(const int64_t* buffer, nsecs_t gpuCompleted) {}
 };
 
 }; // namespace uirenderer
@@ -30,7 +30,7 @@ namespace uirenderer {
 
 class FrameMetricsReporter {
 public:
-    FrameMetricsReporter() {}
+    FrameMetricsReporter() : mRing(new FrameMetricsRing()) {}
 
     void addObserver(FrameMetricsObserver* observer) {
         mObservers.push_back(observer);
@@ -51,12 +51,23 @@ public:
     }
 
     void reportFrameMetrics(const int64_t* stats) {
+        FrameMetricsData data;
+        memcpy(data.data(), stats, sizeof(data));
+        uint64_t position = mRing->head();
+        mRing->push(data);
         for (size_t i = 0; i < mObservers.size(); i++) {
-            mObservers[i]->notify(stats);
+            mObservers[i]->notify(mRing, position);
+        }
+    }
+
+    void reportGpuCompleted(const int64_t* stats, nsecs_t gpuCompleted) {
+        for (size_t i = 0; i < mObservers.size(); i++) {
+            mObservers[i]->notifyGpuCompleted(stats, gpuCompleted);
         }
     }
 
 private:
+    sp<FrameMetricsRing> mRing;
     std::vector< sp<FrameMetricsObserver> > mObservers;
 };
 
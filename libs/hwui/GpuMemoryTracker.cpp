@@ -20,7 +20,9 @@
 #include <cutils/compiler.h>
 #include <GpuMemoryTracker.h>
 #include <utils/Trace.h>
+#include <algorithm>
 #include <array>
+#include <climits>
 #include <sstream>
 #include <unordered_set>
 #include <vector>
@@ -41,22 +43,43 @@ const char* TYPE_NAMES[] = {
 struct TypeStats {
     int totalSize = 0;
     int count = 0;
+    int peakSize = 0;
+    int peakCount = 0;
 };
 
+// Upper bounds of the age ranges live objects are grouped in by dump()
+static const struct {
+    nsecs_t maxAge;
+    const char* name;
+} AGE_BUCKETS[] = {
+        { seconds_to_nanoseconds(1), "<1s" },
+        { seconds_to_nanoseconds(10), "<10s" },
+        { seconds_to_nanoseconds(60), "<1m" },
+        { seconds_to_nanoseconds(600), "<10m" },
+        { LLONG_MAX, ">=10m" },
+};
+
+#define NUM_AGE_BUCKETS (sizeof(AGE_BUCKETS) / sizeof(AGE_BUCKETS[0]))
+
 static std::array<TypeStats, NUM_TYPES> gObjectStats;
 static std::unordered_set<GpuMemoryTracker*> gObjectSet;
 
 void GpuMemoryTracker::notifySizeChanged(int newSize) {
     int delta = newSize - mSize;
     mSize = newSize;
-    gObjectStats[static_cast<int>(mType)].totalSize += delta;
+    TypeStats& stats = gObjectStats[static_cast<int>(mType)];
+    stats.totalSize += delta;
+    stats.peakSize = std::max(stats.peakSize, stats.totalSize);
 }
 
 void GpuMemoryTracker::startTrackingObject() {
     auto result = gObjectSet.insert(this);
     LOG_ALWAYS_FATAL_IF(!result.second,
             "startTrackingObject() on %p failed, already being tracked!", this);
-    gObjectStats[static_cast<int>(mType)].count++;
+    mCreationTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    TypeStats& stats = gObjectStats[static_cast<int>(mType)];
+    stats.count++;
+    stats.peakCount = std::max(stats.peakCount, stats.count);
 }
 
 void GpuMemoryTracker::stopTrackingObject() {
@@ -71,6 +94,11 @@ void GpuMemoryTracker::onGpuContextCreated() {
     LOG_ALWAYS_FATAL_IF(gGpuThread != 0, "We already have a gpu thread? "
             "current = %lu, gpu thread = %lu", pthread_self(), gGpuThread);
     gGpuThread = pthread_self();
+    // There are no live objects without a context, so the peaks start over from zero
+    for (TypeStats& stats : gObjectStats) {
+        stats.peakSize = 0;
+        stats.peakCount = 0;
+    }
 }
 
 void GpuMemoryTracker::onGpuContextDestroyed() {
@@ -90,12 +118,32 @@ void GpuMemoryTracker::dump() {
 }
 
 void GpuMemoryTracker::dump(std::ostream& stream) {
+    int ageCounts[NUM_TYPES][NUM_AGE_BUCKETS] = {};
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (const auto& obj : gObjectSet) {
+        const nsecs_t age = now - obj->mCreationTime;
+        size_t bucket = 0;
+        while (age >= AGE_BUCKETS[bucket].maxAge && bucket + 1 < NUM_AGE_BUCKETS) {
+            bucket++;
+        }
+        ageCounts[static_cast<int>(obj->mType)][bucket]++;
+    }
+
     for (int type = 0; type < NUM_TYPES; type++) {
         const TypeStats& stats = gObjectStats[type];
         stream << TYPE_NAMES[type];
         stream << " is using " << SizePrinter{stats.totalSize};
         stream << ", count = " << stats.count;
+        stream << ", peak " << SizePrinter{stats.peakSize};
+        stream << ", peak count = " << stats.peakCount;
         stream << std::endl;
+        if (stats.count > 0) {
+            stream << "  age:";
+            for (size_t bucket = 0; bucket < NUM_AGE_BUCKETS; bucket++) {
+                stream << " " << AGE_BUCKETS[bucket].name << "=" << ageCounts[type][bucket];
+            }
+            stream << std::endl;
+        }
     }
 }
 
@@ -107,6 +155,14 @@ int GpuMemoryTracker::getTotalSize(GpuObjectType type) {
     return gObjectStats[static_cast<int>(type)].totalSize;
 }
 
+int GpuMemoryTracker::getPeakInstanceCount(GpuObjectType type) {
+    return gObjectStats[static_cast<int>(type)].peakCount;
+}
+
+int GpuMemoryTracker::getPeakTotalSize(GpuObjectType type) {
+    return gObjectStats[static_cast<int>(type)].peakSize;
+}
+
 void GpuMemoryTracker::onFrameCompleted() {
     if (ATRACE_ENABLED()) {
         char buf[128];
@@ -19,6 +19,7 @@
 #include <ostream>
 
 #include <log/log.h>
+#include <utils/Timers.h>
 
 namespace android {
 namespace uirenderer {
@@ -50,6 +51,9 @@ public:
     static void dump(std::ostream& stream);
     static int getInstanceCount(GpuObjectType type);
     static int getTotalSize(GpuObjectType type);
+    // High-water marks since the GPU context was created
+    static int getPeakInstanceCount(GpuObjectType type);
+    static int getPeakTotalSize(GpuObjectType type);
     static void onFrameCompleted();
 
 protected:
@@ -71,6 +75,7 @@ private:
 
     int mSize = 0;
     GpuObjectType mType;
+    nsecs_t mCreationTime = 0;
 };
 
 } // namespace uirenderer
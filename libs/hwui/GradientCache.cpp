@@ -66,6 +66,7 @@ GradientCache::GradientCache(Extensions& extensions)
         : mCache(LruCache<GradientCacheEntry, Texture*>::kUnlimitedCapacity)
         , mSize(0)
         , mMaxSize(Properties::gradientCacheSize)
+        , mRecycledTexture(nullptr)
         , mUseFloatTexture(extensions.hasFloatTextures())
         , mHasNpot(extensions.hasNPot())
         , mHasLinearBlending(extensions.hasLinearBlending()) {
@@ -97,8 +98,10 @@ uint32_t GradientCache::getMaxSize() {
 void GradientCache::operator()(GradientCacheEntry&, Texture*& texture) {
     if (texture) {
         mSize -= texture->objectSize();
-        texture->deleteTexture();
-        delete texture;
+        if (texture != mRecycledTexture) {
+            texture->deleteTexture();
+            delete texture;
+        }
     }
 }
 
@@ -150,19 +153,30 @@ Texture* GradientCache::addLinearGradient(GradientCacheEntry& gradient,
     GradientInfo info;
     getGradientInfo(colors, count, info);
 
-    Texture* texture = new Texture(Caches::getInstance());
-    texture->blend = info.hasAlpha;
-    texture->generation = 1;
-
     // Assume the cache is always big enough
     const uint32_t size = info.width * 2 * bytesPerPixel();
     while (getSize() + size > mMaxSize) {
+        // Animated gradients create a new entry on every frame, always with the
+        // same number of stops. Keep the oldest texture when it has the right size
+        // so that its storage is updated in place instead of reallocated.
+        if (!mRecycledTexture && mCache.size() > 0
+                && (int) size == mCache.peekOldestValue()->objectSize()) {
+            mRecycledTexture = mCache.peekOldestValue();
+        }
         LOG_ALWAYS_FATAL_IF(!mCache.removeOldest(),
                 "Ran out of things to remove from the cache? getSize() = %" PRIu32
                 ", size = %" PRIu32 ", mMaxSize = %" PRIu32 ", width = %" PRIu32,
                 getSize(), size, mMaxSize, info.width);
     }
 
+    Texture* texture = mRecycledTexture;
+    mRecycledTexture = nullptr;
+    if (!texture) {
+        texture = new Texture(Caches::getInstance());
+        texture->generation = 1;
+    }
+    texture->blend = info.hasAlpha;
+
     generateTexture(colors, positions, info.width, 2, texture);
 
     mSize += size;
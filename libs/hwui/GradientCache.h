@@ -167,6 +167,9 @@ private:
     uint32_t mSize;
     const uint32_t mMaxSize;
 
+    // Evicted texture whose storage is reused by the gradient being added
+    Texture* mRecycledTexture;
+
     GLint mMaxTextureSize;
     bool mUseFloatTexture;
     bool mHasNpot;
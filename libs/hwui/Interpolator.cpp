@@ -89,12 +89,14 @@ float OvershootInterpolator::interpolate(float t) {
     return t * t * ((mTension + 1) * t + mTension) + 1.0f;
 }
 
-float PathInterpolator::interpolate(float t) {
-    if (t <= 0) {
-        return 0;
-    } else if (t >= 1) {
-        return 1;
+size_t PathInterpolator::findStartIndex(float t) {
+    // Check the segment of the previous call, and the one after it, before searching.
+    for (size_t index = mLastIndex; index < mLastIndex + 2 && index + 1 < mX.size(); index++) {
+        if (mX[index] <= t && t < mX[index + 1]) {
+            return index;
+        }
     }
+
     // Do a binary search for the correct x to interpolate between.
     size_t startIndex = 0;
     size_t endIndex = mX.size() - 1;
@@ -107,6 +109,18 @@ float PathInterpolator::interpolate(float t) {
             startIndex = midIndex;
         }
     }
+    return startIndex;
+}
+
+float PathInterpolator::interpolate(float t) {
+    if (t <= 0) {
+        return 0;
+    } else if (t >= 1) {
+        return 1;
+    }
+    size_t startIndex = findStartIndex(t);
+    size_t endIndex = std::min(startIndex + 1, mX.size() - 1);
+    mLastIndex = startIndex;
 
     float xRange = mX[endIndex] - mX[startIndex];
     if (xRange == 0) {
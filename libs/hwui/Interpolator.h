@@ -104,11 +104,17 @@ private:
 class ANDROID_API PathInterpolator : public Interpolator {
 public:
     explicit PathInterpolator(std::vector<float>&& x, std::vector<float>&& y)
-            : mX (x), mY(y) {}
+            : mX (x), mY(y), mLastIndex(0) {}
     virtual float interpolate(float input) override;
 private:
+    size_t findStartIndex(float t);
+
     std::vector<float> mX;
     std::vector<float> mY;
+
+    // Start of the segment of the previous interpolate() call. Animators move forward through
+    // the path frame after frame, so the next input usually falls in the same or next segment.
+    size_t mLastIndex;
 };
 
 class ANDROID_API LUTInterpolator : public Interpolator {
@@ -42,6 +42,14 @@ static const char* JANK_TYPE_NAMES[] = {
         "Slow issue draw commands",
 };
 
+static const char* FRAME_STAGE_NAMES[] = {
+        "Sync",
+        "Issue draw commands",
+        "Swap buffers",
+        "Dequeue buffer",
+        "Queue buffer",
+};
+
 struct Comparison {
     FrameInfoIndex start;
     FrameInfoIndex end;
@@ -86,6 +94,20 @@ static const uint32_t kSlowFrameBucketIntervalMs = 50;
 // The start point of the slow frame bucket in ms
 static const uint32_t kSlowFrameBucketStartMs = 150;
 
+// Stage durations are bucketed in 250us increments up to 8ms, then in 1ms
+// increments. The last bucket holds everything longer.
+static const uint32_t kStageBucketFineIntervalUs = 250;
+static const uint32_t kStageBucketCoarseStartUs = 8000;
+static const uint32_t kStageBucketCoarseIntervalUs = 1000;
+static const uint32_t kStageBucketCoarseStart =
+        kStageBucketCoarseStartUs / kStageBucketFineIntervalUs;
+
+static const Comparison STAGE_COMPARISONS[] = {
+        {FrameInfoIndex::SyncStart, FrameInfoIndex::IssueDrawCommandsStart},
+        {FrameInfoIndex::IssueDrawCommandsStart, FrameInfoIndex::SwapBuffers},
+        {FrameInfoIndex::SwapBuffers, FrameInfoIndex::FrameCompleted},
+};
+
 // This will be called every frame, performance sensitive
 // Uses bit twiddling to avoid branching while achieving the packing desired
 static uint32_t frameCountIndexForFrameTime(nsecs_t frameTime) {
@@ -127,6 +149,26 @@ int32_t JankTracker::frameTimeForSlowFrameCountIndex(uint32_t index) {
     return (index * kSlowFrameBucketIntervalMs) + kSlowFrameBucketStartMs;
 }
 
+static uint32_t stageCountIndexForStageTime(nsecs_t stageTime, uint32_t bucketCount) {
+    uint32_t us = static_cast<uint32_t>(std::min(ns2us(stageTime),
+            static_cast<nsecs_t>(std::numeric_limits<uint32_t>::max())));
+    if (us < kStageBucketCoarseStartUs) {
+        return us / kStageBucketFineIntervalUs;
+    }
+    uint32_t index = kStageBucketCoarseStart
+            + (us - kStageBucketCoarseStartUs) / kStageBucketCoarseIntervalUs;
+    return std::min(index, bucketCount - 1);
+}
+
+// Returns the upper bound of the bucket
+uint32_t JankTracker::stageTimeForStageCountIndex(uint32_t index) {
+    if (index < kStageBucketCoarseStart) {
+        return (index + 1) * kStageBucketFineIntervalUs;
+    }
+    return kStageBucketCoarseStartUs
+            + (index - kStageBucketCoarseStart + 1) * kStageBucketCoarseIntervalUs;
+}
+
 JankTracker::JankTracker(const DisplayInfo& displayInfo) {
     // By default this will use malloc memory. It may be moved later to ashmem
     // if there is shared space for it and a request comes in to do that.
@@ -252,6 +294,19 @@ void JankTracker::setFrameInterval(nsecs_t frameInterval) {
 
 void JankTracker::addFrame(const FrameInfo& frame) {
     mData->totalFrameCount++;
+    if (CC_LIKELY(!(frame[FrameInfoIndex::Flags] & EXEMPT_FRAMES_FLAGS))) {
+        const uint32_t bucketCount = mStageCounts[0].size();
+        for (int i = 0; i < kStageDequeueBuffer; i++) {
+            nsecs_t delta = frame.duration(STAGE_COMPARISONS[i].start, STAGE_COMPARISONS[i].end);
+            mStageCounts[i][stageCountIndexForStageTime(delta, bucketCount)]++;
+        }
+        mStageCounts[kStageDequeueBuffer][stageCountIndexForStageTime(
+                frame[FrameInfoIndex::DequeueBufferDuration], bucketCount)]++;
+        mStageCounts[kStageQueueBuffer][stageCountIndexForStageTime(
+                frame[FrameInfoIndex::QueueBufferDuration], bucketCount)]++;
+        mStageFrameCount++;
+    }
+
     // Fast-path for jank-free frames
     int64_t totalDuration = frame.duration(sFrameStart, FrameInfoIndex::FrameCompleted);
     if (mDequeueTimeForgiveness
@@ -344,6 +399,19 @@ void JankTracker::dumpData(int fd, const ProfileDataDescription* description, co
     dprintf(fd, "\n");
 }
 
+void JankTracker::dump(int fd) {
+    dumpData(fd, &mDescription, mData);
+    if (!mStageFrameCount) return;
+    dprintf(fd, "Frame stage percentiles (50th/90th/95th/99th):");
+    for (int i = 0; i < NUM_FRAME_STAGES; i++) {
+        FrameStage stage = static_cast<FrameStage>(i);
+        dprintf(fd, "\n  %s: %.2fms/%.2fms/%.2fms/%.2fms", FRAME_STAGE_NAMES[i],
+                findStagePercentile(stage, 50) / 1000.0f, findStagePercentile(stage, 90) / 1000.0f,
+                findStagePercentile(stage, 95) / 1000.0f, findStagePercentile(stage, 99) / 1000.0f);
+    }
+    dprintf(fd, "\n");
+}
+
 void JankTracker::reset() {
     mData->jankTypeCounts.fill(0);
     mData->frameCounts.fill(0);
@@ -351,6 +419,10 @@ void JankTracker::reset() {
     mData->totalFrameCount = 0;
     mData->jankFrameCount = 0;
     mData->statStartTime = systemTime(CLOCK_MONOTONIC);
+    for (auto& stageCounts : mStageCounts) {
+        stageCounts.fill(0);
+    }
+    mStageFrameCount = 0;
     sFrameStart = Properties::filterOutTestOverhead
             ? FrameInfoIndex::HandleInputStart
             : FrameInfoIndex::IntendedVsync;
@@ -374,5 +446,19 @@ uint32_t JankTracker::findPercentile(const ProfileData* data, int percentile) {
     return 0;
 }
 
+uint32_t JankTracker::findStagePercentile(FrameStage stage, int percentile) const {
+    if (!mStageFrameCount) return 0;
+    const auto& stageCounts = mStageCounts[stage];
+    int pos = percentile * mStageFrameCount / 100;
+    int remaining = mStageFrameCount - pos;
+    for (int i = stageCounts.size() - 1; i >= 0; i--) {
+        remaining -= stageCounts[i];
+        if (remaining <= 0) {
+            return stageTimeForStageCountIndex(i);
+        }
+    }
+    return 0;
+}
+
 } /* namespace uirenderer */
 } /* namespace android */
@@ -40,6 +40,18 @@ enum JankType {
     NUM_BUCKETS,
 };
 
+// The RenderThread stages of a frame that get their own latency histogram
+enum FrameStage {
+    kStageSync = 0,
+    kStageIssueDrawCommands,
+    kStageSwapBuffers,
+    kStageDequeueBuffer,
+    kStageQueueBuffer,
+
+    // must be last
+    NUM_FRAME_STAGES,
+};
+
 // Try to keep as small as possible, should match ASHMEM_SIZE in
 // GraphicsStatsService.java
 struct ProfileData {
@@ -82,7 +94,7 @@ public:
 
     void addFrame(const FrameInfo& frame);
 
-    void dump(int fd) { dumpData(fd, &mDescription, mData); }
+    void dump(int fd);
     void reset();
 
     void rotateStorage();
@@ -92,6 +104,10 @@ public:
     static int32_t frameTimeForFrameCountIndex(uint32_t index);
     static int32_t frameTimeForSlowFrameCountIndex(uint32_t index);
 
+    // Returns the p-th percentile duration of the given stage, in microseconds
+    uint32_t findStagePercentile(FrameStage stage, int p) const;
+    static uint32_t stageTimeForStageCountIndex(uint32_t index);
+
 private:
     void freeData();
     void setFrameInterval(nsecs_t frameIntervalNanos);
@@ -112,6 +128,11 @@ private:
     ProfileData* mData;
     bool mIsMapped = false;
     ProfileDataDescription mDescription;
+
+    // Per-stage histograms, see kStageBucket* constants for the bucketing. These are kept out
+    // of ProfileData, as its layout is shared with GraphicsStatsService through ashmem.
+    std::array<std::array<uint32_t, 64>, NUM_FRAME_STAGES> mStageCounts;
+    uint32_t mStageFrameCount = 0;
 };
 
 } /* namespace uirenderer */
@@ -25,18 +25,44 @@ void LayerUpdateQueue::clear() {
     mEntries.clear();
 }
 
-void LayerUpdateQueue::enqueueLayerWithDamage(RenderNode* renderNode, Rect damage) {
+static void addDamage(std::vector<LayerUpdateQueue::Entry>& entries,
+        RenderNode* renderNode, Rect damage) {
     damage.roundOut();
     damage.doIntersect(0, 0, renderNode->getWidth(), renderNode->getHeight());
     if (!damage.isEmpty()) {
-        for (Entry& entry : mEntries) {
+        for (LayerUpdateQueue::Entry& entry : entries) {
             if (CC_UNLIKELY(entry.renderNode == renderNode)) {
                 entry.damage.unionWith(damage);
                 return;
             }
         }
-        mEntries.emplace_back(renderNode, damage);
+        entries.emplace_back(renderNode, damage);
+    }
+}
+
+void LayerUpdateQueue::enqueueLayerWithDamage(RenderNode* renderNode, Rect damage) {
+    for (auto it = mDeferredEntries.begin(); it != mDeferredEntries.end(); it++) {
+        if (CC_UNLIKELY(it->renderNode == renderNode)) {
+            damage.unionWith(it->damage);
+            mDeferredEntries.erase(it);
+            break;
+        }
+    }
+    addDamage(mEntries, renderNode, damage);
+}
+
+void LayerUpdateQueue::deferLayerWithDamage(RenderNode* renderNode, Rect damage) {
+    addDamage(mDeferredEntries, renderNode, damage);
+}
+
+void LayerUpdateQueue::enqueueDeferredLayers() {
+    for (Entry& entry : mDeferredEntries) {
+        // The layer is redrawn entirely if it is ever created again
+        if (entry.renderNode->hasLayer()) {
+            addDamage(mEntries, entry.renderNode.get(), entry.damage);
+        }
     }
+    mDeferredEntries.clear();
 }
 
 } // namespace uirenderer
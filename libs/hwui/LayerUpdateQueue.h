@@ -44,8 +44,21 @@ public:
     void enqueueLayerWithDamage(RenderNode* renderNode, Rect dirty);
     void clear();
     const std::vector<Entry>& entries() const { return mEntries; }
+
+    /**
+     * Holds on to the damage of a layer that isn't visible this frame. It is added to the next
+     * update enqueued for the same layer, or enqueued by enqueueDeferredLayers(). Deferred
+     * damage is kept across clear().
+     */
+    void deferLayerWithDamage(RenderNode* renderNode, Rect dirty);
+    // Enqueues the deferred damage of the layers that haven't been destroyed since
+    void enqueueDeferredLayers();
+    void clearDeferredLayers() { mDeferredEntries.clear(); }
+    bool hasDeferredLayers() const { return !mDeferredEntries.empty(); }
+    const std::vector<Entry>& deferredEntries() const { return mDeferredEntries; }
 private:
     std::vector<Entry> mEntries;
+    std::vector<Entry> mDeferredEntries;
 };
 
 }; // namespace uirenderer
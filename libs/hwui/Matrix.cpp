@@ -24,6 +24,14 @@
 
 #include "Matrix.h"
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MATRIX_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MATRIX_USE_SSE2
+#endif
+
 namespace android {
 namespace uirenderer {
 
@@ -224,6 +232,31 @@ void Matrix4::loadInverse(const Matrix4& v) {
         return;
     }
 
+    // Fast case for scale and translate matrices, the most common ones after translations
+    if (v.isSimple()) {
+        const double scaleX = 1.0 / v.data[kScaleX];
+        const double scaleY = 1.0 / v.data[kScaleY];
+
+        data[kScaleX]       = scaleX;
+        data[kSkewX]        = 0.0f;
+
+        data[kScaleY]       = scaleY;
+        data[kSkewY]        = 0.0f;
+
+        data[kScaleZ]       = 1.0f;
+
+        data[kPerspective0] = 0.0f;
+        data[kPerspective1] = 0.0f;
+        data[kPerspective2] = 1.0f;
+
+        data[kTranslateX]   = -v.data[kTranslateX] * scaleX;
+        data[kTranslateY]   = -v.data[kTranslateY] * scaleY;
+        data[kTranslateZ]   = 0.0f;
+
+        mType = kTypeUnknown;
+        return;
+    }
+
     double scale = 1.0 /
             (v.data[kScaleX] * ((double) v.data[kScaleY]  * v.data[kPerspective2] -
                     (double) v.data[kTranslateY] * v.data[kPerspective1]) +
@@ -370,6 +403,33 @@ void Matrix4::loadRotate(float angle, float x, float y, float z) {
 }
 
 void Matrix4::loadMultiply(const Matrix4& u, const Matrix4& v) {
+    // Each column i of the result is the sum of the columns j of u, weighted by v(i, j), which
+    // lets the vector paths compute a whole column at once.
+#if defined(MATRIX_USE_NEON)
+    const float32x4_t u0 = vld1q_f32(&u.data[0]);
+    const float32x4_t u1 = vld1q_f32(&u.data[4]);
+    const float32x4_t u2 = vld1q_f32(&u.data[8]);
+    const float32x4_t u3 = vld1q_f32(&u.data[12]);
+    for (int i = 0 ; i < 4 ; i++) {
+        float32x4_t column = vmulq_n_f32(u0, v.get(i, 0));
+        column = vaddq_f32(column, vmulq_n_f32(u1, v.get(i, 1)));
+        column = vaddq_f32(column, vmulq_n_f32(u2, v.get(i, 2)));
+        column = vaddq_f32(column, vmulq_n_f32(u3, v.get(i, 3)));
+        vst1q_f32(&data[i * 4], column);
+    }
+#elif defined(MATRIX_USE_SSE2)
+    const __m128 u0 = _mm_loadu_ps(&u.data[0]);
+    const __m128 u1 = _mm_loadu_ps(&u.data[4]);
+    const __m128 u2 = _mm_loadu_ps(&u.data[8]);
+    const __m128 u3 = _mm_loadu_ps(&u.data[12]);
+    for (int i = 0 ; i < 4 ; i++) {
+        __m128 column = _mm_mul_ps(u0, _mm_set1_ps(v.get(i, 0)));
+        column = _mm_add_ps(column, _mm_mul_ps(u1, _mm_set1_ps(v.get(i, 1))));
+        column = _mm_add_ps(column, _mm_mul_ps(u2, _mm_set1_ps(v.get(i, 2))));
+        column = _mm_add_ps(column, _mm_mul_ps(u3, _mm_set1_ps(v.get(i, 3))));
+        _mm_storeu_ps(&data[i * 4], column);
+    }
+#else
     for (int i = 0 ; i < 4 ; i++) {
         float x = 0;
         float y = 0;
@@ -389,6 +449,7 @@ void Matrix4::loadMultiply(const Matrix4& u, const Matrix4& v) {
         set(i, 2, z);
         set(i, 3, w);
     }
+#endif
 
     mType = kTypeUnknown;
 }
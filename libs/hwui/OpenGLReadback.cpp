@@ -20,6 +20,7 @@
 #include "Image.h"
 #include "GlopBuilder.h"
 #include "GlLayer.h"
+#include "hwui/Bitmap.h"
 #include "renderstate/RenderState.h"
 #include "renderthread/EglManager.h"
 #include "utils/GLUtils.h"
@@ -31,13 +32,11 @@
 namespace android {
 namespace uirenderer {
 
-CopyResult OpenGLReadback::copySurfaceInto(Surface& surface, const Rect& srcRect,
-        SkBitmap* bitmap) {
-    ATRACE_CALL();
-    // Setup the source
-    sp<GraphicBuffer> sourceBuffer;
+CopyResult OpenGLReadback::getLastQueuedBuffer(Surface& surface, sp<GraphicBuffer>* outBuffer,
+        Matrix4* outTexTransform) {
+    sp<GraphicBuffer>& sourceBuffer = *outBuffer;
     sp<Fence> sourceFence;
-    Matrix4 texTransform;
+    Matrix4& texTransform = *outTexTransform;
     status_t err = surface.getLastQueuedBuffer(&sourceBuffer, &sourceFence,
             texTransform.data);
     texTransform.invalidateType();
@@ -58,37 +57,118 @@ CopyResult OpenGLReadback::copySurfaceInto(Surface& surface, const Rect& srcRect
         ALOGE("Timeout (500ms) exceeded waiting for buffer fence, abandoning readback attempt");
         return CopyResult::Timeout;
     }
+    return CopyResult::Success;
+}
+
+CopyResult OpenGLReadback::copySurfaceInto(Surface& surface, const Rect& srcRect,
+        SkBitmap* bitmap) {
+    ATRACE_CALL();
+    // Setup the source
+    sp<GraphicBuffer> sourceBuffer;
+    Matrix4 texTransform;
+    CopyResult copyResult = getLastQueuedBuffer(surface, &sourceBuffer, &texTransform);
+    if (copyResult != CopyResult::Success) {
+        return copyResult;
+    }
 
     return copyGraphicBufferInto(sourceBuffer.get(), texTransform, srcRect, bitmap);
 }
 
-CopyResult OpenGLReadback::copyGraphicBufferInto(GraphicBuffer* graphicBuffer,
-        Matrix4& texTransform, const Rect& srcRect, SkBitmap* bitmap) {
-    mRenderThread.eglManager().initialize();
-    // TODO: Can't use Image helper since it forces GL_TEXTURE_2D usage via
-    // GL_OES_EGL_image, which doesn't work since we need samplerExternalOES
-    // to be able to properly sample from the buffer.
-
+// TODO: Can't use Image helper since it forces GL_TEXTURE_2D usage via
+// GL_OES_EGL_image, which doesn't work since we need samplerExternalOES
+// to be able to properly sample from the buffer.
+static EGLImageKHR createEglImage(EGLDisplay display, GraphicBuffer* graphicBuffer) {
     // Create the EGLImage object that maps the GraphicBuffer
-    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     EGLClientBuffer clientBuffer = (EGLClientBuffer) graphicBuffer->getNativeBuffer();
     EGLint attrs[] = { EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE };
 
-    EGLImageKHR sourceImage = eglCreateImageKHR(display, EGL_NO_CONTEXT,
+    EGLImageKHR image = eglCreateImageKHR(display, EGL_NO_CONTEXT,
             EGL_NATIVE_BUFFER_ANDROID, clientBuffer, attrs);
-
-    if (sourceImage == EGL_NO_IMAGE_KHR) {
+    if (image == EGL_NO_IMAGE_KHR) {
         ALOGW("eglCreateImageKHR failed (%#x)", eglGetError());
-        return CopyResult::UnknownError;
     }
+    return image;
+}
 
-    uint32_t width = graphicBuffer->getWidth();
-    uint32_t height = graphicBuffer->getHeight();
+// Size of the buffer once texTransform is applied
+static void getTransformedSize(GraphicBuffer* graphicBuffer, const Matrix4& texTransform,
+        uint32_t* outWidth, uint32_t* outHeight) {
+    *outWidth = graphicBuffer->getWidth();
+    *outHeight = graphicBuffer->getHeight();
     // If this is a 90 or 270 degree rotation we need to swap width/height
     // This is a fuzzy way of checking that.
     if (texTransform[Matrix4::kSkewX] >= 0.5f || texTransform[Matrix4::kSkewX] <= -0.5f) {
-        std::swap(width, height);
+        std::swap(*outWidth, *outHeight);
     }
+}
+
+CopyResult OpenGLReadback::copySurfaceIntoHardwareBitmap(Surface& surface, const Rect& srcRect,
+        int width, int height, sk_sp<Bitmap>* outBitmap) {
+    ATRACE_CALL();
+    if (width <= 0 || height <= 0) {
+        ALOGW("Can't copy surface into a %dx%d hardware bitmap", width, height);
+        return CopyResult::DestinationInvalid;
+    }
+
+    sp<GraphicBuffer> sourceBuffer;
+    Matrix4 texTransform;
+    CopyResult copyResult = getLastQueuedBuffer(surface, &sourceBuffer, &texTransform);
+    if (copyResult != CopyResult::Success) {
+        return copyResult;
+    }
+
+    sp<GraphicBuffer> destBuffer = new GraphicBuffer(width, height, PIXEL_FORMAT_RGBA_8888,
+            GraphicBuffer::USAGE_HW_TEXTURE |
+            GraphicBuffer::USAGE_HW_RENDER |
+            GraphicBuffer::USAGE_SW_WRITE_NEVER |
+            GraphicBuffer::USAGE_SW_READ_NEVER,
+            std::string("OpenGLReadback pid [") + std::to_string(getpid()) + "]");
+    status_t error = destBuffer->initCheck();
+    if (error < 0) {
+        ALOGW("Failed to allocate a %dx%d GraphicBuffer, error = %d", width, height, error);
+        return CopyResult::DestinationInvalid;
+    }
+
+    mRenderThread.eglManager().initialize();
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLImageKHR sourceImage = createEglImage(display, sourceBuffer.get());
+    if (sourceImage == EGL_NO_IMAGE_KHR) {
+        return CopyResult::UnknownError;
+    }
+    EGLImageKHR destImage = createEglImage(display, destBuffer.get());
+    if (destImage == EGL_NO_IMAGE_KHR) {
+        eglDestroyImageKHR(display, sourceImage);
+        return CopyResult::UnknownError;
+    }
+
+    uint32_t sourceWidth;
+    uint32_t sourceHeight;
+    getTransformedSize(sourceBuffer.get(), texTransform, &sourceWidth, &sourceHeight);
+    copyResult = copyImageIntoImage(sourceImage, texTransform, sourceWidth, sourceHeight,
+            srcRect, destImage, width, height);
+
+    // The pending GPU work keeps the buffers alive, there's no need to wait for it
+    eglDestroyImageKHR(display, destImage);
+    eglDestroyImageKHR(display, sourceImage);
+    if (copyResult == CopyResult::Success) {
+        *outBitmap = Bitmap::createFrom(destBuffer);
+    }
+    return copyResult;
+}
+
+CopyResult OpenGLReadback::copyGraphicBufferInto(GraphicBuffer* graphicBuffer,
+        Matrix4& texTransform, const Rect& srcRect, SkBitmap* bitmap) {
+    mRenderThread.eglManager().initialize();
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLImageKHR sourceImage = createEglImage(display, graphicBuffer);
+    if (sourceImage == EGL_NO_IMAGE_KHR) {
+        return CopyResult::UnknownError;
+    }
+
+    uint32_t width;
+    uint32_t height;
+    getTransformedSize(graphicBuffer, texTransform, &width, &height);
     CopyResult copyResult = copyImageInto(sourceImage, texTransform, width, height,
             srcRect, bitmap);
 
@@ -120,6 +200,47 @@ static const Matrix4 sFlipV(sFlipVInit);
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
+// Draws srcRect of the texture into the whole of the bound framebuffer
+static void drawTextureInto(Caches& caches, RenderState& renderState,
+        Texture& sourceTexture, const Matrix4& texTransform, const Rect& srcRect,
+        int destWidth, int destHeight) {
+    bool requiresFilter;
+    // Draw & readback
+    renderState.setViewport(destWidth, destHeight);
+    renderState.scissor().setEnabled(false);
+    renderState.blend().syncEnabled();
+    renderState.stencil().disable();
+
+    Matrix4 croppedTexTransform(texTransform);
+    if (!srcRect.isEmpty()) {
+        // We flipV to convert to 0,0 top-left for the srcRect
+        // coordinates then flip back to 0,0 bottom-left for
+        // GLES coordinates.
+        croppedTexTransform.multiply(sFlipV);
+        croppedTexTransform.translate(srcRect.left / sourceTexture.width(),
+                srcRect.top / sourceTexture.height(), 0);
+        croppedTexTransform.scale(srcRect.getWidth() / sourceTexture.width(),
+                srcRect.getHeight() / sourceTexture.height(), 1);
+        croppedTexTransform.multiply(sFlipV);
+        requiresFilter = srcRect.getWidth() != (float) destWidth
+                || srcRect.getHeight() != (float) destHeight;
+    } else {
+        requiresFilter = sourceTexture.width() != (uint32_t) destWidth
+                || sourceTexture.height() != (uint32_t) destHeight;
+    }
+    Glop glop;
+    GlopBuilder(renderState, caches, &glop)
+            .setRoundRectClipState(nullptr)
+            .setMeshTexturedUnitQuad(nullptr)
+            .setFillExternalTexture(sourceTexture, croppedTexTransform, requiresFilter)
+            .setTransform(Matrix4::identity(), TransformFlags::None)
+            .setModelViewMapUnitToRect(Rect(destWidth, destHeight))
+            .build();
+    Matrix4 ortho;
+    ortho.loadOrtho(destWidth, destHeight);
+    renderState.render(glop, ortho);
+}
+
 inline CopyResult copyTextureInto(Caches& caches, RenderState& renderState,
         Texture& sourceTexture, const Matrix4& texTransform, const Rect& srcRect,
         SkBitmap* bitmap) {
@@ -190,46 +311,10 @@ inline CopyResult copyTextureInto(Caches& caches, RenderState& renderState,
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
             GL_TEXTURE_2D, texture, 0);
 
-    {
-        bool requiresFilter;
-        // Draw & readback
-        renderState.setViewport(destWidth, destHeight);
-        renderState.scissor().setEnabled(false);
-        renderState.blend().syncEnabled();
-        renderState.stencil().disable();
-
-        Matrix4 croppedTexTransform(texTransform);
-        if (!srcRect.isEmpty()) {
-            // We flipV to convert to 0,0 top-left for the srcRect
-            // coordinates then flip back to 0,0 bottom-left for
-            // GLES coordinates.
-            croppedTexTransform.multiply(sFlipV);
-            croppedTexTransform.translate(srcRect.left / sourceTexture.width(),
-                    srcRect.top / sourceTexture.height(), 0);
-            croppedTexTransform.scale(srcRect.getWidth() / sourceTexture.width(),
-                    srcRect.getHeight() / sourceTexture.height(), 1);
-            croppedTexTransform.multiply(sFlipV);
-            requiresFilter = srcRect.getWidth() != (float) destWidth
-                    || srcRect.getHeight() != (float) destHeight;
-        } else {
-            requiresFilter = sourceTexture.width() != (uint32_t) destWidth
-                    || sourceTexture.height() != (uint32_t) destHeight;
-        }
-        Glop glop;
-        GlopBuilder(renderState, caches, &glop)
-                .setRoundRectClipState(nullptr)
-                .setMeshTexturedUnitQuad(nullptr)
-                .setFillExternalTexture(sourceTexture, croppedTexTransform, requiresFilter)
-                .setTransform(Matrix4::identity(), TransformFlags::None)
-                .setModelViewMapUnitToRect(Rect(destWidth, destHeight))
-                .build();
-        Matrix4 ortho;
-        ortho.loadOrtho(destWidth, destHeight);
-        renderState.render(glop, ortho);
-
-        glReadPixels(0, 0, bitmap->width(), bitmap->height(), format,
-                type, bitmap->getPixels());
-    }
+    drawTextureInto(caches, renderState, sourceTexture, texTransform, srcRect,
+            destWidth, destHeight);
+    glReadPixels(0, 0, bitmap->width(), bitmap->height(), format,
+            type, bitmap->getPixels());
 
     // Cleanup
     caches.textureState().deleteTexture(texture);
@@ -240,11 +325,55 @@ inline CopyResult copyTextureInto(Caches& caches, RenderState& renderState,
     return CopyResult::Success;
 }
 
-CopyResult OpenGLReadbackImpl::copyImageInto(EGLImageKHR eglImage,
-        const Matrix4& imgTransform, int imgWidth, int imgHeight, const Rect& srcRect,
-        SkBitmap* bitmap) {
+static CopyResult copyTextureIntoImage(Caches& caches, RenderState& renderState,
+        Texture& sourceTexture, const Matrix4& texTransform, const Rect& srcRect,
+        EGLImageKHR destImage, int destWidth, int destHeight) {
+    if (destWidth > caches.maxTextureSize || destHeight > caches.maxTextureSize) {
+        ALOGW("Can't copy surface into hardware bitmap, %dx%d exceeds max texture size %d",
+                destWidth, destHeight, caches.maxTextureSize);
+        return CopyResult::DestinationInvalid;
+    }
 
-    Caches& caches = Caches::getInstance();
+    GLuint fbo = renderState.createFramebuffer();
+    if (!fbo) {
+        ALOGW("Could not obtain an FBO");
+        return CopyResult::UnknownError;
+    }
+    renderState.bindFramebuffer(fbo);
+
+    // Render straight into the destination buffer
+    GLuint texture;
+    glGenTextures(1, &texture);
+    caches.textureState().activateTexture(0);
+    caches.textureState().bindTexture(texture);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, destImage);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, texture, 0);
+
+    CopyResult copyResult = CopyResult::UnknownError;
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status == GL_FRAMEBUFFER_COMPLETE) {
+        drawTextureInto(caches, renderState, sourceTexture, texTransform, srcRect,
+                destWidth, destHeight);
+        // Submit the copy without waiting for it to complete
+        glFlush();
+        copyResult = CopyResult::Success;
+    } else {
+        ALOGW("Hardware bitmap framebuffer is incomplete (%#x)", status);
+    }
+
+    // Cleanup
+    caches.textureState().deleteTexture(texture);
+    renderState.deleteFramebuffer(fbo);
+
+    GL_CHECKPOINT(MODERATE);
+
+    return copyResult;
+}
+
+// Wraps a 2D texture around the EGLImage to sample from it, returns false on failure
+static bool wrapExternalImage(Caches& caches, EGLImageKHR eglImage, int imgWidth, int imgHeight,
+        Texture* outTexture) {
     GLuint sourceTexId;
     // Create a 2D texture to sample from the EGLImage
     glGenTextures(1, &sourceTexId);
@@ -254,12 +383,23 @@ CopyResult OpenGLReadbackImpl::copyImageInto(EGLImageKHR eglImage,
     GLenum status = GL_NO_ERROR;
     while ((status = glGetError()) != GL_NO_ERROR) {
         ALOGW("glEGLImageTargetTexture2DOES failed (%#x)", status);
-        return CopyResult::UnknownError;
+        return false;
     }
 
-    Texture sourceTexture(caches);
-    sourceTexture.wrap(sourceTexId, imgWidth, imgHeight, 0, 0 /* total lie */,
+    outTexture->wrap(sourceTexId, imgWidth, imgHeight, 0, 0 /* total lie */,
             GL_TEXTURE_EXTERNAL_OES);
+    return true;
+}
+
+CopyResult OpenGLReadbackImpl::copyImageInto(EGLImageKHR eglImage,
+        const Matrix4& imgTransform, int imgWidth, int imgHeight, const Rect& srcRect,
+        SkBitmap* bitmap) {
+
+    Caches& caches = Caches::getInstance();
+    Texture sourceTexture(caches);
+    if (!wrapExternalImage(caches, eglImage, imgWidth, imgHeight, &sourceTexture)) {
+        return CopyResult::UnknownError;
+    }
 
     CopyResult copyResult = copyTextureInto(caches, mRenderThread.renderState(),
             sourceTexture, imgTransform, srcRect, bitmap);
@@ -267,6 +407,21 @@ CopyResult OpenGLReadbackImpl::copyImageInto(EGLImageKHR eglImage,
     return copyResult;
 }
 
+CopyResult OpenGLReadbackImpl::copyImageIntoImage(EGLImageKHR eglImage,
+        const Matrix4& imgTransform, int imgWidth, int imgHeight, const Rect& srcRect,
+        EGLImageKHR destImage, int destWidth, int destHeight) {
+    Caches& caches = Caches::getInstance();
+    Texture sourceTexture(caches);
+    if (!wrapExternalImage(caches, eglImage, imgWidth, imgHeight, &sourceTexture)) {
+        return CopyResult::UnknownError;
+    }
+
+    CopyResult copyResult = copyTextureIntoImage(caches, mRenderThread.renderState(),
+            sourceTexture, imgTransform, srcRect, destImage, destWidth, destHeight);
+    sourceTexture.deleteTexture();
+    return copyResult;
+}
+
 bool OpenGLReadbackImpl::copyLayerInto(renderthread::RenderThread& renderThread,
         GlLayer& layer, SkBitmap* bitmap) {
     return CopyResult::Success == copyTextureInto(Caches::getInstance(),
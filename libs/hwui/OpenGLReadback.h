@@ -30,6 +30,8 @@ public:
             SkBitmap* bitmap) override;
     virtual CopyResult copyGraphicBufferInto(GraphicBuffer* graphicBuffer,
             SkBitmap* bitmap) override;
+    virtual CopyResult copySurfaceIntoHardwareBitmap(Surface& surface, const Rect& srcRect,
+            int width, int height, sk_sp<Bitmap>* outBitmap) override;
 
 protected:
     explicit OpenGLReadback(renderthread::RenderThread& thread) : Readback(thread) {}
@@ -37,7 +39,16 @@ protected:
 
     virtual CopyResult copyImageInto(EGLImageKHR eglImage, const Matrix4& imgTransform,
             int imgWidth, int imgHeight, const Rect& srcRect, SkBitmap* bitmap) = 0;
+    /**
+     * Draws srcRect of the image into the whole of the destination image, which is backed by a
+     * RGBA_8888 buffer. Must flush the GPU work but not wait for it.
+     */
+    virtual CopyResult copyImageIntoImage(EGLImageKHR eglImage, const Matrix4& imgTransform,
+            int imgWidth, int imgHeight, const Rect& srcRect,
+            EGLImageKHR destImage, int destWidth, int destHeight) = 0;
 private:
+    CopyResult getLastQueuedBuffer(Surface& surface, sp<GraphicBuffer>* outBuffer,
+            Matrix4* outTexTransform);
     CopyResult copyGraphicBufferInto(GraphicBuffer* graphicBuffer, Matrix4& texTransform,
             const Rect& srcRect, SkBitmap* bitmap);
 };
@@ -55,6 +66,9 @@ public:
 protected:
     virtual CopyResult copyImageInto(EGLImageKHR eglImage, const Matrix4& imgTransform,
             int imgWidth, int imgHeight, const Rect& srcRect, SkBitmap* bitmap) override;
+    virtual CopyResult copyImageIntoImage(EGLImageKHR eglImage, const Matrix4& imgTransform,
+            int imgWidth, int imgHeight, const Rect& srcRect,
+            EGLImageKHR destImage, int destWidth, int destHeight) override;
 };
 
 } // namespace uirenderer
@@ -128,18 +128,12 @@ void PatchCache::clearGarbage() {
         mGarbage.clear();
     }
 
-    // TODO: We could sort patchesToRemove by offset to merge
-    // adjacent free blocks
     for (size_t i = 0; i < patchesToRemove.size(); i++) {
         const patch_pair_t& pair = patchesToRemove[i];
 
         // Release the patch and mark the space in the free list
         Patch* patch = pair.getSecond();
-        BufferBlock* block = new BufferBlock(patch->positionOffset, patch->getSize());
-        block->next = mFreeBlocks;
-        mFreeBlocks = block;
-
-        mSize -= patch->getSize();
+        releaseBlock(patch);
 
         mCache.remove(*pair.getFirst());
         delete patch;
@@ -159,6 +153,97 @@ void PatchCache::createVertexBuffer() {
     mFreeBlocks = new BufferBlock(0, mMaxSize);
 }
 
+/**
+ * Returns the range used by the specified mesh to the free list. The list is
+ * kept sorted by offset and adjacent blocks are merged, so that the space
+ * freed by several neighbouring meshes can be reused by a larger one.
+ */
+void PatchCache::releaseBlock(Patch* mesh) {
+    const uint32_t size = mesh->getSize();
+    if (!mesh->vertices || size == 0) return;
+
+    const uint32_t offset = (uint32_t) mesh->positionOffset;
+    mSize -= size;
+
+    BufferBlock* previous = nullptr;
+    BufferBlock* next = mFreeBlocks;
+    while (next && next->offset < offset) {
+        previous = next;
+        next = next->next;
+    }
+
+    if (previous && previous->offset + previous->size == offset) {
+        previous->size += size;
+        if (next && previous->offset + previous->size == next->offset) {
+            previous->size += next->size;
+            previous->next = next->next;
+            delete next;
+        }
+    } else if (next && offset + size == next->offset) {
+        next->offset = offset;
+        next->size += size;
+    } else {
+        BufferBlock* block = new BufferBlock(offset, size);
+        block->next = next;
+        if (previous) {
+            previous->next = block;
+        } else {
+            mFreeBlocks = block;
+        }
+    }
+}
+
+/**
+ * Removes the least recently used meshes until the specified number of
+ * bytes can be stored in the mesh buffer.
+ */
+void PatchCache::evictFor(uint32_t size) {
+    while (mSize + size > mMaxSize && mCache.size() > 0) {
+        Patch* oldest = mCache.peekOldestValue();
+        releaseBlock(oldest);
+        mCache.removeOldest();
+        delete oldest;
+    }
+}
+
+/**
+ * Moves all the cached meshes to the beginning of the mesh buffer, leaving
+ * a single free block at its end. The vertices of every mesh are kept on
+ * the CPU side, so this only costs a re-upload instead of regenerating all
+ * the meshes after clearing the cache.
+ */
+void PatchCache::compact() {
+    BufferBlock* block = mFreeBlocks;
+    while (block) {
+        BufferBlock* next = block->next;
+        delete block;
+        block = next;
+    }
+
+    uint32_t offset = 0;
+    LruCache<PatchDescription, Patch*>::Iterator i(mCache);
+    while (i.next()) {
+        Patch* mesh = i.value();
+        const uint32_t size = mesh->getSize();
+        if (!mesh->vertices || size == 0) continue;
+
+        if ((uint32_t) mesh->positionOffset != offset) {
+            mesh->positionOffset = (GLintptr) offset;
+            mesh->textureOffset = mesh->positionOffset + kMeshTextureOffset;
+            mRenderState.meshState().updateMeshBufferSubData(mMeshBuffer,
+                    mesh->positionOffset, size, mesh->vertices.get());
+        }
+        offset += size;
+    }
+
+    mSize = offset;
+    mFreeBlocks = offset < mMaxSize ? new BufferBlock(offset, mMaxSize - offset) : nullptr;
+
+#if DEBUG_PATCHES
+    dumpFreeBlocks("Compacted");
+#endif
+}
+
 /**
  * Sets the mesh's offsets and copies its associated vertices into
  * the mesh buffer (VBO).
@@ -169,11 +254,11 @@ void PatchCache::setupMesh(Patch* newMesh) {
         createVertexBuffer();
     }
 
-    // If we're running out of space, let's clear the entire cache
+    // If we're running out of space, make room by dropping the meshes
+    // that haven't been drawn for the longest time
     uint32_t size = newMesh->getSize();
     if (mSize + size > mMaxSize) {
-        clearCache();
-        createVertexBuffer();
+        evictFor(size);
     }
 
     // Find a block where we can fit the mesh
@@ -189,14 +274,23 @@ void PatchCache::setupMesh(Patch* newMesh) {
     }
 
     // We have enough space left in the buffer, but it's
-    // too fragmented, let's clear the cache
+    // too fragmented, move the remaining meshes together
     if (!block) {
-        clearCache();
-        createVertexBuffer();
+        compact();
         previous = nullptr;
         block = mFreeBlocks;
     }
 
+    // The mesh doesn't fit even in an empty buffer
+    if (!block || block->size < size) {
+        ALOGW("9-patch mesh of %u bytes doesn't fit in the patch cache (%u bytes)",
+                size, mMaxSize);
+        newMesh->vertices.reset();
+        newMesh->verticesCount = 0;
+        newMesh->indexCount = 0;
+        return;
+    }
+
     // Copy the 9patch mesh in the VBO
     newMesh->positionOffset = (GLintptr) (block->offset);
     newMesh->textureOffset = newMesh->positionOffset + kMeshTextureOffset;
@@ -253,7 +347,7 @@ void PatchCache::dumpFreeBlocks(const char* prefix) {
     String8 dump;
     BufferBlock* block = mFreeBlocks;
     while (block) {
-        dump.appendFormat("->(%d, %d)", block->positionOffset, block->size);
+        dump.appendFormat("->(%d, %d)", block->offset, block->size);
         block = block->next;
     }
     ALOGD("%s: Free blocks%s", prefix, dump.string());
@@ -135,8 +135,8 @@ private:
      * A buffer block represents an empty range in the mesh buffer
      * that can be used to store vertices.
      *
-     * The patch cache maintains a linked-list of buffer blocks
-     * to track available regions of memory in the VBO.
+     * The patch cache maintains a linked-list of buffer blocks, sorted
+     * by offset, to track available regions of memory in the VBO.
      */
     struct BufferBlock {
         BufferBlock(uint32_t offset, uint32_t size): offset(offset), size(size), next(nullptr) {
@@ -154,6 +154,9 @@ private:
     void createVertexBuffer();
 
     void setupMesh(Patch* newMesh);
+    void releaseBlock(Patch* mesh);
+    void evictFor(uint32_t size);
+    void compact();
 
     void remove(Vector<patch_pair_t>& patchesToRemove, Res_png_9patch* patch);
 
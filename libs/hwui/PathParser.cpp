@@ -20,9 +20,13 @@
 
 #include <errno.h>
 #include <utils/Log.h>
+#include <list>
+#include <mutex>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace android {
@@ -214,6 +218,162 @@ void PathParser::getPathDataFromAsciiString(PathData* data, ParseResult* result,
     }
 }
 
+// Most apps use a few hundred distinct icons at most
+static const size_t kMaxCachedPathData = 256;
+
+namespace {
+class PathDataCache {
+public:
+    bool get(const std::string& pathStr, PathData* outData) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto iter = mEntries.find(pathStr);
+        if (iter == mEntries.end()) {
+            return false;
+        }
+        mLru.splice(mLru.begin(), mLru, iter->second.lruPosition);
+        *outData = iter->second.data;
+        return true;
+    }
+
+    void put(std::string&& pathStr, const PathData& data) {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mEntries.count(pathStr)) {
+            return;
+        }
+        if (mEntries.size() >= kMaxCachedPathData) {
+            mEntries.erase(mLru.back());
+            mLru.pop_back();
+        }
+        mLru.push_front(pathStr);
+        Entry& entry = mEntries[std::move(pathStr)];
+        entry.data = data;
+        entry.lruPosition = mLru.begin();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mEntries.clear();
+        mLru.clear();
+    }
+
+private:
+    struct Entry {
+        PathData data;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    std::mutex mLock;
+    std::unordered_map<std::string, Entry> mEntries;
+    // Most recently used first
+    std::list<std::string> mLru;
+};
+} // namespace
+
+static PathDataCache& pathDataCache() {
+    static PathDataCache* sCache = new PathDataCache();
+    return *sCache;
+}
+
+void PathParser::getCachedPathDataFromAsciiString(PathData* data, ParseResult* result,
+        const char* pathStr, size_t strLen) {
+    if (pathStr == NULL) {
+        getPathDataFromAsciiString(data, result, pathStr, strLen);
+        return;
+    }
+    std::string key(pathStr, strLen);
+    if (pathDataCache().get(key, data)) {
+        return;
+    }
+    PathData parsed;
+    getPathDataFromAsciiString(&parsed, result, pathStr, strLen);
+    if (!result->failureOccurred) {
+        pathDataCache().put(std::move(key), parsed);
+        *data = std::move(parsed);
+    }
+}
+
+void PathParser::clearPathDataCache() {
+    pathDataCache().clear();
+}
+
+static const uint32_t kPathDataMagic = 0x44505748; // "HWPD"
+
+struct PathDataHeader {
+    uint32_t magic;
+    uint32_t verbCount;
+    uint32_t pointCount;
+};
+
+static size_t align4(size_t size) {
+    return (size + 3) & ~3;
+}
+
+void PathParser::serializePathData(const PathData& data, std::vector<uint8_t>* outBuffer) {
+    PathDataHeader header;
+    header.magic = kPathDataMagic;
+    header.verbCount = data.verbs.size();
+    header.pointCount = data.points.size();
+
+    // header, verbs padded to 4 bytes, uint32_t verb sizes, float points
+    size_t verbsOffset = sizeof(PathDataHeader);
+    size_t verbSizesOffset = verbsOffset + align4(header.verbCount);
+    size_t pointsOffset = verbSizesOffset + header.verbCount * sizeof(uint32_t);
+    outBuffer->assign(pointsOffset + header.pointCount * sizeof(float), 0);
+
+    uint8_t* buffer = outBuffer->data();
+    memcpy(buffer, &header, sizeof(PathDataHeader));
+    memcpy(buffer + verbsOffset, data.verbs.data(), header.verbCount);
+    uint32_t* verbSizes = reinterpret_cast<uint32_t*>(buffer + verbSizesOffset);
+    for (size_t i = 0; i < header.verbCount; i++) {
+        verbSizes[i] = data.verbSizes[i];
+    }
+    memcpy(buffer + pointsOffset, data.points.data(), header.pointCount * sizeof(float));
+}
+
+void PathParser::getPathDataFromBinary(PathData* data, ParseResult* result,
+        const void* buffer, size_t size) {
+    PathDataHeader header;
+    if (buffer == NULL || size < sizeof(PathDataHeader)
+            || (reinterpret_cast<uintptr_t>(buffer) & 3)) {
+        result->failureOccurred = true;
+        result->failureMessage = "Binary path data is truncated.";
+        return;
+    }
+    memcpy(&header, buffer, sizeof(PathDataHeader));
+    size_t verbsOffset = sizeof(PathDataHeader);
+    size_t verbSizesOffset = verbsOffset + align4(header.verbCount);
+    size_t pointsOffset = verbSizesOffset + header.verbCount * sizeof(uint32_t);
+    if (header.magic != kPathDataMagic || header.verbCount > size || header.pointCount > size
+            || pointsOffset + header.pointCount * sizeof(float) != size) {
+        result->failureOccurred = true;
+        result->failureMessage = "Invalid binary path data.";
+        return;
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(buffer);
+    const char* verbs = reinterpret_cast<const char*>(bytes + verbsOffset);
+    const uint32_t* verbSizes = reinterpret_cast<const uint32_t*>(bytes + verbSizesOffset);
+    size_t totalVerbSize = 0;
+    for (size_t i = 0; i < header.verbCount; i++) {
+        if (!isVerbValid(verbs[i])) {
+            result->failureOccurred = true;
+            result->failureMessage = "Invalid verb in binary path data.";
+            return;
+        }
+        totalVerbSize += verbSizes[i];
+    }
+    if (totalVerbSize != header.pointCount) {
+        result->failureOccurred = true;
+        result->failureMessage = "Invalid binary path data.";
+        return;
+    }
+
+    data->verbs.assign(verbs, verbs + header.verbCount);
+    data->verbSizes.assign(verbSizes, verbSizes + header.verbCount);
+    const float* points = reinterpret_cast<const float*>(bytes + pointsOffset);
+    data->points.assign(points, points + header.pointCount);
+}
+
 void PathParser::dump(const PathData& data) {
     // Print out the path data.
     size_t start = 0;
@@ -25,6 +25,7 @@
 #include <cutils/compiler.h>
 
 #include <string>
+#include <vector>
 
 namespace android {
 namespace uirenderer {
@@ -43,6 +44,24 @@ public:
             const char* pathStr, size_t strLength);
     ANDROID_API static void getPathDataFromAsciiString(PathData* outData, ParseResult* result,
             const char* pathStr, size_t strLength);
+    /**
+     * Same as getPathDataFromAsciiString(), but the PathData of the most recently parsed
+     * strings is kept in a process wide cache, as the same icons tend to be inflated over and
+     * over. outData is replaced rather than appended to. Thread safe.
+     */
+    ANDROID_API static void getCachedPathDataFromAsciiString(PathData* outData,
+            ParseResult* result, const char* pathStr, size_t strLength);
+    ANDROID_API static void clearPathDataCache();
+
+    /**
+     * Writes the data in a compact binary form, that can be produced ahead of time and loaded
+     * with getPathDataFromBinary() without tokenizing any text. The data is in native byte
+     * order, and the buffer given to getPathDataFromBinary() must be 4 byte aligned.
+     */
+    ANDROID_API static void serializePathData(const PathData& data,
+            std::vector<uint8_t>* outBuffer);
+    ANDROID_API static void getPathDataFromBinary(PathData* outData, ParseResult* result,
+            const void* buffer, size_t size);
     static void dump(const PathData& data);
     static bool isVerbValid(char verb);
 };
@@ -53,6 +53,14 @@
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define TESSELLATOR_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TESSELLATOR_USE_SSE2
+#endif
+
 namespace android {
 namespace uirenderer {
 
@@ -93,6 +101,104 @@ inline static Vector2 totalOffsetFromNormals(const Vector2& normalA, const Vecto
     return (normalA + normalB) / (1 + fabs(normalA.dot(normalB)));
 }
 
+/**
+ * Fills normals with the normal of each edge (vertices[i], vertices[i + 1]), wrapping around at
+ * the end, and offsets with totalOffsetFromNormals() of the two edges meeting at each vertex.
+ *
+ * The square roots and divisions these need dominate the cost of emitting fill and stroke
+ * vertices, so they are computed here over the whole path, four points at a time, ahead of the
+ * per vertex loops below. Only uses SIMD where square root and division are exact, so the
+ * results match the scalar code.
+ */
+static void computeNormalsAndOffsets(const std::vector<Vertex>& vertices,
+        std::vector<Vector2>& normals, std::vector<Vector2>& offsets) {
+    const int count = vertices.size();
+    normals.resize(count);
+    offsets.resize(count);
+    const float* points = reinterpret_cast<const float*>(vertices.data());
+    float* outNormals = reinterpret_cast<float*>(normals.data());
+    float* outOffsets = reinterpret_cast<float*>(offsets.data());
+
+    int i = 0;
+#if defined(TESSELLATOR_USE_NEON)
+    for (; i + 5 <= count; i += 4) {
+        float32x4x2_t current = vld2q_f32(points + 2 * i);
+        float32x4x2_t next = vld2q_f32(points + 2 * (i + 1));
+        float32x4_t nx = vsubq_f32(next.val[1], current.val[1]);
+        float32x4_t ny = vsubq_f32(current.val[0], next.val[0]);
+        float32x4_t length = vsqrtq_f32(vaddq_f32(vmulq_f32(nx, nx), vmulq_f32(ny, ny)));
+        float32x4_t scale = vdivq_f32(vdupq_n_f32(1.0f), length);
+        float32x4x2_t normal = {{ vmulq_f32(nx, scale), vmulq_f32(ny, scale) }};
+        vst2q_f32(outNormals + 2 * i, normal);
+    }
+#elif defined(TESSELLATOR_USE_SSE2)
+    for (; i + 5 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(points + 2 * i);
+        __m128 b = _mm_loadu_ps(points + 2 * i + 4);
+        __m128 c = _mm_loadu_ps(points + 2 * i + 2);
+        __m128 d = _mm_loadu_ps(points + 2 * i + 6);
+        __m128 currentX = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 currentY = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 nextX = _mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 nextY = _mm_shuffle_ps(c, d, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 nx = _mm_sub_ps(nextY, currentY);
+        __m128 ny = _mm_sub_ps(currentX, nextX);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)));
+        __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), length);
+        nx = _mm_mul_ps(nx, scale);
+        ny = _mm_mul_ps(ny, scale);
+        _mm_storeu_ps(outNormals + 2 * i, _mm_unpacklo_ps(nx, ny));
+        _mm_storeu_ps(outNormals + 2 * i + 4, _mm_unpackhi_ps(nx, ny));
+    }
+#endif
+    for (; i < count; i++) {
+        const Vertex& current = vertices[i];
+        const Vertex& next = vertices[i + 1 >= count ? 0 : i + 1];
+        normals[i] = {next.y - current.y, current.x - next.x};
+        normals[i].normalize();
+    }
+
+    // The first vertex joins the last edge, which the vector loops can't load contiguously
+    if (count > 0) {
+        offsets[0] = totalOffsetFromNormals(normals[count - 1], normals[0]);
+    }
+    i = 1;
+#if defined(TESSELLATOR_USE_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4x2_t last = vld2q_f32(outNormals + 2 * (i - 1));
+        float32x4x2_t next = vld2q_f32(outNormals + 2 * i);
+        float32x4_t dot = vaddq_f32(vmulq_f32(last.val[0], next.val[0]),
+                vmulq_f32(last.val[1], next.val[1]));
+        float32x4_t divisor = vaddq_f32(vdupq_n_f32(1.0f), vabsq_f32(dot));
+        float32x4x2_t offset = {{
+                vdivq_f32(vaddq_f32(last.val[0], next.val[0]), divisor),
+                vdivq_f32(vaddq_f32(last.val[1], next.val[1]), divisor) }};
+        vst2q_f32(outOffsets + 2 * i, offset);
+    }
+#elif defined(TESSELLATOR_USE_SSE2)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(outNormals + 2 * (i - 1));
+        __m128 b = _mm_loadu_ps(outNormals + 2 * (i - 1) + 4);
+        __m128 c = _mm_loadu_ps(outNormals + 2 * i);
+        __m128 d = _mm_loadu_ps(outNormals + 2 * i + 4);
+        __m128 lastX = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 lastY = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 nextX = _mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 nextY = _mm_shuffle_ps(c, d, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 dot = _mm_add_ps(_mm_mul_ps(lastX, nextX), _mm_mul_ps(lastY, nextY));
+        __m128 divisor = _mm_add_ps(_mm_set1_ps(1.0f), _mm_and_ps(dot, absMask));
+        __m128 ox = _mm_div_ps(_mm_add_ps(lastX, nextX), divisor);
+        __m128 oy = _mm_div_ps(_mm_add_ps(lastY, nextY), divisor);
+        _mm_storeu_ps(outOffsets + 2 * i, _mm_unpacklo_ps(ox, oy));
+        _mm_storeu_ps(outOffsets + 2 * i + 4, _mm_unpackhi_ps(ox, oy));
+    }
+#endif
+    for (; i < count; i++) {
+        offsets[i] = totalOffsetFromNormals(normals[i - 1], normals[i]);
+    }
+}
+
 /**
  * Structure used for storing useful information about the SkPaint and scale used for tessellating
  */
@@ -209,17 +315,13 @@ void getStrokeVerticesFromPerimeter(const PaintInfo& paintInfo,
         const std::vector<Vertex>& perimeter, VertexBuffer& vertexBuffer) {
     Vertex* buffer = vertexBuffer.alloc<Vertex>(perimeter.size() * 2 + 2);
 
+    std::vector<Vector2> normals, offsets;
+    computeNormalsAndOffsets(perimeter, normals, offsets);
+
     int currentIndex = 0;
-    const Vertex* last = &(perimeter[perimeter.size() - 1]);
-    const Vertex* current = &(perimeter[0]);
-    Vector2 lastNormal = {current->y - last->y, last->x - current->x};
-    lastNormal.normalize();
     for (unsigned int i = 0; i < perimeter.size(); i++) {
-        const Vertex* next = &(perimeter[i + 1 >= perimeter.size() ? 0 : i + 1]);
-        Vector2 nextNormal = {next->y - current->y, current->x - next->x};
-        nextNormal.normalize();
-
-        Vector2 totalOffset = totalOffsetFromNormals(lastNormal, nextNormal);
+        const Vertex* current = &(perimeter[i]);
+        Vector2 totalOffset = offsets[i];
         paintInfo.scaleOffsetForStrokeWidth(totalOffset);
 
         Vertex::set(&buffer[currentIndex++],
@@ -229,9 +331,6 @@ void getStrokeVerticesFromPerimeter(const PaintInfo& paintInfo,
         Vertex::set(&buffer[currentIndex++],
                 current->x - totalOffset.x,
                 current->y - totalOffset.y);
-
-        current = next;
-        lastNormal = nextNormal;
     }
 
     // wrap around to beginning
@@ -304,31 +403,25 @@ void getStrokeVerticesFromUnclosedVertices(const PaintInfo& paintInfo,
         }
     }
 
-    int currentIndex = extra;
-    const Vertex* last = &(vertices[0]);
-    const Vertex* current = &(vertices[1]);
-    Vector2 lastNormal = {current->y - last->y, last->x - current->x};
-    lastNormal.normalize();
+    // The wrapping edge and the offsets of both ends are computed but unused
+    std::vector<Vector2> normals, offsets;
+    computeNormalsAndOffsets(vertices, normals, offsets);
 
-    storeBeginEnd(paintInfo, vertices[0], lastNormal, buffer, currentIndex, true);
+    int currentIndex = extra;
+    storeBeginEnd(paintInfo, vertices[0], normals[0], buffer, currentIndex, true);
 
     for (unsigned int i = 1; i < vertices.size() - 1; i++) {
-        const Vertex* next = &(vertices[i + 1]);
-        Vector2 nextNormal = {next->y - current->y, current->x - next->x};
-        nextNormal.normalize();
-
-        Vector2 strokeOffset  = totalOffsetFromNormals(lastNormal, nextNormal);
+        const Vertex* current = &(vertices[i]);
+        Vector2 strokeOffset = offsets[i];
         paintInfo.scaleOffsetForStrokeWidth(strokeOffset);
 
         Vector2 center = {current->x, current->y};
         Vertex::set(&buffer[currentIndex++], center + strokeOffset);
         Vertex::set(&buffer[currentIndex++], center - strokeOffset);
-
-        current = next;
-        lastNormal = nextNormal;
     }
 
-    storeBeginEnd(paintInfo, vertices[lastIndex], lastNormal, buffer, currentIndex, false);
+    storeBeginEnd(paintInfo, vertices[lastIndex], normals[lastIndex - 1], buffer, currentIndex,
+            false);
 
     DEBUG_DUMP_BUFFER();
 }
@@ -350,19 +443,16 @@ void getFillVerticesFromPerimeterAA(const PaintInfo& paintInfo,
 
     // generate alpha points - fill Alpha vertex gaps in between each point with
     // alpha 0 vertex, offset by a scaled normal.
+    std::vector<Vector2> normals, offsets;
+    computeNormalsAndOffsets(perimeter, normals, offsets);
+
     int currentIndex = 0;
-    const Vertex* last = &(perimeter[perimeter.size() - 1]);
-    const Vertex* current = &(perimeter[0]);
-    Vector2 lastNormal = {current->y - last->y, last->x - current->x};
-    lastNormal.normalize();
     for (unsigned int i = 0; i < perimeter.size(); i++) {
-        const Vertex* next = &(perimeter[i + 1 >= perimeter.size() ? 0 : i + 1]);
-        Vector2 nextNormal = {next->y - current->y, current->x - next->x};
-        nextNormal.normalize();
+        const Vertex* current = &(perimeter[i]);
 
         // AA point offset from original point is that point's normal, such that each side is offset
         // by .5 pixels
-        Vector2 totalOffset = paintInfo.deriveAAOffset(totalOffsetFromNormals(lastNormal, nextNormal));
+        Vector2 totalOffset = paintInfo.deriveAAOffset(offsets[i]);
 
         AlphaVertex::set(&buffer[currentIndex++],
                 current->x + totalOffset.x,
@@ -372,9 +462,6 @@ void getFillVerticesFromPerimeterAA(const PaintInfo& paintInfo,
                 current->x - totalOffset.x,
                 current->y - totalOffset.y,
                 maxAlpha);
-
-        current = next;
-        lastNormal = nextNormal;
     }
 
     // wrap around to beginning
@@ -588,20 +675,16 @@ void getStrokeVerticesFromUnclosedVerticesAA(const PaintInfo& paintInfo,
     int currentAAInnerIndex = currentAAOuterIndex + (2 * offset) + 3 + (2 * extra);
     int currentStrokeIndex = currentAAInnerIndex + 7 + (3 * extra - 2 * extraOffset);
 
-    const Vertex* last = &(vertices[0]);
-    const Vertex* current = &(vertices[1]);
-    Vector2 lastNormal = {current->y - last->y, last->x - current->x};
-    lastNormal.normalize();
+    // The wrapping edge and the offsets of both ends are computed but unused
+    std::vector<Vector2> normals, offsets;
+    computeNormalsAndOffsets(vertices, normals, offsets);
 
     // TODO: use normal from bezier traversal for cap, instead of from vertices
-    storeCapAA(paintInfo, vertices, buffer, true, lastNormal, offset);
+    storeCapAA(paintInfo, vertices, buffer, true, normals[0], offset);
 
     for (unsigned int i = 1; i < vertices.size() - 1; i++) {
-        const Vertex* next = &(vertices[i + 1]);
-        Vector2 nextNormal = {next->y - current->y, current->x - next->x};
-        nextNormal.normalize();
-
-        Vector2 totalOffset = totalOffsetFromNormals(lastNormal, nextNormal);
+        const Vertex* current = &(vertices[i]);
+        Vector2 totalOffset = offsets[i];
         Vector2 AAOffset = paintInfo.deriveAAOffset(totalOffset);
 
         Vector2 innerOffset = totalOffset;
@@ -635,13 +718,10 @@ void getStrokeVerticesFromUnclosedVerticesAA(const PaintInfo& paintInfo,
                 current->x - outerOffset.x,
                 current->y - outerOffset.y,
                 0.0f);
-
-        current = next;
-        lastNormal = nextNormal;
     }
 
     // TODO: use normal from bezier traversal for cap, instead of from vertices
-    storeCapAA(paintInfo, vertices, buffer, false, lastNormal, offset);
+    storeCapAA(paintInfo, vertices, buffer, false, normals[vertices.size() - 2], offset);
 
     DEBUG_DUMP_ALPHA_BUFFER();
 }
@@ -656,16 +736,12 @@ void getStrokeVerticesFromPerimeterAA(const PaintInfo& paintInfo,
     int currentStrokeIndex = offset;
     int currentAAInnerIndex = offset * 2;
 
-    const Vertex* last = &(perimeter[perimeter.size() - 1]);
-    const Vertex* current = &(perimeter[0]);
-    Vector2 lastNormal = {current->y - last->y, last->x - current->x};
-    lastNormal.normalize();
-    for (unsigned int i = 0; i < perimeter.size(); i++) {
-        const Vertex* next = &(perimeter[i + 1 >= perimeter.size() ? 0 : i + 1]);
-        Vector2 nextNormal = {next->y - current->y, current->x - next->x};
-        nextNormal.normalize();
+    std::vector<Vector2> normals, offsets;
+    computeNormalsAndOffsets(perimeter, normals, offsets);
 
-        Vector2 totalOffset = totalOffsetFromNormals(lastNormal, nextNormal);
+    for (unsigned int i = 0; i < perimeter.size(); i++) {
+        const Vertex* current = &(perimeter[i]);
+        Vector2 totalOffset = offsets[i];
         Vector2 AAOffset = paintInfo.deriveAAOffset(totalOffset);
 
         Vector2 innerOffset = totalOffset;
@@ -699,9 +775,6 @@ void getStrokeVerticesFromPerimeterAA(const PaintInfo& paintInfo,
                 current->x - outerOffset.x,
                 current->y - outerOffset.y,
                 0.0f);
-
-        current = next;
-        lastNormal = nextNormal;
     }
 
     // wrap each strip around to beginning, creating degenerate tris to bridge strips
@@ -73,10 +73,41 @@ Program::Program(const ProgramDescription& description, const char* vertex, cons
         }
     }
 
-    if (mInitialized) {
-        transform = addUniform("transform");
-        projection = addUniform("projection");
+    initUniforms();
+}
+
+Program::Program(GLenum binaryFormat, const void* binary, GLsizei length, bool hasTexCoords) {
+    mInitialized = false;
+    mHasColorUniform = false;
+    mHasSampler = false;
+    mUse = false;
+    mVertexShader = 0;
+    mFragmentShader = 0;
+
+    ATRACE_NAME("Load GL Program Binary");
+    mProgramId = glCreateProgram();
+    glProgramBinaryOES(mProgramId, binaryFormat, binary, length);
+
+    GLint status;
+    glGetProgramiv(mProgramId, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        // Usually means the driver was updated, the caller will compile the sources again
+        glDeleteProgram(mProgramId);
+        mProgramId = 0;
+        return;
+    }
+    mInitialized = true;
+
+    // The attribute locations were bound when the binary was linked
+    mAttributes.add("position", kBindingPosition);
+    if (hasTexCoords) {
+        texCoords = kBindingTexCoords;
+        mAttributes.add("texCoords", kBindingTexCoords);
+    } else {
+        texCoords = -1;
     }
+
+    initUniforms();
 }
 
 Program::~Program() {
@@ -84,16 +115,43 @@ Program::~Program() {
         // This would ideally happen after linking the program
         // but Tegra drivers, especially when perfhud is enabled,
         // sometimes crash if we do so
-        glDetachShader(mProgramId, mVertexShader);
-        glDetachShader(mProgramId, mFragmentShader);
+        if (mVertexShader) {
+            glDetachShader(mProgramId, mVertexShader);
+            glDetachShader(mProgramId, mFragmentShader);
 
-        glDeleteShader(mVertexShader);
-        glDeleteShader(mFragmentShader);
+            glDeleteShader(mVertexShader);
+            glDeleteShader(mFragmentShader);
+        }
 
         glDeleteProgram(mProgramId);
     }
 }
 
+void Program::initUniforms() {
+    if (mInitialized) {
+        transform = addUniform("transform");
+        projection = addUniform("projection");
+    }
+}
+
+bool Program::getBinary(GLenum* outBinaryFormat, std::vector<uint8_t>* outBinary) const {
+    if (!mInitialized) return false;
+
+    GLint length = 0;
+    glGetProgramiv(mProgramId, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) return false;
+
+    outBinary->resize(length);
+    GLsizei written = 0;
+    glGetProgramBinaryOES(mProgramId, length, &written, outBinaryFormat, outBinary->data());
+    if (written <= 0) {
+        outBinary->clear();
+        return false;
+    }
+    outBinary->resize(written);
+    return true;
+}
+
 int Program::addAttrib(const char* name) {
     int slot = glGetAttribLocation(mProgramId, name);
     mAttributes.add(name, slot);
@@ -19,6 +19,9 @@
 
 #include <utils/KeyedVector.h>
 
+#include <vector>
+
+
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
@@ -343,8 +346,20 @@ public:
      * shaders sources.
      */
     Program(const ProgramDescription& description, const char* vertex, const char* fragment);
+
+    /**
+     * Creates a new program from a binary previously returned by getBinary().
+     * isInitialized() returns false if the driver rejected the binary.
+     */
+    Program(GLenum binaryFormat, const void* binary, GLsizei length, bool hasTexCoords);
     virtual ~Program();
 
+    /**
+     * Retrieves the linked program as a driver specific binary, requires
+     * GL_OES_get_program_binary. Returns false on failure.
+     */
+    bool getBinary(GLenum* outBinaryFormat, std::vector<uint8_t>* outBinary) const;
+
     /**
      * Binds this program to the GL context.
      */
@@ -436,6 +451,8 @@ private:
      */
     GLuint buildShader(const char* source, GLenum type);
 
+    void initUniforms();
+
     // Name of the OpenGL program and shaders
     GLuint mProgramId;
     GLuint mVertexShader;
@@ -14,12 +14,21 @@
  * limitations under the License.
  */
 
+#include <utils/Mutex.h>
 #include <utils/String8.h>
+#include <utils/Trace.h>
 
 #include "Caches.h"
 #include "ProgramCache.h"
 #include "Properties.h"
 
+#include <cutils/compiler.h>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
 namespace android {
 namespace uirenderer {
 
@@ -34,6 +43,20 @@ namespace uirenderer {
 #define STR(x) STR1(x)
 #define STR1(x) #x
 
+// Disk cache format, in host byte order: magic, version, driver id, number of
+// entries then for each entry key, use count, flags, binary format, length and binary
+static const uint32_t kDiskCacheMagic = 0x43425048; // 'HPBC'
+static const uint32_t kDiskCacheVersion = 1;
+static const uint32_t kDiskCacheFlagTexCoords = 0x1;
+// Bounds the size of the file, the least used programs are dropped first
+static const size_t kMaxDiskCacheEntries = 64;
+static const uint32_t kMaxProgramBinarySize = 1024 * 1024;
+// Number of programs linked ahead of time when the context is created
+static const size_t kPrewarmProgramCount = 12;
+
+static Mutex sDiskCacheLock;
+static std::string sDiskCachePath;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Vertex shaders snippets
 ///////////////////////////////////////////////////////////////////////////////
@@ -507,7 +530,8 @@ const char* gBlendOps[18] = {
 
 ProgramCache::ProgramCache(Extensions& extensions)
         : mHasES3(extensions.getMajorGlVersion() >= 3)
-        , mHasLinearBlending(extensions.hasLinearBlending()) {
+        , mHasLinearBlending(extensions.hasLinearBlending())
+        , mHasProgramBinary(extensions.hasProgramBinary()) {
 }
 
 ProgramCache::~ProgramCache() {
@@ -520,7 +544,9 @@ ProgramCache::~ProgramCache() {
 
 void ProgramCache::clear() {
     PROGRAM_LOGD("Clearing program cache");
+    saveDiskCache();
     mCache.clear();
+    mPrewarmed.clear();
 }
 
 Program* ProgramCache::get(const ProgramDescription& description) {
@@ -539,19 +565,222 @@ Program* ProgramCache::get(const ProgramDescription& description) {
         mCache[key] = std::unique_ptr<Program>(program);
     } else {
         program = iter->second.get();
+        if (CC_UNLIKELY(!mPrewarmed.empty()) && mPrewarmed.erase(key)) {
+            mBinaries[key].usedThisRun = true;
+        }
     }
     return program;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Disk cache
+///////////////////////////////////////////////////////////////////////////////
+
+void ProgramCache::setDiskCachePath(const char* path) {
+    Mutex::Autolock _l(sDiskCacheLock);
+    sDiskCachePath = path;
+}
+
+static std::string getDiskCachePath() {
+    Mutex::Autolock _l(sDiskCacheLock);
+    return sDiskCachePath;
+}
+
+std::string ProgramCache::getDriverId() const {
+    // Binaries are only valid for the driver build that produced them
+    std::string id;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const char* value = (const char*) glGetString(name);
+        id.append(value ? value : "");
+        id.push_back('\n');
+    }
+    return id;
+}
+
+template <typename T>
+static bool readValue(FILE* file, T* value) {
+    return fread(value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+static bool writeValue(FILE* file, const T& value) {
+    return fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+void ProgramCache::loadDiskCache() {
+    if (!mHasProgramBinary) return;
+    const std::string path = getDiskCachePath();
+    if (path.empty()) return;
+
+    ATRACE_NAME("ProgramCache::loadDiskCache");
+    if (!mDiskCacheLoaded) {
+        mDiskCacheLoaded = true;
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file) {
+            const std::string driverId = getDriverId();
+            uint32_t magic, version, length, count = 0;
+            bool valid = readValue(file, &magic) && magic == kDiskCacheMagic
+                    && readValue(file, &version) && version == kDiskCacheVersion
+                    && readValue(file, &length) && length == driverId.size();
+            if (valid) {
+                std::string fileDriverId(length, '\0');
+                valid = fread(&fileDriverId[0], 1, length, file) == length
+                        && fileDriverId == driverId
+                        && readValue(file, &count) && count <= kMaxDiskCacheEntries;
+            }
+            for (uint32_t i = 0; valid && i < count; i++) {
+                programid key;
+                uint32_t flags, format;
+                ProgramBinary binary;
+                valid = readValue(file, &key) && readValue(file, &binary.useCount)
+                        && readValue(file, &flags) && readValue(file, &format)
+                        && readValue(file, &length) && length <= kMaxProgramBinarySize;
+                if (valid) {
+                    binary.format = format;
+                    binary.hasTexCoords = flags & kDiskCacheFlagTexCoords;
+                    binary.data.resize(length);
+                    valid = fread(binary.data.data(), 1, length, file) == length;
+                    mBinaries[key] = std::move(binary);
+                }
+            }
+            fclose(file);
+            if (!valid) {
+                // Stale or corrupt, start over and rewrite it on the next save
+                PROGRAM_LOGD("Discarding program disk cache %s", path.c_str());
+                mBinaries.clear();
+                mDiskCacheDirty = true;
+            }
+        }
+    }
+
+    // Link the programs most runs needed now rather than on the first frames
+    std::vector<std::pair<uint32_t, programid>> byUseCount;
+    for (auto& iter : mBinaries) {
+        if (mCache.find(iter.first) == mCache.end()) {
+            byUseCount.emplace_back(iter.second.useCount, iter.first);
+        }
+    }
+    std::sort(byUseCount.rbegin(), byUseCount.rend());
+    if (byUseCount.size() > kPrewarmProgramCount) {
+        byUseCount.resize(kPrewarmProgramCount);
+    }
+    for (auto& entry : byUseCount) {
+        const programid key = entry.second;
+        Program* program = loadProgram(key, mBinaries[key]);
+        if (program) {
+            mCache[key] = std::unique_ptr<Program>(program);
+            mPrewarmed.insert(key);
+        } else {
+            mBinaries.erase(key);
+            mDiskCacheDirty = true;
+        }
+    }
+}
+
+void ProgramCache::saveDiskCache() {
+    if (!mDiskCacheLoaded) return;
+
+    for (auto& iter : mBinaries) {
+        if (iter.second.usedThisRun) {
+            iter.second.usedThisRun = false;
+            iter.second.useCount++;
+            mDiskCacheDirty = true;
+        }
+    }
+    if (!mDiskCacheDirty) return;
+
+    const std::string path = getDiskCachePath();
+    if (path.empty()) return;
+
+    ATRACE_NAME("ProgramCache::saveDiskCache");
+    std::vector<std::pair<uint32_t, programid>> byUseCount;
+    for (auto& iter : mBinaries) {
+        byUseCount.emplace_back(iter.second.useCount, iter.first);
+    }
+    std::sort(byUseCount.rbegin(), byUseCount.rend());
+    for (size_t i = kMaxDiskCacheEntries; i < byUseCount.size(); i++) {
+        mBinaries.erase(byUseCount[i].second);
+    }
+
+    // Write to a temporary file so a reader never sees a partial cache
+    const std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        ALOGW("Failed to open program disk cache %s", tempPath.c_str());
+        return;
+    }
+    const std::string driverId = getDriverId();
+    bool success = writeValue(file, kDiskCacheMagic)
+            && writeValue(file, kDiskCacheVersion)
+            && writeValue(file, (uint32_t) driverId.size())
+            && fwrite(driverId.data(), 1, driverId.size(), file) == driverId.size()
+            && writeValue(file, (uint32_t) mBinaries.size());
+    for (auto iter = mBinaries.begin(); success && iter != mBinaries.end(); iter++) {
+        const ProgramBinary& binary = iter->second;
+        success = writeValue(file, iter->first)
+                && writeValue(file, binary.useCount)
+                && writeValue(file, binary.hasTexCoords ? kDiskCacheFlagTexCoords : 0u)
+                && writeValue(file, (uint32_t) binary.format)
+                && writeValue(file, (uint32_t) binary.data.size())
+                && fwrite(binary.data.data(), 1, binary.data.size(), file)
+                        == binary.data.size();
+    }
+    success = (fclose(file) == 0) && success;
+    if (success && rename(tempPath.c_str(), path.c_str()) == 0) {
+        mDiskCacheDirty = false;
+    } else {
+        ALOGW("Failed to write program disk cache %s", path.c_str());
+        unlink(tempPath.c_str());
+    }
+}
+
+Program* ProgramCache::loadProgram(programid key, const ProgramBinary& binary) {
+    std::unique_ptr<Program> program(new Program(binary.format, binary.data.data(),
+            binary.data.size(), binary.hasTexCoords));
+    if (!program->isInitialized()) {
+        PROGRAM_LOGD("Driver rejected binary of program 0x%" PRIx64, key);
+        return nullptr;
+    }
+    return program.release();
+}
+
+void ProgramCache::storeProgramBinary(programid key, const Program& program,
+        bool hasTexCoords) {
+    ProgramBinary binary;
+    if (program.getBinary(&binary.format, &binary.data)
+            && binary.data.size() <= kMaxProgramBinarySize) {
+        binary.hasTexCoords = hasTexCoords;
+        binary.usedThisRun = true;
+        mBinaries[key] = std::move(binary);
+        mDiskCacheDirty = true;
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Program generation
 ///////////////////////////////////////////////////////////////////////////////
 
 Program* ProgramCache::generateProgram(const ProgramDescription& description, programid key) {
+    auto binary = mBinaries.find(key);
+    if (binary != mBinaries.end()) {
+        Program* program = loadProgram(key, binary->second);
+        if (program) {
+            binary->second.usedThisRun = true;
+            return program;
+        }
+        mBinaries.erase(binary);
+        mDiskCacheDirty = true;
+    }
+
     String8 vertexShader = generateVertexShader(description);
     String8 fragmentShader = generateFragmentShader(description);
 
-    return new Program(description, vertexShader.string(), fragmentShader.string());
+    Program* program = new Program(description, vertexShader.string(), fragmentShader.string());
+    if (mDiskCacheLoaded) {
+        storeProgramBinary(key, *program,
+                description.hasTexture || description.hasExternalTexture);
+    }
+    return program;
 }
 
 static inline size_t gradientIndex(const ProgramDescription& description) {
@@ -21,6 +21,9 @@
 #include <utils/Log.h>
 #include <utils/String8.h>
 #include <map>
+#include <set>
+#include <string>
+#include <vector>
 
 #include <GLES2/gl2.h>
 
@@ -47,8 +50,37 @@ public:
 
     void clear();
 
+    /**
+     * Sets the file where program binaries are kept between runs of the app.
+     * Must be called before the first GL context is created.
+     */
+    static void setDiskCachePath(const char* path);
+
+    /**
+     * Loads the program binaries saved by previous runs, if any, and links the
+     * programs that were used by the most runs. Called when the GL context is created.
+     */
+    void loadDiskCache();
+
+    /**
+     * Writes the binaries of the programs created since the last save to disk.
+     */
+    void saveDiskCache();
+
 private:
+    struct ProgramBinary {
+        GLenum format = 0;
+        std::vector<uint8_t> data;
+        bool hasTexCoords = false;
+        // Number of runs of the app that used this program, used to pick what to pre-link
+        uint32_t useCount = 0;
+        bool usedThisRun = false;
+    };
+
     Program* generateProgram(const ProgramDescription& description, programid key);
+    Program* loadProgram(programid key, const ProgramBinary& binary);
+    void storeProgramBinary(programid key, const Program& program, bool hasTexCoords);
+    std::string getDriverId() const;
     String8 generateVertexShader(const ProgramDescription& description);
     String8 generateFragmentShader(const ProgramDescription& description);
     void generateBlend(String8& shader, const char* name, SkBlendMode mode);
@@ -57,9 +89,15 @@ private:
     void printLongString(const String8& shader) const;
 
     std::map<programid, std::unique_ptr<Program>> mCache;
+    std::map<programid, ProgramBinary> mBinaries;
+    // Programs linked by loadDiskCache() that weren't asked for yet
+    std::set<programid> mPrewarmed;
+    bool mDiskCacheLoaded = false;
+    bool mDiskCacheDirty = false;
 
     const bool mHasES3;
     const bool mHasLinearBlending;
+    const bool mHasProgramBinary;
 }; // class ProgramCache
 
 }; // namespace uirenderer
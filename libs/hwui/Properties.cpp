@@ -35,6 +35,12 @@ bool Properties::showDirtyRegions = false;
 bool Properties::skipEmptyFrames = true;
 bool Properties::useBufferAge = true;
 bool Properties::enablePartialUpdates = true;
+int Properties::skiaOpCombineWindow = DEFAULT_SKIA_OP_COMBINE_WINDOW;
+bool Properties::diffDisplayLists = false;
+bool Properties::skipStaticSubtrees = true;
+bool Properties::deferOffscreenLayers = true;
+bool Properties::preloadGpuContext = true;
+bool Properties::skpCaptureEnabled = false;
 
 float Properties::textGamma = DEFAULT_TEXT_GAMMA;
 
@@ -49,6 +55,7 @@ int Properties::textDropShadowCacheSize = MB(DEFAULT_DROP_SHADOW_CACHE_SIZE);
 int Properties::textureCacheSize = MB(DEFAULT_TEXTURE_CACHE_SIZE);
 
 float Properties::textureCacheFlushRate = DEFAULT_TEXTURE_CACHE_FLUSH_RATE;
+int Properties::gpuMemoryBudget = MB(DEFAULT_GPU_MEMORY_BUDGET);
 
 DebugLevel Properties::debugLevel = kDebugDisabled;
 OverdrawColorSet Properties::overdrawColorSet = OverdrawColorSet::Default;
@@ -139,6 +146,9 @@ bool Properties::load() {
     drawReorderDisabled = property_get_bool(PROPERTY_DISABLE_DRAW_REORDER, false);
     INIT_LOGD("  Draw reorder %s", drawReorderDisabled ? "disabled" : "enabled");
 
+    skiaOpCombineWindow = drawReorderDisabled ? 1 : std::max(1,
+            property_get_int(PROPERTY_SKIA_OP_COMBINE_WINDOW, DEFAULT_SKIA_OP_COMBINE_WINDOW));
+
     showDirtyRegions = property_get_bool(PROPERTY_DEBUG_SHOW_DIRTY_REGIONS, false);
 
     debugLevel = (DebugLevel) property_get_int(PROPERTY_DEBUG, kDebugDisabled);
@@ -146,6 +156,12 @@ bool Properties::load() {
     skipEmptyFrames = property_get_bool(PROPERTY_SKIP_EMPTY_DAMAGE, true);
     useBufferAge = property_get_bool(PROPERTY_USE_BUFFER_AGE, true);
     enablePartialUpdates = property_get_bool(PROPERTY_ENABLE_PARTIAL_UPDATES, true);
+    diffDisplayLists = property_get_bool(PROPERTY_DIFF_DISPLAY_LISTS, false);
+    skipStaticSubtrees = property_get_bool(PROPERTY_SKIP_STATIC_SUBTREES, true);
+    deferOffscreenLayers = property_get_bool(PROPERTY_DEFER_OFFSCREEN_LAYERS, true);
+    preloadGpuContext = property_get_bool(PROPERTY_PRELOAD_GPU_CONTEXT, true);
+    skpCaptureEnabled = property_get_bool("ro.debuggable", false)
+            && property_get_bool(PROPERTY_CAPTURE_SKP_ENABLED, false);
 
     textGamma = property_get_float(PROPERTY_TEXT_GAMMA, DEFAULT_TEXT_GAMMA);
 
@@ -160,6 +176,7 @@ bool Properties::load() {
     textureCacheSize = MB(property_get_float(PROPERTY_TEXTURE_CACHE_SIZE, DEFAULT_TEXTURE_CACHE_SIZE));
     textureCacheFlushRate = std::max(0.0f, std::min(1.0f,
             property_get_float(PROPERTY_TEXTURE_CACHE_FLUSH_RATE, DEFAULT_TEXTURE_CACHE_FLUSH_RATE)));
+    gpuMemoryBudget = MB(property_get_float(PROPERTY_GPU_MEMORY_BUDGET, DEFAULT_GPU_MEMORY_BUDGET));
 
     filterOutTestOverhead = property_get_bool(PROPERTY_FILTER_TEST_OVERHEAD, false);
 
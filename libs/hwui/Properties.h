@@ -129,6 +129,14 @@ enum DebugLevel {
  */
 #define PROPERTY_DISABLE_DRAW_REORDER "debug.hwui.disable_draw_reorder"
 
+/**
+ * Number of recorded GPU ops the Skia pipelines search before and after each new
+ * op for a compatible, non-overlapping op to merge it with. Only adjacent ops are
+ * merged if PROPERTY_DISABLE_DRAW_REORDER is set to "true".
+ * Default is 32.
+ */
+#define PROPERTY_SKIA_OP_COMBINE_WINDOW "debug.hwui.skia_op_combine_window"
+
 /**
  * Setting this property will enable or disable the dropping of frames with
  * empty damage. Default is "true".
@@ -150,8 +158,58 @@ enum DebugLevel {
  */
 #define PROPERTY_ENABLE_PARTIAL_UPDATES "debug.hwui.use_partial_updates"
 
+/**
+ * Setting this to "true" will make HWUI compare each re-recorded display list with
+ * the one it replaces, and only damage the ops that changed instead of the whole
+ * RenderNode. Only applies to the OpenGL pipeline.
+ * Default is "false"
+ */
+#define PROPERTY_DIFF_DISPLAY_LISTS "debug.hwui.diff_display_lists"
+
+/**
+ * Setting this to "false" will make RenderThread driven animation frames traverse the whole
+ * tree, instead of only the subtrees that contain animators or other RenderThread work.
+ * Default is "true"
+ */
+#define PROPERTY_SKIP_STATIC_SUBTREES "debug.hwui.skip_static_subtrees"
+
+/**
+ * Setting this to "false" will make HWUI update every damaged hardware layer before each
+ * frame, instead of deferring the updates of layers that are entirely off screen until they
+ * come into view or RenderThread is idle.
+ * Default is "true"
+ */
+#define PROPERTY_DEFER_OFFSCREEN_LAYERS "debug.hwui.defer_offscreen_layers"
+
+/**
+ * Setting this to "false" will leave the GPU context to be initialized by the first frame,
+ * instead of doing it in the background as soon as the application is bound.
+ * Default is "true"
+ */
+#define PROPERTY_PRELOAD_GPU_CONTEXT "debug.hwui.preload_gpu_context"
+
 #define PROPERTY_FILTER_TEST_OVERHEAD "debug.hwui.filter_test_overhead"
 
+/**
+ * Allows frames drawn by the Skia pipelines to be captured as SKP files, for
+ * replaying them offline. Only taken into account on debuggable builds.
+ * Default is "false"
+ */
+#define PROPERTY_CAPTURE_SKP_ENABLED "debug.hwui.capture_skp_enabled"
+
+/**
+ * Path of the SKP file to capture. A capture starts when this property is set
+ * and no file exists at that path yet.
+ */
+#define PROPERTY_CAPTURE_SKP_FILENAME "debug.hwui.capture_frame_as_skp"
+
+/**
+ * Number of consecutive frames captured, the first one is written to the
+ * path set by PROPERTY_CAPTURE_SKP_FILENAME and frame N to "<path>_N".
+ * Default is 1
+ */
+#define PROPERTY_CAPTURE_SKP_FRAMES "debug.hwui.capture_skp_frames"
+
 /**
  * Allows to set rendering pipeline mode to OpenGL (default), Skia OpenGL
  * or Vulkan.
@@ -193,6 +251,8 @@ enum DebugLevel {
 #define PROPERTY_PATCH_CACHE_SIZE "ro.hwui.patch_cache_size"
 #define PROPERTY_DROP_SHADOW_CACHE_SIZE "ro.hwui.drop_shadow_cache_size"
 #define PROPERTY_FBO_CACHE_SIZE "ro.hwui.fbo_cache_size"
+// Cap on the sum of all the caches above, 0 means each cache only obeys its own limit
+#define PROPERTY_GPU_MEMORY_BUDGET "ro.hwui.gpu_memory_budget"
 
 // These properties are defined in percentage (range 0..1)
 #define PROPERTY_TEXTURE_CACHE_FLUSH_RATE "ro.hwui.texture_cache_flushrate"
@@ -219,9 +279,12 @@ enum DebugLevel {
 #define DEFAULT_GRADIENT_CACHE_SIZE 0.5f
 #define DEFAULT_DROP_SHADOW_CACHE_SIZE 2.0f
 #define DEFAULT_FBO_CACHE_SIZE 0
+#define DEFAULT_GPU_MEMORY_BUDGET 0.0f
 
 #define DEFAULT_TEXTURE_CACHE_FLUSH_RATE 0.6f
 
+#define DEFAULT_SKIA_OP_COMBINE_WINDOW 32
+
 #define DEFAULT_TEXT_GAMMA 1.45f // Match design tools
 
 // cap to 256 to limite paths in the path cache
@@ -278,6 +341,12 @@ public:
     static bool skipEmptyFrames;
     static bool useBufferAge;
     static bool enablePartialUpdates;
+    static int skiaOpCombineWindow;
+    static bool diffDisplayLists;
+    static bool skipStaticSubtrees;
+    static bool deferOffscreenLayers;
+    static bool preloadGpuContext;
+    static bool skpCaptureEnabled;
 
     static float textGamma;
 
@@ -291,6 +360,7 @@ public:
     static int textDropShadowCacheSize;
     static int textureCacheSize;
     static float textureCacheFlushRate;
+    static int gpuMemoryBudget;
 
     static DebugLevel debugLevel;
     static OverdrawColorSet overdrawColorSet;
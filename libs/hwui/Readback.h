@@ -23,6 +23,7 @@
 #include <gui/Surface.h>
 
 namespace android {
+class Bitmap;
 class GraphicBuffer;
 namespace uirenderer {
 
@@ -45,6 +46,15 @@ public:
             SkBitmap* bitmap) = 0;
     virtual CopyResult copyGraphicBufferInto(GraphicBuffer* graphicBuffer, SkBitmap* bitmap) = 0;
 
+    /**
+     * Copies the surface's most recently queued buffer into a new width x height hardware
+     * bitmap, scaling it on the GPU. The pixels never go through CPU memory and the GPU work
+     * is only flushed, not waited on: drawing the bitmap later on the RenderThread is ordered
+     * after the copy.
+     */
+    virtual CopyResult copySurfaceIntoHardwareBitmap(Surface& surface, const Rect& srcRect,
+            int width, int height, sk_sp<Bitmap>* outBitmap) = 0;
+
 protected:
     explicit Readback(renderthread::RenderThread& thread) : mRenderThread(thread) {}
     virtual ~Readback() {}
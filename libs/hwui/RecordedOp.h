@@ -363,13 +363,17 @@ struct VectorDrawableOp : RecordedOp {
  * State construction handles these properties specially, ignoring matrix/bounds.
  */
 struct ShadowOp : RecordedOp {
-    ShadowOp(sp<TessellationCache::ShadowTask>& shadowTask, float casterAlpha)
+    ShadowOp(sp<TessellationCache::ShadowTask>& shadowTask, float casterAlpha,
+            const Vector2& translation = Vector2())
             : RecordedOp(RecordedOpId::ShadowOp, Rect(), Matrix4::identity(), nullptr, nullptr)
             , shadowTask(shadowTask)
-            , casterAlpha(casterAlpha) {
+            , casterAlpha(casterAlpha)
+            , translation(translation) {
     };
     sp<TessellationCache::ShadowTask> shadowTask;
     const float casterAlpha;
+    // offset of the caster, which isn't part of the (reusable) shadow tessellation
+    const Vector2 translation;
 };
 
 struct SimpleRectsOp : RecordedOp { // Filled, no AA (TODO: better name?)
@@ -19,6 +19,7 @@
 #include "BakedOpRenderer.h"
 #include "DamageAccumulator.h"
 #include "Debug.h"
+#include "DisplayListDiff.h"
 #include "RecordedOp.h"
 #include "TreeInfo.h"
 #include "utils/FatVector.h"
@@ -271,7 +272,11 @@ void RenderNode::pushLayerUpdate(TreeInfo& info) {
 
     SkRect dirty;
     info.damageAccumulator->peekAtDirty(&dirty);
-    info.layerUpdateQueue->enqueueLayerWithDamage(this, dirty);
+    if (CC_LIKELY(Properties::deferOffscreenLayers) && isLayerOffscreen(info)) {
+        info.layerUpdateQueue->deferLayerWithDamage(this, dirty);
+    } else {
+        info.layerUpdateQueue->enqueueLayerWithDamage(this, dirty);
+    }
 
     // There might be prefetched layers that need to be accounted for.
     // That might be us, so tell CanvasContext that this layer is in the
@@ -279,6 +284,19 @@ void RenderNode::pushLayerUpdate(TreeInfo& info) {
     info.canvasContext.markLayerInUse(this);
 }
 
+bool RenderNode::isLayerOffscreen(const TreeInfo& info) const {
+    if (info.windowWidth <= 0 || info.windowHeight <= 0) return false;
+
+    Matrix4 transform;
+    info.damageAccumulator->computeCurrentTransform(&transform);
+    // Projected bounds can't be mapped reliably, assume they are visible
+    if (transform.isPerspective()) return false;
+
+    Rect bounds(getWidth(), getHeight());
+    transform.mapRect(bounds);
+    return !bounds.intersects(0, 0, info.windowWidth, info.windowHeight);
+}
+
 /**
  * Traverse down the the draw tree to prepare for a frame.
  *
@@ -286,8 +304,20 @@ void RenderNode::pushLayerUpdate(TreeInfo& info) {
  *
  * While traversing down the tree, functorsNeedLayer flag is set to true if anything that uses the
  * stencil buffer may be needed. Views that use a functor to draw will be forced onto a layer.
+ *
+ * The traversal has to stay on the RenderThread: besides the DamageAccumulator stack it runs
+ * animators against the shared AnimationContext, calls position listeners into Java, creates
+ * layers and pins images through the CanvasContext and hands removed display lists back to it.
  */
 void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
+    if (info.mode == TreeInfo::MODE_RT_ONLY && !mNeedsRtOnlyPrepare
+            && CC_LIKELY(Properties::skipStaticSubtrees)) {
+        // Nothing in here can have changed since the last traversal, so there is no
+        // damage to report
+        info.hasBackwardProjectedNodes = mHasBackwardProjectedNodes;
+        return;
+    }
+
     info.damageAccumulator->pushTransform(this);
 
     if (info.mode == TreeInfo::MODE_FULL) {
@@ -316,11 +346,14 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
         pushStagingDisplayListChanges(observer, info);
     }
 
+    bool childrenNeedRtOnlyPrepare = false;
     if (mDisplayList) {
         info.out.hasFunctors |= mDisplayList->hasFunctor();
         bool isDirty = mDisplayList->prepareListAndChildren(observer, info, childFunctorsNeedLayer,
-                [](RenderNode* child, TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
+                [&childrenNeedRtOnlyPrepare](RenderNode* child, TreeObserver& observer,
+                        TreeInfo& info, bool functorsNeedLayer) {
             child->prepareTreeImpl(observer, info, functorsNeedLayer);
+            childrenNeedRtOnlyPrepare |= child->mNeedsRtOnlyPrepare;
         });
         if (isDirty) {
             damageSelf(info);
@@ -328,6 +361,13 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
     }
     pushLayerUpdate(info);
 
+    mNeedsRtOnlyPrepare = childrenNeedRtOnlyPrepare
+            || mAnimatorManager.hasAnimators()
+            || mPositionListener.get()
+            || hasLayer()
+            || (mDisplayList && (mDisplayList->hasFunctor() || mDisplayList->hasVectorDrawables()));
+    mHasBackwardProjectedNodes = info.hasBackwardProjectedNodes;
+
     info.damageAccumulator->popTransform();
 }
 
@@ -376,6 +416,21 @@ void RenderNode::syncDisplayList(TreeObserver& observer, TreeInfo* info) {
 void RenderNode::pushStagingDisplayListChanges(TreeObserver& observer, TreeInfo& info) {
     if (mNeedsDisplayListSync) {
         mNeedsDisplayListSync = false;
+        Rect damage;
+        if (CC_UNLIKELY(Properties::diffDisplayLists)
+                && isRenderable() && mStagingDisplayList && !mStagingDisplayList->isEmpty()
+                && DisplayListDiff::computeDamage(*mDisplayList, *mStagingDisplayList, &damage)) {
+            // Only the ops that changed need to be redrawn
+            syncDisplayList(observer, &info);
+            if (properties().getClipDamageToBounds()) {
+                damage.doIntersect(0, 0, properties().getWidth(), properties().getHeight());
+            }
+            if (!damage.isEmpty()) {
+                info.damageAccumulator->dirty(damage.left, damage.top,
+                        damage.right, damage.bottom);
+            }
+            return;
+        }
         // Damage with the old display list first then the new one to catch any
         // changes in isRenderable or, in the future, bounds
         damageSelf(info);
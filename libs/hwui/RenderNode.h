@@ -263,6 +263,7 @@ private:
     void pushStagingDisplayListChanges(TreeObserver& observer, TreeInfo& info);
     void prepareLayer(TreeInfo& info, uint32_t dirtyMask);
     void pushLayerUpdate(TreeInfo& info);
+    bool isLayerOffscreen(const TreeInfo& info) const;
     void deleteDisplayList(TreeObserver& observer, TreeInfo* info = nullptr);
     void damageSelf(TreeInfo& info);
 
@@ -288,6 +289,13 @@ private:
     friend class AnimatorManager;
     AnimatorManager mAnimatorManager;
 
+    // Set by the last traversal if this subtree has work that RenderThread-only traversals
+    // must do: animators, position listeners, functors, vector drawables or layers. Anything
+    // else in the subtree can only change with a sync from the UI thread.
+    bool mNeedsRtOnlyPrepare = true;
+    // Whether the last traversal found backward projected nodes in this subtree
+    bool mHasBackwardProjectedNodes = false;
+
     // Owned by RT. Lifecycle is managed by prepareTree(), with the exception
     // being in ~RenderNode() which may happen on any thread.
     OffscreenBuffer* mLayer = nullptr;
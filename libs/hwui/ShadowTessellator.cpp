@@ -25,6 +25,14 @@
 #include "SpotShadow.h"
 #include "Vector.h"
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define SHADOW_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SHADOW_USE_SSE2
+#endif
+
 namespace android {
 namespace uirenderer {
 
@@ -161,6 +169,56 @@ Vector2 ShadowTessellator::calculateNormal(const Vector2& p1, const Vector2& p2)
     return result;
 }
 
+void ShadowTessellator::calculateNormals(const Vector2* points, int count, Vector2* normals) {
+    const float* coords = reinterpret_cast<const float*>(points);
+    float* outNormals = reinterpret_cast<float*>(normals);
+
+    // Same operations as calculateNormal(), which SIMD sqrt and division reproduce exactly.
+    // Zero length edges keep a zero normal.
+    int i = 0;
+#if defined(SHADOW_USE_NEON)
+    for (; i + 5 <= count; i += 4) {
+        float32x4x2_t current = vld2q_f32(coords + 2 * i);
+        float32x4x2_t next = vld2q_f32(coords + 2 * (i + 1));
+        float32x4_t dx = vsubq_f32(next.val[0], current.val[0]);
+        float32x4_t dy = vsubq_f32(next.val[1], current.val[1]);
+        float32x4_t length = vsqrtq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)));
+        float32x4_t scale = vdivq_f32(vdupq_n_f32(1.0f), length);
+        uint32x4_t isZero = vandq_u32(vceqq_f32(dx, vdupq_n_f32(0)),
+                vceqq_f32(dy, vdupq_n_f32(0)));
+        float32x4x2_t normal = {{
+                vbslq_f32(isZero, dx, vnegq_f32(vmulq_f32(dy, scale))),
+                vbslq_f32(isZero, dy, vmulq_f32(dx, scale)) }};
+        vst2q_f32(outNormals + 2 * i, normal);
+    }
+#elif defined(SHADOW_USE_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+    for (; i + 5 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(coords + 2 * i);
+        __m128 b = _mm_loadu_ps(coords + 2 * i + 4);
+        __m128 c = _mm_loadu_ps(coords + 2 * i + 2);
+        __m128 d = _mm_loadu_ps(coords + 2 * i + 6);
+        __m128 dx = _mm_sub_ps(_mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128 dy = _mm_sub_ps(_mm_shuffle_ps(c, d, _MM_SHUFFLE(3, 1, 3, 1)),
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), length);
+        __m128 isZero = _mm_and_ps(_mm_cmpeq_ps(dx, zero), _mm_cmpeq_ps(dy, zero));
+        __m128 nx = _mm_xor_ps(_mm_mul_ps(dy, scale), signMask);
+        __m128 ny = _mm_mul_ps(dx, scale);
+        nx = _mm_or_ps(_mm_and_ps(isZero, dx), _mm_andnot_ps(isZero, nx));
+        ny = _mm_or_ps(_mm_and_ps(isZero, dy), _mm_andnot_ps(isZero, ny));
+        _mm_storeu_ps(outNormals + 2 * i, _mm_unpacklo_ps(nx, ny));
+        _mm_storeu_ps(outNormals + 2 * i + 4, _mm_unpackhi_ps(nx, ny));
+    }
+#endif
+    for (; i < count; i++) {
+        normals[i] = calculateNormal(points[i], points[i + 1 >= count ? 0 : i + 1]);
+    }
+}
+
 int ShadowTessellator::getExtraVertexNumber(const Vector2& vector1,
         const Vector2& vector2, float divisor) {
     // When there is no distance difference, there is no need for extra vertices.
@@ -82,6 +82,12 @@ public:
 
     static Vector2 calculateNormal(const Vector2& p1, const Vector2& p2);
 
+    /**
+     * Fills normals with calculateNormal(points[i], points[(i + 1) % count]) for every edge of
+     * the polygon, several edges at a time where SIMD is available.
+     */
+    static void calculateNormals(const Vector2* points, int count, Vector2* normals);
+
     static int getExtraVertexNumber(const Vector2& vector1, const Vector2& vector2,
             float divisor);
 
@@ -57,6 +57,14 @@
 #include <stdlib.h>
 #include <utils/Log.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define SHADOW_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SHADOW_USE_SSE2
+#endif
+
 // TODO: After we settle down the new algorithm, we can remove the old one and
 // its utility functions.
 // Right now, we still need to keep it for comparison purpose and future expansion.
@@ -65,18 +73,6 @@ namespace uirenderer {
 
 static const float EPSILON = 1e-7;
 
-/**
- * For each polygon's vertex, the light center will project it to the receiver
- * as one of the outline vertex.
- * For each outline vertex, we need to store the position and normal.
- * Normal here is defined against the edge by the current vertex and the next vertex.
- */
-struct OutlineData {
-    Vector2 position;
-    Vector2 normal;
-    float radius;
-};
-
 /**
  * For each vertex, we need to keep track of its angle, whether it is penumbra or
  * umbra, and its corresponding vertex index.
@@ -361,6 +357,127 @@ float SpotShadow::projectCasterToOutline(Vector2& outline,
     return ratioZ;
 }
 
+/**
+ * Projects every vertex of the polygon with projectCasterToOutline(), four vertices at a time
+ * where SIMD is available, and fills radius with the resulting outline radius of each vertex.
+ */
+void SpotShadow::projectCasterToOutlines(const Vector3& lightCenter, float lightSize,
+        const Vector3* poly, int polyLength, Vector2* outline, float* radius) {
+    int i = 0;
+#if defined(SHADOW_USE_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t cap = vdupq_n_f32(CASTER_Z_CAP_RATIO);
+    for (; i + 4 <= polyLength; i += 4) {
+        float32x4x3_t v = vld3q_f32(&poly[i].x);
+        float32x4_t lightToPolyZ = vsubq_f32(vdupq_n_f32(lightCenter.z), v.val[2]);
+        float32x4_t ratioZ = vminq_f32(vmaxq_f32(vdivq_f32(v.val[2], lightToPolyZ), zero), cap);
+        ratioZ = vbslq_f32(vceqq_f32(lightToPolyZ, zero), cap, ratioZ);
+        float32x4x2_t position = {{
+                vsubq_f32(v.val[0], vmulq_f32(ratioZ,
+                        vsubq_f32(vdupq_n_f32(lightCenter.x), v.val[0]))),
+                vsubq_f32(v.val[1], vmulq_f32(ratioZ,
+                        vsubq_f32(vdupq_n_f32(lightCenter.y), v.val[1]))) }};
+        vst2q_f32(&outline[i].x, position);
+        vst1q_f32(radius + i, vmulq_f32(ratioZ, vdupq_n_f32(lightSize)));
+    }
+#elif defined(SHADOW_USE_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 cap = _mm_set1_ps(CASTER_Z_CAP_RATIO);
+    for (; i + 4 <= polyLength; i += 4) {
+        __m128 x = _mm_setr_ps(poly[i].x, poly[i + 1].x, poly[i + 2].x, poly[i + 3].x);
+        __m128 y = _mm_setr_ps(poly[i].y, poly[i + 1].y, poly[i + 2].y, poly[i + 3].y);
+        __m128 z = _mm_setr_ps(poly[i].z, poly[i + 1].z, poly[i + 2].z, poly[i + 3].z);
+        __m128 lightToPolyZ = _mm_sub_ps(_mm_set1_ps(lightCenter.z), z);
+        // operand order matches MathUtils::clamp() for NaN
+        __m128 ratioZ = _mm_min_ps(cap, _mm_max_ps(zero, _mm_div_ps(z, lightToPolyZ)));
+        __m128 isZero = _mm_cmpeq_ps(lightToPolyZ, zero);
+        ratioZ = _mm_or_ps(_mm_and_ps(isZero, cap), _mm_andnot_ps(isZero, ratioZ));
+        __m128 outlineX = _mm_sub_ps(x,
+                _mm_mul_ps(ratioZ, _mm_sub_ps(_mm_set1_ps(lightCenter.x), x)));
+        __m128 outlineY = _mm_sub_ps(y,
+                _mm_mul_ps(ratioZ, _mm_sub_ps(_mm_set1_ps(lightCenter.y), y)));
+        _mm_storeu_ps(&outline[i].x, _mm_unpacklo_ps(outlineX, outlineY));
+        _mm_storeu_ps(&outline[i + 2].x, _mm_unpackhi_ps(outlineX, outlineY));
+        _mm_storeu_ps(radius + i, _mm_mul_ps(ratioZ, _mm_set1_ps(lightSize)));
+    }
+#endif
+    for (; i < polyLength; i++) {
+        radius[i] = projectCasterToOutline(outline[i], lightCenter, poly[i]) * lightSize;
+    }
+}
+
+/**
+ * Computes the umbra from the outline's centroid. See createSpotShadow() for the details.
+ *
+ * @return false if the outline has 0 area, in which case there is no spot shadow.
+ */
+static bool computeUmbra(const Vector2* outline, const float* radius, int length,
+        const Vector2& centroid, Vector2* umbra, float* outMinRatioVI) {
+    const float maxRatioVI = 1 - FAKE_UMBRA_SIZE_RATIO;
+    float minRatioVI = FLT_MAX;
+    int i = 0;
+#if defined(SHADOW_USE_NEON)
+    float32x4_t minRatios = vdupq_n_f32(FLT_MAX);
+    for (; i + 4 <= length; i += 4) {
+        float32x4x2_t position = vld2q_f32(&outline[i].x);
+        float32x4_t dx = vsubq_f32(position.val[0], vdupq_n_f32(centroid.x));
+        float32x4_t dy = vsubq_f32(position.val[1], vdupq_n_f32(centroid.y));
+        float32x4_t distOutline = vsqrtq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)));
+        if (vmaxvq_u32(vceqq_f32(distOutline, vdupq_n_f32(0.0f)))) return false;
+        float32x4_t ratioVI = vdivq_f32(vld1q_f32(radius + i), distOutline);
+        minRatios = vminq_f32(ratioVI, minRatios);
+        ratioVI = vminq_f32(ratioVI, vdupq_n_f32(maxRatioVI));
+        float32x4_t ratioIC = vsubq_f32(vdupq_n_f32(1.0f), ratioVI);
+        float32x4x2_t result = {{
+                vaddq_f32(vmulq_f32(position.val[0], ratioIC),
+                        vmulq_f32(vdupq_n_f32(centroid.x), ratioVI)),
+                vaddq_f32(vmulq_f32(position.val[1], ratioIC),
+                        vmulq_f32(vdupq_n_f32(centroid.y), ratioVI)) }};
+        vst2q_f32(&umbra[i].x, result);
+    }
+    minRatioVI = vminvq_f32(minRatios);
+#elif defined(SHADOW_USE_SSE2)
+    __m128 minRatios = _mm_set1_ps(FLT_MAX);
+    for (; i + 4 <= length; i += 4) {
+        __m128 a = _mm_loadu_ps(&outline[i].x);
+        __m128 b = _mm_loadu_ps(&outline[i + 2].x);
+        __m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 dx = _mm_sub_ps(x, _mm_set1_ps(centroid.x));
+        __m128 dy = _mm_sub_ps(y, _mm_set1_ps(centroid.y));
+        __m128 distOutline = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        if (_mm_movemask_ps(_mm_cmpeq_ps(distOutline, _mm_setzero_ps()))) return false;
+        __m128 ratioVI = _mm_div_ps(_mm_loadu_ps(radius + i), distOutline);
+        minRatios = _mm_min_ps(ratioVI, minRatios);
+        ratioVI = _mm_min_ps(_mm_set1_ps(maxRatioVI), ratioVI);
+        __m128 ratioIC = _mm_sub_ps(_mm_set1_ps(1.0f), ratioVI);
+        __m128 umbraX = _mm_add_ps(_mm_mul_ps(x, ratioIC),
+                _mm_mul_ps(_mm_set1_ps(centroid.x), ratioVI));
+        __m128 umbraY = _mm_add_ps(_mm_mul_ps(y, ratioIC),
+                _mm_mul_ps(_mm_set1_ps(centroid.y), ratioVI));
+        _mm_storeu_ps(&umbra[i].x, _mm_unpacklo_ps(umbraX, umbraY));
+        _mm_storeu_ps(&umbra[i + 2].x, _mm_unpackhi_ps(umbraX, umbraY));
+    }
+    float ratios[4];
+    _mm_storeu_ps(ratios, minRatios);
+    minRatioVI = std::min(std::min(ratios[0], ratios[1]), std::min(ratios[2], ratios[3]));
+#endif
+    for (; i < length; i++) {
+        float distOutline = (outline[i] - centroid).length();
+        if (CC_UNLIKELY(distOutline == 0)) return false;
+
+        float ratioVI = radius[i] / distOutline;
+        minRatioVI = std::min(minRatioVI, ratioVI);
+        if (ratioVI >= maxRatioVI) {
+            ratioVI = maxRatioVI;
+        }
+        float ratioIC = 1 - ratioVI;
+        umbra[i] = outline[i] * ratioIC + centroid * ratioVI;
+    }
+    *outMinRatioVI = minRatioVI;
+    return true;
+}
+
 /**
  * Generate the shadow spot light of shape lightPoly and a object poly
  *
@@ -385,7 +502,13 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
 #endif
         return;
     }
-    OutlineData outlineData[polyLength];
+    // For each polygon's vertex, the light center will project it to the receiver
+    // as one of the outline vertex.
+    // For each outline vertex, we need to store the position, radius and normal.
+    // Normal here is defined against the edge by the current vertex and the next vertex.
+    Vector2 outline[polyLength];
+    float outlineRadius[polyLength];
+    Vector2 outlineNormal[polyLength];
     Vector2 outlineCentroid;
     // Calculate the projected outline for each polygon's vertices from the light center.
     //
@@ -400,30 +523,48 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
     // Ratio = (Poly - Outline) / (Light - Poly)
     // Outline.x = Poly.x - Ratio * (Light.x - Poly.x)
     // Outline's radius / Light's radius = Ratio
-
-    // Compute the last outline vertex to make sure we can get the normal and outline
-    // in one single loop.
-    projectCasterToOutline(outlineData[polyLength - 1].position, lightCenter,
-            poly[polyLength - 1]);
+    projectCasterToOutlines(lightCenter, lightSize, poly, polyLength, outline, outlineRadius);
 
     // Take the outline's polygon, calculate the normal for each outline edge.
-    int currentNormalIndex = polyLength - 1;
-    int nextNormalIndex = 0;
-
-    for (int i = 0; i < polyLength; i++) {
-        float ratioZ = projectCasterToOutline(outlineData[i].position,
-                lightCenter, poly[i]);
-        outlineData[i].radius = ratioZ * lightSize;
-
-        outlineData[currentNormalIndex].normal = ShadowTessellator::calculateNormal(
-                outlineData[currentNormalIndex].position,
-                outlineData[nextNormalIndex].position);
-        currentNormalIndex = (currentNormalIndex + 1) % polyLength;
-        nextNormalIndex++;
-    }
+    ShadowTessellator::calculateNormals(outline, polyLength, outlineNormal);
 
     projectCasterToOutline(outlineCentroid, lightCenter, polyCentroid);
 
+    // Compute the umbra by the intersection from the outline's centroid!
+    //
+    //       (V) ------------------------------------
+    //           |          '                       |
+    //           |         '                        |
+    //           |       ' (I)                      |
+    //           |    '                             |
+    //           | '             (C)                |
+    //           |                                  |
+    //           |                                  |
+    //           |                                  |
+    //           |                                  |
+    //           ------------------------------------
+    //
+    // Connect a line b/t the outline vertex (V) and the centroid (C), it will
+    // intersect with the outline vertex's circle at point (I).
+    // Now, ratioVI = VI / VC, ratioIC = IC / VC
+    // Then the intersetion point can be computed as Ixy = Vxy * ratioIC + Cxy * ratioVI;
+    //
+    // When all of the outline circles cover the the outline centroid, (like I is
+    // on the other side of C), there is no real umbra any more, so we just fake
+    // a small area around the centroid as the umbra, and tune down the spot
+    // shadow's umbra strength to simulate the effect the whole shadow will
+    // become lighter in this case.
+    // The ratio can be simulated by using the inverse of maximum of ratioVI for
+    // all (V).
+    Vector2 umbra[polyLength];
+    // We need the minimal of RaitoVI to decrease the spot shadow strength accordingly.
+    float minRaitoVI = FLT_MAX;
+    if (!computeUmbra(outline, outlineRadius, polyLength, outlineCentroid, umbra, &minRaitoVI)) {
+        // If the outline has 0 area, then there is no spot shadow anyway.
+        ALOGW("Outline has 0 area, no spot shadow!");
+        return;
+    }
+
     int penumbraIndex = 0;
     // Then each polygon's vertex produce at minmal 2 penumbra vertices.
     // Since the size can be dynamic here, we keep track of the size and update
@@ -432,14 +573,6 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
     Vector2 penumbra[allocatedPenumbraLength];
     int totalExtraCornerSliceNumber = 0;
 
-    Vector2 umbra[polyLength];
-
-    // When centroid is covered by all circles from outline, then we consider
-    // the umbra is invalid, and we will tune down the shadow strength.
-    bool hasValidUmbra = true;
-    // We need the minimal of RaitoVI to decrease the spot shadow strength accordingly.
-    float minRaitoVI = FLT_MAX;
-
     for (int i = 0; i < polyLength; i++) {
         // Generate all the penumbra's vertices only using the (outline vertex + normal * radius)
         // There is no guarantee that the penumbra is still convex, but for
@@ -465,8 +598,8 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
         //       (V3)-----------------------------------(V2)
         int preNormalIndex = (i + polyLength - 1) % polyLength;
 
-        const Vector2& previousNormal = outlineData[preNormalIndex].normal;
-        const Vector2& currentNormal = outlineData[i].normal;
+        const Vector2& previousNormal = outlineNormal[preNormalIndex];
+        const Vector2& currentNormal = outlineNormal[i];
 
         // Depending on how roundness we want for each corner, we can subdivide
         // further here and/or introduce some heuristic to decide how much the
@@ -489,64 +622,20 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
                     (previousNormal * (currentCornerSliceNumber - k) + currentNormal * k) /
                     currentCornerSliceNumber;
             avgNormal.normalize();
-            penumbra[penumbraIndex++] = outlineData[i].position +
-                    avgNormal * outlineData[i].radius;
-        }
-
-
-        // Compute the umbra by the intersection from the outline's centroid!
-        //
-        //       (V) ------------------------------------
-        //           |          '                       |
-        //           |         '                        |
-        //           |       ' (I)                      |
-        //           |    '                             |
-        //           | '             (C)                |
-        //           |                                  |
-        //           |                                  |
-        //           |                                  |
-        //           |                                  |
-        //           ------------------------------------
-        //
-        // Connect a line b/t the outline vertex (V) and the centroid (C), it will
-        // intersect with the outline vertex's circle at point (I).
-        // Now, ratioVI = VI / VC, ratioIC = IC / VC
-        // Then the intersetion point can be computed as Ixy = Vxy * ratioIC + Cxy * ratioVI;
-        //
-        // When all of the outline circles cover the the outline centroid, (like I is
-        // on the other side of C), there is no real umbra any more, so we just fake
-        // a small area around the centroid as the umbra, and tune down the spot
-        // shadow's umbra strength to simulate the effect the whole shadow will
-        // become lighter in this case.
-        // The ratio can be simulated by using the inverse of maximum of ratioVI for
-        // all (V).
-        float distOutline = (outlineData[i].position - outlineCentroid).length();
-        if (CC_UNLIKELY(distOutline == 0)) {
-            // If the outline has 0 area, then there is no spot shadow anyway.
-            ALOGW("Outline has 0 area, no spot shadow!");
-            return;
-        }
-
-        float ratioVI = outlineData[i].radius / distOutline;
-        minRaitoVI = std::min(minRaitoVI, ratioVI);
-        if (ratioVI >= (1 - FAKE_UMBRA_SIZE_RATIO)) {
-            ratioVI = (1 - FAKE_UMBRA_SIZE_RATIO);
+            penumbra[penumbraIndex++] = outline[i] + avgNormal * outlineRadius[i];
         }
-        // When we know we don't have valid umbra, don't bother to compute the
-        // values below. But we can't skip the loop yet since we want to know the
-        // maximum ratio.
-        float ratioIC = 1 - ratioVI;
-        umbra[i] = outlineData[i].position * ratioIC + outlineCentroid * ratioVI;
     }
 
-    hasValidUmbra = (minRaitoVI <= 1.0);
+    // When centroid is covered by all circles from outline, then we consider
+    // the umbra is invalid, and we will tune down the shadow strength.
+    bool hasValidUmbra = (minRaitoVI <= 1.0);
     float shadowStrengthScale = 1.0;
     if (!hasValidUmbra) {
 #if DEBUG_SHADOW
         ALOGW("The object is too close to the light or too small, no real umbra!");
 #endif
         for (int i = 0; i < polyLength; i++) {
-            umbra[i] = outlineData[i].position * FAKE_UMBRA_SIZE_RATIO +
+            umbra[i] = outline[i] * FAKE_UMBRA_SIZE_RATIO +
                     outlineCentroid * (1 - FAKE_UMBRA_SIZE_RATIO);
         }
         shadowStrengthScale = 1.0 / minRaitoVI;
@@ -36,6 +36,8 @@ private:
 
     static float projectCasterToOutline(Vector2& outline,
             const Vector3& lightCenter, const Vector3& polyVertex);
+    static void projectCasterToOutlines(const Vector3& lightCenter, float lightSize,
+            const Vector3* poly, int polyLength, Vector2* outline, float* radius);
 
     static void computeLightPolygon(int points, const Vector3& lightCenter,
             float size, Vector3* ret);
@@ -95,24 +95,41 @@ void TessellationCache::Description::setupMatrixAndPaint(Matrix4* matrix, SkPain
 }
 
 TessellationCache::ShadowDescription::ShadowDescription()
-        : nodeKey(nullptr) {
-    memset(&matrixData, 0, sizeof(matrixData));
+        : pathGenerationId(0)
+        , lightRadius(0)
+        , opaque(false) {
+    memset(&matrixXY, 0, sizeof(matrixXY));
+    memset(&matrixZ, 0, sizeof(matrixZ));
 }
 
-TessellationCache::ShadowDescription::ShadowDescription(const SkPath* nodeKey, const Matrix4* drawTransform)
-        : nodeKey(nodeKey) {
-    memcpy(&matrixData, drawTransform->data, sizeof(matrixData));
+TessellationCache::ShadowDescription::ShadowDescription(const SkPath* casterPerimeter,
+        const Matrix4& transformXY, const Matrix4& transformZ, float lightRadius, bool opaque)
+        : pathGenerationId(casterPerimeter->getGenerationID())
+        , lightRadius(lightRadius)
+        , opaque(opaque) {
+    memcpy(&matrixXY, transformXY.data, sizeof(matrixXY));
+    // only the elements used by Matrix4::mapZ() affect the tessellation
+    matrixZ[0] = transformZ.data[2];
+    matrixZ[1] = transformZ.data[6];
+    matrixZ[2] = transformZ.data[Matrix4::kScaleZ];
+    matrixZ[3] = transformZ.data[Matrix4::kTranslateZ];
 }
 
 bool TessellationCache::ShadowDescription::operator==(
         const TessellationCache::ShadowDescription& rhs) const {
-    return nodeKey == rhs.nodeKey
-            && memcmp(&matrixData, &rhs.matrixData, sizeof(matrixData)) == 0;
+    return pathGenerationId == rhs.pathGenerationId
+            && lightRadius == rhs.lightRadius
+            && opaque == rhs.opaque
+            && memcmp(&matrixXY, &rhs.matrixXY, sizeof(matrixXY)) == 0
+            && memcmp(&matrixZ, &rhs.matrixZ, sizeof(matrixZ)) == 0;
 }
 
 hash_t TessellationCache::ShadowDescription::hash() const {
-    uint32_t hash = JenkinsHashMixBytes(0, (uint8_t*) &nodeKey, sizeof(const void*));
-    hash = JenkinsHashMixBytes(hash, (uint8_t*) &matrixData, sizeof(matrixData));
+    uint32_t hash = JenkinsHashMix(0, pathGenerationId);
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) &matrixXY, sizeof(matrixXY));
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) &matrixZ, sizeof(matrixZ));
+    hash = JenkinsHashMix(hash, android::hash_type(lightRadius));
+    hash = JenkinsHashMix(hash, opaque);
     return JenkinsHashWhiten(hash);
 }
 
@@ -292,7 +309,7 @@ public:
 TessellationCache::TessellationCache()
         : mMaxSize(Properties::tessellationCacheSize)
         , mCache(LruCache<Description, Buffer*>::kUnlimitedCapacity)
-        , mShadowCache(LruCache<ShadowDescription, Task<vertexBuffer_pair_t*>*>::kUnlimitedCapacity) {
+        , mShadowCache(kMaxShadowEntries) {
     mCache.setOnEntryRemovedListener(&mBufferRemovedListener);
     mShadowCache.setOnEntryRemovedListener(&mBufferPairRemovedListener);
     mDebugEnabled = Properties::debugLevel & kDebugCaches;
@@ -330,7 +347,6 @@ void TessellationCache::trim() {
         size -= mCache.peekOldestValue()->getSize();
         mCache.removeOldest();
     }
-    mShadowCache.clear();
 }
 
 void TessellationCache::clear() {
@@ -351,37 +367,77 @@ void TessellationCache::BufferRemovedListener::operator()(Description& descripti
 // Shadows
 ///////////////////////////////////////////////////////////////////////////////
 
-void TessellationCache::precacheShadows(const Matrix4* drawTransform, const Rect& localClip,
-        bool opaque, const SkPath* casterPerimeter,
-        const Matrix4* transformXY, const Matrix4* transformZ,
-        const Vector3& lightCenter, float lightRadius) {
-    ShadowDescription key(casterPerimeter, drawTransform);
-
-    if (mShadowCache.get(key)) return;
-    sp<ShadowTask> task = new ShadowTask(drawTransform, localClip, opaque,
-            casterPerimeter, transformXY, transformZ, lightCenter, lightRadius);
-    if (mShadowProcessor == nullptr) {
-        mShadowProcessor = new ShadowProcessor(Caches::getInstance());
-    }
-    mShadowProcessor->add(task);
-    task->incStrong(nullptr); // not using sp<>s, so manually ref while in the cache
-    mShadowCache.put(key, task.get());
+// Casters translated by no more than this (in pixels) relative to the light reuse their shadow
+static const float kShadowLightShiftTolerance = 0.5f;
+
+// Returns the largest Z of the caster, used to estimate how far its spot shadow moves with the
+// light
+static float getMaxCasterZ(const SkPath* casterPerimeter, const Matrix4& transformZ) {
+    const SkRect& bounds = casterPerimeter->getBounds();
+    float maxZ = SHADOW_MIN_CASTER_Z;
+    maxZ = std::max(maxZ, transformZ.mapZ((Vector3) {bounds.fLeft, bounds.fTop, 0}));
+    maxZ = std::max(maxZ, transformZ.mapZ((Vector3) {bounds.fRight, bounds.fTop, 0}));
+    maxZ = std::max(maxZ, transformZ.mapZ((Vector3) {bounds.fLeft, bounds.fBottom, 0}));
+    maxZ = std::max(maxZ, transformZ.mapZ((Vector3) {bounds.fRight, bounds.fBottom, 0}));
+    return maxZ;
 }
 
 sp<TessellationCache::ShadowTask> TessellationCache::getShadowTask(
-        const Matrix4* drawTransform, const Rect& localClip,
-        bool opaque, const SkPath* casterPerimeter,
+        const Matrix4* drawTransform, bool opaque, const SkPath* casterPerimeter,
         const Matrix4* transformXY, const Matrix4* transformZ,
-        const Vector3& lightCenter, float lightRadius) {
-    ShadowDescription key(casterPerimeter, drawTransform);
+        const Vector3& lightCenter, float lightRadius, Vector2* outTranslation) {
+    // Strip the XY translation of the caster, so the tessellation only depends on its shape.
+    // Since the receiver is translated by the same amount, the light moves the opposite way.
+    const float translateX = transformXY->data[Matrix4::kTranslateX];
+    const float translateY = transformXY->data[Matrix4::kTranslateY];
+    Matrix4 untranslate;
+    untranslate.loadTranslate(-translateX, -translateY, 0);
+    Matrix4 casterTransformXY;
+    casterTransformXY.loadMultiply(untranslate, *transformXY);
+    Matrix4 casterTransformZ;
+    casterTransformZ.loadMultiply(untranslate, *transformZ);
+    Matrix4 receiverTransform(*drawTransform);
+    receiverTransform.translate(translateX, translateY);
+
+    Matrix4 inverseReceiver;
+    inverseReceiver.loadInverse(receiverTransform);
+    Vector3 localLightCenter(lightCenter);
+    inverseReceiver.mapPoint3d(localLightCenter);
+
+    outTranslation->x = translateX;
+    outTranslation->y = translateY;
+
+    ShadowDescription key(casterPerimeter, casterTransformXY, casterTransformZ,
+            lightRadius, opaque);
     ShadowTask* task = static_cast<ShadowTask*>(mShadowCache.get(key));
-    if (!task) {
-        precacheShadows(drawTransform, localClip, opaque, casterPerimeter,
-                transformXY, transformZ, lightCenter, lightRadius);
-        task = static_cast<ShadowTask*>(mShadowCache.get(key));
+    if (task) {
+        // The spot shadow shifts by (light shift * z / (lightZ - z)), reuse it until that moves
+        // the shadow by a noticeable amount.
+        const float casterZ = getMaxCasterZ(casterPerimeter, casterTransformZ);
+        const float lightZ = std::min(localLightCenter.z, task->localLightCenter.z);
+        Vector2 lightShift = {localLightCenter.x - task->localLightCenter.x,
+                localLightCenter.y - task->localLightCenter.y};
+        if (localLightCenter.z == task->localLightCenter.z
+                && lightZ > casterZ
+                && lightShift.length() * casterZ < kShadowLightShiftTolerance * (lightZ - casterZ)) {
+            return task;
+        }
+        mShadowCache.remove(key);
+    }
+
+    // Rejecting against the current clip would make the shadow unusable in later frames, so the
+    // whole shadow is tessellated, and clipped when drawn.
+    const Rect unclipped(-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX);
+    sp<ShadowTask> newTask = new ShadowTask(&receiverTransform, unclipped, opaque,
+            casterPerimeter, &casterTransformXY, &casterTransformZ, lightCenter, lightRadius,
+            localLightCenter);
+    if (mShadowProcessor == nullptr) {
+        mShadowProcessor = new ShadowProcessor(Caches::getInstance());
     }
-    LOG_ALWAYS_FATAL_IF(task == nullptr, "shadow not precached");
-    return task;
+    mShadowProcessor->add(newTask);
+    newTask->incStrong(nullptr); // not using sp<>s, so manually ref while in the cache
+    mShadowCache.put(key, newTask.get());
+    return newTask;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
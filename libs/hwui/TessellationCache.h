@@ -78,20 +78,30 @@ public:
         void setupMatrixAndPaint(Matrix4* matrix, SkPaint* paint) const;
     };
 
+    /**
+     * Shadows are keyed on the caster's geometry rather than on where it is drawn: the XY
+     * translation of the caster is stripped from the key (and from the tessellated vertices),
+     * and applied back as a draw offset, so a caster that only moves - such as while scrolling -
+     * reuses its shadow across frames.
+     */
     struct ShadowDescription {
         HASHABLE_TYPE(ShadowDescription);
-        const SkPath* nodeKey;
-        float matrixData[16];
+        uint32_t pathGenerationId;
+        float matrixXY[16];
+        float matrixZ[4];
+        float lightRadius;
+        bool opaque;
 
         ShadowDescription();
-        ShadowDescription(const SkPath* nodeKey, const Matrix4* drawTransform);
+        ShadowDescription(const SkPath* casterPerimeter, const Matrix4& transformXY,
+                const Matrix4& transformZ, float lightRadius, bool opaque);
     };
 
     class ShadowTask : public Task<vertexBuffer_pair_t> {
     public:
         ShadowTask(const Matrix4* drawTransform, const Rect& localClip, bool opaque,
                 const SkPath* casterPerimeter, const Matrix4* transformXY, const Matrix4* transformZ,
-                const Vector3& lightCenter, float lightRadius)
+                const Vector3& lightCenter, float lightRadius, const Vector3& localLightCenter)
             : drawTransform(*drawTransform)
             , localClip(localClip)
             , opaque(opaque)
@@ -99,7 +109,8 @@ public:
             , transformXY(*transformXY)
             , transformZ(*transformZ)
             , lightCenter(lightCenter)
-            , lightRadius(lightRadius) {
+            , lightRadius(lightRadius)
+            , localLightCenter(localLightCenter) {
         }
 
         /* Note - we deep copy all task parameters, because *even though* pointers into Allocator
@@ -117,6 +128,8 @@ public:
         const Matrix4 transformZ;
         const Vector3 lightCenter;
         const float lightRadius;
+        // light position in the (translation-free) space of the tessellated vertices
+        const Vector3 localLightCenter;
         VertexBuffer ambientBuffer;
         VertexBuffer spotBuffer;
     };
@@ -147,7 +160,7 @@ public:
      * trim the cache at the end of the frame to keep the total amount of
      * memory used under control.
      *
-     * Also removes transient Shadow VertexBuffers, which aren't cached between frames.
+     * Shadow VertexBuffers are kept across frames, bounded by entry count instead of size.
      */
     void trim();
 
@@ -160,10 +173,15 @@ public:
     const VertexBuffer* getRoundRect(const Matrix4& transform, const SkPaint& paint,
             float width, float height, float rx, float ry);
 
-    sp<ShadowTask> getShadowTask(const Matrix4* drawTransform, const Rect& localClip,
+    /**
+     * Returns the shadow task for the caster, creating and enqueueing it if no reusable one is
+     * cached. The returned buffers are tessellated without the caster's XY translation, which is
+     * returned in outTranslation and must be applied when drawing them.
+     */
+    sp<ShadowTask> getShadowTask(const Matrix4* drawTransform,
             bool opaque, const SkPath* casterPerimeter,
             const Matrix4* transformXY, const Matrix4* transformZ,
-            const Vector3& lightCenter, float lightRadius);
+            const Vector3& lightCenter, float lightRadius, Vector2* outTranslation);
 
 private:
     class Buffer;
@@ -172,11 +190,6 @@ private:
 
     typedef VertexBuffer* (*Tessellator)(const Description&);
 
-    void precacheShadows(const Matrix4* drawTransform, const Rect& localClip,
-                bool opaque, const SkPath* casterPerimeter,
-                const Matrix4* transformXY, const Matrix4* transformZ,
-                const Vector3& lightCenter, float lightRadius);
-
     Buffer* getRectBuffer(const Matrix4& transform, const SkPaint& paint,
             float width, float height);
     Buffer* getRoundRectBuffer(const Matrix4& transform, const SkPaint& paint,
@@ -203,9 +216,12 @@ private:
     ///////////////////////////////////////////////////////////////////////////////
     // Shadow tessellation caching
     ///////////////////////////////////////////////////////////////////////////////
+    // Maximum number of shadows kept across frames
+    static const uint32_t kMaxShadowEntries = 64;
+
     sp<TaskProcessor<vertexBuffer_pair_t> > mShadowProcessor;
 
-    // holds a pointer, and implicit strong ref to each shadow task of the frame
+    // holds a pointer, and implicit strong ref to each cached shadow task
     LruCache<ShadowDescription, Task<vertexBuffer_pair_t>*> mShadowCache;
     class BufferPairRemovedListener : public OnEntryRemoved<ShadowDescription, Task<vertexBuffer_pair_t>*> {
         void operator()(ShadowDescription& description, Task<vertexBuffer_pair_t>*& bufferPairTask) override {
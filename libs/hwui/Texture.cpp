@@ -131,7 +131,7 @@ void Texture::upload(GLint internalFormat, uint32_t width, uint32_t height,
         glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, mWidth, mHeight, 0,
                 format, type, pixels);
     } else if (pixels) {
-        glTexSubImage2D(GL_TEXTURE_2D, 0, internalFormat, mWidth, mHeight, 0,
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mWidth, mHeight,
                 format, type, pixels);
     }
     GL_CHECKPOINT(MODERATE);
@@ -274,6 +274,30 @@ bool Texture::hasUnsupportedColorType(const SkImageInfo& info, bool hasLinearBle
                 && Caches::getInstance().extensions().getMajorGlVersion() < 3);
 }
 
+bool Texture::getDirectUploadFormat(const Caches& caches, Bitmap& bitmap,
+        GLint* outInternalFormat, GLint* outFormat, GLint* outType) {
+    if (bitmap.isHardware() || !bitmap.readyToDraw() || bitmap.hasHardwareMipMap()
+            || bitmap.rowBytesAsPixels() != bitmap.width()) {
+        return false;
+    }
+
+    bool hasLinearBlending = caches.extensions().hasLinearBlending();
+    if (hasUnsupportedColorType(bitmap.info(), hasLinearBlending)) {
+        return false;
+    }
+
+    bool needSRGB = transferFunctionCloseToSRGB(bitmap.info().colorSpace());
+    colorTypeToGlFormatAndType(caches, bitmap.colorType(),
+            needSRGB && hasLinearBlending, outInternalFormat, outFormat, outType);
+
+    // Mirrors the color space handling of upload(Bitmap&), which would need a connector
+    if (bitmap.colorType() == kRGBA_F16_SkColorType) {
+        return *outInternalFormat == GL_RGBA16F;
+    }
+    SkColorSpace* colorSpace = bitmap.info().colorSpace();
+    return *outInternalFormat == GL_ALPHA || colorSpace == nullptr || colorSpace->isSRGB();
+}
+
 void Texture::upload(Bitmap& bitmap) {
     if (!bitmap.readyToDraw()) {
         ALOGE("Cannot generate texture from bitmap");
@@ -393,6 +417,16 @@ void Texture::wrap(GLuint id, uint32_t width, uint32_t height,
     notifySizeChanged(0);
 }
 
+void Texture::adopt(GLuint id, uint32_t width, uint32_t height,
+        GLint internalFormat, GLint format) {
+    mId = id;
+    mConnector.reset();
+    // Unlike wrap() this texture is ours, so its memory is counted
+    updateLayout(width, height, internalFormat, format, GL_TEXTURE_2D);
+    setFilter(GL_NEAREST, true, true);
+    setWrap(GL_CLAMP_TO_EDGE, true, true);
+}
+
 TransferFunctionType Texture::getTransferFunctionType() const {
     if (mConnector.get() != nullptr && mInternalFormat != GL_SRGB8_ALPHA8) {
         const ColorSpace::TransferParameters& p = mConnector->getSource().getTransferParameters();
@@ -53,6 +53,12 @@ public:
     static bool hasUnsupportedColorType(const SkImageInfo& info, bool hasLinearBlending);
     static void colorTypeToGlFormatAndType(const Caches& caches, SkColorType colorType,
             bool needSRGB, GLint* outInternalFormat, GLint* outFormat, GLint* outType);
+    /**
+     * Returns true if the bitmap's pixels can be handed to glTexImage2D() as they are, that is
+     * without a color space conversion, a copy or a mipmap, and gets the formats to use.
+     */
+    static bool getDirectUploadFormat(const Caches& caches, Bitmap& bitmap,
+            GLint* outInternalFormat, GLint* outFormat, GLint* outType);
 
     explicit Texture(Caches& caches)
         : GpuMemoryTracker(GpuObjectType::Texture)
@@ -112,6 +118,13 @@ public:
     void wrap(GLuint id, uint32_t width, uint32_t height, GLint internalFormat,
             GLint format, GLenum target);
 
+    /**
+     * Takes ownership of a GL_TEXTURE_2D uploaded on another context sharing
+     * textures with this one, see TextureUploader.
+     */
+    void adopt(GLuint id, uint32_t width, uint32_t height, GLint internalFormat,
+            GLint format);
+
     GLuint id() const {
         return mId;
     }
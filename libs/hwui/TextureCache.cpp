@@ -21,13 +21,18 @@
 #include "Caches.h"
 #include "Texture.h"
 #include "TextureCache.h"
+#include "TextureUploader.h"
 #include "Properties.h"
+#include "renderthread/EglManager.h"
 #include "utils/TraceUtils.h"
 #include "hwui/Bitmap.h"
 
 namespace android {
 namespace uirenderer {
 
+// Smaller bitmaps upload faster than the round trip to the upload thread
+static const uint32_t kMinAsyncUploadSize = 64 * 1024;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Constructors/destructor
 ///////////////////////////////////////////////////////////////////////////////
@@ -47,6 +52,7 @@ TextureCache::TextureCache()
 
 TextureCache::~TextureCache() {
     this->clear();
+    destroyTextureUploader();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -146,7 +152,13 @@ Texture* TextureCache::getCachedTexture(Bitmap* bitmap) {
         }
 
         if (canCache) {
-            texture = createTexture(bitmap);
+            texture = mUploader ? mUploader->takeTexture(bitmap) : nullptr;
+            if (texture) {
+                texture->bitmapSize = size;
+                texture->generation = bitmap->getGenerationID();
+            } else {
+                texture = createTexture(bitmap);
+            }
             mSize += size;
             TEXTURE_LOGD("TextureCache::get: create texture(%p): name, size, mSize = %d, %d, %d",
                      bitmap, texture->id, size, mSize);
@@ -177,6 +189,28 @@ bool TextureCache::prefetch(Bitmap* bitmap) {
     return getCachedTexture(bitmap);
 }
 
+bool TextureCache::prefetchAsync(Bitmap* bitmap, renderthread::EglManager& eglManager) {
+    const uint32_t size = bitmap->rowBytes() * bitmap->height();
+    if (bitmap->isHardware() || size < kMinAsyncUploadSize || size >= mMaxSize
+            || mCache.get(bitmap->getStableID()) || !canMakeTextureFromBitmap(bitmap)) {
+        return false;
+    }
+
+    if (!mUploader) {
+        EGLSurface surface = EGL_NO_SURFACE;
+        EGLContext context = eglManager.createSharedContext(&surface);
+        if (context == EGL_NO_CONTEXT) {
+            return false;
+        }
+        mUploader.reset(new TextureUploader(eglManager.eglDisplay(), context, surface));
+    }
+    return mUploader->upload(bitmap);
+}
+
+void TextureCache::destroyTextureUploader() {
+    mUploader.reset();
+}
+
 Texture* TextureCache::get(Bitmap* bitmap) {
     Texture* texture = getCachedTexture(bitmap);
 
@@ -198,10 +232,16 @@ bool TextureCache::destroyTexture(uint32_t pixelRefStableID) {
         mHardwareTextures.erase(hardwareIter);
         return true;
     }
+    if (mUploader) {
+        mUploader->cancel(pixelRefStableID);
+    }
     return mCache.remove(pixelRefStableID);
 }
 
 void TextureCache::clear() {
+    if (mUploader) {
+        mUploader->cancelAll();
+    }
     mCache.clear();
     for(auto& iter: mHardwareTextures) {
         iter.second->deleteTexture();
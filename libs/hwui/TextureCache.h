@@ -26,6 +26,7 @@
 
 #include "Debug.h"
 
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -36,6 +37,11 @@ class Bitmap;
 namespace uirenderer {
 
 class Texture;
+class TextureUploader;
+
+namespace renderthread {
+class EglManager;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // Defines
@@ -87,6 +93,19 @@ public:
      */
     bool prefetch(Bitmap* bitmap);
 
+    /**
+     * Queues the upload of the bitmap on a worker thread, the texture is added to the cache
+     * the first time the bitmap is drawn. Returns false if the bitmap is already cached or
+     * isn't worth uploading asynchronously, in which case prefetch() should be used instead.
+     */
+    bool prefetchAsync(Bitmap* bitmap, renderthread::EglManager& eglManager);
+
+    /**
+     * Stops the texture upload thread and destroys its context. Must be called
+     * before the RenderThread's context is destroyed.
+     */
+    void destroyTextureUploader();
+
     /**
      * Returns the texture associated with the specified bitmap from within the cache.
      * If the texture cannot be found in the cache, a new texture is generated.
@@ -136,6 +155,8 @@ private:
     bool mDebugEnabled;
 
     std::unordered_map<uint32_t, std::unique_ptr<Texture>> mHardwareTextures;
+
+    std::unique_ptr<TextureUploader> mUploader;
 }; // class TextureCache
 
 }; // namespace uirenderer
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureUploader.h"
+
+#include "Caches.h"
+#include "Texture.h"
+#include "hwui/Bitmap.h"
+#include "renderthread/EglManager.h"
+#include "utils/TraceUtils.h"
+
+#include <utils/Log.h>
+
+#include <algorithm>
+
+namespace android {
+namespace uirenderer {
+
+// Bounds the memory pinned by bitmaps waiting for the worker
+static const size_t kMaxPendingUploads = 16;
+
+#define FENCE_TIMEOUT 2000000000
+
+TextureUploader::TextureUploader(EGLDisplay display, EGLContext context, EGLSurface surface)
+        : mDisplay(display)
+        , mContext(context)
+        , mSurface(surface)
+        , mThread(new UploadThread(this)) {
+    mThread->run("hwuiTexUpload", PRIORITY_DISPLAY);
+}
+
+TextureUploader::~TextureUploader() {
+    {
+        Mutex::Autolock _l(mLock);
+        mExiting = true;
+        mCondition.broadcast();
+    }
+    mThread->requestExitAndWait();
+
+    // The worker is gone, whatever is left is ours to release
+    mQueue.clear();
+    for (auto& iter : mUploads) {
+        release(*iter.second);
+    }
+    mUploads.clear();
+
+    eglDestroySurface(mDisplay, mSurface);
+    eglDestroyContext(mDisplay, mContext);
+}
+
+bool TextureUploader::upload(Bitmap* bitmap) {
+    GLint internalFormat, format, type;
+    if (!Texture::getDirectUploadFormat(Caches::getInstance(), *bitmap,
+            &internalFormat, &format, &type)) {
+        return false;
+    }
+
+    Mutex::Autolock _l(mLock);
+    if (mFailed || mQueue.size() >= kMaxPendingUploads) {
+        return false;
+    }
+
+    auto iter = mUploads.find(bitmap->getStableID());
+    if (iter != mUploads.end()) {
+        if (iter->second->generation == bitmap->getGenerationID()) {
+            return true;
+        }
+        // Stale, replace it with an upload of the current pixels
+        if (finishOrDequeue(iter->second)) {
+            release(*iter->second);
+        }
+        mUploads.erase(iter);
+    }
+
+    auto job = std::make_shared<Upload>();
+    job->bitmap = sk_ref_sp(bitmap);
+    job->generation = bitmap->getGenerationID();
+    job->internalFormat = internalFormat;
+    job->format = format;
+    job->type = type;
+    mUploads.emplace(bitmap->getStableID(), job);
+    mQueue.push_back(std::move(job));
+    mCondition.signal();
+    return true;
+}
+
+Texture* TextureUploader::takeTexture(Bitmap* bitmap) {
+    std::shared_ptr<Upload> job;
+    {
+        Mutex::Autolock _l(mLock);
+        auto iter = mUploads.find(bitmap->getStableID());
+        if (iter == mUploads.end()) {
+            return nullptr;
+        }
+        job = std::move(iter->second);
+        mUploads.erase(iter);
+        if (!finishOrDequeue(job)) {
+            return nullptr;
+        }
+    }
+
+    if (job->id && bitmap->getGenerationID() == job->generation) {
+        ATRACE_NAME("Wait for texture upload");
+        EGLint waitStatus = eglClientWaitSyncKHR(mDisplay, job->fence, 0, FENCE_TIMEOUT);
+        if (waitStatus == EGL_CONDITION_SATISFIED_KHR) {
+            Texture* texture = new Texture(Caches::getInstance());
+            texture->adopt(job->id, bitmap->width(), bitmap->height(),
+                    job->internalFormat, job->format);
+            texture->blend = !bitmap->isOpaque();
+            job->id = 0;
+            release(*job);
+            return texture;
+        }
+        ALOGW("Failed to wait for texture upload fence %#x", eglGetError());
+    }
+    release(*job);
+    return nullptr;
+}
+
+void TextureUploader::cancel(uint32_t stableId) {
+    Mutex::Autolock _l(mLock);
+    auto iter = mUploads.find(stableId);
+    if (iter != mUploads.end()) {
+        if (finishOrDequeue(iter->second)) {
+            release(*iter->second);
+        }
+        mUploads.erase(iter);
+    }
+}
+
+void TextureUploader::cancelAll() {
+    Mutex::Autolock _l(mLock);
+    mQueue.clear();
+    for (auto& iter : mUploads) {
+        if (finishOrDequeue(iter.second)) {
+            release(*iter.second);
+        }
+    }
+    mUploads.clear();
+}
+
+bool TextureUploader::finishOrDequeue(const std::shared_ptr<Upload>& upload) {
+    if (!upload->started) {
+        auto iter = std::find(mQueue.begin(), mQueue.end(), upload);
+        if (iter != mQueue.end()) {
+            mQueue.erase(iter);
+        }
+        return false;
+    }
+    while (!upload->done) {
+        mCondition.wait(mLock);
+    }
+    return true;
+}
+
+void TextureUploader::release(Upload& upload) {
+    if (upload.id) {
+        glDeleteTextures(1, &upload.id);
+        upload.id = 0;
+    }
+    if (upload.fence != EGL_NO_SYNC_KHR) {
+        eglDestroySyncKHR(mDisplay, upload.fence);
+        upload.fence = EGL_NO_SYNC_KHR;
+    }
+}
+
+bool TextureUploader::processNextUpload() {
+    std::shared_ptr<Upload> job;
+    {
+        Mutex::Autolock _l(mLock);
+        while (!mExiting && mQueue.empty()) {
+            mCondition.wait(mLock);
+        }
+        if (mExiting) {
+            if (mContextCurrent) {
+                eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            }
+            return false;
+        }
+        job = mQueue.front();
+        mQueue.pop_front();
+        job->started = true;
+    }
+
+    if (!mContextCurrent) {
+        mContextCurrent = eglMakeCurrent(mDisplay, mSurface, mSurface, mContext);
+        if (!mContextCurrent) {
+            ALOGW("Failed to make the texture upload context current, error = %s",
+                    renderthread::EglManager::eglErrorString());
+        }
+    }
+    if (mContextCurrent) {
+        doUpload(*job);
+    }
+
+    Mutex::Autolock _l(mLock);
+    if (!mContextCurrent) {
+        // Nothing can be uploaded, let the RenderThread do it all
+        mFailed = true;
+    }
+    job->done = true;
+    mCondition.broadcast();
+    return true;
+}
+
+void TextureUploader::doUpload(Upload& upload) {
+    Bitmap& bitmap = *upload.bitmap;
+    ATRACE_FORMAT("Async upload %dx%d Texture", bitmap.width(), bitmap.height());
+
+    glGenTextures(1, &upload.id);
+    glBindTexture(GL_TEXTURE_2D, upload.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, upload.internalFormat, bitmap.width(), bitmap.height(), 0,
+            upload.format, upload.type, bitmap.pixels());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    upload.fence = eglCreateSyncKHR(mDisplay, EGL_SYNC_FENCE_KHR, nullptr);
+    if (upload.fence == EGL_NO_SYNC_KHR) {
+        // Without a fence the RenderThread can't know when the texture is complete
+        glDeleteTextures(1, &upload.id);
+        upload.id = 0;
+    }
+    glFlush();
+}
+
+}; // namespace uirenderer
+}; // namespace android
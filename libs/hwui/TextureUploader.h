@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HWUI_TEXTURE_UPLOADER_H
+#define ANDROID_HWUI_TEXTURE_UPLOADER_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <SkRefCnt.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Thread.h>
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+namespace android {
+
+class Bitmap;
+
+namespace uirenderer {
+
+class Texture;
+
+/**
+ * Uploads bitmaps to textures on a worker thread, using an EGL context that shares its textures
+ * with the RenderThread's. This is used for Bitmap#prepareToDraw() so that large images are
+ * ready by the time a frame needs them, without that frame paying for the upload.
+ *
+ * All methods must be called from the RenderThread, with the shared context current.
+ */
+class TextureUploader {
+public:
+    /**
+     * Takes ownership of context and surface, which the worker thread makes current.
+     */
+    TextureUploader(EGLDisplay display, EGLContext context, EGLSurface surface);
+    ~TextureUploader();
+
+    /**
+     * Queues the upload of the bitmap. Returns false if the bitmap needs work that only
+     * Texture::upload() does, such as color space conversion, or too many uploads are pending.
+     */
+    bool upload(Bitmap* bitmap);
+
+    /**
+     * Returns a texture for the bitmap if its upload was queued and the bitmap didn't change
+     * since then, waiting for the upload if it is in progress. Uploads still waiting for the
+     * worker are cancelled instead, the caller uploads the bitmap itself. The caller owns the
+     * returned texture.
+     */
+    Texture* takeTexture(Bitmap* bitmap);
+
+    /**
+     * Drops the upload of the bitmap with the given stable ID, if any.
+     */
+    void cancel(uint32_t stableId);
+
+    /**
+     * Drops all the uploads.
+     */
+    void cancelAll();
+
+private:
+    struct Upload {
+        sk_sp<Bitmap> bitmap;
+        uint32_t generation = 0;
+        GLint internalFormat = 0;
+        GLint format = 0;
+        GLint type = 0;
+
+        GLuint id = 0;
+        EGLSyncKHR fence = EGL_NO_SYNC_KHR;
+        bool started = false;
+        bool done = false;
+    };
+
+    class UploadThread : public Thread {
+    public:
+        explicit UploadThread(TextureUploader* uploader)
+                : Thread(false), mUploader(uploader) {}
+
+    private:
+        virtual bool threadLoop() override {
+            return mUploader->processNextUpload();
+        }
+
+        TextureUploader* const mUploader;
+    };
+
+    bool processNextUpload();
+    void doUpload(Upload& upload);
+
+    // Removes the upload from the queue if the worker didn't get to it, or waits for it to
+    // complete. Returns true if the upload completed. Called with mLock held.
+    bool finishOrDequeue(const std::shared_ptr<Upload>& upload);
+    void release(Upload& upload);
+
+    const EGLDisplay mDisplay;
+    const EGLContext mContext;
+    const EGLSurface mSurface;
+    bool mContextCurrent = false;
+
+    sp<UploadThread> mThread;
+
+    Mutex mLock;
+    Condition mCondition;
+    std::deque<std::shared_ptr<Upload>> mQueue;
+    std::unordered_map<uint32_t, std::shared_ptr<Upload>> mUploads;
+    bool mExiting = false;
+    bool mFailed = false;
+}; // class TextureUploader
+
+}; // namespace uirenderer
+}; // namespace android
+
+#endif // ANDROID_HWUI_TEXTURE_UPLOADER_H
@@ -91,6 +91,11 @@ public:
     LayerUpdateQueue* layerUpdateQueue = nullptr;
     ErrorHandler* errorHandler = nullptr;
 
+    // Size of the surface the tree was last drawn into, or 0 if unknown. Updates of layers
+    // entirely outside of it are deferred until they come into view.
+    int windowWidth = 0;
+    int windowHeight = 0;
+
     bool updateWindowPositions = false;
 
     struct Out {
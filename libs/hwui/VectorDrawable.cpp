@@ -22,6 +22,7 @@
 #include "SkShader.h"
 #include <utils/Log.h>
 #include "utils/Macros.h"
+#include "utils/TraceUtils.h"
 #include "utils/VectorDrawableUtils.h"
 
 #include <math.h>
@@ -51,12 +52,10 @@ Path::Path(const Path& path) : Node(path) {
 
 const SkPath& Path::getUpdatedPath(bool useStagingData, SkPath* tempStagingPath) {
     if (useStagingData) {
-        tempStagingPath->reset();
         VectorDrawableUtils::verbsToPath(tempStagingPath, mStagingProperties.getData());
         return *tempStagingPath;
     } else {
         if (mSkPathDirty) {
-            mSkPath.reset();
             VectorDrawableUtils::verbsToPath(&mSkPath, mProperties.getData());
             mSkPathDirty = false;
         }
@@ -482,6 +481,11 @@ SkPaint* Tree::updatePaint(SkPaint* outPaint, TreeProperties* prop) {
 }
 
 Bitmap& Tree::getBitmapUpdateIfDirty() {
+    if (mPendingCacheUpdate.get()) {
+        ATRACE_NAME("Wait for VectorDrawable cache");
+        mPendingCacheUpdate->getResult();
+        mPendingCacheUpdate.clear();
+    }
     bool redrawNeeded = allocateBitmapIfNeeded(mCache, mProperties.getScaledWidth(),
             mProperties.getScaledHeight());
     if (redrawNeeded || mCache.dirty) {
@@ -491,6 +495,32 @@ Bitmap& Tree::getBitmapUpdateIfDirty() {
     return *mCache.bitmap;
 }
 
+bool Tree::setPendingCacheUpdate(const sp<Task<bool> >& task) {
+    if (mPendingCacheUpdate.get()) {
+        // Drawn more than once in this frame, or left over from a frame that wasn't drawn
+        mPendingCacheUpdate->getResult();
+        mPendingCacheUpdate.clear();
+    }
+    if (mProperties.getScaledWidth() <= 0 || mProperties.getScaledHeight() <= 0) {
+        return false;
+    }
+    // The bitmap is allocated here so that it is never replaced while it is being drawn
+    bool redrawNeeded = allocateBitmapIfNeeded(mCache, mProperties.getScaledWidth(),
+            mProperties.getScaledHeight());
+    if (!redrawNeeded && !mCache.dirty) {
+        return false;
+    }
+    mPendingCacheUpdate = task;
+    return true;
+}
+
+void Tree::updateCache() {
+    ATRACE_FORMAT("Update VectorDrawable cache %dx%d",
+            mCache.bitmap->width(), mCache.bitmap->height());
+    updateBitmapCache(*mCache.bitmap, false);
+    mCache.dirty = false;
+}
+
 void Tree::updateBitmapCache(Bitmap& bitmap, bool useStagingData) {
     SkBitmap outCache;
     bitmap.getSkBitmap(&outCache);
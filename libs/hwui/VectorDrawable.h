@@ -20,6 +20,7 @@
 #include "hwui/Canvas.h"
 #include "hwui/Bitmap.h"
 #include "DisplayList.h"
+#include "thread/Task.h"
 
 #include <SkBitmap.h>
 #include <SkColor.h>
@@ -550,6 +551,14 @@ public:
     void drawStaging(Canvas* canvas);
 
     Bitmap& getBitmapUpdateIfDirty();
+
+    // Lets another thread redraw the RenderThread cache ahead of getBitmapUpdateIfDirty(),
+    // which then waits for the given task. Must be called from the RenderThread once the
+    // properties of the frame are final, returns false if the cache is up to date. The
+    // properties must not change again until updateCache() has run.
+    bool setPendingCacheUpdate(const sp<Task<bool> >& task);
+    void updateCache();
+
     void setAllowCaching(bool allowCaching) {
         mAllowCaching = allowCaching;
     }
@@ -708,6 +717,8 @@ private:
 
     Cache mStagingCache;
     Cache mCache;
+    // Set while another thread redraws mCache, see setPendingCacheUpdate()
+    sp<Task<bool> > mPendingCacheUpdate;
 
     PropertyChangedListener mPropertyChangedListener
             = PropertyChangedListener(&mCache.dirty, &mStagingCache.dirty);
@@ -16,6 +16,8 @@
 
 #include <SkGlyph.h>
 
+#include <algorithm>
+
 #include "CacheTexture.h"
 #include "FontUtil.h"
 #include "../Caches.h"
@@ -26,85 +28,6 @@
 namespace android {
 namespace uirenderer {
 
-///////////////////////////////////////////////////////////////////////////////
-// CacheBlock
-///////////////////////////////////////////////////////////////////////////////
-
-/**
- * Insert new block into existing linked list of blocks. Blocks are sorted in increasing-width
- * order, except for the final block (the remainder space at the right, since we fill from the
- * left).
- */
-CacheBlock* CacheBlock::insertBlock(CacheBlock* head, CacheBlock* newBlock) {
-#if DEBUG_FONT_RENDERER
-    ALOGD("insertBlock: this, x, y, w, h = %p, %d, %d, %d, %d",
-            newBlock, newBlock->mX, newBlock->mY,
-            newBlock->mWidth, newBlock->mHeight);
-#endif
-
-    CacheBlock* currBlock = head;
-    CacheBlock* prevBlock = nullptr;
-
-    while (currBlock && currBlock->mY != TEXTURE_BORDER_SIZE) {
-        if (newBlock->mWidth < currBlock->mWidth) {
-            newBlock->mNext = currBlock;
-            newBlock->mPrev = prevBlock;
-            currBlock->mPrev = newBlock;
-
-            if (prevBlock) {
-                prevBlock->mNext = newBlock;
-                return head;
-            } else {
-                return newBlock;
-            }
-        }
-
-        prevBlock = currBlock;
-        currBlock = currBlock->mNext;
-    }
-
-    // new block larger than all others - insert at end (but before the remainder space, if there)
-    newBlock->mNext = currBlock;
-    newBlock->mPrev = prevBlock;
-
-    if (currBlock) {
-        currBlock->mPrev = newBlock;
-    }
-
-    if (prevBlock) {
-        prevBlock->mNext = newBlock;
-        return head;
-    } else {
-        return newBlock;
-    }
-}
-
-CacheBlock* CacheBlock::removeBlock(CacheBlock* head, CacheBlock* blockToRemove) {
-#if DEBUG_FONT_RENDERER
-    ALOGD("removeBlock: this, x, y, w, h = %p, %d, %d, %d, %d",
-            blockToRemove, blockToRemove->mX, blockToRemove->mY,
-            blockToRemove->mWidth, blockToRemove->mHeight);
-#endif
-
-    CacheBlock* newHead = head;
-    CacheBlock* nextBlock = blockToRemove->mNext;
-    CacheBlock* prevBlock = blockToRemove->mPrev;
-
-    if (prevBlock) {
-        prevBlock->mNext = nextBlock;
-    } else {
-        newHead = nextBlock;
-    }
-
-    if (nextBlock) {
-        nextBlock->mPrev = prevBlock;
-    }
-
-    delete blockToRemove;
-
-    return newHead;
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 // CacheTexture
 ///////////////////////////////////////////////////////////////////////////////
@@ -118,8 +41,7 @@ CacheTexture::CacheTexture(uint16_t width, uint16_t height, GLenum format, uint3
         , mCaches(Caches::getInstance()) {
     mTexture.blend = true;
 
-    mCacheBlocks = new CacheBlock(TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
-            getWidth() - TEXTURE_BORDER_SIZE, getHeight() - TEXTURE_BORDER_SIZE);
+    init();
 
     // OpenGL ES 3.0+ lets us specify the row length for unpack operations such
     // as glTexSubImage2D(). This allows us to upload a sub-rectangle of a texture.
@@ -134,21 +56,16 @@ CacheTexture::~CacheTexture() {
 }
 
 void CacheTexture::reset() {
-    // Delete existing cache blocks
-    while (mCacheBlocks != nullptr) {
-        CacheBlock* tmpBlock = mCacheBlocks;
-        mCacheBlocks = mCacheBlocks->mNext;
-        delete tmpBlock;
-    }
+    mSkyline.clear();
     mNumGlyphs = 0;
     mCurrentQuad = 0;
 }
 
 void CacheTexture::init() {
-    // reset, then create a new remainder space to start again
+    // reset, then start again with a single empty level
     reset();
-    mCacheBlocks = new CacheBlock(TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
-            getWidth() - TEXTURE_BORDER_SIZE, getHeight() - TEXTURE_BORDER_SIZE);
+    mSkyline.push_back({TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
+            static_cast<uint16_t>(getWidth() - TEXTURE_BORDER_SIZE)});
 }
 
 void CacheTexture::releaseMesh() {
@@ -257,92 +174,99 @@ bool CacheTexture::fitBitmap(const SkGlyph& glyph, uint32_t* retOriginX, uint32_
     uint16_t glyphW = glyph.fWidth + TEXTURE_BORDER_SIZE;
     uint16_t glyphH = glyph.fHeight + TEXTURE_BORDER_SIZE;
 
-    // roundedUpW equals glyphW to the next multiple of CACHE_BLOCK_ROUNDING_SIZE.
-    // This columns for glyphs that are close but not necessarily exactly the same size. It trades
-    // off the loss of a few pixels for some glyphs against the ability to store more glyphs
-    // of varying sizes in one block.
-    uint16_t roundedUpW = (glyphW + CACHE_BLOCK_ROUNDING_SIZE - 1) & -CACHE_BLOCK_ROUNDING_SIZE;
-
-    CacheBlock* cacheBlock = mCacheBlocks;
-    while (cacheBlock) {
-        // Store glyph in this block iff: it fits the block's remaining space and:
-        // it's the remainder space (mY == 0) or there's only enough height for this one glyph
-        // or it's within ROUNDING_SIZE of the block width
-        if (roundedUpW <= cacheBlock->mWidth && glyphH <= cacheBlock->mHeight &&
-                (cacheBlock->mY == TEXTURE_BORDER_SIZE ||
-                        (cacheBlock->mWidth - roundedUpW < CACHE_BLOCK_ROUNDING_SIZE))) {
-            if (cacheBlock->mHeight - glyphH < glyphH) {
-                // Only enough space for this glyph - don't bother rounding up the width
-                roundedUpW = glyphW;
-            }
-
-            *retOriginX = cacheBlock->mX;
-            *retOriginY = cacheBlock->mY;
-
-            // If this is the remainder space, create a new cache block for this column. Otherwise,
-            // adjust the info about this column.
-            if (cacheBlock->mY == TEXTURE_BORDER_SIZE) {
-                uint16_t oldX = cacheBlock->mX;
-                // Adjust remainder space dimensions
-                cacheBlock->mWidth -= roundedUpW;
-                cacheBlock->mX += roundedUpW;
-
-                if (getHeight() - glyphH >= glyphH) {
-                    // There's enough height left over to create a new CacheBlock
-                    CacheBlock* newBlock = new CacheBlock(oldX, glyphH + TEXTURE_BORDER_SIZE,
-                            roundedUpW, getHeight() - glyphH - TEXTURE_BORDER_SIZE);
-#if DEBUG_FONT_RENDERER
-                    ALOGD("fitBitmap: Created new block: this, x, y, w, h = %p, %d, %d, %d, %d",
-                            newBlock, newBlock->mX, newBlock->mY,
-                            newBlock->mWidth, newBlock->mHeight);
-#endif
-                    mCacheBlocks = CacheBlock::insertBlock(mCacheBlocks, newBlock);
-                }
-            } else {
-                // Insert into current column and adjust column dimensions
-                cacheBlock->mY += glyphH;
-                cacheBlock->mHeight -= glyphH;
+    uint16_t y;
+    int index = findSkylinePosition(glyphW, glyphH, &y);
+    if (index < 0) {
 #if DEBUG_FONT_RENDERER
-                ALOGD("fitBitmap: Added to existing block: this, x, y, w, h = %p, %d, %d, %d, %d",
-                        cacheBlock, cacheBlock->mX, cacheBlock->mY,
-                        cacheBlock->mWidth, cacheBlock->mHeight);
+        ALOGD("fitBitmap: returning false for glyph of size %d, %d", glyphW, glyphH);
 #endif
-            }
+        return false;
+    }
 
-            if (cacheBlock->mHeight < std::min(glyphH, glyphW)) {
-                // If remaining space in this block is too small to be useful, remove it
-                mCacheBlocks = CacheBlock::removeBlock(mCacheBlocks, cacheBlock);
-            }
+    *retOriginX = mSkyline[index].mX;
+    *retOriginY = y;
+    addSkylineLevel(index, glyphW, glyphH, y);
 
-            mDirty = true;
-            const Rect r(*retOriginX - TEXTURE_BORDER_SIZE, *retOriginY - TEXTURE_BORDER_SIZE,
-                    *retOriginX + glyphW, *retOriginY + glyphH);
-            mDirtyRect.unionWith(r);
-            mNumGlyphs++;
+    mDirty = true;
+    const Rect r(*retOriginX - TEXTURE_BORDER_SIZE, *retOriginY - TEXTURE_BORDER_SIZE,
+            *retOriginX + glyphW, *retOriginY + glyphH);
+    mDirtyRect.unionWith(r);
+    mNumGlyphs++;
 
 #if DEBUG_FONT_RENDERER
-            ALOGD("fitBitmap: current block list:");
-            mCacheBlocks->output();
+    ALOGD("fitBitmap: placed glyph of size %d, %d at %d, %d, %zu skyline segments",
+            glyphW, glyphH, *retOriginX, *retOriginY, mSkyline.size());
 #endif
 
-            return true;
+    return true;
+}
+
+int CacheTexture::findSkylinePosition(uint16_t width, uint16_t height, uint16_t* outY) const {
+    int bestIndex = -1;
+    uint32_t bestBottom = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+
+    for (size_t i = 0; i < mSkyline.size(); i++) {
+        const uint32_t left = mSkyline[i].mX;
+        const uint32_t right = left + width;
+        if (right > getWidth()) {
+            break;
+        }
+
+        // The glyph rests on the lowest of the segments it spans
+        uint32_t y = 0;
+        for (size_t j = i; j < mSkyline.size() && mSkyline[j].mX < right; j++) {
+            y = std::max(y, (uint32_t) mSkyline[j].mY);
+        }
+
+        const uint32_t bottom = y + height;
+        if (bottom > getHeight()) {
+            continue;
+        }
+
+        if (bottom < bestBottom || (bottom == bestBottom && mSkyline[i].mWidth < bestWidth)) {
+            bestIndex = i;
+            bestBottom = bottom;
+            bestWidth = mSkyline[i].mWidth;
+            *outY = y;
+        }
+    }
+    return bestIndex;
+}
+
+void CacheTexture::addSkylineLevel(size_t index, uint16_t width, uint16_t height, uint16_t y) {
+    const SkylineSegment segment = { mSkyline[index].mX, (uint16_t) (y + height), width };
+    const uint32_t right = segment.mX + width;
+
+    // Drop or shrink the segments now covered by the new one
+    size_t end = index;
+    while (end < mSkyline.size() && mSkyline[end].mX + mSkyline[end].mWidth <= right) {
+        end++;
+    }
+    if (end < mSkyline.size() && mSkyline[end].mX < right) {
+        mSkyline[end].mWidth -= right - mSkyline[end].mX;
+        mSkyline[end].mX = right;
+    }
+    mSkyline.erase(mSkyline.begin() + index, mSkyline.begin() + end);
+    mSkyline.insert(mSkyline.begin() + index, segment);
+
+    // Merge neighbours at the same level to keep the list short
+    for (size_t i = index > 0 ? index - 1 : 0; i + 1 < mSkyline.size() && i <= index + 1;) {
+        if (mSkyline[i].mY == mSkyline[i + 1].mY) {
+            mSkyline[i].mWidth += mSkyline[i + 1].mWidth;
+            mSkyline.erase(mSkyline.begin() + i + 1);
+        } else {
+            i++;
         }
-        cacheBlock = cacheBlock->mNext;
     }
-#if DEBUG_FONT_RENDERER
-    ALOGD("fitBitmap: returning false for glyph of size %d, %d", glyphW, glyphH);
-#endif
-    return false;
 }
 
 uint32_t CacheTexture::calculateFreeMemory() const {
-    CacheBlock* cacheBlock = mCacheBlocks;
     uint32_t free = 0;
     // currently only two formats are supported: GL_ALPHA or GL_RGBA;
     uint32_t bpp = mFormat == GL_RGBA ? 4 : 1;
-    while (cacheBlock) {
-        free += bpp * cacheBlock->mWidth * cacheBlock->mHeight;
-        cacheBlock = cacheBlock->mNext;
+    for (const SkylineSegment& segment : mSkyline) {
+        free += bpp * segment.mWidth * (getHeight() - segment.mY);
     }
     return free;
 }
@@ -26,6 +26,7 @@
 #include <SkGlyph.h>
 #include <utils/Log.h>
 
+#include <vector>
 
 namespace android {
 namespace uirenderer {
@@ -33,42 +34,17 @@ namespace uirenderer {
 class Caches;
 
 /**
- * CacheBlock is a node in a linked list of current free space areas in a CacheTexture.
- * Using CacheBlocks enables us to pack the cache from top to bottom as well as left to right.
- * When we add a glyph to the cache, we see if it fits within one of the existing columns that
- * have already been started (this is the case if the glyph fits vertically as well as
- * horizontally, and if its width is sufficiently close to the column width to avoid
- * sub-optimal packing of small glyphs into wide columns). If there is no column in which the
- * glyph fits, we check the final node, which is the remaining space in the cache, creating
- * a new column as appropriate.
- *
- * As columns fill up, we remove their CacheBlock from the list to avoid having to check
- * small blocks in the future.
+ * The free space of a CacheTexture is tracked as a skyline: a list of segments, sorted from
+ * left to right, each of which says that the columns [mX, mX + mWidth) are used down to mY.
+ * A new glyph goes where its bottom edge ends up highest, ties going to the narrowest segment
+ * (bottom-left rule, upside down since we fill from the top). Unlike fixed-width columns, this
+ * lets glyphs of different sizes share rows, so mixed text sizes fill the texture much further
+ * before it overflows.
  */
-struct CacheBlock {
+struct SkylineSegment {
     uint16_t mX;
     uint16_t mY;
     uint16_t mWidth;
-    uint16_t mHeight;
-    CacheBlock* mNext;
-    CacheBlock* mPrev;
-
-    CacheBlock(uint16_t x, uint16_t y, uint16_t width, uint16_t height):
-            mX(x), mY(y), mWidth(width), mHeight(height), mNext(nullptr), mPrev(nullptr) {
-    }
-
-    static CacheBlock* insertBlock(CacheBlock* head, CacheBlock* newBlock);
-    static CacheBlock* removeBlock(CacheBlock* head, CacheBlock* blockToRemove);
-
-    void output() {
-        CacheBlock* currBlock = this;
-        while (currBlock) {
-            ALOGD("Block: this, x, y, w, h = %p, %d, %d, %d, %d",
-                    currBlock, currBlock->mX, currBlock->mY,
-                    currBlock->mWidth, currBlock->mHeight);
-            currBlock = currBlock->mNext;
-        }
-    }
 };
 
 class CacheTexture {
@@ -183,6 +159,11 @@ public:
 private:
     void setDirty(bool dirty);
 
+    // Returns the index of the skyline segment at which a glyph of the given size fits best, or
+    // -1 if it doesn't fit anywhere
+    int findSkylinePosition(uint16_t width, uint16_t height, uint16_t* outY) const;
+    void addSkylineLevel(size_t index, uint16_t width, uint16_t height, uint16_t y);
+
     PixelBuffer* mPixelBuffer = nullptr;
     Texture mTexture;
     uint32_t mWidth, mHeight;
@@ -194,7 +175,7 @@ private:
     uint32_t mCurrentQuad = 0;
     uint32_t mMaxQuadCount;
     Caches& mCaches;
-    CacheBlock* mCacheBlocks;
+    std::vector<SkylineSegment> mSkyline;
     bool mHasUnpackRowLength;
     Rect mDirtyRect;
 };
@@ -50,6 +50,7 @@ void FontCacheHistoryTracker::dumpUploadEntry(String8& log, const CachedGlyph& g
 
 void FontCacheHistoryTracker::dump(String8& log) const {
     log.appendFormat("FontCacheHistory: \n");
+    log.appendFormat("  Texture evictions: %u, full flushes: %u\n", mEvictionCount, mFlushCount);
     log.appendFormat("  Upload history: \n");
     for (size_t i = 0; i < mUploadHistory.size(); i++) {
         dumpUploadEntry(log, mUploadHistory[i]);
@@ -93,6 +94,15 @@ void FontCacheHistoryTracker::glyphsCleared(CacheTexture* texture) {
     glyph.bitmapH = 0;
 }
 
+void FontCacheHistoryTracker::textureEvicted(CacheTexture* texture) {
+    mEvictionCount++;
+    glyphsCleared(texture);
+}
+
+void FontCacheHistoryTracker::cacheFlushed() {
+    mFlushCount++;
+}
+
 void FontCacheHistoryTracker::frameCompleted() {
     generation++;
 }
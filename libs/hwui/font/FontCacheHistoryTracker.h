@@ -32,6 +32,10 @@ public:
     void glyphRendered(CachedGlyphInfo*, int penX, int penY);
     void glyphUploaded(CacheTexture*, uint32_t x, uint32_t y, uint16_t glyphW, uint16_t glyphH);
     void glyphsCleared(CacheTexture*);
+    // A single texture was cleared to make room for a new glyph
+    void textureEvicted(CacheTexture*);
+    // Every texture was cleared because a new glyph didn't fit anywhere
+    void cacheFlushed();
     void frameCompleted();
 
     void dump(String8& log) const;
@@ -58,6 +62,8 @@ private:
     RingBuffer<RenderEntry, 300> mRenderHistory;
     RingBuffer<CachedGlyph, 120> mUploadHistory;
     uint16_t generation = 0;
+    uint32_t mEvictionCount = 0;
+    uint32_t mFlushCount = 0;
 };
 
 }; // namespace uirenderer
@@ -38,8 +38,6 @@
   #define TEXTURE_BORDER_SIZE 1
 #endif
 
-#define CACHE_BLOCK_ROUNDING_SIZE 4
-
 typedef uint16_t glyph_t;
 #define GET_METRICS(cache, glyph) cache->getGlyphIDMetrics(glyph)
 #define IS_END_OF_STRING(glyph) false
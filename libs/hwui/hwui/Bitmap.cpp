@@ -16,6 +16,7 @@
 #include "Bitmap.h"
 
 #include "Caches.h"
+#include "PixelBufferPool.h"
 #include "renderthread/EglManager.h"
 #include "renderthread/RenderThread.h"
 #include "renderthread/RenderProxy.h"
@@ -85,7 +86,7 @@ sk_sp<Bitmap> Bitmap::allocateAshmemBitmap(SkBitmap* bitmap, SkColorTable* ctabl
 
 static sk_sp<Bitmap> allocateHeapBitmap(size_t size, const SkImageInfo& info, size_t rowBytes,
         SkColorTable* ctable) {
-    void* addr = calloc(size, 1);
+    void* addr = PixelBufferPool::getInstance().allocate(size);
     if (!addr) {
         return nullptr;
     }
@@ -262,6 +263,27 @@ sk_sp<Bitmap> Bitmap::allocateHardwareBitmap(SkBitmap& bitmap) {
     return uirenderer::renderthread::RenderProxy::allocateHardwareBitmap(bitmap);
 }
 
+sk_sp<Bitmap> Bitmap::allocateCpuWritableHardwareBitmap(const SkImageInfo& info) {
+    // Other color types may need a conversion on upload, see allocateHardwareBitmap()
+    if (info.colorType() != kRGBA_8888_SkColorType) {
+        return nullptr;
+    }
+    sp<GraphicBuffer> buffer = new GraphicBuffer(info.width(), info.height(),
+            PIXEL_FORMAT_RGBA_8888,
+            GraphicBuffer::USAGE_HW_TEXTURE |
+            GraphicBuffer::USAGE_SW_WRITE_RARELY |
+            GraphicBuffer::USAGE_SW_READ_NEVER,
+            std::string("Bitmap::allocateCpuWritableHardwareBitmap pid [")
+                    + std::to_string(getpid()) + "]");
+
+    status_t error = buffer->initCheck();
+    if (error < 0) {
+        ALOGW("createGraphicBuffer() failed in GraphicBuffer.create()");
+        return nullptr;
+    }
+    return sk_sp<Bitmap>(new Bitmap(buffer.get(), info));
+}
+
 sk_sp<Bitmap> Bitmap::allocateHeapBitmap(SkBitmap* bitmap, SkColorTable* ctable) {
    return allocateBitmap(bitmap, ctable, &android::allocateHeapBitmap);
 }
@@ -406,7 +428,8 @@ Bitmap::~Bitmap() {
         close(mPixelStorage.ashmem.fd);
         break;
     case PixelStorageType::Heap:
-        free(mPixelStorage.heap.address);
+        PixelBufferPool::getInstance().release(mPixelStorage.heap.address,
+                mPixelStorage.heap.size);
         break;
     case PixelStorageType::Hardware:
         auto buffer = mPixelStorage.hardware.buffer;
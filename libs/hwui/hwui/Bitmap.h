@@ -49,6 +49,14 @@ public:
 
     static sk_sp<Bitmap> allocateHardwareBitmap(SkBitmap& bitmap);
 
+    /**
+     * Allocates a hardware bitmap whose pixels are written by the CPU, between
+     * graphicBuffer()->lock() and unlock(), instead of being uploaded from an SkBitmap.
+     * This saves the staging copy of allocateHardwareBitmap(). Returns nullptr if info
+     * isn't kRGBA_8888_SkColorType.
+     */
+    static sk_sp<Bitmap> allocateCpuWritableHardwareBitmap(const SkImageInfo& info);
+
     static sk_sp<Bitmap> allocateAshmemBitmap(SkBitmap* bitmap, SkColorTable* ctable);
     static sk_sp<Bitmap> allocateAshmemBitmap(size_t allocSize, const SkImageInfo& info,
         size_t rowBytes, SkColorTable* ctable);
@@ -23,9 +23,69 @@
 #include "Paint.h"
 #include "SkPathMeasure.h"
 #include "Typeface.h"
+#include "thread/Task.h"
+#include "thread/TaskManager.h"
+#include "thread/TaskProcessor.h"
+
+#include <atomic>
+#include <vector>
 
 namespace android {
 
+using uirenderer::Task;
+using uirenderer::TaskManager;
+using uirenderer::TaskProcessor;
+
+// Past this the UI thread is producing text faster than it can be shaped ahead of time
+static const int kMaxPendingPrefetches = 64;
+
+class LayoutPrefetchTask : public Task<bool> {
+public:
+    std::vector<uint16_t> text;
+    size_t start;
+    size_t count;
+    int bidiFlags;
+    minikin::FontStyle style;
+    minikin::MinikinPaint paint;
+    std::shared_ptr<minikin::FontCollection> fontCollection;
+};
+
+class LayoutPrefetchProcessor : public TaskProcessor<bool> {
+public:
+    explicit LayoutPrefetchProcessor(TaskManager* manager)
+            : TaskProcessor<bool>(manager) {}
+
+    // Reserves a slot for a new prefetch, returns false if too many are pending
+    bool tryReserve() {
+        if (mPendingCount.fetch_add(1) >= kMaxPendingPrefetches) {
+            mPendingCount--;
+            return false;
+        }
+        return true;
+    }
+
+    virtual void onProcess(const sp<Task<bool> >& task) override {
+        ATRACE_NAME("prefetchLayout");
+        LayoutPrefetchTask* t = static_cast<LayoutPrefetchTask*>(task.get());
+        // Only the side effect on the layout cache matters
+        minikin::Layout layout;
+        layout.doLayout(t->text.data(), t->start, t->count, t->text.size(), t->bidiFlags,
+                t->style, t->paint, t->fontCollection);
+        t->setResult(true);
+        mPendingCount--;
+    }
+
+private:
+    std::atomic<int> mPendingCount { 0 };
+};
+
+static LayoutPrefetchProcessor& getLayoutPrefetchProcessor() {
+    // Kept apart from the workers of the RenderThread, prefetches must never delay a frame
+    static TaskManager* sTaskManager = new TaskManager();
+    static sp<LayoutPrefetchProcessor> sProcessor = new LayoutPrefetchProcessor(sTaskManager);
+    return *sProcessor;
+}
+
 minikin::FontStyle MinikinUtils::prepareMinikinPaint(minikin::MinikinPaint* minikinPaint,
         const Paint* paint, Typeface* typeface) {
     const Typeface* resolvedFace = Typeface::resolveDefault(typeface);
@@ -73,6 +133,23 @@ float MinikinUtils::measureText(const Paint* paint, int bidiFlags, Typeface* typ
             minikinPaint, resolvedTypeface->fFontCollection, advances);
 }
 
+void MinikinUtils::prefetchLayout(const Paint* paint, int bidiFlags, Typeface* typeface,
+        const uint16_t* buf, size_t start, size_t count, size_t bufSize) {
+    LayoutPrefetchProcessor& processor = getLayoutPrefetchProcessor();
+    if (!processor.tryReserve()) {
+        return;
+    }
+    sp<LayoutPrefetchTask> task = new LayoutPrefetchTask();
+    task->text.assign(buf, buf + bufSize);
+    task->start = start;
+    task->count = count;
+    task->bidiFlags = bidiFlags;
+    task->style = prepareMinikinPaint(&task->paint, paint, typeface);
+    // Holding on to the collection rather than the typeface keeps the fonts alive
+    task->fontCollection = Typeface::resolveDefault(typeface)->fFontCollection;
+    processor.add(task);
+}
+
 bool MinikinUtils::hasVariationSelector(Typeface* typeface, uint32_t codepoint, uint32_t vs) {
     const Typeface* resolvedFace = Typeface::resolveDefault(typeface);
     return resolvedFace->fFontCollection->hasVariationSelector(codepoint, vs);
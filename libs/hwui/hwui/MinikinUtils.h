@@ -44,6 +44,16 @@ public:
     ANDROID_API static float measureText(const Paint* paint, int bidiFlags, Typeface* typeface,
             const uint16_t* buf, size_t start, size_t count, size_t bufSize, float *advances);
 
+    /**
+     * Shapes the text on a worker thread, so that a later doLayout() or measureText() of the
+     * same text with the same paint finds its words in the minikin layout cache. The text and
+     * the paint are copied, they don't need to outlive the call. Requests are dropped while
+     * too many are pending.
+     */
+    ANDROID_API static void prefetchLayout(const Paint* paint, int bidiFlags,
+            Typeface* typeface, const uint16_t* buf, size_t start, size_t count,
+            size_t bufSize);
+
     ANDROID_API static bool hasVariationSelector(Typeface* typeface, uint32_t codepoint,
             uint32_t vs);
 
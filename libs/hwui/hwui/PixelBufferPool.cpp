@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PixelBufferPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace android {
+
+// Enough for a couple of full screen bitmaps
+static const size_t kPoolMaxSize = 32 * 1024 * 1024;
+
+PixelBufferPool& PixelBufferPool::getInstance() {
+    static PixelBufferPool* sInstance = new PixelBufferPool(kPoolMaxSize);
+    return *sInstance;
+}
+
+PixelBufferPool::PixelBufferPool(size_t maxSize)
+        : mMaxSize(maxSize) {}
+
+PixelBufferPool::~PixelBufferPool() {
+    clear();
+}
+
+bool PixelBufferPool::isPooled(size_t size) const {
+    return size >= kMinPooledSize && size <= mMaxSize / 2;
+}
+
+void* PixelBufferPool::allocate(size_t size) {
+    if (!isPooled(size)) {
+        return calloc(size, 1);
+    }
+    void* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+            if (it->size == size) {
+                buffer = it->buffer;
+                mSize -= size;
+                mEntries.erase(it);
+                break;
+            }
+        }
+    }
+    if (!buffer) {
+        return calloc(size, 1);
+    }
+    // Callers rely on calloc() semantics, decoders skip writing zeroes
+    memset(buffer, 0, size);
+    return buffer;
+}
+
+void PixelBufferPool::release(void* buffer, size_t size) {
+    if (!buffer || !isPooled(size)) {
+        free(buffer);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    trimToSize(mMaxSize - size);
+    mEntries.push_front({buffer, size});
+    mSize += size;
+}
+
+void PixelBufferPool::clear() {
+    std::lock_guard<std::mutex> lock(mLock);
+    trimToSize(0);
+}
+
+size_t PixelBufferPool::getSize() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mSize;
+}
+
+size_t PixelBufferPool::getCount() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mEntries.size();
+}
+
+void PixelBufferPool::trimToSize(size_t maxSize) {
+    while (mSize > maxSize) {
+        Entry& oldest = mEntries.back();
+        free(oldest.buffer);
+        mSize -= oldest.size;
+        mEntries.pop_back();
+    }
+}
+
+} // namespace android
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "utils/Macros.h"
+
+#include <list>
+#include <mutex>
+#include <stddef.h>
+
+namespace android {
+
+/**
+ * Pool of recently freed pixel buffers of heap bitmaps. Image feeds keep decoding bitmaps of
+ * the same few sizes, handing them the pixels of the ones just freed saves the mmap, page
+ * faults and munmap that every large allocation otherwise goes through.
+ *
+ * Requests are only served by buffers of the exact same size, which is what bitmaps of the
+ * same dimensions and config need, and lets release() take buffers it didn't allocate. Only
+ * buffers of at least kMinPooledSize, and at most half of the budget, are pooled. When over
+ * budget the least recently released buffers are freed first.
+ */
+class ANDROID_API PixelBufferPool {
+    PREVENT_COPY_AND_ASSIGN(PixelBufferPool);
+public:
+    static PixelBufferPool& getInstance();
+
+    explicit PixelBufferPool(size_t maxSize);
+    ~PixelBufferPool();
+
+    /**
+     * Returns a zero initialized buffer of size bytes, or nullptr if out of memory. It must
+     * be handed back to release() or free().
+     */
+    void* allocate(size_t size);
+
+    /**
+     * Keeps a malloc() allocated buffer around for a later allocate() of the same size, or
+     * frees it.
+     */
+    void release(void* buffer, size_t size);
+
+    /**
+     * Frees all the pooled buffers.
+     */
+    void clear();
+
+    size_t getMaxSize() const { return mMaxSize; }
+
+    /**
+     * Returns the size in bytes of the buffers currently pooled, and their count.
+     */
+    size_t getSize();
+    size_t getCount();
+
+    // Smaller allocations are cheap enough for malloc
+    static constexpr size_t kMinPooledSize = 64 * 1024;
+
+private:
+    struct Entry {
+        void* buffer;
+        size_t size;
+    };
+
+    bool isPooled(size_t size) const;
+    void trimToSize(size_t maxSize);
+
+    const size_t mMaxSize;
+
+    std::mutex mLock;
+    // Most recently released first
+    std::list<Entry> mEntries;
+    size_t mSize = 0;
+};
+
+} // namespace android
@@ -92,6 +92,7 @@ bool SkiaDisplayList::prepareListAndChildren(TreeObserver& observer, TreeInfo& i
         // If any vector drawable in the display list needs update, damage the node.
         if (vectorDrawable->isDirty()) {
             isDirty = true;
+            info.canvasContext.scheduleVectorDrawableUpdate(vectorDrawable);
         }
         vectorDrawable->setPropertyChangeWillBeConsumed(true);
     }
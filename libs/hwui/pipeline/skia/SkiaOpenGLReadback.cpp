@@ -31,15 +31,10 @@ namespace android {
 namespace uirenderer {
 namespace skiapipeline {
 
-CopyResult SkiaOpenGLReadback::copyImageInto(EGLImageKHR eglImage, const Matrix4& imgTransform,
-        int imgWidth, int imgHeight, const Rect& srcRect, SkBitmap* bitmap) {
-
-    GLuint sourceTexId;
-    glGenTextures(1, &sourceTexId);
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, sourceTexId);
-    glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, eglImage);
-
-    sk_sp<GrContext> grContext = sk_ref_sp(mRenderThread.getGrContext());
+// Returns the context to draw the readback with. Resets its GL state, which must be done after
+// any texture was bound for the readback.
+static sk_sp<GrContext> getReadbackContext(RenderThread& renderThread) {
+    sk_sp<GrContext> grContext = sk_ref_sp(renderThread.getGrContext());
     if (Properties::getRenderPipelineType() == RenderPipelineType::SkiaVulkan) {
         sk_sp<const GrGLInterface> glInterface(GrGLCreateNativeInterface());
         LOG_ALWAYS_FATAL_IF(!glInterface.get());
@@ -48,10 +43,15 @@ CopyResult SkiaOpenGLReadback::copyImageInto(EGLImageKHR eglImage, const Matrix4
     } else {
         grContext->resetContext();
     }
+    return grContext;
+}
 
+// Takes ownership of the external texture
+static sk_sp<SkImage> adoptExternalTexture(GrContext* grContext, GLuint texId,
+        int imgWidth, int imgHeight) {
     GrGLTextureInfo externalTexture;
     externalTexture.fTarget = GL_TEXTURE_EXTERNAL_OES;
-    externalTexture.fID = sourceTexId;
+    externalTexture.fID = texId;
 
     GrBackendTextureDesc textureDescription;
     textureDescription.fWidth = imgWidth;
@@ -59,54 +59,74 @@ CopyResult SkiaOpenGLReadback::copyImageInto(EGLImageKHR eglImage, const Matrix4
     textureDescription.fConfig = kRGBA_8888_GrPixelConfig;
     textureDescription.fOrigin = kTopLeft_GrSurfaceOrigin;
     textureDescription.fTextureHandle = reinterpret_cast<GrBackendObject>(&externalTexture);
+    return SkImage::MakeFromAdoptedTexture(grContext, textureDescription);
+}
+
+// Maps srcRect into the coordinates of the image, returns false if nothing of it is left
+static bool computeImageSrcRect(const Matrix4& imgTransform, int imgWidth, int imgHeight,
+        const Rect& srcRect, SkRect* outSrcRect) {
+    // convert to Skia data structures
+    const SkRect bufferRect = SkRect::MakeIWH(imgWidth, imgHeight);
+    SkRect skiaSrcRect = srcRect.toSkRect();
+    SkMatrix textureMatrix;
+    imgTransform.copyTo(textureMatrix);
+
+    // remove the y-flip applied to the matrix so that we can scale the srcRect.
+    // This flip is not needed as we specify the origin of the texture when we
+    // wrap it as an SkImage.
+    SkMatrix yFlip = SkMatrix::MakeScale(1, -1);
+    yFlip.postTranslate(0,1);
+    textureMatrix.preConcat(yFlip);
+
+    // copy the entire src if the rect is empty
+    if (skiaSrcRect.isEmpty()) {
+        skiaSrcRect = bufferRect;
+    }
+
+    // since the y-flip has been removed we can simply scale & translate
+    // the source rectangle
+    textureMatrix.mapRect(&skiaSrcRect);
+
+    if (!skiaSrcRect.intersect(bufferRect)) {
+        return false;
+    }
+    *outSrcRect = skiaSrcRect;
+    return true;
+}
+
+CopyResult SkiaOpenGLReadback::copyImageInto(EGLImageKHR eglImage, const Matrix4& imgTransform,
+        int imgWidth, int imgHeight, const Rect& srcRect, SkBitmap* bitmap) {
+
+    GLuint sourceTexId;
+    glGenTextures(1, &sourceTexId);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, sourceTexId);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, eglImage);
+
+    sk_sp<GrContext> grContext = getReadbackContext(mRenderThread);
 
     CopyResult copyResult = CopyResult::UnknownError;
-    sk_sp<SkImage> image(SkImage::MakeFromAdoptedTexture(grContext.get(), textureDescription));
-    if (image) {
+    sk_sp<SkImage> image(adoptExternalTexture(grContext.get(), sourceTexId, imgWidth, imgHeight));
+    SkRect skiaSrcRect;
+    if (image && computeImageSrcRect(imgTransform, imgWidth, imgHeight, srcRect, &skiaSrcRect)) {
         SkAutoLockPixels alp(*bitmap);
-
-        // convert to Skia data structures
-        const SkRect bufferRect = SkRect::MakeIWH(imgWidth, imgHeight);
-        SkRect skiaSrcRect = srcRect.toSkRect();
-        SkMatrix textureMatrix;
-        imgTransform.copyTo(textureMatrix);
-
-        // remove the y-flip applied to the matrix so that we can scale the srcRect.
-        // This flip is not needed as we specify the origin of the texture when we
-        // wrap it as an SkImage.
-        SkMatrix yFlip = SkMatrix::MakeScale(1, -1);
-        yFlip.postTranslate(0,1);
-        textureMatrix.preConcat(yFlip);
-
-        // copy the entire src if the rect is empty
-        if (skiaSrcRect.isEmpty()) {
-            skiaSrcRect = bufferRect;
+        SkPoint srcOrigin = SkPoint::Make(skiaSrcRect.fLeft, skiaSrcRect.fTop);
+
+        // if we need to scale the result we must render to an offscreen buffer
+        if (bitmap->width() != skiaSrcRect.width()
+                || bitmap->height() != skiaSrcRect.height()) {
+            sk_sp<SkSurface> scaledSurface = SkSurface::MakeRenderTarget(
+                    grContext.get(), SkBudgeted::kYes, bitmap->info());
+            SkPaint paint;
+            paint.setBlendMode(SkBlendMode::kSrc);
+            scaledSurface->getCanvas()->drawImageRect(image, skiaSrcRect,
+                    SkRect::MakeWH(bitmap->width(), bitmap->height()), &paint);
+            image = scaledSurface->makeImageSnapshot();
+            srcOrigin.set(0,0);
         }
 
-        // since the y-flip has been removed we can simply scale & translate
-        // the source rectangle
-        textureMatrix.mapRect(&skiaSrcRect);
-
-        if (skiaSrcRect.intersect(bufferRect)) {
-            SkPoint srcOrigin = SkPoint::Make(skiaSrcRect.fLeft, skiaSrcRect.fTop);
-
-            // if we need to scale the result we must render to an offscreen buffer
-            if (bitmap->width() != skiaSrcRect.width()
-                    || bitmap->height() != skiaSrcRect.height()) {
-                sk_sp<SkSurface> scaledSurface = SkSurface::MakeRenderTarget(
-                        grContext.get(), SkBudgeted::kYes, bitmap->info());
-                SkPaint paint;
-                paint.setBlendMode(SkBlendMode::kSrc);
-                scaledSurface->getCanvas()->drawImageRect(image, skiaSrcRect,
-                        SkRect::MakeWH(bitmap->width(), bitmap->height()), &paint);
-                image = scaledSurface->makeImageSnapshot();
-                srcOrigin.set(0,0);
-            }
-
-            if (image->readPixels(bitmap->info(), bitmap->getPixels(), bitmap->rowBytes(),
-                                  srcOrigin.fX, srcOrigin.fY)) {
-                copyResult = CopyResult::Success;
-            }
+        if (image->readPixels(bitmap->info(), bitmap->getPixels(), bitmap->rowBytes(),
+                              srcOrigin.fX, srcOrigin.fY)) {
+            copyResult = CopyResult::Success;
         }
     }
 
@@ -116,6 +136,64 @@ CopyResult SkiaOpenGLReadback::copyImageInto(EGLImageKHR eglImage, const Matrix4
     return copyResult;
 }
 
+CopyResult SkiaOpenGLReadback::copyImageIntoImage(EGLImageKHR eglImage,
+        const Matrix4& imgTransform, int imgWidth, int imgHeight, const Rect& srcRect,
+        EGLImageKHR destImage, int destWidth, int destHeight) {
+    GLuint sourceTexId;
+    glGenTextures(1, &sourceTexId);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, sourceTexId);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, eglImage);
+
+    GLuint destTexId;
+    glGenTextures(1, &destTexId);
+    glBindTexture(GL_TEXTURE_2D, destTexId);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, destImage);
+
+    sk_sp<GrContext> grContext = getReadbackContext(mRenderThread);
+
+    GrGLTextureInfo destTexture;
+    destTexture.fTarget = GL_TEXTURE_2D;
+    destTexture.fID = destTexId;
+
+    GrBackendTextureDesc destDescription;
+    destDescription.fFlags = kRenderTarget_GrBackendTextureFlag;
+    destDescription.fWidth = destWidth;
+    destDescription.fHeight = destHeight;
+    destDescription.fConfig = kRGBA_8888_GrPixelConfig;
+    destDescription.fOrigin = kTopLeft_GrSurfaceOrigin;
+    destDescription.fTextureHandle = reinterpret_cast<GrBackendObject>(&destTexture);
+
+    CopyResult copyResult = CopyResult::UnknownError;
+    sk_sp<SkImage> image(adoptExternalTexture(grContext.get(), sourceTexId, imgWidth, imgHeight));
+    sk_sp<SkSurface> destSurface(SkSurface::MakeFromBackendTexture(grContext.get(),
+            destDescription, nullptr, nullptr));
+    SkRect skiaSrcRect;
+    if (image && destSurface
+            && computeImageSrcRect(imgTransform, imgWidth, imgHeight, srcRect, &skiaSrcRect)) {
+        SkPaint paint;
+        paint.setBlendMode(SkBlendMode::kSrc);
+        paint.setFilterQuality(kLow_SkFilterQuality);
+        destSurface->getCanvas()->drawImageRect(image, skiaSrcRect,
+                SkRect::MakeIWH(destWidth, destHeight), &paint);
+        destSurface->getCanvas()->flush();
+        copyResult = CopyResult::Success;
+    }
+
+    // Vulkan draws the bitmap through another API, so the copy has to be complete
+    if (Properties::getRenderPipelineType() == RenderPipelineType::SkiaVulkan) {
+        glFinish();
+    } else {
+        glFlush();
+    }
+
+    // the textures wrapped by Skia must be released before the EGLImages are destroyed
+    destSurface.reset();
+    image.reset();
+    glDeleteTextures(1, &destTexId);
+    grContext->resetContext(kTextureBinding_GrGLBackendState);
+    return copyResult;
+}
+
 } /* namespace skiapipeline */
 } /* namespace uirenderer */
 } /* namespace android */
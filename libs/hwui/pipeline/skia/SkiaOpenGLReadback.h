@@ -28,6 +28,9 @@ public:
 protected:
     virtual CopyResult copyImageInto(EGLImageKHR eglImage, const Matrix4& imgTransform,
             int imgWidth, int imgHeight, const Rect& srcRect, SkBitmap* bitmap) override;
+    virtual CopyResult copyImageIntoImage(EGLImageKHR eglImage, const Matrix4& imgTransform,
+            int imgWidth, int imgHeight, const Rect& srcRect,
+            EGLImageKHR destImage, int destWidth, int destHeight) override;
 };
 
 } /* namespace skiapipeline */
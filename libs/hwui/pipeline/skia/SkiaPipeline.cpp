@@ -26,6 +26,7 @@
 #include <SkPixelSerializer.h>
 #include <SkStream.h>
 
+#include <algorithm>
 #include <unistd.h>
 
 using namespace android::uirenderer::renderthread;
@@ -79,6 +80,10 @@ void SkiaPipeline::renderLayers(const FrameBuilder::LightGeometry& lightGeometry
 }
 
 void SkiaPipeline::renderLayersImpl(const LayerUpdateQueue& layers, bool opaque) {
+    // Layers are flushed once they have all been rendered, rather than one by one, so that
+    // their work reaches the GPU in as few submissions as possible.
+    GrContext* pendingContext = nullptr;
+
     // Render all layers that need to be updated, in order.
     for (size_t i = 0; i < layers.entries().size(); i++) {
         RenderNode* layerNode = layers.entries()[i].renderNode.get();
@@ -91,7 +96,7 @@ void SkiaPipeline::renderLayersImpl(const LayerUpdateQueue& layers, bool opaque)
             SkiaDisplayList* displayList = (SkiaDisplayList*)layerNode->getDisplayList();
             if (!displayList || displayList->isEmpty()) {
                 SkDEBUGF(("%p drawLayers(%s) : missing drawable", this, layerNode->getName()));
-                return;
+                continue;
             }
 
             const Rect& layerDamage = layers.entries()[i].damage;
@@ -110,7 +115,9 @@ void SkiaPipeline::renderLayersImpl(const LayerUpdateQueue& layers, bool opaque)
             const RenderProperties& properties = layerNode->properties();
             const SkRect bounds = SkRect::MakeWH(properties.getWidth(), properties.getHeight());
             if (properties.getClipToBounds() && layerCanvas->quickReject(bounds)) {
-                return;
+                layerCanvas->restoreToCount(saveCount);
+                mLightCenter = savedLightCenter;
+                continue;
             }
 
             layerNode->getSkiaLayer()->hasRenderedSinceRepaint = false;
@@ -119,10 +126,19 @@ void SkiaPipeline::renderLayersImpl(const LayerUpdateQueue& layers, bool opaque)
             RenderNodeDrawable root(layerNode, layerCanvas, false);
             root.forceDraw(layerCanvas);
             layerCanvas->restoreToCount(saveCount);
-            layerCanvas->flush();
             mLightCenter = savedLightCenter;
+
+            GrContext* context = layerCanvas->getGrContext();
+            if (pendingContext && pendingContext != context) {
+                pendingContext->flush();
+            }
+            pendingContext = context;
         }
     }
+
+    if (pendingContext) {
+        pendingContext->flush();
+    }
 }
 
 bool SkiaPipeline::createOrUpdateLayer(RenderNode* node,
@@ -176,6 +192,27 @@ public:
     }
 };
 
+std::string SkiaPipeline::getCaptureFilePath() {
+    if (mCaptureFramesRemaining == 0) {
+        char prop[PROPERTY_VALUE_MAX];
+        property_get(PROPERTY_CAPTURE_SKP_FILENAME, prop, "0");
+        if (prop[0] == '0' || access(prop, F_OK) == 0) {
+            return std::string();
+        }
+        mCapturePath = prop;
+        mCapturedFrames = 0;
+        mCaptureFramesRemaining = std::max(1, property_get_int32(PROPERTY_CAPTURE_SKP_FRAMES, 1));
+    }
+
+    std::string path = mCapturePath;
+    if (mCapturedFrames > 0) {
+        path += "_" + std::to_string(mCapturedFrames);
+    }
+    mCapturedFrames++;
+    mCaptureFramesRemaining--;
+    return path;
+}
+
 void SkiaPipeline::renderFrame(const LayerUpdateQueue& layers, const SkRect& clip,
         const std::vector<sp<RenderNode>>& nodes, bool opaque, const Rect &contentDrawBounds,
         sk_sp<SkSurface> surface) {
@@ -187,12 +224,10 @@ void SkiaPipeline::renderFrame(const LayerUpdateQueue& layers, const SkRect& cli
     SkCanvas* canvas = surface->getCanvas();
 
     std::unique_ptr<SkPictureRecorder> recorder;
-    bool recordingPicture = false;
-    char prop[PROPERTY_VALUE_MAX];
-    if (skpCaptureEnabled()) {
-        property_get("debug.hwui.capture_frame_as_skp", prop, "0");
-        recordingPicture = prop[0] != '0' && access(prop, F_OK) != 0;
-        if (recordingPicture) {
+    std::string capturePath;
+    if (CC_UNLIKELY(skpCaptureEnabled())) {
+        capturePath = getCaptureFilePath();
+        if (!capturePath.empty()) {
             recorder.reset(new SkPictureRecorder());
             canvas = recorder->beginRecording(surface->width(), surface->height(),
                     nullptr, SkPictureRecorder::kPlaybackDrawPicture_RecordFlag);
@@ -201,18 +236,20 @@ void SkiaPipeline::renderFrame(const LayerUpdateQueue& layers, const SkRect& cli
 
     renderFrameImpl(layers, clip, nodes, opaque, contentDrawBounds, canvas);
 
-    if (skpCaptureEnabled() && recordingPicture) {
+    if (CC_UNLIKELY(recorder.get())) {
         sk_sp<SkPicture> picture = recorder->finishRecordingAsPicture();
         if (picture->approximateOpCount() > 0) {
-            SkFILEWStream stream(prop);
+            SkFILEWStream stream(capturePath.c_str());
             if (stream.isValid()) {
                 PngPixelSerializer serializer;
                 picture->serialize(&stream, &serializer);
                 stream.flush();
-                SkDebugf("Captured Drawing Output (%d bytes) for frame. %s", stream.bytesWritten(), prop);
+                SkDebugf("Captured Drawing Output (%d bytes) for frame. %s", stream.bytesWritten(),
+                        capturePath.c_str());
             }
         }
         surface->getCanvas()->drawPicture(picture);
+        canvas = surface->getCanvas();
     }
 
     if (CC_UNLIKELY(Properties::debugOverdraw)) {
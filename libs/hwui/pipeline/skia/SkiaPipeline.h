@@ -21,6 +21,8 @@
 #include "renderthread/IRenderPipeline.h"
 #include <SkSurface.h>
 
+#include <string>
+
 namespace android {
 namespace uirenderer {
 namespace skiapipeline {
@@ -55,7 +57,7 @@ public:
 
     static void renderLayersImpl(const LayerUpdateQueue& layers, bool opaque);
 
-    static bool skpCaptureEnabled() { return false; }
+    static bool skpCaptureEnabled() { return Properties::skpCaptureEnabled; }
 
     static float getLightRadius() {
         if (CC_UNLIKELY(Properties::overrideLightRadius > 0)) {
@@ -119,8 +121,17 @@ private:
             const std::vector< sp<RenderNode> >& nodes, const Rect &contentDrawBounds,
             sk_sp<SkSurface>);
 
+    // Starts a capture if one was requested, returns the path of the SKP file to write the
+    // current frame to, or an empty string if the frame isn't captured.
+    std::string getCaptureFilePath();
+
     TaskManager mTaskManager;
     std::vector<sk_sp<SkImage>> mPinnedImages;
+
+    std::string mCapturePath;
+    int mCapturedFrames = 0;
+    int mCaptureFramesRemaining = 0;
+
     static float mLightRadius;
     static uint8_t mAmbientShadowAlpha;
     static uint8_t mSpotShadowAlpha;
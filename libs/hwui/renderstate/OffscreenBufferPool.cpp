@@ -130,6 +130,23 @@ int OffscreenBufferPool::Entry::compare(const Entry& lhs, const Entry& rhs) {
     return int(lhs.height) - int(rhs.height);
 }
 
+bool OffscreenBufferPool::isInSizeClass(const OffscreenBuffer* layer,
+        const uint32_t width, const uint32_t height) {
+    const uint32_t idealWidth = OffscreenBuffer::computeIdealDimension(width);
+    const uint32_t idealHeight = OffscreenBuffer::computeIdealDimension(height);
+    return layer->texture.width() >= idealWidth
+            && layer->texture.width() <= idealWidth + LAYER_SIZE
+            && layer->texture.height() >= idealHeight
+            && layer->texture.height() <= idealHeight + LAYER_SIZE;
+}
+
+void OffscreenBufferPool::deleteEntry(std::multiset<Entry>::iterator iter) {
+    OffscreenBuffer* victim = iter->layer;
+    mSize -= victim->getSizeInBytes();
+    delete victim;
+    mPool.erase(iter);
+}
+
 void OffscreenBufferPool::clear() {
     for (auto& entry : mPool) {
         delete entry.layer;
@@ -138,14 +155,29 @@ void OffscreenBufferPool::clear() {
     mSize = 0;
 }
 
+void OffscreenBufferPool::trimUnused(nsecs_t now) {
+    for (auto iter = mPool.begin(); iter != mPool.end();) {
+        auto current = iter++;
+        if (now - current->lastUsedTime > kMaxUnusedTime) {
+            deleteEntry(current);
+        }
+    }
+}
+
 OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
         const uint32_t width, const uint32_t height) {
     OffscreenBuffer* layer = nullptr;
 
+    // Entries are sorted by width then height, so the exact size comes first, followed by
+    // the slightly larger textures of the same size class
     Entry entry(width, height);
-    auto iter = mPool.find(entry);
+    auto iter = mPool.lower_bound(entry);
+    while (iter != mPool.end() && iter->width <= entry.width + LAYER_SIZE
+            && !isInSizeClass(iter->layer, width, height)) {
+        iter++;
+    }
 
-    if (iter != mPool.end()) {
+    if (iter != mPool.end() && isInSizeClass(iter->layer, width, height)) {
         entry = *iter;
         mPool.erase(iter);
 
@@ -153,8 +185,10 @@ OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
         layer->viewportWidth = width;
         layer->viewportHeight = height;
         mSize -= layer->getSizeInBytes();
+        mHitCount++;
     } else {
         layer = new OffscreenBuffer(renderState, Caches::getInstance(), width, height);
+        mMissCount++;
     }
 
     return layer;
@@ -163,8 +197,7 @@ OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
 OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
         const uint32_t width, const uint32_t height) {
     RenderState& renderState = layer->renderState;
-    if (layer->texture.width() == OffscreenBuffer::computeIdealDimension(width)
-            && layer->texture.height() == OffscreenBuffer::computeIdealDimension(height)) {
+    if (isInSizeClass(layer, width, height)) {
         // resize in place
         layer->viewportWidth = width;
         layer->viewportHeight = height;
@@ -178,6 +211,7 @@ OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
 }
 
 void OffscreenBufferPool::dump() {
+    ALOGD("  Layer pool hits %u, misses %u", mHitCount, mMissCount);
     for (auto entry : mPool) {
         ALOGD("  Layer size %dx%d", entry.width, entry.height);
     }
@@ -185,20 +219,25 @@ void OffscreenBufferPool::dump() {
 
 void OffscreenBufferPool::putOrDelete(OffscreenBuffer* layer) {
     const uint32_t size = layer->getSizeInBytes();
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    trimUnused(now);
+
     // Don't even try to cache a layer that's bigger than the cache
     if (size < mMaxSize) {
-        // TODO: Use an LRU
         while (mSize + size > mMaxSize) {
-            OffscreenBuffer* victim = mPool.begin()->layer;
-            mSize -= victim->getSizeInBytes();
-            delete victim;
-            mPool.erase(mPool.begin());
+            auto victim = mPool.begin();
+            for (auto iter = mPool.begin(); iter != mPool.end(); iter++) {
+                if (iter->lastUsedTime < victim->lastUsedTime) {
+                    victim = iter;
+                }
+            }
+            deleteEntry(victim);
         }
 
         // clear region, since it's no longer valid
         layer->region.clear();
 
-        Entry entry(layer);
+        Entry entry(layer, now);
 
         mPool.insert(entry);
         mSize += size;
@@ -22,6 +22,7 @@
 #include "Texture.h"
 #include "utils/Macros.h"
 #include <ui/Region.h>
+#include <utils/Timers.h>
 
 #include <set>
 
@@ -83,6 +84,12 @@ public:
 
 /**
  * Pool of OffscreenBuffers allocated, but not currently in use.
+ *
+ * A request is served by any pooled buffer of its size class, that is a texture at most one
+ * LAYER_SIZE step larger than ideal in each dimension, so that layers that grow or shrink a
+ * little every frame keep reusing the same textures. When the pool is over its byte budget the
+ * least recently returned buffers go first, and buffers left unused for too long are dropped
+ * the next time the pool is touched.
  */
 class OffscreenBufferPool {
 public:
@@ -102,6 +109,11 @@ public:
      */
     void clear();
 
+    /**
+     * Deletes the layers that have not been used for longer than kMaxUnusedTime.
+     */
+    void trimUnused(nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC));
+
     /**
      * Returns the maximum size of the pool in bytes.
      */
@@ -114,6 +126,17 @@ public:
 
     size_t getCount() { return mPool.size(); }
 
+    /**
+     * Returns how many calls to get() were served from the pool, and how many had to allocate.
+     */
+    uint32_t getHitCount() { return mHitCount; }
+    uint32_t getMissCount() { return mMissCount; }
+
+    /**
+     * Layers returned to the pool are deleted once they have been unused for this long.
+     */
+    static constexpr nsecs_t kMaxUnusedTime = 10000000000LL; // 10s
+
     /**
      * Prints out the content of the pool.
      */
@@ -126,10 +149,11 @@ private:
                 : width(OffscreenBuffer::computeIdealDimension(layerWidth))
                 , height(OffscreenBuffer::computeIdealDimension(layerHeight)) {}
 
-        explicit Entry(OffscreenBuffer* layer)
+        Entry(OffscreenBuffer* layer, nsecs_t lastUsedTime)
                 : layer(layer)
                 , width(layer->texture.width())
-                , height(layer->texture.height()) {
+                , height(layer->texture.height())
+                , lastUsedTime(lastUsedTime) {
         }
 
         static int compare(const Entry& lhs, const Entry& rhs);
@@ -149,12 +173,21 @@ private:
         OffscreenBuffer* layer = nullptr;
         uint32_t width = 0;
         uint32_t height = 0;
+        nsecs_t lastUsedTime = 0;
     }; // struct Entry
 
+    static bool isInSizeClass(const OffscreenBuffer* layer,
+            const uint32_t width, const uint32_t height);
+
+    void deleteEntry(std::multiset<Entry>::iterator iter);
+
     std::multiset<Entry> mPool;
 
     uint32_t mSize = 0;
     uint32_t mMaxSize;
+
+    uint32_t mHitCount = 0;
+    uint32_t mMissCount = 0;
 }; // class OffscreenBufferCache
 
 }; // namespace uirenderer
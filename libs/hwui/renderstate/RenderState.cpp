@@ -24,8 +24,10 @@
 #include "utils/GLUtils.h"
 
 #include <algorithm>
+#include <functional>
 
 #include <ui/ColorSpace.h>
+#include <utils/Trace.h>
 
 namespace android {
 namespace uirenderer {
@@ -122,6 +124,37 @@ void RenderState::flush(Caches::FlushMode mode) {
     mCaches->flush(mode);
 }
 
+void RenderState::trimToMemoryBudget(uint32_t budget) {
+    if (!mCaches || budget == 0) return;
+
+    auto overBudget = [this, budget]() {
+        return mLayerPool.getSize() + mCaches->getCacheMemoryUsage() > budget;
+    };
+    if (!overBudget()) return;
+
+    ATRACE_NAME("trimToMemoryBudget");
+    // Ordered by the cost of getting the content back: pooled layers and render buffers are
+    // only reallocated, tessellations, shadows, gradients and path masks are regenerated on the
+    // CPU, while glyphs and bitmaps need rasterizing or decoding and uploading again. The
+    // texture cache goes last since it is the only one that evicts partially, by recency.
+    const std::function<void()> steps[] = {
+        [this]() { mLayerPool.trimUnused(); },
+        [this]() { mCaches->renderBufferCache.clear(); },
+        [this]() { mCaches->tessellationCache.clear(); },
+        [this]() { mCaches->dropShadowCache.clear(); },
+        [this]() { mCaches->gradientCache.clear(); },
+        [this]() { mCaches->pathCache.clear(); },
+        [this]() { mLayerPool.clear(); },
+        [this]() { mCaches->fontRenderer.flush(); },
+        [this]() { mCaches->textureCache.flush(); },
+    };
+    for (const auto& step : steps) {
+        step();
+        if (!overBudget()) break;
+    }
+    mCaches->clearGarbage();
+}
+
 void RenderState::onBitmapDestroyed(uint32_t pixelRefId) {
     if (mCaches && mCaches->textureCache.destroyTexture(pixelRefId)) {
         glFlush();
@@ -233,7 +266,10 @@ void RenderState::destroyLayersInUpdater() {
 
 class DecStrongTask : public renderthread::RenderTask {
 public:
-    explicit DecStrongTask(VirtualLightRefBase* object) : mObject(object) {}
+    explicit DecStrongTask(VirtualLightRefBase* object) : mObject(object) {
+        // Only ever used to release GPU resources, such as layers
+        mPriority = renderthread::TaskPriority::Maintenance;
+    }
 
     virtual void run() override {
         mObject->decStrong(nullptr);
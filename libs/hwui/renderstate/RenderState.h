@@ -18,6 +18,7 @@
 
 #include "Caches.h"
 #include "Glop.h"
+#include "Properties.h"
 #include "renderstate/Blend.h"
 #include "renderstate/MeshState.h"
 #include "renderstate/OffscreenBufferPool.h"
@@ -63,6 +64,12 @@ public:
     void onVkContextDestroyed();
 
     void flush(Caches::FlushMode flushMode);
+
+    /**
+     * Evicts cached content, cheapest to rebuild first, until the caches and the layer pool
+     * together use at most budget bytes. Does nothing if budget is 0.
+     */
+    void trimToMemoryBudget(uint32_t budget = Properties::gpuMemoryBudget);
     void onBitmapDestroyed(uint32_t pixelRefId);
 
     void setViewport(GLsizei width, GLsizei height);
@@ -21,9 +21,11 @@
 #include "Caches.h"
 #include "EglManager.h"
 #include "Frame.h"
+#include "GpuCompletionTracker.h"
 #include "LayerUpdateQueue.h"
 #include "Properties.h"
 #include "RenderThread.h"
+#include "VectorDrawable.h"
 #include "hwui/Canvas.h"
 #include "renderstate/RenderState.h"
 #include "renderstate/Stencil.h"
@@ -48,6 +50,7 @@
 
 #define TRIM_MEMORY_COMPLETE 80
 #define TRIM_MEMORY_UI_HIDDEN 20
+#define TRIM_MEMORY_RUNNING_MODERATE 5
 
 #define ENABLE_RENDERNODE_SERIALIZATION false
 
@@ -175,6 +178,10 @@ void CanvasContext::removeRenderNode(RenderNode* node) {
 
 void CanvasContext::destroy() {
     stopDrawing();
+    if (mDeferredLayersQueued) {
+        mRenderThread.remove(&mDeferredLayersTask);
+        mDeferredLayersQueued = false;
+    }
     setSurface(nullptr);
     freePrefetchedLayers();
     destroyHardwareResources();
@@ -324,6 +331,8 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo,
 
     info.damageAccumulator = &mDamageAccumulator;
     info.layerUpdateQueue = &mLayerUpdateQueue;
+    info.windowWidth = mLastFrameWidth;
+    info.windowHeight = mLastFrameHeight;
 
     mAnimationContext->startFrame(info.mode);
     for (const sp<RenderNode>& node : mRenderNodes) {
@@ -337,9 +346,13 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo,
     mAnimationContext->runRemainingAnimations(info);
     GL_CHECKPOINT(MODERATE);
 
+    updateVectorDrawables();
+
     freePrefetchedLayers();
     GL_CHECKPOINT(MODERATE);
 
+    scheduleDeferredLayers(info.out.hasAnimations);
+
     mIsDirty = true;
 
     if (CC_UNLIKELY(!mNativeSurface.get())) {
@@ -412,6 +425,10 @@ void CanvasContext::draw() {
     mCurrentFrameInfo->markIssueDrawCommandsStart();
 
     Frame frame = mRenderPipeline->getFrame();
+    if (CC_UNLIKELY(frame.width() != mLastFrameWidth || frame.height() != mLastFrameHeight)) {
+        // Layers were culled against the previous size of the surface
+        mLayerUpdateQueue.enqueueDeferredLayers();
+    }
 
     SkRect windowDirty = computeDirtyRect(frame, &dirty);
 
@@ -420,6 +437,13 @@ void CanvasContext::draw() {
 
     waitOnFences();
 
+    if (CC_UNLIKELY(mGpuCompletionTracker.get() != nullptr) && drew) {
+        // Inserted before the swap, which flushes it
+        EglManager& eglManager = mRenderThread.eglManager();
+        mGpuCompletionTracker->track(eglManager.eglDisplay(), eglManager.createFence(),
+                mCurrentFrameInfo);
+    }
+
     bool requireSwap = false;
     bool didSwap = mRenderPipeline->swapBuffers(frame, drew, windowDirty, mCurrentFrameInfo,
             &requireSwap);
@@ -487,6 +511,7 @@ void CanvasContext::draw() {
     }
 
     GpuMemoryTracker::onFrameCompleted();
+    mRenderThread.renderState().trimToMemoryBudget();
 #ifdef BUGREPORT_FONT_CACHE_USAGE
     auto renderType = Properties::getRenderPipelineType();
     if (RenderPipelineType::OpenGL == renderType) {
@@ -564,12 +589,41 @@ void CanvasContext::buildLayer(RenderNode* node) {
     mPrefetchedLayers.insert(node);
 }
 
+void CanvasContext::scheduleDeferredLayers(bool hasAnimations) {
+    // How long RenderThread must stay idle before the deferred layers are rendered
+    static const auto DEFERRED_LAYERS_DELAY = 100_ms;
+
+    if (hasAnimations || !mLayerUpdateQueue.hasDeferredLayers()) {
+        // Don't compete with animation frames, the layers will wait for the next idle frame
+        if (mDeferredLayersQueued) {
+            mRenderThread.remove(&mDeferredLayersTask);
+            mDeferredLayersQueued = false;
+        }
+    } else if (!mDeferredLayersQueued) {
+        mDeferredLayersQueued = true;
+        mRenderThread.queueAt(&mDeferredLayersTask,
+                systemTime(CLOCK_MONOTONIC) + DEFERRED_LAYERS_DELAY);
+    }
+}
+
+void CanvasContext::renderDeferredLayers() {
+    ATRACE_CALL();
+    mDeferredLayersQueued = false;
+    if (!mRenderPipeline->isContextReady() || !mLayerUpdateQueue.hasDeferredLayers()) return;
+
+    // Brings the off screen layers up to date, so they don't have to be rendered by the frame
+    // that scrolls them into view
+    mLayerUpdateQueue.enqueueDeferredLayers();
+    mRenderPipeline->renderLayers(mLightGeometry, &mLayerUpdateQueue, mOpaque, mLightInfo);
+}
+
 bool CanvasContext::copyLayerInto(DeferredLayerUpdater* layer, SkBitmap* bitmap) {
     return mRenderPipeline->copyLayerInto(layer, bitmap);
 }
 
 void CanvasContext::destroyHardwareResources() {
     stopDrawing();
+    mLayerUpdateQueue.clearDeferredLayers();
     if (mRenderPipeline->isContextReady()) {
         freePrefetchedLayers();
         for (const sp<RenderNode>& node : mRenderNodes) {
@@ -589,6 +643,11 @@ void CanvasContext::trimMemory(RenderThread& thread, int level) {
         thread.eglManager().destroy();
     } else if (level >= TRIM_MEMORY_UI_HIDDEN) {
         thread.renderState().flush(Caches::FlushMode::Moderate);
+    } else if (level >= TRIM_MEMORY_RUNNING_MODERATE) {
+        // Still visible, only drop the layers that animations stopped using and tighten the
+        // global budget while the system is short on memory
+        thread.renderState().layerPool().trimUnused();
+        thread.renderState().trimToMemoryBudget(Properties::gpuMemoryBudget / 2);
     }
 }
 
@@ -661,6 +720,34 @@ void CanvasContext::serializeDisplayListTree() {
 #endif
 }
 
+void CanvasContext::addFrameMetricsObserver(FrameMetricsObserver* observer) {
+    if (mFrameMetricsReporter.get() == nullptr) {
+        mFrameMetricsReporter.reset(new FrameMetricsReporter());
+        auto renderType = Properties::getRenderPipelineType();
+        if (RenderPipelineType::OpenGL == renderType || RenderPipelineType::SkiaGL == renderType) {
+            mGpuCompletionTracker.reset(new GpuCompletionTracker(mRenderThread, *this));
+        }
+    }
+
+    mFrameMetricsReporter->addObserver(observer);
+}
+
+void CanvasContext::removeFrameMetricsObserver(FrameMetricsObserver* observer) {
+    if (mFrameMetricsReporter.get() != nullptr) {
+        mFrameMetricsReporter->removeObserver(observer);
+        if (!mFrameMetricsReporter->hasObservers()) {
+            mGpuCompletionTracker.reset(nullptr);
+            mFrameMetricsReporter.reset(nullptr);
+        }
+    }
+}
+
+void CanvasContext::onGpuCompleted(const FrameInfo& frame) {
+    if (mFrameMetricsReporter.get() != nullptr) {
+        mFrameMetricsReporter->reportGpuCompleted(frame.data(), frame.gpuCompleted());
+    }
+}
+
 void CanvasContext::waitOnFences() {
     if (mFrameFences.size()) {
         ATRACE_CALL();
@@ -669,6 +756,7 @@ void CanvasContext::waitOnFences() {
         }
         mFrameFences.clear();
     }
+    mDirtyVectorDrawables.clear();
 }
 
 class CanvasContext::FuncTaskProcessor : public TaskProcessor<bool> {
@@ -684,15 +772,40 @@ public:
 };
 
 void CanvasContext::enqueueFrameWork(std::function<void()>&& func) {
+    sp<FuncTask> task(new FuncTask());
+    task->func = func;
+    addFrameWork(task);
+}
+
+void CanvasContext::addFrameWork(const sp<FuncTask>& task) {
     if (!mFrameWorkProcessor.get()) {
         mFrameWorkProcessor = new FuncTaskProcessor(mRenderPipeline->getTaskManager());
     }
-    sp<FuncTask> task(new FuncTask());
-    task->func = func;
+    // The frame waits on this work in its fences, run it ahead of precaching
+    task->setPriority(TaskPriority::High);
     mFrameFences.push_back(task);
     mFrameWorkProcessor->add(task);
 }
 
+void CanvasContext::scheduleVectorDrawableUpdate(VectorDrawableRoot* tree) {
+    mDirtyVectorDrawables.push_back(tree);
+}
+
+void CanvasContext::updateVectorDrawables() {
+    if (mDirtyVectorDrawables.empty()) return;
+
+    ATRACE_CALL();
+    for (auto& tree : mDirtyVectorDrawables) {
+        // mDirtyVectorDrawables keeps the tree alive until the frame waited on its fences
+        VectorDrawableRoot* root = tree.get();
+        sp<FuncTask> task(new FuncTask());
+        task->func = [root]() { root->updateCache(); };
+        if (root->setPendingCacheUpdate(task)) {
+            addFrameWork(task);
+        }
+    }
+}
+
 int64_t CanvasContext::getFrameNumber() {
     // mFrameNumber is reset to -1 when the surface changes or we swap buffers
     if (mFrameNumber == -1 && mNativeSurface.get()) {
@@ -58,6 +58,7 @@ namespace renderthread {
 
 class EglManager;
 class Frame;
+class GpuCompletionTracker;
 
 // This per-renderer class manages the bridge between the global EGL context
 // and the render surface.
@@ -170,26 +171,19 @@ public:
         return mRenderThread.renderState();
     }
 
-    void addFrameMetricsObserver(FrameMetricsObserver* observer) {
-        if (mFrameMetricsReporter.get() == nullptr) {
-            mFrameMetricsReporter.reset(new FrameMetricsReporter());
-        }
-
-        mFrameMetricsReporter->addObserver(observer);
-    }
+    void addFrameMetricsObserver(FrameMetricsObserver* observer);
+    void removeFrameMetricsObserver(FrameMetricsObserver* observer);
 
-    void removeFrameMetricsObserver(FrameMetricsObserver* observer) {
-        if (mFrameMetricsReporter.get() != nullptr) {
-            mFrameMetricsReporter->removeObserver(observer);
-            if (!mFrameMetricsReporter->hasObservers()) {
-                mFrameMetricsReporter.reset(nullptr);
-            }
-        }
-    }
+    // Called by mGpuCompletionTracker once the GPU has finished rendering the frame
+    void onGpuCompleted(const FrameInfo& frame);
 
     // Used to queue up work that needs to be completed before this frame completes
     ANDROID_API void enqueueFrameWork(std::function<void()>&& func);
 
+    // The cache of the dirty vector drawable is redrawn on a worker thread once the
+    // properties of the frame are final, at the end of prepareTree()
+    void scheduleVectorDrawableUpdate(VectorDrawableRoot* tree);
+
     ANDROID_API int64_t getFrameNumber();
 
     void waitOnFences();
@@ -211,6 +205,11 @@ private:
 
     SkRect computeDirtyRect(const Frame& frame, SkRect* dirty);
 
+    void updateVectorDrawables();
+
+    void scheduleDeferredLayers(bool hasAnimations);
+    void renderDeferredLayers();
+
     EGLint mLastFrameWidth = 0;
     EGLint mLastFrameHeight = 0;
 
@@ -255,9 +254,25 @@ private:
     JankTracker mJankTracker;
     FrameInfoVisualizer mProfiler;
     std::unique_ptr<FrameMetricsReporter> mFrameMetricsReporter;
+    // Only tracks GPU completion while there are observers to report it to
+    std::unique_ptr<GpuCompletionTracker> mGpuCompletionTracker;
 
     std::set<RenderNode*> mPrefetchedLayers;
 
+    // Renders the updates of off screen layers once RenderThread is done animating
+    class DeferredLayersTask : public RenderTask {
+    public:
+        explicit DeferredLayersTask(CanvasContext* context) : mContext(context) {
+            mPriority = TaskPriority::Maintenance;
+        }
+        virtual void run() override { mContext->renderDeferredLayers(); }
+
+    private:
+        CanvasContext* const mContext;
+    };
+    DeferredLayersTask mDeferredLayersTask { this };
+    bool mDeferredLayersQueued = false;
+
     // Stores the bounds of the main content.
     Rect mContentDrawBounds;
 
@@ -267,8 +282,11 @@ private:
         std::function<void()> func;
     };
     class FuncTaskProcessor;
+    void addFrameWork(const sp<FuncTask>& task);
 
     std::vector< sp<FuncTask> > mFrameFences;
+    // Vector drawables of the frame with a dirty cache, kept alive until it is redrawn
+    std::vector< sp<VectorDrawableRoot> > mDirtyVectorDrawables;
     sp<TaskProcessor<bool> > mFrameWorkProcessor;
     std::unique_ptr<IRenderPipeline> mRenderPipeline;
 };
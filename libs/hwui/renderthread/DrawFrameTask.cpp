@@ -33,6 +33,7 @@ DrawFrameTask::DrawFrameTask()
         : mRenderThread(nullptr)
         , mContext(nullptr)
         , mSyncResult(SyncResult::OK) {
+    mPriority = TaskPriority::Frame;
 }
 
 DrawFrameTask::~DrawFrameTask() {
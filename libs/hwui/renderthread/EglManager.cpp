@@ -106,10 +106,11 @@ void EglManager::initialize() {
 
     // Now that extensions are loaded, pick a swap behavior
     if (Properties::enablePartialUpdates) {
-        // An Adreno driver bug is causing rendering problems for SkiaGL with
-        // buffer age swap behavior (b/31957043).  To temporarily workaround,
-        // we will use preserved swap behavior.
-        if (Properties::useBufferAge && EglExtensions.bufferAge && !Properties::isSkiaEnabled()) {
+        // The Skia pipelines clip every frame to the buffer age damage, the same as
+        // FrameBuilder does, so they use buffer age too. Devices whose driver mishandles buffer
+        // age with SkiaGL (b/31957043) can fall back to preserved swap behavior by setting
+        // PROPERTY_USE_BUFFER_AGE to false.
+        if (Properties::useBufferAge && EglExtensions.bufferAge) {
             mSwapBehavior = SwapBehavior::BufferAge;
         } else {
             mSwapBehavior = SwapBehavior::Preserved;
@@ -135,6 +136,11 @@ void EglManager::initialize() {
         GrContextOptions options;
         options.fGpuPathRenderers &= ~GrContextOptions::GpuPathRenderers::kDistanceField;
         options.fAllowPathMaskCaching = true;
+        // Skia merges draws that share GPU state, such as glyphs and images from the
+        // same atlas, across intervening non-overlapping draws. Its default window is
+        // too small for lists that interleave text and icons.
+        options.fMaxOpCombineLookback = Properties::skiaOpCombineWindow;
+        options.fMaxOpCombineLookahead = Properties::skiaOpCombineWindow;
         mRenderThread.setGrContext(GrContext::Create(GrBackend::kOpenGL_GrBackend,
                 (GrBackendContext)glInterface.get(), options));
     }
@@ -200,6 +206,31 @@ void EglManager::createContext() {
         "Failed to create context, error = %s", eglErrorString());
 }
 
+EGLContext EglManager::createSharedContext(EGLSurface* outSurface) {
+    LOG_ALWAYS_FATAL_IF(mEglContext == EGL_NO_CONTEXT,
+            "createSharedContext() called without a context!");
+
+    EGLint attribs[] = {
+            EGL_CONTEXT_CLIENT_VERSION, GLES_VERSION,
+            EGL_NONE
+    };
+    EGLContext context = eglCreateContext(mEglDisplay, mEglConfig, mEglContext, attribs);
+    if (context == EGL_NO_CONTEXT) {
+        ALOGW("Failed to create shared context, error = %s", eglErrorString());
+        return EGL_NO_CONTEXT;
+    }
+
+    EGLint surfaceAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    EGLSurface surface = eglCreatePbufferSurface(mEglDisplay, mEglConfig, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        ALOGW("Failed to create shared context surface, error = %s", eglErrorString());
+        eglDestroyContext(mEglDisplay, context);
+        return EGL_NO_CONTEXT;
+    }
+    *outSurface = surface;
+    return context;
+}
+
 void EglManager::createPBufferSurface() {
     LOG_ALWAYS_FATAL_IF(mEglDisplay == EGL_NO_DISPLAY,
             "usePBufferSurface() called on uninitialized GlobalContext!");
@@ -366,6 +397,14 @@ void EglManager::fence() {
     eglDestroySyncKHR(mEglDisplay, fence);
 }
 
+EGLSyncKHR EglManager::createFence() {
+    EGLSyncKHR fence = eglCreateSyncKHR(mEglDisplay, EGL_SYNC_FENCE_KHR, nullptr);
+    if (fence == EGL_NO_SYNC_KHR) {
+        ALOGW("Failed to create fence, error = %s", eglErrorString());
+    }
+    return fence;
+}
+
 bool EglManager::setPreserveBuffer(EGLSurface surface, bool preserve) {
     if (mSwapBehavior != SwapBehavior::Preserved) return false;
 
@@ -18,6 +18,7 @@
 
 #include <cutils/compiler.h>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <SkRect.h>
 #include <ui/GraphicBuffer.h>
 #include <utils/StrongPointer.h>
@@ -60,6 +61,17 @@ public:
 
     void fence();
 
+    // Inserts a fence after the commands issued so far in the current context, without
+    // flushing them. Returns EGL_NO_SYNC_KHR on failure. The caller must destroy it.
+    EGLSyncKHR createFence();
+
+    EGLDisplay eglDisplay() { return mEglDisplay; }
+
+    // Creates a context sharing textures with the RenderThread's context, along
+    // with a 1x1 pbuffer surface to make it current on another thread. Returns
+    // EGL_NO_CONTEXT on failure. The caller must destroy both.
+    EGLContext createSharedContext(EGLSurface* outSurface);
+
 private:
     friend class RenderThread;
     explicit EglManager(RenderThread& thread);
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpuCompletionTracker.h"
+
+#include "CanvasContext.h"
+#include "FrameInfo.h"
+#include "RenderThread.h"
+
+#include <utils/Log.h>
+
+namespace android {
+namespace uirenderer {
+namespace renderthread {
+
+// The swap chain keeps the GPU only a few frames behind, anything past this means the
+// worker is stuck on a fence that will never signal
+static const size_t kMaxPendingFrames = 8;
+
+#define FENCE_TIMEOUT 2000000000
+
+GpuCompletionTracker::GpuCompletionTracker(RenderThread& thread, CanvasContext& context)
+        : mRenderThread(thread)
+        , mContext(context)
+        , mThread(new WaitThread(this))
+        , mDispatchTask(this) {
+    mThread->run("hwuiGpuCompletion", PRIORITY_DISPLAY);
+}
+
+GpuCompletionTracker::~GpuCompletionTracker() {
+    {
+        Mutex::Autolock _l(mLock);
+        mExiting = true;
+        mCondition.signal();
+    }
+    mThread->requestExitAndWait();
+
+    // The worker is gone, so nothing can queue the dispatch anymore
+    if (mDispatchQueued) {
+        mRenderThread.remove(&mDispatchTask);
+    }
+    for (auto& pending : mPending) {
+        eglDestroySyncKHR(pending.display, pending.fence);
+    }
+}
+
+void GpuCompletionTracker::track(EGLDisplay display, EGLSyncKHR fence, FrameInfo* frame) {
+    if (fence == EGL_NO_SYNC_KHR) return;
+
+    Mutex::Autolock _l(mLock);
+    if (mPending.size() >= kMaxPendingFrames) {
+        eglDestroySyncKHR(display, fence);
+        return;
+    }
+    PendingFrame pending;
+    pending.display = display;
+    pending.fence = fence;
+    pending.frame = frame;
+    pending.syncStart = frame->get(FrameInfoIndex::SyncStart);
+    mPending.push_back(pending);
+    mCondition.signal();
+}
+
+bool GpuCompletionTracker::waitForNextFence() {
+    PendingFrame pending;
+    {
+        Mutex::Autolock _l(mLock);
+        while (!mExiting && mPending.empty()) {
+            mCondition.wait(mLock);
+        }
+        if (mExiting) {
+            return false;
+        }
+        // Leave the fence in mPending while waiting on it, it only times out if the GPU hangs
+        pending = mPending.front();
+    }
+
+    // No context is current on this thread, the fence must already have been flushed
+    EGLint waitStatus = eglClientWaitSyncKHR(pending.display, pending.fence, 0, FENCE_TIMEOUT);
+    pending.gpuCompleted = systemTime(CLOCK_MONOTONIC);
+
+    Mutex::Autolock _l(mLock);
+    mPending.pop_front();
+    eglDestroySyncKHR(pending.display, pending.fence);
+    if (waitStatus != EGL_CONDITION_SATISFIED_KHR) {
+        ALOGW("Failed to wait for frame completion fence %#x", eglGetError());
+        return true;
+    }
+    mCompleted.push_back(pending);
+    if (!mDispatchQueued) {
+        mDispatchQueued = true;
+        mRenderThread.queue(&mDispatchTask);
+    }
+    return true;
+}
+
+void GpuCompletionTracker::dispatchCompletedFrames() {
+    std::vector<PendingFrame> completed;
+    {
+        Mutex::Autolock _l(mLock);
+        mDispatchQueued = false;
+        completed.swap(mCompleted);
+    }
+    for (auto& pending : completed) {
+        FrameInfo* frame = pending.frame;
+        if (frame->get(FrameInfoIndex::SyncStart) != pending.syncStart) {
+            continue;
+        }
+        frame->markGpuCompleted(pending.gpuCompleted);
+        mContext.onGpuCompleted(*frame);
+    }
+}
+
+} /* namespace renderthread */
+} /* namespace uirenderer */
+} /* namespace android */
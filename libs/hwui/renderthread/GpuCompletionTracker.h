@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "renderthread/RenderTask.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+
+#include <deque>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+class FrameInfo;
+
+namespace renderthread {
+
+class CanvasContext;
+class RenderThread;
+
+/**
+ * Waits on a worker thread for the GPU to finish rendering frames, then stamps the time at
+ * which it did into their FrameInfo back on the RenderThread and lets the CanvasContext
+ * report it. This makes GPU bound frames visible to FrameMetrics observers without ever
+ * blocking the RenderThread on the GPU.
+ *
+ * The completion time is when the worker woke up from the fence wait, so it may be late by
+ * the scheduling latency of the worker.
+ *
+ * All methods must be called from the RenderThread.
+ */
+class GpuCompletionTracker {
+public:
+    GpuCompletionTracker(RenderThread& thread, CanvasContext& context);
+    ~GpuCompletionTracker();
+
+    /**
+     * Takes ownership of fence, which must be flushed by the caller, typically by the swap
+     * following this call. The frame is dropped if it was recycled by the time the fence
+     * signaled.
+     */
+    void track(EGLDisplay display, EGLSyncKHR fence, FrameInfo* frame);
+
+private:
+    struct PendingFrame {
+        EGLDisplay display = EGL_NO_DISPLAY;
+        EGLSyncKHR fence = EGL_NO_SYNC_KHR;
+        FrameInfo* frame = nullptr;
+        // Identifies the frame, in case its FrameInfo was reused for a later one
+        nsecs_t syncStart = 0;
+        nsecs_t gpuCompleted = 0;
+    };
+
+    class WaitThread : public Thread {
+    public:
+        explicit WaitThread(GpuCompletionTracker* tracker)
+                : Thread(false), mTracker(tracker) {}
+
+    private:
+        virtual bool threadLoop() override {
+            return mTracker->waitForNextFence();
+        }
+
+        GpuCompletionTracker* const mTracker;
+    };
+
+    class DispatchTask : public RenderTask {
+    public:
+        explicit DispatchTask(GpuCompletionTracker* tracker) : mTracker(tracker) {}
+        virtual void run() override { mTracker->dispatchCompletedFrames(); }
+
+    private:
+        GpuCompletionTracker* const mTracker;
+    };
+
+    bool waitForNextFence();
+    void dispatchCompletedFrames();
+
+    RenderThread& mRenderThread;
+    CanvasContext& mContext;
+
+    sp<WaitThread> mThread;
+    DispatchTask mDispatchTask;
+
+    Mutex mLock;
+    Condition mCondition;
+    std::deque<PendingFrame> mPending;
+    std::vector<PendingFrame> mCompleted;
+    bool mDispatchQueued = false;
+    bool mExiting = false;
+}; // class GpuCompletionTracker
+
+} /* namespace renderthread */
+} /* namespace uirenderer */
+} /* namespace android */
@@ -255,7 +255,10 @@ void OpenGLPipeline::destroyLayer(RenderNode* node) {
 void OpenGLPipeline::prepareToDraw(const RenderThread& thread, Bitmap* bitmap) {
     if (Caches::hasInstance() && thread.eglManager().hasEglContext()) {
         ATRACE_NAME("Bitmap#prepareToDraw task");
-        Caches::getInstance().textureCache.prefetch(bitmap);
+        TextureCache& textureCache = Caches::getInstance().textureCache;
+        if (!textureCache.prefetchAsync(bitmap, thread.eglManager())) {
+            textureCache.prefetch(bitmap);
+        }
     }
 }
 
@@ -18,19 +18,25 @@
 
 #include "DeferredLayerUpdater.h"
 #include "DisplayList.h"
+#include "GpuMemoryTracker.h"
+#include "ProgramCache.h"
 #include "Properties.h"
 #include "Readback.h"
 #include "Rect.h"
+#include "hwui/PixelBufferPool.h"
 #include "renderthread/CanvasContext.h"
 #include "renderthread/EglManager.h"
 #include "renderthread/RenderTask.h"
 #include "renderthread/RenderThread.h"
+#include "renderthread/VulkanManager.h"
 #include "renderstate/RenderState.h"
 #include "utils/Macros.h"
 #include "utils/TimeUtils.h"
 
 #include <ui/GraphicBuffer.h>
 
+#include <sstream>
+
 namespace android {
 namespace uirenderer {
 namespace renderthread {
@@ -128,16 +134,18 @@ bool RenderProxy::loadSystemProperties() {
     return (bool) postAndWait(task);
 }
 
-CREATE_BRIDGE2(setName, CanvasContext* context, const char* name) {
+CREATE_BRIDGE2(setName, CanvasContext* context, char* name) {
     args->context->setName(std::string(args->name));
+    free(args->name);
     return nullptr;
 }
 
 void RenderProxy::setName(const char* name) {
     SETUP_TASK(setName);
     args->context = mContext;
-    args->name = name;
-    postAndWait(task); // block since name/value pointers owned by caller
+    // Copy the name, which is owned by the caller, so that there is no need to wait.
+    args->name = strdup(name);
+    post(task);
 }
 
 CREATE_BRIDGE2(initialize, CanvasContext* context, Surface* surface) {
@@ -184,7 +192,9 @@ void RenderProxy::setStopped(bool stopped) {
     SETUP_TASK(setStopped);
     args->context = mContext;
     args->stopped = stopped;
-    postAndWait(task);
+    // Only the RenderThread looks at the stopped state, and every later call is queued behind
+    // this one, so there is nothing to wait for.
+    post(task);
 }
 
 CREATE_BRIDGE4(setup, CanvasContext* context,
@@ -345,12 +355,16 @@ CREATE_BRIDGE2(trimMemory, RenderThread* thread, int level) {
 }
 
 void RenderProxy::trimMemory(int level) {
+    // The pool only holds freed bitmaps, drop it whatever the level
+    PixelBufferPool::getInstance().clear();
+
     // Avoid creating a RenderThread to do a trimMemory.
     if (RenderThread::hasInstance()) {
         RenderThread& thread = RenderThread::getInstance();
         SETUP_TASK(trimMemory);
         args->thread = &thread;
         args->level = level;
+        task->mPriority = TaskPriority::Maintenance;
         thread.queue(task);
     }
 }
@@ -441,7 +455,7 @@ CREATE_BRIDGE1(resetProfileInfo, CanvasContext* context) {
 void RenderProxy::resetProfileInfo() {
     SETUP_TASK(resetProfileInfo);
     args->context = mContext;
-    postAndWait(task);
+    post(task);
 }
 
 CREATE_BRIDGE2(frameTimePercentile, RenderThread* thread, int percentile) {
@@ -468,6 +482,9 @@ CREATE_BRIDGE2(dumpGraphicsMemory, int fd, RenderThread* thread) {
     } else {
         fprintf(file, "\nNo caches instance.\n");
     }
+    std::stringstream gpuObjectsLog;
+    GpuMemoryTracker::dump(gpuObjectsLog);
+    fprintf(file, "\nGPU objects:\n%s", gpuObjectsLog.str().c_str());
     fprintf(file, "\nPipeline=FrameBuilder\n");
     fflush(file);
     return nullptr;
@@ -631,6 +648,25 @@ int RenderProxy::copySurfaceInto(sp<Surface>& surface, int left, int top,
             reinterpret_cast<intptr_t>( staticPostAndWait(task) ));
 }
 
+CREATE_BRIDGE6(copySurfaceIntoHardwareBitmap, RenderThread* thread,
+        Surface* surface, Rect srcRect, int width, int height, sk_sp<Bitmap>* outBitmap) {
+    return (void*)args->thread->readback().copySurfaceIntoHardwareBitmap(*args->surface,
+            args->srcRect, args->width, args->height, args->outBitmap);
+}
+
+int RenderProxy::copySurfaceIntoHardwareBitmap(sp<Surface>& surface, int left, int top,
+        int right, int bottom, int width, int height, sk_sp<Bitmap>* outBitmap) {
+    SETUP_TASK(copySurfaceIntoHardwareBitmap);
+    args->thread = &RenderThread::getInstance();
+    args->surface = surface.get();
+    args->srcRect.set(left, top, right, bottom);
+    args->width = width;
+    args->height = height;
+    args->outBitmap = outBitmap;
+    return static_cast<int>(
+            reinterpret_cast<intptr_t>( staticPostAndWait(task) ));
+}
+
 CREATE_BRIDGE2(prepareToDraw, RenderThread* thread, Bitmap* bitmap) {
     CanvasContext::prepareToDraw(*args->thread, args->bitmap);
     args->bitmap->unref();
@@ -706,6 +742,7 @@ void RenderProxy::onBitmapDestroyed(uint32_t pixelRefId) {
     RenderThread& thread = RenderThread::getInstance();
     args->thread = &thread;
     args->pixelRefId = pixelRefId;
+    task->mPriority = TaskPriority::Maintenance;
     thread.queue(task);
 }
 
@@ -713,6 +750,30 @@ void RenderProxy::disableVsync() {
     Properties::disableVsync = true;
 }
 
+void RenderProxy::setupProgramDiskCache(const char* path) {
+    ProgramCache::setDiskCachePath(path);
+}
+
+CREATE_BRIDGE1(preload, RenderThread* thread) {
+    ATRACE_NAME("RenderProxy::preload");
+    // The same initialization the pipeline of the first CanvasContext would do
+    if (Properties::getRenderPipelineType() == RenderPipelineType::SkiaVulkan) {
+        args->thread->vulkanManager().initialize();
+    } else {
+        args->thread->eglManager().initialize();
+    }
+    return nullptr;
+}
+
+void RenderProxy::preload() {
+    // Creating the RenderThread loads the properties
+    RenderThread& thread = RenderThread::getInstance();
+    if (!Properties::preloadGpuContext) return;
+    SETUP_TASK(preload);
+    args->thread = &thread;
+    thread.queue(task);
+}
+
 void RenderProxy::post(RenderTask* task) {
     mRenderThread.queue(task);
 }
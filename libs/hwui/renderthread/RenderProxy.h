@@ -130,6 +130,10 @@ public:
 
     ANDROID_API static int copySurfaceInto(sp<Surface>& surface,
             int left, int top, int right, int bottom, SkBitmap* bitmap);
+    // Scales the copy on the GPU and doesn't wait for it to complete
+    ANDROID_API static int copySurfaceIntoHardwareBitmap(sp<Surface>& surface,
+            int left, int top, int right, int bottom, int width, int height,
+            sk_sp<Bitmap>* outBitmap);
     ANDROID_API static void prepareToDraw(Bitmap& bitmap);
 
     static sk_sp<Bitmap> allocateHardwareBitmap(SkBitmap& bitmap);
@@ -139,6 +143,15 @@ public:
     static void onBitmapDestroyed(uint32_t pixelRefId);
 
     ANDROID_API static void disableVsync();
+
+    // Sets the file that keeps the OpenGL pipeline's program binaries across runs
+    ANDROID_API static void setupProgramDiskCache(const char* path);
+
+    // Starts the RenderThread and initializes its GPU context in the background, so that
+    // driver initialization is off the first frame's critical path. Must be called after
+    // setupProgramDiskCache() for the cached programs to be linked along with it.
+    ANDROID_API static void preload();
+
 private:
     RenderThread& mRenderThread;
     CanvasContext* mContext;
@@ -45,15 +45,29 @@ namespace renderthread {
  * malloc/free churn of small objects?
  */
 
+/*
+ * Frame and Normal tasks run in the order they were queued, since a frame may depend on state
+ * set by the tasks posted before it. Maintenance tasks run after all of them, and are held
+ * back while frame work is about to be due, so that cleanup never delays a frame.
+ */
+enum class TaskPriority {
+    // Produces a frame, such as DrawFrameTask
+    Frame,
+    Normal,
+    // Cleanup that can wait, such as trimming caches or destroying layers
+    Maintenance,
+};
+
 class ANDROID_API RenderTask {
 public:
-    ANDROID_API RenderTask() : mNext(nullptr), mRunAt(0) {}
+    ANDROID_API RenderTask() : mNext(nullptr), mRunAt(0), mPriority(TaskPriority::Normal) {}
     ANDROID_API virtual ~RenderTask() {}
 
     ANDROID_API virtual void run() = 0;
 
     RenderTask* mNext;
     nsecs_t mRunAt; // nano-seconds on the SYSTEM_TIME_MONOTONIC clock
+    TaskPriority mPriority; // must not change while the task is queued
 };
 
 class SignalingRenderTask : public RenderTask {
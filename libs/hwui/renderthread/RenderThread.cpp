@@ -33,6 +33,8 @@
 #include <utils/Log.h>
 #include <utils/Mutex.h>
 
+#include <algorithm>
+
 namespace android {
 namespace uirenderer {
 namespace renderthread {
@@ -45,95 +47,161 @@ static const size_t EVENT_BUFFER_SIZE = 100;
 // Slight delay to give the UI time to push us a new frame before we replay
 static const nsecs_t DISPATCH_FRAME_CALLBACKS_DELAY = milliseconds_to_nanoseconds(4);
 
-TaskQueue::TaskQueue() : mHead(nullptr), mTail(nullptr) {}
+// Maintenance tasks don't start when frame work is due this soon, so they can't delay it
+static const nsecs_t MAINTENANCE_FRAME_MARGIN = milliseconds_to_nanoseconds(2);
 
-RenderTask* TaskQueue::next() {
-    RenderTask* ret = mHead;
+RenderTask* TaskQueue::TaskList::next() {
+    RenderTask* ret = head;
     if (ret) {
-        mHead = ret->mNext;
-        if (!mHead) {
-            mTail = nullptr;
+        head = ret->mNext;
+        if (!head) {
+            tail = nullptr;
         }
         ret->mNext = nullptr;
     }
     return ret;
 }
 
-RenderTask* TaskQueue::peek() {
-    return mHead;
-}
-
-void TaskQueue::queue(RenderTask* task) {
-    // Since the RenderTask itself forms the linked list it is not allowed
-    // to have the same task queued twice
-    LOG_ALWAYS_FATAL_IF(task->mNext || mTail == task, "Task is already in the queue!");
-    if (mTail) {
+void TaskQueue::TaskList::queue(RenderTask* task) {
+    if (tail) {
         // Fast path if we can just append
-        if (mTail->mRunAt <= task->mRunAt) {
-            mTail->mNext = task;
-            mTail = task;
+        if (tail->mRunAt <= task->mRunAt) {
+            tail->mNext = task;
+            tail = task;
         } else {
             // Need to find the proper insertion point
             RenderTask* previous = nullptr;
-            RenderTask* next = mHead;
+            RenderTask* next = head;
             while (next && next->mRunAt <= task->mRunAt) {
                 previous = next;
                 next = next->mNext;
             }
             if (!previous) {
-                task->mNext = mHead;
-                mHead = task;
+                task->mNext = head;
+                head = task;
             } else {
                 previous->mNext = task;
                 if (next) {
                     task->mNext = next;
                 } else {
-                    mTail = task;
+                    tail = task;
                 }
             }
         }
     } else {
-        mTail = mHead = task;
+        tail = head = task;
     }
 }
 
-void TaskQueue::queueAtFront(RenderTask* task) {
-    LOG_ALWAYS_FATAL_IF(task->mNext || mHead == task, "Task is already in the queue!");
-    if (mTail) {
-        task->mNext = mHead;
-        mHead = task;
+void TaskQueue::TaskList::queueAtFront(RenderTask* task) {
+    if (tail) {
+        task->mNext = head;
+        head = task;
     } else {
-        mTail = mHead = task;
+        tail = head = task;
     }
 }
 
-void TaskQueue::remove(RenderTask* task) {
-    // TaskQueue is strict here to enforce that users are keeping track of
-    // their RenderTasks due to how their memory is managed
-    LOG_ALWAYS_FATAL_IF(!task->mNext && mTail != task,
-            "Cannot remove a task that isn't in the queue!");
-
+void TaskQueue::TaskList::remove(RenderTask* task) {
     // If task is the head we can just call next() to pop it off
     // Otherwise we need to scan through to find the task before it
-    if (peek() == task) {
+    if (head == task) {
         next();
     } else {
-        RenderTask* previous = mHead;
+        RenderTask* previous = head;
         while (previous->mNext != task) {
             previous = previous->mNext;
         }
         previous->mNext = task->mNext;
-        if (mTail == task) {
-            mTail = previous;
+        if (tail == task) {
+            tail = previous;
         }
+        task->mNext = nullptr;
     }
 }
 
+static bool isDue(const RenderTask* task, nsecs_t* now) {
+    if (!task) return false;
+    // Most tasks won't be delayed, so avoid unnecessary systemTime() calls
+    if (task->mRunAt <= 0) return true;
+    if (!*now) {
+        *now = systemTime(SYSTEM_TIME_MONOTONIC);
+    }
+    return task->mRunAt <= *now;
+}
+
+RenderTask* TaskQueue::next() {
+    nsecs_t now = 0;
+    if (isDue(mTasks.head, &now)) {
+        return mTasks.next();
+    }
+    if (isDue(mMaintenanceTasks.head, &now)) {
+        if (!now) {
+            now = systemTime(SYSTEM_TIME_MONOTONIC);
+        }
+        if (nextFrameRunAt() > now + MAINTENANCE_FRAME_MARGIN) {
+            return mMaintenanceTasks.next();
+        }
+    }
+    return nullptr;
+}
+
+nsecs_t TaskQueue::nextWakeup() const {
+    nsecs_t wakeup = mTasks.head ? mTasks.head->mRunAt : LLONG_MAX;
+    if (mMaintenanceTasks.head) {
+        nsecs_t runAt = mMaintenanceTasks.head->mRunAt;
+        nsecs_t frameRunAt = nextFrameRunAt();
+        if (frameRunAt != LLONG_MAX) {
+            nsecs_t start = std::max(runAt, systemTime(SYSTEM_TIME_MONOTONIC));
+            if (frameRunAt <= start + MAINTENANCE_FRAME_MARGIN) {
+                // Held back until the frame task ran
+                runAt = std::max(runAt, frameRunAt);
+            }
+        }
+        wakeup = std::min(wakeup, runAt);
+    }
+    return wakeup;
+}
+
+void TaskQueue::queue(RenderTask* task) {
+    // Since the RenderTask itself forms the linked list it is not allowed
+    // to have the same task queued twice
+    TaskList& list = listFor(task);
+    LOG_ALWAYS_FATAL_IF(task->mNext || list.tail == task, "Task is already in the queue!");
+    list.queue(task);
+}
+
+void TaskQueue::queueAtFront(RenderTask* task) {
+    TaskList& list = listFor(task);
+    LOG_ALWAYS_FATAL_IF(task->mNext || list.head == task, "Task is already in the queue!");
+    list.queueAtFront(task);
+}
+
+void TaskQueue::remove(RenderTask* task) {
+    // TaskQueue is strict here to enforce that users are keeping track of
+    // their RenderTasks due to how their memory is managed
+    TaskList& list = listFor(task);
+    LOG_ALWAYS_FATAL_IF(!task->mNext && list.tail != task,
+            "Cannot remove a task that isn't in the queue!");
+    list.remove(task);
+}
+
+nsecs_t TaskQueue::nextFrameRunAt() const {
+    for (RenderTask* task = mTasks.head; task; task = task->mNext) {
+        if (task->mPriority == TaskPriority::Frame) {
+            return task->mRunAt;
+        }
+    }
+    return LLONG_MAX;
+}
+
 class DispatchFrameCallbacks : public RenderTask {
 private:
     RenderThread* mRenderThread;
 public:
-    explicit DispatchFrameCallbacks(RenderThread* rt) : mRenderThread(rt) {}
+    explicit DispatchFrameCallbacks(RenderThread* rt) : mRenderThread(rt) {
+        mPriority = TaskPriority::Frame;
+    }
 
     virtual void run() override {
         mRenderThread->dispatchFrameCallbacks();
@@ -320,6 +388,9 @@ bool RenderThread::threadLoop() {
             // starvation if more tasks are queued while we are processing tasks.
             while (RenderTask* task = nextTask(&nextWakeup)) {
                 workQueue.push_back(task);
+                // Maintenance tasks come last and run one per loop, so that frames
+                // queued in the meantime go first
+                if (task->mPriority == TaskPriority::Maintenance) break;
             }
             for (auto task : workQueue) {
                 task->run();
@@ -415,18 +486,8 @@ void RenderThread::pushBackFrameCallback(IFrameCallback* callback) {
 
 RenderTask* RenderThread::nextTask(nsecs_t* nextWakeup) {
     AutoMutex _lock(mLock);
-    RenderTask* next = mQueue.peek();
-    if (!next) {
-        mNextWakeup = LLONG_MAX;
-    } else {
-        mNextWakeup = next->mRunAt;
-        // Most tasks won't be delayed, so avoid unnecessary systemTime() calls
-        if (next->mRunAt <= 0 || next->mRunAt <= systemTime(SYSTEM_TIME_MONOTONIC)) {
-            next = mQueue.next();
-        } else {
-            next = nullptr;
-        }
-    }
+    RenderTask* next = mQueue.next();
+    mNextWakeup = next ? next->mRunAt : mQueue.nextWakeup();
     if (nextWakeup) {
         *nextWakeup = mNextWakeup;
     }
@@ -51,17 +51,36 @@ class VulkanManager;
 
 class TaskQueue {
 public:
-    TaskQueue();
+    TaskQueue() {}
 
+    // Removes and returns the next task that is due, or null if none can run yet
     RenderTask* next();
+    // Time at which next() may return a task, LLONG_MAX if the queue is empty
+    nsecs_t nextWakeup() const;
     void queue(RenderTask* task);
     void queueAtFront(RenderTask* task);
-    RenderTask* peek();
     void remove(RenderTask* task);
 
 private:
-    RenderTask* mHead;
-    RenderTask* mTail;
+    // Sorted by mRunAt, in FIFO order for equal times
+    struct TaskList {
+        RenderTask* head = nullptr;
+        RenderTask* tail = nullptr;
+
+        RenderTask* next();
+        void queue(RenderTask* task);
+        void queueAtFront(RenderTask* task);
+        void remove(RenderTask* task);
+    };
+
+    TaskList& listFor(const RenderTask* task) {
+        return task->mPriority == TaskPriority::Maintenance ? mMaintenanceTasks : mTasks;
+    }
+    // Run time of the first queued frame task, LLONG_MAX if there is none
+    nsecs_t nextFrameRunAt() const;
+
+    TaskList mTasks;
+    TaskList mMaintenanceTasks;
 };
 
 // Mimics android.view.Choreographer.FrameCallback
@@ -19,19 +19,52 @@ namespace android {
 namespace uirenderer {
 namespace renderthread {
 
+// Vsyncs further apart than this many periods (display idle, dropped
+// frames) are too noisy to measure the period from
+static const nsecs_t kMaxMeasuredPeriods = 4;
+
 TimeLord::TimeLord()
         : mFrameIntervalNanos(milliseconds_to_nanoseconds(16))
-        , mFrameTimeNanos(0) {
+        , mFrameTimeNanos(0)
+        , mLastVsyncNanos(0) {
+}
+
+void TimeLord::setFrameInterval(nsecs_t intervalNanos) {
+    mFrameIntervalNanos = intervalNanos;
+    mLastVsyncNanos = 0;
 }
 
 bool TimeLord::vsyncReceived(nsecs_t vsync) {
     if (vsync > mFrameTimeNanos) {
+        updateFrameInterval(vsync);
         mFrameTimeNanos = vsync;
         return true;
     }
     return false;
 }
 
+void TimeLord::updateFrameInterval(nsecs_t vsync) {
+    const nsecs_t lastVsync = mLastVsyncNanos;
+    mLastVsyncNanos = vsync;
+    if (lastVsync <= 0 || vsync <= lastVsync) return;
+
+    // Vsyncs are only requested when there is something to draw, so count how
+    // many periods elapsed since the previous one
+    const nsecs_t delta = vsync - lastVsync;
+    const nsecs_t periods = (delta + mFrameIntervalNanos / 2) / mFrameIntervalNanos;
+    if (periods < 1 || periods > kMaxMeasuredPeriods) return;
+
+    // Ignore the samples that are too far off to be the same display timing,
+    // such as timestamps adjusted for jitter by the UI thread
+    const nsecs_t sample = delta / periods;
+    const nsecs_t tolerance = mFrameIntervalNanos / 5;
+    if (sample < mFrameIntervalNanos - tolerance || sample > mFrameIntervalNanos + tolerance) {
+        return;
+    }
+    // Smooth out the jitter of the timestamps
+    mFrameIntervalNanos += (sample - mFrameIntervalNanos) / 8;
+}
+
 nsecs_t TimeLord::computeFrameTimeNanos() {
     // Logic copied from Choreographer.java
     nsecs_t now = systemTime(CLOCK_MONOTONIC);
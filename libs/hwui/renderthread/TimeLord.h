@@ -28,7 +28,9 @@ class RenderThread;
 // ensuring that time flows linearly and smoothly
 class TimeLord {
 public:
-    void setFrameInterval(nsecs_t intervalNanos) { mFrameIntervalNanos = intervalNanos; }
+    void setFrameInterval(nsecs_t intervalNanos);
+    // The vsync period, as measured from the recent vsync timestamps. Starts at the interval
+    // set by setFrameInterval(), which comes from the nominal refresh rate of the display.
     nsecs_t frameIntervalNanos() const { return mFrameIntervalNanos; }
 
     // returns true if the vsync is newer, false if it was rejected for staleness
@@ -42,8 +44,12 @@ private:
     TimeLord();
     ~TimeLord() {}
 
+    void updateFrameInterval(nsecs_t vsync);
+
     nsecs_t mFrameIntervalNanos;
     nsecs_t mFrameTimeNanos;
+    // Latest vsync timestamp received, unlike mFrameTimeNanos this is never an estimate
+    nsecs_t mLastVsyncNanos;
 };
 
 } /* namespace renderthread */
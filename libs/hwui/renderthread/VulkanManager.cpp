@@ -23,6 +23,7 @@
 #include "utils/FatVector.h"
 
 #include <GrContext.h>
+#include <GrContextOptions.h>
 #include <GrTypes.h>
 #include <vk/GrVkTypes.h>
 
@@ -104,8 +105,12 @@ void VulkanManager::initialize() {
 
     mGetDeviceQueue(mBackendContext->fDevice, mPresentQueueIndex, 0, &mPresentQueue);
 
+    // See EglManager::initialize() for the op combine window.
+    GrContextOptions options;
+    options.fMaxOpCombineLookback = Properties::skiaOpCombineWindow;
+    options.fMaxOpCombineLookahead = Properties::skiaOpCombineWindow;
     mRenderThread.setGrContext(GrContext::Create(kVulkan_GrBackend,
-            (GrBackendContext) mBackendContext.get()));
+            (GrBackendContext) mBackendContext.get(), options));
     DeviceInfo::initialize(mRenderThread.getGrContext()->caps()->maxRenderTargetSize());
 
     if (Properties::enablePartialUpdates && Properties::useBufferAge) {
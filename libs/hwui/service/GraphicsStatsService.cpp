@@ -23,50 +23,173 @@
 #include <log/log.h>
 
 #include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <vector>
 
 namespace android {
 namespace uirenderer {
 
 using namespace google::protobuf;
 
-constexpr int32_t sCurrentFileVersion = 1;
+constexpr int32_t sProtobufFileVersion = 1;
+constexpr int32_t sFixedLayoutFileVersion = 2;
 constexpr int32_t sHeaderSize = 4;
-static_assert(sizeof(sCurrentFileVersion) == sHeaderSize, "Header size is wrong");
+static_assert(sizeof(sFixedLayoutFileVersion) == sHeaderSize, "Header size is wrong");
 
-constexpr int sHistogramSize =
-        std::tuple_size<decltype(ProfileData::frameCounts)>::value +
+constexpr int sFrameCountsSize = std::tuple_size<decltype(ProfileData::frameCounts)>::value;
+constexpr int sHistogramSize = sFrameCountsSize +
         std::tuple_size<decltype(ProfileData::slowFrameCounts)>::value;
 
+/*
+ * Layout of the stats files since version 2. The counts are at fixed offsets so that saveBuffer()
+ * can merge new frames into the file in place through mmap, instead of parsing and rewriting
+ * a protobuf. The histogram buckets are in the same order as GraphicsStatsProto's histogram.
+ */
+struct FixedLayoutStats {
+    int32_t fileVersion;
+    uint32_t histogramSize;
+    int64_t statsStart;
+    int64_t statsEnd;
+    int32_t versionCode;
+    uint32_t packageNameLength;
+    uint32_t totalFrames;
+    uint32_t jankyFrames;
+    uint32_t missedVsyncCount;
+    uint32_t highInputLatencyCount;
+    uint32_t slowUiThreadCount;
+    uint32_t slowBitmapUploadCount;
+    uint32_t slowDrawCount;
+    uint32_t histogram[sHistogramSize];
+    // Followed by the package name, without a terminating null
+};
+
 static void mergeProfileDataIntoProto(service::GraphicsStatsProto* proto,
         const std::string& package, int versionCode, int64_t startTime, int64_t endTime,
         const ProfileData* data);
 static void dumpAsTextToFd(service::GraphicsStatsProto* proto, int outFd);
 
-bool GraphicsStatsService::parseFromFile(const std::string& path, service::GraphicsStatsProto* output) {
+static int32_t renderMillisForBucket(int index) {
+    return index < sFrameCountsSize
+            ? JankTracker::frameTimeForFrameCountIndex(index)
+            : JankTracker::frameTimeForSlowFrameCountIndex(index - sFrameCountsSize);
+}
 
-    int fd = open(path.c_str(), O_RDONLY);
-    if (fd == -1) {
+// Maps a fixed layout stats file, or returns null if fd isn't one
+static FixedLayoutStats* mapFixedLayoutStats(int fd, bool writable, size_t* outSize) {
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < (off_t) sizeof(FixedLayoutStats)) {
+        return nullptr;
+    }
+    size_t size = st.st_size;
+    void* addr = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+            MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
         int err = errno;
-        // The file not existing is normal for addToDump(), so only log if
-        // we get an unexpected error
-        if (err != ENOENT) {
-            ALOGW("Failed to open '%s', errno=%d (%s)", path.c_str(), err, strerror(err));
-        }
-        return false;
+        ALOGW("Failed to map fd=%d, errno=%d (%s)", fd, err, strerror(err));
+        return nullptr;
     }
-    uint32_t file_version;
-    ssize_t bytesRead = read(fd, &file_version, sHeaderSize);
-    if (bytesRead != sHeaderSize || file_version != sCurrentFileVersion) {
-        ALOGW("Failed to read '%s', bytesRead=%zd file_version=%d", path.c_str(), bytesRead,
-                file_version);
-        close(fd);
+    FixedLayoutStats* stats = reinterpret_cast<FixedLayoutStats*>(addr);
+    if (stats->fileVersion != sFixedLayoutFileVersion
+            || stats->histogramSize != sHistogramSize
+            || size != sizeof(FixedLayoutStats) + stats->packageNameLength) {
+        munmap(addr, size);
+        return nullptr;
+    }
+    *outSize = size;
+    return stats;
+}
+
+static const char* packageName(const FixedLayoutStats* stats) {
+    return reinterpret_cast<const char*>(stats + 1);
+}
+
+static void fixedLayoutStatsToProto(const FixedLayoutStats* stats,
+        service::GraphicsStatsProto* proto) {
+    proto->set_package_name(packageName(stats), stats->packageNameLength);
+    proto->set_version_code(stats->versionCode);
+    proto->set_stats_start(stats->statsStart);
+    proto->set_stats_end(stats->statsEnd);
+    auto summary = proto->mutable_summary();
+    summary->set_total_frames(stats->totalFrames);
+    summary->set_janky_frames(stats->jankyFrames);
+    summary->set_missed_vsync_count(stats->missedVsyncCount);
+    summary->set_high_input_latency_count(stats->highInputLatencyCount);
+    summary->set_slow_ui_thread_count(stats->slowUiThreadCount);
+    summary->set_slow_bitmap_upload_count(stats->slowBitmapUploadCount);
+    summary->set_slow_draw_count(stats->slowDrawCount);
+    proto->mutable_histogram()->Reserve(sHistogramSize);
+    for (int i = 0; i < sHistogramSize; i++) {
+        auto bucket = proto->add_histogram();
+        bucket->set_render_millis(renderMillisForBucket(i));
+        bucket->set_frame_count(stats->histogram[i]);
+    }
+}
+
+// Same as mergeProfileDataIntoProto(), for data of the same package
+static void mergeProfileDataIntoFixedLayout(FixedLayoutStats* stats, int versionCode,
+        int64_t startTime, int64_t endTime, const ProfileData* data) {
+    if (stats->statsStart == 0 || stats->statsStart > startTime) {
+        stats->statsStart = startTime;
+    }
+    if (stats->statsEnd == 0 || stats->statsEnd < endTime) {
+        stats->statsEnd = endTime;
+    }
+    stats->versionCode = versionCode;
+    stats->totalFrames += data->totalFrameCount;
+    stats->jankyFrames += data->jankFrameCount;
+    stats->missedVsyncCount += data->jankTypeCounts[kMissedVsync];
+    stats->highInputLatencyCount += data->jankTypeCounts[kHighInputLatency];
+    stats->slowUiThreadCount += data->jankTypeCounts[kSlowUI];
+    stats->slowBitmapUploadCount += data->jankTypeCounts[kSlowSync];
+    stats->slowDrawCount += data->jankTypeCounts[kSlowRT];
+    for (size_t i = 0; i < data->frameCounts.size(); i++) {
+        stats->histogram[i] += data->frameCounts[i];
+    }
+    for (size_t i = 0; i < data->slowFrameCounts.size(); i++) {
+        stats->histogram[sFrameCountsSize + i] += data->slowFrameCounts[i];
+    }
+}
+
+static bool writeFixedLayoutStats(int fd, const std::string& path,
+        const service::GraphicsStatsProto& proto) {
+    const std::string& package = proto.package_name();
+    std::vector<char> buffer(sizeof(FixedLayoutStats) + package.size());
+    FixedLayoutStats* stats = reinterpret_cast<FixedLayoutStats*>(buffer.data());
+    stats->fileVersion = sFixedLayoutFileVersion;
+    stats->histogramSize = sHistogramSize;
+    stats->statsStart = proto.stats_start();
+    stats->statsEnd = proto.stats_end();
+    stats->versionCode = proto.version_code();
+    stats->packageNameLength = package.size();
+    const auto& summary = proto.summary();
+    stats->totalFrames = summary.total_frames();
+    stats->jankyFrames = summary.janky_frames();
+    stats->missedVsyncCount = summary.missed_vsync_count();
+    stats->highInputLatencyCount = summary.high_input_latency_count();
+    stats->slowUiThreadCount = summary.slow_ui_thread_count();
+    stats->slowBitmapUploadCount = summary.slow_bitmap_upload_count();
+    stats->slowDrawCount = summary.slow_draw_count();
+    for (int i = 0; i < sHistogramSize; i++) {
+        stats->histogram[i] = proto.histogram(i).frame_count();
+    }
+    memcpy(buffer.data() + sizeof(FixedLayoutStats), package.data(), package.size());
+
+    if (ftruncate(fd, 0) || pwrite(fd, buffer.data(), buffer.size(), 0)
+            != (ssize_t) buffer.size()) {
+        int err = errno;
+        ALOGW("Failed to write '%s', errno=%d (%s)", path.c_str(), err, strerror(err));
         return false;
     }
+    return true;
+}
 
+static bool parseProtobufFile(int fd, const std::string& path,
+        service::GraphicsStatsProto* output) {
     io::FileInputStream input(fd);
     bool success = output->ParseFromZeroCopyStream(&input);
     if (input.GetErrno() != 0) {
@@ -77,6 +200,41 @@ bool GraphicsStatsService::parseFromFile(const std::string& path, service::Graph
         ALOGW("Parse failed on '%s' error='%s'",
                 path.c_str(), output->InitializationErrorString().c_str());
     }
+    return success;
+}
+
+bool GraphicsStatsService::parseFromFile(const std::string& path, service::GraphicsStatsProto* output) {
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        int err = errno;
+        // The file not existing is normal for addToDump(), so only log if
+        // we get an unexpected error
+        if (err != ENOENT) {
+            ALOGW("Failed to open '%s', errno=%d (%s)", path.c_str(), err, strerror(err));
+        }
+        return false;
+    }
+    int32_t file_version;
+    ssize_t bytesRead = read(fd, &file_version, sHeaderSize);
+    bool success = false;
+    if (bytesRead == sHeaderSize && file_version == sFixedLayoutFileVersion) {
+        size_t size;
+        FixedLayoutStats* stats = mapFixedLayoutStats(fd, false, &size);
+        if (stats) {
+            fixedLayoutStatsToProto(stats, output);
+            munmap(stats, size);
+            success = true;
+        } else {
+            ALOGW("Invalid stats file '%s'", path.c_str());
+        }
+    } else if (bytesRead == sHeaderSize && file_version == sProtobufFileVersion) {
+        // Written before the fixed layout, it is converted by the next saveBuffer()
+        success = parseProtobufFile(fd, path, output);
+    } else {
+        ALOGW("Failed to read '%s', bytesRead=%zd file_version=%d", path.c_str(), bytesRead,
+                file_version);
+    }
     close(fd);
     return success;
 }
@@ -185,8 +343,30 @@ void dumpAsTextToFd(service::GraphicsStatsProto* proto, int fd) {
 
 void GraphicsStatsService::saveBuffer(const std::string& path, const std::string& package,
         int versionCode, int64_t startTime, int64_t endTime, const ProfileData* data) {
+    int fd = open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0660);
+    if (fd == -1) {
+        int err = errno;
+        ALOGW("Failed to open '%s', error=%d (%s)", path.c_str(), err, strerror(err));
+        return;
+    }
+
+    // Fast path, add the data to the counts of the existing file in place
+    size_t size;
+    FixedLayoutStats* stats = mapFixedLayoutStats(fd, true, &size);
+    if (stats && package.compare(0, std::string::npos, packageName(stats),
+            stats->packageNameLength) == 0) {
+        mergeProfileDataIntoFixedLayout(stats, versionCode, startTime, endTime, data);
+        munmap(stats, size);
+        close(fd);
+        return;
+    }
+    if (stats) {
+        munmap(stats, size);
+    }
+
+    // New file, or one that can't be merged in place such as a protobuf from an older version
     service::GraphicsStatsProto statsProto;
-    if (!parseFromFile(path, &statsProto)) {
+    if (!parseFromFile(path, &statsProto) || statsProto.package_name() != package) {
         statsProto.Clear();
     }
     mergeProfileDataIntoProto(&statsProto, package, versionCode, startTime, endTime, data);
@@ -197,43 +377,45 @@ void GraphicsStatsService::saveBuffer(const std::string& path, const std::string
     LOG_ALWAYS_FATAL_IF(statsProto.package_name().empty()
             || !statsProto.has_summary(), "package_name() '%s' summary %d",
             statsProto.package_name().c_str(), statsProto.has_summary());
-    int outFd = open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0660);
-    if (outFd <= 0) {
-        int err = errno;
-        ALOGW("Failed to open '%s', error=%d (%s)", path.c_str(), err, strerror(err));
-        return;
-    }
-    int wrote = write(outFd, &sCurrentFileVersion, sHeaderSize);
-    if (wrote != sHeaderSize) {
-        int err = errno;
-        ALOGW("Failed to write header to '%s', returned=%d errno=%d (%s)",
-                path.c_str(), wrote, err, strerror(err));
-        close(outFd);
-        return;
-    }
-    {
-        io::FileOutputStream output(outFd);
-        bool success = statsProto.SerializeToZeroCopyStream(&output) && output.Flush();
-        if (output.GetErrno() != 0) {
-            ALOGW("Error writing to fd=%d, path='%s' err=%d (%s)",
-                    outFd, path.c_str(), output.GetErrno(), strerror(output.GetErrno()));
-            success = false;
-        } else if (!success) {
-            ALOGW("Serialize failed on '%s' unknown error", path.c_str());
-        }
-    }
-    close(outFd);
+    writeFixedLayoutStats(fd, path, statsProto);
+    close(fd);
 }
 
+/*
+ * Protobuf dumps are streamed: each entry is written as a GraphicsStatsServiceDumpProto of its
+ * own, which parses the same as all of them in a single one since repeated fields append.
+ * This keeps a single GraphicsStatsProto in memory at a time, however many packages there are.
+ */
 class GraphicsStatsService::Dump {
 public:
-    Dump(int outFd, DumpType type) : mFd(outFd), mType(type) {}
+    Dump(int outFd, DumpType type) : mFd(outFd), mType(type), mOutput(outFd) {}
     int fd() { return mFd; }
     DumpType type() { return mType; }
-    service::GraphicsStatsServiceDumpProto& proto() { return mProto; }
+
+    // Clearing the previous entry keeps its allocations around for reuse
+    service::GraphicsStatsProto* nextStats() {
+        mProto.Clear();
+        return mProto.add_stats();
+    }
+
+    void write() {
+        if (mType == DumpType::Protobuf) {
+            mProto.SerializeToZeroCopyStream(&mOutput);
+        } else {
+            dumpAsTextToFd(mProto.mutable_stats(0), mFd);
+        }
+    }
+
+    void finish() {
+        if (mType == DumpType::Protobuf) {
+            mOutput.Flush();
+        }
+    }
+
 private:
     int mFd;
     DumpType mType;
+    io::FileOutputStream mOutput;
     service::GraphicsStatsServiceDumpProto mProto;
 };
 
@@ -243,45 +425,33 @@ GraphicsStatsService::Dump* GraphicsStatsService::createDump(int outFd, DumpType
 
 void GraphicsStatsService::addToDump(Dump* dump, const std::string& path, const std::string& package,
         int versionCode, int64_t startTime, int64_t endTime, const ProfileData* data) {
-    service::GraphicsStatsProto statsProto;
-    if (!path.empty() && !parseFromFile(path, &statsProto)) {
-        statsProto.Clear();
+    service::GraphicsStatsProto* statsProto = dump->nextStats();
+    if (!path.empty() && !parseFromFile(path, statsProto)) {
+        statsProto->Clear();
     }
     if (data) {
-        mergeProfileDataIntoProto(&statsProto, package, versionCode, startTime, endTime, data);
+        mergeProfileDataIntoProto(statsProto, package, versionCode, startTime, endTime, data);
     }
-    if (!statsProto.IsInitialized()) {
+    if (!statsProto->IsInitialized()) {
         ALOGW("Failed to load profile data from path '%s' and data %p",
                 path.empty() ? "<empty>" : path.c_str(), data);
         return;
     }
-
-    if (dump->type() == DumpType::Protobuf) {
-        dump->proto().add_stats()->CopyFrom(statsProto);
-    } else {
-        dumpAsTextToFd(&statsProto, dump->fd());
-    }
+    dump->write();
 }
 
 void GraphicsStatsService::addToDump(Dump* dump, const std::string& path) {
-    service::GraphicsStatsProto statsProto;
-    if (!parseFromFile(path, &statsProto)) {
+    service::GraphicsStatsProto* statsProto = dump->nextStats();
+    if (!parseFromFile(path, statsProto)) {
         return;
     }
-    if (dump->type() == DumpType::Protobuf) {
-        dump->proto().add_stats()->CopyFrom(statsProto);
-    } else {
-        dumpAsTextToFd(&statsProto, dump->fd());
-    }
+    dump->write();
 }
 
 void GraphicsStatsService::finishDump(Dump* dump) {
-    if (dump->type() == DumpType::Protobuf) {
-        io::FileOutputStream stream(dump->fd());
-        dump->proto().SerializeToZeroCopyStream(&stream);
-    }
+    dump->finish();
     delete dump;
 }
 
 } /* namespace uirenderer */
-} /* namespace android */
\ No newline at end of file
+} /* namespace android */
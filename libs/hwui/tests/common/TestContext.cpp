@@ -70,6 +70,10 @@ sp<Surface> TestContext::surface() {
 }
 
 void TestContext::createSurface() {
+    if (!mWidth || !mHeight) {
+        mWidth = gDisplay.w;
+        mHeight = gDisplay.h;
+    }
     if (mRenderOffscreen) {
         createOffscreenSurface();
     } else {
@@ -79,10 +83,11 @@ void TestContext::createSurface() {
 
 void TestContext::createWindowSurface() {
     mSurfaceControl = mSurfaceComposerClient->createSurface(String8("HwuiTest"),
-            gDisplay.w, gDisplay.h, PIXEL_FORMAT_RGBX_8888);
+            mWidth, mHeight, PIXEL_FORMAT_RGBX_8888);
 
     SurfaceComposerClient::openGlobalTransaction();
     mSurfaceControl->setLayer(0x7FFFFFF);
+    mSurfaceControl->setPosition(mLeft, mTop);
     mSurfaceControl->show();
     SurfaceComposerClient::closeGlobalTransaction();
     mSurface = mSurfaceControl->getSurface();
@@ -95,7 +100,7 @@ void TestContext::createOffscreenSurface() {
     producer->setMaxDequeuedBufferCount(3);
     producer->setAsyncMode(true);
     mConsumer = new BufferItemConsumer(consumer, GRALLOC_USAGE_HW_COMPOSER, 4);
-    mConsumer->setDefaultBufferSize(gDisplay.w, gDisplay.h);
+    mConsumer->setDefaultBufferSize(mWidth, mHeight);
     mSurface = new Surface(producer);
 }
 
@@ -50,6 +50,16 @@ public:
         mRenderOffscreen = renderOffscreen;
     }
 
+    // Must be called before surface(), defaults to the whole display
+    void setWindowBounds(int left, int top, int width, int height) {
+        LOG_ALWAYS_FATAL_IF(mSurface.get(),
+                "Must be called before surface is created");
+        mLeft = left;
+        mTop = top;
+        mWidth = width;
+        mHeight = height;
+    }
+
     sp<Surface> surface();
 
     void waitForVsync();
@@ -66,6 +76,11 @@ private:
     sp<Looper> mLooper;
     sp<Surface> mSurface;
     bool mRenderOffscreen;
+    int mLeft = 0;
+    int mTop = 0;
+    // 0 uses the size of the display
+    int mWidth = 0;
+    int mHeight = 0;
 };
 
 } // namespace test
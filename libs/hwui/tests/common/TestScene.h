@@ -33,8 +33,12 @@ class TestScene {
 public:
     struct Options {
         int count = 0;
+        // Frames drawn before the measured ones, a negative count picks a default
+        int warmupCount = -1;
         int reportFrametimeWeight = 0;
         bool renderOffscreen = true;
+        // Number of windows the scene is drawn in, each with its own context
+        int windowCount = 1;
     };
 
     template <class T>
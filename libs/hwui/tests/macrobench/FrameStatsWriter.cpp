@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameStatsWriter.h"
+
+#include <algorithm>
+#include <array>
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+struct FrameStage {
+    const char* name;
+    FrameInfoIndex start;
+    FrameInfoIndex end;
+};
+
+// A stage that starts and ends at the same index is a duration recorded as is
+static const std::array<FrameStage, 6> FRAME_STAGES = {
+    FrameStage { "Sync", FrameInfoIndex::SyncStart, FrameInfoIndex::IssueDrawCommandsStart },
+    FrameStage { "IssueDrawCommands", FrameInfoIndex::IssueDrawCommandsStart,
+            FrameInfoIndex::SwapBuffers },
+    FrameStage { "SwapBuffers", FrameInfoIndex::SwapBuffers, FrameInfoIndex::FrameCompleted },
+    FrameStage { "DequeueBuffer", FrameInfoIndex::DequeueBufferDuration,
+            FrameInfoIndex::DequeueBufferDuration },
+    FrameStage { "QueueBuffer", FrameInfoIndex::QueueBufferDuration,
+            FrameInfoIndex::QueueBufferDuration },
+    FrameStage { "Total", FrameInfoIndex::IntendedVsync, FrameInfoIndex::FrameCompleted },
+};
+
+static const std::array<int, 5> PERCENTILES = { 50, 90, 95, 99, 100 };
+
+static int64_t get(const FrameMetricsData& frame, FrameInfoIndex index) {
+    return frame[static_cast<int>(index)];
+}
+
+// Same as FrameInfo::duration()
+static int64_t stageDuration(const FrameMetricsData& frame, const FrameStage& stage) {
+    if (stage.start == stage.end) {
+        return get(frame, stage.start);
+    }
+    int64_t starttime = get(frame, stage.start);
+    int64_t gap = starttime > 0 ? get(frame, stage.end) - starttime : 0;
+    if (stage.end > FrameInfoIndex::SyncQueued && stage.start < FrameInfoIndex::SyncQueued) {
+        int64_t offset = get(frame, FrameInfoIndex::SyncStart)
+                - get(frame, FrameInfoIndex::SyncQueued);
+        if (offset > 0) {
+            gap -= offset;
+        }
+    }
+    return gap > 0 ? gap : 0;
+}
+
+static double toUs(nsecs_t duration) {
+    return duration / 1000.0;
+}
+
+// Nearest rank, durations must be sorted
+static nsecs_t percentile(const std::vector<nsecs_t>& durations, int p) {
+    size_t rank = (durations.size() * p + 99) / 100;
+    return durations[rank > 0 ? rank - 1 : 0];
+}
+
+static void writeStage(FILE* file, const char* name, const std::vector<nsecs_t>& durations) {
+    fprintf(file, "        \"%s\": {\n", name);
+    fprintf(file, "          \"percentiles\": {");
+    if (!durations.empty()) {
+        std::vector<nsecs_t> sorted(durations);
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < PERCENTILES.size(); i++) {
+            fprintf(file, "%s\"%d\": %.3f", i ? ", " : " ", PERCENTILES[i],
+                    toUs(percentile(sorted, PERCENTILES[i])));
+        }
+        fprintf(file, " ");
+    }
+    fprintf(file, "},\n");
+    fprintf(file, "          \"frames\": [");
+    for (size_t i = 0; i < durations.size(); i++) {
+        fprintf(file, "%s%.3f", i ? ", " : "", toUs(durations[i]));
+    }
+    fprintf(file, "]\n");
+    fprintf(file, "        }");
+}
+
+FrameStatsWriter::FrameStatsWriter(FILE* file)
+        : mFile(file) {
+    fprintf(mFile, "{\n  \"runs\": [");
+}
+
+FrameStatsWriter::~FrameStatsWriter() {
+    fprintf(mFile, "%s]\n}\n", mHasRuns ? "\n  " : "");
+    fclose(mFile);
+}
+
+void FrameStatsWriter::addRun(const std::string& name, int warmupCount,
+        const FrameStatsRecorder& recorder) {
+    const auto& frames = recorder.frames();
+    fprintf(mFile, "%s\n    {\n", mHasRuns ? "," : "");
+    mHasRuns = true;
+
+    // Test names are plain identifiers, nothing to escape
+    fprintf(mFile, "      \"name\": \"%s\",\n", name.c_str());
+    fprintf(mFile, "      \"warmup_frames\": %d,\n", warmupCount);
+    fprintf(mFile, "      \"frames\": %zu,\n", frames.size());
+    fprintf(mFile, "      \"stages\": {\n");
+
+    std::vector<nsecs_t> durations(frames.size());
+    for (size_t i = 0; i < FRAME_STAGES.size(); i++) {
+        for (size_t f = 0; f < frames.size(); f++) {
+            durations[f] = stageDuration(frames[f], FRAME_STAGES[i]);
+        }
+        writeStage(mFile, FRAME_STAGES[i].name, durations);
+        fprintf(mFile, ",\n");
+    }
+    writeStage(mFile, "GpuCompleted", recorder.gpuDurations());
+    fprintf(mFile, "\n      }\n    }");
+}
+
+} /* namespace test */
+} /* namespace uirenderer */
+} /* namespace android */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "FrameMetricsObserver.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+/**
+ * Records the FrameInfo of every frame drawn while it is attached to a RenderProxy. Frames
+ * are appended on the RenderThread, so they must only be read after a RenderProxy::fence().
+ */
+class FrameStatsRecorder : public FrameMetricsObserver {
+public:
+    explicit FrameStatsRecorder(int expectedFrameCount) {
+        mFrames.reserve(expectedFrameCount);
+        mGpuDurations.reserve(expectedFrameCount);
+    }
+
+    virtual void notify(const sp<FrameMetricsRing>& ring, uint64_t position) override {
+        FrameMetricsData data;
+        if (ring->read(position, &data)) {
+            mFrames.push_back(data);
+        }
+    }
+
+    virtual void notifyGpuCompleted(const int64_t* buffer, nsecs_t gpuCompleted) override {
+        mGpuDurations.push_back(gpuCompleted
+                - buffer[static_cast<int>(FrameInfoIndex::SwapBuffers)]);
+    }
+
+    const std::vector<FrameMetricsData>& frames() const { return mFrames; }
+
+    // Time from the swap to the GPU finishing each frame, empty if the pipeline can't tell
+    const std::vector<nsecs_t>& gpuDurations() const { return mGpuDurations; }
+
+private:
+    std::vector<FrameMetricsData> mFrames;
+    std::vector<nsecs_t> mGpuDurations;
+};
+
+/**
+ * Writes the frames recorded for every run of a scene into a single JSON document: the
+ * percentiles of each stage of the frame, followed by the raw per-frame durations so that
+ * baselines can be compared with other statistics. All durations are in microseconds.
+ */
+class FrameStatsWriter {
+public:
+    // Takes ownership of file, the document is completed and closed by the destructor
+    explicit FrameStatsWriter(FILE* file);
+    ~FrameStatsWriter();
+
+    void addRun(const std::string& name, int warmupCount, const FrameStatsRecorder& recorder);
+
+private:
+    FILE* mFile;
+    bool mHasRuns = false;
+};
+
+} /* namespace test */
+} /* namespace uirenderer */
+} /* namespace android */
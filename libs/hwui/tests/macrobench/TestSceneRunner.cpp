@@ -19,6 +19,7 @@
 #include "tests/common/TestContext.h"
 #include "tests/common/TestScene.h"
 #include "tests/common/scenes/TestSceneBase.h"
+#include "tests/macrobench/FrameStatsWriter.h"
 #include "renderthread/RenderProxy.h"
 #include "renderthread/RenderTask.h"
 
@@ -27,6 +28,10 @@
 #include <log/log.h>
 #include <ui/PixelFormat.h>
 
+#include <cmath>
+#include <string>
+#include <vector>
+
 using namespace android;
 using namespace android::uirenderer;
 using namespace android::uirenderer::renderthread;
@@ -84,12 +89,17 @@ void outputBenchmarkReport(const TestScene::Info& info, const TestScene::Options
     // otherwise the BenchmarkReporter will automatically compute
     // mean and stddev which doesn't make sense for our usage
     std::vector<BenchmarkReporter::Run> reports;
+    std::string name = info.name;
+    if (opts.windowCount > 1) {
+        name += "_x" + std::to_string(opts.windowCount);
+    }
     BenchmarkReporter::Run report;
-    report.benchmark_name = info.name;
+    report.benchmark_name = name;
     report.iterations = static_cast<int64_t>(opts.count);
     report.real_accumulated_time = durationInS;
     report.cpu_accumulated_time = durationInS;
-    report.items_per_second = opts.count / durationInS;
+    // Frames drawn by all the windows
+    report.items_per_second = opts.count * opts.windowCount / durationInS;
     reports.push_back(report);
     reporter->ReportRuns(reports);
 
@@ -98,7 +108,7 @@ void outputBenchmarkReport(const TestScene::Info& info, const TestScene::Options
     // in that test case than percentiles.
     if (!opts.renderOffscreen) {
         for (auto& ri : REPORTS) {
-            reports[0].benchmark_name = info.name;
+            reports[0].benchmark_name = name;
             reports[0].benchmark_name += ri.suffix;
             durationInS = proxy->frameTimePercentile(ri.percentile) / 1000.0;
             reports[0].real_accumulated_time = durationInS;
@@ -110,65 +120,105 @@ void outputBenchmarkReport(const TestScene::Info& info, const TestScene::Options
     }
 }
 
+// One window of a scene, each with its own surface and CanvasContext sharing the RenderThread
+struct TestWindow {
+    TestContext testContext;
+    std::unique_ptr<TestScene> scene;
+    sp<RenderNode> rootNode;
+    std::unique_ptr<RenderProxy> proxy;
+    sp<FrameStatsRecorder> recorder;
+};
+
+// Returns the vsync time, doFrame() is skipped for a negative frameNr
+static nsecs_t drawFrame(std::vector<std::unique_ptr<TestWindow>>& windows,
+        bool renderOffscreen, int frameNr) {
+    for (auto& window : windows) {
+        window->testContext.waitForVsync();
+        // Onscreen windows all share the display's vsync, offscreen ones only
+        // release the buffers their surface consumed without blocking
+        if (!renderOffscreen) break;
+    }
+    nsecs_t vsync = systemTime(CLOCK_MONOTONIC);
+    ATRACE_NAME("UI-Draw Frame");
+    for (auto& window : windows) {
+        UiFrameInfoBuilder(window->proxy->frameInfo()).setVsync(vsync, vsync);
+        if (frameNr >= 0) {
+            window->scene->doFrame(frameNr);
+        }
+        window->proxy->syncAndDrawFrame();
+    }
+    return vsync;
+}
+
 void run(const TestScene::Info& info, const TestScene::Options& opts,
-        benchmark::BenchmarkReporter* reporter) {
+        benchmark::BenchmarkReporter* reporter, FrameStatsWriter* frameStats) {
     // Switch to the real display
     gDisplay = getBuiltInDisplay();
 
-    std::unique_ptr<TestScene> scene(info.createScene(opts));
-
     Properties::forceDrawFrame = true;
-    TestContext testContext;
-    testContext.setRenderOffscreen(opts.renderOffscreen);
-
-    // create the native surface
-    const int width = gDisplay.w;
-    const int height = gDisplay.h;
-    sp<Surface> surface = testContext.surface();
 
-    sp<RenderNode> rootNode = TestUtils::createNode(0, 0, width, height,
-            [&scene, width, height](RenderProperties& props, Canvas& canvas) {
-        props.setClipToBounds(false);
-        scene->createContent(width, height, canvas);
-    });
+    // Tile the windows over the display, like freeform multi-window would
+    const int columns = static_cast<int>(ceilf(sqrtf(opts.windowCount)));
+    const int rows = (opts.windowCount + columns - 1) / columns;
+    const int width = gDisplay.w / columns;
+    const int height = gDisplay.h / rows;
 
     ContextFactory factory;
-    std::unique_ptr<RenderProxy> proxy(new RenderProxy(false,
-            rootNode.get(), &factory));
-    proxy->loadSystemProperties();
-    proxy->initialize(surface);
-    float lightX = width / 2.0;
-    proxy->setup(dp(800.0f), 255 * 0.075, 255 * 0.15);
-    proxy->setLightCenter((Vector3){lightX, dp(-200.0f), dp(800.0f)});
+    std::vector<std::unique_ptr<TestWindow>> windows;
+    for (int i = 0; i < opts.windowCount; i++) {
+        std::unique_ptr<TestWindow> window(new TestWindow());
+        window->scene.reset(info.createScene(opts));
+        window->testContext.setRenderOffscreen(opts.renderOffscreen);
+        window->testContext.setWindowBounds((i % columns) * width, (i / columns) * height,
+                width, height);
+
+        // create the native surface
+        sp<Surface> surface = window->testContext.surface();
+
+        TestScene* scene = window->scene.get();
+        window->rootNode = TestUtils::createNode(0, 0, width, height,
+                [scene, width, height](RenderProperties& props, Canvas& canvas) {
+            props.setClipToBounds(false);
+            scene->createContent(width, height, canvas);
+        });
+
+        window->proxy.reset(new RenderProxy(false, window->rootNode.get(), &factory));
+        RenderProxy* proxy = window->proxy.get();
+        proxy->loadSystemProperties();
+        proxy->initialize(surface);
+        float lightX = width / 2.0;
+        proxy->setup(dp(800.0f), 255 * 0.075, 255 * 0.15);
+        proxy->setLightCenter((Vector3){lightX, dp(-200.0f), dp(800.0f)});
+        windows.push_back(std::move(window));
+    }
+    RenderProxy* proxy = windows[0]->proxy.get();
 
     // Do a few cold runs then reset the stats so that the caches are all hot
-    int warmupFrameCount = 5;
-    if (opts.renderOffscreen) {
-        // Do a few more warmups to try and boost the clocks up
-        warmupFrameCount = 10;
+    int warmupFrameCount = opts.warmupCount;
+    if (warmupFrameCount < 0) {
+        // Do a few more warmups offscreen to try and boost the clocks up
+        warmupFrameCount = opts.renderOffscreen ? 10 : 5;
     }
     for (int i = 0; i < warmupFrameCount; i++) {
-        testContext.waitForVsync();
-        nsecs_t vsync = systemTime(CLOCK_MONOTONIC);
-        UiFrameInfoBuilder(proxy->frameInfo()).setVsync(vsync, vsync);
-        proxy->syncAndDrawFrame();
+        drawFrame(windows, opts.renderOffscreen, -1);
     }
 
+    // The jank stats are shared by all the contexts of the RenderThread
     proxy->resetProfileInfo();
     proxy->fence();
 
+    if (frameStats) {
+        for (auto& window : windows) {
+            window->recorder = new FrameStatsRecorder(opts.count);
+            window->proxy->addFrameMetricsObserver(window->recorder.get());
+        }
+    }
+
     ModifiedMovingAverage<double> avgMs(opts.reportFrametimeWeight);
 
     nsecs_t start = systemTime(CLOCK_MONOTONIC);
     for (int i = 0; i < opts.count; i++) {
-        testContext.waitForVsync();
-        nsecs_t vsync = systemTime(CLOCK_MONOTONIC);
-        {
-            ATRACE_NAME("UI-Draw Frame");
-            UiFrameInfoBuilder(proxy->frameInfo()).setVsync(vsync, vsync);
-            scene->doFrame(i);
-            proxy->syncAndDrawFrame();
-        }
+        nsecs_t vsync = drawFrame(windows, opts.renderOffscreen, i);
         if (opts.reportFrametimeWeight) {
             proxy->fence();
             nsecs_t done = systemTime(CLOCK_MONOTONIC);
@@ -181,8 +231,21 @@ void run(const TestScene::Info& info, const TestScene::Options& opts,
     proxy->fence();
     nsecs_t end = systemTime(CLOCK_MONOTONIC);
 
+    for (size_t i = 0; i < windows.size(); i++) {
+        auto& window = windows[i];
+        if (window->recorder) {
+            window->proxy->removeFrameMetricsObserver(window->recorder.get());
+            window->proxy->fence();
+            std::string name = info.name;
+            if (windows.size() > 1) {
+                name += "_window" + std::to_string(i);
+            }
+            frameStats->addRun(name, warmupFrameCount, *window->recorder);
+        }
+    }
+
     if (reporter) {
-        outputBenchmarkReport(info, opts, reporter, proxy.get(),
+        outputBenchmarkReport(info, opts, reporter, proxy,
                 (end - start) / (double) s2ns(1));
     } else {
         proxy->dumpProfileInfo(STDOUT_FILENO, DumpFlags::JankStats);
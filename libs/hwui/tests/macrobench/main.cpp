@@ -16,6 +16,7 @@
 
 #include "tests/common/LeakChecker.h"
 #include "tests/common/TestScene.h"
+#include "tests/macrobench/FrameStatsWriter.h"
 
 #include "hwui/Typeface.h"
 #include "protos/hwui.pb.h"
@@ -44,9 +45,10 @@ static int gRepeatCount = 1;
 static std::vector<TestScene::Info> gRunTests;
 static TestScene::Options gOpts;
 std::unique_ptr<benchmark::BenchmarkReporter> gBenchmarkReporter;
+std::unique_ptr<FrameStatsWriter> gFrameStatsWriter;
 
 void run(const TestScene::Info& info, const TestScene::Options& opts,
-        benchmark::BenchmarkReporter* reporter);
+        benchmark::BenchmarkReporter* reporter, FrameStatsWriter* frameStats);
 
 static void printHelp() {
     printf(R"(
@@ -55,6 +57,8 @@ USAGE: hwuimacro [OPTIONS] <TESTNAME>
 OPTIONS:
   -c, --count=NUM      NUM loops a test should run (example, number of frames)
   -r, --runs=NUM       Repeat the test(s) NUM times
+  --warmup=NUM         Draw NUM frames before measuring the test. Defaults to
+                       10 offscreen and 5 onscreen
   -h, --help           Display this help
   --list               List all tests
   --wait-for-gpu       Set this to wait for the GPU before producing the
@@ -68,6 +72,10 @@ OPTIONS:
   --onscreen           Render tests on device screen. By default tests
                        are offscreen rendered
   --benchmark_format   Set output format. Possible values are tabular, json, csv
+  --windows=NUM        Draw the test in NUM windows tiled over the display, each
+                       with its own context sharing the RenderThread
+  --frame-stats=FILE   Write the duration of each stage of every measured frame
+                       and their percentiles to FILE, as JSON
 )");
 }
 
@@ -157,6 +165,9 @@ enum {
     BenchmarkFormat,
     Onscreen,
     Offscreen,
+    Warmup,
+    FrameStats,
+    Windows,
 };
 }
 
@@ -171,6 +182,9 @@ static const struct option LONG_OPTIONS[] = {
     { "benchmark_format", required_argument, nullptr, LongOpts::BenchmarkFormat },
     { "onscreen", no_argument, nullptr, LongOpts::Onscreen },
     { "offscreen", no_argument, nullptr, LongOpts::Offscreen },
+    { "warmup", required_argument, nullptr, LongOpts::Warmup },
+    { "frame-stats", required_argument, nullptr, LongOpts::FrameStats },
+    { "windows", required_argument, nullptr, LongOpts::Windows },
     { 0, 0, 0, 0 }
 };
 
@@ -262,6 +276,35 @@ void parseOptions(int argc, char* argv[]) {
             gOpts.renderOffscreen = true;
             break;
 
+        case LongOpts::Warmup: {
+            char* end;
+            gOpts.warmupCount = strtol(optarg, &end, 10);
+            if (*end || gOpts.warmupCount < 0) {
+                fprintf(stderr, "Invalid warmup argument '%s'\n", optarg);
+                error = true;
+            }
+            break;
+        }
+
+        case LongOpts::Windows:
+            gOpts.windowCount = atoi(optarg);
+            if (gOpts.windowCount <= 0) {
+                fprintf(stderr, "Invalid windows argument '%s'\n", optarg);
+                error = true;
+            }
+            break;
+
+        case LongOpts::FrameStats: {
+            FILE* file = fopen(optarg, "we");
+            if (!file) {
+                fprintf(stderr, "Error opening '%s' %d\n", optarg, errno);
+                error = true;
+                break;
+            }
+            gFrameStatsWriter.reset(new FrameStatsWriter(file));
+            break;
+        }
+
         case 'h':
             printHelp();
             exit(EXIT_SUCCESS);
@@ -318,6 +361,10 @@ int main(int argc, char* argv[]) {
         }
         // _50th, _90th, etc...
         name_field_width += 5;
+        if (gOpts.windowCount > 1) {
+            // _x4
+            name_field_width += 2 + std::to_string(gOpts.windowCount).size();
+        }
 
         benchmark::BenchmarkReporter::Context context;
         context.num_cpus = benchmark::NumCPUs();
@@ -329,13 +376,14 @@ int main(int argc, char* argv[]) {
 
     for (int i = 0; i < gRepeatCount; i++) {
         for (auto&& test : gRunTests) {
-            run(test, gOpts, gBenchmarkReporter.get());
+            run(test, gOpts, gBenchmarkReporter.get(), gFrameStatsWriter.get());
         }
     }
 
     if (gBenchmarkReporter) {
         gBenchmarkReporter->Finalize();
     }
+    gFrameStatsWriter.reset();
 
     LeakChecker::checkForLeaks();
     return 0;
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "utils/Blur.h"
+
+#include <memory>
+
+using namespace android;
+using namespace android::uirenderer;
+
+// Roughly the size of a launcher label's shadow
+static const int32_t kWidth = 256;
+static const int32_t kHeight = 64;
+
+static std::unique_ptr<uint8_t[]> createImage() {
+    std::unique_ptr<uint8_t[]> image(new uint8_t[kWidth * kHeight]);
+    for (int32_t i = 0; i < kWidth * kHeight; i++) {
+        image[i] = (i * 37) & 0xff;
+    }
+    return image;
+}
+
+void BM_Blur_gaussian(benchmark::State& state) {
+    const float radius = state.range(0);
+    const uint32_t intRadius = Blur::convertRadiusToInt(radius);
+    std::unique_ptr<float[]> weights(new float[2 * intRadius + 1]);
+    Blur::generateGaussianWeights(weights.get(), radius);
+    std::unique_ptr<uint8_t[]> image = createImage();
+    std::unique_ptr<uint8_t[]> scratch(new uint8_t[kWidth * kHeight]);
+
+    while (state.KeepRunning()) {
+        Blur::horizontal(weights.get(), intRadius, image.get(), scratch.get(), kWidth, kHeight);
+        Blur::vertical(weights.get(), intRadius, scratch.get(), image.get(), kWidth, kHeight);
+        benchmark::DoNotOptimize(image.get());
+    }
+}
+BENCHMARK(BM_Blur_gaussian)->Arg(2)->Arg(8)->Arg(25);
+
+void BM_Blur_approximateGaussian(benchmark::State& state) {
+    const float radius = state.range(0);
+    std::unique_ptr<uint8_t[]> image = createImage();
+    std::unique_ptr<uint8_t[]> scratch(new uint8_t[kWidth * kHeight]);
+
+    while (state.KeepRunning()) {
+        Blur::approximateGaussian(radius, image.get(), scratch.get(), kWidth, kHeight);
+        benchmark::DoNotOptimize(image.get());
+    }
+}
+BENCHMARK(BM_Blur_approximateGaussian)->Arg(25)->Arg(50);
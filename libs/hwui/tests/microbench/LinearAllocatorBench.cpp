@@ -46,3 +46,21 @@ static void BM_LinearStdAllocator_vector(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_LinearStdAllocator_vector);
+
+struct SimpleOp {
+    float left, top, right, bottom;
+    const void* paint;
+};
+
+static void BM_LinearAllocator_recordList(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        LinearAllocator la;
+        LinearStdAllocator<void*> stdAllocator(la);
+        LsaVector<SimpleOp*> ops(stdAllocator);
+        for (int j = 0; j < state.range(0); j++) {
+            ops.push_back(la.create_trivial<SimpleOp>());
+        }
+        benchmark::DoNotOptimize(&ops);
+    }
+}
+BENCHMARK(BM_LinearAllocator_recordList)->Arg(500)->Arg(15000);
@@ -18,6 +18,7 @@
 
 #include "PathParser.h"
 #include "VectorDrawable.h"
+#include "utils/VectorDrawableUtils.h"
 
 #include <SkPath.h>
 
@@ -49,3 +50,50 @@ void BM_PathParser_parseStringPathForPathData(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_PathParser_parseStringPathForPathData);
+
+void BM_PathParser_cachedPathData(benchmark::State& state) {
+    size_t length = strlen(sPathString);
+    PathParser::ParseResult result;
+    while (state.KeepRunning()) {
+        PathData outData;
+        PathParser::getCachedPathDataFromAsciiString(&outData, &result, sPathString, length);
+        benchmark::DoNotOptimize(&result);
+        benchmark::DoNotOptimize(&outData);
+    }
+}
+BENCHMARK(BM_PathParser_cachedPathData);
+
+void BM_PathParser_binaryPathData(benchmark::State& state) {
+    PathData pathData;
+    PathParser::ParseResult result;
+    PathParser::getPathDataFromAsciiString(&pathData, &result, sPathString, strlen(sPathString));
+    std::vector<uint8_t> buffer;
+    PathParser::serializePathData(pathData, &buffer);
+    while (state.KeepRunning()) {
+        PathData outData;
+        PathParser::getPathDataFromBinary(&outData, &result, buffer.data(), buffer.size());
+        benchmark::DoNotOptimize(&result);
+        benchmark::DoNotOptimize(&outData);
+    }
+}
+BENCHMARK(BM_PathParser_binaryPathData);
+
+void BM_VectorDrawableUtils_morphPath(benchmark::State& state) {
+    PathData fromData;
+    PathParser::ParseResult result;
+    PathParser::getPathDataFromAsciiString(&fromData, &result, sPathString, strlen(sPathString));
+    PathData toData = fromData;
+    for (float& point : toData.points) {
+        point += 10;
+    }
+    PathData outData;
+    SkPath skPath;
+    float fraction = 0;
+    while (state.KeepRunning()) {
+        VectorDrawableUtils::interpolatePathData(&outData, fromData, toData, fraction);
+        VectorDrawableUtils::verbsToPath(&skPath, outData);
+        benchmark::DoNotOptimize(&skPath);
+        fraction = fraction < 1 ? fraction + 0.01f : 0;
+    }
+}
+BENCHMARK(BM_VectorDrawableUtils_morphPath);
@@ -16,15 +16,19 @@
 
 #include <benchmark/benchmark.h>
 
+#include "AmbientShadow.h"
 #include "Matrix.h"
 #include "Rect.h"
+#include "SpotShadow.h"
 #include "Vector.h"
 #include "VertexBuffer.h"
 #include "TessellationCache.h"
 
 #include <SkPath.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 using namespace android;
 using namespace android::uirenderer;
@@ -109,3 +113,47 @@ void BM_TessellateShadows_roundrect_translucent(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_TessellateShadows_roundrect_translucent);
+
+// A 100x100 caster at z = 32, with rounded corners made of 8 segments each
+static std::vector<Vector3> createRoundRectCasterPolygon() {
+    std::vector<Vector3> polygon;
+    const float radius = 10;
+    const Vector2 centers[] = {{90, 90}, {10, 90}, {10, 10}, {90, 10}};
+    for (int corner = 0; corner < 4; corner++) {
+        for (int i = 0; i <= 8; i++) {
+            float angle = (corner * 8 + i) * M_PI / 16;
+            polygon.push_back({centers[corner].x + radius * cosf(angle),
+                    centers[corner].y + radius * sinf(angle), 32});
+        }
+    }
+    // shadows require CCW polygons
+    std::reverse(polygon.begin(), polygon.end());
+    return polygon;
+}
+
+void BM_AmbientShadow_roundrect(benchmark::State& state) {
+    std::vector<Vector3> polygon = createRoundRectCasterPolygon();
+    const Vector3 centroid = {50, 50, 32};
+
+    while (state.KeepRunning()) {
+        VertexBuffer ambient;
+        AmbientShadow::createAmbientShadow(true, polygon.data(), polygon.size(), centroid,
+                1.0f / 128, 64, ambient);
+        benchmark::DoNotOptimize(&ambient);
+    }
+}
+BENCHMARK(BM_AmbientShadow_roundrect);
+
+void BM_SpotShadow_roundrect(benchmark::State& state) {
+    std::vector<Vector3> polygon = createRoundRectCasterPolygon();
+    const Vector3 centroid = {50, 50, 32};
+    const Vector3 lightCenter = {768, -400, 1600};
+
+    while (state.KeepRunning()) {
+        VertexBuffer spot;
+        SpotShadow::createSpotShadow(true, lightCenter, 800, polygon.data(), polygon.size(),
+                centroid, spot);
+        benchmark::DoNotOptimize(&spot);
+    }
+}
+BENCHMARK(BM_SpotShadow_roundrect);
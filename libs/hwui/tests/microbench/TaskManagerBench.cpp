@@ -15,6 +15,7 @@
  */
 
 #include <benchmark/benchmark.h>
+#include <utils/Timers.h>
 
 #include "thread/Task.h"
 #include "thread/TaskManager.h"
@@ -86,3 +87,52 @@ void BM_TaskManager_enqueueRunDeleteTask(benchmark::State& state) {
     state.PauseTiming();
 }
 BENCHMARK(BM_TaskManager_enqueueRunDeleteTask);
+
+class SpinTask : public Task<char> {
+public:
+    explicit SpinTask(nsecs_t duration)
+            : mDuration(duration) {}
+
+    const nsecs_t mDuration;
+};
+
+class SpinProcessor : public TaskProcessor<char> {
+public:
+    explicit SpinProcessor(TaskManager* manager)
+            : TaskProcessor(manager) {}
+    virtual ~SpinProcessor() {}
+    virtual void onProcess(const sp<Task<char> >& task) override {
+        SpinTask* t = static_cast<SpinTask*>(task.get());
+        nsecs_t end = systemTime(SYSTEM_TIME_MONOTONIC) + t->mDuration;
+        while (systemTime(SYSTEM_TIME_MONOTONIC) < end) {}
+        t->setResult('a');
+    }
+};
+
+// Measures how long short tasks wait when they are queued behind a long one,
+// which is the tail latency a frame sees when precaching work is in flight
+void BM_TaskManager_mixedTaskLatency(benchmark::State& state) {
+    TaskManager taskManager;
+    sp<SpinProcessor> processor(new SpinProcessor(&taskManager));
+    const size_t shortTaskCount = state.range(0);
+
+    while (state.KeepRunning()) {
+        sp<SpinTask> longTask(new SpinTask(2000000));
+        processor->add(longTask);
+
+        std::vector<sp<SpinTask> > shortTasks;
+        shortTasks.reserve(shortTaskCount);
+        for (size_t i = 0; i < shortTaskCount; i++) {
+            shortTasks.emplace_back(new SpinTask(10000));
+            processor->add(shortTasks.back());
+        }
+        for (sp<SpinTask>& task : shortTasks) {
+            benchmark::DoNotOptimize(task->getResult());
+        }
+
+        state.PauseTiming();
+        longTask->getResult();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_TaskManager_mixedTaskLatency)->Arg(4)->Arg(16)->Arg(64);
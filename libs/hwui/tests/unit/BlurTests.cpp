@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "utils/Blur.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+using namespace android;
+using namespace android::uirenderer;
+
+static void blurReference(const float* weights, int32_t radius, const uint8_t* source,
+        uint8_t* dest, int32_t width, int32_t height, int32_t stepX, int32_t stepY) {
+    for (int32_t y = 0; y < height; y++) {
+        for (int32_t x = 0; x < width; x++) {
+            float sum = 0.0f;
+            for (int32_t r = -radius; r <= radius; r++) {
+                int32_t sx = std::min(std::max(x + r * stepX, 0), width - 1);
+                int32_t sy = std::min(std::max(y + r * stepY, 0), height - 1);
+                sum += source[sy * width + sx] * weights[r + radius];
+            }
+            dest[y * width + x] = (uint8_t) sum;
+        }
+    }
+}
+
+TEST(Blur, gaussianMatchesReference) {
+    // Odd sizes exercise the vector loops' tails and images narrower than the kernel
+    const int32_t sizes[][2] = { { 37, 13 }, { 5, 40 }, { 64, 64 } };
+    for (auto& size : sizes) {
+        const int32_t width = size[0];
+        const int32_t height = size[1];
+        std::unique_ptr<uint8_t[]> source(new uint8_t[width * height]);
+        for (int32_t i = 0; i < width * height; i++) {
+            source[i] = (i * 73 + 11) & 0xff;
+        }
+
+        const float radius = 6.0f;
+        const int32_t intRadius = Blur::convertRadiusToInt(radius);
+        std::unique_ptr<float[]> weights(new float[2 * intRadius + 1]);
+        Blur::generateGaussianWeights(weights.get(), radius);
+
+        std::unique_ptr<uint8_t[]> expected(new uint8_t[width * height]);
+        std::unique_ptr<uint8_t[]> actual(new uint8_t[width * height]);
+        for (bool horizontal : { true, false }) {
+            blurReference(weights.get(), intRadius, source.get(), expected.get(),
+                    width, height, horizontal ? 1 : 0, horizontal ? 0 : 1);
+            if (horizontal) {
+                Blur::horizontal(weights.get(), intRadius, source.get(), actual.get(),
+                        width, height);
+            } else {
+                Blur::vertical(weights.get(), intRadius, source.get(), actual.get(),
+                        width, height);
+            }
+            for (int32_t i = 0; i < width * height; i++) {
+                // Vector and scalar float rounding may differ by one step
+                ASSERT_NEAR(expected[i], actual[i], 1) << "at " << i;
+            }
+        }
+    }
+}
+
+TEST(Blur, approximateGaussian) {
+    const int32_t width = 120;
+    const int32_t height = 80;
+    std::unique_ptr<uint8_t[]> image(new uint8_t[width * height]);
+    std::unique_ptr<uint8_t[]> scratch(new uint8_t[width * height]);
+
+    // A flat image stays flat
+    memset(image.get(), 77, width * height);
+    Blur::approximateGaussian(40.0f, image.get(), scratch.get(), width, height);
+    for (int32_t i = 0; i < width * height; i++) {
+        ASSERT_EQ(77, image[i]);
+    }
+
+    // A single bright row spreads out symmetrically
+    memset(image.get(), 0, width * height);
+    memset(image.get() + (height / 2) * width, 255, width);
+    Blur::approximateGaussian(30.0f, image.get(), scratch.get(), width, height);
+    const uint8_t* column = image.get() + width / 2;
+    EXPECT_GT(column[(height / 2) * width], column[(height / 2 - 10) * width]);
+    EXPECT_GT(column[(height / 2 - 10) * width], 0);
+    EXPECT_NEAR(column[(height / 2 - 10) * width], column[(height / 2 + 10) * width], 1);
+}
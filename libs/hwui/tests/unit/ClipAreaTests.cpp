@@ -85,6 +85,30 @@ TEST(RectangleList, basics) {
     EXPECT_FALSE(rgn.isEmpty());
 }
 
+TEST(RectangleList, intersectWithRectToRect) {
+    RectangleList list;
+    list.set(Rect(0, 0, 200, 200), Matrix4::identity());
+
+    Matrix4 m45;
+    m45.loadRotate(45);
+    list.intersectWith(Rect(0, 0, 100, 100), m45);
+    EXPECT_EQ(2, list.getTransformedRectanglesCount());
+
+    // Axis aligned clips are folded into the identity rectangle, whatever their transform.
+    Matrix4 translateScale;
+    translateScale.loadTranslate(10, 20, 0);
+    translateScale.scale(2, 2, 1);
+    list.intersectWith(Rect(0, 0, 50, 50), translateScale);
+    EXPECT_EQ(2, list.getTransformedRectanglesCount());
+    EXPECT_EQ(Rect(10, 20, 110, 120), list.getTransformedRectangle(0).getBounds());
+
+    Matrix4 m90;
+    m90.loadRotate(90);
+    list.intersectWith(Rect(0, -150, 150, 0), m90);
+    EXPECT_EQ(2, list.getTransformedRectanglesCount());
+    EXPECT_EQ(Rect(10, 20, 110, 120), list.getTransformedRectangle(0).getBounds());
+}
+
 TEST(ClipArea, basics) {
     ClipArea area(createClipArea());
     EXPECT_FALSE(area.isEmpty());
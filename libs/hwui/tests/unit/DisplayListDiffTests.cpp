@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "AnimationContext.h"
+#include "DamageAccumulator.h"
+#include "DisplayListDiff.h"
+#include "IContextFactory.h"
+#include "RecordingCanvas.h"
+#include "renderthread/CanvasContext.h"
+#include "tests/common/TestUtils.h"
+
+using namespace android;
+using namespace android::uirenderer;
+using namespace android::uirenderer::renderthread;
+
+namespace {
+class ContextFactory : public IContextFactory {
+public:
+    AnimationContext* createAnimationContext(TimeLord& clock) override {
+        return new AnimationContext(clock);
+    }
+};
+} // namespace
+
+static std::unique_ptr<DisplayList> createRectList(SkColor secondColor) {
+    return TestUtils::createDisplayList<RecordingCanvas>(200, 200, [&](RecordingCanvas& canvas) {
+        SkPaint paint;
+        paint.setColor(SK_ColorBLUE);
+        canvas.drawRect(0, 0, 100, 100, paint);
+        paint.setColor(secondColor);
+        canvas.drawRect(120, 130, 140, 150, paint);
+    });
+}
+
+OPENGL_PIPELINE_TEST(DisplayListDiff, identical) {
+    auto previous = createRectList(SK_ColorRED);
+    auto next = createRectList(SK_ColorRED);
+
+    Rect damage(1, 1, 2, 2);
+    ASSERT_TRUE(DisplayListDiff::computeDamage(*previous, *next, &damage));
+    EXPECT_TRUE(damage.isEmpty());
+}
+
+OPENGL_PIPELINE_TEST(DisplayListDiff, paintChange) {
+    auto previous = createRectList(SK_ColorRED);
+    auto next = createRectList(SK_ColorGREEN);
+
+    Rect damage;
+    ASSERT_TRUE(DisplayListDiff::computeDamage(*previous, *next, &damage));
+    // only the second rect, outset for antialiasing
+    EXPECT_EQ(Rect(119, 129, 141, 151), damage);
+}
+
+OPENGL_PIPELINE_TEST(DisplayListDiff, structureChange) {
+    auto previous = createRectList(SK_ColorRED);
+    auto next = TestUtils::createDisplayList<RecordingCanvas>(200, 200,
+            [](RecordingCanvas& canvas) {
+        canvas.drawRect(0, 0, 100, 100, SkPaint());
+    });
+
+    Rect damage;
+    EXPECT_FALSE(DisplayListDiff::computeDamage(*previous, *next, &damage));
+}
+
+OPENGL_PIPELINE_TEST(DisplayListDiff, mutableBitmap) {
+    sk_sp<Bitmap> bitmap(TestUtils::createBitmap(20, 20));
+    auto record = [&bitmap](RecordingCanvas& canvas) {
+        canvas.drawBitmap(*bitmap, 10, 10, nullptr);
+    };
+    auto previous = TestUtils::createDisplayList<RecordingCanvas>(200, 200, record);
+    auto next = TestUtils::createDisplayList<RecordingCanvas>(200, 200, record);
+
+    // The bitmap contents may have changed between the two recordings
+    Rect damage;
+    ASSERT_TRUE(DisplayListDiff::computeDamage(*previous, *next, &damage));
+    EXPECT_EQ(Rect(9, 9, 31, 31), damage);
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(DisplayListDiff, prepareTree_damageChangedOps) {
+    ScopedProperty<bool> diffDisplayLists(Properties::diffDisplayLists, true);
+    auto node = TestUtils::createNode(0, 0, 200, 200, nullptr);
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(CanvasContext::create(
+            renderThread, false, node.get(), &contextFactory));
+
+    SkColor secondColor = SK_ColorRED;
+    auto record = [&secondColor](Canvas& canvas) {
+        SkPaint paint;
+        paint.setColor(SK_ColorBLUE);
+        canvas.drawRect(0, 0, 100, 100, paint);
+        paint.setColor(secondColor);
+        canvas.drawRect(120, 130, 140, 150, paint);
+    };
+    auto prepareTree = [&]() {
+        TreeInfo info(TreeInfo::MODE_FULL, *canvasContext.get());
+        DamageAccumulator damageAccumulator;
+        info.damageAccumulator = &damageAccumulator;
+        node->prepareTree(info);
+        SkRect dirty;
+        damageAccumulator.finish(&dirty);
+        return dirty;
+    };
+
+    TestUtils::recordNode(*node, record);
+    EXPECT_EQ(SkRect::MakeWH(200, 200), prepareTree());
+
+    secondColor = SK_ColorGREEN;
+    TestUtils::recordNode(*node, record);
+    EXPECT_EQ(SkRect::MakeLTRB(119, 129, 141, 151), prepareTree());
+
+    TestUtils::recordNode(*node, record);
+    EXPECT_TRUE(prepareTree().isEmpty());
+
+    canvasContext->destroy();
+}
@@ -17,6 +17,8 @@
 #include <gtest/gtest.h>
 
 #include "GammaFontRenderer.h"
+#include "font/CacheTexture.h"
+#include "font/FontUtil.h"
 #include "tests/common/TestUtils.h"
 
 using namespace android::uirenderer;
@@ -53,3 +55,53 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(FontRenderer, DISABLED_renderDropShadow) {
         delete result.image;
     }
 }
+
+static SkGlyph makeGlyph(uint16_t width, uint16_t height) {
+    SkGlyph glyph;
+    glyph.fWidth = width;
+    glyph.fHeight = height;
+    glyph.fMaskFormat = SkMask::kA8_Format;
+    return glyph;
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(CacheTexture, fitBitmap_packsWithoutOverlap) {
+    CacheTexture cacheTexture(128, 64, GL_ALPHA, 16);
+
+    std::vector<Rect> placed;
+    for (int i = 0; i < 1000; i++) {
+        SkGlyph glyph = makeGlyph(4 + (i * 7) % 13, 3 + (i * 5) % 11);
+        uint32_t x, y;
+        if (!cacheTexture.fitBitmap(glyph, &x, &y)) {
+            break;
+        }
+        Rect bounds(x, y, x + glyph.fWidth + TEXTURE_BORDER_SIZE,
+                y + glyph.fHeight + TEXTURE_BORDER_SIZE);
+        EXPECT_LE(bounds.right, 128);
+        EXPECT_LE(bounds.bottom, 64);
+        for (const Rect& other : placed) {
+            EXPECT_FALSE(bounds.intersects(other));
+        }
+        placed.push_back(bounds);
+    }
+
+    // Mixed sizes should share rows instead of wasting most of the texture
+    EXPECT_EQ(placed.size(), cacheTexture.getGlyphCount());
+    EXPECT_LT(cacheTexture.calculateFreeMemory(), 128u * 64u / 4);
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(CacheTexture, fitBitmap_usesLowestPosition) {
+    CacheTexture cacheTexture(24, 64, GL_ALPHA, 16);
+
+    uint32_t x, y;
+    ASSERT_TRUE(cacheTexture.fitBitmap(makeGlyph(10, 20), &x, &y));
+    EXPECT_EQ(1u, x);
+    EXPECT_EQ(1u, y);
+    ASSERT_TRUE(cacheTexture.fitBitmap(makeGlyph(10, 5), &x, &y));
+    EXPECT_EQ(12u, x);
+    EXPECT_EQ(1u, y);
+
+    // Goes under the short glyph rather than under the tall one
+    ASSERT_TRUE(cacheTexture.fitBitmap(makeGlyph(10, 5), &x, &y));
+    EXPECT_EQ(12u, x);
+    EXPECT_EQ(7u, y);
+}
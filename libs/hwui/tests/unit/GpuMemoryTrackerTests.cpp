@@ -24,6 +24,8 @@
 
 #include <utils/StrongPointer.h>
 
+#include <sstream>
+
 using namespace android;
 using namespace android::uirenderer;
 using namespace android::uirenderer::renderthread;
@@ -68,3 +70,30 @@ TEST(GpuMemoryTracker, sizeCheck) {
     ASSERT_EQ(0, GpuMemoryTracker::getInstanceCount(GpuObjectType::Texture));
     GpuMemoryTracker::onGpuContextDestroyed();
 }
+
+TEST(GpuMemoryTracker, peaks) {
+    destroyEglContext();
+
+    GpuMemoryTracker::onGpuContextCreated();
+    ASSERT_EQ(0, GpuMemoryTracker::getPeakTotalSize(GpuObjectType::Texture));
+    ASSERT_EQ(0, GpuMemoryTracker::getPeakInstanceCount(GpuObjectType::Texture));
+    {
+        TestGPUObject first;
+        first.changeSize(1000);
+        {
+            TestGPUObject second;
+            second.changeSize(500);
+            ASSERT_EQ(2, GpuMemoryTracker::getPeakInstanceCount(GpuObjectType::Texture));
+            ASSERT_EQ(1500, GpuMemoryTracker::getPeakTotalSize(GpuObjectType::Texture));
+        }
+        first.changeSize(200);
+
+        std::stringstream dump;
+        GpuMemoryTracker::dump(dump);
+        EXPECT_NE(std::string::npos, dump.str().find("peak count = 2"));
+        EXPECT_NE(std::string::npos, dump.str().find("<1s=1"));
+    }
+    EXPECT_EQ(2, GpuMemoryTracker::getPeakInstanceCount(GpuObjectType::Texture));
+    EXPECT_EQ(1500, GpuMemoryTracker::getPeakTotalSize(GpuObjectType::Texture));
+    GpuMemoryTracker::onGpuContextDestroyed();
+}
@@ -38,3 +38,31 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(GradientCache, addRemove) {
     cache.clear();
     ASSERT_EQ(cache.getSize(), 0u);
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(GradientCache, recyclesEvictedTexture) {
+    Extensions extensions;
+    GradientCache cache(extensions);
+
+    SkColor colors[] = { 0xFF00FF00, 0xFFFF0000, 0xFF0000FF };
+    float positions[] = { 0.0f, 0.5f, 1.0f };
+    Texture* oldest = cache.get(colors, positions, 3);
+    ASSERT_TRUE(oldest);
+    const GLuint oldestId = oldest->id();
+    const uint32_t textureSize = oldest->objectSize();
+
+    // Fill the cache with gradients of the same size, as when animating the
+    // colors of a gradient. Once full, the storage of the oldest is reused.
+    const uint32_t textureCount = cache.getMaxSize() / textureSize;
+    Texture* texture = nullptr;
+    for (uint32_t i = 0; i < textureCount; i++) {
+        colors[1] = 0xFF000000 | (i + 1);
+        texture = cache.get(colors, positions, 3);
+        ASSERT_TRUE(texture);
+        ASSERT_LE(cache.getSize(), cache.getMaxSize());
+    }
+    EXPECT_EQ(oldest, texture);
+    EXPECT_EQ(oldestId, texture->id());
+    EXPECT_EQ(textureSize, (uint32_t) texture->objectSize());
+    cache.clear();
+    ASSERT_EQ(cache.getSize(), 0u);
+}
@@ -22,8 +22,10 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace android;
@@ -156,4 +158,93 @@ TEST(GraphicsStats, merge) {
         EXPECT_EQ(expectedCount, loadedProto.histogram().Get(i).frame_count());
         EXPECT_EQ(expectedBucket, loadedProto.histogram().Get(i).render_millis());
     }
-}
\ No newline at end of file
+}
+TEST(GraphicsStats, convertProtobufFile) {
+    std::string path = findRootPath() + "/test_convertProtobufFile";
+    std::string packageName = "com.test.convert";
+    ProfileData mockData;
+    memset(&mockData, 0, sizeof(mockData));
+    mockData.jankFrameCount = 2;
+    mockData.totalFrameCount = 10;
+    mockData.frameCounts[3] = 10;
+
+    // Written the way files were before they had a fixed layout
+    service::GraphicsStatsProto legacyProto;
+    legacyProto.set_package_name(packageName);
+    legacyProto.set_version_code(4);
+    legacyProto.set_stats_start(1000);
+    legacyProto.set_stats_end(2000);
+    legacyProto.mutable_summary()->set_total_frames(5);
+    legacyProto.mutable_summary()->set_janky_frames(1);
+    for (size_t i = 0; i < mockData.frameCounts.size(); i++) {
+        auto bucket = legacyProto.add_histogram();
+        bucket->set_render_millis(JankTracker::frameTimeForFrameCountIndex(i));
+        bucket->set_frame_count(i == 3 ? 5 : 0);
+    }
+    for (size_t i = 0; i < mockData.slowFrameCounts.size(); i++) {
+        auto bucket = legacyProto.add_histogram();
+        bucket->set_render_millis(JankTracker::frameTimeForSlowFrameCountIndex(i));
+        bucket->set_frame_count(0);
+    }
+    FILE* file = fopen(path.c_str(), "wb");
+    ASSERT_NE(nullptr, file);
+    int32_t version = 1;
+    fwrite(&version, sizeof(version), 1, file);
+    std::string serialized = legacyProto.SerializeAsString();
+    fwrite(serialized.data(), 1, serialized.size(), file);
+    fclose(file);
+
+    GraphicsStatsService::saveBuffer(path, packageName, 5, 3000, 7000, &mockData);
+    // Merged in place this time
+    GraphicsStatsService::saveBuffer(path, packageName, 5, 7000, 9000, &mockData);
+    service::GraphicsStatsProto loadedProto;
+    EXPECT_TRUE(GraphicsStatsService::parseFromFile(path, &loadedProto));
+    unlink(path.c_str());
+
+    EXPECT_EQ(packageName, loadedProto.package_name());
+    EXPECT_EQ(5, loadedProto.version_code());
+    EXPECT_EQ(1000, loadedProto.stats_start());
+    EXPECT_EQ(9000, loadedProto.stats_end());
+    EXPECT_EQ(5 + 10 + 10, loadedProto.summary().total_frames());
+    EXPECT_EQ(1 + 2 + 2, loadedProto.summary().janky_frames());
+    ASSERT_EQ(legacyProto.histogram_size(), loadedProto.histogram_size());
+    EXPECT_EQ(5 + 10 + 10, loadedProto.histogram(3).frame_count());
+    EXPECT_EQ(0, loadedProto.histogram(4).frame_count());
+}
+
+TEST(GraphicsStats, streamedDump) {
+    std::string path = findRootPath() + "/test_streamedDump";
+    std::string dumpPath = findRootPath() + "/test_streamedDump.dump";
+    ProfileData mockData;
+    memset(&mockData, 0, sizeof(mockData));
+    mockData.totalFrameCount = 10;
+    GraphicsStatsService::saveBuffer(path, "com.test.first", 1, 1000, 2000, &mockData);
+
+    int fd = open(dumpPath.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0660);
+    ASSERT_NE(-1, fd);
+    auto dump = GraphicsStatsService::createDump(fd, GraphicsStatsService::DumpType::Protobuf);
+    GraphicsStatsService::addToDump(dump, path);
+    GraphicsStatsService::addToDump(dump, "", "com.test.second", 2, 3000, 4000, &mockData);
+    GraphicsStatsService::finishDump(dump);
+    close(fd);
+    unlink(path.c_str());
+
+    service::GraphicsStatsServiceDumpProto dumpProto;
+    FILE* file = fopen(dumpPath.c_str(), "rb");
+    ASSERT_NE(nullptr, file);
+    std::string serialized;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        serialized.append(buffer, read);
+    }
+    fclose(file);
+    unlink(dumpPath.c_str());
+
+    ASSERT_TRUE(dumpProto.ParseFromString(serialized));
+    ASSERT_EQ(2, dumpProto.stats_size());
+    EXPECT_EQ("com.test.first", dumpProto.stats(0).package_name());
+    EXPECT_EQ(10, dumpProto.stats(0).summary().total_frames());
+    EXPECT_EQ("com.test.second", dumpProto.stats(1).package_name());
+    EXPECT_EQ(2, dumpProto.stats(1).version_code());
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "JankTracker.h"
+#include "utils/TimeUtils.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+static DisplayInfo createDisplayInfo() {
+    DisplayInfo info;
+    info.fps = 60;
+    return info;
+}
+
+static void addFrame(JankTracker* tracker, nsecs_t sync, nsecs_t issue, nsecs_t swap) {
+    FrameInfo frame;
+    memset(&frame, 0, sizeof(frame));
+    nsecs_t time = 1_ms;
+    frame.set(FrameInfoIndex::IntendedVsync) = time;
+    frame.set(FrameInfoIndex::Vsync) = time;
+    frame.set(FrameInfoIndex::SyncQueued) = time;
+    frame.set(FrameInfoIndex::SyncStart) = time;
+    frame.set(FrameInfoIndex::IssueDrawCommandsStart) = (time += sync);
+    frame.set(FrameInfoIndex::SwapBuffers) = (time += issue);
+    frame.set(FrameInfoIndex::FrameCompleted) = (time += swap);
+    tracker->addFrame(frame);
+}
+
+TEST(JankTracker, stageBuckets) {
+    EXPECT_EQ(250u, JankTracker::stageTimeForStageCountIndex(0));
+    EXPECT_EQ(8000u, JankTracker::stageTimeForStageCountIndex(31));
+    EXPECT_EQ(9000u, JankTracker::stageTimeForStageCountIndex(32));
+}
+
+TEST(JankTracker, stagePercentiles) {
+    JankTracker tracker(createDisplayInfo());
+    for (int i = 0; i < 90; i++) {
+        addFrame(&tracker, 1_ms, 2_ms, 100_us);
+    }
+    for (int i = 0; i < 10; i++) {
+        addFrame(&tracker, 1_ms, 20_ms, 100_us);
+    }
+
+    EXPECT_EQ(1250u, tracker.findStagePercentile(kStageSync, 50));
+    EXPECT_EQ(1250u, tracker.findStagePercentile(kStageSync, 99));
+    EXPECT_EQ(2250u, tracker.findStagePercentile(kStageIssueDrawCommands, 50));
+    EXPECT_EQ(2250u, tracker.findStagePercentile(kStageIssueDrawCommands, 89));
+    EXPECT_EQ(21000u, tracker.findStagePercentile(kStageIssueDrawCommands, 95));
+    EXPECT_EQ(250u, tracker.findStagePercentile(kStageSwapBuffers, 99));
+
+    tracker.reset();
+    EXPECT_EQ(0u, tracker.findStagePercentile(kStageIssueDrawCommands, 50));
+}
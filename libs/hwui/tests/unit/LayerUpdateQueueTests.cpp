@@ -82,5 +82,41 @@ TEST(LayerUpdateQueue, clear) {
     EXPECT_TRUE(queue.entries().empty());
 }
 
+TEST(LayerUpdateQueue, deferUnion) {
+    sp<RenderNode> a = createSyncedNode(100, 100);
+
+    LayerUpdateQueue queue;
+    queue.deferLayerWithDamage(a.get(), Rect(10, 10, 20, 20));
+    queue.clear();
+    EXPECT_TRUE(queue.entries().empty());
+    ASSERT_TRUE(queue.hasDeferredLayers());
+
+    // The deferred damage is added to the next update of the same layer
+    queue.enqueueLayerWithDamage(a.get(), Rect(30, 30, 40, 40));
+    EXPECT_FALSE(queue.hasDeferredLayers());
+    ASSERT_EQ(1u, queue.entries().size());
+    EXPECT_EQ(Rect(10, 10, 40, 40), queue.entries()[0].damage);
+
+    // Even when that update is empty
+    queue.clear();
+    queue.deferLayerWithDamage(a.get(), Rect(10, 10, 20, 20));
+    queue.enqueueLayerWithDamage(a.get(), Rect());
+    ASSERT_EQ(1u, queue.entries().size());
+    EXPECT_EQ(Rect(10, 10, 20, 20), queue.entries()[0].damage);
+}
+
+TEST(LayerUpdateQueue, enqueueDeferredLayers_skipsDestroyedLayers) {
+    sp<RenderNode> a = createSyncedNode(100, 100);
+
+    LayerUpdateQueue queue;
+    queue.deferLayerWithDamage(a.get(), Rect(10, 10, 20, 20));
+    ASSERT_EQ(1u, queue.deferredEntries().size());
+
+    // a never had a layer to update
+    queue.enqueueDeferredLayers();
+    EXPECT_FALSE(queue.hasDeferredLayers());
+    EXPECT_TRUE(queue.entries().empty());
+}
+
 };
 };
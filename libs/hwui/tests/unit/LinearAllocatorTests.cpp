@@ -19,6 +19,8 @@
 
 #include <tests/common/TestUtils.h>
 
+#include <thread>
+
 using namespace android;
 using namespace android::uirenderer;
 
@@ -86,6 +88,25 @@ TEST(LinearAllocator, rewind) {
     EXPECT_EQ(1, destroyed);
 }
 
+TEST(LinearAllocator, recyclePages) {
+    // Pages are pooled per thread, so use a fresh thread to start with an empty pool
+    std::thread thread([]() {
+        void* firstAlloc;
+        {
+            LinearAllocator la;
+            firstAlloc = la.alloc<char>(64);
+            // Force a few more pages, of increasing size
+            for (int i = 0; i < 10; i++) {
+                la.alloc<char>(200);
+            }
+        }
+        // A new allocator on the same thread starts out in the page released by the last one
+        LinearAllocator la;
+        EXPECT_EQ(firstAlloc, la.alloc<char>(64));
+    });
+    thread.join();
+}
+
 TEST(LinearStdAllocator, simpleAllocate) {
     LinearAllocator la;
     LinearStdAllocator<void*> stdAllocator(la);
@@ -48,3 +48,44 @@ TEST(Matrix, mapRect_emptyRotate) {
     EXPECT_FALSE(lineRect.isEmpty())
         << "Empty 'line' rect doesn't remain empty when rotated.";
 }
+
+TEST(Matrix, loadMultiply) {
+    Matrix4 u;
+    u.loadRotate(30, 0, 0, 1);
+    u.translate(10, 20, 30);
+    Matrix4 v;
+    v.loadScale(2, 3, 4);
+    v.skew(0.5f, 0.25f);
+
+    Matrix4 product;
+    product.loadMultiply(u, v);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            float expected = 0;
+            for (int k = 0; k < 4; k++) {
+                expected += u.get(k, j) * v.get(i, k);
+            }
+            EXPECT_FLOAT_EQ(expected, product.get(i, j));
+        }
+    }
+}
+
+TEST(Matrix, loadInverse_scaleTranslate) {
+    Matrix4 scaleTranslate;
+    scaleTranslate.loadTranslate(10, 20, 0);
+    scaleTranslate.scale(4, 0.5f, 1);
+    ASSERT_TRUE(scaleTranslate.isSimple());
+
+    Matrix4 inverse;
+    inverse.loadInverse(scaleTranslate);
+    EXPECT_TRUE(inverse.isSimple());
+
+    Rect r(10, 20, 110, 220);
+    scaleTranslate.mapRect(r);
+    inverse.mapRect(r);
+    EXPECT_EQ(Rect(10, 20, 110, 220), r);
+
+    Matrix4 product;
+    product.loadMultiply(scaleTranslate, inverse);
+    EXPECT_TRUE(product.isIdentity());
+}
@@ -153,3 +153,49 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, clear) {
 
     EXPECT_EQ(0, GpuMemoryTracker::getInstanceCount(GpuObjectType::OffscreenBuffer));
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, getFromSizeClass) {
+    OffscreenBufferPool pool;
+
+    auto layer = pool.get(renderThread.renderState(), 128u, 128u);
+    pool.putOrDelete(layer);
+    EXPECT_EQ(0u, pool.getHitCount());
+    EXPECT_EQ(1u, pool.getMissCount());
+
+    // one step smaller still fits in the 128x128 texture
+    auto layer2 = pool.get(renderThread.renderState(), 60u, 100u);
+    EXPECT_EQ(layer, layer2) << "layer of the same size class should be recycled";
+    EXPECT_EQ(60u, layer2->viewportWidth);
+    EXPECT_EQ(100u, layer2->viewportHeight);
+    EXPECT_EQ(1u, pool.getHitCount());
+    pool.putOrDelete(layer2);
+
+    // two steps smaller would waste too much
+    auto layer3 = pool.get(renderThread.renderState(), 30u, 30u);
+    EXPECT_NE(layer, layer3);
+    EXPECT_EQ(64u, layer3->texture.width());
+    EXPECT_EQ(2u, pool.getMissCount());
+    EXPECT_EQ(1u, pool.getCount());
+
+    // resizing within the size class keeps the texture
+    ASSERT_EQ(layer3, pool.resize(layer3, 10u, 10u));
+
+    pool.putOrDelete(layer3);
+    pool.clear();
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, trimUnused) {
+    OffscreenBufferPool pool;
+
+    pool.putOrDelete(pool.get(renderThread.renderState(), 64u, 64u));
+    pool.putOrDelete(pool.get(renderThread.renderState(), 256u, 256u));
+    ASSERT_EQ(2u, pool.getCount());
+
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    pool.trimUnused(now);
+    EXPECT_EQ(2u, pool.getCount()) << "recently used layers should be kept";
+
+    pool.trimUnused(now + OffscreenBufferPool::kMaxUnusedTime + 1);
+    EXPECT_EQ(0u, pool.getCount()) << "layers unused for too long should be deleted";
+    EXPECT_EQ(0u, pool.getSize());
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "Patch.h"
+#include "PatchCache.h"
+#include "tests/common/TestUtils.h"
+
+#include <cstdlib>
+
+using namespace android;
+using namespace android::uirenderer;
+
+static Res_png_9patch* createPatch() {
+    Res_png_9patch header;
+    header.numXDivs = 2;
+    header.numYDivs = 2;
+    header.numColors = 9;
+    const int32_t divs[] = { 10, 20 };
+    uint32_t colors[9];
+    for (int i = 0; i < 9; i++) {
+        colors[i] = Res_png_9patch::NO_COLOR;
+    }
+    return static_cast<Res_png_9patch*>(Res_png_9patch::serialize(header, divs, divs, colors));
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(PatchCache, evictsLeastRecentlyUsed) {
+    PatchCache cache(renderThread.renderState());
+    Res_png_9patch* patch = createPatch();
+
+    const Patch* recent = cache.get(30, 30, 100, 100, patch);
+    ASSERT_TRUE(recent->vertices);
+    const uint32_t meshSize = recent->getSize();
+    ASSERT_LT(0u, meshSize);
+
+    // Stretch the patch to enough sizes to overflow the cache several times over,
+    // drawing the first mesh between each of them. It must never be dropped.
+    const uint32_t stretchCount = 3 * cache.getMaxSize() / meshSize;
+    for (uint32_t i = 0; i < stretchCount; i++) {
+        const Patch* stretched = cache.get(30, 30, 100 + i + 1, 100, patch);
+        ASSERT_TRUE(stretched->vertices);
+        EXPECT_LE(stretched->positionOffset + stretched->getSize(), cache.getMaxSize());
+        ASSERT_LE(cache.getSize(), cache.getMaxSize());
+
+        ASSERT_EQ(recent, cache.get(30, 30, 100, 100, patch));
+    }
+
+    cache.clear();
+    EXPECT_EQ(0u, cache.getSize());
+    free(patch);
+}
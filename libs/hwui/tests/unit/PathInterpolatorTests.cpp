@@ -106,5 +106,14 @@ TEST(Interpolator, pathInterpolation) {
     }
 }
 
+TEST(Interpolator, pathInterpolationOutOfOrder) {
+    for (const TestData& data: sTestDataSet) {
+        PathInterpolator interpolator(getX(data), getY(data));
+        for (size_t i = data.inFraction.size(); i-- > 0;) {
+            EXPECT_FLOAT_EQ(data.outFraction[i], interpolator.interpolate(data.inFraction[i]));
+        }
+    }
+}
+
 }
 }
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "hwui/PixelBufferPool.h"
+
+#include <string.h>
+
+using namespace android;
+
+static const size_t kBufferSize = PixelBufferPool::kMinPooledSize * 2;
+
+TEST(PixelBufferPool, reuseSameSize) {
+    PixelBufferPool pool(kBufferSize * 4);
+    void* buffer = pool.allocate(kBufferSize);
+    ASSERT_NE(nullptr, buffer);
+    memset(buffer, 0xFF, kBufferSize);
+    pool.release(buffer, kBufferSize);
+    EXPECT_EQ(1u, pool.getCount());
+    EXPECT_EQ(kBufferSize, pool.getSize());
+
+    // A different size doesn't take it
+    void* other = pool.allocate(kBufferSize + 4);
+    EXPECT_NE(buffer, other);
+    free(other);
+
+    uint8_t* reused = reinterpret_cast<uint8_t*>(pool.allocate(kBufferSize));
+    EXPECT_EQ(buffer, reused);
+    EXPECT_EQ(0u, pool.getCount());
+    for (size_t i = 0; i < kBufferSize; i++) {
+        ASSERT_EQ(0, reused[i]) << "reused buffer not cleared at " << i;
+    }
+    pool.release(reused, kBufferSize);
+}
+
+TEST(PixelBufferPool, smallBuffersNotPooled) {
+    PixelBufferPool pool(kBufferSize * 4);
+    pool.release(pool.allocate(PixelBufferPool::kMinPooledSize - 1),
+            PixelBufferPool::kMinPooledSize - 1);
+    // Too large for the budget
+    pool.release(pool.allocate(kBufferSize * 3), kBufferSize * 3);
+    EXPECT_EQ(0u, pool.getCount());
+}
+
+TEST(PixelBufferPool, evictLeastRecentlyReleased) {
+    PixelBufferPool pool(kBufferSize * 2);
+    void* first = pool.allocate(kBufferSize);
+    void* second = pool.allocate(kBufferSize);
+    void* third = pool.allocate(kBufferSize);
+    pool.release(first, kBufferSize);
+    pool.release(second, kBufferSize);
+    pool.release(third, kBufferSize);
+    EXPECT_EQ(2u, pool.getCount());
+    EXPECT_EQ(kBufferSize * 2, pool.getSize());
+
+    // Most recently released first
+    void* a = pool.allocate(kBufferSize);
+    void* b = pool.allocate(kBufferSize);
+    EXPECT_EQ(third, a);
+    EXPECT_EQ(second, b);
+    pool.release(a, kBufferSize);
+    pool.release(b, kBufferSize);
+
+    pool.clear();
+    EXPECT_EQ(0u, pool.getCount());
+    EXPECT_EQ(0u, pool.getSize());
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "Extensions.h"
+#include "ProgramCache.h"
+#include "tests/common/TestUtils.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace android;
+using namespace android::uirenderer;
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(ProgramCache, diskCacheRoundTrip) {
+    Extensions extensions;
+    if (!extensions.hasProgramBinary()) {
+        return;
+    }
+
+    const char* path = "/data/local/tmp/hwui_program_cache_test";
+    unlink(path);
+    ProgramCache::setDiskCachePath(path);
+
+    ProgramDescription description;
+    description.hasTexture = true;
+    {
+        ProgramCache cache(extensions);
+        cache.loadDiskCache();
+        Program* program = cache.get(description);
+        ASSERT_TRUE(program->isInitialized());
+        cache.saveDiskCache();
+    }
+
+    struct stat st;
+    ASSERT_EQ(0, stat(path, &st));
+    EXPECT_GT(st.st_size, 0);
+
+    {
+        // The program is linked from its binary before it is asked for
+        ProgramCache cache(extensions);
+        cache.loadDiskCache();
+        Program* program = cache.get(description);
+        ASSERT_TRUE(program->isInitialized());
+        EXPECT_EQ(Program::kBindingTexCoords, program->texCoords);
+    }
+
+    ProgramCache::setDiskCachePath("");
+    unlink(path);
+}
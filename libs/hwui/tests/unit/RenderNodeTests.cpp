@@ -335,3 +335,92 @@ RENDERTHREAD_TEST(RenderNode, prepareTree_HwLayer_AVD_enqueueDamage) {
     EXPECT_EQ(uirenderer::Rect(0, 0, 200, 400), info.layerUpdateQueue->entries().at(0).damage);
     canvasContext->destroy();
 }
+
+RENDERTHREAD_TEST(RenderNode, prepareTree_rtOnlySkipsStaticSubtrees) {
+    class CountingPositionListener : public RenderNode::PositionListener {
+    public:
+        explicit CountingPositionListener(int* updateCount) : mUpdateCount(updateCount) {}
+        void onPositionUpdated(RenderNode& node, const TreeInfo& info) override {
+            (*mUpdateCount)++;
+        }
+        void onPositionLost(RenderNode& node, const TreeInfo* info) override {}
+
+    private:
+        int* mUpdateCount;
+    };
+
+    auto child = TestUtils::createNode(0, 0, 100, 100,
+            [](RenderProperties& props, Canvas& canvas) {
+        canvas.drawColor(Color::Red_500, SkBlendMode::kSrcOver);
+    });
+    auto rootNode = TestUtils::createNode(0, 0, 200, 200,
+            [&child](RenderProperties& props, Canvas& canvas) {
+        canvas.drawRenderNode(child.get());
+    });
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(CanvasContext::create(
+            renderThread, false, rootNode.get(), &contextFactory));
+    auto prepareTree = [&](TreeInfo::TraversalMode mode) {
+        TreeInfo info(mode, *canvasContext.get());
+        DamageAccumulator damageAccumulator;
+        LayerUpdateQueue layerUpdateQueue;
+        info.damageAccumulator = &damageAccumulator;
+        info.layerUpdateQueue = &layerUpdateQueue;
+        rootNode->prepareTree(info);
+        SkRect dirty;
+        damageAccumulator.finish(&dirty);
+        return dirty;
+    };
+    prepareTree(TreeInfo::MODE_FULL);
+
+    // The listener is only picked up by the next traversal from the UI thread, since the
+    // subtree had nothing for RenderThread-only traversals to do
+    int updateCount = 0;
+    child->setPositionListener(new CountingPositionListener(&updateCount));
+    EXPECT_TRUE(prepareTree(TreeInfo::MODE_RT_ONLY).isEmpty());
+    EXPECT_EQ(0, updateCount);
+
+    prepareTree(TreeInfo::MODE_FULL);
+    EXPECT_EQ(1, updateCount);
+    EXPECT_TRUE(prepareTree(TreeInfo::MODE_RT_ONLY).isEmpty());
+    EXPECT_EQ(2, updateCount);
+
+    canvasContext->destroy();
+}
+
+RENDERTHREAD_TEST(RenderNode, prepareTree_HwLayer_offscreenDeferred) {
+    auto rootNode = TestUtils::createNode(0, 0, 200, 400,
+            [](RenderProperties& props, Canvas& canvas) {
+        canvas.drawColor(Color::Red_500, SkBlendMode::kSrcOver);
+    });
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(CanvasContext::create(
+            renderThread, false, rootNode.get(), &contextFactory));
+    TreeInfo info(TreeInfo::MODE_FULL, *canvasContext.get());
+    DamageAccumulator damageAccumulator;
+    LayerUpdateQueue layerUpdateQueue;
+    info.damageAccumulator = &damageAccumulator;
+    info.layerUpdateQueue = &layerUpdateQueue;
+    info.windowWidth = 500;
+    info.windowHeight = 500;
+
+    // Put node on HW layer, entirely to the right of the window
+    rootNode->mutateStagingProperties().mutateLayerProperties().setType(LayerType::RenderLayer);
+    rootNode->mutateStagingProperties().setTranslationX(600);
+    rootNode->setPropertyFieldsDirty(RenderNode::GENERIC | RenderNode::TRANSLATION_X);
+    rootNode->prepareTree(info);
+
+    EXPECT_TRUE(layerUpdateQueue.entries().empty());
+    ASSERT_EQ(1u, layerUpdateQueue.deferredEntries().size());
+    EXPECT_EQ(uirenderer::Rect(0, 0, 200, 400), layerUpdateQueue.deferredEntries()[0].damage);
+
+    // Once it scrolls into view, the deferred damage is updated with the frame
+    rootNode->mutateStagingProperties().setTranslationX(100);
+    rootNode->setPropertyFieldsDirty(RenderNode::TRANSLATION_X);
+    rootNode->prepareTree(info);
+
+    EXPECT_FALSE(layerUpdateQueue.hasDeferredLayers());
+    ASSERT_EQ(1u, layerUpdateQueue.entries().size());
+    EXPECT_EQ(uirenderer::Rect(0, 0, 200, 400), layerUpdateQueue.entries()[0].damage);
+    canvasContext->destroy();
+}
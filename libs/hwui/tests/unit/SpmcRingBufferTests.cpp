@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <utils/SpmcRingBuffer.h>
+
+#include <array>
+#include <thread>
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(SpmcRingBuffer, readInOrder) {
+    SpmcRingBuffer<int, 4> ring;
+    SpmcRingBuffer<int, 4>::Reader reader(ring);
+    int value = -1;
+    int dropCount = 0;
+    EXPECT_FALSE(reader.next(ring, &value, &dropCount));
+
+    ring.push(1);
+    ring.push(2);
+    ASSERT_TRUE(reader.next(ring, &value, &dropCount));
+    EXPECT_EQ(1, value);
+    ASSERT_TRUE(reader.next(ring, &value, &dropCount));
+    EXPECT_EQ(2, value);
+    EXPECT_FALSE(reader.next(ring, &value, &dropCount));
+    EXPECT_EQ(0, dropCount);
+}
+
+TEST(SpmcRingBuffer, readersAreIndependent) {
+    SpmcRingBuffer<int, 4> ring;
+    ring.push(1);
+    SpmcRingBuffer<int, 4>::Reader late(ring);
+    SpmcRingBuffer<int, 4>::Reader early(ring, 0);
+    ring.push(2);
+
+    int value = -1;
+    int dropCount = 0;
+    ASSERT_TRUE(late.next(ring, &value, &dropCount));
+    EXPECT_EQ(2, value);
+    ASSERT_TRUE(early.next(ring, &value, &dropCount));
+    EXPECT_EQ(1, value);
+    ASSERT_TRUE(early.next(ring, &value, &dropCount));
+    EXPECT_EQ(2, value);
+    EXPECT_EQ(0, dropCount);
+}
+
+TEST(SpmcRingBuffer, overrunCountsDrops) {
+    SpmcRingBuffer<int, 4> ring;
+    SpmcRingBuffer<int, 4>::Reader reader(ring);
+    for (int i = 0; i < 10; i++) {
+        ring.push(i);
+    }
+
+    int value = -1;
+    int dropCount = 0;
+    ASSERT_TRUE(reader.next(ring, &value, &dropCount));
+    // Only the last 4 values are still in the ring
+    EXPECT_EQ(6, value);
+    EXPECT_EQ(6, dropCount);
+}
+
+TEST(SpmcRingBuffer, concurrentReaders) {
+    typedef std::array<int, 16> Element;
+    SpmcRingBuffer<Element, 8> ring;
+    static const int elementCount = 20000;
+
+    auto read = [&ring]() {
+        SpmcRingBuffer<Element, 8>::Reader reader(ring, 0);
+        Element element;
+        int dropCount = 0;
+        int readCount = 0;
+        int lastValue = -1;
+        while (readCount + dropCount < elementCount) {
+            if (!reader.next(ring, &element, &dropCount)) {
+                std::this_thread::yield();
+                continue;
+            }
+            readCount++;
+            // Every element must have been copied out whole, and in order
+            for (int value : element) {
+                ASSERT_EQ(element[0], value);
+            }
+            ASSERT_LT(lastValue, element[0]);
+            lastValue = element[0];
+        }
+        EXPECT_EQ(elementCount, readCount + dropCount);
+    };
+    std::thread first(read);
+    std::thread second(read);
+
+    for (int i = 0; i < elementCount; i++) {
+        Element element;
+        element.fill(i);
+        ring.push(element);
+    }
+    first.join();
+    second.join();
+}
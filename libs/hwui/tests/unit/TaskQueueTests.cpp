@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "renderthread/RenderThread.h"
+#include "utils/TimeUtils.h"
+
+using namespace android;
+using namespace android::uirenderer;
+using namespace android::uirenderer::renderthread;
+
+namespace {
+class TestTask : public RenderTask {
+public:
+    explicit TestTask(TaskPriority priority, nsecs_t runAt = 0) {
+        mPriority = priority;
+        mRunAt = runAt;
+    }
+    virtual void run() override {}
+};
+} // namespace
+
+TEST(TaskQueue, maintenanceRunsLast) {
+    TaskQueue queue;
+    TestTask trim(TaskPriority::Maintenance);
+    TestTask normal(TaskPriority::Normal);
+    TestTask frame(TaskPriority::Frame);
+    queue.queue(&trim);
+    queue.queue(&normal);
+    queue.queue(&frame);
+
+    // The other tasks keep their FIFO order
+    EXPECT_EQ(&normal, queue.next());
+    EXPECT_EQ(&frame, queue.next());
+    EXPECT_EQ(&trim, queue.next());
+    EXPECT_EQ(nullptr, queue.next());
+    EXPECT_EQ(LLONG_MAX, queue.nextWakeup());
+}
+
+TEST(TaskQueue, maintenanceHeldBackByUpcomingFrame) {
+    TaskQueue queue;
+    TestTask trim(TaskPriority::Maintenance);
+    nsecs_t frameTime = systemTime(SYSTEM_TIME_MONOTONIC) + 1_s;
+    TestTask frame(TaskPriority::Frame, frameTime);
+    queue.queue(&trim);
+    queue.queue(&frame);
+
+    // Plenty of time left before the frame
+    EXPECT_EQ(&trim, queue.next());
+    EXPECT_EQ(nullptr, queue.next());
+    EXPECT_EQ(frameTime, queue.nextWakeup());
+    queue.remove(&frame);
+
+    frameTime = systemTime(SYSTEM_TIME_MONOTONIC) + 1_ms;
+    frame.mRunAt = frameTime;
+    queue.queue(&trim);
+    queue.queue(&frame);
+    EXPECT_EQ(nullptr, queue.next());
+    // Not before the frame task runs
+    EXPECT_EQ(frameTime, queue.nextWakeup());
+
+    queue.remove(&frame);
+    EXPECT_EQ(&trim, queue.next());
+}
+
+TEST(TaskQueue, remove) {
+    TaskQueue queue;
+    TestTask first(TaskPriority::Maintenance);
+    TestTask second(TaskPriority::Maintenance);
+    TestTask normal(TaskPriority::Normal);
+    queue.queue(&first);
+    queue.queue(&second);
+    queue.queue(&normal);
+
+    queue.remove(&second);
+    queue.remove(&normal);
+    EXPECT_EQ(&first, queue.next());
+    EXPECT_EQ(nullptr, queue.next());
+
+    // Removed tasks can be queued again
+    queue.queue(&second);
+    EXPECT_EQ(&second, queue.next());
+}
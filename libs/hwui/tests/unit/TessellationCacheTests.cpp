@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "TessellationCache.h"
+#include "tests/common/TestUtils.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+static sp<TessellationCache::ShadowTask> getRectShadowTask(TessellationCache& cache,
+        const SkPath& caster, float translateX, float translateY, const Vector3& lightCenter,
+        Vector2* outTranslation) {
+    Matrix4 transformXY;
+    transformXY.loadTranslate(translateX, translateY, 0);
+    Matrix4 transformZ;
+    transformZ.loadTranslate(translateX, translateY, 10);
+    return cache.getShadowTask(&Matrix4::identity(), true, &caster,
+            &transformXY, &transformZ, lightCenter, 30, outTranslation);
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(TessellationCache, shadowReusedWhenTranslated) {
+    TessellationCache cache;
+    SkPath caster;
+    caster.addRect(0, 0, 50, 50);
+    const Vector3 lightCenter = {100, 100, 800};
+
+    Vector2 translation;
+    sp<TessellationCache::ShadowTask> task = getRectShadowTask(cache, caster, 10, 20,
+            lightCenter, &translation);
+    EXPECT_EQ(10, translation.x);
+    EXPECT_EQ(20, translation.y);
+    EXPECT_MATRIX_APPROX_EQ(Matrix4::identity(), task->transformXY);
+
+    // a small move reuses the same tessellation, drawn at the new offset
+    EXPECT_EQ(task, getRectShadowTask(cache, caster, 12, 18, lightCenter, &translation));
+    EXPECT_EQ(12, translation.x);
+    EXPECT_EQ(18, translation.y);
+
+    // a large move shifts the spot shadow relative to the caster, so it's re-tessellated
+    sp<TessellationCache::ShadowTask> movedTask = getRectShadowTask(cache, caster, 10, 520,
+            lightCenter, &translation);
+    EXPECT_NE(task, movedTask);
+    EXPECT_EQ(movedTask, getRectShadowTask(cache, caster, 10, 520, lightCenter, &translation));
+
+    // tessellation still completes for reused tasks
+    EXPECT_GT(movedTask->getResult().first->getVertexCount(), 0u);
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(TessellationCache, shadowKeptAcrossTrim) {
+    TessellationCache cache;
+    SkPath caster;
+    caster.addRect(0, 0, 50, 50);
+    const Vector3 lightCenter = {100, 100, 800};
+
+    Vector2 translation;
+    sp<TessellationCache::ShadowTask> task = getRectShadowTask(cache, caster, 0, 0,
+            lightCenter, &translation);
+    cache.trim();
+    EXPECT_EQ(task, getRectShadowTask(cache, caster, 0, 0, lightCenter, &translation));
+
+    cache.clear();
+    EXPECT_NE(task, getRectShadowTask(cache, caster, 0, 0, lightCenter, &translation));
+}
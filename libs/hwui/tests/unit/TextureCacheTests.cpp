@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 
 #include "Extensions.h"
+#include "Texture.h"
 #include "TextureCache.h"
 #include "tests/common/TestUtils.h"
 
@@ -37,3 +38,32 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(TextureCache, clear) {
     cache.clear();
     ASSERT_EQ(GpuMemoryTracker::getInstanceCount(GpuObjectType::Texture), initialCount);
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(TextureCache, prefetchAsync) {
+    TextureCache cache;
+    int initialCount = GpuMemoryTracker::getInstanceCount(GpuObjectType::Texture);
+
+    // Too small to be worth the round trip to the upload thread
+    sk_sp<Bitmap> smallBitmap(TestUtils::createBitmap(10, 10));
+    EXPECT_FALSE(cache.prefetchAsync(smallBitmap.get(), renderThread.eglManager()));
+
+    sk_sp<Bitmap> bitmap(TestUtils::createBitmap(256, 256));
+    ASSERT_TRUE(cache.prefetchAsync(bitmap.get(), renderThread.eglManager()));
+    // The texture is only cached once it is first used
+    EXPECT_EQ(0u, cache.getSize());
+
+    Texture* texture = cache.get(bitmap.get());
+    ASSERT_NE(nullptr, texture);
+    EXPECT_NE(0u, texture->id());
+    EXPECT_EQ(256u, texture->width());
+    EXPECT_EQ(bitmap->getGenerationID(), texture->generation);
+    EXPECT_EQ(bitmap->rowBytes() * bitmap->height(), cache.getSize());
+    EXPECT_EQ(initialCount + 1, GpuMemoryTracker::getInstanceCount(GpuObjectType::Texture));
+
+    // Already cached
+    EXPECT_FALSE(cache.prefetchAsync(bitmap.get(), renderThread.eglManager()));
+
+    cache.clear();
+    cache.destroyTextureUploader();
+    EXPECT_EQ(initialCount, GpuMemoryTracker::getInstanceCount(GpuObjectType::Texture));
+}
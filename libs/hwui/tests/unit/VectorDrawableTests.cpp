@@ -298,6 +298,52 @@ TEST(PathParser, parseAsciiStringForSkPath) {
     }
 }
 
+TEST(PathParser, cachedPathData) {
+    PathParser::clearPathDataCache();
+    for (int i = 0; i < 2; i++) {
+        for (TestData testData: sTestDataSet) {
+            PathParser::ParseResult result;
+            PathData reusedData;
+            reusedData.verbs.push_back('z');
+            PathParser::getCachedPathDataFromAsciiString(&reusedData, &result,
+                    testData.pathString, strlen(testData.pathString));
+            EXPECT_FALSE(result.failureOccurred);
+            EXPECT_EQ(testData.pathData, reusedData);
+        }
+    }
+
+    for (StringPath stringPath : sStringPaths) {
+        for (int i = 0; i < 2; i++) {
+            PathParser::ParseResult result;
+            PathData data;
+            PathParser::getCachedPathDataFromAsciiString(&data, &result, stringPath.stringPath,
+                    strlen(stringPath.stringPath));
+            EXPECT_EQ(stringPath.isValid, !result.failureOccurred);
+        }
+    }
+    PathParser::clearPathDataCache();
+}
+
+TEST(PathParser, binaryPathData) {
+    for (TestData testData: sTestDataSet) {
+        std::vector<uint8_t> buffer;
+        PathParser::serializePathData(testData.pathData, &buffer);
+        EXPECT_EQ(0u, buffer.size() % 4);
+
+        PathParser::ParseResult result;
+        PathData data;
+        PathParser::getPathDataFromBinary(&data, &result, buffer.data(), buffer.size());
+        EXPECT_FALSE(result.failureOccurred);
+        EXPECT_EQ(testData.pathData, data);
+
+        // Truncated data must be rejected
+        PathParser::ParseResult truncatedResult;
+        PathParser::getPathDataFromBinary(&data, &truncatedResult, buffer.data(),
+                buffer.size() - 4);
+        EXPECT_TRUE(truncatedResult.failureOccurred);
+    }
+}
+
 TEST(VectorDrawableUtils, morphPathData) {
     for (TestData fromData: sTestDataSet) {
         for (TestData toData: sTestDataSet) {
@@ -347,6 +393,27 @@ TEST(VectorDrawableUtils, interpolatePathData) {
     }
 }
 
+TEST(VectorDrawableUtils, interpolatePathData_reuseOutput) {
+    // Interpolating into data left over from a different path must replace all of it
+    const PathData& fromPathData = sTestDataSet[0].pathData;
+    PathData toPathData = fromPathData;
+    for (float& point : toPathData.points) {
+        point += 2;
+    }
+    PathData outData = sTestDataSet[1].pathData;
+    for (float fraction : {0.25f, 0.5f}) {
+        ASSERT_TRUE(VectorDrawableUtils::interpolatePathData(
+                &outData, fromPathData, toPathData, fraction));
+        EXPECT_EQ(fromPathData.verbs, outData.verbs);
+        EXPECT_EQ(fromPathData.verbSizes, outData.verbSizes);
+        ASSERT_EQ(fromPathData.points.size(), outData.points.size());
+        for (size_t i = 0; i < outData.points.size(); i++) {
+            EXPECT_TRUE(MathUtils::areEqual(fromPathData.points[i] + 2 * fraction,
+                    outData.points[i]));
+        }
+    }
+}
+
 TEST(VectorDrawable, groupProperties) {
     //TODO: Also need to test property sync and dirty flag when properties change.
     VectorDrawable::Group group;
@@ -425,5 +492,25 @@ TEST(VectorDrawable, drawPathWithoutIncrementingShaderRefCount) {
     EXPECT_TRUE(shaderIsDestroyed);
 }
 
+TEST(VectorDrawable, pendingCacheUpdate) {
+    sp<VectorDrawable::Tree> tree(new VectorDrawable::Tree(new VectorDrawable::Group()));
+    tree->mutateProperties()->setViewportSize(10, 10);
+    tree->mutateProperties()->setScaledSize(20, 20);
+
+    sp<Task<bool> > task(new Task<bool>());
+    ASSERT_TRUE(tree->setPendingCacheUpdate(task));
+    // Done by a worker thread during the frame
+    tree->updateCache();
+    task->setResult(true);
+    EXPECT_FALSE(tree->isDirty());
+
+    Bitmap& bitmap = tree->getBitmapUpdateIfDirty();
+    EXPECT_EQ(20, bitmap.width());
+    EXPECT_EQ(20, bitmap.height());
+
+    // The cache is up to date
+    EXPECT_FALSE(tree->setPendingCacheUpdate(new Task<bool>()));
+}
+
 }; // namespace uirenderer
 }; // namespace android
@@ -25,10 +25,32 @@
 namespace android {
 namespace uirenderer {
 
+/**
+ * Tasks of a higher priority are run before tasks of a lower priority,
+ * no matter which worker thread they were given to.
+ */
+enum class TaskPriority {
+    // Work that the current frame is waiting for
+    High,
+    // Everything else, such as precaching work for upcoming frames
+    Normal,
+};
+
 class TaskBase: public RefBase {
 public:
     TaskBase() { }
     virtual ~TaskBase() { }
+
+    TaskPriority getPriority() const {
+        return mPriority;
+    }
+
+    void setPriority(TaskPriority priority) {
+        mPriority = priority;
+    }
+
+private:
+    TaskPriority mPriority = TaskPriority::Normal;
 };
 
 template<typename T>
@@ -39,13 +39,16 @@ TaskManager::TaskManager() {
     for (int i = 0; i < workerCount; i++) {
         String8 name;
         name.appendFormat("hwuiTask%d", i + 1);
-        mThreads.push_back(new WorkerThread(name));
+        mThreads.push_back(new WorkerThread(this, name));
     }
 }
 
 TaskManager::~TaskManager() {
+    stop();
+    // The workers share mWorkLock and mWorkCondition, wait until none of them
+    // can touch this manager anymore
     for (size_t i = 0; i < mThreads.size(); i++) {
-        mThreads[i]->exit();
+        mThreads[i]->join();
     }
 }
 
@@ -73,7 +76,15 @@ bool TaskManager::addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBa
             }
         }
 
-        return thread->addTask(wrapper);
+        // Queue the task and count it atomically, so that a worker stealing
+        // it right away never sees the count go below zero
+        Mutex::Autolock l(mWorkLock);
+        if (!thread->addTask(wrapper)) {
+            return false;
+        }
+        mPendingTaskCount++;
+        mWorkCondition.signal();
+        return true;
     }
     return false;
 }
@@ -88,21 +99,66 @@ status_t TaskManager::WorkerThread::readyToRun() {
 }
 
 bool TaskManager::WorkerThread::threadLoop() {
-    mSignal.wait();
-    std::vector<TaskWrapper> tasks;
     {
-        Mutex::Autolock l(mLock);
-        tasks.swap(mTasks);
+        Mutex::Autolock l(mManager->mWorkLock);
+        while (mManager->mPendingTaskCount == 0) {
+            if (exitPending()) {
+                return false;
+            }
+            mManager->mWorkCondition.wait(mManager->mWorkLock);
+        }
     }
 
-    for (size_t i = 0; i < tasks.size(); i++) {
-        const TaskWrapper& task = tasks[i];
+    // Keep going until every queue is empty, this also drains the queues
+    // when the thread was asked to exit
+    TaskWrapper task;
+    while (findTask(&task)) {
         task.mProcessor->process(task.mTask);
+        task = TaskWrapper();
     }
 
     return true;
 }
 
+bool TaskManager::WorkerThread::findTask(TaskWrapper* outTask) {
+    bool found = false;
+    const TaskPriority priorities[] = { TaskPriority::High, TaskPriority::Normal };
+    for (TaskPriority priority : priorities) {
+        found = takeTask(priority, false, outTask);
+        for (size_t i = 0; i < mManager->mThreads.size() && !found; i++) {
+            WorkerThread* victim = mManager->mThreads[i].get();
+            found = victim != this && victim->takeTask(priority, true, outTask);
+        }
+        if (found) {
+            break;
+        }
+    }
+
+    if (found) {
+        Mutex::Autolock l(mManager->mWorkLock);
+        mManager->mPendingTaskCount--;
+    }
+    return found;
+}
+
+bool TaskManager::WorkerThread::takeTask(TaskPriority priority, bool steal,
+        TaskWrapper* outTask) {
+    Mutex::Autolock l(mLock);
+    std::deque<TaskWrapper>& tasks = mTasks[static_cast<size_t>(priority)];
+    if (tasks.empty()) {
+        return false;
+    }
+
+    if (steal) {
+        *outTask = tasks.back();
+        tasks.pop_back();
+    } else {
+        *outTask = tasks.front();
+        tasks.pop_front();
+    }
+    return true;
+}
+
 bool TaskManager::WorkerThread::addTask(const TaskWrapper& task) {
     if (!isRunning()) {
         run(mName.string(), PRIORITY_DEFAULT);
@@ -110,23 +166,26 @@ bool TaskManager::WorkerThread::addTask(const TaskWrapper& task) {
         return false;
     }
 
-    {
-        Mutex::Autolock l(mLock);
-        mTasks.push_back(task);
-    }
-    mSignal.signal();
+    Mutex::Autolock l(mLock);
+    mTasks[static_cast<size_t>(task.mTask->getPriority())].push_back(task);
 
     return true;
 }
 
 size_t TaskManager::WorkerThread::getTaskCount() const {
     Mutex::Autolock l(mLock);
-    return mTasks.size();
+    size_t count = 0;
+    for (const std::deque<TaskWrapper>& tasks : mTasks) {
+        count += tasks.size();
+    }
+    return count;
 }
 
 void TaskManager::WorkerThread::exit() {
     requestExit();
-    mSignal.signal();
+    // Take the lock so that a worker about to wait cannot miss the wake up
+    Mutex::Autolock l(mManager->mWorkLock);
+    mManager->mWorkCondition.broadcast();
 }
 
 }; // namespace uirenderer
@@ -21,8 +21,9 @@
 #include <utils/String8.h>
 #include <utils/Thread.h>
 
-#include "Signal.h"
+#include "Task.h"
 
+#include <deque>
 #include <vector>
 
 namespace android {
@@ -76,29 +77,50 @@ private:
         sp<TaskProcessorBase> mProcessor;
     };
 
+    static constexpr size_t kPriorityCount = 2;
+
+    /**
+     * Each worker runs the tasks of its own queues first, oldest first. Once
+     * those are empty, it steals the most recently added tasks from the other
+     * workers, so that a long task does not hold up the tasks queued behind it.
+     * Within each queue, tasks of a higher priority always go first.
+     */
     class WorkerThread: public Thread {
     public:
-        explicit WorkerThread(const String8& name): mSignal(Condition::WAKE_UP_ONE), mName(name) { }
+        WorkerThread(TaskManager* manager, const String8& name)
+                : mManager(manager), mName(name) { }
 
         bool addTask(const TaskWrapper& task);
         size_t getTaskCount() const;
         void exit();
 
+        /**
+         * Removes a task of the given priority from this worker's queue. The owner
+         * takes the oldest task, other workers take the newest.
+         */
+        bool takeTask(TaskPriority priority, bool steal, TaskWrapper* outTask);
+
     private:
         virtual status_t readyToRun() override;
         virtual bool threadLoop() override;
 
-        // Lock for the list of tasks
-        mutable Mutex mLock;
-        std::vector<TaskWrapper> mTasks;
+        bool findTask(TaskWrapper* outTask);
+
+        TaskManager* const mManager;
 
-        // Signal used to wake up the thread when a new
-        // task is available in the list
-        mutable Signal mSignal;
+        // Lock for the queues of tasks
+        mutable Mutex mLock;
+        std::deque<TaskWrapper> mTasks[kPriorityCount];
 
         const String8 mName;
     };
 
+    // Wakes up idle workers when a task is added to any of the queues
+    Mutex mWorkLock;
+    Condition mWorkCondition;
+    // Number of tasks in all queues, guarded by mWorkLock
+    size_t mPendingTaskCount = 0;
+
     std::vector<sp<WorkerThread> > mThreads;
 };
 
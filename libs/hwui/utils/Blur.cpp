@@ -19,6 +19,17 @@
 #include "Blur.h"
 #include "MathUtils.h"
 
+#include <algorithm>
+#include <memory>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BLUR_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BLUR_USE_SSE2
+#endif
+
 namespace android {
 namespace uirenderer {
 
@@ -91,93 +102,184 @@ void Blur::generateGaussianWeights(float* weights, float radius) {
     }
 }
 
+// Adds source * weight to accum for count pixels. Both blur passes are built on
+// this so the weighted sums run over contiguous memory and can be vectorized.
+static void accumulateRow(float* accum, const uint8_t* source, float weight, int32_t count) {
+    int32_t x = 0;
+#if defined(BLUR_USE_NEON)
+    for (; x + 8 <= count; x += 8) {
+        uint16x8_t pixels = vmovl_u8(vld1_u8(source + x));
+        float32x4_t low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(pixels)));
+        float32x4_t high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(pixels)));
+        vst1q_f32(accum + x, vmlaq_n_f32(vld1q_f32(accum + x), low, weight));
+        vst1q_f32(accum + x + 4, vmlaq_n_f32(vld1q_f32(accum + x + 4), high, weight));
+    }
+#elif defined(BLUR_USE_SSE2)
+    const __m128 weights = _mm_set1_ps(weight);
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 8 <= count; x += 8) {
+        __m128i pixels = _mm_unpacklo_epi8(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + x)), zero);
+        __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(pixels, zero));
+        __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(pixels, zero));
+        _mm_storeu_ps(accum + x,
+                _mm_add_ps(_mm_loadu_ps(accum + x), _mm_mul_ps(low, weights)));
+        _mm_storeu_ps(accum + x + 4,
+                _mm_add_ps(_mm_loadu_ps(accum + x + 4), _mm_mul_ps(high, weights)));
+    }
+#endif
+    for (; x < count; x++) {
+        accum[x] += source[x] * weight;
+    }
+}
+
+// Truncates the accumulated pixels like the cast the scalar passes used to do
+static void storeRow(const float* accum, uint8_t* dest, int32_t count) {
+    int32_t x = 0;
+#if defined(BLUR_USE_NEON)
+    for (; x + 8 <= count; x += 8) {
+        uint16x4_t low = vqmovn_u32(vcvtq_u32_f32(vld1q_f32(accum + x)));
+        uint16x4_t high = vqmovn_u32(vcvtq_u32_f32(vld1q_f32(accum + x + 4)));
+        vst1_u8(dest + x, vqmovn_u16(vcombine_u16(low, high)));
+    }
+#elif defined(BLUR_USE_SSE2)
+    for (; x + 8 <= count; x += 8) {
+        __m128i low = _mm_cvttps_epi32(_mm_loadu_ps(accum + x));
+        __m128i high = _mm_cvttps_epi32(_mm_loadu_ps(accum + x + 4));
+        __m128i pixels = _mm_packus_epi16(_mm_packs_epi32(low, high), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + x), pixels);
+    }
+#endif
+    for (; x < count; x++) {
+        dest[x] = (uint8_t) accum[x];
+    }
+}
+
+static inline int32_t clamp(int32_t value, int32_t max) {
+    return value < 0 ? 0 : (value > max ? max : value);
+}
+
 void Blur::horizontal(float* weights, int32_t radius,
         const uint8_t* source, uint8_t* dest, int32_t width, int32_t height) {
-    float blurredPixel = 0.0f;
-    float currentPixel = 0.0f;
+    // Pixels in [interiorStart, interiorEnd) don't need their neighbors clamped
+    const int32_t interiorStart = std::min(radius, width);
+    const int32_t interiorEnd = std::max(interiorStart, width - radius);
+    const int32_t interiorCount = interiorEnd - interiorStart;
+    std::unique_ptr<float[]> accum(new float[width]);
 
     for (int32_t y = 0; y < height; y ++) {
-
         const uint8_t* input = source + y * width;
         uint8_t* output = dest + y * width;
 
+        std::fill(accum.get(), accum.get() + interiorCount, 0.0f);
+        for (int32_t r = -radius; r <= radius; r ++) {
+            accumulateRow(accum.get(), input + interiorStart + r, weights[r + radius],
+                    interiorCount);
+        }
+        storeRow(accum.get(), output + interiorStart, interiorCount);
+
+        // Stepping left and right away from the pixel, clamped to the row
         for (int32_t x = 0; x < width; x ++) {
-            blurredPixel = 0.0f;
-            const float* gPtr = weights;
-            // Optimization for non-border pixels
-            if (x > radius && x < (width - radius)) {
-                const uint8_t *i = input + (x - radius);
-                for (int r = -radius; r <= radius; r ++) {
-                    currentPixel = (float) (*i);
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                    i++;
-                }
-            } else {
-                for (int32_t r = -radius; r <= radius; r ++) {
-                    // Stepping left and right away from the pixel
-                    int validW = x + r;
-                    if (validW < 0) {
-                        validW = 0;
-                    }
-                    if (validW > width - 1) {
-                        validW = width - 1;
-                    }
-
-                    currentPixel = (float) input[validW];
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                }
+            if (x == interiorStart) {
+                x = interiorEnd;
+                if (x >= width) break;
+            }
+            float blurredPixel = 0.0f;
+            for (int32_t r = -radius; r <= radius; r ++) {
+                blurredPixel += (float) input[clamp(x + r, width - 1)] * weights[r + radius];
             }
-            *output = (uint8_t)blurredPixel;
-            output ++;
+            output[x] = (uint8_t) blurredPixel;
         }
     }
 }
 
 void Blur::vertical(float* weights, int32_t radius,
         const uint8_t* source, uint8_t* dest, int32_t width, int32_t height) {
-    float blurredPixel = 0.0f;
-    float currentPixel = 0.0f;
+    // Accumulate whole rows rather than walking down each column
+    std::unique_ptr<float[]> accum(new float[width]);
 
     for (int32_t y = 0; y < height; y ++) {
+        std::fill(accum.get(), accum.get() + width, 0.0f);
+        for (int32_t r = -radius; r <= radius; r ++) {
+            // Clamp to zero and height
+            const uint8_t* input = source + clamp(y + r, height - 1) * width;
+            accumulateRow(accum.get(), input, weights[r + radius], width);
+        }
+        storeRow(accum.get(), dest + y * width, width);
+    }
+}
+
+// Splits a gaussian into three box blurs of (odd) sizes whose variances add up to
+// sigma^2, see "Fast Almost-Gaussian Filtering" (Kovesi)
+static void computeBoxRadii(float sigma, int32_t* radii, int32_t passes) {
+    const float variance = 12.0f * sigma * sigma;
+    int32_t lower = (int32_t) floorf(sqrtf(variance / passes + 1.0f));
+    if (lower % 2 == 0) lower--;
+    const int32_t upper = lower + 2;
+    const int32_t lowerCount = (int32_t) roundf(
+            (variance - passes * lower * lower - 4 * passes * lower - 3 * passes)
+            / (-4.0f * lower - 4.0f));
+    for (int32_t i = 0; i < passes; i++) {
+        radii[i] = ((i < lowerCount ? lower : upper) - 1) / 2;
+    }
+}
+
+static void boxHorizontal(int32_t radius, const uint8_t* source, uint8_t* dest,
+        int32_t width, int32_t height) {
+    const uint32_t size = 2 * radius + 1;
+    for (int32_t y = 0; y < height; y++) {
+        const uint8_t* input = source + y * width;
         uint8_t* output = dest + y * width;
 
-        for (int32_t x = 0; x < width; x ++) {
-            blurredPixel = 0.0f;
-            const float* gPtr = weights;
-            const uint8_t* input = source + x;
-            // Optimization for non-border pixels
-            if (y > radius && y < (height - radius)) {
-                const uint8_t *i = input + ((y - radius) * width);
-                for (int32_t r = -radius; r <= radius; r ++) {
-                    currentPixel = (float) (*i);
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                    i += width;
-                }
-            } else {
-                for (int32_t r = -radius; r <= radius; r ++) {
-                    int validH = y + r;
-                    // Clamp to zero and width
-                    if (validH < 0) {
-                        validH = 0;
-                    }
-                    if (validH > height - 1) {
-                        validH = height - 1;
-                    }
-
-                    const uint8_t *i = input + validH * width;
-                    currentPixel = (float) (*i);
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                }
-            }
-            *output = (uint8_t) blurredPixel;
-            output++;
+        // Running sum of the window, clamped to the row
+        uint32_t sum = (radius + 1) * input[0];
+        for (int32_t i = 1; i <= radius; i++) {
+            sum += input[clamp(i, width - 1)];
+        }
+        for (int32_t x = 0; x < width; x++) {
+            output[x] = (sum + size / 2) / size;
+            sum += input[clamp(x + radius + 1, width - 1)];
+            sum -= input[clamp(x - radius, width - 1)];
         }
     }
 }
 
+static void boxVertical(int32_t radius, const uint8_t* source, uint8_t* dest,
+        int32_t width, int32_t height) {
+    const uint32_t size = 2 * radius + 1;
+    std::unique_ptr<uint32_t[]> sums(new uint32_t[width]);
+    for (int32_t x = 0; x < width; x++) {
+        sums[x] = (radius + 1) * source[x];
+    }
+    for (int32_t i = 1; i <= radius; i++) {
+        const uint8_t* input = source + clamp(i, height - 1) * width;
+        for (int32_t x = 0; x < width; x++) {
+            sums[x] += input[x];
+        }
+    }
+
+    for (int32_t y = 0; y < height; y++) {
+        uint8_t* output = dest + y * width;
+        const uint8_t* added = source + clamp(y + radius + 1, height - 1) * width;
+        const uint8_t* removed = source + clamp(y - radius, height - 1) * width;
+        for (int32_t x = 0; x < width; x++) {
+            output[x] = (sums[x] + size / 2) / size;
+            sums[x] += added[x] - removed[x];
+        }
+    }
+}
+
+void Blur::approximateGaussian(float radius, uint8_t* image, uint8_t* scratch,
+        int32_t width, int32_t height) {
+    const int32_t passes = 3;
+    int32_t radii[passes];
+    computeBoxRadii(legacyConvertRadiusToSigma(radius), radii, passes);
+
+    for (int32_t i = 0; i < passes; i++) {
+        boxHorizontal(radii[i], image, scratch, width, height);
+        boxVertical(radii[i], scratch, image, width, height);
+    }
+}
+
 }; // namespace uirenderer
 }; // namespace android
@@ -25,6 +25,10 @@ namespace uirenderer {
 
 class Blur {
 public:
+    // Above this radius approximateGaussian() is used instead of the gaussian
+    // passes, the curve is flat enough by then that three box blurs look the same
+    static const int32_t kBoxApproximationRadius = 25;
+
     // If radius > 0, return the corresponding sigma, else return 0
     ANDROID_API static float convertRadiusToSigma(float radius);
     // If sigma > 0.5, return the corresponding radius, else return 0
@@ -39,6 +43,11 @@ public:
         uint8_t* dest, int32_t width, int32_t height);
     static void vertical(float* weights, int32_t radius, const uint8_t* source,
         uint8_t* dest, int32_t width, int32_t height);
+
+    // Blurs image in place with three horizontal and vertical box blurs matching the
+    // gaussian of the given radius. scratch must hold width * height bytes.
+    static void approximateGaussian(float radius, uint8_t* image, uint8_t* scratch,
+        int32_t width, int32_t height);
 };
 
 }; // namespace uirenderer
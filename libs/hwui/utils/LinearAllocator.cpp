@@ -42,6 +42,11 @@
 // Must be smaller than INITIAL_PAGE_SIZE
 #define MAX_WASTE_RATIO (0.5f)
 
+// The maximum amount of memory each thread keeps in released pages for reuse by the next
+// LinearAllocator, and the number of distinct page sizes from INITIAL_PAGE_SIZE to MAX_PAGE_SIZE
+#define MAX_POOLED_BYTES ((size_t)524288) // 512kb
+#define POOL_BUCKET_COUNT 9
+
 #if ALIGN_DOUBLE
 #define ALIGN_SZ (sizeof(double))
 #else
@@ -108,12 +113,94 @@ private:
     Page* mNextPage;
 };
 
+namespace {
+
+/**
+ * Per-thread cache of the pages released by destroyed LinearAllocators. Display lists are
+ * re-recorded constantly (e.g. every frame of a scroll), and every new list walks through the
+ * same page sizes, so handing the pages of the previous list to the next one avoids most of
+ * the malloc/free traffic. Only pages of the standard growth sizes are kept, up to
+ * MAX_POOLED_BYTES per thread; anything else is freed.
+ */
+class PagePool {
+public:
+    static void* obtain(size_t pageSize) {
+        int bucket = bucketFor(pageSize);
+        if (bucket < 0 || !sState.buckets[bucket]) return nullptr;
+        FreePage* page = sState.buckets[bucket];
+        sState.buckets[bucket] = page->next;
+        sState.pooledBytes -= pageSize;
+        return page;
+    }
+
+    static bool recycle(void* buf, size_t pageSize) {
+        int bucket = bucketFor(pageSize);
+        if (bucket < 0 || sState.disabled
+                || sState.pooledBytes + pageSize > MAX_POOLED_BYTES) {
+            return false;
+        }
+        registerDrainer();
+        FreePage* page = reinterpret_cast<FreePage*>(buf);
+        page->next = sState.buckets[bucket];
+        sState.buckets[bucket] = page;
+        sState.pooledBytes += pageSize;
+        return true;
+    }
+
+private:
+    struct FreePage {
+        FreePage* next;
+    };
+
+    // Kept trivially destructible so that allocators destroyed late during thread exit can
+    // still safely consult it after the drainer has run.
+    struct State {
+        FreePage* buckets[POOL_BUCKET_COUNT];
+        size_t pooledBytes;
+        bool disabled;
+    };
+
+    struct Drainer {
+        ~Drainer() {
+            for (int i = 0; i < POOL_BUCKET_COUNT; i++) {
+                while (sState.buckets[i]) {
+                    FreePage* page = sState.buckets[i];
+                    sState.buckets[i] = page->next;
+                    free(page);
+                    RM_ALLOCATION();
+                }
+            }
+            sState.pooledBytes = 0;
+            sState.disabled = true;
+        }
+    };
+
+    static void registerDrainer() {
+        static thread_local Drainer sDrainer;
+        (void) sDrainer;
+    }
+
+    static int bucketFor(size_t pageSize) {
+        int bucket = 0;
+        for (size_t size = INITIAL_PAGE_SIZE; size <= MAX_PAGE_SIZE; size *= 2, bucket++) {
+            if (size == pageSize) return bucket;
+        }
+        return -1;
+    }
+
+    static thread_local State sState;
+};
+
+thread_local PagePool::State PagePool::sState;
+} // namespace
+
 LinearAllocator::LinearAllocator()
     : mPageSize(INITIAL_PAGE_SIZE)
     , mMaxAllocSize(INITIAL_PAGE_SIZE * MAX_WASTE_RATIO)
     , mNext(0)
     , mCurrentPage(0)
     , mPages(0)
+    , mDedicatedPages(0)
     , mTotalAllocated(0)
     , mWastedSpace(0)
     , mPageCount(0)
@@ -125,7 +212,20 @@ LinearAllocator::~LinearAllocator(void) {
         mDtorList = node->next;
         node->dtor(node->addr);
     }
+    // mPages only holds pages created by ensureNext(), so their sizes follow its growth
+    size_t pageSize = INITIAL_PAGE_SIZE;
     Page* p = mPages;
+    while (p) {
+        Page* next = p->next();
+        p->~Page();
+        if (!PagePool::recycle(p, pageSize)) {
+            free(p);
+            RM_ALLOCATION();
+        }
+        pageSize = min(MAX_PAGE_SIZE, pageSize * 2);
+        p = next;
+    }
+    p = mDedicatedPages;
     while (p) {
         Page* next = p->next();
         p->~Page();
@@ -174,10 +274,8 @@ void* LinearAllocator::allocImpl(size_t size) {
         // Allocation is too large, create a dedicated page for the allocation
         Page* page = newPage(size);
         mDedicatedPageCount++;
-        page->setNext(mPages);
-        mPages = page;
-        if (!mCurrentPage)
-            mCurrentPage = mPages;
+        page->setNext(mDedicatedPages);
+        mDedicatedPages = page;
         return start(page);
     }
     ensureNext(size);
@@ -223,9 +321,13 @@ void LinearAllocator::rewindIfLastAlloc(void* ptr, size_t allocSize) {
     // also rewind for the DestructorNode allocation which will
     // have been allocated after this void* if it has a destructor
     runDestructorFor(ptr);
+    rewindTrivialIfLastAlloc(ptr, allocSize);
+}
+
+void LinearAllocator::rewindTrivialIfLastAlloc(void* ptr, size_t allocSize) {
     // Don't bother rewinding across pages
     allocSize = ALIGN(allocSize);
-    if (ptr >= start(mCurrentPage) && ptr < end(mCurrentPage)
+    if (mCurrentPage && ptr >= start(mCurrentPage) && ptr < end(mCurrentPage)
             && ptr == ((char*)mNext - allocSize)) {
         mWastedSpace += allocSize;
         mNext = ptr;
@@ -233,11 +335,14 @@ void LinearAllocator::rewindIfLastAlloc(void* ptr, size_t allocSize) {
 }
 
 LinearAllocator::Page* LinearAllocator::newPage(size_t pageSize) {
-    pageSize = ALIGN(pageSize + sizeof(LinearAllocator::Page));
-    ADD_ALLOCATION();
-    mTotalAllocated += pageSize;
+    size_t allocSize = ALIGN(pageSize + sizeof(LinearAllocator::Page));
+    mTotalAllocated += allocSize;
     mPageCount++;
-    void* buf = malloc(pageSize);
+    void* buf = PagePool::obtain(pageSize);
+    if (!buf) {
+        ADD_ALLOCATION();
+        buf = malloc(allocSize);
+    }
     return new (buf) Page();
 }
 
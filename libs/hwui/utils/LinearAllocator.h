@@ -102,7 +102,11 @@ public:
      */
     template<class T>
     void rewindIfLastAlloc(T* ptr) {
-        rewindIfLastAlloc((void*)ptr, sizeof(T));
+        if (std::is_trivially_destructible<T>::value) {
+            rewindTrivialIfLastAlloc(ptr, sizeof(T));
+        } else {
+            rewindIfLastAlloc((void*)ptr, sizeof(T));
+        }
     }
 
     /**
@@ -117,6 +121,8 @@ public:
     size_t usedSize() const { return mTotalAllocated - mWastedSpace; }
 
 private:
+    template <class T> friend class LinearStdAllocator;
+
     LinearAllocator(const LinearAllocator& other);
 
     class Page;
@@ -131,6 +137,9 @@ private:
 
     void addToDestructionList(Destructor, void* addr);
     void runDestructorFor(void* addr);
+    // Same as rewindIfLastAlloc(void*, size_t), for buffers known to have no destructor,
+    // without searching the destruction list
+    void rewindTrivialIfLastAlloc(void* ptr, size_t allocSize);
     Page* newPage(size_t pageSize);
     bool fitsInCurrentPage(size_t size);
     void ensureNext(size_t size);
@@ -142,6 +151,7 @@ private:
     void* mNext;
     Page* mCurrentPage;
     Page* mPages;
+    Page* mDedicatedPages;
     DestructorNode* mDtorList = nullptr;
 
     // Memory usage tracking
@@ -179,7 +189,7 @@ public:
 
     void deallocate(pointer p, size_t num) {
         // attempt to rewind, but no guarantees
-        linearAllocator.rewindIfLastAlloc(p, num * sizeof(T));
+        linearAllocator.rewindTrivialIfLastAlloc(p, num * sizeof(T));
     }
 
     // public so template copy constructor can access
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPMCRINGBUFFER_H_
+#define SPMCRINGBUFFER_H_
+
+#include "utils/Macros.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Lock-free ring buffer with a single producer and any number of consumers. The producer
+ * never waits: once the ring is full it overwrites the oldest element, and consumers that
+ * fall behind skip ahead and count what they missed. Each consumer keeps its own Reader, the
+ * ring itself holds no per-consumer state.
+ *
+ * Every slot is guarded by a sequence number, odd while the producer writes it, so a
+ * consumer can detect that an element was overwritten while it copied it out. This is why T
+ * must be trivially copyable.
+ */
+template<class T, size_t SIZE>
+class SpmcRingBuffer {
+    PREVENT_COPY_AND_ASSIGN(SpmcRingBuffer);
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+    class Reader {
+    public:
+        // Only reads the elements pushed after the reader was created
+        explicit Reader(const SpmcRingBuffer& ring) : mPosition(ring.head()) {}
+        Reader(const SpmcRingBuffer& ring, uint64_t position) : mPosition(position) {}
+
+        /**
+         * Copies the oldest element this reader hasn't read yet into out. Returns false if
+         * there is none. Elements overwritten before they could be read are added to
+         * dropCount.
+         */
+        bool next(const SpmcRingBuffer& ring, T* out, int* dropCount) {
+            uint64_t head = ring.head();
+            while (mPosition < head) {
+                if (head - mPosition > SIZE) {
+                    *dropCount += head - SIZE - mPosition;
+                    mPosition = head - SIZE;
+                }
+                if (ring.read(mPosition++, out)) {
+                    return true;
+                }
+                // The producer lapped this reader while it was copying
+                (*dropCount)++;
+                head = ring.head();
+            }
+            return false;
+        }
+
+    private:
+        uint64_t mPosition;
+    };
+
+    SpmcRingBuffer() {}
+    ~SpmcRingBuffer() {}
+
+    constexpr size_t capacity() const { return SIZE; }
+
+    // Position of the next element to be pushed
+    uint64_t head() const { return mHead.load(std::memory_order_acquire); }
+
+    // Must only be called from the producer thread
+    void push(const T& value) {
+        uint64_t position = mHead.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[position % SIZE];
+        slot.sequence.store(position * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.sequence.store(position * 2 + 2, std::memory_order_release);
+        mHead.store(position + 1, std::memory_order_release);
+    }
+
+    /**
+     * Copies the element at the given position into out. Returns false if it isn't in the
+     * ring, because it was overwritten or hasn't been pushed yet.
+     */
+    bool read(uint64_t position, T* out) const {
+        const Slot& slot = mSlots[position % SIZE];
+        uint64_t expected = position * 2 + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            return false;
+        }
+        *out = slot.value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == expected;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence { 0 };
+        T value;
+    };
+
+    Slot mSlots[SIZE];
+    std::atomic<uint64_t> mHead { 0 };
+};
+
+}; // namespace uirenderer
+}; // namespace android
+
+#endif /* SPMCRINGBUFFER_H_ */
@@ -21,6 +21,14 @@
 #include <math.h>
 #include <utils/Log.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define VECTORDRAWABLE_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTORDRAWABLE_USE_SSE2
+#endif
+
 namespace android {
 namespace uirenderer {
 
@@ -66,7 +74,8 @@ void VectorDrawableUtils::verbsToPath(SkPath* outPath, const PathData& data) {
     PathResolver resolver;
     char previousCommand = 'm';
     size_t start = 0;
-    outPath->reset();
+    // Keeps the path storage around, since animated paths are rebuilt with the same verbs
+    outPath->rewind();
     for (unsigned int i = 0; i < data.verbs.size(); i++) {
         size_t verbSize = data.verbSizes[i];
         resolver.addCommand(outPath, previousCommand, data.verbs[i], &data.points, start,
@@ -87,12 +96,41 @@ void VectorDrawableUtils::verbsToPath(SkPath* outPath, const PathData& data) {
  */
 void VectorDrawableUtils::interpolatePaths(PathData* outData,
         const PathData& from, const PathData& to, float fraction) {
+    // Animators interpolate into the same PathData every frame, so the verbs only need to be
+    // copied the first time
+    if (outData->verbs != from.verbs || outData->verbSizes != from.verbSizes) {
+        outData->verbSizes = from.verbSizes;
+        outData->verbs = from.verbs;
+    }
     outData->points.resize(from.points.size());
-    outData->verbSizes = from.verbSizes;
-    outData->verbs = from.verbs;
 
-    for (size_t i = 0; i < from.points.size(); i++) {
-        outData->points[i] = from.points[i] * (1 - fraction) + to.points[i] * fraction;
+    const size_t count = from.points.size();
+    const float* fromPoints = from.points.data();
+    const float* toPoints = to.points.data();
+    float* outPoints = outData->points.data();
+    const float inverseFraction = 1 - fraction;
+
+    // Four points at a time, the scalar loop handles the remainder
+    size_t i = 0;
+#if defined(VECTORDRAWABLE_USE_NEON)
+    const float32x4_t fromScale = vdupq_n_f32(inverseFraction);
+    const float32x4_t toScale = vdupq_n_f32(fraction);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t result = vaddq_f32(vmulq_f32(vld1q_f32(fromPoints + i), fromScale),
+                vmulq_f32(vld1q_f32(toPoints + i), toScale));
+        vst1q_f32(outPoints + i, result);
+    }
+#elif defined(VECTORDRAWABLE_USE_SSE2)
+    const __m128 fromScale = _mm_set1_ps(inverseFraction);
+    const __m128 toScale = _mm_set1_ps(fraction);
+    for (; i + 4 <= count; i += 4) {
+        __m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(fromPoints + i), fromScale),
+                _mm_mul_ps(_mm_loadu_ps(toPoints + i), toScale));
+        _mm_storeu_ps(outPoints + i, result);
+    }
+#endif
+    for (; i < count; i++) {
+        outPoints[i] = fromPoints[i] * inverseFraction + toPoints[i] * fraction;
     }
 }
 
@@ -21,6 +21,7 @@
 
 #include <log/log.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 #include <gui/Surface.h>
 
 // ToDo: Fix code to be warning free
@@ -36,6 +37,10 @@
 
 namespace android {
 
+// Mice report up to 1000 moves per second, while the compositor only latches one sprite
+// position per frame. Moves that come faster than this are coalesced into one transaction.
+static const nsecs_t MIN_POSITION_UPDATE_INTERVAL = ms2ns(8);
+
 // --- SpriteController ---
 
 SpriteController::SpriteController(const sp<Looper>& looper, int32_t overlayLayer) :
@@ -44,6 +49,8 @@ SpriteController::SpriteController(const sp<Looper>& looper, int32_t overlayLaye
 
     mLocked.transactionNestingCount = 0;
     mLocked.deferredSpriteUpdate = false;
+    mLocked.positionOnlyUpdate = false;
+    mLocked.lastUpdateTime = 0;
 }
 
 SpriteController::~SpriteController() {
@@ -74,22 +81,38 @@ void SpriteController::closeTransaction() {
     mLocked.transactionNestingCount -= 1;
     if (mLocked.transactionNestingCount == 0 && mLocked.deferredSpriteUpdate) {
         mLocked.deferredSpriteUpdate = false;
-        mLooper->sendMessage(mHandler, Message(MSG_UPDATE_SPRITES));
+        scheduleSpriteUpdateLocked();
     }
 }
 
-void SpriteController::invalidateSpriteLocked(const sp<SpriteImpl>& sprite) {
+void SpriteController::invalidateSpriteLocked(const sp<SpriteImpl>& sprite, uint32_t dirty) {
     bool wasEmpty = mLocked.invalidatedSprites.isEmpty();
     mLocked.invalidatedSprites.push(sprite);
+    if (wasEmpty) {
+        mLocked.positionOnlyUpdate = true;
+    }
+    if (dirty & ~DIRTY_POSITION) {
+        mLocked.positionOnlyUpdate = false;
+    }
     if (wasEmpty) {
         if (mLocked.transactionNestingCount != 0) {
             mLocked.deferredSpriteUpdate = true;
         } else {
-            mLooper->sendMessage(mHandler, Message(MSG_UPDATE_SPRITES));
+            scheduleSpriteUpdateLocked();
         }
     }
 }
 
+void SpriteController::scheduleSpriteUpdateLocked() {
+    nsecs_t earliestUpdateTime = mLocked.lastUpdateTime + MIN_POSITION_UPDATE_INTERVAL;
+    if (mLocked.positionOnlyUpdate
+            && systemTime(SYSTEM_TIME_MONOTONIC) < earliestUpdateTime) {
+        mLooper->sendMessageAtTime(earliestUpdateTime, mHandler, Message(MSG_UPDATE_SPRITES));
+    } else {
+        mLooper->sendMessage(mHandler, Message(MSG_UPDATE_SPRITES));
+    }
+}
+
 void SpriteController::disposeSurfaceLocked(const sp<SurfaceControl>& surfaceControl) {
     bool wasEmpty = mLocked.disposedSurfaces.isEmpty();
     mLocked.disposedSurfaces.push(surfaceControl);
@@ -128,6 +151,9 @@ void SpriteController::doUpdateSprites() {
             sprite->resetDirtyLocked();
         }
         mLocked.invalidatedSprites.clear();
+        if (numSprites) {
+            mLocked.lastUpdateTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        }
     } // release lock
 
     // Create missing surfaces.
@@ -478,7 +504,7 @@ void SpriteController::SpriteImpl::invalidateLocked(uint32_t dirty) {
     mLocked.state.dirty |= dirty;
 
     if (!wasDirty) {
-        mController->invalidateSpriteLocked(this);
+        mController->invalidateSpriteLocked(this, dirty);
     }
 }
 
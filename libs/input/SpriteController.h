@@ -275,9 +275,13 @@ private:
         Vector<sp<SurfaceControl> > disposedSurfaces;
         uint32_t transactionNestingCount;
         bool deferredSpriteUpdate;
+        // True while the invalidated sprites only moved.
+        bool positionOnlyUpdate;
+        nsecs_t lastUpdateTime;
     } mLocked; // guarded by mLock
 
-    void invalidateSpriteLocked(const sp<SpriteImpl>& sprite);
+    void invalidateSpriteLocked(const sp<SpriteImpl>& sprite, uint32_t dirty);
+    void scheduleSpriteUpdateLocked();
     void disposeSurfaceLocked(const sp<SurfaceControl>& surfaceControl);
 
     void handleMessage(const Message& message);
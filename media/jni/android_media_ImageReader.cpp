@@ -37,6 +37,7 @@
 #include <jni.h>
 #include <JNIHelp.h>
 
+#include <pthread.h>
 #include <stdint.h>
 #include <inttypes.h>
 
@@ -112,8 +113,8 @@ public:
     int getBufferHeight() { return mHeight; }
 
 private:
-    static JNIEnv* getJNIEnv(bool* needsDetach);
-    static void detachJNI();
+    static JNIEnv* getJNIEnv();
+    static void detachJNI(void* env);
 
     List<BufferItem*> mBuffers;
     sp<BufferItemConsumer> mConsumer;
@@ -140,11 +141,17 @@ JNIImageReaderContext::JNIImageReaderContext(JNIEnv* env,
     }
 }
 
-JNIEnv* JNIImageReaderContext::getJNIEnv(bool* needsDetach) {
-    LOG_ALWAYS_FATAL_IF(needsDetach == NULL, "needsDetach is null!!!");
-    *needsDetach = false;
+static pthread_key_t sDetachKey;
+static pthread_once_t sDetachKeyOnce = PTHREAD_ONCE_INIT;
+
+// Threads outside the VM that deliver frames are attached once and stay attached until they
+// exit. Attaching allocates a java.lang.Thread, doing it for every frame churns the heap.
+JNIEnv* JNIImageReaderContext::getJNIEnv() {
     JNIEnv* env = AndroidRuntime::getJNIEnv();
     if (env == NULL) {
+        pthread_once(&sDetachKeyOnce, [] {
+            pthread_key_create(&sDetachKey, JNIImageReaderContext::detachJNI);
+        });
         JavaVMAttachArgs args = {JNI_VERSION_1_4, NULL, NULL};
         JavaVM* vm = AndroidRuntime::getJavaVM();
         int result = vm->AttachCurrentThread(&env, (void*) &args);
@@ -152,12 +159,12 @@ JNIEnv* JNIImageReaderContext::getJNIEnv(bool* needsDetach) {
             ALOGE("thread attach failed: %#x", result);
             return NULL;
         }
-        *needsDetach = true;
+        pthread_setspecific(sDetachKey, env);
     }
     return env;
 }
 
-void JNIImageReaderContext::detachJNI() {
+void JNIImageReaderContext::detachJNI(void* /*env*/) {
     JavaVM* vm = AndroidRuntime::getJavaVM();
     int result = vm->DetachCurrentThread();
     if (result != JNI_OK) {
@@ -182,17 +189,13 @@ void JNIImageReaderContext::returnBufferItem(BufferItem* buffer) {
 }
 
 JNIImageReaderContext::~JNIImageReaderContext() {
-    bool needsDetach = false;
-    JNIEnv* env = getJNIEnv(&needsDetach);
+    JNIEnv* env = getJNIEnv();
     if (env != NULL) {
         env->DeleteGlobalRef(mWeakThiz);
         env->DeleteGlobalRef(mClazz);
     } else {
         ALOGW("leaking JNI object references");
     }
-    if (needsDetach) {
-        detachJNI();
-    }
 
     // Delete buffer items.
     for (List<BufferItem *>::iterator it = mBuffers.begin();
@@ -208,16 +211,12 @@ JNIImageReaderContext::~JNIImageReaderContext() {
 void JNIImageReaderContext::onFrameAvailable(const BufferItem& /*item*/)
 {
     ALOGV("%s: frame available", __FUNCTION__);
-    bool needsDetach = false;
-    JNIEnv* env = getJNIEnv(&needsDetach);
+    JNIEnv* env = getJNIEnv();
     if (env != NULL) {
         env->CallStaticVoidMethod(mClazz, gImageReaderClassInfo.postEventFromNative, mWeakThiz);
     } else {
         ALOGW("onFrameAvailable event will not posted");
     }
-    if (needsDetach) {
-        detachJNI();
-    }
 }
 
 // ----------------------------------------------------------------------------
@@ -454,6 +453,7 @@ static sp<Fence> Image_unlockIfLocked(JNIEnv* env, jobject image) {
         planes = env->GetObjectField(image, gSurfaceImageClassInfo.mPlanes);
     }
     wasBufferLocked = (planes != NULL);
+    env->DeleteLocalRef(planes);
     if (wasBufferLocked) {
         status_t res = OK;
         int fenceFd = -1;
@@ -756,6 +756,8 @@ static jobjectArray Image_createSurfacePlanes(JNIEnv* env, jobject thiz,
         jobject surfacePlane = env->NewObject(gSurfacePlaneClassInfo.clazz,
                     gSurfacePlaneClassInfo.ctor, thiz, rowStride, pixelStride, byteBuffer);
         env->SetObjectArrayElement(surfacePlanes, i, surfacePlane);
+        env->DeleteLocalRef(surfacePlane);
+        env->DeleteLocalRef(byteBuffer);
     }
 
     return surfacePlanes;
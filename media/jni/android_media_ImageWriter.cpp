@@ -177,7 +177,7 @@ static void Image_setNativeContext(JNIEnv* env, jobject thiz,
         sp<GraphicBuffer> buffer, int fenceFd);
 static void Image_getNativeContext(JNIEnv* env, jobject thiz,
         GraphicBuffer** buffer, int* fenceFd);
-static void Image_unlockIfLocked(JNIEnv* env, jobject thiz);
+static void Image_unlockIfLocked(JNIEnv* env, jobject thiz, int* fenceFd);
 
 // --------------------------ImageWriter methods---------------------------------------
 
@@ -414,7 +414,7 @@ static void ImageWriter_cancelImage(JNIEnv* env, jobject thiz, jlong nativeCtx,
     }
 
     // Unlock the image if it was locked
-    Image_unlockIfLocked(env, image);
+    Image_unlockIfLocked(env, image, &fenceFd);
 
     anw->cancelBuffer(anw.get(), buffer, fenceFd);
 
@@ -444,7 +444,7 @@ static void ImageWriter_queueImage(JNIEnv* env, jobject thiz, jlong nativeCtx, j
     }
 
     // Unlock image if it was locked.
-    Image_unlockIfLocked(env, image);
+    Image_unlockIfLocked(env, image, &fenceFd);
 
     // Set timestamp
     ALOGV("timestamp to be queued: %" PRId64, timestampNs);
@@ -608,7 +608,9 @@ static void Image_setNativeContext(JNIEnv* env, jobject thiz,
     env->SetIntField(thiz, gSurfaceImageClassInfo.mNativeFenceFd, reinterpret_cast<jint>(fenceFd));
 }
 
-static void Image_unlockIfLocked(JNIEnv* env, jobject thiz) {
+// If the image was locked, fenceFd is replaced by the fence that signals once the CPU writes
+// have landed, the lock already consumed the fence that was there before.
+static void Image_unlockIfLocked(JNIEnv* env, jobject thiz, int* fenceFd) {
     ALOGV("%s", __FUNCTION__);
     GraphicBuffer* buffer;
     Image_getNativeContext(env, thiz, &buffer, NULL);
@@ -625,11 +627,15 @@ static void Image_unlockIfLocked(JNIEnv* env, jobject thiz) {
         planes = env->GetObjectField(thiz, gSurfaceImageClassInfo.mPlanes);
     }
     isLocked = (planes != NULL);
+    env->DeleteLocalRef(planes);
     if (isLocked) {
-        // no need to use fence here, as we it will be consumed by either cancel or queue buffer.
-        status_t res = buffer->unlock();
+        // Don't wait for the unlock here, the fence is handed to the consumer by either cancel
+        // or queue buffer.
+        status_t res = buffer->unlockAsync(fenceFd);
         if (res != OK) {
+            *fenceFd = -1;
             jniThrowRuntimeException(env, "unlock buffer failed");
+            return;
         }
         ALOGV("Successfully unlocked the image");
     }
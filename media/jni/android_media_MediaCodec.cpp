@@ -91,6 +91,12 @@ static struct {
     jmethodID setNativeObjectLocked;
 } gPersistentSurfaceClassInfo;
 
+static struct {
+    jclass clazz;
+    jmethodID ctor;
+    jmethodID setId;
+} gBufferInfo;
+
 static struct {
     jint Unencrypted;
     jint AesCtr;
@@ -368,11 +374,7 @@ status_t JMediaCodec::dequeueOutputBuffer(
         return err;
     }
 
-    ScopedLocalRef<jclass> clazz(
-            env, env->FindClass("android/media/MediaCodec$BufferInfo"));
-
-    jmethodID method = env->GetMethodID(clazz.get(), "set", "(IIJI)V");
-    env->CallVoidMethod(bufferInfo, method, (jint)offset, (jint)size, timeUs, flags);
+    env->CallVoidMethod(bufferInfo, gBufferInfo.setId, (jint)offset, (jint)size, timeUs, flags);
 
     return OK;
 }
@@ -484,16 +486,23 @@ status_t JMediaCodec::createByteBufferFromABuffer(
     jobject me = env->CallObjectMethod(
             byteBuffer, mByteBufferOrderMethodID, mNativeByteOrderObj);
     env->DeleteLocalRef(me);
-    me = env->CallObjectMethod(
-            byteBuffer, mByteBufferLimitMethodID,
-            clearBuffer ? buffer->capacity() : (buffer->offset() + buffer->size()));
-    env->DeleteLocalRef(me);
-    me = env->CallObjectMethod(
-            byteBuffer, mByteBufferPositionMethodID,
-            clearBuffer ? 0 : buffer->offset());
-    env->DeleteLocalRef(me);
     me = NULL;
 
+    // A new direct buffer already spans [0, capacity), only call back into
+    // Java when the codec buffer holds a sub-range.
+    size_t limit = clearBuffer ? buffer->capacity() : (buffer->offset() + buffer->size());
+    if (limit != buffer->capacity()) {
+        me = env->CallObjectMethod(byteBuffer, mByteBufferLimitMethodID, (jint)limit);
+        env->DeleteLocalRef(me);
+        me = NULL;
+    }
+    if (!clearBuffer && buffer->offset() != 0) {
+        me = env->CallObjectMethod(
+                byteBuffer, mByteBufferPositionMethodID, (jint)buffer->offset());
+        env->DeleteLocalRef(me);
+        me = NULL;
+    }
+
     *buf = byteBuffer;
     return OK;
 }
@@ -705,12 +714,7 @@ void JMediaCodec::handleCallback(const sp<AMessage> &msg) {
             CHECK(msg->findInt64("timeUs", &timeUs));
             CHECK(msg->findInt32("flags", (int32_t *)&flags));
 
-            ScopedLocalRef<jclass> clazz(
-                    env, env->FindClass("android/media/MediaCodec$BufferInfo"));
-            jmethodID ctor = env->GetMethodID(clazz.get(), "<init>", "()V");
-            jmethodID method = env->GetMethodID(clazz.get(), "set", "(IIJI)V");
-
-            obj = env->NewObject(clazz.get(), ctor);
+            obj = env->NewObject(gBufferInfo.clazz, gBufferInfo.ctor);
 
             if (obj == NULL) {
                 if (env->ExceptionCheck()) {
@@ -721,7 +725,8 @@ void JMediaCodec::handleCallback(const sp<AMessage> &msg) {
                 return;
             }
 
-            env->CallVoidMethod(obj, method, (jint)offset, (jint)size, timeUs, flags);
+            env->CallVoidMethod(
+                    obj, gBufferInfo.setId, (jint)offset, (jint)size, timeUs, flags);
             break;
         }
 
@@ -1877,6 +1882,20 @@ static void android_media_MediaCodec_native_init(JNIEnv *env) {
     field = env->GetFieldID(clazz.get(), "mPersistentObject", "J");
     CHECK(field != NULL);
     gPersistentSurfaceClassInfo.mPersistentObject = field;
+
+    // Looked up once here, both dequeueOutputBuffer and the async output callback
+    // fill in a BufferInfo for every buffer
+    clazz.reset(env->FindClass("android/media/MediaCodec$BufferInfo"));
+    CHECK(clazz.get() != NULL);
+    gBufferInfo.clazz = (jclass)env->NewGlobalRef(clazz.get());
+
+    method = env->GetMethodID(clazz.get(), "<init>", "()V");
+    CHECK(method != NULL);
+    gBufferInfo.ctor = method;
+
+    method = env->GetMethodID(clazz.get(), "set", "(IIJI)V");
+    CHECK(method != NULL);
+    gBufferInfo.setId = method;
 }
 
 static void android_media_MediaCodec_native_setup(
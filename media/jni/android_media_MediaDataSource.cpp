@@ -32,8 +32,10 @@
 
 namespace android {
 
-JMediaDataSource::JMediaDataSource(JNIEnv* env, jobject source)
-    : mJavaObjStatus(OK), mSizeIsCached(false), mCachedSize(0), mMemory(NULL) {
+JMediaDataSource::JMediaDataSource(JNIEnv* env, jobject source, size_t readAheadSize)
+    : mJavaObjStatus(OK), mSizeIsCached(false), mCachedSize(0), mMemory(NULL),
+      mReadAheadSize(readAheadSize < kBufferSize ? readAheadSize : kBufferSize),
+      mUseCounter(0) {
     mMediaDataSourceObj = env->NewGlobalRef(source);
     CHECK(mMediaDataSourceObj != NULL);
 
@@ -56,6 +58,12 @@ JMediaDataSource::JMediaDataSource(JNIEnv* env, jobject source)
     if (mMemory == NULL) {
         ALOGE("Failed to allocate memory!");
     }
+
+    for (CachedBlock& block : mBlocks) {
+        block.offset = 0;
+        block.size = 0;
+        block.lastUse = 0;
+    }
 }
 
 JMediaDataSource::~JMediaDataSource() {
@@ -69,16 +77,7 @@ sp<IMemory> JMediaDataSource::getIMemory() {
     return mMemory;
 }
 
-ssize_t JMediaDataSource::readAt(off64_t offset, size_t size) {
-    Mutex::Autolock lock(mLock);
-
-    if (mJavaObjStatus != OK || mMemory == NULL) {
-        return -1;
-    }
-    if (size > kBufferSize) {
-        size = kBufferSize;
-    }
-
+ssize_t JMediaDataSource::readFromSource(off64_t offset, size_t size, uint8_t* dst) {
     JNIEnv* env = AndroidRuntime::getJNIEnv();
     jint numread = env->CallIntMethod(mMediaDataSourceObj, mReadMethod,
             (jlong)offset, mByteArrayObj, (jint)0, (jint)size);
@@ -106,10 +105,98 @@ ssize_t JMediaDataSource::readAt(off64_t offset, size_t size) {
     }
 
     ALOGV("readAt %lld / %zu => %d.", (long long)offset, size, numread);
-    env->GetByteArrayRegion(mByteArrayObj, 0, numread, (jbyte*)mMemory->pointer());
+    env->GetByteArrayRegion(mByteArrayObj, 0, numread, (jbyte*)dst);
+    return numread;
+}
+
+JMediaDataSource::CachedBlock* JMediaDataSource::findCachedBlock(off64_t offset) {
+    for (CachedBlock& block : mBlocks) {
+        if (block.size > 0 && offset >= block.offset
+                && offset - block.offset < (off64_t)block.size) {
+            return &block;
+        }
+    }
+    return NULL;
+}
+
+ssize_t JMediaDataSource::fillCachedBlock(off64_t offset, size_t minSize, CachedBlock** out) {
+    CachedBlock* block = &mBlocks[0];
+    for (CachedBlock& candidate : mBlocks) {
+        if (candidate.lastUse < block->lastUse) {
+            block = &candidate;
+        }
+    }
+    if (block->data == NULL) {
+        block->data.reset(new uint8_t[kBufferSize]);
+    }
+
+    size_t size = minSize > mReadAheadSize ? minSize : mReadAheadSize;
+    // Don't ask for data past the end, some sources block until it shows up.
+    if (mSizeIsCached && mCachedSize >= 0 && mCachedSize - offset < (off64_t)size) {
+        if (offset >= mCachedSize) {
+            return 0;
+        }
+        size = mCachedSize - offset;
+    }
+
+    block->size = 0;
+    ssize_t numread = readFromSource(offset, size, block->data.get());
+    if (numread > 0) {
+        block->offset = offset;
+        block->size = numread;
+        *out = block;
+    }
     return numread;
 }
 
+ssize_t JMediaDataSource::readAt(off64_t offset, size_t size) {
+    Mutex::Autolock lock(mLock);
+
+    if (mJavaObjStatus != OK || mMemory == NULL) {
+        return -1;
+    }
+    if (size > kBufferSize) {
+        size = kBufferSize;
+    }
+
+    uint8_t* dst = (uint8_t*)mMemory->pointer();
+    if (mReadAheadSize == 0) {
+        return readFromSource(offset, size, dst);
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        off64_t position = offset + total;
+        CachedBlock* block = findCachedBlock(position);
+        bool shortRead = false;
+        if (block == NULL) {
+            ssize_t numread = fillCachedBlock(position, size - total, &block);
+            if (numread < 0) {
+                return -1;
+            }
+            if (numread == 0) {
+                break;
+            }
+            // Hand out what the source had rather than asking it again, a short read may
+            // mean it doesn't have more data yet.
+            shortRead = (size_t)numread < size - total;
+        }
+
+        size_t skip = position - block->offset;
+        size_t count = block->size - skip;
+        if (count > size - total) {
+            count = size - total;
+        }
+        memcpy(dst + total, block->data.get() + skip, count);
+        block->lastUse = ++mUseCounter;
+        total += count;
+        if (shortRead) {
+            break;
+        }
+    }
+    return total;
+}
+
 status_t JMediaDataSource::getSize(off64_t* size) {
     Mutex::Autolock lock(mLock);
 
@@ -150,6 +237,11 @@ void JMediaDataSource::close() {
     env->CallVoidMethod(mMediaDataSourceObj, mCloseMethod);
     // The closed state is effectively the same as an error state.
     mJavaObjStatus = UNKNOWN_ERROR;
+
+    for (CachedBlock& block : mBlocks) {
+        block.size = 0;
+        block.data.reset();
+    }
 }
 
 uint32_t JMediaDataSource::getFlags() {
@@ -19,6 +19,8 @@
 
 #include "jni.h"
 
+#include <memory>
+
 #include <media/IDataSource.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <utils/Errors.h>
@@ -32,13 +34,19 @@ namespace android {
 // If the java DataSource returns an error or throws an exception it
 // will be considered to be in a broken state, and the only further call this
 // will make is to close().
+//
+// Reads go through a small cache of recently read ranges, so that the many
+// small nearby reads done by extractors don't each call into java. On a miss at
+// least readAheadSize bytes are requested from the java DataSource, a
+// readAheadSize of 0 disables the cache.
 class JMediaDataSource : public BnDataSource {
 public:
     enum {
         kBufferSize = 64 * 1024,
+        kMaxCachedBlocks = 4,
     };
 
-    JMediaDataSource(JNIEnv *env, jobject source);
+    JMediaDataSource(JNIEnv *env, jobject source, size_t readAheadSize = kBufferSize);
     virtual ~JMediaDataSource();
 
     virtual sp<IMemory> getIMemory();
@@ -50,6 +58,20 @@ public:
     virtual sp<DecryptHandle> DrmInitialization(const char *mime);
 
 private:
+    struct CachedBlock {
+        off64_t offset;
+        size_t size;
+        uint32_t lastUse;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    // Calls the java readAt() and copies what it read to dst. Returns the
+    // number of bytes read, 0 at EOF or -1 if the java DataSource is broken.
+    ssize_t readFromSource(off64_t offset, size_t size, uint8_t* dst);
+    CachedBlock* findCachedBlock(off64_t offset);
+    // Reads the range starting at offset into the least recently used block.
+    ssize_t fillCachedBlock(off64_t offset, size_t minSize, CachedBlock** block);
+
     // Protect all member variables with mLock because this object will be
     // accessed on different binder worker threads.
     Mutex mLock;
@@ -68,6 +90,10 @@ private:
     jmethodID mCloseMethod;
     jbyteArray mByteArrayObj;
 
+    size_t mReadAheadSize;
+    CachedBlock mBlocks[kMaxCachedBlocks];
+    uint32_t mUseCounter;
+
     DISALLOW_EVIL_CONSTRUCTORS(JMediaDataSource);
 };
 
@@ -49,6 +49,10 @@ struct fields_t {
     jfieldID context;
 
     jmethodID cryptoInfoSetID;
+
+    jmethodID byteBufferArrayID;
+    jmethodID byteBufferPositionID;
+    jmethodID byteBufferLimitID;
 };
 
 static fields_t gFields;
@@ -147,24 +151,14 @@ status_t JMediaExtractor::readSampleData(
     size_t dstSize;
     jbyteArray byteArray = NULL;
 
-    ScopedLocalRef<jclass> byteBufClass(env, env->FindClass("java/nio/ByteBuffer"));
-    CHECK(byteBufClass.get() != NULL);
-
     if (dst == NULL) {
-        jmethodID arrayID =
-            env->GetMethodID(byteBufClass.get(), "array", "()[B");
-        CHECK(arrayID != NULL);
-
         byteArray =
-            (jbyteArray)env->CallObjectMethod(byteBuf, arrayID);
+            (jbyteArray)env->CallObjectMethod(byteBuf, gFields.byteBufferArrayID);
 
         if (byteArray == NULL) {
             return INVALID_OPERATION;
         }
 
-        jboolean isCopy;
-        dst = env->GetByteArrayElements(byteArray, &isCopy);
-
         dstSize = (size_t) env->GetArrayLength(byteArray);
     } else {
         dstSize = (size_t) env->GetDirectBufferCapacity(byteBuf);
@@ -172,18 +166,32 @@ status_t JMediaExtractor::readSampleData(
 
     if (dstSize < offset) {
         if (byteArray != NULL) {
-            env->ReleaseByteArrayElements(byteArray, (jbyte *)dst, 0);
+            env->DeleteLocalRef(byteArray);
         }
 
         return -ERANGE;
     }
 
-    sp<ABuffer> buffer = new ABuffer((char *)dst + offset, dstSize - offset);
+    sp<ABuffer> buffer;
+    if (byteArray != NULL) {
+        // Read into native memory and only copy the sample itself into the array, instead of
+        // copying the whole array in and out around the read.
+        if (mSampleBuffer.size() < dstSize - offset) {
+            mSampleBuffer.resize(dstSize - offset);
+        }
+        buffer = new ABuffer(mSampleBuffer.data(), dstSize - offset);
+    } else {
+        buffer = new ABuffer((char *)dst + offset, dstSize - offset);
+    }
 
     status_t err = mImpl->readSampleData(buffer);
 
     if (byteArray != NULL) {
-        env->ReleaseByteArrayElements(byteArray, (jbyte *)dst, 0);
+        if (err == OK) {
+            env->SetByteArrayRegion(
+                    byteArray, offset, buffer->size(), (const jbyte *)buffer->data());
+        }
+        env->DeleteLocalRef(byteArray);
     }
 
     if (err != OK) {
@@ -192,21 +200,11 @@ status_t JMediaExtractor::readSampleData(
 
     *sampleSize = buffer->size();
 
-    jmethodID positionID = env->GetMethodID(
-            byteBufClass.get(), "position", "(I)Ljava/nio/Buffer;");
-
-    CHECK(positionID != NULL);
-
-    jmethodID limitID = env->GetMethodID(
-            byteBufClass.get(), "limit", "(I)Ljava/nio/Buffer;");
-
-    CHECK(limitID != NULL);
-
     jobject me = env->CallObjectMethod(
-            byteBuf, limitID, offset + *sampleSize);
+            byteBuf, gFields.byteBufferLimitID, offset + *sampleSize);
     env->DeleteLocalRef(me);
     me = env->CallObjectMethod(
-            byteBuf, positionID, offset);
+            byteBuf, gFields.byteBufferPositionID, offset);
     env->DeleteLocalRef(me);
     me = NULL;
 
@@ -620,6 +618,20 @@ static void android_media_MediaExtractor_native_init(JNIEnv *env) {
 
     gFields.cryptoInfoSetID =
         env->GetMethodID(clazz, "set", "(I[I[I[B[BI)V");
+
+    clazz = env->FindClass("java/nio/ByteBuffer");
+    CHECK(clazz != NULL);
+
+    gFields.byteBufferArrayID = env->GetMethodID(clazz, "array", "()[B");
+    CHECK(gFields.byteBufferArrayID != NULL);
+
+    gFields.byteBufferPositionID =
+        env->GetMethodID(clazz, "position", "(I)Ljava/nio/Buffer;");
+    CHECK(gFields.byteBufferPositionID != NULL);
+
+    gFields.byteBufferLimitID =
+        env->GetMethodID(clazz, "limit", "(I)Ljava/nio/Buffer;");
+    CHECK(gFields.byteBufferLimitID != NULL);
 }
 
 static void android_media_MediaExtractor_native_setup(
@@ -25,6 +25,8 @@
 #include <utils/RefBase.h>
 #include <utils/String8.h>
 
+#include <vector>
+
 #include "jni.h"
 
 namespace android {
@@ -77,6 +79,8 @@ private:
     jclass mClass;
     jweak mObject;
     sp<NuMediaExtractor> mImpl;
+    // Sample data is read here when the target ByteBuffer is not direct
+    std::vector<uint8_t> mSampleBuffer;
 
     DISALLOW_EVIL_CONSTRUCTORS(JMediaExtractor);
 };
@@ -113,7 +113,8 @@ public:
             mClient(env->NewGlobalRef(client)),
             mScanFileMethodID(0),
             mHandleStringTagMethodID(0),
-            mSetMimeTypeMethodID(0)
+            mSetMimeTypeMethodID(0),
+            mNumTagNames(0)
     {
         ALOGV("MyMediaScannerClient constructor");
         jclass mediaScannerClientInterface =
@@ -143,6 +144,10 @@ public:
     {
         ALOGV("MyMediaScannerClient destructor");
         mEnv->DeleteGlobalRef(mClient);
+        for (size_t i = 0; i < mNumTagNames; i++) {
+            free(mTagNames[i].name);
+            mEnv->DeleteGlobalRef(mTagNames[i].str);
+        }
     }
 
     virtual status_t scanFile(const char* path, long long lastModified,
@@ -168,7 +173,7 @@ public:
     {
         ALOGV("handleStringTag: name(%s) and value(%s)", name, value);
         jstring nameStr, valueStr;
-        if ((nameStr = mEnv->NewStringUTF(name)) == NULL) {
+        if ((nameStr = getTagNameString(name)) == NULL) {
             mEnv->ExceptionClear();
             return NO_MEMORY;
         }
@@ -188,7 +193,6 @@ public:
         valueStr = mEnv->NewStringUTF(value);
         free(cleaned);
         if (valueStr == NULL) {
-            mEnv->DeleteLocalRef(nameStr);
             mEnv->ExceptionClear();
             return NO_MEMORY;
         }
@@ -196,7 +200,6 @@ public:
         mEnv->CallVoidMethod(
             mClient, mHandleStringTagMethodID, nameStr, valueStr);
 
-        mEnv->DeleteLocalRef(nameStr);
         mEnv->DeleteLocalRef(valueStr);
         return checkAndClearExceptionFromCallback(mEnv, "handleStringTag");
     }
@@ -217,11 +220,58 @@ public:
     }
 
 private:
+    // Tag names come from a small fixed set, keep their strings around for the
+    // whole scan instead of creating them again for every file.
+    enum { kMaxCachedTagNames = 32 };
+
+    struct TagName {
+        char *name;
+        jstring str;
+    };
+
+    // Returns a global reference owned by this client, or NULL if out of memory.
+    jstring getTagNameString(const char* name)
+    {
+        for (size_t i = 0; i < mNumTagNames; i++) {
+            if (!strcmp(mTagNames[i].name, name)) {
+                return mTagNames[i].str;
+            }
+        }
+        if (mNumTagNames == kMaxCachedTagNames) {
+            ALOGW("Too many tag names, not caching '%s'", name);
+            // Replace the last one so the cache keeps owning every string it hands out
+            mNumTagNames--;
+            free(mTagNames[mNumTagNames].name);
+            mEnv->DeleteGlobalRef(mTagNames[mNumTagNames].str);
+        }
+
+        jstring localStr = mEnv->NewStringUTF(name);
+        if (localStr == NULL) {
+            return NULL;
+        }
+        jstring str = (jstring) mEnv->NewGlobalRef(localStr);
+        mEnv->DeleteLocalRef(localStr);
+        char *nameCopy = strdup(name);
+        if (str == NULL || nameCopy == NULL) {
+            free(nameCopy);
+            if (str != NULL) {
+                mEnv->DeleteGlobalRef(str);
+            }
+            return NULL;
+        }
+        mTagNames[mNumTagNames].name = nameCopy;
+        mTagNames[mNumTagNames].str = str;
+        mNumTagNames++;
+        return str;
+    }
+
     JNIEnv *mEnv;
     jobject mClient;
     jmethodID mScanFileMethodID;
     jmethodID mHandleStringTagMethodID;
     jmethodID mSetMimeTypeMethodID;
+    TagName mTagNames[kMaxCachedTagNames];
+    size_t mNumTagNames;
 };
 
 
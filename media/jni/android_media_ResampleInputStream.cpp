@@ -69,6 +69,7 @@ static const short fir21[] = {
     FIR_COEF(-0.006965742326)
 };
 static const int nFir21 = sizeof(fir21) / sizeof(fir21[0]);
+static_assert(nFir21 % 2 == 1, "fir21 must have a center tap");
 
 static const int BUF_SIZE = 2048;
 
@@ -89,14 +90,14 @@ static void android_media_ResampleInputStream_fir21(JNIEnv *env, jclass /* clazz
     short in[BUF_SIZE];
     env->GetByteArrayRegion(jIn, jInOffset, (jNpoints * 2 + nFir21 - 1) * 2, (jbyte*)in);
 
-    // compute filter
+    // compute filter, the coefficients are symmetric so fold the taps
+    // around the center one to halve the multiplies
     short out[BUF_SIZE];
     for (int i = 0; i < jNpoints; i++) {
-        long sum = 0;
-        const short* firp = &fir21[0];
         const short* inp = &in[i * 2];
-        for (int n = nFir21; --n >= 0; ) {
-            sum += ((long)*firp++) * ((long)*inp++);
+        long sum = ((long)fir21[nFir21 / 2]) * ((long)inp[nFir21 / 2]);
+        for (int n = 0; n < nFir21 / 2; n++) {
+            sum += ((long)fir21[n]) * ((long)inp[n] + (long)inp[nFir21 - 1 - n]);
         }
         out[i] = (short)(sum >> 16);
     }
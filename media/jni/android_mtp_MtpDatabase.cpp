@@ -49,6 +49,8 @@ extern "C" {
 #include <stdio.h>
 #include <unistd.h>
 
+#include <unordered_map>
+
 using namespace android;
 
 // ----------------------------------------------------------------------------
@@ -101,6 +103,23 @@ private:
     jlongArray      mLongBuffer;
     jcharArray      mStringBuffer;
 
+    // Thumbnail and image size read from the EXIF data of an object, so hosts that
+    // enumerate a folder of photos again don't parse every file again
+    struct ExifInfo {
+        int64_t         length;
+        time_t          dateModified;
+        uint32_t        thumbCompressedSize;
+        MtpObjectFormat thumbFormat;
+        uint32_t        imagePixWidth;
+        uint32_t        imagePixHeight;
+    };
+    std::unordered_map<MtpObjectHandle, ExifInfo> mExifInfoCache;
+
+    bool                            getCachedExifInfo(MtpObjectHandle handle, int64_t length,
+                                            MtpObjectInfo& info);
+    void                            cacheExifInfo(MtpObjectHandle handle, int64_t length,
+                                            const MtpObjectInfo& info);
+
 public:
                                     MyMtpDatabase(JNIEnv *env, jobject client);
     virtual                         ~MyMtpDatabase();
@@ -185,6 +204,9 @@ public:
 
 // ----------------------------------------------------------------------------
 
+// Only clears the cache once it gets this big, a few thousand photos is a typical camera roll
+static const size_t kMaxExifInfoCacheSize = 8192;
+
 static void checkAndClearExceptionFromCallback(JNIEnv* env, const char* methodName) {
     if (env->ExceptionCheck()) {
         ALOGE("An exception was thrown by callback '%s'.", methodName);
@@ -823,16 +845,16 @@ MtpResponseCode MyMtpDatabase::getObjectInfo(MtpObjectHandle handle,
         return MTP_RESPONSE_INVALID_OBJECT_HANDLE;
     }
 
-    jint* intValues = env->GetIntArrayElements(mIntBuffer, 0);
+    jint intValues[3];
+    env->GetIntArrayRegion(mIntBuffer, 0, 3, intValues);
     info.mStorageID = intValues[0];
     info.mFormat = intValues[1];
     info.mParent = intValues[2];
-    env->ReleaseIntArrayElements(mIntBuffer, intValues, 0);
 
-    jlong* longValues = env->GetLongArrayElements(mLongBuffer, 0);
+    jlong longValues[2];
+    env->GetLongArrayRegion(mLongBuffer, 0, 2, longValues);
     info.mDateCreated = longValues[0];
     info.mDateModified = longValues[1];
-    env->ReleaseLongArrayElements(mLongBuffer, longValues, 0);
 
     if ((false)) {
         info.mAssociationType = (format == MTP_FORMAT_ASSOCIATION ?
@@ -841,10 +863,16 @@ MtpResponseCode MyMtpDatabase::getObjectInfo(MtpObjectHandle handle,
     }
     info.mAssociationType = MTP_ASSOCIATION_TYPE_UNDEFINED;
 
-    jchar* str = env->GetCharArrayElements(mStringBuffer, 0);
+    // The buffer is PATH_MAX chars long, don't copy it out and back just to read the name
+    jchar* str = (jchar*)env->GetPrimitiveArrayCritical(mStringBuffer, NULL);
     MtpString temp(reinterpret_cast<char16_t*>(str));
+    env->ReleasePrimitiveArrayCritical(mStringBuffer, str, JNI_ABORT);
     info.mName = strdup((const char *)temp);
-    env->ReleaseCharArrayElements(mStringBuffer, str, 0);
+
+    if (getCachedExifInfo(handle, length, info)) {
+        checkAndClearExceptionFromCallback(env, __FUNCTION__);
+        return MTP_RESPONSE_OK;
+    }
 
     // read EXIF data for thumbnail information
     switch (info.mFormat) {
@@ -891,11 +919,64 @@ MtpResponseCode MyMtpDatabase::getObjectInfo(MtpObjectHandle handle,
             break;
         }
     }
+    cacheExifInfo(handle, length, info);
 
     checkAndClearExceptionFromCallback(env, __FUNCTION__);
     return MTP_RESPONSE_OK;
 }
 
+static bool hasExifInfo(MtpObjectFormat format) {
+    switch (format) {
+        case MTP_FORMAT_EXIF_JPEG:
+        case MTP_FORMAT_JFIF:
+        case MTP_FORMAT_DNG:
+        case MTP_FORMAT_TIFF:
+        case MTP_FORMAT_TIFF_EP:
+        case MTP_FORMAT_DEFINED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool MyMtpDatabase::getCachedExifInfo(MtpObjectHandle handle, int64_t length,
+                                      MtpObjectInfo& info) {
+    if (!hasExifInfo(info.mFormat)) {
+        // Nothing to parse
+        return true;
+    }
+    auto it = mExifInfoCache.find(handle);
+    if (it == mExifInfoCache.end()) {
+        return false;
+    }
+    const ExifInfo& cached = it->second;
+    if (cached.length != length || cached.dateModified != info.mDateModified) {
+        // The file was replaced since it was parsed
+        mExifInfoCache.erase(it);
+        return false;
+    }
+    info.mThumbCompressedSize = cached.thumbCompressedSize;
+    info.mThumbFormat = cached.thumbFormat;
+    info.mImagePixWidth = cached.imagePixWidth;
+    info.mImagePixHeight = cached.imagePixHeight;
+    return true;
+}
+
+void MyMtpDatabase::cacheExifInfo(MtpObjectHandle handle, int64_t length,
+                                  const MtpObjectInfo& info) {
+    if (mExifInfoCache.size() >= kMaxExifInfoCacheSize) {
+        mExifInfoCache.clear();
+    }
+    // Files without usable EXIF data are cached too, they are just as slow to parse again
+    ExifInfo& cached = mExifInfoCache[handle];
+    cached.length = length;
+    cached.dateModified = info.mDateModified;
+    cached.thumbCompressedSize = info.mThumbCompressedSize;
+    cached.thumbFormat = info.mThumbFormat;
+    cached.imagePixWidth = info.mImagePixWidth;
+    cached.imagePixHeight = info.mImagePixHeight;
+}
+
 void* MyMtpDatabase::getThumbnail(MtpObjectHandle handle, size_t& outThumbSize) {
     MtpString path;
     int64_t length;
@@ -971,15 +1052,15 @@ MtpResponseCode MyMtpDatabase::getObjectFilePath(MtpObjectHandle handle,
         return result;
     }
 
-    jchar* str = env->GetCharArrayElements(mStringBuffer, 0);
+    jchar* str = (jchar*)env->GetPrimitiveArrayCritical(mStringBuffer, NULL);
     outFilePath.setTo(reinterpret_cast<char16_t*>(str),
                       strlen16(reinterpret_cast<char16_t*>(str)));
-    env->ReleaseCharArrayElements(mStringBuffer, str, 0);
+    env->ReleasePrimitiveArrayCritical(mStringBuffer, str, JNI_ABORT);
 
-    jlong* longValues = env->GetLongArrayElements(mLongBuffer, 0);
+    jlong longValues[2];
+    env->GetLongArrayRegion(mLongBuffer, 0, 2, longValues);
     outFileLength = longValues[0];
     outFormat = longValues[1];
-    env->ReleaseLongArrayElements(mLongBuffer, longValues, 0);
 
     checkAndClearExceptionFromCallback(env, __FUNCTION__);
     return result;
@@ -988,6 +1069,7 @@ MtpResponseCode MyMtpDatabase::getObjectFilePath(MtpObjectHandle handle,
 MtpResponseCode MyMtpDatabase::deleteFile(MtpObjectHandle handle) {
     JNIEnv* env = AndroidRuntime::getJNIEnv();
     MtpResponseCode result = env->CallIntMethod(mDatabase, method_deleteFile, (jint)handle);
+    mExifInfoCache.erase(handle);
 
     checkAndClearExceptionFromCallback(env, __FUNCTION__);
     return result;
@@ -1222,12 +1304,14 @@ MtpProperty* MyMtpDatabase::getDevicePropertyDesc(MtpDeviceProperty property) {
 }
 
 void MyMtpDatabase::sessionStarted() {
+    mExifInfoCache.clear();
     JNIEnv* env = AndroidRuntime::getJNIEnv();
     env->CallVoidMethod(mDatabase, method_sessionStarted);
     checkAndClearExceptionFromCallback(env, __FUNCTION__);
 }
 
 void MyMtpDatabase::sessionEnded() {
+    mExifInfoCache.clear();
     JNIEnv* env = AndroidRuntime::getJNIEnv();
     env->CallVoidMethod(mDatabase, method_sessionEnded);
     checkAndClearExceptionFromCallback(env, __FUNCTION__);
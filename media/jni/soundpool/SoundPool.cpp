@@ -18,6 +18,8 @@
 #define LOG_TAG "SoundPool"
 
 #include <inttypes.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <utils/Log.h>
 
@@ -42,6 +44,7 @@ uint32_t kMaxSampleRate = 48000;
 uint32_t kDefaultSampleRate = 44100;
 uint32_t kDefaultFrameCount = 1200;
 size_t kDefaultHeapSize = 1024 * 1024; // 1MB
+int kMaxDecodeThreads = 4;
 
 
 SoundPool::SoundPool(int maxChannels, const audio_attributes_t* pAttributes)
@@ -183,8 +186,14 @@ void SoundPool::quit()
 bool SoundPool::startThreads()
 {
     createThreadEtc(beginThread, this, "SoundPool");
-    if (mDecodeThread == NULL)
-        mDecodeThread = new SoundPoolThread(this);
+    if (mDecodeThread == NULL) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int numThreads = cpus > 1 ? cpus / 2 : 1;
+        if (numThreads > kMaxDecodeThreads) {
+            numThreads = kMaxDecodeThreads;
+        }
+        mDecodeThread = new SoundPoolThread(this, numThreads);
+    }
     return mDecodeThread != NULL;
 }
 
@@ -199,6 +208,18 @@ sp<Sample> SoundPool::findSample_l(int sampleID)
     return mSamples.valueFor(sampleID);
 }
 
+sp<Sample> SoundPool::findDecodedSample(const sp<Sample>& sample)
+{
+    Mutex::Autolock lock(&mLock);
+    for (size_t i = 0; i < mSamples.size(); i++) {
+        const sp<Sample>& other = mSamples.valueAt(i);
+        if (other != sample && other->hasSameSource(sample)) {
+            return other;
+        }
+    }
+    return NULL;
+}
+
 SoundChannel* SoundPool::findChannel(int channelID)
 {
     for (int i = 0; i < mMaxChannels; ++i) {
@@ -490,6 +511,13 @@ Sample::Sample(int sampleID, int fd, int64_t offset, int64_t length)
     mFd = dup(fd);
     mOffset = offset;
     mLength = length;
+    struct stat st;
+    if (mFd >= 0 && fstat(mFd, &st) == 0 && S_ISREG(st.st_mode)) {
+        mHasSource = true;
+        mSourceDev = st.st_dev;
+        mSourceIno = st.st_ino;
+        mSourceMtimeNs = int64_t(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    }
     ALOGV("create sampleID=%d, fd=%d, offset=%" PRId64 " length=%" PRId64,
         mSampleID, mFd, mLength, mOffset);
 }
@@ -503,6 +531,10 @@ void Sample::init()
     mFd = -1;
     mOffset = 0;
     mLength = 0;
+    mHasSource = false;
+    mSourceDev = 0;
+    mSourceIno = 0;
+    mSourceMtimeNs = 0;
 }
 
 Sample::~Sample()
@@ -709,6 +741,33 @@ error:
 }
 
 
+// A READY sample never changes its decoded data again, so it can be shared from any thread.
+bool Sample::hasSameSource(const sp<Sample>& other)
+{
+    return mState == READY && mHasSource && other->mHasSource
+            && mSourceDev == other->mSourceDev && mSourceIno == other->mSourceIno
+            && mSourceMtimeNs == other->mSourceMtimeNs
+            && mOffset == other->mOffset && mLength == other->mLength;
+}
+
+status_t Sample::shareDecodedData(const sp<Sample>& source)
+{
+    ALOGV("sample %d shares decoded data of sample %d", mSampleID, source->mSampleID);
+    ALOGV("close(%d)", mFd);
+    ::close(mFd);
+    mFd = -1;
+
+    // The heap is never written after decoding, so both samples can play from it.
+    mHeap = source->mHeap;
+    mData = source->mData;
+    mSize = source->mSize;
+    mSampleRate = source->mSampleRate;
+    mNumChannels = source->mNumChannels;
+    mFormat = source->mFormat;
+    mState = READY;
+    return NO_ERROR;
+}
+
 void SoundChannel::init(SoundPool* soundPool)
 {
     mSoundPool = soundPool;
@@ -17,6 +17,8 @@
 #ifndef SOUNDPOOL_H_
 #define SOUNDPOOL_H_
 
+#include <atomic>
+
 #include <utils/threads.h>
 #include <utils/List.h>
 #include <utils/Vector.h>
@@ -62,6 +64,10 @@ public:
     int state() { return mState; }
     uint8_t* data() { return static_cast<uint8_t*>(mData->pointer()); }
     status_t doLoad();
+    // Reuses the decoded data of a sample loaded from the same file region
+    // instead of decoding it again.
+    status_t shareDecodedData(const sp<Sample>& source);
+    bool hasSameSource(const sp<Sample>& other);
     void startLoad() { mState = LOADING; }
     sp<IMemory> getIMemory() { return mData; }
 
@@ -72,12 +78,18 @@ private:
     volatile int32_t    mRefCount;
     uint16_t            mSampleID;
     uint16_t            mSampleRate;
-    uint8_t             mState;
+    // Samples are decoded on one of several threads, READY publishes the decoded data
+    std::atomic<uint8_t> mState;
     uint8_t             mNumChannels;
     audio_format_t      mFormat;
     int                 mFd;
     int64_t             mOffset;
     int64_t             mLength;
+    // Identifies the file the sample was loaded from, only set for regular files
+    bool                mHasSource;
+    dev_t               mSourceDev;
+    ino_t               mSourceIno;
+    int64_t             mSourceMtimeNs;
     sp<IMemory>         mData;
     sp<MemoryHeapBase>  mHeap;
 };
@@ -184,6 +196,7 @@ public:
     // called from SoundPoolThread
     void sampleLoaded(int sampleID);
     sp<Sample> findSample(int sampleID);
+    sp<Sample> findDecodedSample(const sp<Sample>& sample);
 
     // called from AudioTrack thread
     void done_l(SoundChannel* channel);
@@ -31,7 +31,8 @@ void SoundPoolThread::write(SoundPoolMsg msg) {
     // if thread is quitting, don't add to queue
     if (mRunning) {
         mMsgQueue.push(msg);
-        mCondition.signal();
+        // Loaders may be waiting for space as well, make sure a decode thread wakes up
+        mCondition.broadcast();
     }
 }
 
@@ -42,7 +43,7 @@ const SoundPoolMsg SoundPoolThread::read() {
     }
     SoundPoolMsg msg = mMsgQueue[0];
     mMsgQueue.removeAt(0);
-    mCondition.signal();
+    mCondition.broadcast();
     return msg;
 }
 
@@ -51,20 +52,30 @@ void SoundPoolThread::quit() {
     if (mRunning) {
         mRunning = false;
         mMsgQueue.clear();
-        mMsgQueue.push(SoundPoolMsg(SoundPoolMsg::KILL, 0));
-        mCondition.signal();
-        mCondition.wait(mLock);
+        for (int i = 0; i < mNumThreads; i++) {
+            mMsgQueue.push(SoundPoolMsg(SoundPoolMsg::KILL, 0));
+        }
+        mCondition.broadcast();
+        // Wait for every thread to finish the sample it may still be decoding
+        while (mNumThreads > 0) {
+            mCondition.wait(mLock);
+        }
     }
     ALOGV("return from quit");
 }
 
-SoundPoolThread::SoundPoolThread(SoundPool* soundPool) :
-    mSoundPool(soundPool)
+SoundPoolThread::SoundPoolThread(SoundPool* soundPool, int numThreads) :
+    mSoundPool(soundPool), mRunning(false), mNumThreads(0)
 {
     mMsgQueue.setCapacity(maxMessages);
-    if (createThreadEtc(beginThread, this, "SoundPoolThread")) {
-        mRunning = true;
+    Mutex::Autolock lock(&mLock);
+    for (int i = 0; i < numThreads; i++) {
+        if (!createThreadEtc(beginThread, this, "SoundPoolThread")) {
+            break;
+        }
+        mNumThreads++;
     }
+    mRunning = mNumThreads > 0;
 }
 
 SoundPoolThread::~SoundPoolThread()
@@ -84,9 +95,13 @@ int SoundPoolThread::run() {
         SoundPoolMsg msg = read();
         ALOGV("Got message m=%d, mData=%d", msg.mMessageType, msg.mData);
         switch (msg.mMessageType) {
-        case SoundPoolMsg::KILL:
+        case SoundPoolMsg::KILL: {
             ALOGV("goodbye");
+            Mutex::Autolock lock(&mLock);
+            mNumThreads--;
+            mCondition.broadcast();
             return NO_ERROR;
+        }
         case SoundPoolMsg::LOAD_SAMPLE:
             doLoadSample(msg.mData);
             break;
@@ -106,7 +121,12 @@ void SoundPoolThread::doLoadSample(int sampleID) {
     sp <Sample> sample = mSoundPool->findSample(sampleID);
     status_t status = -1;
     if (sample != 0) {
-        status = sample->doLoad();
+        sp<Sample> source = mSoundPool->findDecodedSample(sample);
+        if (source != 0) {
+            status = sample->shareDecodedData(source);
+        } else {
+            status = sample->doLoad();
+        }
     }
     mSoundPool->notify(SoundPoolEvent(SoundPoolEvent::SAMPLE_LOADED, sampleID, status));
 }
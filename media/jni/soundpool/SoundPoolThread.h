@@ -36,11 +36,12 @@ public:
 };
 
 /*
- * This class handles background requests from the SoundPool
+ * This class handles background requests from the SoundPool on a pool of
+ * numThreads threads, so several samples can be decoded at the same time.
  */
 class SoundPoolThread {
 public:
-    explicit SoundPoolThread(SoundPool* SoundPool);
+    SoundPoolThread(SoundPool* SoundPool, int numThreads);
     ~SoundPoolThread();
     void loadSample(int sampleID);
     void quit();
@@ -59,6 +60,7 @@ private:
     Vector<SoundPoolMsg>    mMsgQueue;
     SoundPool*              mSoundPool;
     bool                    mRunning;
+    int                     mNumThreads;
 };
 
 } // end namespace android
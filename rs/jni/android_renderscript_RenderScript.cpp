@@ -1991,6 +1991,61 @@ nScriptInvokeV(JNIEnv *_env, jobject _this, jlong con, jlong script, jint slot,
     _env->ReleaseByteArrayElements(data, ptr, JNI_ABORT);
 }
 
+// Reads the input allocations of a kernel launch into `in_allocs`, which must hold
+// RS_KERNEL_MAX_ARGUMENTS entries. The handles are copied out with GetLongArrayRegion(), so the
+// Java array is not pinned for the duration of the launch.
+static bool
+getKernelInputs(JNIEnv *_env, jlongArray ains, RsAllocation *in_allocs, jint *in_len)
+{
+    *in_len = _env->GetArrayLength(ains);
+    if (*in_len > (jint)RS_KERNEL_MAX_ARGUMENTS) {
+        ALOGE("Too many arguments in kernel launch.");
+        // TODO (b/20758983): Report back to Java and throw an exception
+        return false;
+    }
+
+    jlong in_handles[RS_KERNEL_MAX_ARGUMENTS];
+    _env->GetLongArrayRegion(ains, 0, *in_len, in_handles);
+    // Convert from 64-bit jlong types to the native pointer type.
+    for (int index = *in_len; --index >= 0;) {
+        in_allocs[index] = (RsAllocation)in_handles[index];
+    }
+    return true;
+}
+
+// Fills in the launch limits of `sc` from the six limits in `limits`.
+static bool
+getScriptCallLimits(JNIEnv *_env, jintArray limits, RsScriptCall *sc)
+{
+    jint limit_len = _env->GetArrayLength(limits);
+    if (limit_len < 6) {
+        ALOGE("Too few launch limits in kernel launch.");
+        // TODO (b/20758983): Report back to Java and throw an exception
+        return false;
+    }
+    assert(limit_len == 6);
+
+    jint limit[6];
+    _env->GetIntArrayRegion(limits, 0, 6, limit);
+
+    sc->xStart     = limit[0];
+    sc->xEnd       = limit[1];
+    sc->yStart     = limit[2];
+    sc->yEnd       = limit[3];
+    sc->zStart     = limit[4];
+    sc->zEnd       = limit[5];
+    sc->strategy   = RS_FOR_EACH_STRATEGY_DONT_CARE;
+    sc->arrayStart = 0;
+    sc->arrayEnd = 0;
+    sc->array2Start = 0;
+    sc->array2End = 0;
+    sc->array3Start = 0;
+    sc->array3End = 0;
+    sc->array4Start = 0;
+    sc->array4End = 0;
+    return true;
+}
+
 static void
 nScriptForEach(JNIEnv *_env, jobject _this, jlong con, jlong script, jint slot,
                jlongArray ains, jlong aout, jbyteArray params,
@@ -2000,41 +2055,28 @@ nScriptForEach(JNIEnv *_env, jobject _this, jlong con, jlong script, jint slot,
         ALOGD("nScriptForEach, con(%p), s(%p), slot(%i) ains(%p) aout(%" PRId64 ")", (RsContext)con, (void *)script, slot, ains, aout);
     }
 
-    jint   in_len = 0;
-    jlong *in_ptr = nullptr;
-
+    jint in_len = 0;
+    RsAllocation in_storage[RS_KERNEL_MAX_ARGUMENTS];
     RsAllocation *in_allocs = nullptr;
 
     if (ains != nullptr) {
-        in_len = _env->GetArrayLength(ains);
-        if (in_len > (jint)RS_KERNEL_MAX_ARGUMENTS) {
-            ALOGE("Too many arguments in kernel launch.");
-            // TODO (b/20758983): Report back to Java and throw an exception
+        if (!getKernelInputs(_env, ains, in_storage, &in_len)) {
             return;
         }
+        in_allocs = in_storage;
+    }
 
-        in_ptr = _env->GetLongArrayElements(ains, nullptr);
-        if (in_ptr == nullptr) {
-            ALOGE("Failed to get Java array elements");
+    RsScriptCall sc, *sca = nullptr;
+    uint32_t sc_size = 0;
+
+    if (limits != nullptr) {
+        if (!getScriptCallLimits(_env, limits, &sc)) {
             return;
         }
 
-        if (sizeof(RsAllocation) == sizeof(jlong)) {
-            in_allocs = (RsAllocation*)in_ptr;
-        } else {
-            // Convert from 64-bit jlong types to the native pointer type.
-
-            in_allocs = (RsAllocation*)alloca(in_len * sizeof(RsAllocation));
-            if (in_allocs == nullptr) {
-                ALOGE("Failed launching kernel for lack of memory.");
-                _env->ReleaseLongArrayElements(ains, in_ptr, JNI_ABORT);
-                return;
-            }
-
-            for (int index = in_len; --index >= 0;) {
-                in_allocs[index] = (RsAllocation)in_ptr[index];
-            }
-        }
+        sca = &sc;
+        // sc_size is required, but unused, by the runtime and drivers.
+        sc_size = sizeof(sc);
     }
 
     jint   param_len = 0;
@@ -2049,59 +2091,13 @@ nScriptForEach(JNIEnv *_env, jobject _this, jlong con, jlong script, jint slot,
         }
     }
 
-    RsScriptCall sc, *sca = nullptr;
-    uint32_t sc_size = 0;
-
-    jint  limit_len = 0;
-    jint *limit_ptr = nullptr;
-
-    if (limits != nullptr) {
-        limit_len = _env->GetArrayLength(limits);
-        limit_ptr = _env->GetIntArrayElements(limits, nullptr);
-        if (limit_ptr == nullptr) {
-            ALOGE("Failed to get Java array elements");
-            return;
-        }
-
-        assert(limit_len == 6);
-        UNUSED(limit_len);  // As the assert might not be compiled.
-
-        sc.xStart     = limit_ptr[0];
-        sc.xEnd       = limit_ptr[1];
-        sc.yStart     = limit_ptr[2];
-        sc.yEnd       = limit_ptr[3];
-        sc.zStart     = limit_ptr[4];
-        sc.zEnd       = limit_ptr[5];
-        sc.strategy   = RS_FOR_EACH_STRATEGY_DONT_CARE;
-        sc.arrayStart = 0;
-        sc.arrayEnd = 0;
-        sc.array2Start = 0;
-        sc.array2End = 0;
-        sc.array3Start = 0;
-        sc.array3End = 0;
-        sc.array4Start = 0;
-        sc.array4End = 0;
-
-        sca = &sc;
-        // sc_size is required, but unused, by the runtime and drivers.
-        sc_size = sizeof(sc);
-    }
-
     rsScriptForEachMulti((RsContext)con, (RsScript)script, slot,
                          in_allocs, in_len, (RsAllocation)aout,
                          param_ptr, param_len, sca, sc_size);
 
-    if (ains != nullptr) {
-        _env->ReleaseLongArrayElements(ains, in_ptr, JNI_ABORT);
-    }
-
     if (params != nullptr) {
         _env->ReleaseByteArrayElements(params, param_ptr, JNI_ABORT);
     }
-
-    if (limits != nullptr) {
-        _env->ReleaseIntArrayElements(limits, limit_ptr, JNI_ABORT);
-    }
 }
 
 static void
@@ -2117,73 +2113,21 @@ nScriptReduce(JNIEnv *_env, jobject _this, jlong con, jlong script, jint slot,
         // TODO (b/20758983): Report back to Java and throw an exception
         return;
     }
-    jint in_len = _env->GetArrayLength(ains);
-    if (in_len > (jint)RS_KERNEL_MAX_ARGUMENTS) {
-        ALOGE("Too many arguments in kernel launch.");
-        // TODO (b/20758983): Report back to Java and throw an exception
-        return;
-    }
 
-    jlong *in_ptr = _env->GetLongArrayElements(ains, nullptr);
-    if (in_ptr == nullptr) {
-        ALOGE("Failed to get Java array elements");
-        // TODO (b/20758983): Report back to Java and throw an exception
+    jint in_len = 0;
+    RsAllocation in_allocs[RS_KERNEL_MAX_ARGUMENTS];
+    if (!getKernelInputs(_env, ains, in_allocs, &in_len)) {
         return;
     }
 
-    RsAllocation *in_allocs = nullptr;
-    if (sizeof(RsAllocation) == sizeof(jlong)) {
-        in_allocs = (RsAllocation*)in_ptr;
-    } else {
-        // Convert from 64-bit jlong types to the native pointer type.
-
-        in_allocs = (RsAllocation*)alloca(in_len * sizeof(RsAllocation));
-        if (in_allocs == nullptr) {
-            ALOGE("Failed launching kernel for lack of memory.");
-            // TODO (b/20758983): Report back to Java and throw an exception
-            _env->ReleaseLongArrayElements(ains, in_ptr, JNI_ABORT);
-            return;
-        }
-
-        for (int index = in_len; --index >= 0;) {
-            in_allocs[index] = (RsAllocation)in_ptr[index];
-        }
-    }
-
     RsScriptCall sc, *sca = nullptr;
     uint32_t sc_size = 0;
 
-    jint  limit_len = 0;
-    jint *limit_ptr = nullptr;
-
     if (limits != nullptr) {
-        limit_len = _env->GetArrayLength(limits);
-        limit_ptr = _env->GetIntArrayElements(limits, nullptr);
-        if (limit_ptr == nullptr) {
-            ALOGE("Failed to get Java array elements");
-            // TODO (b/20758983): Report back to Java and throw an exception
+        if (!getScriptCallLimits(_env, limits, &sc)) {
             return;
         }
 
-        assert(limit_len == 6);
-        UNUSED(limit_len);  // As the assert might not be compiled.
-
-        sc.xStart     = limit_ptr[0];
-        sc.xEnd       = limit_ptr[1];
-        sc.yStart     = limit_ptr[2];
-        sc.yEnd       = limit_ptr[3];
-        sc.zStart     = limit_ptr[4];
-        sc.zEnd       = limit_ptr[5];
-        sc.strategy   = RS_FOR_EACH_STRATEGY_DONT_CARE;
-        sc.arrayStart = 0;
-        sc.arrayEnd = 0;
-        sc.array2Start = 0;
-        sc.array2End = 0;
-        sc.array3Start = 0;
-        sc.array3End = 0;
-        sc.array4Start = 0;
-        sc.array4End = 0;
-
         sca = &sc;
         sc_size = sizeof(sc);
     }
@@ -2191,12 +2135,6 @@ nScriptReduce(JNIEnv *_env, jobject _this, jlong con, jlong script, jint slot,
     rsScriptReduce((RsContext)con, (RsScript)script, slot,
                    in_allocs, in_len, (RsAllocation)aout,
                    sca, sc_size);
-
-    _env->ReleaseLongArrayElements(ains, in_ptr, JNI_ABORT);
-
-    if (limits != nullptr) {
-        _env->ReleaseIntArrayElements(limits, limit_ptr, JNI_ABORT);
-    }
 }
 
 // -----------------------------------
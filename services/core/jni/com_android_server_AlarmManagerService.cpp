@@ -41,6 +41,7 @@
 
 #include <array>
 #include <memory>
+#include <mutex>
 
 namespace android {
 
@@ -69,13 +70,23 @@ static const clockid_t android_alarm_to_clockid[N_ANDROID_TIMERFDS] = {
     CLOCK_REALTIME,
 };
 
+/* Clocks the alarm deadlines are compared against, the alarm clocks only
+   differ from these in waking the device up */
+static const clockid_t android_alarm_to_base_clockid[ANDROID_ALARM_TYPE_COUNT] = {
+    CLOCK_REALTIME,
+    CLOCK_REALTIME,
+    CLOCK_BOOTTIME,
+    CLOCK_BOOTTIME,
+    CLOCK_MONOTONIC,
+};
+
 typedef std::array<int, N_ANDROID_TIMERFDS> TimerFds;
 
 class AlarmImpl
 {
 public:
     AlarmImpl(const TimerFds &fds, int epollfd, int rtc_id) :
-        fds{fds}, epollfd{epollfd}, rtc_id{rtc_id} { }
+        fds{fds}, epollfd{epollfd}, rtc_id{rtc_id}, armed{} { }
     ~AlarmImpl();
 
     int set(int type, struct timespec *ts);
@@ -83,11 +94,29 @@ public:
     int waitForAlarm();
 
 private:
+    struct ArmedTimer {
+        bool armed;
+        struct timespec deadline;
+    };
+
+    int collectExpired(int result);
+
     const TimerFds fds;
     const int epollfd;
     const int rtc_id;
+
+    /* Deadline each alarm timerfd is armed with, until its expiration is read.
+       Guarded by lock, set() and waitForAlarm() run on different threads. */
+    std::mutex lock;
+    std::array<ArmedTimer, ANDROID_ALARM_TYPE_COUNT> armed;
 };
 
+static bool timespec_reached(const struct timespec &now, const struct timespec &deadline)
+{
+    return now.tv_sec > deadline.tv_sec ||
+            (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec);
+}
+
 AlarmImpl::~AlarmImpl()
 {
     for (auto fd : fds) {
@@ -100,7 +129,8 @@ AlarmImpl::~AlarmImpl()
 
 int AlarmImpl::set(int type, struct timespec *ts)
 {
-    if (static_cast<size_t>(type) > ANDROID_ALARM_TYPE_COUNT) {
+    /* The last timerfd only watches for RTC changes and must stay disarmed */
+    if (static_cast<size_t>(type) >= ANDROID_ALARM_TYPE_COUNT) {
         errno = EINVAL;
         return -1;
     }
@@ -111,11 +141,23 @@ int AlarmImpl::set(int type, struct timespec *ts)
     /* timerfd interprets 0 = disarm, so replace with a practically
        equivalent deadline of 1 ns */
 
+    std::lock_guard<std::mutex> guard(lock);
+    ArmedTimer &timer = armed[type];
+    /* Already armed with this deadline, or expired on it and not read yet,
+       either way rearming wouldn't change when the alarm is reported */
+    if (timer.armed && timer.deadline.tv_sec == ts->tv_sec &&
+            timer.deadline.tv_nsec == ts->tv_nsec) {
+        return 0;
+    }
+
     struct itimerspec spec;
     memset(&spec, 0, sizeof(spec));
     memcpy(&spec.it_value, ts, sizeof(spec.it_value));
 
-    return timerfd_settime(fds[type], TFD_TIMER_ABSTIME, &spec, NULL);
+    int res = timerfd_settime(fds[type], TFD_TIMER_ABSTIME, &spec, NULL);
+    timer.armed = res == 0;
+    timer.deadline = *ts;
+    return res;
 }
 
 int AlarmImpl::setTime(struct timeval *tv)
@@ -178,6 +220,7 @@ int AlarmImpl::waitForAlarm()
         return nevents;
     }
 
+    std::lock_guard<std::mutex> guard(lock);
     int result = 0;
     for (int i = 0; i < nevents; i++) {
         uint32_t alarm_idx = events[i].data.u32;
@@ -186,11 +229,43 @@ int AlarmImpl::waitForAlarm()
         if (err < 0) {
             if (alarm_idx == ANDROID_ALARM_TYPE_COUNT && errno == ECANCELED) {
                 result |= ANDROID_ALARM_TIME_CHANGE_MASK;
+            } else if (errno == EAGAIN) {
+                /* rearmed to a later deadline since epoll reported it */
+                continue;
             } else {
                 return err;
             }
         } else {
             result |= (1 << alarm_idx);
+            armed[alarm_idx].armed = false;
+        }
+    }
+
+    return collectExpired(result);
+}
+
+/* Adds the alarms that expired after epoll_wait() collected its events, so
+   alarms of different types due at about the same time are reported in one
+   upcall instead of waking the alarm thread again right after this one. Only
+   the timerfds whose deadline has passed are read. Must be called with lock
+   held. */
+int AlarmImpl::collectExpired(int result)
+{
+    for (size_t i = 0; i < ANDROID_ALARM_TYPE_COUNT; i++) {
+        if (!armed[i].armed || (result & (1 << i))) {
+            continue;
+        }
+
+        struct timespec now;
+        if (clock_gettime(android_alarm_to_base_clockid[i], &now) < 0 ||
+                !timespec_reached(now, armed[i].deadline)) {
+            continue;
+        }
+
+        uint64_t unused;
+        if (read(fds[i], &unused, sizeof(unused)) == sizeof(unused)) {
+            result |= (1 << i);
+            armed[i].armed = false;
         }
     }
 
@@ -337,7 +412,9 @@ static jlong android_server_AlarmManagerService_init(JNIEnv*, jobject)
     }
 
     for (size_t i = 0; i < fds.size(); i++) {
-        fds[i] = timerfd_create(android_alarm_to_clockid[i], 0);
+        /* Nonblocking, the alarm timers are read whenever their deadline
+           passed and a rearm may have raced with that */
+        fds[i] = timerfd_create(android_alarm_to_clockid[i], TFD_NONBLOCK);
         if (fds[i] < 0) {
             log_timerfd_create_error(android_alarm_to_clockid[i]);
             close(epollfd);
@@ -53,9 +53,13 @@ namespace android
 
 #define LAST_RESUME_REASON "/sys/kernel/wakeup_reasons/last_resume_reason"
 #define MAX_REASON_SIZE 512
+// sysfs attributes never return more than a page
+#define MAX_RESUME_REASONS_SIZE 4096
 
 static bool wakeup_init = false;
 static sem_t wakeup_sem;
+// Kept open across wakeups, the file is reread from the start each time
+static int last_resume_reason_fd = -1;
 extern sp<IPower> gPowerHal;
 extern std::mutex gPowerHalMutex;
 extern bool getPowerHal();
@@ -105,20 +109,40 @@ static jint nativeWaitWakeup(JNIEnv *env, jobject clazz, jobject outBuf)
         return 0;
     }
 
-    FILE *fp = fopen(LAST_RESUME_REASON, "r");
-    if (fp == NULL) {
-        ALOGE("Failed to open %s", LAST_RESUME_REASON);
+    if (last_resume_reason_fd < 0) {
+        last_resume_reason_fd = open(LAST_RESUME_REASON, O_RDONLY | O_CLOEXEC);
+        if (last_resume_reason_fd < 0) {
+            ALOGE("Failed to open %s", LAST_RESUME_REASON);
+            return -1;
+        }
+    }
+
+    char reasons[MAX_RESUME_REASONS_SIZE + 1];
+    ssize_t reasonslen = TEMP_FAILURE_RETRY(pread(last_resume_reason_fd, reasons,
+            MAX_RESUME_REASONS_SIZE, 0));
+    if (reasonslen < 0) {
+        ALOGE("Failed to read %s", LAST_RESUME_REASON);
         return -1;
     }
+    reasons[reasonslen] = 0;
 
     char* mergedreason = (char*)env->GetDirectBufferAddress(outBuf);
     int remainreasonlen = (int)env->GetDirectBufferCapacity(outBuf);
 
     ALOGV("Reading wakeup reasons");
     char* mergedreasonpos = mergedreason;
-    char reasonline[128];
+    char* nextline;
     int i = 0;
-    while (fgets(reasonline, sizeof(reasonline), fp) != NULL) {
+    for (char* reasonline = reasons; *reasonline != 0; reasonline = nextline) {
+        // Chop newline at end.
+        char* newline = strchr(reasonline, '\n');
+        if (newline != NULL) {
+            *newline = 0;
+            nextline = newline + 1;
+        } else {
+            nextline = reasonline + strlen(reasonline);
+        }
+
         char* pos = reasonline;
         char* endPos;
         int len;
@@ -147,21 +171,11 @@ static jint nativeWaitWakeup(JNIEnv *env, jobject clazz, jobject outBuf)
             remainreasonlen -= len;
         }
 
-        // Skip whitespace; rest of the buffer is the reason string.
+        // Skip whitespace; rest of the line is the reason string.
         while (*pos == ' ') {
             pos++;
         }
 
-        // Chop newline at end.
-        char* endpos = pos;
-        while (*endpos != 0) {
-            if (*endpos == '\n') {
-                *endpos = 0;
-                break;
-            }
-            endpos++;
-        }
-
         len = snprintf(mergedreasonpos, remainreasonlen, ":%s", pos);
         if (len >= 0 && len < remainreasonlen) {
             mergedreasonpos += len;
@@ -175,24 +189,20 @@ static jint nativeWaitWakeup(JNIEnv *env, jobject clazz, jobject outBuf)
         *mergedreasonpos = 0;
     }
 
-    if (fclose(fp) != 0) {
-        ALOGE("Failed to close %s", LAST_RESUME_REASON);
-        return -1;
-    }
     return mergedreasonpos - mergedreason;
 }
 
 static jint getPlatformLowPowerStats(JNIEnv* env, jobject /* clazz */, jobject outBuf) {
-    char *output = (char*)env->GetDirectBufferAddress(outBuf);
-    char *offset = output;
-    int remaining = (int)env->GetDirectBufferCapacity(outBuf);
-    int total_added = -1;
-
     if (outBuf == NULL) {
         jniThrowException(env, "java/lang/NullPointerException", "null argument");
         return -1;
     }
 
+    char *output = (char*)env->GetDirectBufferAddress(outBuf);
+    char *offset = output;
+    int remaining = (int)env->GetDirectBufferCapacity(outBuf);
+    int total_added = -1;
+
     {
         std::lock_guard<std::mutex> lock(gPowerHalMutex);
         if (!getPowerHal()) {
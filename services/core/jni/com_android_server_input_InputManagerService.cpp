@@ -30,6 +30,8 @@
 #include <atomic>
 #include <cinttypes>
 #include <limits.h>
+#include <map>
+#include <string>
 #include <android_runtime/AndroidRuntime.h>
 #include <android_runtime/Log.h>
 
@@ -175,6 +177,112 @@ enum {
 };
 
 
+// --- InputLatencyStats ---
+
+/*
+ * Histograms of how late events reach the policy, and of how long the policy takes with them.
+ * The delays are measured from the event time, which the kernel stamps when the event is
+ * read from the device, so they include the InputReader and InputDispatcher queues. Injected
+ * events carry arbitrary times and are not recorded.
+ */
+class InputLatencyStats {
+public:
+    enum Stage {
+        // Event time to the policy queueing the event, on the InputReader thread
+        KEY_QUEUEING,
+        MOTION_QUEUEING,
+        // Time spent in the Java interceptKeyBeforeQueueing policy
+        KEY_QUEUEING_POLICY,
+        // Time spent in the Java interceptKeyBeforeDispatching policy
+        KEY_DISPATCH_POLICY,
+        STAGE_COUNT
+    };
+
+    void record(Stage stage, nsecs_t duration) {
+        AutoMutex _l(mLock);
+        mStages[stage].add(duration);
+    }
+
+    // Event time to the policy seeing the key dispatched to the window
+    void recordKeyDispatch(const sp<InputWindowHandle>& inputWindowHandle, nsecs_t duration) {
+        std::string name = inputWindowHandle != NULL
+                ? inputWindowHandle->getName().string() : "(no window)";
+        AutoMutex _l(mLock);
+        auto it = mKeyDispatchByWindow.find(name);
+        if (it == mKeyDispatchByWindow.end()) {
+            if (mKeyDispatchByWindow.size() >= MAX_WINDOWS) {
+                name = "(other)";
+            }
+            it = mKeyDispatchByWindow.emplace(name, Histogram()).first;
+        }
+        it->second.add(duration);
+    }
+
+    void dump(String8& dump) {
+        static const char* kStageNames[STAGE_COUNT] = {
+            "Key queueing delay", "Motion queueing delay",
+            "Key queueing policy", "Key dispatch policy",
+        };
+        AutoMutex _l(mLock);
+        dump.append(INDENT "Latency (count, mean, max, buckets <1 <2 <4 <8 <16 <32 <64 "
+                ">=64 ms):\n");
+        for (size_t i = 0; i < STAGE_COUNT; i++) {
+            mStages[i].dump(dump, kStageNames[i]);
+        }
+        dump.append(INDENT INDENT "Key dispatch delay by window:\n");
+        for (const auto& entry : mKeyDispatchByWindow) {
+            entry.second.dump(dump, entry.first.c_str(), INDENT INDENT INDENT);
+        }
+    }
+
+private:
+    static const size_t MAX_WINDOWS = 32;
+    static const size_t BUCKET_COUNT = 8;
+
+    struct Histogram {
+        uint64_t count = 0;
+        nsecs_t total = 0;
+        nsecs_t max = 0;
+        // Powers of two in milliseconds, the last bucket is unbounded
+        uint32_t buckets[BUCKET_COUNT] = {};
+
+        void add(nsecs_t duration) {
+            if (duration < 0) {
+                duration = 0;
+            }
+            count++;
+            total += duration;
+            if (duration > max) {
+                max = duration;
+            }
+            size_t bucket = 0;
+            for (nsecs_t limit = milliseconds_to_nanoseconds(1);
+                    bucket < BUCKET_COUNT - 1 && duration >= limit; limit *= 2) {
+                bucket++;
+            }
+            buckets[bucket]++;
+        }
+
+        void dump(String8& dump, const char* name,
+                const char* indent = INDENT INDENT) const {
+            dump.appendFormat("%s%s: %" PRIu64, indent, name, count);
+            if (count) {
+                dump.appendFormat(", %.2fms, %.2fms,", total / 1000000.0 / count,
+                        max / 1000000.0);
+                for (size_t i = 0; i < BUCKET_COUNT; i++) {
+                    dump.appendFormat(" %" PRIu32, buckets[i]);
+                }
+            }
+            dump.append("\n");
+        }
+    };
+
+    Mutex mLock;
+    Histogram mStages[STAGE_COUNT];
+    std::map<std::string, Histogram> mKeyDispatchByWindow;
+};
+
+
 // --- NativeInputManager ---
 
 class NativeInputManager : public virtual RefBase,
@@ -292,6 +400,8 @@ private:
 
     std::atomic<bool> mInteractive;
 
+    InputLatencyStats mLatencyStats;
+
     void updateInactivityTimeoutLocked(const sp<PointerController>& controller);
     void handleInterceptActions(jint wmActions, nsecs_t when, uint32_t& policyFlags);
     void ensureSpriteControllerLocked();
@@ -356,6 +466,10 @@ void NativeInputManager::dump(String8& dump) {
 
     mInputManager->getDispatcher()->dump(dump);
     dump.append("\n");
+
+    dump.append("Input Policy Latency:\n");
+    mLatencyStats.dump(dump);
+    dump.append("\n");
 }
 
 bool NativeInputManager::checkAndClearExceptionFromCallback(JNIEnv* env, const char* methodName) {
@@ -947,6 +1061,10 @@ void NativeInputManager::interceptKeyBeforeQueueing(const KeyEvent* keyEvent,
     }
     if ((policyFlags & POLICY_FLAG_TRUSTED)) {
         nsecs_t when = keyEvent->getEventTime();
+        nsecs_t policyStart = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (!(policyFlags & POLICY_FLAG_INJECTED)) {
+            mLatencyStats.record(InputLatencyStats::KEY_QUEUEING, policyStart - when);
+        }
         JNIEnv* env = jniEnv();
         jobject keyEventObj = android_view_KeyEvent_fromNative(env, keyEvent);
         jint wmActions;
@@ -957,6 +1075,8 @@ void NativeInputManager::interceptKeyBeforeQueueing(const KeyEvent* keyEvent,
             if (checkAndClearExceptionFromCallback(env, "interceptKeyBeforeQueueing")) {
                 wmActions = 0;
             }
+            mLatencyStats.record(InputLatencyStats::KEY_QUEUEING_POLICY,
+                    systemTime(SYSTEM_TIME_MONOTONIC) - policyStart);
             android_view_KeyEvent_recycle(env, keyEventObj);
             env->DeleteLocalRef(keyEventObj);
         } else {
@@ -983,6 +1103,8 @@ void NativeInputManager::interceptMotionBeforeQueueing(nsecs_t when, uint32_t& p
         policyFlags |= POLICY_FLAG_INTERACTIVE;
     }
     if ((policyFlags & POLICY_FLAG_TRUSTED) && !(policyFlags & POLICY_FLAG_INJECTED)) {
+        mLatencyStats.record(InputLatencyStats::MOTION_QUEUEING,
+                systemTime(SYSTEM_TIME_MONOTONIC) - when);
         if (policyFlags & POLICY_FLAG_INTERACTIVE) {
             policyFlags |= POLICY_FLAG_PASS_TO_USER;
         } else {
@@ -1024,6 +1146,11 @@ nsecs_t NativeInputManager::interceptKeyBeforeDispatching(
     //   handle the HOME key and the like.
     nsecs_t result = 0;
     if (policyFlags & POLICY_FLAG_TRUSTED) {
+        nsecs_t policyStart = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (!(policyFlags & POLICY_FLAG_INJECTED)) {
+            mLatencyStats.recordKeyDispatch(inputWindowHandle,
+                    policyStart - keyEvent->getEventTime());
+        }
         JNIEnv* env = jniEnv();
 
         // Note: inputWindowHandle may be null.
@@ -1034,6 +1161,8 @@ nsecs_t NativeInputManager::interceptKeyBeforeDispatching(
                     gServiceClassInfo.interceptKeyBeforeDispatching,
                     inputWindowHandleObj, keyEventObj, policyFlags);
             bool error = checkAndClearExceptionFromCallback(env, "interceptKeyBeforeDispatching");
+            mLatencyStats.record(InputLatencyStats::KEY_DISPATCH_POLICY,
+                    systemTime(SYSTEM_TIME_MONOTONIC) - policyStart);
             android_view_KeyEvent_recycle(env, keyEventObj);
             env->DeleteLocalRef(keyEventObj);
             if (!error) {
@@ -35,6 +35,7 @@
 #include <pthread.h>
 #include <string.h>
 #include <cinttypes>
+#include <type_traits>
 
 static jobject mCallbacksObj = NULL;
 
@@ -60,6 +61,18 @@ static jmethodID method_reportMeasurementData;
 static jmethodID method_reportNavigationMessages;
 static jmethodID method_reportLocationBatch;
 
+static jclass class_location;
+static jclass class_gnssMeasurement;
+static jclass class_gnssClock;
+static jclass class_gnssMeasurementsEvent;
+static jclass class_gnssNavigationMessage;
+static jmethodID method_locationCtor;
+static jmethodID method_gnssMeasurementCtor;
+static jmethodID method_gnssClockCtor;
+static jmethodID method_gnssMeasurementsEventCtor;
+static jmethodID method_gnssNavigationMessageCtor;
+static jstring sGpsProviderName;
+
 /*
  * Save a pointer to JavaVm to attach/detach threads executing
  * callback methods that need to make JNI calls.
@@ -131,37 +144,34 @@ namespace android {
 template<class T>
 class JavaMethodHelper {
  public:
-    // Helper function to call setter on a Java object.
-    static void callJavaMethod(
+    // Helper function to look up a setter taking a T on a Java class.
+    static jmethodID getMethodID(
            JNIEnv* env,
            jclass clazz,
-           jobject object,
-           const char* method_name,
-           T value);
+           const char* method_name);
 
  private:
     static const char *const signature_;
 };
 
 template<class T>
-void JavaMethodHelper<T>::callJavaMethod(
+jmethodID JavaMethodHelper<T>::getMethodID(
         JNIEnv* env,
         jclass clazz,
-        jobject object,
-        const char* method_name,
-        T value) {
-    jmethodID method = env->GetMethodID(clazz, method_name, signature_);
-    env->CallVoidMethod(object, method, value);
+        const char* method_name) {
+    return env->GetMethodID(clazz, method_name, signature_);
 }
 
 class JavaObject {
  public:
-    JavaObject(JNIEnv* env, const char* class_name);
-    JavaObject(JNIEnv* env, const char* class_name, const char * sz_arg_1);
-    virtual ~JavaObject();
+    // clazz must be a global reference
+    JavaObject(JNIEnv* env, jclass clazz, jmethodID ctor);
+    JavaObject(JNIEnv* env, jclass clazz, jmethodID ctor, jstring arg_1);
 
     template<class T>
-    void callSetter(const char* method_name, T value);
+    jmethodID getSetter(const char* method_name);
+    template<class T>
+    void callSetter(jmethodID method, T value);
     template<class T>
     void callSetter(const char* method_name, T* value, size_t size);
     jobject get();
@@ -172,26 +182,24 @@ class JavaObject {
     jobject object_;
 };
 
-JavaObject::JavaObject(JNIEnv* env, const char* class_name) : env_(env) {
-    clazz_ = env_->FindClass(class_name);
-    jmethodID ctor = env->GetMethodID(clazz_, "<init>", "()V");
+JavaObject::JavaObject(JNIEnv* env, jclass clazz, jmethodID ctor)
+        : env_(env), clazz_(clazz) {
     object_ = env_->NewObject(clazz_, ctor);
 }
 
-JavaObject::JavaObject(JNIEnv* env, const char* class_name, const char * sz_arg_1) : env_(env) {
-    clazz_ = env_->FindClass(class_name);
-    jmethodID ctor = env->GetMethodID(clazz_, "<init>", "(Ljava/lang/String;)V");
-    object_ = env_->NewObject(clazz_, ctor, env->NewStringUTF(sz_arg_1));
+JavaObject::JavaObject(JNIEnv* env, jclass clazz, jmethodID ctor, jstring arg_1)
+        : env_(env), clazz_(clazz) {
+    object_ = env_->NewObject(clazz_, ctor, arg_1);
 }
 
-JavaObject::~JavaObject() {
-    env_->DeleteLocalRef(clazz_);
+template<class T>
+jmethodID JavaObject::getSetter(const char* method_name) {
+    return JavaMethodHelper<T>::getMethodID(env_, clazz_, method_name);
 }
 
 template<class T>
-void JavaObject::callSetter(const char* method_name, T value) {
-    JavaMethodHelper<T>::callJavaMethod(
-            env_, clazz_, object_, method_name, value);
+void JavaObject::callSetter(jmethodID method, T value) {
+    env_->CallVoidMethod(object_, method, value);
 }
 
 template<>
@@ -233,7 +241,14 @@ const char *const JavaMethodHelper<double>::signature_ = "(D)V";
 template<>
 const char *const JavaMethodHelper<bool>::signature_ = "(Z)V";
 
-#define SET(setter, value) object.callSetter("set" # setter, (value))
+// Measurements and locations are translated field by field several times a second, so each
+// call site looks its setter up only once. The framework classes are never unloaded.
+#define SET(setter, value)                                                           \
+    do {                                                                             \
+        static const jmethodID sSetter =                                             \
+                object.getSetter<std::decay<decltype(value)>::type>("set" # setter); \
+        object.callSetter(sSetter, (value));                                         \
+    } while (0)
 
 static inline jboolean boolToJbool(bool value) {
     return value ? JNI_TRUE : JNI_FALSE;
@@ -304,7 +319,7 @@ static JNIEnv* getJniEnv() {
 }
 
 static jobject translateLocation(JNIEnv* env, const hardware::gnss::V1_0::GnssLocation& location) {
-    JavaObject object(env, "android/location/Location", "gps");
+    JavaObject object(env, class_location, method_locationCtor, sGpsProviderName);
 
     uint16_t flags = static_cast<uint32_t>(location.gnssLocationFlags);
     if (flags & hardware::gnss::V1_0::GnssLocationFlags::HAS_LAT_LONG) {
@@ -619,7 +634,7 @@ Return<void> GnssNavigationMessageCallback::gnssNavigationMessageCb(
       return Void();
     }
 
-    JavaObject object(env, "android/location/GnssNavigationMessage");
+    JavaObject object(env, class_gnssNavigationMessage, method_gnssNavigationMessageCtor);
     SET(Type, static_cast<int32_t>(message.type));
     SET(Svid, static_cast<int32_t>(message.svid));
     SET(MessageId, static_cast<int32_t>(message.messageId));
@@ -674,7 +689,7 @@ Return<void> GnssMeasurementCallback::GnssMeasurementCb(
 
 jobject GnssMeasurementCallback::translateGnssMeasurement(
         JNIEnv* env, const IGnssMeasurementCallback::GnssMeasurement* measurement) {
-    JavaObject object(env, "android/location/GnssMeasurement");
+    JavaObject object(env, class_gnssMeasurement, method_gnssMeasurementCtor);
 
     uint32_t flags = static_cast<uint32_t>(measurement->flags);
 
@@ -722,7 +737,7 @@ jobject GnssMeasurementCallback::translateGnssMeasurement(
 
 jobject GnssMeasurementCallback::translateGnssClock(
        JNIEnv* env, const IGnssMeasurementCallback::GnssClock* clock) {
-    JavaObject object(env, "android/location/GnssClock");
+    JavaObject object(env, class_gnssClock, method_gnssClockCtor);
 
     uint32_t flags = static_cast<uint32_t>(clock->gnssClockFlags);
     if (flags & static_cast<uint32_t>(GnssClockFlags::HAS_LEAP_SECOND)) {
@@ -766,10 +781,9 @@ jobjectArray GnssMeasurementCallback::translateGnssMeasurements(JNIEnv* env,
         return NULL;
     }
 
-    jclass gnssMeasurementClass = env->FindClass("android/location/GnssMeasurement");
     jobjectArray gnssMeasurementArray = env->NewObjectArray(
             count,
-            gnssMeasurementClass,
+            class_gnssMeasurement,
             NULL /* initialElement */);
 
     for (uint16_t i = 0; i < count; ++i) {
@@ -780,29 +794,19 @@ jobjectArray GnssMeasurementCallback::translateGnssMeasurements(JNIEnv* env,
         env->DeleteLocalRef(gnssMeasurement);
     }
 
-    env->DeleteLocalRef(gnssMeasurementClass);
     return gnssMeasurementArray;
 }
 
 void GnssMeasurementCallback::setMeasurementData(JNIEnv* env, jobject clock,
                              jobjectArray measurementArray) {
-    jclass gnssMeasurementsEventClass =
-            env->FindClass("android/location/GnssMeasurementsEvent");
-    jmethodID gnssMeasurementsEventCtor =
-            env->GetMethodID(
-                    gnssMeasurementsEventClass,
-                    "<init>",
-                    "(Landroid/location/GnssClock;[Landroid/location/GnssMeasurement;)V");
-
-    jobject gnssMeasurementsEvent = env->NewObject(gnssMeasurementsEventClass,
-                                                   gnssMeasurementsEventCtor,
+    jobject gnssMeasurementsEvent = env->NewObject(class_gnssMeasurementsEvent,
+                                                   method_gnssMeasurementsEventCtor,
                                                    clock,
                                                    measurementArray);
 
     env->CallVoidMethod(mCallbacksObj, method_reportMeasurementData,
                       gnssMeasurementsEvent);
     checkAndClearExceptionFromCallback(env, __FUNCTION__);
-    env->DeleteLocalRef(gnssMeasurementsEventClass);
     env->DeleteLocalRef(gnssMeasurementsEvent);
 }
 
@@ -985,7 +989,7 @@ Return<void> GnssBatchingCallback::gnssLocationBatchCb(
     JNIEnv* env = getJniEnv();
 
     jobjectArray jLocations = env->NewObjectArray(locations.size(),
-            env->FindClass("android/location/Location"), nullptr);
+            class_location, nullptr);
 
     for (uint16_t i = 0; i < locations.size(); ++i) {
         jobject jLocation = translateLocation(env, locations[i]);
@@ -1001,6 +1005,13 @@ Return<void> GnssBatchingCallback::gnssLocationBatchCb(
     return Void();
 }
 
+static jclass findClassGlobalRef(JNIEnv* env, const char* name) {
+    jclass clazz = env->FindClass(name);
+    jclass globalRef = static_cast<jclass>(env->NewGlobalRef(clazz));
+    env->DeleteLocalRef(clazz);
+    return globalRef;
+}
+
 static void android_location_GnssLocationProvider_class_init_native(JNIEnv* env, jclass clazz) {
     method_reportLocation = env->GetMethodID(clazz, "reportLocation",
             "(ZLandroid/location/Location;)V");
@@ -1041,6 +1052,25 @@ static void android_location_GnssLocationProvider_class_init_native(JNIEnv* env,
             "reportLocationBatch",
             "([Landroid/location/Location;)V");
 
+    class_location = findClassGlobalRef(env, "android/location/Location");
+    method_locationCtor = env->GetMethodID(class_location, "<init>", "(Ljava/lang/String;)V");
+    class_gnssMeasurement = findClassGlobalRef(env, "android/location/GnssMeasurement");
+    method_gnssMeasurementCtor = env->GetMethodID(class_gnssMeasurement, "<init>", "()V");
+    class_gnssClock = findClassGlobalRef(env, "android/location/GnssClock");
+    method_gnssClockCtor = env->GetMethodID(class_gnssClock, "<init>", "()V");
+    class_gnssMeasurementsEvent = findClassGlobalRef(env, "android/location/GnssMeasurementsEvent");
+    method_gnssMeasurementsEventCtor = env->GetMethodID(
+            class_gnssMeasurementsEvent,
+            "<init>",
+            "(Landroid/location/GnssClock;[Landroid/location/GnssMeasurement;)V");
+    class_gnssNavigationMessage = findClassGlobalRef(env, "android/location/GnssNavigationMessage");
+    method_gnssNavigationMessageCtor = env->GetMethodID(
+            class_gnssNavigationMessage, "<init>", "()V");
+
+    jstring gpsProviderName = env->NewStringUTF("gps");
+    sGpsProviderName = static_cast<jstring>(env->NewGlobalRef(gpsProviderName));
+    env->DeleteLocalRef(gpsProviderName);
+
     /*
      * Save a pointer to JVM.
      */
@@ -1281,22 +1311,26 @@ enum ShiftWidth: uint8_t {
     CONSTELLATION_TYPE_SHIFT_WIDTH = 4
 };
 
+static constexpr size_t kMaxSvs =
+        static_cast<uint32_t>(android::hardware::gnss::V1_0::GnssMax::SVS_COUNT);
+
 static jint android_location_GnssLocationProvider_read_sv_status(JNIEnv* env, jobject /* obj */,
         jintArray svidWithFlagArray, jfloatArray cn0Array, jfloatArray elevArray,
         jfloatArray azumArray, jfloatArray carrierFreqArray) {
     /*
      * This method should only be called from within a call to reportSvStatus.
      */
-    jint* svidWithFlags = env->GetIntArrayElements(svidWithFlagArray, 0);
-    jfloat* cn0s = env->GetFloatArrayElements(cn0Array, 0);
-    jfloat* elev = env->GetFloatArrayElements(elevArray, 0);
-    jfloat* azim = env->GetFloatArrayElements(azumArray, 0);
-    jfloat* carrierFreq = env->GetFloatArrayElements(carrierFreqArray, 0);
+    const size_t count = GnssCallback::sGnssSvListSize;
+    jint svidWithFlags[kMaxSvs];
+    jfloat cn0s[kMaxSvs];
+    jfloat elev[kMaxSvs];
+    jfloat azim[kMaxSvs];
+    jfloat carrierFreq[kMaxSvs];
 
     /*
      * Read GNSS SV info.
      */
-    for (size_t i = 0; i < GnssCallback::sGnssSvListSize; ++i) {
+    for (size_t i = 0; i < count; ++i) {
         const IGnssCallback::GnssSvInfo& info = GnssCallback::sGnssSvList[i];
         svidWithFlags[i] = (info.svid << SVID_SHIFT_WIDTH) |
             (static_cast<uint32_t>(info.constellation) << CONSTELLATION_TYPE_SHIFT_WIDTH) |
@@ -1307,11 +1341,12 @@ static jint android_location_GnssLocationProvider_read_sv_status(JNIEnv* env, jo
         carrierFreq[i] = info.carrierFrequencyHz;
     }
 
-    env->ReleaseIntArrayElements(svidWithFlagArray, svidWithFlags, 0);
-    env->ReleaseFloatArrayElements(cn0Array, cn0s, 0);
-    env->ReleaseFloatArrayElements(elevArray, elev, 0);
-    env->ReleaseFloatArrayElements(azumArray, azim, 0);
-    env->ReleaseFloatArrayElements(carrierFreqArray, carrierFreq, 0);
+    // Only copy the satellites in view, the Java arrays are sized for the maximum
+    env->SetIntArrayRegion(svidWithFlagArray, 0, count, svidWithFlags);
+    env->SetFloatArrayRegion(cn0Array, 0, count, cn0s);
+    env->SetFloatArrayRegion(elevArray, 0, count, elev);
+    env->SetFloatArrayRegion(azumArray, 0, count, azim);
+    env->SetFloatArrayRegion(carrierFreqArray, 0, count, carrierFreq);
     return static_cast<jint>(GnssCallback::sGnssSvListSize);
 }
 
@@ -19,6 +19,17 @@
 #include "XMLNode.h"
 
 #include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#if !defined(_WIN32)
+#  include <unistd.h>
+#endif
 
 // STATUST: mingw does seem to redefine UNKNOWN_ERROR from our enum value, so a cast is necessary.
 
@@ -31,7 +42,8 @@
 // Set to true for noisy debug output.
 static const bool kIsDebug = false;
 
-// Number of threads to use for preprocessing images.
+// Minimum number of threads to use for preprocessing images. More are used on hosts with more
+// cores.
 static const size_t MAX_THREADS = 4;
 
 // ==========================================================================
@@ -361,17 +373,117 @@ private:
     volatile bool* mHasErrors;
 };
 
+static size_t getPreProcessThreadCount()
+{
+    size_t threads = MAX_THREADS;
+#if !defined(_WIN32)
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0 && (size_t) cores > threads) {
+        threads = (size_t) cores;
+    }
+#endif
+    return threads;
+}
+
+// Computes the CRC32 and size of the file at path. Returns false if it can't be read.
+static bool checksumFile(const String8& path, uLong* outCrc, size_t* outSize)
+{
+    FILE* fp = fopen(path.string(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    size_t size = 0;
+    unsigned char buffer[16384];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        crc = crc32(crc, buffer, count);
+        size += count;
+    }
+    const bool result = ferror(fp) == 0;
+    fclose(fp);
+
+    *outCrc = crc;
+    *outSize = size;
+    return result;
+}
+
+static bool filesHaveSameContents(const String8& pathA, const String8& pathB)
+{
+    FILE* fpA = fopen(pathA.string(), "rb");
+    FILE* fpB = fopen(pathB.string(), "rb");
+    bool same = fpA != NULL && fpB != NULL;
+    unsigned char bufferA[16384];
+    unsigned char bufferB[16384];
+    while (same) {
+        const size_t countA = fread(bufferA, 1, sizeof(bufferA), fpA);
+        const size_t countB = fread(bufferB, 1, sizeof(bufferB), fpB);
+        if (countA != countB || memcmp(bufferA, bufferB, countA) != 0) {
+            same = false;
+        } else if (countA == 0) {
+            same = ferror(fpA) == 0 && ferror(fpB) == 0;
+            break;
+        }
+    }
+    if (fpA != NULL) {
+        fclose(fpA);
+    }
+    if (fpB != NULL) {
+        fclose(fpB);
+    }
+    return same;
+}
+
+static bool isNinePatch(const sp<AaptFile>& file)
+{
+    return file->getPath().getBasePath().getPathExtension() == ".9";
+}
+
 static status_t preProcessImages(const Bundle* bundle, const sp<AaptAssets>& assets,
                           const sp<ResourceTypeSet>& set, const char* type)
 {
     volatile bool hasErrors = false;
     ssize_t res = NO_ERROR;
     if (bundle->getUseCrunchCache() == false) {
-        WorkQueue wq(MAX_THREADS, false);
+        // The same PNG often ships in several configurations. Only the first copy of each image is
+        // crunched, the others get its output once the queue finishes. Images are keyed by whether
+        // they are 9-patches, their size and CRC, and then compared in full.
+        typedef std::tuple<bool, size_t, uLong> ImageKey;
+        std::map<ImageKey, std::vector<sp<AaptFile> > > crunchedImages;
+        std::vector<std::pair<sp<AaptFile>, sp<AaptFile> > > duplicateImages;
+
+        WorkQueue wq(getPreProcessThreadCount(), false);
         ResourceDirIterator it(set, String8(type));
         while ((res=it.next()) == NO_ERROR) {
+            const sp<AaptFile>& file = it.getFile();
+            uLong crc;
+            size_t size;
+            if (file->getPath().getPathExtension() == ".png"
+                    && checksumFile(file->getSourceFile(), &crc, &size)) {
+                std::vector<sp<AaptFile> >& candidates =
+                        crunchedImages[ImageKey(isNinePatch(file), size, crc)];
+                sp<AaptFile> original;
+                for (const sp<AaptFile>& candidate : candidates) {
+                    if (filesHaveSameContents(candidate->getSourceFile(), file->getSourceFile())) {
+                        original = candidate;
+                        break;
+                    }
+                }
+                if (original != NULL) {
+                    if (bundle->getVerbose()) {
+                        printf("Reusing processed image %s for %s\n",
+                                original->getPrintableSource().string(),
+                                file->getPrintableSource().string());
+                    }
+                    duplicateImages.push_back(std::make_pair(file, original));
+                    continue;
+                }
+                candidates.push_back(file);
+            }
+
             PreProcessImageWorkUnit* w = new PreProcessImageWorkUnit(
-                    bundle, assets, it.getFile(), &hasErrors);
+                    bundle, assets, file, &hasErrors);
             status_t status = wq.schedule(w);
             if (status) {
                 fprintf(stderr, "preProcessImages failed: schedule() returned %d\n", status);
@@ -385,6 +497,16 @@ static status_t preProcessImages(const Bundle* bundle, const sp<AaptAssets>& ass
             fprintf(stderr, "preProcessImages failed: finish() returned %d\n", status);
             hasErrors = true;
         }
+
+        if (!hasErrors) {
+            for (const auto& duplicate : duplicateImages) {
+                const sp<AaptFile>& original = duplicate.second;
+                if (duplicate.first->writeData(original->getData(), original->getSize())
+                        != NO_ERROR) {
+                    hasErrors = true;
+                }
+            }
+        }
     }
     return (hasErrors || (res < NO_ERROR)) ? STATUST(UNKNOWN_ERROR) : NO_ERROR;
 }
@@ -20,6 +20,8 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "android-base/macros.h"
 #include "androidfw/StringPiece.h"
@@ -142,6 +144,36 @@ class SourcePathDiagnostics : public IDiagnostics {
   DISALLOW_COPY_AND_ASSIGN(SourcePathDiagnostics);
 };
 
+// Holds diagnostics until they can be replayed, in a deterministic order, to the real diagnostics.
+// Used by work that runs concurrently with other work.
+class BufferedDiagnostics : public IDiagnostics {
+ public:
+  BufferedDiagnostics() = default;
+
+  void Log(Level level, DiagMessageActual& actual_msg) override {
+    if (level != Level::Note) {
+      had_warnings_ = true;
+    }
+    messages_.push_back({level, actual_msg});
+  }
+
+  // Returns true if a warning or an error was logged.
+  bool HadWarnings() const { return had_warnings_; }
+
+  void Replay(IDiagnostics* diag) {
+    for (auto& message : messages_) {
+      diag->Log(message.first, message.second);
+    }
+    messages_.clear();
+  }
+
+ private:
+  std::vector<std::pair<Level, DiagMessageActual>> messages_;
+  bool had_warnings_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedDiagnostics);
+};
+
 }  // namespace aapt
 
 #endif /* AAPT_DIAGNOSTICS_H */
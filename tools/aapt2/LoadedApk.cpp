@@ -27,6 +27,17 @@ namespace aapt {
 
 std::unique_ptr<LoadedApk> LoadedApk::LoadApkFromPath(IAaptContext* context,
                                                       const android::StringPiece& path) {
+  std::unique_ptr<io::ZipFileCollection> apk;
+  std::unique_ptr<io::IData> data = OpenResourceTable(context, path, &apk);
+  if (!data) {
+    return {};
+  }
+  return LoadApkFromTable(context, path, std::move(apk), *data);
+}
+
+std::unique_ptr<io::IData> LoadedApk::OpenResourceTable(
+    IAaptContext* context, const android::StringPiece& path,
+    std::unique_ptr<io::ZipFileCollection>* out_apk) {
   Source source(path);
   std::string error;
   std::unique_ptr<io::ZipFileCollection> apk = io::ZipFileCollection::Create(path, &error);
@@ -46,9 +57,18 @@ std::unique_ptr<LoadedApk> LoadedApk::LoadApkFromPath(IAaptContext* context,
     context->GetDiagnostics()->Error(DiagMessage(source) << "could not open resources.arsc");
     return {};
   }
+  *out_apk = std::move(apk);
+  return data;
+}
 
+std::unique_ptr<LoadedApk> LoadedApk::LoadApkFromTable(IAaptContext* context,
+                                                       const android::StringPiece& path,
+                                                       std::unique_ptr<io::ZipFileCollection> apk,
+                                                       const io::IData& table_data) {
+  Source source(path);
   std::unique_ptr<ResourceTable> table = util::make_unique<ResourceTable>();
-  BinaryResourceParser parser(context, table.get(), source, data->data(), data->size(), apk.get());
+  BinaryResourceParser parser(context, table.get(), source, table_data.data(), table_data.size(),
+                              apk.get());
   if (!parser.Parse()) {
     return {};
   }
@@ -52,6 +52,21 @@ class LoadedApk {
   static std::unique_ptr<LoadedApk> LoadApkFromPath(IAaptContext* context,
                                                     const android::StringPiece& path);
 
+  /**
+   * Opens the APK at the given path and returns its resources.arsc without parsing it. The
+   * table is mapped in place when it is stored uncompressed. The opened APK is returned in
+   * out_apk, which must outlive the returned data.
+   */
+  static std::unique_ptr<io::IData> OpenResourceTable(
+      IAaptContext* context, const android::StringPiece& path,
+      std::unique_ptr<io::ZipFileCollection>* out_apk);
+
+  /** Parses the resources.arsc of an APK opened with OpenResourceTable(). */
+  static std::unique_ptr<LoadedApk> LoadApkFromTable(IAaptContext* context,
+                                                     const android::StringPiece& path,
+                                                     std::unique_ptr<io::ZipFileCollection> apk,
+                                                     const io::IData& table_data);
+
  private:
   Source source_;
   std::unique_ptr<io::IFileCollection> apk_;
@@ -24,6 +24,7 @@
 #include "Source.h"
 #include "StringPool.h"
 #include "io/File.h"
+#include "util/Arena.h"
 
 #include "android-base/macros.h"
 #include "androidfw/StringPiece.h"
@@ -57,7 +58,7 @@ struct Symbol {
   std::string comment;
 };
 
-class ResourceConfigValue {
+class ResourceConfigValue : public ArenaAllocated {
  public:
   /**
    * The configuration for which this value is defined.
@@ -85,7 +86,7 @@ class ResourceConfigValue {
  * Represents a resource entry, which may have
  * varying values for each defined configuration.
  */
-class ResourceEntry {
+class ResourceEntry : public ArenaAllocated {
  public:
   /**
    * The name of the resource. Immutable, as
@@ -21,6 +21,7 @@
 #include <set>
 
 #include "androidfw/ResourceTypes.h"
+#include "utils/JenkinsHash.h"
 
 #include "Resource.h"
 #include "ResourceUtils.h"
@@ -44,6 +45,21 @@ void BaseItem<Derived>::Accept(RawValueVisitor* visitor) {
   visitor->Visit(static_cast<Derived*>(this));
 }
 
+static size_t HashString(const std::string& str) {
+  return android::JenkinsHashWhiten(
+      android::JenkinsHashMix(0, static_cast<uint32_t>(std::hash<std::string>()(str))));
+}
+
+static size_t HashUntranslatableSections(size_t hash,
+                                         const std::vector<UntranslatableSection>& sections) {
+  android::hash_t h = static_cast<android::hash_t>(hash);
+  for (const UntranslatableSection& section : sections) {
+    h = android::JenkinsHashMix(h, static_cast<uint32_t>(section.start));
+    h = android::JenkinsHashMix(h, static_cast<uint32_t>(section.end));
+  }
+  return android::JenkinsHashWhiten(h);
+}
+
 RawString::RawString(const StringPool::Ref& ref) : value(ref) {}
 
 bool RawString::Equals(const Value* value) const {
@@ -54,6 +70,10 @@ bool RawString::Equals(const Value* value) const {
   return *this->value == *other->value;
 }
 
+size_t RawString::Hash() const {
+  return HashString(*value);
+}
+
 RawString* RawString::Clone(StringPool* new_pool) const {
   RawString* rs = new RawString(new_pool->MakeRef(*value));
   rs->comment_ = comment_;
@@ -92,6 +112,16 @@ bool Reference::Equals(const Value* value) const {
          name == other->name;
 }
 
+size_t Reference::Hash() const {
+  android::hash_t h = android::JenkinsHashMix(0, static_cast<uint32_t>(reference_type));
+  h = android::JenkinsHashMix(h, private_reference ? 1u : 0u);
+  h = android::JenkinsHashMix(h, id ? id.value().id : 0u);
+  if (name) {
+    h = android::JenkinsHashMix(h, static_cast<uint32_t>(std::hash<ResourceName>()(name.value())));
+  }
+  return android::JenkinsHashWhiten(h);
+}
+
 bool Reference::Flatten(android::Res_value* out_value) const {
   const ResourceId resid = id.value_or_default(ResourceId(0));
   const bool dynamic = resid.is_valid_dynamic() && resid.package_id() != kFrameworkPackageId &&
@@ -149,6 +179,10 @@ bool Id::Equals(const Value* value) const {
   return ValueCast<Id>(value) != nullptr;
 }
 
+size_t Id::Hash() const {
+  return 0u;
+}
+
 bool Id::Flatten(android::Res_value* out) const {
   out->dataType = android::Res_value::TYPE_INT_BOOLEAN;
   out->data = util::HostToDevice32(0);
@@ -185,6 +219,10 @@ bool String::Equals(const Value* value) const {
   return true;
 }
 
+size_t String::Hash() const {
+  return HashUntranslatableSections(HashString(*value), untranslatable_sections);
+}
+
 bool String::Flatten(android::Res_value* out_value) const {
   // Verify that our StringPool index is within encode-able limits.
   if (value.index() > std::numeric_limits<uint32_t>::max()) {
@@ -234,6 +272,11 @@ bool StyledString::Equals(const Value* value) const {
   return true;
 }
 
+size_t StyledString::Hash() const {
+  // The spans are left out, strings rarely differ by their spans alone.
+  return HashUntranslatableSections(HashString(*value->str), untranslatable_sections);
+}
+
 bool StyledString::Flatten(android::Res_value* out_value) const {
   if (value.index() > std::numeric_limits<uint32_t>::max()) {
     return false;
@@ -270,6 +313,10 @@ bool FileReference::Equals(const Value* value) const {
   return path == other->path;
 }
 
+size_t FileReference::Hash() const {
+  return HashString(*path);
+}
+
 bool FileReference::Flatten(android::Res_value* out_value) const {
   if (path.index() > std::numeric_limits<uint32_t>::max()) {
     return false;
@@ -308,6 +355,12 @@ bool BinaryPrimitive::Equals(const Value* value) const {
          this->value.data == other->value.data;
 }
 
+size_t BinaryPrimitive::Hash() const {
+  android::hash_t h = android::JenkinsHashMix(0, value.dataType);
+  h = android::JenkinsHashMix(h, value.data);
+  return android::JenkinsHashWhiten(h);
+}
+
 bool BinaryPrimitive::Flatten(android::Res_value* out_value) const {
   out_value->dataType = value.dataType;
   out_value->data = util::HostToDevice32(value.data);
@@ -410,6 +463,21 @@ bool Attribute::Equals(const Value* value) const {
                     });
 }
 
+size_t Attribute::Hash() const {
+  android::hash_t h = android::JenkinsHashMix(0, type_mask);
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(min_int));
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(max_int));
+
+  // Equals() ignores the order of the symbols, so combine them with a commutative sum.
+  uint32_t symbols_hash = 0u;
+  for (const Symbol& symbol : symbols) {
+    symbols_hash += android::JenkinsHashMix(static_cast<uint32_t>(symbol.symbol.Hash()),
+                                            symbol.value);
+  }
+  h = android::JenkinsHashMix(h, symbols_hash);
+  return android::JenkinsHashWhiten(h);
+}
+
 Attribute* Attribute::Clone(StringPool* /*new_pool*/) const {
   return new Attribute(*this);
 }
@@ -672,6 +740,20 @@ bool Style::Equals(const Value* value) const {
                     });
 }
 
+size_t Style::Hash() const {
+  android::hash_t h =
+      android::JenkinsHashMix(0, parent ? static_cast<uint32_t>(parent.value().Hash()) : 0u);
+
+  // Equals() ignores the order of the entries, so combine them with a commutative sum.
+  uint32_t entries_hash = 0u;
+  for (const Entry& entry : entries) {
+    entries_hash += android::JenkinsHashMix(static_cast<uint32_t>(entry.key.Hash()),
+                                            static_cast<uint32_t>(entry.value->Hash()));
+  }
+  h = android::JenkinsHashMix(h, entries_hash);
+  return android::JenkinsHashWhiten(h);
+}
+
 Style* Style::Clone(StringPool* new_pool) const {
   Style* style = new Style();
   style->parent = parent;
@@ -773,6 +855,14 @@ bool Array::Equals(const Value* value) const {
                     });
 }
 
+size_t Array::Hash() const {
+  android::hash_t h = 0;
+  for (const std::unique_ptr<Item>& item : items) {
+    h = android::JenkinsHashMix(h, static_cast<uint32_t>(item->Hash()));
+  }
+  return android::JenkinsHashWhiten(h);
+}
+
 Array* Array::Clone(StringPool* new_pool) const {
   Array* array = new Array();
   array->comment_ = comment_;
@@ -810,6 +900,14 @@ bool Plural::Equals(const Value* value) const {
   return true;
 }
 
+size_t Plural::Hash() const {
+  android::hash_t h = 0;
+  for (const std::unique_ptr<Item>& item : values) {
+    h = android::JenkinsHashMix(h, item != nullptr ? static_cast<uint32_t>(item->Hash()) : 0u);
+  }
+  return android::JenkinsHashWhiten(h);
+}
+
 Plural* Plural::Clone(StringPool* new_pool) const {
   Plural* p = new Plural();
   p->comment_ = comment_;
@@ -866,6 +964,14 @@ bool Styleable::Equals(const Value* value) const {
                     });
 }
 
+size_t Styleable::Hash() const {
+  android::hash_t h = 0;
+  for (const Reference& entry : entries) {
+    h = android::JenkinsHashMix(h, static_cast<uint32_t>(entry.Hash()));
+  }
+  return android::JenkinsHashWhiten(h);
+}
+
 Styleable* Styleable::Clone(StringPool* /*new_pool*/) const {
   return new Styleable(*this);
 }
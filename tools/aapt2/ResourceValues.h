@@ -29,6 +29,7 @@
 #include "Resource.h"
 #include "StringPool.h"
 #include "io/File.h"
+#include "util/Arena.h"
 #include "util/Maybe.h"
 
 namespace aapt {
@@ -40,7 +41,8 @@ struct RawValueVisitor;
 // type specific operations is to check the Value's type() and
 // cast it to the appropriate subclass. This isn't super clean,
 // but it is the simplest strategy.
-class Value {
+// Values are created in very large numbers, so they are ArenaAllocated.
+class Value : public ArenaAllocated {
  public:
   virtual ~Value() = default;
 
@@ -73,6 +75,10 @@ class Value {
 
   virtual bool Equals(const Value* value) const = 0;
 
+  // Returns a hash of this value that is consistent with Equals(): values that are equal always
+  // hash the same. Candidate duplicates can then be found without comparing every pair of values.
+  virtual size_t Hash() const = 0;
+
   // Calls the appropriate overload of ValueVisitor.
   virtual void Accept(RawValueVisitor* visitor) = 0;
 
@@ -134,6 +140,7 @@ struct Reference : public BaseItem<Reference> {
   Reference(const ResourceNameRef& n, const ResourceId& i);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   Reference* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
@@ -146,6 +153,7 @@ bool operator==(const Reference&, const Reference&);
 struct Id : public BaseItem<Id> {
   Id() { weak_ = true; }
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out) const override;
   Id* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
@@ -159,6 +167,7 @@ struct RawString : public BaseItem<RawString> {
   explicit RawString(const StringPool::Ref& ref);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   RawString* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
@@ -193,6 +202,7 @@ struct String : public BaseItem<String> {
   explicit String(const StringPool::Ref& ref);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   String* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
@@ -209,6 +219,7 @@ struct StyledString : public BaseItem<StyledString> {
   explicit StyledString(const StringPool::StyleRef& ref);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   StyledString* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
@@ -225,6 +236,7 @@ struct FileReference : public BaseItem<FileReference> {
   explicit FileReference(const StringPool::Ref& path);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   FileReference* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
@@ -239,6 +251,7 @@ struct BinaryPrimitive : public BaseItem<BinaryPrimitive> {
   BinaryPrimitive(uint8_t dataType, uint32_t data);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   BinaryPrimitive* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
@@ -261,6 +274,7 @@ struct Attribute : public BaseValue<Attribute> {
   explicit Attribute(bool w, uint32_t t = 0u);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   Attribute* Clone(StringPool* new_pool) const override;
   void PrintMask(std::ostream* out) const;
   void Print(std::ostream* out) const override;
@@ -283,6 +297,7 @@ struct Style : public BaseValue<Style> {
   std::vector<Entry> entries;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   Style* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
 
@@ -295,6 +310,7 @@ struct Array : public BaseValue<Array> {
   std::vector<std::unique_ptr<Item>> items;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   Array* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
 };
@@ -305,6 +321,7 @@ struct Plural : public BaseValue<Plural> {
   std::array<std::unique_ptr<Item>, Count> values;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   Plural* Clone(StringPool* new_pool) const override;
   void Print(std::ostream* out) const override;
 };
@@ -313,6 +330,7 @@ struct Styleable : public BaseValue<Styleable> {
   std::vector<Reference> entries;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   Styleable* Clone(StringPool* newPool) const override;
   void Print(std::ostream* out) const override;
   void MergeWith(Styleable* styleable);
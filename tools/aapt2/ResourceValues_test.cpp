@@ -137,6 +137,38 @@ TEST(ResourceValuesTest, StyleEquals) {
   EXPECT_TRUE(a->Equals(g.get()));
 }
 
+TEST(ResourceValuesTest, EqualValuesHashTheSame) {
+  StringPool pool;
+
+  std::unique_ptr<Style> a = test::StyleBuilder()
+      .SetParent("android:style/Parent")
+      .AddItem("android:attr/foo", ResourceUtils::TryParseInt("1"))
+      .AddItem("android:attr/bar", util::make_unique<String>(pool.MakeRef("bar")))
+      .Build();
+
+  // Same entries in a different order, with strings from another pool.
+  StringPool other_pool;
+  std::unique_ptr<Style> b = test::StyleBuilder()
+      .SetParent("android:style/Parent")
+      .AddItem("android:attr/bar", util::make_unique<String>(other_pool.MakeRef("bar")))
+      .AddItem("android:attr/foo", ResourceUtils::TryParseInt("1"))
+      .Build();
+
+  ASSERT_TRUE(a->Equals(b.get()));
+  EXPECT_EQ(a->Hash(), b->Hash());
+
+  std::unique_ptr<Value> c(a->Clone(&other_pool));
+  EXPECT_EQ(a->Hash(), c->Hash());
+
+  Array d;
+  d.items.push_back(util::make_unique<String>(pool.MakeRef("one")));
+  d.items.push_back(util::make_unique<Reference>(test::ParseNameOrDie("android:string/two")));
+
+  std::unique_ptr<Value> e(d.Clone(&other_pool));
+  ASSERT_TRUE(d.Equals(e.get()));
+  EXPECT_EQ(d.Hash(), e->Hash());
+}
+
 TEST(ResourceValuesTest, StyleClone) {
   std::unique_ptr<Style> a = test::StyleBuilder()
       .SetParent("android:style/Parent")
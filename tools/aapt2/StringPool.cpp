@@ -17,8 +17,11 @@
 #include "StringPool.h"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "android-base/logging.h"
 #include "androidfw/ResourceTypes.h"
@@ -162,23 +165,33 @@ StringPool::Ref StringPool::MakeRef(const StringPiece& str,
   return MakeRefImpl(str, context, true);
 }
 
-StringPool::Ref StringPool::MakeRefImpl(const StringPiece& str,
-                                        const Context& context, bool unique) {
-  if (unique) {
-    auto iter = indexed_strings_.find(str);
-    if (iter != std::end(indexed_strings_)) {
-      return Ref(iter->second);
-    }
-  }
+static size_t HashString(const StringPiece& str) {
+  return std::hash<StringPiece>()(str);
+}
 
+StringPool::Entry* StringPool::NewEntry(const StringPiece& str, size_t hash,
+                                        const Context& context) {
   Entry* entry = new Entry();
   entry->value = str.to_string();
   entry->context = context;
   entry->index = strings_.size();
   entry->ref_ = 0;
+  entry->hash_ = hash;
   strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
-  return Ref(entry);
+  indexed_strings_.insert(std::make_pair(IndexKey{entry->value, hash}, entry));
+  return entry;
+}
+
+StringPool::Ref StringPool::MakeRefImpl(const StringPiece& str,
+                                        const Context& context, bool unique) {
+  const size_t hash = HashString(str);
+  if (unique) {
+    auto iter = indexed_strings_.find(IndexKey{str, hash});
+    if (iter != std::end(indexed_strings_)) {
+      return Ref(iter->second);
+    }
+  }
+  return Ref(NewEntry(str, hash, context));
 }
 
 StringPool::StyleRef StringPool::MakeRef(const StyleString& str) {
@@ -187,13 +200,7 @@ StringPool::StyleRef StringPool::MakeRef(const StyleString& str) {
 
 StringPool::StyleRef StringPool::MakeRef(const StyleString& str,
                                          const Context& context) {
-  Entry* entry = new Entry();
-  entry->value = str.str;
-  entry->context = context;
-  entry->index = strings_.size();
-  entry->ref_ = 0;
-  strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+  Entry* entry = NewEntry(str.str, HashString(str.str), context);
 
   StyleEntry* style_entry = new StyleEntry();
   style_entry->str = Ref(entry);
@@ -207,13 +214,8 @@ StringPool::StyleRef StringPool::MakeRef(const StyleString& str,
 }
 
 StringPool::StyleRef StringPool::MakeRef(const StyleRef& ref) {
-  Entry* entry = new Entry();
-  entry->value = *ref.entry_->str;
-  entry->context = ref.entry_->str.entry_->context;
-  entry->index = strings_.size();
-  entry->ref_ = 0;
-  strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+  const Entry* src_entry = ref.entry_->str.entry_;
+  Entry* entry = NewEntry(src_entry->value, src_entry->hash_, src_entry->context);
 
   StyleEntry* style_entry = new StyleEntry();
   style_entry->str = Ref(entry);
@@ -227,6 +229,8 @@ StringPool::StyleRef StringPool::MakeRef(const StyleRef& ref) {
 }
 
 void StringPool::Merge(StringPool&& pool) {
+  // The keys carry their hashes, so none of the merged strings is hashed again.
+  indexed_strings_.reserve(indexed_strings_.size() + pool.indexed_strings_.size());
   indexed_strings_.insert(pool.indexed_strings_.begin(),
                           pool.indexed_strings_.end());
   pool.indexed_strings_.clear();
@@ -286,7 +290,9 @@ void StringPool::Prune() {
 
 void StringPool::Sort(
     const std::function<bool(const Entry&, const Entry&)>& cmp) {
-  std::sort(
+  // Use a stable sort, so that strings comparing equal keep their relative order no matter where
+  // other strings were inserted.
+  std::stable_sort(
       strings_.begin(), strings_.end(),
       [&cmp](const std::unique_ptr<Entry>& a,
              const std::unique_ptr<Entry>& b) -> bool { return cmp(*a, *b); });
@@ -327,6 +333,32 @@ static size_t EncodedLengthUnits(size_t length) {
   return length > kMaxSize ? 2 : 1;
 }
 
+// Strings are encoded on several threads only when each thread gets at least this many.
+constexpr static size_t kMinStringsPerEncodeJob = 4096u;
+
+/**
+ * Calls func(begin, end) on consecutive ranges that together cover [0, count). Large counts are
+ * split among several threads.
+ */
+static void ForEachRange(size_t count, const std::function<void(size_t, size_t)>& func) {
+  const size_t max_jobs = std::max(1u, std::thread::hardware_concurrency());
+  const size_t jobs = std::min(max_jobs, count / kMinStringsPerEncodeJob);
+  if (jobs <= 1) {
+    func(0, count);
+    return;
+  }
+
+  const size_t range_size = (count + jobs - 1) / jobs;
+  std::vector<std::thread> threads;
+  for (size_t begin = range_size; begin < count; begin += range_size) {
+    threads.emplace_back(func, begin, std::min(count, begin + range_size));
+  }
+  func(0, range_size);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 bool StringPool::Flatten(BigBuffer* out, const StringPool& pool, bool utf8) {
   const size_t start_index = out->size();
   android::ResStringPool_header* header =
@@ -350,15 +382,36 @@ bool StringPool::Flatten(BigBuffer* out, const StringPool& pool, bool utf8) {
   const size_t before_strings_index = out->size();
   header->stringsStart = before_strings_index - start_index;
 
-  for (const auto& entry : pool) {
+  // Converting the strings is the costly part, so do it up front, in parallel. Only copying the
+  // results into `out` has to happen in order.
+  const size_t string_count = pool.size();
+  std::vector<ssize_t> utf16_lengths;
+  std::vector<std::u16string> utf16_strings;
+  if (utf8) {
+    utf16_lengths.resize(string_count);
+    ForEachRange(string_count, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        const std::string& value = pool.strings_[i]->value;
+        utf16_lengths[i] =
+            utf8_to_utf16_length(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+      }
+    });
+  } else {
+    utf16_strings.resize(string_count);
+    ForEachRange(string_count, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        utf16_strings[i] = util::Utf8ToUtf16(pool.strings_[i]->value);
+      }
+    });
+  }
+
+  for (size_t i = 0; i < string_count; i++) {
     *indices = out->size() - before_strings_index;
     indices++;
 
     if (utf8) {
-      const std::string& encoded = entry->value;
-      const ssize_t utf16_length = utf8_to_utf16_length(
-          reinterpret_cast<const uint8_t*>(entry->value.data()),
-          entry->value.size());
+      const std::string& encoded = pool.strings_[i]->value;
+      const ssize_t utf16_length = utf16_lengths[i];
       CHECK(utf16_length >= 0);
 
       const size_t total_size = EncodedLengthUnits<char>(utf16_length) +
@@ -375,7 +428,7 @@ bool StringPool::Flatten(BigBuffer* out, const StringPool& pool, bool utf8) {
       strncpy(data, encoded.data(), encoded.size());
 
     } else {
-      const std::u16string encoded = util::Utf8ToUtf16(entry->value);
+      const std::u16string& encoded = utf16_strings[i];
       const ssize_t utf16_length = encoded.size();
 
       // Total number of 16-bit words to write.
@@ -123,6 +123,9 @@ class StringPool {
     friend class Ref;
 
     int ref_;
+
+    // Hash of value, computed once when the entry is created.
+    size_t hash_;
   };
 
   struct Span {
@@ -217,11 +220,26 @@ class StringPool {
 
   static bool Flatten(BigBuffer* out, const StringPool& pool, bool utf8);
 
+  // A string along with its precomputed hash, so that indexing an existing Entry again (when
+  // merging pools, for instance) never hashes its string again.
+  struct IndexKey {
+    android::StringPiece str;
+    size_t hash;
+
+    bool operator==(const IndexKey& rhs) const { return hash == rhs.hash && str == rhs.str; }
+  };
+
+  struct IndexKeyHash {
+    size_t operator()(const IndexKey& key) const { return key.hash; }
+  };
+
   Ref MakeRefImpl(const android::StringPiece& str, const Context& context, bool unique);
 
+  Entry* NewEntry(const android::StringPiece& str, size_t hash, const Context& context);
+
   std::vector<std::unique_ptr<Entry>> strings_;
   std::vector<std::unique_ptr<StyleEntry>> styles_;
-  std::unordered_multimap<android::StringPiece, Entry*> indexed_strings_;
+  std::unordered_multimap<IndexKey, Entry*, IndexKeyHash> indexed_strings_;
 };
 
 //
@@ -269,4 +269,50 @@ TEST(StringPoolTest, Flatten) {
   }
 }
 
+TEST(StringPoolTest, FlattenManyStrings) {
+  using namespace android;  // For NO_ERROR on Windows.
+
+  // Enough strings for the encoding to be split among threads, if there are several cores.
+  const size_t kStringCount = 20000u;
+  StringPool pool;
+  std::vector<StringPool::Ref> refs;
+  for (size_t i = 0; i < kStringCount; i++) {
+    refs.push_back(pool.MakeRef("string \xE2\x82\xAC" + std::to_string(i)));
+  }
+
+  BigBuffer buffers[2] = {BigBuffer(1024), BigBuffer(1024)};
+  StringPool::FlattenUtf8(&buffers[0], pool);
+  StringPool::FlattenUtf16(&buffers[1], pool);
+
+  for (const BigBuffer& buffer : buffers) {
+    std::unique_ptr<uint8_t[]> data = util::Copy(buffer);
+
+    ResStringPool test;
+    ASSERT_EQ(test.setTo(data.get(), buffer.size()), NO_ERROR);
+    ASSERT_EQ(kStringCount, test.size());
+
+    for (size_t i = 0; i < kStringCount; i += 997) {
+      const std::string expected = "string \xE2\x82\xAC" + std::to_string(i);
+      EXPECT_EQ(expected, util::GetString(test, i));
+      EXPECT_EQ(util::Utf8ToUtf16(expected), util::GetString16(test, i).to_string());
+    }
+  }
+}
+
+TEST(StringPoolTest, MergeKeepsStringsDeduplicated) {
+  StringPool pool;
+  StringPool::Ref ref1 = pool.MakeRef("hello");
+
+  StringPool other_pool;
+  StringPool::Ref ref2 = other_pool.MakeRef("goodbye");
+
+  pool.Merge(std::move(other_pool));
+  EXPECT_EQ(2u, pool.size());
+
+  // Both the original and the merged strings are still found.
+  EXPECT_EQ(ref1, pool.MakeRef("hello"));
+  EXPECT_EQ(ref2, pool.MakeRef("goodbye"));
+  EXPECT_EQ(2u, pool.size());
+}
+
 }  // namespace aapt
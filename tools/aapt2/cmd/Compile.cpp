@@ -16,8 +16,12 @@
 
 #include <dirent.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "android-base/errors.h"
 #include "android-base/file.h"
@@ -30,6 +34,8 @@
 #include "Flags.h"
 #include "ResourceParser.h"
 #include "ResourceTable.h"
+#include "ResourceUtils.h"
+#include "compile/CompileCache.h"
 #include "compile/IdAssigner.h"
 #include "compile/InlineXmlFormatParser.h"
 #include "compile/Png.h"
@@ -117,6 +123,8 @@ struct CompileOptions {
   bool no_png_crunch = false;
   bool legacy_mode = false;
   bool verbose = false;
+  size_t jobs = 1;
+  Maybe<std::string> cache_dir;
 };
 
 static std::string BuildIntermediateFilename(const ResourcePathData& data) {
@@ -650,6 +658,281 @@ class CompileContext : public IAaptContext {
   bool verbose_ = false;
 };
 
+/**
+ * Returns the name of the intermediate .flat entry `path_data` compiles to. Values files have
+ * their extension overwritten.
+ */
+static std::string GetIntermediateFilename(ResourcePathData* path_data) {
+  if (path_data->resource_dir == "values") {
+    // Overwrite the extension.
+    path_data->extension = "arsc";
+  }
+  return BuildIntermediateFilename(*path_data);
+}
+
+/**
+ * Compiles a single input file into its intermediate .flat entry in `writer`.
+ */
+static bool CompileInput(IAaptContext* context, const CompileOptions& options,
+                         ResourcePathData* path_data, IArchiveWriter* writer) {
+  if (options.verbose) {
+    context->GetDiagnostics()->Note(DiagMessage(path_data->source) << "processing");
+  }
+
+  if (!IsValidFile(context, path_data->source.path)) {
+    return false;
+  }
+
+  const std::string output_filename = GetIntermediateFilename(path_data);
+  if (path_data->resource_dir == "values") {
+    return CompileTable(context, options, *path_data, writer, output_filename);
+  }
+
+  if (const ResourceType* type = ParseResourceType(path_data->resource_dir)) {
+    if (*type != ResourceType::kRaw) {
+      if (path_data->extension == "xml") {
+        return CompileXml(context, options, *path_data, writer, output_filename);
+      } else if (!options.no_png_crunch &&
+                 (path_data->extension == "png" || path_data->extension == "9.png")) {
+        return CompilePng(context, options, *path_data, writer, output_filename);
+      }
+    }
+    return CompileFile(context, options, *path_data, writer, output_filename);
+  }
+
+  context->GetDiagnostics()->Error(DiagMessage() << "invalid file path '" << path_data->source
+                                                 << "'");
+  return false;
+}
+
+/**
+ * Holds the entries written by one compilation job in memory until they can be written, in input
+ * order, to the real archive.
+ */
+class BufferedArchiveWriter : public IArchiveWriter {
+ public:
+  BufferedArchiveWriter() = default;
+
+  bool StartEntry(const StringPiece& path, uint32_t flags) override {
+    if (current_entry_ != nullptr) {
+      return false;
+    }
+    entries_.push_back(util::make_unique<Entry>(path, flags));
+    current_entry_ = entries_.back().get();
+    return true;
+  }
+
+  bool Write(const void* data, int len) override {
+    if (current_entry_ == nullptr) {
+      return false;
+    }
+    const size_t size = static_cast<size_t>(len);
+    memcpy(current_entry_->buffer.NextBlock<uint8_t>(size), data, size);
+    return true;
+  }
+
+  bool FinishEntry() override {
+    if (current_entry_ == nullptr) {
+      return false;
+    }
+    current_entry_ = nullptr;
+    return true;
+  }
+
+  bool WriteFile(const StringPiece& path, uint32_t flags, io::InputStream* in) override {
+    if (!StartEntry(path, flags)) {
+      return false;
+    }
+
+    const void* data = nullptr;
+    size_t len = 0;
+    while (in->Next(&data, &len)) {
+      if (!Write(data, static_cast<int>(len))) {
+        return false;
+      }
+    }
+    return !in->HadError() && FinishEntry();
+  }
+
+  bool HadError() const override { return false; }
+
+  std::string GetError() const override { return {}; }
+
+  // Returns the data of the finished entry at `path`, or nullptr if there is none.
+  const BigBuffer* FindEntry(const StringPiece& path) const {
+    for (const std::unique_ptr<Entry>& entry : entries_) {
+      if (entry.get() != current_entry_ && entry->path == path) {
+        return &entry->buffer;
+      }
+    }
+    return nullptr;
+  }
+
+  // Writes all finished entries to `writer`, in the order they were started.
+  bool WriteTo(IArchiveWriter* writer, IDiagnostics* diag) {
+    for (const std::unique_ptr<Entry>& entry : entries_) {
+      if (entry.get() == current_entry_) {
+        break;
+      }
+
+      if (!writer->StartEntry(entry->path, entry->flags)) {
+        diag->Error(DiagMessage(entry->path) << "failed to open file");
+        return false;
+      }
+
+      for (const BigBuffer::Block& block : entry->buffer) {
+        if (!writer->Write(block.buffer.get(), static_cast<int>(block.size))) {
+          diag->Error(DiagMessage(entry->path) << "failed to write data");
+          return false;
+        }
+      }
+
+      if (!writer->FinishEntry()) {
+        diag->Error(DiagMessage(entry->path) << "failed to finish writing data");
+        return false;
+      }
+    }
+    entries_.clear();
+    return true;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BufferedArchiveWriter);
+
+  struct Entry {
+    Entry(const StringPiece& entry_path, uint32_t entry_flags)
+        : path(entry_path.to_string()), flags(entry_flags), buffer(4096) {}
+
+    std::string path;
+    uint32_t flags;
+    BigBuffer buffer;
+  };
+
+  std::vector<std::unique_ptr<Entry>> entries_;
+  Entry* current_entry_ = nullptr;
+};
+
+/**
+ * Compiles a single input file like CompileInput(), but first looks for the result in `cache`.
+ * Results that came with warnings are not cached, so that a cache hit never hides a diagnostic.
+ */
+static bool CompileInputWithCache(IAaptContext* context, const CompileOptions& options,
+                                  const CompileCache* cache, ResourcePathData* path_data,
+                                  BufferedArchiveWriter* writer, BufferedDiagnostics* diag) {
+  std::string contents;
+  if (!android::base::ReadFileToString(path_data->source.path, &contents,
+                                       true /*follow_symlinks*/)) {
+    // Let compilation report the error.
+    return CompileInput(context, options, path_data, writer);
+  }
+
+  const std::string output_filename = GetIntermediateFilename(path_data);
+
+  // Everything other than the contents of the file that ends up in the output.
+  std::stringstream salt;
+  salt << path_data->source.path << '\0' << output_filename << '\0' << options.pseudolocalize
+       << options.no_png_crunch << options.legacy_mode;
+  const std::string key = CompileCache::ComputeKey(salt.str(), contents);
+
+  std::string cached_data;
+  if (cache->Lookup(key, &cached_data)) {
+    if (context->IsVerbose()) {
+      context->GetDiagnostics()->Note(DiagMessage(path_data->source) << "using cached output");
+    }
+    return writer->StartEntry(output_filename, 0) &&
+           writer->Write(cached_data.data(), static_cast<int>(cached_data.size())) &&
+           writer->FinishEntry();
+  }
+
+  if (!CompileInput(context, options, path_data, writer)) {
+    return false;
+  }
+
+  if (!diag->HadWarnings()) {
+    if (const BigBuffer* data = writer->FindEntry(output_filename)) {
+      cache->Store(key, *data, context->GetDiagnostics());
+    }
+  }
+  return true;
+}
+
+/**
+ * Compiles `input_data` on `options.jobs` worker threads, reusing results from `cache` if it is
+ * not null. Each file is compiled into memory, and the results are committed to `writer` and
+ * `context`'s diagnostics in input order, so the output is identical to a serial compile.
+ */
+static bool CompileInputsBuffered(CompileContext* context, const CompileOptions& options,
+                                  const CompileCache* cache,
+                                  std::vector<ResourcePathData>* input_data,
+                                  IArchiveWriter* writer) {
+  struct CompileJob {
+    BufferedDiagnostics diagnostics;
+    BufferedArchiveWriter writer;
+    bool result = false;
+    bool done = false;
+  };
+
+  const size_t job_count = input_data->size();
+  std::vector<std::unique_ptr<CompileJob>> jobs;
+  jobs.reserve(job_count);
+  for (size_t i = 0; i < job_count; i++) {
+    jobs.push_back(util::make_unique<CompileJob>());
+  }
+
+  std::mutex lock;
+  std::condition_variable done_cond;
+  std::atomic<size_t> next_job(0);
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next_job.fetch_add(1)) < job_count) {
+      CompileJob* job = jobs[i].get();
+      CompileContext job_context(&job->diagnostics);
+      job_context.SetVerbose(context->IsVerbose());
+      ResourcePathData* path_data = &(*input_data)[i];
+      const bool result =
+          cache != nullptr ? CompileInputWithCache(&job_context, options, cache, path_data,
+                                                   &job->writer, &job->diagnostics)
+                           : CompileInput(&job_context, options, path_data, &job->writer);
+
+      std::lock_guard<std::mutex> guard(lock);
+      job->result = result;
+      job->done = true;
+      done_cond.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t worker_count = std::min(options.jobs, job_count);
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back(worker);
+  }
+
+  // This thread is the only one that touches the real writer and diagnostics.
+  bool success = true;
+  for (size_t i = 0; i < job_count; i++) {
+    CompileJob* job = jobs[i].get();
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      done_cond.wait(guard, [job]() { return job->done; });
+    }
+
+    job->diagnostics.Replay(context->GetDiagnostics());
+    if (!job->result) {
+      success = false;
+    } else if (!job->writer.WriteTo(writer, context->GetDiagnostics())) {
+      success = false;
+    }
+
+    // Release the compiled data as soon as it is committed.
+    jobs[i].reset();
+  }
+
+  for (std::thread& t : workers) {
+    t.join();
+  }
+  return success;
+}
+
 /**
  * Entry point for compilation phase. Parses arguments and dispatches to the
  * correct steps.
@@ -659,6 +942,7 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   CompileOptions options;
 
   bool verbose = false;
+  Maybe<std::string> jobs;
   Flags flags =
       Flags()
           .RequiredFlag("-o", "Output path", &options.output_path)
@@ -670,11 +954,29 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
           .OptionalSwitch("--no-crunch", "Disables PNG processing", &options.no_png_crunch)
           .OptionalSwitch("--legacy", "Treat errors that used to be valid in AAPT as warnings",
                           &options.legacy_mode)
+          .OptionalFlag("--cache-dir",
+                        "Directory in which to keep compiled files, keyed by their contents. "
+                        "Unchanged files are copied from it instead of being recompiled",
+                        &options.cache_dir)
+          .OptionalFlag("--jobs",
+                        "Number of files to compile in parallel. Output is identical to a "
+                        "serial compile. Defaults to 1",
+                        &jobs)
           .OptionalSwitch("-v", "Enables verbose logging", &verbose);
   if (!flags.Parse("aapt2 compile", args, &std::cerr)) {
     return 1;
   }
 
+  if (jobs) {
+    const Maybe<uint32_t> maybe_jobs = ResourceUtils::ParseInt(jobs.value());
+    if (!maybe_jobs || maybe_jobs.value() == 0) {
+      context.GetDiagnostics()->Error(DiagMessage() << "--jobs '" << jobs.value()
+                                                    << "' is not a positive integer");
+      return 1;
+    }
+    options.jobs = maybe_jobs.value();
+  }
+
   context.SetVerbose(verbose);
 
   std::unique_ptr<IArchiveWriter> archive_writer;
@@ -716,51 +1018,22 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   }
 
   bool error = false;
-  for (ResourcePathData& path_data : input_data) {
-    if (options.verbose) {
-      context.GetDiagnostics()->Note(DiagMessage(path_data.source) << "processing");
-    }
-
-    if (!IsValidFile(&context, path_data.source.path)) {
-      error = true;
-      continue;
-    }
-
-    if (path_data.resource_dir == "values") {
-      // Overwrite the extension.
-      path_data.extension = "arsc";
-
-      const std::string output_filename = BuildIntermediateFilename(path_data);
-      if (!CompileTable(&context, options, path_data, archive_writer.get(), output_filename)) {
-        error = true;
+  if (options.cache_dir || (options.jobs > 1 && input_data.size() > 1)) {
+    std::unique_ptr<CompileCache> cache;
+    if (options.cache_dir) {
+      if (!file::mkdirs(options.cache_dir.value())) {
+        context.GetDiagnostics()->Error(DiagMessage(options.cache_dir.value())
+                                        << "failed to create cache directory: "
+                                        << android::base::SystemErrorCodeToString(errno));
+        return 1;
       }
-
-    } else {
-      const std::string output_filename = BuildIntermediateFilename(path_data);
-      if (const ResourceType* type = ParseResourceType(path_data.resource_dir)) {
-        if (*type != ResourceType::kRaw) {
-          if (path_data.extension == "xml") {
-            if (!CompileXml(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          } else if (!options.no_png_crunch &&
-                     (path_data.extension == "png" || path_data.extension == "9.png")) {
-            if (!CompilePng(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          } else {
-            if (!CompileFile(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          }
-        } else {
-          if (!CompileFile(&context, options, path_data, archive_writer.get(), output_filename)) {
-            error = true;
-          }
-        }
-      } else {
-        context.GetDiagnostics()->Error(DiagMessage() << "invalid file path '" << path_data.source
-                                                      << "'");
+      cache = util::make_unique<CompileCache>(options.cache_dir.value());
+    }
+    error = !CompileInputsBuffered(&context, options, cache.get(), &input_data,
+                                   archive_writer.get());
+  } else {
+    for (ResourcePathData& path_data : input_data) {
+      if (!CompileInput(&context, options, &path_data, archive_writer.get())) {
         error = true;
       }
     }
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
 #include "android-base/macros.h"
 
 #include "Flags.h"
@@ -357,8 +359,29 @@ int Diff(const std::vector<StringPiece>& args) {
     return 1;
   }
 
-  std::unique_ptr<LoadedApk> apk_a = LoadedApk::LoadApkFromPath(&context, flags.GetArgs()[0]);
-  std::unique_ptr<LoadedApk> apk_b = LoadedApk::LoadApkFromPath(&context, flags.GetArgs()[1]);
+  const std::string& path_a = flags.GetArgs()[0];
+  const std::string& path_b = flags.GetArgs()[1];
+  std::unique_ptr<io::ZipFileCollection> zip_a;
+  std::unique_ptr<io::ZipFileCollection> zip_b;
+  std::unique_ptr<io::IData> data_a = LoadedApk::OpenResourceTable(&context, path_a, &zip_a);
+  std::unique_ptr<io::IData> data_b = LoadedApk::OpenResourceTable(&context, path_b, &zip_b);
+  if (!data_a || !data_b) {
+    return 1;
+  }
+
+  // Identical tables can't differ, so skip parsing them. This is the common case when
+  // verifying builds, and the tables are usually mapped, so nothing gets copied either.
+  if (data_a->size() == data_b->size() &&
+      memcmp(data_a->data(), data_b->data(), data_a->size()) == 0) {
+    return 0;
+  }
+
+  std::unique_ptr<LoadedApk> apk_a =
+      LoadedApk::LoadApkFromTable(&context, path_a, std::move(zip_a), *data_a);
+  data_a = {};
+  std::unique_ptr<LoadedApk> apk_b =
+      LoadedApk::LoadApkFromTable(&context, path_b, std::move(zip_b), *data_b);
+  data_b = {};
   if (!apk_a || !apk_b) {
     return 1;
   }
@@ -15,9 +15,15 @@
  */
 
 #include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <queue>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -43,6 +49,7 @@
 #include "io/FileSystem.h"
 #include "io/Util.h"
 #include "io/ZipArchive.h"
+#include "java/ClassDefinition.h"
 #include "java/JavaClassGenerator.h"
 #include "java/ManifestClassGenerator.h"
 #include "java/ProguardRules.h"
@@ -58,6 +65,7 @@
 #include "proto/ProtoSerialize.h"
 #include "split/TableSplitter.h"
 #include "unflatten/BinaryResourceParser.h"
+#include "util/Arena.h"
 #include "util/Files.h"
 #include "xml/XmlDom.h"
 
@@ -115,6 +123,13 @@ struct LinkOptions {
   // Stable ID options.
   std::unordered_map<ResourceName, ResourceId> stable_id_map;
   Maybe<std::string> resource_id_map_path;
+
+  // Incremental link options. The assigned IDs are also written here, for the next link to
+  // reuse.
+  Maybe<std::string> incremental_id_map_path;
+
+  // Number of threads used to link references and XML files.
+  size_t jobs = 1;
 };
 
 class LinkContext : public IAaptContext {
@@ -179,9 +194,16 @@ class LinkContext : public IAaptContext {
     min_sdk_version_ = minSdk;
   }
 
+  // The Arena from which the resource tables of this link are allocated. It is destroyed after
+  // everything else that lives as long as this context.
+  Arena* GetArena() {
+    return &arena_;
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(LinkContext);
 
+  Arena arena_;
   PackageType package_type_ = PackageType::kApp;
   IDiagnostics* diagnostics_;
   NameMangler name_mangler_;
@@ -305,6 +327,7 @@ struct ResourceFileFlattenerOptions {
   bool do_not_compress_anything = false;
   bool update_proguard_spec = false;
   std::unordered_set<std::string> extensions_to_not_compress;
+  size_t jobs = 1;
 };
 
 // A sampling of public framework resource IDs.
@@ -352,10 +375,23 @@ class ResourceFileFlattener {
 
     // The destination to write this file to.
     std::string dst_path;
+
+    // Set if xml_to_flatten was already linked by LinkXmlFiles(), along with the result.
+    std::unique_ptr<BufferedDiagnostics> link_diagnostics;
+    bool linked = false;
+
+    // The keep rules LinkXmlFiles() collected from xml_to_flatten, if it was asked to.
+    std::unique_ptr<proguard::KeepSet> keep_set;
+    bool collected_keep_rules = false;
   };
 
   uint32_t GetCompressionFlags(const StringPiece& str);
 
+  // Links the XML files of `file_ops` on options_.jobs threads, and collects their keep rules
+  // when updating the proguard spec. Diagnostics and rules are held until the file is versioned by
+  // LinkAndVersionXmlFile(), which runs in a stable order.
+  void LinkXmlFiles(const std::vector<FileOperation*>& file_ops);
+
   std::vector<std::unique_ptr<xml::XmlResource>> LinkAndVersionXmlFile(ResourceTable* table,
                                                                        FileOperation* file_op);
 
@@ -460,12 +496,25 @@ std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVer
     context_->GetDiagnostics()->Note(DiagMessage() << "linking " << src.path);
   }
 
-  XmlReferenceLinker xml_linker;
-  if (!xml_linker.Consume(context_, doc)) {
-    return {};
+  if (file_op->link_diagnostics) {
+    file_op->link_diagnostics->Replay(context_->GetDiagnostics());
+    if (!file_op->linked) {
+      return {};
+    }
+  } else {
+    XmlReferenceLinker xml_linker;
+    if (!xml_linker.Consume(context_, doc)) {
+      return {};
+    }
   }
 
-  if (options_.update_proguard_spec && !proguard::CollectProguardRules(src, doc, keep_set_)) {
+  if (file_op->keep_set) {
+    if (!file_op->collected_keep_rules) {
+      return {};
+    }
+    keep_set_->Merge(*file_op->keep_set);
+  } else if (options_.update_proguard_spec &&
+             !proguard::CollectProguardRules(src, doc, keep_set_)) {
     return {};
   }
 
@@ -500,6 +549,45 @@ std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVer
   return xml_compat_versioner.Process(context_, doc, api_range);
 }
 
+void ResourceFileFlattener::LinkXmlFiles(const std::vector<FileOperation*>& file_ops) {
+  for (FileOperation* file_op : file_ops) {
+    file_op->link_diagnostics = util::make_unique<BufferedDiagnostics>();
+    if (options_.update_proguard_spec) {
+      file_op->keep_set = util::make_unique<proguard::KeepSet>();
+    }
+  }
+
+  SymbolTable* symbols = context_->GetExternalSymbols();
+  symbols->SetRetainSymbols(true);
+
+  std::atomic<size_t> next_file(0);
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next_file.fetch_add(1)) < file_ops.size()) {
+      FileOperation* file_op = file_ops[i];
+      DiagnosticsOverrideContext file_context(context_, file_op->link_diagnostics.get());
+      XmlReferenceLinker xml_linker;
+      file_op->linked = xml_linker.Consume(&file_context, file_op->xml_to_flatten.get());
+      if (file_op->linked && file_op->keep_set) {
+        xml::XmlResource* doc = file_op->xml_to_flatten.get();
+        file_op->collected_keep_rules =
+            proguard::CollectProguardRules(doc->file.source, doc, file_op->keep_set.get());
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t worker_count = std::min(options_.jobs, file_ops.size());
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back(worker);
+  }
+  for (std::thread& t : workers) {
+    t.join();
+  }
+
+  symbols->SetRetainSymbols(false);
+}
+
 bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archive_writer) {
   bool error = false;
   std::map<std::pair<ConfigDescription, StringPiece>, FileOperation> config_sorted_files;
@@ -566,6 +654,18 @@ bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archiv
         }
       }
 
+      if (options_.jobs > 1) {
+        std::vector<FileOperation*> xml_file_ops;
+        for (auto& map_entry : config_sorted_files) {
+          if (map_entry.second.xml_to_flatten) {
+            xml_file_ops.push_back(&map_entry.second);
+          }
+        }
+        if (xml_file_ops.size() > 1) {
+          LinkXmlFiles(xml_file_ops);
+        }
+      }
+
       // Now flatten the sorted values.
       for (auto& map_entry : config_sorted_files) {
         const ConfigDescription& config = map_entry.first.first;
@@ -678,6 +778,93 @@ static bool LoadStableIdMap(IDiagnostics* diag, const std::string& path,
   return true;
 }
 
+// Appends a line identifying the contents of the file at `path` to `out_fingerprint`.
+static bool AppendFileFingerprint(const std::string& path, std::string* out_fingerprint) {
+  std::string error_str;
+  Maybe<android::FileMap> map = file::MmapPath(path, &error_str);
+  if (!map) {
+    return false;
+  }
+
+  const uLong crc = crc32(0u, reinterpret_cast<const Bytef*>(map.value().getDataPtr()),
+                          map.value().getDataLength());
+  *out_fingerprint += StringPrintf("%s\t%zu\t%08lx\n", path.c_str(),
+                                   map.value().getDataLength(), crc);
+  return true;
+}
+
+// Computes a fingerprint of everything that goes into a link: the command line and the contents
+// of every input file. Returns an empty value if the inputs can't be fingerprinted, in which case
+// the link must always run.
+static Maybe<std::string> ComputeLinkFingerprint(const std::vector<StringPiece>& args,
+                                                 const LinkOptions& options,
+                                                 const std::vector<std::string>& input_files,
+                                                 const Maybe<std::string>& stable_id_file_path) {
+  // Assets are whole directory trees; don't try to fingerprint those.
+  if (!options.assets_dirs.empty()) {
+    return {};
+  }
+
+  std::string fingerprint;
+  for (const StringPiece& arg : args) {
+    fingerprint += arg.to_string();
+    fingerprint += '\n';
+  }
+
+  std::vector<std::string> paths = {options.manifest_path};
+  paths.insert(paths.end(), options.include_paths.begin(), options.include_paths.end());
+  paths.insert(paths.end(), input_files.begin(), input_files.end());
+  paths.insert(paths.end(), options.overlay_files.begin(), options.overlay_files.end());
+  if (stable_id_file_path) {
+    paths.push_back(stable_id_file_path.value());
+  }
+
+  for (const std::string& path : paths) {
+    if (!AppendFileFingerprint(path, &fingerprint)) {
+      return {};
+    }
+  }
+  return fingerprint;
+}
+
+// Returns true if every output of a link with `options` is present.
+static bool LinkOutputsExist(const LinkOptions& options) {
+  std::vector<std::string> paths = {options.output_path};
+  paths.insert(paths.end(), options.split_paths.begin(), options.split_paths.end());
+  for (const Maybe<std::string>& path :
+       {options.generate_java_class_path, options.generate_text_symbols_path,
+        options.generate_proguard_rules_path, options.generate_main_dex_proguard_rules_path}) {
+    if (path) {
+      paths.push_back(path.value());
+    }
+  }
+
+  for (const std::string& path : paths) {
+    if (file::GetFileType(path) == file::FileType::kNonexistant) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes `contents` to `path`, unless the file already holds exactly these contents. Leaving an
+// unchanged file alone keeps its timestamp, so the build doesn't recompile an R.java whose IDs
+// are all the same as before.
+static bool WriteFileIfChanged(const std::string& path, const std::string& contents,
+                               std::string* out_error) {
+  std::string existing;
+  if (android::base::ReadFileToString(path, &existing) && existing == contents) {
+    return true;
+  }
+
+  if (!android::base::WriteStringToFile(contents, path)) {
+    *out_error = StringPrintf("failed writing to '%s': %s", path.c_str(),
+                              android::base::SystemErrorCodeToString(errno).c_str());
+    return false;
+  }
+  return true;
+}
+
 class LinkCommand {
  public:
   LinkCommand(LinkContext* context, const LinkOptions& options)
@@ -895,49 +1082,35 @@ class LinkCommand {
     }
   }
 
-  bool FlattenTable(ResourceTable* table, IArchiveWriter* writer) {
+  bool FlattenTable(IAaptContext* context, ResourceTable* table, IArchiveWriter* writer) {
     BigBuffer buffer(1024);
     TableFlattener flattener(options_.table_flattener_options, &buffer);
-    if (!flattener.Consume(context_, table)) {
-      context_->GetDiagnostics()->Error(DiagMessage() << "failed to flatten resource table");
+    if (!flattener.Consume(context, table)) {
+      context->GetDiagnostics()->Error(DiagMessage() << "failed to flatten resource table");
       return false;
     }
 
     io::BigBufferInputStream input_stream(&buffer);
-    return io::CopyInputStreamToArchive(context_, &input_stream, "resources.arsc",
+    return io::CopyInputStreamToArchive(context, &input_stream, "resources.arsc",
                                         ArchiveEntry::kAlign, writer);
   }
 
-  bool FlattenTableToPb(ResourceTable* table, IArchiveWriter* writer) {
+  bool FlattenTableToPb(IAaptContext* context, ResourceTable* table, IArchiveWriter* writer) {
     std::unique_ptr<pb::ResourceTable> pb_table = SerializeTableToPb(table);
-    return io::CopyProtoToArchive(context_, pb_table.get(), "resources.arsc.flat", 0, writer);
+    return io::CopyProtoToArchive(context, pb_table.get(), "resources.arsc.flat", 0, writer);
   }
 
-  bool WriteJavaFile(ResourceTable* table, const StringPiece& package_name_to_generate,
-                     const StringPiece& out_package, const JavaClassGeneratorOptions& java_options,
-                     const Maybe<std::string> out_text_symbols_path = {}) {
-    if (!options_.generate_java_class_path) {
+  // Writes an R.java with the symbols of `package_name_to_generate` into each of `out_packages`.
+  // The R class is the same in all of them, so it is generated once and only the package
+  // declaration differs. The files are written on up to options_.jobs threads.
+  bool WriteJavaFiles(ResourceTable* table, const StringPiece& package_name_to_generate,
+                      const std::vector<std::string>& out_packages,
+                      const JavaClassGeneratorOptions& java_options,
+                      const Maybe<std::string> out_text_symbols_path = {}) {
+    if (!options_.generate_java_class_path || out_packages.empty()) {
       return true;
     }
 
-    std::string out_path = options_.generate_java_class_path.value();
-    file::AppendPath(&out_path, file::PackageToPath(out_package));
-    if (!file::mkdirs(out_path)) {
-      context_->GetDiagnostics()->Error(DiagMessage() << "failed to create directory '" << out_path
-                                                      << "'");
-      return false;
-    }
-
-    file::AppendPath(&out_path, "R.java");
-
-    std::ofstream fout(out_path, std::ofstream::binary);
-    if (!fout) {
-      context_->GetDiagnostics()->Error(DiagMessage()
-                                        << "failed writing to '" << out_path
-                                        << "': " << android::base::SystemErrorCodeToString(errno));
-      return false;
-    }
-
     std::unique_ptr<std::ofstream> fout_text;
     if (out_text_symbols_path) {
       fout_text =
@@ -950,18 +1123,66 @@ class LinkCommand {
       }
     }
 
+    std::stringstream class_out;
     JavaClassGenerator generator(context_, table, java_options);
-    if (!generator.Generate(package_name_to_generate, out_package, &fout, fout_text.get())) {
-      context_->GetDiagnostics()->Error(DiagMessage(out_path) << generator.getError());
+    if (!generator.GenerateClass(package_name_to_generate, &class_out, fout_text.get())) {
+      context_->GetDiagnostics()->Error(DiagMessage(GetJavaFilePath(out_packages.front()))
+                                        << generator.getError());
       return false;
     }
+    const std::string r_class = class_out.str();
 
-    if (!fout) {
-      context_->GetDiagnostics()->Error(DiagMessage()
-                                        << "failed writing to '" << out_path
-                                        << "': " << android::base::SystemErrorCodeToString(errno));
+    std::vector<std::string> errors(out_packages.size());
+    std::atomic<size_t> next_package(0);
+    auto worker = [&]() {
+      size_t i;
+      while ((i = next_package.fetch_add(1)) < out_packages.size()) {
+        WriteJavaFile(out_packages[i], r_class, &errors[i]);
+      }
+    };
+
+    std::vector<std::thread> workers;
+    const size_t worker_count = std::min(options_.jobs, out_packages.size());
+    for (size_t i = 1; i < worker_count; i++) {
+      workers.emplace_back(worker);
     }
-    return true;
+    worker();
+    for (std::thread& t : workers) {
+      t.join();
+    }
+
+    bool error = false;
+    for (const std::string& error_str : errors) {
+      if (!error_str.empty()) {
+        context_->GetDiagnostics()->Error(DiagMessage() << error_str);
+        error = true;
+      }
+    }
+    return !error;
+  }
+
+  std::string GetJavaFilePath(const StringPiece& out_package) {
+    std::string out_path = options_.generate_java_class_path.value();
+    file::AppendPath(&out_path, file::PackageToPath(out_package));
+    file::AppendPath(&out_path, "R.java");
+    return out_path;
+  }
+
+  // Writes `r_class` as the R.java of `out_package`. Called concurrently, so errors are returned
+  // in `out_error` instead of being logged.
+  bool WriteJavaFile(const StringPiece& out_package, const std::string& r_class,
+                     std::string* out_error) {
+    const std::string out_path = GetJavaFilePath(out_package);
+    const StringPiece out_dir = file::GetStem(out_path);
+    if (!file::mkdirs(out_dir)) {
+      *out_error = StringPrintf("failed to create directory '%s'", out_dir.to_string().c_str());
+      return false;
+    }
+
+    std::stringstream contents;
+    ClassDefinition::WriteJavaFileHeader(out_package, &contents);
+    contents << r_class;
+    return WriteFileIfChanged(out_path, contents.str(), out_error);
   }
 
   bool WriteManifestJavaFile(xml::XmlResource* manifest_xml) {
@@ -1376,6 +1597,14 @@ class LinkCommand {
    */
   bool WriteApk(IArchiveWriter* writer, proguard::KeepSet* keep_set, xml::XmlResource* manifest,
                 ResourceTable* table) {
+    return WriteApkFiles(writer, keep_set, manifest, table) &&
+           WriteApkTable(context_, writer, table);
+  }
+
+  // Writes the manifest and the file resources of an APK. File resources may add versioned
+  // values to the table, so this must run before WriteApkTable().
+  bool WriteApkFiles(IArchiveWriter* writer, proguard::KeepSet* keep_set,
+                     xml::XmlResource* manifest, ResourceTable* table) {
     const bool keep_raw_values = context_->GetPackageType() == PackageType::kStaticLib;
     bool result = FlattenXml(context_, manifest, "AndroidManifest.xml", keep_raw_values, writer);
     if (!result) {
@@ -1392,6 +1621,7 @@ class LinkCommand {
     file_flattener_options.no_xml_namespaces = options_.no_xml_namespaces;
     file_flattener_options.update_proguard_spec =
         static_cast<bool>(options_.generate_proguard_rules_path);
+    file_flattener_options.jobs = options_.jobs;
 
     ResourceFileFlattener file_flattener(file_flattener_options, context_, keep_set);
 
@@ -1399,20 +1629,58 @@ class LinkCommand {
       context_->GetDiagnostics()->Error(DiagMessage() << "failed linking file resources");
       return false;
     }
+    return true;
+  }
 
-    if (context_->GetPackageType() == PackageType::kStaticLib) {
-      if (!FlattenTableToPb(table, writer)) {
+  // Flattens the table of an APK and writes it. This only touches `table` and `writer`, so the
+  // tables of different APKs can be written concurrently, each with its own `context`.
+  bool WriteApkTable(IAaptContext* context, IArchiveWriter* writer, ResourceTable* table) {
+    if (context->GetPackageType() == PackageType::kStaticLib) {
+      if (!FlattenTableToPb(context, table, writer)) {
         return false;
       }
     } else {
-      if (!FlattenTable(table, writer)) {
-        context_->GetDiagnostics()->Error(DiagMessage() << "failed to write resources.arsc");
+      if (!FlattenTable(context, table, writer)) {
+        context->GetDiagnostics()->Error(DiagMessage() << "failed to write resources.arsc");
         return false;
       }
     }
     return true;
   }
 
+  // Writes the table of each split into its archive, on up to options_.jobs threads. Diagnostics
+  // are replayed in split order once all tables are written.
+  bool WriteSplitTables(const std::vector<std::unique_ptr<ResourceTable>>& split_tables,
+                        const std::vector<std::unique_ptr<IArchiveWriter>>& split_writers) {
+    std::vector<BufferedDiagnostics> diagnostics(split_tables.size());
+    std::unique_ptr<bool[]> results(new bool[split_tables.size()]);
+    std::atomic<size_t> next_split(0);
+    auto worker = [&]() {
+      size_t i;
+      while ((i = next_split.fetch_add(1)) < split_tables.size()) {
+        DiagnosticsOverrideContext split_context(context_, &diagnostics[i]);
+        results[i] = WriteApkTable(&split_context, split_writers[i].get(), split_tables[i].get());
+      }
+    };
+
+    std::vector<std::thread> workers;
+    const size_t worker_count = std::min(options_.jobs, split_tables.size());
+    for (size_t i = 1; i < worker_count; i++) {
+      workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : workers) {
+      t.join();
+    }
+
+    bool error = false;
+    for (size_t i = 0; i < split_tables.size(); i++) {
+      diagnostics[i].Replay(context_->GetDiagnostics());
+      error |= !results[i];
+    }
+    return !error;
+  }
+
   int Run(const std::vector<std::string>& input_files) {
     // Load the AndroidManifest.xml
     std::unique_ptr<xml::XmlResource> manifest_xml =
@@ -1504,7 +1772,7 @@ class LinkCommand {
       }
 
       // Now grab each ID and emit it as a file.
-      if (options_.resource_id_map_path) {
+      if (options_.resource_id_map_path || options_.incremental_id_map_path) {
         for (auto& package : final_table_.packages) {
           for (auto& type : package->types) {
             for (auto& entry : type->entries) {
@@ -1516,10 +1784,17 @@ class LinkCommand {
           }
         }
 
-        if (!WriteStableIdMapToPath(context_->GetDiagnostics(), options_.stable_id_map,
+        if (options_.resource_id_map_path &&
+            !WriteStableIdMapToPath(context_->GetDiagnostics(), options_.stable_id_map,
                                     options_.resource_id_map_path.value())) {
           return 1;
         }
+
+        if (options_.incremental_id_map_path &&
+            !WriteStableIdMapToPath(context_->GetDiagnostics(), options_.stable_id_map,
+                                    options_.incremental_id_map_path.value())) {
+          return 1;
+        }
       }
     } else {
       // Static libs are merged with other apps, and ID collisions are bad, so
@@ -1551,7 +1826,7 @@ class LinkCommand {
           util::make_unique<FeatureSplitSymbolTableDelegate>(context_));
     }
 
-    ReferenceLinker linker;
+    ReferenceLinker linker(options_.jobs);
     if (!linker.Consume(context_, &final_table_)) {
       context_->GetDiagnostics()->Error(DiagMessage() << "failed linking references");
       return 1;
@@ -1614,16 +1889,21 @@ class LinkCommand {
       options_.split_constraints =
           AdjustSplitConstraintsForMinSdk(context_->GetMinSdkVersion(), options_.split_constraints);
 
+      options_.table_splitter_options.jobs = options_.jobs;
       TableSplitter table_splitter(options_.split_constraints, options_.table_splitter_options);
       if (!table_splitter.VerifySplitConstraints(context_)) {
         return 1;
       }
       table_splitter.SplitTable(&final_table_);
 
-      // Now we need to write out the Split APKs.
+      // Now we need to write out the Split APKs. The manifests and files are written one split at
+      // a time, since they read from the shared inputs, then all split tables are flattened
+      // concurrently.
+      std::vector<std::unique_ptr<ResourceTable>>& split_tables = table_splitter.splits();
+      std::vector<std::unique_ptr<IArchiveWriter>> split_writers;
       auto path_iter = options_.split_paths.begin();
       auto split_constraints_iter = options_.split_constraints.begin();
-      for (std::unique_ptr<ResourceTable>& split_table : table_splitter.splits()) {
+      for (std::unique_ptr<ResourceTable>& split_table : split_tables) {
         if (context_->IsVerbose()) {
           context_->GetDiagnostics()->Note(DiagMessage(*path_iter)
                                            << "generating split with configurations '"
@@ -1648,14 +1928,19 @@ class LinkCommand {
           return 1;
         }
 
-        if (!WriteApk(archive_writer.get(), &proguard_keep_set, split_manifest.get(),
-                      split_table.get())) {
+        if (!WriteApkFiles(archive_writer.get(), &proguard_keep_set, split_manifest.get(),
+                           split_table.get())) {
           return 1;
         }
+        split_writers.push_back(std::move(archive_writer));
 
         ++path_iter;
         ++split_constraints_iter;
       }
+
+      if (!WriteSplitTables(split_tables, split_writers)) {
+        return 1;
+      }
     }
 
     // Start writing the base APK.
@@ -1755,19 +2040,22 @@ class LinkCommand {
         // private package.
         JavaClassGeneratorOptions options = template_options;
         options.types = JavaClassGeneratorOptions::SymbolTypes::kPublicPrivate;
-        if (!WriteJavaFile(&final_table_, actual_package, options_.private_symbols.value(),
-                           options)) {
+        if (!WriteJavaFiles(&final_table_, actual_package, {options_.private_symbols.value()},
+                            options)) {
           return 1;
         }
       }
 
       // Generate all the symbols for all extra packages.
-      for (const std::string& extra_package : options_.extra_java_packages) {
-        packages_to_callback.push_back(extra_package);
+      if (!options_.extra_java_packages.empty()) {
+        const std::vector<std::string> extra_packages(options_.extra_java_packages.begin(),
+                                                      options_.extra_java_packages.end());
+        packages_to_callback.insert(packages_to_callback.end(), extra_packages.begin(),
+                                    extra_packages.end());
 
         JavaClassGeneratorOptions options = template_options;
         options.types = JavaClassGeneratorOptions::SymbolTypes::kAll;
-        if (!WriteJavaFile(&final_table_, actual_package, extra_package, options)) {
+        if (!WriteJavaFiles(&final_table_, actual_package, extra_packages, options)) {
           return 1;
         }
       }
@@ -1785,8 +2073,8 @@ class LinkCommand {
             std::move(packages_to_callback);
       }
 
-      if (!WriteJavaFile(&final_table_, actual_package, output_package, options,
-                         options_.generate_text_symbols_path)) {
+      if (!WriteJavaFiles(&final_table_, actual_package, {output_package.to_string()}, options,
+                          options_.generate_text_symbols_path)) {
         return 1;
       }
     }
@@ -1839,6 +2127,8 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   bool shared_lib = false;
   bool static_lib = false;
   Maybe<std::string> stable_id_file_path;
+  Maybe<std::string> incremental_dir;
+  Maybe<std::string> jobs;
   std::vector<std::string> split_args;
   Flags flags =
       Flags()
@@ -1931,6 +2221,11 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
                         "Emit a file at the given path with a list of name to ID mappings,\n"
                         "suitable for use with --stable-ids.",
                         &options.resource_id_map_path)
+          .OptionalFlag("--incremental-dir",
+                        "Directory in which to keep state between links of the same app.\n"
+                        "Resource IDs are kept stable across links, and the link is skipped\n"
+                        "when no input or flag changed since the last successful one.",
+                        &incremental_dir)
           .OptionalFlag("--private-symbols",
                         "Package name to use when generating R.java for private symbols.\n"
                         "If not specified, public and private symbols will use the application's\n"
@@ -1965,6 +2260,10 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
                             "Syntax: path/to/output.apk:<config>[,<config>[...]].\n"
                             "On Windows, use a semicolon ';' separator instead.",
                             &split_args)
+          .OptionalFlag("--jobs",
+                        "Number of threads used to link references and XML files. Output is\n"
+                        "identical to a link on a single thread. Defaults to 1.",
+                        &jobs)
           .OptionalSwitch("-v", "Enables verbose logging.", &verbose);
 
   if (!flags.Parse("aapt2 link", args, &std::cerr)) {
@@ -2021,6 +2320,16 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
     context.SetPackageId(kAppPackageId);
   }
 
+  if (jobs) {
+    const Maybe<uint32_t> maybe_jobs = ResourceUtils::ParseInt(jobs.value());
+    if (!maybe_jobs || maybe_jobs.value() == 0) {
+      context.GetDiagnostics()->Error(DiagMessage() << "--jobs '" << jobs.value()
+                                                    << "' is not a positive integer");
+      return 1;
+    }
+    options.jobs = maybe_jobs.value();
+  }
+
   if (package_id) {
     if (context.GetPackageType() != PackageType::kApp) {
       context.GetDiagnostics()->Error(
@@ -2110,8 +2419,59 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
     options.no_version_transitions = true;
   }
 
+  std::string fingerprint_path;
+  Maybe<std::string> fingerprint;
+  if (incremental_dir) {
+    if (!file::mkdirs(incremental_dir.value())) {
+      context.GetDiagnostics()->Error(DiagMessage(incremental_dir.value())
+                                      << "failed to create incremental directory: "
+                                      << android::base::SystemErrorCodeToString(errno));
+      return 1;
+    }
+
+    fingerprint_path = incremental_dir.value();
+    file::AppendPath(&fingerprint_path, "fingerprint.txt");
+    fingerprint = ComputeLinkFingerprint(args, options, arg_list, stable_id_file_path);
+
+    std::string last_fingerprint;
+    if (fingerprint && LinkOutputsExist(options) &&
+        android::base::ReadFileToString(fingerprint_path, &last_fingerprint) &&
+        last_fingerprint == fingerprint.value()) {
+      if (context.IsVerbose()) {
+        context.GetDiagnostics()->Note(DiagMessage()
+                                       << "inputs unchanged since last link, skipping");
+      }
+      return 0;
+    }
+
+    // The fingerprint is only written back once this link succeeds.
+    unlink(fingerprint_path.data());
+
+    if (context.GetPackageType() != PackageType::kStaticLib) {
+      std::string id_map_path = incremental_dir.value();
+      file::AppendPath(&id_map_path, "ids.txt");
+
+      // Explicitly given stable IDs take precedence over the ones from the last link.
+      if (!stable_id_file_path &&
+          file::GetFileType(id_map_path) == file::FileType::kRegular &&
+          !LoadStableIdMap(context.GetDiagnostics(), id_map_path, &options.stable_id_map)) {
+        return 1;
+      }
+      options.incremental_id_map_path = id_map_path;
+    }
+  }
+
+  // Allocate the tables and values of this link from the context's arena. They are all freed
+  // at once when the context goes away, which is much faster than freeing each of them.
+  ArenaScope arena_scope(context.GetArena());
   LinkCommand cmd(&context, options);
-  return cmd.Run(arg_list);
+  const int result = cmd.Run(arg_list);
+  if (result == 0 && fingerprint &&
+      !android::base::WriteStringToFile(fingerprint.value(), fingerprint_path)) {
+    context.GetDiagnostics()->Warn(DiagMessage(fingerprint_path)
+                                   << "failed to write link fingerprint");
+  }
+  return result;
 }
 
 }  // namespace aapt
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compile/CompileCache.h"
+
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+
+#include "android-base/errors.h"
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+
+#include "util/Files.h"
+
+using android::StringPiece;
+using android::base::StringPrintf;
+
+namespace aapt {
+
+// Bump this whenever the output of compiling a file changes, so that entries written by older
+// versions of aapt2 are no longer found.
+constexpr static uint32_t kCacheVersion = 1u;
+
+constexpr static uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr static uint64_t kFnvPrime = 0x100000001b3ull;
+
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t len) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ bytes[i]) * kFnvPrime;
+  }
+  return hash;
+}
+
+static uint64_t HashString(uint64_t hash, const StringPiece& str) {
+  // Hash the length as well, so that the boundary between strings is part of the key.
+  const uint64_t len = str.size();
+  hash = HashBytes(hash, &len, sizeof(len));
+  return HashBytes(hash, str.data(), str.size());
+}
+
+CompileCache::CompileCache(const StringPiece& dir) : dir_(dir.to_string()) {
+}
+
+std::string CompileCache::ComputeKey(const StringPiece& salt, const StringPiece& contents) {
+  uint64_t hash = HashBytes(kFnvOffsetBasis, &kCacheVersion, sizeof(kCacheVersion));
+  hash = HashString(hash, salt);
+  hash = HashString(hash, contents);
+
+  // A second, independent checksum of the contents makes accidental collisions a non-issue.
+  const uint32_t crc = static_cast<uint32_t>(
+      crc32(0u, reinterpret_cast<const Bytef*>(contents.data()), contents.size()));
+  return StringPrintf("%016" PRIx64 "%08x%zx", hash, crc, contents.size());
+}
+
+std::string CompileCache::GetEntryPath(const std::string& key) const {
+  std::string path = dir_;
+  file::AppendPath(&path, key + ".flat");
+  return path;
+}
+
+bool CompileCache::Lookup(const std::string& key, std::string* out_data) const {
+  const std::string path = GetEntryPath(key);
+  if (file::GetFileType(path) != file::FileType::kRegular) {
+    return false;
+  }
+  return android::base::ReadFileToString(path, out_data);
+}
+
+bool CompileCache::Store(const std::string& key, const BigBuffer& data, IDiagnostics* diag) const {
+  const std::string path = GetEntryPath(key);
+
+  // Write to a file private to this process first, then move it into place.
+  const std::string tmp_path = StringPrintf("%s.%d.tmp", path.c_str(), getpid());
+  {
+    std::unique_ptr<FILE, decltype(fclose)*> f = {fopen(tmp_path.data(), "wb"), fclose};
+    if (!f) {
+      diag->Warn(DiagMessage(tmp_path) << "failed to write compile cache entry: "
+                                       << android::base::SystemErrorCodeToString(errno));
+      return false;
+    }
+
+    for (const BigBuffer::Block& block : data) {
+      if (fwrite(block.buffer.get(), 1, block.size, f.get()) != block.size) {
+        diag->Warn(DiagMessage(tmp_path) << "failed to write compile cache entry: "
+                                         << android::base::SystemErrorCodeToString(errno));
+        f.reset(nullptr);
+        unlink(tmp_path.data());
+        return false;
+      }
+    }
+  }
+
+  if (rename(tmp_path.data(), path.data()) != 0) {
+    // Another build may have stored the same entry first, which is just as good.
+    unlink(tmp_path.data());
+    return file::GetFileType(path) == file::FileType::kRegular;
+  }
+  return true;
+}
+
+}  // namespace aapt
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_COMPILE_COMPILECACHE_H
+#define AAPT_COMPILE_COMPILECACHE_H
+
+#include <string>
+
+#include "android-base/macros.h"
+#include "androidfw/StringPiece.h"
+
+#include "Diagnostics.h"
+#include "util/BigBuffer.h"
+
+namespace aapt {
+
+// A persistent, content-addressed cache of compiled resource files. Each entry holds the .flat
+// container produced by compiling one input file, keyed by the contents of that file and
+// everything else that goes into the output. Entries are never invalidated, only replaced, so
+// the directory can be shared by concurrent and unrelated builds.
+class CompileCache {
+ public:
+  explicit CompileCache(const android::StringPiece& dir);
+
+  // Returns the key of the output of compiling a file with `contents`. `salt` must identify
+  // everything other than the contents that the output depends on, such as the path of the file
+  // and the compile options.
+  static std::string ComputeKey(const android::StringPiece& salt,
+                                const android::StringPiece& contents);
+
+  // Reads the entry for `key` into `out_data`. Returns false if there is no such entry.
+  bool Lookup(const std::string& key, std::string* out_data) const;
+
+  // Writes `data` as the entry for `key`. The entry is published atomically, so readers never
+  // see a partial entry. Failures are reported as warnings, since the cache is only an
+  // optimization.
+  bool Store(const std::string& key, const BigBuffer& data, IDiagnostics* diag) const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CompileCache);
+
+  std::string GetEntryPath(const std::string& key) const;
+
+  std::string dir_;
+};
+
+}  // namespace aapt
+
+#endif /* AAPT_COMPILE_COMPILECACHE_H */
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compile/CompileCache.h"
+
+#include "test/Test.h"
+
+namespace aapt {
+
+TEST(CompileCacheTest, KeyDependsOnSaltAndContents) {
+  const std::string key = CompileCache::ComputeKey("res/values/strings.xml", "<resources/>");
+  EXPECT_EQ(key, CompileCache::ComputeKey("res/values/strings.xml", "<resources/>"));
+  EXPECT_NE(key, CompileCache::ComputeKey("res/values-en/strings.xml", "<resources/>"));
+  EXPECT_NE(key, CompileCache::ComputeKey("res/values/strings.xml", "<resources />"));
+
+  // Moving bytes between the salt and the contents must change the key.
+  EXPECT_NE(CompileCache::ComputeKey("ab", "c"), CompileCache::ComputeKey("a", "bc"));
+}
+
+TEST(CompileCacheTest, LookupMissesWithoutEntry) {
+  CompileCache cache("/this/directory/does/not/exist");
+  std::string data;
+  EXPECT_FALSE(cache.Lookup(CompileCache::ComputeKey("salt", "contents"), &data));
+}
+
+}  // namespace aapt
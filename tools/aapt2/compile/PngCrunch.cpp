@@ -20,8 +20,11 @@
 #include <zlib.h>
 
 #include <algorithm>
+#include <functional>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "android-base/errors.h"
 #include "android-base/logging.h"
@@ -475,6 +478,194 @@ static void WriteNinePatch(png_structp write_ptr, png_infop write_info_ptr,
   png_set_unknown_chunks(write_ptr, write_info_ptr, unknown_chunks, index);
 }
 
+// The largest number of colors a PNG palette can hold.
+constexpr static size_t kMaxPaletteSize = 256u;
+
+// Images with fewer pixels than this per available thread are analyzed and converted on the
+// calling thread only.
+constexpr static size_t kMinPixelsPerRowBand = 256u * 1024u;
+
+// Returns the number of horizontal bands `image` should be split into, one per thread.
+static size_t RowBandCount(const Image* image) {
+  const size_t pixels = static_cast<size_t>(image->width) * static_cast<size_t>(image->height);
+  const size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  return std::max<size_t>(
+      std::min({threads, pixels / kMinPixelsPerRowBand, static_cast<size_t>(image->height)}), 1u);
+}
+
+// Splits the rows of `image` into `band_count` contiguous bands and invokes `func` with the
+// band index and its [start_row, end_row) range for each one. The first band runs on the calling
+// thread and the rest on their own threads. Returns once every band has been processed.
+static void ForEachRowBand(const Image* image, size_t band_count,
+                           const std::function<void(size_t, int32_t, int32_t)>& func) {
+  const int32_t rows_per_band = static_cast<int32_t>(image->height / band_count);
+  auto band_start = [&](size_t band) -> int32_t {
+    return band == band_count ? image->height : static_cast<int32_t>(band) * rows_per_band;
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t band = 1; band < band_count; band++) {
+    threads.emplace_back(func, band, band_start(band), band_start(band + 1));
+  }
+  func(0, band_start(0), band_start(1));
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// The result of scanning a contiguous range of rows of an image.
+struct RowBandAnalysis {
+  // The distinct RGBA colors of the band in the order they first appear, with the color channels
+  // of transparent pixels zeroed. Stops growing once it holds more than kMaxPaletteSize colors.
+  std::vector<uint32_t> colors;
+
+  // True if some transparent pixel has non-zero color channels.
+  bool needs_to_zero_rgb_channels_of_transparent_pixels = false;
+
+  // True if some pixel is not fully opaque.
+  bool has_alpha = false;
+
+  // The largest difference between any two color channels of a pixel.
+  int max_gray_deviation = 0;
+};
+
+static void AnalyzeRows(const Image* image, int32_t start_row, int32_t end_row,
+                        RowBandAnalysis* out_analysis) {
+  std::unordered_set<uint32_t> seen_colors;
+  bool palette_overflow = false;
+  uint32_t last_color = 0;
+  bool has_last_color = false;
+
+  for (int32_t y = start_row; y < end_row; y++) {
+    const uint8_t* row = image->rows[y];
+
+    // Channel statistics. This loop is kept free of branches and lookups so the compiler can
+    // vectorize it; it is where the time goes for images that don't fit in a palette.
+    bool needs_zero = false;
+    bool has_alpha = false;
+    int max_deviation = 0;
+    for (int32_t x = 0; x < image->width; x++) {
+      const int alpha = row[x * 4 + 3];
+      // For purposes of palettes and grayscale optimization, treat all channels of a completely
+      // transparent pixel as 0x00.
+      const int mask = alpha == 0 ? 0x00 : 0xff;
+      const int red = row[x * 4] & mask;
+      const int green = row[x * 4 + 1] & mask;
+      const int blue = row[x * 4 + 2] & mask;
+
+      needs_zero |= (row[x * 4] | row[x * 4 + 1] | row[x * 4 + 2]) != 0 && alpha == 0;
+      has_alpha |= alpha != 0xff;
+      max_deviation = std::max(max_deviation, std::abs(red - green));
+      max_deviation = std::max(max_deviation, std::abs(green - blue));
+      max_deviation = std::max(max_deviation, std::abs(blue - red));
+    }
+    out_analysis->needs_to_zero_rgb_channels_of_transparent_pixels |= needs_zero;
+    out_analysis->has_alpha |= has_alpha;
+    out_analysis->max_gray_deviation = std::max(out_analysis->max_gray_deviation, max_deviation);
+
+    if (palette_overflow) {
+      continue;
+    }
+
+    // Collect the palette. Runs of the same color are common, so skip the set lookup for them.
+    for (int32_t x = 0; x < image->width; x++) {
+      const uint32_t alpha = row[x * 4 + 3];
+      uint32_t color = 0;
+      if (alpha != 0) {
+        color = static_cast<uint32_t>(row[x * 4]) << 24 |
+                static_cast<uint32_t>(row[x * 4 + 1]) << 16 |
+                static_cast<uint32_t>(row[x * 4 + 2]) << 8 | alpha;
+      }
+
+      if (has_last_color && color == last_color) {
+        continue;
+      }
+      last_color = color;
+      has_last_color = true;
+
+      if (seen_colors.insert(color).second) {
+        out_analysis->colors.push_back(color);
+        if (out_analysis->colors.size() > kMaxPaletteSize) {
+          palette_overflow = true;
+          break;
+        }
+      }
+    }
+  }
+}
+
+// Converts a row of RGBA pixels to palette indices.
+static void ConvertRowToPalette(const png_byte* in_row, int32_t width,
+                                const std::unordered_map<uint32_t, int>& color_palette,
+                                png_byte* out_row) {
+  for (int32_t x = 0; x < width; x++) {
+    int rr = *in_row++;
+    int gg = *in_row++;
+    int bb = *in_row++;
+    int aa = *in_row++;
+    if (aa == 0) {
+      // Zero out color channels when transparent.
+      rr = gg = bb = 0;
+    }
+
+    const uint32_t color = rr << 24 | gg << 16 | bb << 8 | aa;
+    const auto iter = color_palette.find(color);
+    CHECK(iter != color_palette.end() && iter->second != -1);
+    out_row[x] = static_cast<png_byte>(iter->second);
+  }
+}
+
+// Converts a row of RGBA pixels to grayscale, with alpha if `bpp` is 2.
+static void ConvertRowToGrayscale(const png_byte* in_row, int32_t width, bool grayscale,
+                                  size_t bpp, png_byte* out_row) {
+  for (int32_t x = 0; x < width; x++) {
+    int rr = in_row[x * 4];
+    int gg = in_row[x * 4 + 1];
+    int bb = in_row[x * 4 + 2];
+    int aa = in_row[x * 4 + 3];
+    if (aa == 0) {
+      // Zero out the gray channel when transparent.
+      rr = gg = bb = 0;
+    }
+
+    if (grayscale) {
+      // The image was already grayscale, red == green == blue.
+      out_row[x * bpp] = in_row[x * 4];
+    } else {
+      // The image is convertible to grayscale, use linear-luminance of
+      // sRGB colorspace:
+      // https://en.wikipedia.org/wiki/Grayscale#Colorimetric_.28luminance-preserving.29_conversion_to_grayscale
+      out_row[x * bpp] = (png_byte)(rr * 0.2126f + gg * 0.7152f + bb * 0.0722f);
+    }
+
+    if (bpp == 2) {
+      // Write out alpha if we have it.
+      out_row[x * bpp + 1] = aa;
+    }
+  }
+}
+
+// Converts a row of RGBA pixels to RGB (`bpp` is 3) or RGBA (`bpp` is 4), zeroing out the
+// color channels of transparent pixels.
+static void ConvertRowToRgb(const png_byte* in_row, int32_t width, size_t bpp, png_byte* out_row) {
+  for (int32_t x = 0; x < width; x++) {
+    int rr = *in_row++;
+    int gg = *in_row++;
+    int bb = *in_row++;
+    int aa = *in_row++;
+    if (aa == 0) {
+      // Zero out the RGB channels when transparent.
+      rr = gg = bb = 0;
+    }
+    out_row[x * bpp] = rr;
+    out_row[x * bpp + 1] = gg;
+    out_row[x * bpp + 2] = bb;
+    if (bpp == 4) {
+      out_row[x * bpp + 3] = aa;
+    }
+  }
+}
+
 bool WritePng(IAaptContext* context, const Image* image,
               const NinePatch* nine_patch, io::OutputStream* out,
               const PngOptions& options) {
@@ -519,60 +710,58 @@ bool WritePng(IAaptContext* context, const Image* image,
   // 1. Every pixel has R == G == B (grayscale)
   // 2. Every pixel has A == 255 (opaque)
   // 3. There are no more than 256 distinct RGBA colors (palette).
+  // The bands are scanned in parallel for large images, then merged in row order so the result
+  // (including the order colors are inserted into the palettes, which decides their indices) is the
+  // same as that of a single pass over the image.
+  const size_t band_count = RowBandCount(image);
+  std::vector<RowBandAnalysis> band_analyses(band_count);
+  ForEachRowBand(image, band_count, [&](size_t band, int32_t start_row, int32_t end_row) {
+    AnalyzeRows(image, start_row, end_row, &band_analyses[band]);
+  });
+
   std::unordered_map<uint32_t, int> color_palette;
   std::unordered_set<uint32_t> alpha_palette;
+  bool palette_overflow = false;
   bool needs_to_zero_rgb_channels_of_transparent_pixels = false;
-  bool grayscale = true;
+  bool has_alpha = false;
   int max_gray_deviation = 0;
-
-  for (int32_t y = 0; y < image->height; y++) {
-    const uint8_t* row = image->rows[y];
-    for (int32_t x = 0; x < image->width; x++) {
-      int red = *row++;
-      int green = *row++;
-      int blue = *row++;
-      int alpha = *row++;
-
-      if (alpha == 0) {
-        // The color is completely transparent.
-        // For purposes of palettes and grayscale optimization,
-        // treat all channels as 0x00.
-        needs_to_zero_rgb_channels_of_transparent_pixels =
-            needs_to_zero_rgb_channels_of_transparent_pixels ||
-            (red != 0 || green != 0 || blue != 0);
-        red = green = blue = 0;
-      }
-
-      // Insert the color into the color palette.
-      const uint32_t color = red << 24 | green << 16 | blue << 8 | alpha;
-      color_palette[color] = -1;
-
-      // If the pixel has non-opaque alpha, insert it into the
-      // alpha palette.
-      if (alpha != 0xff) {
-        alpha_palette.insert(color);
+  for (const RowBandAnalysis& band_analysis : band_analyses) {
+    needs_to_zero_rgb_channels_of_transparent_pixels |=
+        band_analysis.needs_to_zero_rgb_channels_of_transparent_pixels;
+    has_alpha |= band_analysis.has_alpha;
+    max_gray_deviation = std::max(max_gray_deviation, band_analysis.max_gray_deviation);
+
+    for (uint32_t color : band_analysis.colors) {
+      if (palette_overflow) {
+        break;
       }
 
-      // Check if the image is indeed grayscale.
-      if (grayscale) {
-        if (red != green || red != blue) {
-          grayscale = false;
+      if (color_palette.insert({color, -1}).second) {
+        // If the pixel has non-opaque alpha, insert it into the alpha palette.
+        if ((color & 0x000000ff) != 0xff) {
+          alpha_palette.insert(color);
         }
+        palette_overflow = color_palette.size() > kMaxPaletteSize;
       }
-
-      // Calculate the gray scale deviation so that it can be compared
-      // with the threshold.
-      max_gray_deviation = std::max(std::abs(red - green), max_gray_deviation);
-      max_gray_deviation = std::max(std::abs(green - blue), max_gray_deviation);
-      max_gray_deviation = std::max(std::abs(blue - red), max_gray_deviation);
     }
   }
 
+  // Every pixel has R == G == B.
+  const bool grayscale = max_gray_deviation == 0;
+
+  // Once the image is known not to fit in a palette, only whether it has any alpha at all matters.
+  const size_t color_palette_size = color_palette.size();
+  const size_t alpha_palette_size =
+      palette_overflow ? (has_alpha ? kMaxPaletteSize + 1 : 0) : alpha_palette.size();
+
   if (context->IsVerbose()) {
     DiagMessage msg;
-    msg << " paletteSize=" << color_palette.size()
-        << " alphaPaletteSize=" << alpha_palette.size()
-        << " maxGrayDeviation=" << max_gray_deviation
+    if (palette_overflow) {
+      msg << " paletteSize>" << kMaxPaletteSize;
+    } else {
+      msg << " paletteSize=" << color_palette_size << " alphaPaletteSize=" << alpha_palette_size;
+    }
+    msg << " maxGrayDeviation=" << max_gray_deviation
         << " grayScale=" << (grayscale ? "true" : "false");
     context->GetDiagnostics()->Note(msg);
   }
@@ -581,7 +770,7 @@ bool WritePng(IAaptContext* context, const Image* image,
 
   const int new_color_type = PickColorType(
       image->width, image->height, grayscale, convertible_to_grayscale,
-      nine_patch != nullptr, color_palette.size(), alpha_palette.size());
+      nine_patch != nullptr, color_palette_size, alpha_palette_size);
 
   if (context->IsVerbose()) {
     DiagMessage msg;
@@ -632,107 +821,58 @@ bool WritePng(IAaptContext* context, const Image* image,
   // Flush our updates to the header.
   png_write_info(write_ptr, write_info_ptr);
 
-  // Write out each row of image data according to its encoding.
+  // Write out each row of image data according to its encoding. Rows that need converting are
+  // converted in bands, in parallel for large images, and then handed to libpng in order.
+  size_t out_bpp = 0;
+  std::function<void(const png_byte*, png_byte*)> convert_row;
   if (new_color_type == PNG_COLOR_TYPE_PALETTE) {
     // 1 byte/pixel.
-    auto out_row = std::unique_ptr<png_byte[]>(new png_byte[image->width]);
-
-    for (int32_t y = 0; y < image->height; y++) {
-      png_const_bytep in_row = image->rows[y];
-      for (int32_t x = 0; x < image->width; x++) {
-        int rr = *in_row++;
-        int gg = *in_row++;
-        int bb = *in_row++;
-        int aa = *in_row++;
-        if (aa == 0) {
-          // Zero out color channels when transparent.
-          rr = gg = bb = 0;
-        }
-
-        const uint32_t color = rr << 24 | gg << 16 | bb << 8 | aa;
-        const int idx = color_palette[color];
-        CHECK(idx != -1);
-        out_row[x] = static_cast<png_byte>(idx);
-      }
-      png_write_row(write_ptr, out_row.get());
-    }
+    out_bpp = 1;
+    convert_row = [&](const png_byte* in_row, png_byte* out_row) {
+      ConvertRowToPalette(in_row, image->width, color_palette, out_row);
+    };
   } else if (new_color_type == PNG_COLOR_TYPE_GRAY ||
              new_color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
-    const size_t bpp = new_color_type == PNG_COLOR_TYPE_GRAY ? 1 : 2;
-    auto out_row =
-        std::unique_ptr<png_byte[]>(new png_byte[image->width * bpp]);
-
-    for (int32_t y = 0; y < image->height; y++) {
-      png_const_bytep in_row = image->rows[y];
-      for (int32_t x = 0; x < image->width; x++) {
-        int rr = in_row[x * 4];
-        int gg = in_row[x * 4 + 1];
-        int bb = in_row[x * 4 + 2];
-        int aa = in_row[x * 4 + 3];
-        if (aa == 0) {
-          // Zero out the gray channel when transparent.
-          rr = gg = bb = 0;
-        }
-
-        if (grayscale) {
-          // The image was already grayscale, red == green == blue.
-          out_row[x * bpp] = in_row[x * 4];
-        } else {
-          // The image is convertible to grayscale, use linear-luminance of
-          // sRGB colorspace:
-          // https://en.wikipedia.org/wiki/Grayscale#Colorimetric_.28luminance-preserving.29_conversion_to_grayscale
-          out_row[x * bpp] =
-              (png_byte)(rr * 0.2126f + gg * 0.7152f + bb * 0.0722f);
-        }
-
-        if (bpp == 2) {
-          // Write out alpha if we have it.
-          out_row[x * bpp + 1] = aa;
-        }
-      }
-      png_write_row(write_ptr, out_row.get());
-    }
+    out_bpp = new_color_type == PNG_COLOR_TYPE_GRAY ? 1 : 2;
+    convert_row = [&](const png_byte* in_row, png_byte* out_row) {
+      ConvertRowToGrayscale(in_row, image->width, grayscale, out_bpp, out_row);
+    };
   } else if (new_color_type == PNG_COLOR_TYPE_RGB || new_color_type == PNG_COLOR_TYPE_RGBA) {
-    const size_t bpp = new_color_type == PNG_COLOR_TYPE_RGB ? 3 : 4;
     if (needs_to_zero_rgb_channels_of_transparent_pixels) {
       // The source RGBA data can't be used as-is, because we need to zero out
       // the RGB values of transparent pixels.
-      auto out_row = std::unique_ptr<png_byte[]>(new png_byte[image->width * bpp]);
-
-      for (int32_t y = 0; y < image->height; y++) {
-        png_const_bytep in_row = image->rows[y];
-        for (int32_t x = 0; x < image->width; x++) {
-          int rr = *in_row++;
-          int gg = *in_row++;
-          int bb = *in_row++;
-          int aa = *in_row++;
-          if (aa == 0) {
-            // Zero out the RGB channels when transparent.
-            rr = gg = bb = 0;
-          }
-          out_row[x * bpp] = rr;
-          out_row[x * bpp + 1] = gg;
-          out_row[x * bpp + 2] = bb;
-          if (bpp == 4) {
-            out_row[x * bpp + 3] = aa;
-          }
-        }
-        png_write_row(write_ptr, out_row.get());
-      }
-    } else {
-      // The source image can be used as-is, just tell libpng whether or not to
-      // ignore the alpha channel.
-      if (new_color_type == PNG_COLOR_TYPE_RGB) {
-        // Delete the extraneous alpha values that we appended to our buffer
-        // when reading the original values.
-        png_set_filler(write_ptr, 0, PNG_FILLER_AFTER);
-      }
-      png_write_image(write_ptr, image->rows.get());
+      out_bpp = new_color_type == PNG_COLOR_TYPE_RGB ? 3 : 4;
+      convert_row = [&](const png_byte* in_row, png_byte* out_row) {
+        ConvertRowToRgb(in_row, image->width, out_bpp, out_row);
+      };
     }
   } else {
     LOG(FATAL) << "unreachable";
   }
 
+  if (convert_row) {
+    const size_t out_stride = static_cast<size_t>(image->width) * out_bpp;
+    auto out_data = std::unique_ptr<png_byte[]>(new png_byte[out_stride * image->height]);
+    ForEachRowBand(image, band_count, [&](size_t, int32_t start_row, int32_t end_row) {
+      for (int32_t y = start_row; y < end_row; y++) {
+        convert_row(image->rows[y], out_data.get() + y * out_stride);
+      }
+    });
+
+    for (int32_t y = 0; y < image->height; y++) {
+      png_write_row(write_ptr, out_data.get() + y * out_stride);
+    }
+  } else {
+    // The source image can be used as-is, just tell libpng whether or not to
+    // ignore the alpha channel.
+    if (new_color_type == PNG_COLOR_TYPE_RGB) {
+      // Delete the extraneous alpha values that we appended to our buffer
+      // when reading the original values.
+      png_set_filler(write_ptr, 0, PNG_FILLER_AFTER);
+    }
+    png_write_image(write_ptr, image->rows.get());
+  }
+
   png_write_end(write_ptr, write_info_ptr);
   return true;
 }
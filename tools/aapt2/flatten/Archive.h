@@ -70,6 +70,10 @@ class IArchiveWriter : public ::google::protobuf::io::CopyingOutputStream {
   virtual std::string GetError() const = 0;
 };
 
+// Returns true if compressing `uncompressed_size` bytes to `compressed_size` bytes saves enough
+// for the entry to be kept compressed. This preserves the behavior of AAPT.
+bool IsCompressedEnough(size_t compressed_size, size_t uncompressed_size);
+
 std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(IDiagnostics* diag,
                                                              const android::StringPiece& path);
 
@@ -215,6 +215,46 @@ class MapFlattenVisitor : public RawValueVisitor {
   size_t entry_count_ = 0;
 };
 
+/**
+ * Computes the number of bytes PackageFlattener::FlattenValue() writes for a value, so that all
+ * the values of a type chunk can be flattened into a single allocation.
+ */
+class FlattenedSizeVisitor : public RawValueVisitor {
+ public:
+  using RawValueVisitor::Visit;
+
+  void VisitItem(Item* item) override { size = sizeof(ResTable_entry) + sizeof(Res_value); }
+
+  void Visit(Attribute* attr) override {
+    size_t count = attr->symbols.size() + 1;
+    if (attr->min_int != std::numeric_limits<int32_t>::min()) {
+      count++;
+    }
+    if (attr->max_int != std::numeric_limits<int32_t>::max()) {
+      count++;
+    }
+    SetMapSize(count);
+  }
+
+  void Visit(Style* style) override { SetMapSize(style->entries.size()); }
+
+  void Visit(Styleable* styleable) override { SetMapSize(styleable->entries.size()); }
+
+  void Visit(Array* array) override { SetMapSize(array->items.size()); }
+
+  void Visit(Plural* plural) override {
+    SetMapSize(std::count_if(plural->values.begin(), plural->values.end(),
+                             [](const std::unique_ptr<Item>& item) { return item != nullptr; }));
+  }
+
+  size_t size = 0;
+
+ private:
+  void SetMapSize(size_t count) {
+    size = sizeof(ResTable_entry_ext) + count * sizeof(ResTable_map);
+  }
+};
+
 class PackageFlattener {
  public:
   PackageFlattener(IAaptContext* context, ResourceTablePackage* package,
@@ -327,7 +367,15 @@ class PackageFlattener {
     std::vector<uint32_t> offsets;
     offsets.resize(num_total_entries, 0xffffffffu);
 
-    BigBuffer values_buffer(512);
+    // Size the values buffer to hold all the values, so that they end up in a single block.
+    size_t values_size = 0;
+    for (FlatEntry& flat_entry : *entries) {
+      FlattenedSizeVisitor size_visitor;
+      flat_entry.value->Accept(&size_visitor);
+      values_size += size_visitor.size;
+    }
+
+    BigBuffer values_buffer(std::max<size_t>(values_size, 1u));
     for (FlatEntry& flat_entry : *entries) {
       CHECK(static_cast<size_t>(flat_entry.entry->id.value()) < num_total_entries);
       offsets[flat_entry.entry->id.value()] = values_buffer.size();
@@ -58,6 +58,40 @@ static bool cmp_xml_attribute_by_id(const xml::Attribute* a,
   return false;
 }
 
+// Computes the number of bytes XmlFlattenerVisitor writes for the nodes of a document, so that
+// they can be flattened into a single allocation.
+class FlattenedSizeVisitor : public xml::Visitor {
+ public:
+  using xml::Visitor::Visit;
+
+  void Visit(xml::Namespace* node) override {
+    if (node->namespace_uri != xml::kSchemaTools) {
+      // Start and end namespace.
+      size += 2 * (sizeof(ResXMLTree_node) + sizeof(ResXMLTree_namespaceExt));
+    }
+    xml::Visitor::Visit(node);
+  }
+
+  void Visit(xml::Text* node) override {
+    if (!util::TrimWhitespace(node->text).empty()) {
+      size += sizeof(ResXMLTree_node) + sizeof(ResXMLTree_cdataExt);
+    }
+  }
+
+  void Visit(xml::Element* node) override {
+    size += sizeof(ResXMLTree_node) + sizeof(ResXMLTree_attrExt);
+    for (const xml::Attribute& attr : node->attributes) {
+      if (attr.namespace_uri != xml::kSchemaTools) {
+        size += sizeof(ResXMLTree_attribute);
+      }
+    }
+    size += sizeof(ResXMLTree_node) + sizeof(ResXMLTree_endElementExt);
+    xml::Visitor::Visit(node);
+  }
+
+  size_t size = 0;
+};
+
 class XmlFlattenerVisitor : public xml::Visitor {
  public:
   using xml::Visitor::Visit;
@@ -297,7 +331,11 @@ class XmlFlattenerVisitor : public xml::Visitor {
 }  // namespace
 
 bool XmlFlattener::Flatten(IAaptContext* context, xml::Node* node) {
-  BigBuffer node_buffer(1024);
+  // Size the node buffer to hold the whole document, so that it ends up in a single block.
+  FlattenedSizeVisitor size_visitor;
+  node->Accept(&size_visitor);
+
+  BigBuffer node_buffer(std::max<size_t>(size_visitor.size, 1u));
   XmlFlattenerVisitor visitor(&node_buffer, options_);
   node->Accept(&visitor);
 
@@ -25,6 +25,7 @@
 
 #include "Source.h"
 #include "io/Data.h"
+#include "util/Maybe.h"
 #include "util/Util.h"
 
 namespace aapt {
@@ -55,6 +56,11 @@ class IFile {
     return false;
   }
 
+  // Returns the compressed size of the file if it was compressed before it was stored in memory.
+  virtual Maybe<size_t> GetCompressedSize() {
+    return {};
+  }
+
  private:
   // Any segments created from this IFile need to be owned by this IFile, so
   // keep them
@@ -38,6 +38,15 @@ bool CopyInputStreamToArchive(IAaptContext* context, InputStream* in, const std:
 bool CopyFileToArchive(IAaptContext* context, io::IFile* file, const std::string& out_path,
                        uint32_t compression_flags, IArchiveWriter* writer) {
   std::unique_ptr<io::IData> data = file->OpenAsData();
+  if (data && (compression_flags & ArchiveEntry::kCompress) != 0) {
+    // A file that comes compressed from another archive already tells how well it compresses. If
+    // that is not enough to be kept compressed, store it right away instead of letting the writer
+    // deflate it only to throw the result away.
+    const Maybe<size_t> compressed_size = file->GetCompressedSize();
+    if (compressed_size && !IsCompressedEnough(compressed_size.value(), data->size())) {
+      compression_flags &= ~ArchiveEntry::kCompress;
+    }
+  }
   if (!data) {
     context->GetDiagnostics()->Error(DiagMessage(file->GetSource()) << "failed to open file");
     return false;
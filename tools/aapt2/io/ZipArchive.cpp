@@ -63,6 +63,13 @@ bool ZipFile::WasCompressed() {
   return zip_entry_.method != kCompressStored;
 }
 
+Maybe<size_t> ZipFile::GetCompressedSize() {
+  if (!WasCompressed()) {
+    return {};
+  }
+  return static_cast<size_t>(zip_entry_.compressed_length);
+}
+
 ZipFileCollectionIterator::ZipFileCollectionIterator(
     ZipFileCollection* collection)
     : current_(collection->files_.begin()), end_(collection->files_.end()) {}
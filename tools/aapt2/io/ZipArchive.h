@@ -41,6 +41,7 @@ class ZipFile : public IFile {
   std::unique_ptr<IData> OpenAsData() override;
   const Source& GetSource() const override;
   bool WasCompressed() override;
+  Maybe<size_t> GetCompressedSize() override;
 
  private:
   ZipArchiveHandle zip_handle_;
@@ -81,10 +81,14 @@ constexpr static const char* sWarningHeader =
     " * should not be modified by hand.\n"
     " */\n\n";
 
+void ClassDefinition::WriteJavaFileHeader(const StringPiece& package, std::ostream* out) {
+  *out << sWarningHeader << "package " << package << ";\n\n";
+}
+
 bool ClassDefinition::WriteJavaFile(const ClassDefinition* def,
                                     const StringPiece& package, bool final,
                                     std::ostream* out) {
-  *out << sWarningHeader << "package " << package << ";\n\n";
+  WriteJavaFileHeader(package, out);
   def->WriteToStream("", final, out);
   return bool(*out);
 }
@@ -172,6 +172,9 @@ class ClassDefinition : public ClassMember {
   static bool WriteJavaFile(const ClassDefinition* def, const android::StringPiece& package,
                             bool final, std::ostream* out);
 
+  // Writes the warning header and package declaration that WriteJavaFile() emits before the class.
+  static void WriteJavaFileHeader(const android::StringPiece& package, std::ostream* out);
+
   ClassDefinition(const android::StringPiece& name, ClassQualifier qualifier, bool createIfEmpty)
       : name_(name.to_string()), qualifier_(qualifier), create_if_empty_(createIfEmpty) {}
 
@@ -566,6 +566,12 @@ static void AppendJavaDocAnnotations(const std::vector<std::string>& annotations
 bool JavaClassGenerator::Generate(const StringPiece& package_name_to_generate,
                                   const StringPiece& out_package_name, std::ostream* out,
                                   std::ostream* out_r_txt) {
+  ClassDefinition::WriteJavaFileHeader(out_package_name, out);
+  return GenerateClass(package_name_to_generate, out, out_r_txt);
+}
+
+bool JavaClassGenerator::GenerateClass(const StringPiece& package_name_to_generate,
+                                       std::ostream* out, std::ostream* out_r_txt) {
   ClassDefinition r_class("R", ClassQualifier::kNone, true);
   std::unique_ptr<MethodDefinition> rewrite_method;
 
@@ -629,7 +635,8 @@ bool JavaClassGenerator::Generate(const StringPiece& package_name_to_generate,
 
   AppendJavaDocAnnotations(options_.javadoc_annotations, r_class.GetCommentBuilder());
 
-  if (!ClassDefinition::WriteJavaFile(&r_class, out_package_name, options_.use_final, out)) {
+  r_class.WriteToStream("", options_.use_final, out);
+  if (!*out) {
     return false;
   }
 
@@ -76,6 +76,12 @@ class JavaClassGenerator {
                 const android::StringPiece& output_package_name, std::ostream* out,
                 std::ostream* out_r_txt = nullptr);
 
+  // Writes only the R class to `out`, without the file header and package declaration. The same
+  // class can then be emitted into several packages, each prefixed by
+  // ClassDefinition::WriteJavaFileHeader().
+  bool GenerateClass(const android::StringPiece& package_name_to_generate, std::ostream* out,
+                     std::ostream* out_r_txt = nullptr);
+
   const std::string& getError() const;
 
  private:
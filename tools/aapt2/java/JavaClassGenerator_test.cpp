@@ -19,6 +19,7 @@
 #include <sstream>
 #include <string>
 
+#include "java/ClassDefinition.h"
 #include "test/Test.h"
 #include "util/Util.h"
 
@@ -108,6 +109,34 @@ TEST(JavaClassGeneratorTest, CorrectPackageNameIsUsed) {
   EXPECT_EQ(std::string::npos, output.find("com_foo$two"));
 }
 
+TEST(JavaClassGeneratorTest, GenerateClassMatchesGenerateWithoutHeader) {
+  std::unique_ptr<ResourceTable> table =
+      test::ResourceTableBuilder()
+          .SetPackageId("android", 0x01)
+          .AddSimple("android:id/one", ResourceId(0x01020000))
+          .AddSimple("android:string/two", ResourceId(0x01030000))
+          .Build();
+
+  std::unique_ptr<IAaptContext> context =
+      test::ContextBuilder()
+          .AddSymbolSource(util::make_unique<ResourceTableSymbolSource>(table.get()))
+          .SetNameManglerPolicy(NameManglerPolicy{"android"})
+          .Build();
+  JavaClassGenerator generator(context.get(), table.get(), {});
+
+  std::stringstream class_out;
+  ASSERT_TRUE(generator.GenerateClass("android", &class_out));
+  EXPECT_EQ(std::string::npos, class_out.str().find("package "));
+
+  std::stringstream expected;
+  ASSERT_TRUE(generator.Generate("android", "com.lib", &expected));
+
+  std::stringstream actual;
+  ClassDefinition::WriteJavaFileHeader("com.lib", &actual);
+  actual << class_out.str();
+  EXPECT_EQ(expected.str(), actual.str());
+}
+
 TEST(JavaClassGeneratorTest, AttrPrivateIsWrittenAsAttr) {
   std::unique_ptr<ResourceTable> table =
       test::ResourceTableBuilder()
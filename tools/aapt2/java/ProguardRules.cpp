@@ -242,6 +242,15 @@ bool CollectProguardRulesForManifest(const Source& source,
   return false;
 }
 
+void KeepSet::Merge(const KeepSet& other) {
+  for (const auto& entry : other.keep_set_) {
+    keep_set_[entry.first].insert(entry.second.begin(), entry.second.end());
+  }
+  for (const auto& entry : other.keep_method_set_) {
+    keep_method_set_[entry.first].insert(entry.second.begin(), entry.second.end());
+  }
+}
+
 bool CollectProguardRules(const Source& source, xml::XmlResource* res,
                           KeepSet* keep_set) {
   if (!res->root) {
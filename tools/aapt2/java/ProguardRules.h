@@ -39,6 +39,10 @@ class KeepSet {
     keep_method_set_[method_name].insert(source);
   }
 
+  // Adds every rule of `other`. The rules are kept sorted, so the result doesn't depend on the
+  // order in which sets are merged.
+  void Merge(const KeepSet& other);
+
  private:
   friend bool WriteKeepSet(std::ostream* out, const KeepSet& keep_set);
 
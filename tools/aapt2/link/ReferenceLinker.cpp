@@ -16,6 +16,11 @@
 
 #include "link/ReferenceLinker.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include "android-base/logging.h"
 #include "androidfw/ResourceTypes.h"
 
@@ -52,12 +57,14 @@ class ReferenceLinkerVisitor : public ValueVisitor {
   using ValueVisitor::Visit;
 
   ReferenceLinkerVisitor(const CallSite& callsite, IAaptContext* context, SymbolTable* symbols,
-                         StringPool* string_pool, xml::IPackageDeclStack* decl)
+                         StringPool* string_pool, std::mutex* string_pool_lock,
+                         xml::IPackageDeclStack* decl)
       : callsite_(callsite),
         context_(context),
         symbols_(symbols),
         package_decls_(decl),
-        string_pool_(string_pool) {}
+        string_pool_(string_pool),
+        string_pool_lock_(string_pool_lock) {}
 
   void Visit(Reference* ref) override {
     if (!ReferenceLinker::LinkReference(callsite_, ref, context_, symbols_, package_decls_)) {
@@ -158,7 +165,7 @@ class ReferenceLinkerVisitor : public ValueVisitor {
         util::StringBuilder string_builder;
         string_builder.Append(*raw_string->value);
         if (string_builder) {
-          transformed = util::make_unique<String>(string_pool_->MakeRef(string_builder.ToString()));
+          transformed = util::make_unique<String>(MakeStringRef(string_builder.ToString()));
         }
       }
 
@@ -169,11 +176,20 @@ class ReferenceLinkerVisitor : public ValueVisitor {
     return value;
   }
 
+  StringPool::Ref MakeStringRef(const std::string& str) {
+    if (string_pool_lock_ == nullptr) {
+      return string_pool_->MakeRef(str);
+    }
+    std::lock_guard<std::mutex> guard(*string_pool_lock_);
+    return string_pool_->MakeRef(str);
+  }
+
   const CallSite& callsite_;
   IAaptContext* context_;
   SymbolTable* symbols_;
   xml::IPackageDeclStack* package_decls_;
   StringPool* string_pool_;
+  std::mutex* string_pool_lock_;
   bool error_ = false;
 };
 
@@ -323,36 +339,123 @@ bool ReferenceLinker::LinkReference(const CallSite& callsite, Reference* referen
   return false;
 }
 
-bool ReferenceLinker::Consume(IAaptContext* context, ResourceTable* table) {
+/**
+ * Links all entries of `type`. If `string_pool_lock` is not null, it is held while adding strings
+ * to `string_pool`.
+ */
+static bool LinkType(IAaptContext* context, ResourceTablePackage* package,
+                     ResourceTableType* type, StringPool* string_pool,
+                     std::mutex* string_pool_lock) {
   EmptyDeclStack decl_stack;
+  bool error = false;
+  for (auto& entry : type->entries) {
+    // Symbol state information may be lost if there is no value for the
+    // resource.
+    if (entry->symbol_status.state != SymbolState::kUndefined && entry->values.empty()) {
+      context->GetDiagnostics()->Error(
+          DiagMessage(entry->symbol_status.source)
+          << "no definition for declared symbol '"
+          << ResourceNameRef(package->name, type->type, entry->name) << "'");
+      error = true;
+    }
+
+    CallSite callsite = {ResourceNameRef(package->name, type->type, entry->name)};
+    ReferenceLinkerVisitor visitor(callsite, context, context->GetExternalSymbols(), string_pool,
+                                   string_pool_lock, &decl_stack);
+
+    for (auto& config_value : entry->values) {
+      config_value->value->Accept(&visitor);
+    }
+
+    if (visitor.HasError()) {
+      error = true;
+    }
+  }
+  return !error;
+}
+
+bool ReferenceLinker::Consume(IAaptContext* context, ResourceTable* table) {
+  if (jobs_ > 1) {
+    return ConsumeInParallel(context, table);
+  }
+
   bool error = false;
   for (auto& package : table->packages) {
     for (auto& type : package->types) {
-      for (auto& entry : type->entries) {
-        // Symbol state information may be lost if there is no value for the
-        // resource.
-        if (entry->symbol_status.state != SymbolState::kUndefined &&
-            entry->values.empty()) {
-          context->GetDiagnostics()->Error(
-              DiagMessage(entry->symbol_status.source)
-              << "no definition for declared symbol '"
-              << ResourceNameRef(package->name, type->type, entry->name)
-              << "'");
-          error = true;
-        }
+      if (!LinkType(context, package.get(), type.get(), &table->string_pool, nullptr)) {
+        error = true;
+      }
+    }
+  }
+  return !error;
+}
 
-        CallSite callsite = {ResourceNameRef(package->name, type->type, entry->name)};
-        ReferenceLinkerVisitor visitor(callsite, context, context->GetExternalSymbols(),
-                                       &table->string_pool, &decl_stack);
+bool ReferenceLinker::ConsumeInParallel(IAaptContext* context, ResourceTable* table) {
+  struct LinkTask {
+    ResourceTablePackage* package;
+    ResourceTableType* type;
+    BufferedDiagnostics diagnostics;
+    bool result = false;
+  };
+
+  // Attributes are linked first and on their own. Symbols for attributes of this table carry a
+  // copy of the Attribute value, which must not be copied while it is being linked.
+  std::vector<std::unique_ptr<LinkTask>> tasks;
+  std::vector<LinkTask*> attr_tasks;
+  std::vector<LinkTask*> other_tasks;
+  for (auto& package : table->packages) {
+    for (auto& type : package->types) {
+      std::unique_ptr<LinkTask> task = util::make_unique<LinkTask>();
+      task->package = package.get();
+      task->type = type.get();
+      if (type->type == ResourceType::kAttr || type->type == ResourceType::kAttrPrivate) {
+        attr_tasks.push_back(task.get());
+      } else {
+        other_tasks.push_back(task.get());
+      }
+      tasks.push_back(std::move(task));
+    }
+  }
 
-        for (auto& config_value : entry->values) {
-          config_value->value->Accept(&visitor);
-        }
+  SymbolTable* symbols = context->GetExternalSymbols();
+  symbols->SetRetainSymbols(true);
 
-        if (visitor.HasError()) {
-          error = true;
-        }
-      }
+  std::mutex string_pool_lock;
+  auto run_task = [&](LinkTask* task) {
+    DiagnosticsOverrideContext task_context(context, &task->diagnostics);
+    task->result =
+        LinkType(&task_context, task->package, task->type, &table->string_pool, &string_pool_lock);
+  };
+
+  for (LinkTask* task : attr_tasks) {
+    run_task(task);
+  }
+
+  std::atomic<size_t> next_task(0);
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next_task.fetch_add(1)) < other_tasks.size()) {
+      run_task(other_tasks[i]);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t worker_count = std::min(jobs_, other_tasks.size());
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back(worker);
+  }
+  for (std::thread& t : workers) {
+    t.join();
+  }
+
+  symbols->SetRetainSymbols(false);
+
+  // Report in table order, as a serial link would have.
+  bool error = false;
+  for (auto& task : tasks) {
+    task->diagnostics.Replay(context->GetDiagnostics());
+    if (!task->result) {
+      error = true;
     }
   }
   return !error;
@@ -40,6 +40,12 @@ class ReferenceLinker : public IResourceTableConsumer {
  public:
   ReferenceLinker() = default;
 
+  /**
+   * Links the types of the table on up to `jobs` threads. Diagnostics are reported in the same
+   * order as with a single thread.
+   */
+  explicit ReferenceLinker(size_t jobs) : jobs_(jobs) {}
+
   /**
    * Returns true if the symbol is visible by the reference and from the
    * callsite.
@@ -110,6 +116,10 @@ class ReferenceLinker : public IResourceTableConsumer {
 
  private:
   DISALLOW_COPY_AND_ASSIGN(ReferenceLinker);
+
+  bool ConsumeInParallel(IAaptContext* context, ResourceTable* table);
+
+  size_t jobs_ = 1;
 };
 
 }  // namespace aapt
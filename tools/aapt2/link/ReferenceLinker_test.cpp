@@ -69,6 +69,77 @@ TEST(ReferenceLinkerTest, LinkSimpleReferences) {
   EXPECT_EQ(ResourceId(0x01040034), ref->id.value());
 }
 
+TEST(ReferenceLinkerTest, LinkTypesInParallel) {
+  std::unique_ptr<ResourceTable> table =
+      test::ResourceTableBuilder()
+          .SetPackageId("com.app.test", 0x7f)
+          .AddValue("com.app.test:attr/foo", ResourceId(0x7f010000),
+                    test::AttributeBuilder().SetTypeMask(ResTable_map::TYPE_COLOR).Build())
+          .AddReference("com.app.test:bool/foo", ResourceId(0x7f020000), "string/foo")
+          .AddReference("com.app.test:color/foo", ResourceId(0x7f030000), "bool/foo")
+          .AddReference("com.app.test:string/foo", ResourceId(0x7f040000), "android:string/ok")
+          .AddValue("com.app.test:style/Theme", ResourceId(0x7f050000),
+                    test::StyleBuilder()
+                        .AddItem("com.app.test:attr/foo", ResourceUtils::TryParseColor("#ff00ff"))
+                        .Build())
+          .Build();
+
+  std::unique_ptr<IAaptContext> context =
+      test::ContextBuilder()
+          .SetCompilationPackage("com.app.test")
+          .SetPackageId(0x7f)
+          .SetNameManglerPolicy(NameManglerPolicy{"com.app.test"})
+          .AddSymbolSource(util::make_unique<ResourceTableSymbolSource>(table.get()))
+          .AddSymbolSource(test::StaticSymbolSourceBuilder()
+                               .AddPublicSymbol("android:string/ok", ResourceId(0x01040034))
+                               .Build())
+          .Build();
+
+  ReferenceLinker linker(4);
+  ASSERT_TRUE(linker.Consume(context.get(), table.get()));
+
+  Reference* ref = test::GetValue<Reference>(table.get(), "com.app.test:bool/foo");
+  ASSERT_NE(nullptr, ref);
+  AAPT_ASSERT_TRUE(ref->id);
+  EXPECT_EQ(ResourceId(0x7f040000), ref->id.value());
+
+  ref = test::GetValue<Reference>(table.get(), "com.app.test:color/foo");
+  ASSERT_NE(nullptr, ref);
+  AAPT_ASSERT_TRUE(ref->id);
+  EXPECT_EQ(ResourceId(0x7f020000), ref->id.value());
+
+  ref = test::GetValue<Reference>(table.get(), "com.app.test:string/foo");
+  ASSERT_NE(nullptr, ref);
+  AAPT_ASSERT_TRUE(ref->id);
+  EXPECT_EQ(ResourceId(0x01040034), ref->id.value());
+
+  Style* style = test::GetValue<Style>(table.get(), "com.app.test:style/Theme");
+  ASSERT_NE(nullptr, style);
+  ASSERT_EQ(1u, style->entries.size());
+  AAPT_ASSERT_TRUE(style->entries[0].key.id);
+  EXPECT_EQ(ResourceId(0x7f010000), style->entries[0].key.id.value());
+}
+
+TEST(ReferenceLinkerTest, FailToLinkMissingReferencesInParallel) {
+  std::unique_ptr<ResourceTable> table =
+      test::ResourceTableBuilder()
+          .SetPackageId("com.app.test", 0x7f)
+          .AddReference("com.app.test:bool/foo", ResourceId(0x7f020000), "string/foo")
+          .AddReference("com.app.test:string/foo", ResourceId(0x7f040000), "string/missing")
+          .Build();
+
+  std::unique_ptr<IAaptContext> context =
+      test::ContextBuilder()
+          .SetCompilationPackage("com.app.test")
+          .SetPackageId(0x7f)
+          .SetNameManglerPolicy(NameManglerPolicy{"com.app.test"})
+          .AddSymbolSource(util::make_unique<ResourceTableSymbolSource>(table.get()))
+          .Build();
+
+  ReferenceLinker linker(4);
+  ASSERT_FALSE(linker.Consume(context.get(), table.get()));
+}
+
 TEST(ReferenceLinkerTest, LinkStyleAttributes) {
   std::unique_ptr<ResourceTable> table =
       test::ResourceTableBuilder()
@@ -17,6 +17,7 @@
 #include "optimize/ResourceDeduper.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "DominatorTree.h"
 #include "ResourceTable.h"
@@ -25,6 +26,48 @@ namespace aapt {
 
 namespace {
 
+/**
+ * Partitions the values of an entry into classes of equal values, so that the remover can
+ * compare two values by their class instead of calling Value::Equals over and over for
+ * entries with many configurations. Candidates are found through Value::Hash and only
+ * confirmed with Value::Equals.
+ */
+class ValueClasses {
+ public:
+  explicit ValueClasses(const ResourceEntry* entry) {
+    std::unordered_multimap<size_t, const ResourceConfigValue*> buckets;
+    for (const auto& config_value : entry->values) {
+      const Value* value = config_value->value.get();
+      if (!value) {
+        continue;
+      }
+
+      const size_t hash = value->Hash();
+      size_t value_class = classes_.size();
+      auto range = buckets.equal_range(hash);
+      for (auto iter = range.first; iter != range.second; ++iter) {
+        if (iter->second->value->Equals(value)) {
+          value_class = classes_[iter->second];
+          break;
+        }
+      }
+      if (value_class == classes_.size()) {
+        buckets.emplace(hash, config_value.get());
+      }
+      classes_[config_value.get()] = value_class;
+    }
+  }
+
+  bool Equal(const ResourceConfigValue* a, const ResourceConfigValue* b) const {
+    return classes_.at(a) == classes_.at(b);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ValueClasses);
+
+  std::unordered_map<const ResourceConfigValue*, size_t> classes_;
+};
+
 /**
  * Remove duplicated key-value entries from dominated resources.
  *
@@ -41,7 +84,7 @@ class DominatedKeyValueRemover : public DominatorTree::BottomUpVisitor {
   using Node = DominatorTree::Node;
 
   explicit DominatedKeyValueRemover(IAaptContext* context, ResourceEntry* entry)
-      : context_(context), entry_(entry) {}
+      : context_(context), entry_(entry), value_classes_(entry) {}
 
   void VisitConfig(Node* node) {
     Node* parent = node->parent();
@@ -53,7 +96,7 @@ class DominatedKeyValueRemover : public DominatorTree::BottomUpVisitor {
     if (!node_value || !parent_value) {
       return;
     }
-    if (!node_value->value->Equals(parent_value->value.get())) {
+    if (!value_classes_.Equal(node_value, parent_value)) {
       return;
     }
 
@@ -66,7 +109,7 @@ class DominatedKeyValueRemover : public DominatorTree::BottomUpVisitor {
         continue;
       }
       if (node_configuration.IsCompatibleWith(sibling->config) &&
-          !node_value->value->Equals(sibling->value.get())) {
+          !value_classes_.Equal(node_value, sibling.get())) {
         // The configurations are compatible, but the value is
         // different, so we can't remove this value.
         return;
@@ -88,6 +131,7 @@ class DominatedKeyValueRemover : public DominatorTree::BottomUpVisitor {
 
   IAaptContext* context_;
   ResourceEntry* entry_;
+  ValueClasses value_classes_;
 };
 
 static void DedupeEntry(IAaptContext* context, ResourceEntry* entry) {
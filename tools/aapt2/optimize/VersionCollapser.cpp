@@ -17,51 +17,12 @@
 #include "optimize/VersionCollapser.h"
 
 #include <algorithm>
-#include <vector>
+#include <set>
 
 #include "ResourceTable.h"
 
 namespace aapt {
 
-template <typename Iterator, typename Pred>
-class FilterIterator {
- public:
-  FilterIterator(Iterator begin, Iterator end, Pred pred = Pred())
-      : current_(begin), end_(end), pred_(pred) {
-    Advance();
-  }
-
-  bool HasNext() { return current_ != end_; }
-
-  Iterator NextIter() {
-    Iterator iter = current_;
-    ++current_;
-    Advance();
-    return iter;
-  }
-
-  typename Iterator::reference Next() { return *NextIter(); }
-
- private:
-  void Advance() {
-    for (; current_ != end_; ++current_) {
-      if (pred_(*current_)) {
-        return;
-      }
-    }
-  }
-
-  Iterator current_, end_;
-  Pred pred_;
-};
-
-template <typename Iterator, typename Pred>
-FilterIterator<Iterator, Pred> make_filter_iterator(Iterator begin,
-                                                    Iterator end = Iterator(),
-                                                    Pred pred = Pred()) {
-  return FilterIterator<Iterator, Pred>(begin, end, pred);
-}
-
 /**
  * Every Configuration with an SDK version specified that is less than minSdk
  * will be removed.
@@ -70,40 +31,20 @@ FilterIterator<Iterator, Pred> make_filter_iterator(Iterator begin,
  * one will be kept.
  */
 static void CollapseVersions(int min_sdk, ResourceEntry* entry) {
+  // Configurations that only differ in SDK version, keyed by the configuration without it, for
+  // which a value with an SDK version <= minSdk was already kept. Looking these up replaces
+  // scanning the rest of the entry for every such value.
+  std::set<ConfigDescription> kept_configs;
+
   // First look for all sdks less than minSdk.
   for (auto iter = entry->values.rbegin(); iter != entry->values.rend();
        ++iter) {
-    // Check if the item was already marked for removal.
-    if (!(*iter)) {
-      continue;
-    }
-
     const ConfigDescription& config = (*iter)->config;
     if (config.sdkVersion <= min_sdk) {
-      // This is the first configuration we've found with a smaller or equal SDK
-      // level
-      // to the minimum. We MUST keep this one, but remove all others we find,
-      // which get
-      // overridden by this one.
-
-      ConfigDescription config_without_sdk = config.CopyWithoutSdkVersion();
-      auto pred = [&](const std::unique_ptr<ResourceConfigValue>& val) -> bool {
-        // Check that the value hasn't already been marked for removal.
-        if (!val) {
-          return false;
-        }
-
-        // Only return Configs that differ in SDK version.
-        config_without_sdk.sdkVersion = val->config.sdkVersion;
-        return config_without_sdk == val->config &&
-               val->config.sdkVersion <= min_sdk;
-      };
-
-      // Remove the rest that match.
-      auto filter_iter =
-          make_filter_iterator(iter + 1, entry->values.rend(), pred);
-      while (filter_iter.HasNext()) {
-        filter_iter.Next() = {};
+      // The first configuration we find with a smaller or equal SDK level to the minimum MUST be
+      // kept, but all others we find that only differ in SDK version get overridden by it.
+      if (!kept_configs.insert(config.CopyWithoutSdkVersion()).second) {
+        *iter = {};
       }
     }
   }
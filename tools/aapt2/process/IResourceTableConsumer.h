@@ -52,6 +52,31 @@ struct IAaptContext {
   virtual int GetMinSdkVersion() = 0;
 };
 
+// Forwards everything to another IAaptContext, except that diagnostics are sent to `diag`.
+// Lets a task running alongside others collect its own diagnostics.
+class DiagnosticsOverrideContext : public IAaptContext {
+ public:
+  DiagnosticsOverrideContext(IAaptContext* context, IDiagnostics* diag)
+      : context_(context), diag_(diag) {}
+
+  PackageType GetPackageType() override { return context_->GetPackageType(); }
+  SymbolTable* GetExternalSymbols() override { return context_->GetExternalSymbols(); }
+  IDiagnostics* GetDiagnostics() override { return diag_; }
+  const std::string& GetCompilationPackage() override {
+    return context_->GetCompilationPackage();
+  }
+  uint8_t GetPackageId() override { return context_->GetPackageId(); }
+  NameMangler* GetNameMangler() override { return context_->GetNameMangler(); }
+  bool IsVerbose() override { return context_->IsVerbose(); }
+  int GetMinSdkVersion() override { return context_->GetMinSdkVersion(); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DiagnosticsOverrideContext);
+
+  IAaptContext* context_;
+  IDiagnostics* diag_;
+};
+
 struct IResourceTableConsumer {
   virtual ~IResourceTableConsumer() = default;
 
@@ -64,7 +64,21 @@ void SymbolTable::PrependSource(std::unique_ptr<ISymbolSource> source) {
   cache_.clear();
 }
 
+void SymbolTable::SetRetainSymbols(bool retain) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (retain && !retain_symbols_) {
+    // Symbols already in the cache were created without being retained, so drop them and let
+    // them be looked up again.
+    cache_.clear();
+    id_cache_.clear();
+  } else if (!retain) {
+    retained_symbols_.clear();
+  }
+  retain_symbols_ = retain;
+}
+
 const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
+  std::lock_guard<std::mutex> guard(lock_);
   const ResourceName* name_with_package = &name;
 
   // Fill in the package name if necessary.
@@ -98,6 +112,9 @@ const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
   // Take ownership of the symbol into a shared_ptr. We do this because
   // LruCache doesn't support unique_ptr.
   std::shared_ptr<Symbol> shared_symbol(std::move(symbol));
+  if (retain_symbols_) {
+    retained_symbols_.push_back(shared_symbol);
+  }
 
   // Since we look in the cache with the unmangled, but package prefixed
   // name, we must put the same name into the cache.
@@ -114,6 +131,7 @@ const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
 }
 
 const SymbolTable::Symbol* SymbolTable::FindById(const ResourceId& id) {
+  std::lock_guard<std::mutex> guard(lock_);
   if (const std::shared_ptr<Symbol>& s = id_cache_.get(id)) {
     return s.get();
   }
@@ -127,6 +145,9 @@ const SymbolTable::Symbol* SymbolTable::FindById(const ResourceId& id) {
   // Take ownership of the symbol into a shared_ptr. We do this because LruCache
   // doesn't support unique_ptr.
   std::shared_ptr<Symbol> shared_symbol(std::move(symbol));
+  if (retain_symbols_) {
+    retained_symbols_.push_back(shared_symbol);
+  }
   id_cache_.put(id, shared_symbol);
 
   // Returns the raw pointer. Callers are not expected to hold on to this
@@ -212,6 +233,8 @@ std::unique_ptr<SymbolTable::Symbol> ResourceTableSymbolSource::FindByName(
 
 bool AssetManagerSymbolSource::AddAssetPath(const StringPiece& path) {
   int32_t cookie = 0;
+  name_index_valid_ = false;
+  name_index_.clear();
   return assets_.addAssetPath(android::String8(path.data(), path.size()), &cookie);
 }
 
@@ -284,22 +307,57 @@ static std::unique_ptr<SymbolTable::Symbol> LookupAttributeInTable(
   return s;
 }
 
-std::unique_ptr<SymbolTable::Symbol> AssetManagerSymbolSource::FindByName(
+const AssetManagerSymbolSource::IndexedEntry* AssetManagerSymbolSource::FindInIndex(
     const ResourceName& name) {
-  const android::ResTable& table = assets_.getResources(false);
+  if (!name_index_valid_) {
+    const android::ResTable& table = assets_.getResources(false);
+    const size_t package_count = table.getBasePackageCount();
+    for (size_t p = 0; p < package_count; p++) {
+      const uint32_t package_id = table.getBasePackageId(p);
+      const uint32_t last_type_id = table.getLastTypeIdForPackage(p);
+      for (uint32_t type_id = 1; type_id <= last_type_id; type_id++) {
+        const size_t entry_count = table.getEntryCountForType(p, type_id);
+        for (size_t entry_id = 0; entry_id < entry_count; entry_id++) {
+          const ResourceId id(static_cast<uint8_t>(package_id), static_cast<uint8_t>(type_id),
+                              static_cast<uint16_t>(entry_id));
+          android::ResTable::resource_name res_name = {};
+          if (!table.getResourceName(id.id, true, &res_name)) {
+            // Not every entry ID has a resource.
+            continue;
+          }
+
+          Maybe<ResourceName> parsed_name = ResourceUtils::ToResourceName(res_name);
+          if (!parsed_name) {
+            continue;
+          }
+
+          IndexedEntry indexed_entry = {id, 0u};
+          table.getResourceFlags(id.id, &indexed_entry.type_spec_flags);
+          name_index_.emplace(std::move(parsed_name.value()), indexed_entry);
+        }
+      }
+    }
+    name_index_valid_ = true;
+  }
 
-  const std::u16string package16 = util::Utf8ToUtf16(name.package);
-  const std::u16string type16 = util::Utf8ToUtf16(ToString(name.type));
-  const std::u16string entry16 = util::Utf8ToUtf16(name.entry);
+  auto iter = name_index_.find(name);
+  if (iter == name_index_.end() && name.type == ResourceType::kAttr) {
+    // Like ResTable::identifierForName(), try looking up a private attribute.
+    iter = name_index_.find(ResourceName(name.package, ResourceType::kAttrPrivate, name.entry));
+  }
+  return iter != name_index_.end() ? &iter->second : nullptr;
+}
 
-  uint32_t type_spec_flags = 0;
-  ResourceId res_id = table.identifierForName(
-      entry16.data(), entry16.size(), type16.data(), type16.size(),
-      package16.data(), package16.size(), &type_spec_flags);
-  if (!res_id.is_valid()) {
+std::unique_ptr<SymbolTable::Symbol> AssetManagerSymbolSource::FindByName(
+    const ResourceName& name) {
+  const IndexedEntry* indexed_entry = FindInIndex(name);
+  if (indexed_entry == nullptr) {
     return {};
   }
 
+  const android::ResTable& table = assets_.getResources(false);
+  const ResourceId res_id = indexed_entry->id;
+
   std::unique_ptr<SymbolTable::Symbol> s;
   if (name.type == ResourceType::kAttr) {
     s = LookupAttributeInTable(table, res_id);
@@ -309,7 +367,8 @@ std::unique_ptr<SymbolTable::Symbol> AssetManagerSymbolSource::FindByName(
   }
 
   if (s) {
-    s->is_public = (type_spec_flags & android::ResTable_typeSpec::SPEC_PUBLIC) != 0;
+    s->is_public =
+        (indexed_entry->type_spec_flags & android::ResTable_typeSpec::SPEC_PUBLIC) != 0;
     return s;
   }
   return {};
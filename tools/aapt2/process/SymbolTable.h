@@ -19,6 +19,8 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "android-base/macros.h"
@@ -84,6 +86,11 @@ class SymbolTable {
   // cause the existing cache to be cleared.
   void PrependSource(std::unique_ptr<ISymbolSource> source);
 
+  // When enabled, every symbol returned by FindByXXX is kept alive until this is disabled again,
+  // so results may be held across calls. Lookups are always serialized internally, so together
+  // this lets several threads link against the same SymbolTable.
+  void SetRetainSymbols(bool retain);
+
   // NOTE: Never hold on to the result between calls to FindByXXX. The
   // results are stored in a cache which may evict entries on subsequent calls.
   const Symbol* FindByName(const ResourceName& name);
@@ -108,6 +115,11 @@ class SymbolTable {
   android::LruCache<ResourceName, std::shared_ptr<Symbol>> cache_;
   android::LruCache<ResourceId, std::shared_ptr<Symbol>> id_cache_;
 
+  // Guards the caches and the retained symbols.
+  std::mutex lock_;
+  bool retain_symbols_ = false;
+  std::vector<std::shared_ptr<Symbol>> retained_symbols_;
+
   DISALLOW_COPY_AND_ASSIGN(SymbolTable);
 };
 
@@ -200,8 +212,21 @@ class AssetManagerSymbolSource : public ISymbolSource {
       const Reference& ref) override;
 
  private:
+  struct IndexedEntry {
+    ResourceId id;
+    uint32_t type_spec_flags;
+  };
+
+  // Finds a resource by name in name_index_, building the index first if needed.
+  const IndexedEntry* FindInIndex(const ResourceName& name);
+
   android::AssetManager assets_;
 
+  // Every named resource of assets_. It is built on the first lookup by name and replaces the
+  // much slower ResTable::identifierForName().
+  bool name_index_valid_ = false;
+  std::unordered_map<ResourceName, IndexedEntry> name_index_;
+
   DISALLOW_COPY_AND_ASSIGN(AssetManagerSymbolSource);
 };
 
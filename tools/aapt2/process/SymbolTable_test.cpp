@@ -68,4 +68,32 @@ TEST(SymbolTableTest, FindByName) {
   EXPECT_NE(nullptr, symbol_table.FindByName(test::ParseNameOrDie("com.android.lib:id/foo")));
 }
 
+TEST(SymbolTableTest, RetainedSymbolsOutliveTheCache) {
+  test::ResourceTableBuilder builder;
+  for (int i = 0; i < 500; i++) {
+    builder.AddSimple("com.android.app:id/foo" + std::to_string(i),
+                      ResourceId(0x7f010000 + i));
+  }
+  std::unique_ptr<ResourceTable> table = builder.Build();
+
+  NameMangler mangler(NameManglerPolicy{"com.android.app"});
+  SymbolTable symbol_table(&mangler);
+  symbol_table.AppendSource(util::make_unique<ResourceTableSymbolSource>(table.get()));
+  symbol_table.SetRetainSymbols(true);
+
+  const SymbolTable::Symbol* first = symbol_table.FindByName(test::ParseNameOrDie("id/foo0"));
+  ASSERT_NE(nullptr, first);
+
+  // Look up more symbols than the cache holds.
+  for (int i = 1; i < 500; i++) {
+    const std::string name = "id/foo" + std::to_string(i);
+    ASSERT_NE(nullptr, symbol_table.FindByName(test::ParseNameOrDie(name)));
+  }
+
+  AAPT_ASSERT_TRUE(first->id);
+  EXPECT_EQ(ResourceId(0x7f010000), first->id.value());
+
+  symbol_table.SetRetainSymbols(false);
+}
+
 }  // namespace aapt
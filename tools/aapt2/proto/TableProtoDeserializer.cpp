@@ -16,6 +16,8 @@
 
 #include "proto/ProtoSerialize.h"
 
+#include <unordered_map>
+
 #include "android-base/logging.h"
 #include "androidfw/ResourceTypes.h"
 
@@ -352,14 +354,20 @@ class PackagePbDeserializer {
     }
 
     if (pb_ref.has_symbol_idx()) {
-      const std::string str_symbol = util::GetString(*symbol_pool_, pb_ref.symbol_idx());
-      ResourceNameRef name_ref;
-      if (!ResourceUtils::ParseResourceName(str_symbol, &name_ref, nullptr)) {
-        diag_->Error(DiagMessage(source_) << "invalid reference name '" << str_symbol << "'");
-        return false;
+      // The same few symbols are referenced from many values, parse each of them once.
+      const uint32_t symbol_idx = pb_ref.symbol_idx();
+      auto iter = symbol_names_.find(symbol_idx);
+      if (iter == symbol_names_.end()) {
+        const std::string str_symbol = util::GetString(*symbol_pool_, symbol_idx);
+        ResourceNameRef name_ref;
+        if (!ResourceUtils::ParseResourceName(str_symbol, &name_ref, nullptr)) {
+          diag_->Error(DiagMessage(source_) << "invalid reference name '" << str_symbol << "'");
+          return false;
+        }
+        iter = symbol_names_.emplace(symbol_idx, name_ref.ToResourceName()).first;
       }
 
-      out_ref->name = name_ref.ToResourceName();
+      out_ref->name = iter->second;
     }
     return true;
   }
@@ -383,6 +391,9 @@ class PackagePbDeserializer {
   const android::ResStringPool* symbol_pool_;
   const Source source_;
   IDiagnostics* diag_;
+
+  // Parsed names of the symbol pool entries, by index.
+  std::unordered_map<uint32_t, ResourceName> symbol_names_;
 };
 
 }  // namespace
@@ -17,8 +17,10 @@
 #include "split/TableSplitter.h"
 
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <set>
+#include <thread>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
@@ -175,15 +177,73 @@ bool TableSplitter::VerifySplitConstraints(IAaptContext* context) {
   return !error;
 }
 
+/**
+ * The values of an entry that were selected for a split. They are copied into the split once
+ * all entries have been split.
+ */
+struct SplitEntrySelection {
+  const ResourceTablePackage* package;
+  const ResourceTableType* type;
+  const ResourceEntry* entry;
+  std::vector<ResourceConfigValue*> values;
+};
+
+/**
+ * Creates the entries of `selections` in `split_table` and copies their values into it. This
+ * only reads the original table, so the splits can be copied concurrently.
+ */
+static void CopySelectedValues(
+    const std::vector<std::unique_ptr<ResourceTablePackage>>& packages,
+    const std::vector<SplitEntrySelection>& selections, ResourceTable* split_table) {
+  // Initialize all packages for splits.
+  for (auto& pkg : packages) {
+    split_table->CreatePackage(pkg->name, pkg->id);
+  }
+
+  for (const SplitEntrySelection& selection : selections) {
+    // Create the same resource structure in the split. We do this
+    // lazily because we might not have actual values for each
+    // type/entry.
+    ResourceTablePackage* split_pkg =
+        split_table->FindPackage(selection.package->name);
+    ResourceTableType* split_type =
+        split_pkg->FindOrCreateType(selection.type->type);
+    if (!split_type->id) {
+      split_type->id = selection.type->id;
+      split_type->symbol_status = selection.type->symbol_status;
+    }
+
+    ResourceEntry* split_entry =
+        split_type->FindOrCreateEntry(selection.entry->name);
+    if (!split_entry->id) {
+      split_entry->id = selection.entry->id;
+      split_entry->symbol_status = selection.entry->symbol_status;
+    }
+
+    // Copy the selected values into the new Split Entry.
+    for (ResourceConfigValue* config_value : selection.values) {
+      ResourceConfigValue* new_config_value =
+          split_entry->FindOrCreateValue(config_value->config,
+                                         config_value->product);
+      new_config_value->value = std::unique_ptr<Value>(
+          config_value->value->Clone(&split_table->string_pool));
+    }
+  }
+}
+
 void TableSplitter::SplitTable(ResourceTable* original_table) {
   const size_t split_count = split_constraints_.size();
-  for (auto& pkg : original_table->packages) {
-    // Initialize all packages for splits.
-    for (size_t idx = 0; idx < split_count; idx++) {
-      ResourceTable* split_table = splits_[idx].get();
-      split_table->CreatePackage(pkg->name, pkg->id);
-    }
+  std::vector<std::unique_ptr<SplitValueSelector>> selectors;
+  for (const SplitConstraints& split_constraint : split_constraints_) {
+    selectors.push_back(util::make_unique<SplitValueSelector>(split_constraint));
+  }
+
+  // Values are only selected here, and copied into the splits at the end. The values claimed
+  // by the splits are kept alive until then, even though they are removed from the base.
+  std::vector<std::vector<SplitEntrySelection>> selections(split_count);
+  std::vector<std::unique_ptr<ResourceConfigValue>> claimed_values;
 
+  for (auto& pkg : original_table->packages) {
     for (auto& type : pkg->types) {
       if (type->type == ResourceType::kMipmap) {
         // Always keep mipmaps.
@@ -230,43 +290,14 @@ void TableSplitter::SplitTable(ResourceTable* original_table) {
         // we
         // leave it in the base.
         for (size_t idx = 0; idx < split_count; idx++) {
-          const SplitConstraints& split_constraint = split_constraints_[idx];
-          ResourceTable* split_table = splits_[idx].get();
-
           // Select the values we want from this entry for this split.
-          SplitValueSelector selector(split_constraint);
           std::vector<ResourceConfigValue*> selected_values =
-              selector.SelectValues(density_groups, &config_claimed_map);
+              selectors[idx]->SelectValues(density_groups, &config_claimed_map);
 
           // No need to do any work if we selected nothing.
           if (!selected_values.empty()) {
-            // Create the same resource structure in the split. We do this
-            // lazily because we might not have actual values for each
-            // type/entry.
-            ResourceTablePackage* split_pkg =
-                split_table->FindPackage(pkg->name);
-            ResourceTableType* split_type =
-                split_pkg->FindOrCreateType(type->type);
-            if (!split_type->id) {
-              split_type->id = type->id;
-              split_type->symbol_status = type->symbol_status;
-            }
-
-            ResourceEntry* split_entry =
-                split_type->FindOrCreateEntry(entry->name);
-            if (!split_entry->id) {
-              split_entry->id = entry->id;
-              split_entry->symbol_status = entry->symbol_status;
-            }
-
-            // Copy the selected values into the new Split Entry.
-            for (ResourceConfigValue* config_value : selected_values) {
-              ResourceConfigValue* new_config_value =
-                  split_entry->FindOrCreateValue(config_value->config,
-                                                 config_value->product);
-              new_config_value->value = std::unique_ptr<Value>(
-                  config_value->value->Clone(&split_table->string_pool));
-            }
+            selections[idx].push_back(SplitEntrySelection{
+                pkg.get(), type.get(), entry.get(), std::move(selected_values)});
           }
         }
 
@@ -283,7 +314,7 @@ void TableSplitter::SplitTable(ResourceTable* original_table) {
              entry->values) {
           if (config_value && config_claimed_map[config_value.get()]) {
             // Claimed, remove from base.
-            config_value.reset();
+            claimed_values.push_back(std::move(config_value));
           }
         }
 
@@ -294,6 +325,24 @@ void TableSplitter::SplitTable(ResourceTable* original_table) {
       }
     }
   }
+
+  std::atomic<size_t> next_split(0);
+  auto worker = [&]() {
+    size_t idx;
+    while ((idx = next_split.fetch_add(1)) < split_count) {
+      CopySelectedValues(original_table->packages, selections[idx], splits_[idx].get());
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t worker_count = std::min(options_.jobs, split_count);
+  for (size_t i = 1; i < worker_count; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& t : workers) {
+    t.join();
+  }
 }
 
 }  // namespace aapt
@@ -44,6 +44,11 @@ struct TableSplitterOptions {
    * end up in the final table.
    */
   IConfigFilter* config_filter = nullptr;
+
+  /**
+   * Number of threads that copy the selected values into the split tables.
+   */
+  size_t jobs = 1;
 };
 
 class TableSplitter {
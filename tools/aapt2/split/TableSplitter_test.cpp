@@ -248,4 +248,43 @@ TEST(TableSplitterTest, SplitTableByConfigAndDensity) {
                                         test::ParseConfigOrDie("land-xxhdpi")));
 }
 
+TEST(TableSplitterTest, SplitTableConcurrently) {
+  ResourceTable table;
+
+  const ResourceName foo = test::ParseNameOrDie("android:string/foo");
+  for (const char* locale : {"", "fr", "de", "es"}) {
+    ASSERT_TRUE(table.AddResource(
+        foo, test::ParseConfigOrDie(locale), {},
+        util::make_unique<String>(table.string_pool.MakeRef(std::string("foo-") + locale)),
+        test::GetDiagnostics()));
+  }
+
+  std::vector<SplitConstraints> constraints;
+  for (const char* locale : {"fr", "de", "es"}) {
+    constraints.push_back(SplitConstraints{{test::ParseConfigOrDie(locale)}});
+  }
+
+  TableSplitterOptions options;
+  options.jobs = 3;
+  TableSplitter splitter(constraints, options);
+  splitter.SplitTable(&table);
+
+  ASSERT_EQ(3u, splitter.splits().size());
+  String* base = test::GetValueForConfig<String>(&table, "android:string/foo", {});
+  ASSERT_NE(nullptr, base);
+  EXPECT_EQ("foo-", *base->value);
+
+  size_t idx = 0;
+  for (const char* locale : {"fr", "de", "es"}) {
+    const ConfigDescription config = test::ParseConfigOrDie(locale);
+    EXPECT_EQ(nullptr, test::GetValueForConfig<String>(&table, "android:string/foo", config));
+
+    ResourceTable* split = splitter.splits()[idx++].get();
+    String* value = test::GetValueForConfig<String>(split, "android:string/foo", config);
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(std::string("foo-") + locale, *value->value);
+    EXPECT_EQ(nullptr, test::GetValueForConfig<String>(split, "android:string/foo", {}));
+  }
+}
+
 }  // namespace aapt
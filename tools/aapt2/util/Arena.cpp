@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/Arena.h"
+
+#include <algorithm>
+#include <new>
+
+#include "android-base/logging.h"
+
+namespace aapt {
+
+constexpr size_t Arena::kDefaultBlockSize;
+
+static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+static size_t AlignSize(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+void* Arena::Allocate(size_t size) {
+  size = AlignSize(std::max<size_t>(size, 1u));
+  if (static_cast<size_t>(end_ - next_) < size) {
+    const size_t new_block_size = std::max(block_size_, size);
+    std::unique_ptr<std::max_align_t[]> block(
+        new std::max_align_t[AlignSize(new_block_size) / sizeof(std::max_align_t)]);
+    CHECK(block);
+    next_ = reinterpret_cast<char*>(block.get());
+    end_ = next_ + new_block_size;
+    reserved_size_ += new_block_size;
+    blocks_.push_back(std::move(block));
+  }
+
+  void* result = next_;
+  next_ += size;
+  return result;
+}
+
+static thread_local Arena* sCurrentArena = nullptr;
+
+ArenaScope::ArenaScope(Arena* arena) : previous_(sCurrentArena) {
+  sCurrentArena = arena;
+}
+
+ArenaScope::~ArenaScope() {
+  sCurrentArena = previous_;
+}
+
+Arena* ArenaScope::Current() {
+  return sCurrentArena;
+}
+
+// Every ArenaAllocated object is preceded by a header which tells operator delete where its
+// memory came from. The header is padded to keep the object aligned for any type.
+union AllocationHeader {
+  Arena* arena;
+  std::max_align_t align;
+};
+
+void* ArenaAllocated::operator new(size_t size) {
+  AllocationHeader* header;
+  if (Arena* arena = sCurrentArena) {
+    header = static_cast<AllocationHeader*>(arena->Allocate(sizeof(AllocationHeader) + size));
+    header->arena = arena;
+  } else {
+    header = static_cast<AllocationHeader*>(::operator new(sizeof(AllocationHeader) + size));
+    header->arena = nullptr;
+  }
+  return header + 1;
+}
+
+void ArenaAllocated::operator delete(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  AllocationHeader* header = static_cast<AllocationHeader*>(ptr) - 1;
+  if (header->arena == nullptr) {
+    ::operator delete(header);
+  }
+  // Memory from an Arena is released with the Arena.
+}
+
+}  // namespace aapt
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_UTIL_ARENA_H
+#define AAPT_UTIL_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "android-base/macros.h"
+
+namespace aapt {
+
+// Hands out memory that is only released when the Arena is destroyed. Allocating many small
+// objects from an Arena is much cheaper than allocating each from the heap, and so is releasing
+// them all at once. An Arena is not thread-safe.
+class Arena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 256u * 1024u;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize) : block_size_(block_size) {}
+
+  // Returns `size` bytes aligned for any type.
+  void* Allocate(size_t size);
+
+  // Total number of bytes obtained from the heap.
+  size_t GetReservedSize() const { return reserved_size_; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Arena);
+
+  const size_t block_size_;
+  std::vector<std::unique_ptr<std::max_align_t[]>> blocks_;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  size_t reserved_size_ = 0;
+};
+
+// Makes `arena` the Arena used for ArenaAllocated objects created on the current thread, for as
+// long as the scope lives. Scopes may nest.
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena* arena);
+  ~ArenaScope();
+
+  // Returns the Arena of the innermost scope on the current thread, or nullptr.
+  static Arena* Current();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ArenaScope);
+
+  Arena* previous_;
+};
+
+// Base of classes whose instances are created in very large numbers. Instances created while an
+// ArenaScope is active on the current thread come from its Arena, all others come from the heap.
+// Deleting an instance runs its destructor as usual, but the memory of an instance from an Arena
+// is only released with the Arena, so the Arena must outlive all of its instances.
+class ArenaAllocated {
+ public:
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
+
+  // Placement new is still available for constructing instances in storage of their own.
+  static void* operator new(size_t size, void* ptr) { return ptr; }
+  static void operator delete(void* ptr, void* place) {}
+};
+
+}  // namespace aapt
+
+#endif  // AAPT_UTIL_ARENA_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/Arena.h"
+
+#include <cstdint>
+
+#include "test/Test.h"
+
+namespace aapt {
+
+namespace {
+
+struct TestObject : public ArenaAllocated {
+  explicit TestObject(int* destroyed) : destroyed(destroyed) {}
+  ~TestObject() { (*destroyed)++; }
+
+  int* destroyed;
+};
+
+}  // namespace
+
+TEST(ArenaTest, AllocationsAreAlignedAndContiguous) {
+  Arena arena(1024);
+
+  char* a = static_cast<char*>(arena.Allocate(1));
+  char* b = static_cast<char*>(arena.Allocate(1));
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(a) % alignof(std::max_align_t));
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(b) % alignof(std::max_align_t));
+  EXPECT_EQ(a + alignof(std::max_align_t), b);
+  EXPECT_EQ(1024u, arena.GetReservedSize());
+}
+
+TEST(ArenaTest, LargeAllocationGetsItsOwnBlock) {
+  Arena arena(64);
+
+  EXPECT_NE(nullptr, arena.Allocate(1000));
+  EXPECT_EQ(1000u, arena.GetReservedSize());
+}
+
+TEST(ArenaTest, ObjectsComeFromTheScopedArena) {
+  Arena arena(1024);
+  int destroyed = 0;
+
+  std::unique_ptr<TestObject> heap_object = util::make_unique<TestObject>(&destroyed);
+  EXPECT_EQ(0u, arena.GetReservedSize());
+
+  {
+    ArenaScope scope(&arena);
+    EXPECT_EQ(&arena, ArenaScope::Current());
+
+    std::unique_ptr<TestObject> arena_object = util::make_unique<TestObject>(&destroyed);
+    EXPECT_EQ(1024u, arena.GetReservedSize());
+
+    // Deleting either object runs its destructor.
+    arena_object = {};
+    heap_object = {};
+    EXPECT_EQ(2, destroyed);
+  }
+  EXPECT_EQ(nullptr, ArenaScope::Current());
+}
+
+}  // namespace aapt
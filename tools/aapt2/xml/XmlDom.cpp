@@ -37,6 +37,9 @@ namespace xml {
 
 constexpr char kXmlNamespaceSep = 1;
 
+// Size of the chunks read into the parser's buffer.
+constexpr int kBufferSize = 16384;
+
 struct Stack {
   std::unique_ptr<xml::Node> root;
   std::stack<xml::Node*> node_stack;
@@ -132,17 +135,21 @@ static void XMLCALL StartElementHandler(void* user_data, const char* name,
   std::unique_ptr<Element> el = util::make_unique<Element>();
   SplitName(name, &el->namespace_uri, &el->name);
 
-  while (*attrs) {
-    Attribute attribute;
+  size_t attr_count = 0;
+  while (attrs[attr_count * 2]) {
+    attr_count++;
+  }
+
+  el->attributes.resize(attr_count);
+  for (Attribute& attribute : el->attributes) {
     SplitName(*attrs++, &attribute.namespace_uri, &attribute.name);
     attribute.value = *attrs++;
-
-    // Insert in sorted order.
-    auto iter = std::lower_bound(el->attributes.begin(), el->attributes.end(), attribute,
-                                 less_attribute);
-    el->attributes.insert(iter, std::move(attribute));
   }
 
+  // expat rejects duplicate attributes, so the order is the same as if they were inserted in
+  // sorted order.
+  std::sort(el->attributes.begin(), el->attributes.end(), less_attribute);
+
   el->comment = std::move(stack->pending_comment);
   AddToStack(stack, parser, std::move(el));
 }
@@ -200,16 +207,23 @@ std::unique_ptr<XmlResource> Inflate(std::istream* in, IDiagnostics* diag, const
   XML_SetCharacterDataHandler(parser, CharacterDataHandler);
   XML_SetCommentHandler(parser, CommentDataHandler);
 
-  char buffer[1024];
   while (!in->eof()) {
-    in->read(buffer, sizeof(buffer) / sizeof(buffer[0]));
+    // Read straight into expat's buffer, so that each chunk isn't copied once more into it.
+    void* buffer = XML_GetBuffer(parser, kBufferSize);
+    if (buffer == nullptr) {
+      stack.root = {};
+      diag->Error(DiagMessage(source) << XML_ErrorString(XML_GetErrorCode(parser)));
+      break;
+    }
+
+    in->read(reinterpret_cast<char*>(buffer), kBufferSize);
     if (in->bad() && !in->eof()) {
       stack.root = {};
       diag->Error(DiagMessage(source) << strerror(errno));
       break;
     }
 
-    if (XML_Parse(parser, buffer, in->gcount(), in->eof()) == XML_STATUS_ERROR) {
+    if (XML_ParseBuffer(parser, in->gcount(), in->eof()) == XML_STATUS_ERROR) {
       stack.root = {};
       diag->Error(DiagMessage(source.WithLine(XML_GetCurrentLineNumber(parser)))
                   << XML_ErrorString(XML_GetErrorCode(parser)));
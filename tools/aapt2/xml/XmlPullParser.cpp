@@ -29,6 +29,9 @@ namespace xml {
 
 constexpr char kXmlNamespaceSep = 1;
 
+// Size of the chunks read into the parser's buffer.
+constexpr int kBufferSize = 16384;
+
 XmlPullParser::XmlPullParser(std::istream& in) : in_(in), empty_(), depth_(0) {
   parser_ = XML_ParserCreateNS(nullptr, kXmlNamespaceSep);
   XML_SetUserData(parser_, this);
@@ -51,7 +54,15 @@ XmlPullParser::Event XmlPullParser::Next() {
 
   event_queue_.pop();
   while (event_queue_.empty()) {
-    in_.read(buffer_, sizeof(buffer_) / sizeof(*buffer_));
+    // Read straight into expat's buffer, so that each chunk isn't copied once more into it.
+    void* buffer = XML_GetBuffer(parser_, kBufferSize);
+    if (buffer == nullptr) {
+      error_ = XML_ErrorString(XML_GetErrorCode(parser_));
+      event_queue_.push(EventData{Event::kBadDocument});
+      continue;
+    }
+
+    in_.read(reinterpret_cast<char*>(buffer), kBufferSize);
 
     const bool done = in_.eof();
     if (in_.bad() && !done) {
@@ -60,7 +71,7 @@ XmlPullParser::Event XmlPullParser::Next() {
       continue;
     }
 
-    if (XML_Parse(parser_, buffer_, in_.gcount(), done) == XML_STATUS_ERROR) {
+    if (XML_ParseBuffer(parser_, in_.gcount(), done) == XML_STATUS_ERROR) {
       error_ = XML_ErrorString(XML_GetErrorCode(parser_));
       event_queue_.push(EventData{Event::kBadDocument});
       continue;
@@ -226,17 +237,21 @@ void XMLCALL XmlPullParser::StartElementHandler(void* user_data,
                     parser->depth_++};
   SplitName(name, &data.data1, &data.data2);
 
-  while (*attrs) {
-    Attribute attribute;
+  size_t attr_count = 0;
+  while (attrs[attr_count * 2]) {
+    attr_count++;
+  }
+
+  data.attributes.resize(attr_count);
+  for (Attribute& attribute : data.attributes) {
     SplitName(*attrs++, &attribute.namespace_uri, &attribute.name);
     attribute.value = *attrs++;
-
-    // Insert in sorted order.
-    auto iter = std::lower_bound(data.attributes.begin(), data.attributes.end(),
-                                 attribute);
-    data.attributes.insert(iter, std::move(attribute));
   }
 
+  // expat rejects duplicate attributes, so the order is the same as if they were inserted in
+  // sorted order.
+  std::sort(data.attributes.begin(), data.attributes.end());
+
   // Move the structure into the queue (no copy).
   parser->event_queue_.push(std::move(data));
 }
@@ -245,6 +260,14 @@ void XMLCALL XmlPullParser::CharacterDataHandler(void* user_data, const char* s,
                                                  int len) {
   XmlPullParser* parser = reinterpret_cast<XmlPullParser*>(user_data);
 
+  // expat reports text in pieces, at least one per line. Consumers concatenate consecutive text
+  // events anyway, so append to the last one if nothing came in between. Events still in the
+  // queue haven't been returned by Next() yet.
+  if (!parser->event_queue_.empty() && parser->event_queue_.back().event == Event::kText) {
+    parser->event_queue_.back().data1.append(s, len);
+    return;
+  }
+
   parser->event_queue_.push(EventData{Event::kText, XML_GetCurrentLineNumber(parser->parser_),
                                       parser->depth_, std::string(s, len)});
 }
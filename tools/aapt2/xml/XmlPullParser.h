@@ -171,7 +171,6 @@ class XmlPullParser : public IPackageDeclStack {
 
   std::istream& in_;
   XML_Parser parser_;
-  char buffer_[16384];
   std::queue<EventData> event_queue_;
   std::string error_;
   const std::string empty_;
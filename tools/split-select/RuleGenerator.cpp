@@ -95,7 +95,38 @@ sp<Rule> RuleGenerator::generateAbi(const Vector<abi::Variant>& splitAbis, size_
     return abiRule;
 }
 
-sp<Rule> RuleGenerator::generate(const SortedVector<SplitDescription>& group, size_t index) {
+// The densities and ABIs of a group of splits. If every split of the group shares the same value,
+// only that value is kept, the group doesn't differ along that axis.
+struct GroupAxes {
+    Vector<int> densities;
+    bool densitiesDiffer = false;
+
+    Vector<abi::Variant> abis;
+    bool abisDiffer = false;
+};
+
+static void collectAxes(const SortedVector<SplitDescription>& group, GroupAxes* outAxes) {
+    const size_t groupSize = group.size();
+    for (size_t i = 1; i < groupSize; i++) {
+        outAxes->densitiesDiffer |= group[i].config.density != group[0].config.density;
+        outAxes->abisDiffer |= group[i].abi != group[0].abi;
+    }
+
+    if (outAxes->densitiesDiffer) {
+        for (size_t i = 0; i < groupSize; i++) {
+            outAxes->densities.add(group[i].config.density);
+        }
+    }
+
+    if (outAxes->abisDiffer) {
+        for (size_t i = 0; i < groupSize; i++) {
+            outAxes->abis.add(group[i].abi);
+        }
+    }
+}
+
+static sp<Rule> generateWithAxes(const SortedVector<SplitDescription>& group, size_t index,
+        const GroupAxes& axes) {
     sp<Rule> rootRule = new Rule();
     rootRule->op = Rule::AND_SUBRULES;
 
@@ -118,46 +149,47 @@ sp<Rule> RuleGenerator::generate(const SortedVector<SplitDescription>& group, si
     }
 
     if (group[index].config.density != 0) {
-        size_t densityIndex = 0;
-        Vector<int> allDensities;
-        allDensities.add(group[index].config.density);
-
-        const size_t groupSize = group.size();
-        for (size_t i = 0; i < groupSize; i++) {
-            if (group[i].config.density != group[index].config.density) {
-                // This group differs by density.
-                allDensities.clear();
-                for (size_t j = 0; j < groupSize; j++) {
-                    allDensities.add(group[j].config.density);
-                }
-                densityIndex = index;
-                break;
-            }
+        if (axes.densitiesDiffer) {
+            // This group differs by density.
+            rootRule->subrules.add(RuleGenerator::generateDensity(axes.densities, index));
+        } else {
+            Vector<int> density;
+            density.add(group[index].config.density);
+            rootRule->subrules.add(RuleGenerator::generateDensity(density, 0));
         }
-        rootRule->subrules.add(generateDensity(allDensities, densityIndex));
     }
 
     if (group[index].abi != abi::Variant_none) {
-        size_t abiIndex = 0;
-        Vector<abi::Variant> allVariants;
-        allVariants.add(group[index].abi);
-
-        const size_t groupSize = group.size();
-        for (size_t i = 0; i < groupSize; i++) {
-            if (group[i].abi != group[index].abi) {
-                // This group differs by ABI.
-                allVariants.clear();
-                for (size_t j = 0; j < groupSize; j++) {
-                    allVariants.add(group[j].abi);
-                }
-                abiIndex = index;
-                break;
-            }
+        if (axes.abisDiffer) {
+            // This group differs by ABI.
+            rootRule->subrules.add(RuleGenerator::generateAbi(axes.abis, index));
+        } else {
+            Vector<abi::Variant> variant;
+            variant.add(group[index].abi);
+            rootRule->subrules.add(RuleGenerator::generateAbi(variant, 0));
         }
-        rootRule->subrules.add(generateAbi(allVariants, abiIndex));
     }
 
     return rootRule;
 }
 
+sp<Rule> RuleGenerator::generate(const SortedVector<SplitDescription>& group, size_t index) {
+    GroupAxes axes;
+    collectAxes(group, &axes);
+    return generateWithAxes(group, index, axes);
+}
+
+Vector<sp<Rule> > RuleGenerator::generateAll(const SortedVector<SplitDescription>& group) {
+    GroupAxes axes;
+    collectAxes(group, &axes);
+
+    Vector<sp<Rule> > rules;
+    const size_t groupSize = group.size();
+    rules.setCapacity(groupSize);
+    for (size_t i = 0; i < groupSize; i++) {
+        rules.add(generateWithAxes(group, i, axes));
+    }
+    return rules;
+}
+
 } // namespace split
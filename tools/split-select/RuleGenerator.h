@@ -30,6 +30,10 @@ struct RuleGenerator {
     // Generate rules for a Split given the group of mutually exclusive splits it belongs to
     static android::sp<Rule> generate(const android::SortedVector<SplitDescription>& group, size_t index);
 
+    // Generate rules for every Split of a group of mutually exclusive splits, in order. This is
+    // the same as calling generate() for each index, but only scans the group once.
+    static android::Vector<android::sp<Rule> > generateAll(const android::SortedVector<SplitDescription>& group);
+
     static android::sp<Rule> generateAbi(const android::Vector<abi::Variant>& allVariants, size_t index);
     static android::sp<Rule> generateDensity(const android::Vector<int>& allDensities, size_t index);
 };
@@ -20,6 +20,7 @@
 #include "TestRules.h"
 
 #include <gtest/gtest.h>
+#include <utils/String8.h>
 #include <utils/Vector.h>
 
 using namespace android;
@@ -107,4 +108,20 @@ TEST(RuleGeneratorTest, testDensityRulesWithAnyDpi) {
     EXPECT_RULES_EQ(RuleGenerator::generateDensity(densities, anyIndex), AlwaysTrue());
 }
 
+TEST(RuleGeneratorTest, generateAllMatchesGenerate) {
+    const char* configs[] = { "hdpi", "xhdpi", "xxhdpi", "anydpi", "mdpi" };
+    SortedVector<SplitDescription> group;
+    for (const char* config : configs) {
+        SplitDescription split;
+        ASSERT_TRUE(SplitDescription::parse(String8(config), &split));
+        group.add(split);
+    }
+
+    Vector<sp<Rule> > rules = RuleGenerator::generateAll(group);
+    ASSERT_EQ(group.size(), rules.size());
+    for (size_t i = 0; i < group.size(); i++) {
+        EXPECT_RULES_EQ(rules[i], *RuleGenerator::generate(group, i));
+    }
+}
+
 } // namespace split
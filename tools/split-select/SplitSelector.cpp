@@ -71,9 +71,10 @@ KeyedVector<SplitDescription, sp<Rule> > SplitSelector::getRules() const {
     const size_t groupCount = mGroups.size();
     for (size_t i = 0; i < groupCount; i++) {
         const SortedVector<SplitDescription>& splits = mGroups[i];
+        const Vector<sp<Rule> > groupRules = RuleGenerator::generateAll(splits);
         const size_t splitCount = splits.size();
         for (size_t j = 0; j < splitCount; j++) {
-            sp<Rule> rule = Rule::simplify(RuleGenerator::generate(splits, j));
+            sp<Rule> rule = Rule::simplify(groupRules[j]);
             if (rule != NULL) {
                 rules.add(splits[j], rule);
             }